@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <Qt3DRaytrace/qmeshpack.h>
+
+using namespace Qt3DRaytrace;
+
+static double toMegabytes(qint64 bytes)
+{
+    return double(bytes) / (1024.0 * 1024.0);
+}
+
+static qint64 rawGeometrySize(const QGeometryData &data)
+{
+    return qint64(data.numVertices() * sizeof(QVertex) + data.numFaces() * sizeof(QTriangle));
+}
+
+// Best time out of all runs of a mesh loading method and the size of geometry it produced.
+struct BenchmarkResult
+{
+    double bestTime = 0.0;
+    qint64 rawSize = 0;
+
+    template<typename Func>
+    bool measure(Func load)
+    {
+        QGeometryData result;
+        QElapsedTimer timer;
+        timer.start();
+        if(!load(result)) {
+            return false;
+        }
+        const double time = double(timer.nsecsElapsed()) * 1e-9;
+        bestTime = (rawSize == 0) ? time : qMin(bestTime, time);
+        rawSize = rawGeometrySize(result);
+        return true;
+    }
+
+    QString toString() const
+    {
+        return QString("%1 ms (%2 GB/s)").arg(bestTime * 1e3, 0, 'f', 2).arg(double(rawSize) / bestTime * 1e-9, 0, 'f', 3);
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("meshpack");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Mesh file to Quartz mesh pack (.qmp) converter.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("source", "Source mesh file path.");
+    parser.addPositionalArgument("output", "Output mesh pack file path.");
+
+    QCommandLineOption keepOrderOption("keep-order", "Do not reorder triangles and vertices for better compression.");
+    parser.addOption(keepOrderOption);
+    QCommandLineOption benchmarkOption({"b", "benchmark"}, "Compare mesh pack decoding with importing the source file with Assimp and native importers.");
+    parser.addOption(benchmarkOption);
+    QCommandLineOption runsOption("runs", "Number of timed runs when benchmarking (default: 5).", "count", "5");
+    parser.addOption(runsOption);
+
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if(args.size() != 2) {
+        parser.showHelp(2);
+    }
+
+    const QString sourcePath = args[0];
+    const QString targetPath = args[1];
+    const int numRuns = qMax(1, parser.value(runsOption).toInt());
+    const bool benchmark = parser.isSet(benchmarkOption);
+
+    QTextStream out(stdout);
+    out << QFileInfo(targetPath).absoluteFilePath() << " ...\n";
+
+    if(benchmark) {
+        // Measure actual parsing of the source rather than loading it from the mesh cache.
+        qputenv("QUARTZ_MESH_CACHE", "0");
+    }
+
+    QGeometryData data;
+    if(!QMeshPack::importMesh(QUrl::fromLocalFile(sourcePath), data)) {
+        return 1;
+    }
+
+    // Raw size is that of the mesh as imported, before optimization drops degenerate and duplicate triangles.
+    const qint64 rawSize = rawGeometrySize(data);
+    out << "Vertices:  " << data.numVertices() << "\n";
+    out << "Triangles: " << data.numFaces() << "\n";
+
+    if(!parser.isSet(keepOrderOption)) {
+        QMeshPack::optimizeMesh(data);
+        out << "Optimized: " << data.numVertices() << " vertices, " << data.numFaces() << " triangles\n";
+    }
+
+    QSaveFile targetFile(targetPath);
+    if(!targetFile.open(QFile::WriteOnly) || !QMeshPack::encode(data, &targetFile) || !targetFile.commit()) {
+        QTextStream(stderr) << "Failed to write mesh pack file: " << targetPath << "\n";
+        return 1;
+    }
+
+    const qint64 sourceSize = QFileInfo(sourcePath).size();
+    const qint64 packSize = QFileInfo(targetPath).size();
+
+    out << QString("Raw size:    %1 MB\n").arg(toMegabytes(rawSize), 0, 'f', 2);
+    out << QString("Source size: %1 MB\n").arg(toMegabytes(sourceSize), 0, 'f', 2);
+    out << QString("Pack size:   %1 MB (%2:1 vs raw, %3:1 vs source)\n")
+           .arg(toMegabytes(packSize), 0, 'f', 2)
+           .arg(double(rawSize) / double(qMax(packSize, qint64(1))), 0, 'f', 2)
+           .arg(double(sourceSize) / double(qMax(packSize, qint64(1))), 0, 'f', 2);
+
+    if(benchmark) {
+        QFile packFile(targetPath);
+        if(!packFile.open(QFile::ReadOnly)) {
+            return 1;
+        }
+        const QByteArray packData = packFile.readAll();
+        const QUrl sourceUrl = QUrl::fromLocalFile(sourcePath);
+
+        // Throughput of each method is measured in bytes of geometry it produces.
+        BenchmarkResult assimpImport, nativeImport, packDecode;
+        for(int i=0; i < numRuns; ++i) {
+            if(!assimpImport.measure([&sourceUrl](QGeometryData &result) { return QMeshPack::importMeshWithAssimp(sourceUrl, result); })) {
+                QTextStream(stderr) << "Failed to import source file with Assimp: " << sourcePath << "\n";
+                return 1;
+            }
+            if(!nativeImport.measure([&sourceUrl](QGeometryData &result) { return QMeshPack::importMesh(sourceUrl, result); })) {
+                return 1;
+            }
+            if(!packDecode.measure([&packData](QGeometryData &result) {
+                return QMeshPack::decode(reinterpret_cast<const uchar*>(packData.constData()), quint64(packData.size()), result);
+            })) {
+                QTextStream(stderr) << "Failed to decode mesh pack file: " << targetPath << "\n";
+                return 1;
+            }
+        }
+
+        out << QString("Assimp import: %1\n").arg(assimpImport.toString());
+        out << QString("QMesh import:  %1\n").arg(nativeImport.toString());
+        out << QString("Pack decode:   %1 (%2x faster than Assimp, %3x faster than QMesh import)\n")
+               .arg(packDecode.toString())
+               .arg(assimpImport.bestTime / packDecode.bestTime, 0, 'f', 1)
+               .arg(nativeImport.bestTime / packDecode.bestTime, 0, 'f', 1);
+    }
+    return 0;
+}
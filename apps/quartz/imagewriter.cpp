@@ -9,6 +9,9 @@
 #include <utility>
 #include <stb_image_write.h>
 
+#include <Qt3DRaytrace/qrgbeimage.h>
+
+#include <QFile>
 #include <QFileInfo>
 #include <QTextStream>
 
@@ -63,6 +66,7 @@ void ImageWriter::run()
         else {
             Q_ASSERT_X(0, Q_FUNC_INFO, "Unsupported image value type");
         }
+        m_image->format = (m_image->channels == 4) ? Format::RGBA : Format::RGB;
     }
 
     int result = 0;
@@ -90,9 +94,8 @@ void ImageWriter::run()
                                 m_image->data.constData());
     }
     else if(fileFormat == QStringLiteral("hdr")) {
-        result = stbi_write_hdr(m_outputPath.toUtf8().constData(),
-                                m_image->width, m_image->height, m_image->channels,
-                                reinterpret_cast<const float*>(m_image->data.constData()));
+        QFile file(m_outputPath);
+        result = file.open(QFile::WriteOnly) && Qt3DRaytrace::QRgbeImage::encode(*m_image, &file);
     }
     else {
         Q_ASSERT_X(0, Q_FUNC_INFO, "Unsupported file format");
@@ -9,6 +9,8 @@
 #include <QTextStream>
 #include <QScopedPointer>
 
+#include <Qt3DRaytrace/qraytraceaspect.h>
+
 #include "renderwindow.h"
 #include "version.h"
 
@@ -17,7 +19,7 @@ static constexpr int DefaultViewportWidth  = 1280;
 static constexpr int DefaultViewportHeight = 720;
 } // Config
 
-static void parseOptions(int &viewportWidth, int &viewportHeight, QString &sceneFilePath)
+static void parseOptions(int &viewportWidth, int &viewportHeight, QString &rendererName, QString &sceneFilePath)
 {
     const QString description = QString("%1 %2\n%3\n%4")
             .arg(ApplicationDescription)
@@ -34,7 +36,10 @@ static void parseOptions(int &viewportWidth, int &viewportHeight, QString &scene
                                    QString::number(Config::DefaultViewportWidth));
     QCommandLineOption heightOption({"y", "sizey", "height"}, "Initial viewport height.", "px",
                                     QString::number(Config::DefaultViewportHeight));
-    parser.addOptions({widthOption, heightOption});
+    QCommandLineOption rendererOption({"r", "renderer"},
+                                      QString("Renderer backend (%1).").arg(Qt3DRaytrace::QRaytraceAspect::availableRenderers().join(", ")), "name",
+                                      Qt3DRaytrace::QRaytraceAspect::defaultRenderer());
+    parser.addOptions({widthOption, heightOption, rendererOption});
     parser.addPositionalArgument("scene", "QML scene file path");
 
     parser.process(*QApplication::instance());
@@ -45,6 +50,12 @@ static void parseOptions(int &viewportWidth, int &viewportHeight, QString &scene
         parser.showHelp(1);
     }
 
+    rendererName = parser.value(rendererOption).toLower();
+    if(!Qt3DRaytrace::QRaytraceAspect::availableRenderers().contains(rendererName)) {
+        QTextStream(stderr) << "Error: Unknown renderer: " << rendererName << "\n";
+        parser.showHelp(1);
+    }
+
     if(parser.positionalArguments().size() > 0) {
         sceneFilePath = parser.positionalArguments().at(0);
     }
@@ -58,21 +69,35 @@ int main(int argc, char *argv[])
 
     int viewportWidth;
     int viewportHeight;
+    QString rendererName;
     QString sceneFilePath;
-    parseOptions(viewportWidth, viewportHeight, sceneFilePath);
+    parseOptions(viewportWidth, viewportHeight, rendererName, sceneFilePath);
 
     QTextStream(stdout) << ApplicationDescription << " "
                         << ApplicationVersion << "\n";
 
-    QScopedPointer<QVulkanInstance> vulkanInstance(RenderWindow::createDefaultVulkanInstance());
-    if(!vulkanInstance) {
-        return 1;
+    // Render window registers the raytrace aspect on construction so the renderer
+    // has to be selected through the environment beforehand.
+    qputenv("QUARTZ_RENDERER", rendererName.toLocal8Bit());
+
+    const bool useVulkan = (rendererName == QStringLiteral("vulkan"));
+    QScopedPointer<QVulkanInstance> vulkanInstance;
+    if(useVulkan) {
+        vulkanInstance.reset(RenderWindow::createDefaultVulkanInstance());
+        if(!vulkanInstance) {
+            return 1;
+        }
     }
 
     RenderWindow window;
     window.setWidth(viewportWidth);
     window.setHeight(viewportHeight);
-    window.setVulkanInstance(vulkanInstance.get());
+    if(useVulkan) {
+        window.setVulkanInstance(vulkanInstance.get());
+    }
+    else {
+        window.setSurfaceType(QSurface::RasterSurface);
+    }
 
     if(sceneFilePath.length() > 0) {
         if(!window.setSourceFile(sceneFilePath)) {
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QVector>
+
+#include <Qt3DRaytrace/qtexturecompression.h>
+
+using namespace Qt3DRaytrace;
+
+struct FormatInfo
+{
+    const char *name;
+    QImageData::BlockFormat blockFormat;
+    // Number of channels stored by the format, used for quality measurement.
+    int numChannels;
+};
+
+static const FormatInfo Formats[] = {
+    { "bc1",  QImageData::BlockFormat::BC1,  3 },
+    { "bc4",  QImageData::BlockFormat::BC4,  1 },
+    { "bc5",  QImageData::BlockFormat::BC5,  2 },
+    { "bc6h", QImageData::BlockFormat::BC6H, 3 },
+    { "bc7",  QImageData::BlockFormat::BC7,  4 },
+};
+
+static bool isSupportedFormat(const FormatInfo &format, const QImageData &image)
+{
+    if(format.blockFormat == QImageData::BlockFormat::BC6H) {
+        return image.type != QImageData::ValueType::UInt8 && image.channels >= 3;
+    }
+    return image.type == QImageData::ValueType::UInt8 && image.channels >= format.numChannels;
+}
+
+static double toMegabytes(quint64 bytes)
+{
+    return double(bytes) / (1024.0 * 1024.0);
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("texcompress");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Texture block compression quality and throughput measurement tool.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("source", "Source image file path.");
+
+    QCommandLineOption formatOption({"f", "format"}, "Block format to test: bc1, bc4, bc5, bc6h or bc7 (default: all formats applicable to the image).", "format");
+    parser.addOption(formatOption);
+    QCommandLineOption mipmapsOption({"m", "mipmaps"}, "Generate and compress full mip chain.");
+    parser.addOption(mipmapsOption);
+    QCommandLineOption runsOption("runs", "Number of timed runs (default: 3).", "count", "3");
+    parser.addOption(runsOption);
+
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if(args.size() != 1) {
+        parser.showHelp(2);
+    }
+
+    const QString sourcePath = args[0];
+    const int numRuns = qMax(1, parser.value(runsOption).toInt());
+
+    QVector<FormatInfo> formats;
+    for(const FormatInfo &format : Formats) {
+        if(!parser.isSet(formatOption) || parser.value(formatOption).compare(QLatin1String(format.name), Qt::CaseInsensitive) == 0) {
+            formats.append(format);
+        }
+    }
+    if(formats.isEmpty()) {
+        QTextStream(stderr) << "Unknown block format: " << parser.value(formatOption) << "\n";
+        return 2;
+    }
+
+    QImageData image;
+    if(!QTextureCompression::importImage(QUrl::fromLocalFile(sourcePath), image)) {
+        return 1;
+    }
+    // Block compressed sources (DDS or KTX2 files) are decoded to serve as reference images.
+    if(image.isCompressed()) {
+        QImageData decodedImage;
+        if(!QTextureCompression::decompress(image, decodedImage)) {
+            return 1;
+        }
+        image = decodedImage;
+    }
+    if(parser.isSet(mipmapsOption) && !QTextureCompression::generateMipmaps(image)) {
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << QFileInfo(sourcePath).absoluteFilePath() << "\n";
+    out << QString("Image: %1x%2, %3 channel(s), %4 mip level(s), %5 MB\n")
+           .arg(image.width).arg(image.height).arg(image.channels).arg(image.mipLevels)
+           .arg(toMegabytes(image.expectedSizeInBytes()), 0, 'f', 2);
+
+    bool succeeded = true;
+    for(const FormatInfo &format : formats) {
+        if(!isSupportedFormat(format, image)) {
+            if(parser.isSet(formatOption)) {
+                QTextStream(stderr) << "Block format " << format.name << " is not applicable to this image\n";
+                succeeded = false;
+            }
+            continue;
+        }
+
+        QImageData compressedImage;
+        QImageData decompressedImage;
+        double bestEncodeTime = 0.0;
+        double bestDecodeTime = 0.0;
+        QElapsedTimer timer;
+        for(int run=0; run<numRuns; ++run) {
+            compressedImage = image;
+            timer.start();
+            if(!QTextureCompression::compress(compressedImage, format.blockFormat)) {
+                return 1;
+            }
+            const double encodeTime = double(timer.nsecsElapsed()) * 1e-9;
+            bestEncodeTime = (run == 0) ? encodeTime : qMin(bestEncodeTime, encodeTime);
+
+            timer.restart();
+            if(!QTextureCompression::decompress(compressedImage, decompressedImage)) {
+                return 1;
+            }
+            const double decodeTime = double(timer.nsecsElapsed()) * 1e-9;
+            bestDecodeTime = (run == 0) ? decodeTime : qMin(bestDecodeTime, decodeTime);
+        }
+
+        const double sourceSize = toMegabytes(image.expectedSizeInBytes());
+        const double psnr = QTextureCompression::computePSNR(image, decompressedImage, format.numChannels);
+        out << QString("%1: %2 MB, PSNR %3 dB, encode %4 ms (%5 MB/s), decode %6 ms (%7 MB/s)\n")
+               .arg(QString::fromLatin1(format.name).toUpper(), -4)
+               .arg(toMegabytes(compressedImage.expectedSizeInBytes()), 0, 'f', 2)
+               .arg(psnr, 0, 'f', 2)
+               .arg(bestEncodeTime * 1e3, 0, 'f', 1)
+               .arg(sourceSize / bestEncodeTime, 0, 'f', 1)
+               .arg(bestDecodeTime * 1e3, 0, 'f', 1)
+               .arg(sourceSize / bestDecodeTime, 0, 'f', 1);
+    }
+    return succeeded ? 0 : 1;
+}
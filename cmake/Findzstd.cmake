@@ -0,0 +1,22 @@
+find_path(zstd_INCLUDE_DIRS
+	NAMES
+		zstd.h
+)
+find_library(zstd_LIBRARIES
+	NAMES
+		zstd zstd_static
+)
+
+if (zstd_INCLUDE_DIRS AND zstd_LIBRARIES)
+	SET(zstd_FOUND TRUE)
+ENDIF (zstd_INCLUDE_DIRS AND zstd_LIBRARIES)
+
+if (zstd_FOUND)
+	if (NOT zstd_FIND_QUIETLY)
+	message(STATUS "Found Zstandard library: ${zstd_LIBRARIES}")
+	endif (NOT zstd_FIND_QUIETLY)
+else (zstd_FOUND)
+	if (zstd_FIND_REQUIRED)
+	message(FATAL_ERROR "Could not find Zstandard library")
+	endif (zstd_FIND_REQUIRED)
+endif (zstd_FOUND)
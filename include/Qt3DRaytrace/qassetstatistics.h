@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qobjectdefs.h>
+#include <QtCore/qurl.h>
+#include <QtCore/qvector.h>
+
+namespace Qt3DRaytrace {
+
+// Metrics of a single asset load. Times are in milliseconds, bytesRead is the size of the source file
+// and memoryFootprint is the size of the resulting vertex, triangle or pixel data.
+struct QAssetStatistics
+{
+    Q_GADGET
+    Q_PROPERTY(QUrl source MEMBER source)
+    Q_PROPERTY(bool succeeded MEMBER succeeded)
+    Q_PROPERTY(bool cacheHit MEMBER cacheHit)
+    Q_PROPERTY(qint64 bytesRead MEMBER bytesRead)
+    Q_PROPERTY(double decodeTime MEMBER decodeTime)
+    Q_PROPERTY(double conversionTime MEMBER conversionTime)
+    Q_PROPERTY(qint64 numVertices MEMBER numVertices)
+    Q_PROPERTY(qint64 numTriangles MEMBER numTriangles)
+    Q_PROPERTY(qint64 numPixels MEMBER numPixels)
+    Q_PROPERTY(qint64 memoryFootprint MEMBER memoryFootprint)
+public:
+    QUrl source;
+    bool succeeded = false;
+    bool cacheHit = false;
+    qint64 bytesRead = 0;
+    double decodeTime = 0.0;
+    double conversionTime = 0.0;
+    qint64 numVertices = 0;
+    qint64 numTriangles = 0;
+    qint64 numPixels = 0;
+    qint64 memoryFootprint = 0;
+
+    double totalTime() const { return decodeTime + conversionTime; }
+};
+
+// Aggregate of asset loads of all meshes and textures known to the aspect.
+// Statistics of finished loads are kept in assets, sorted by total load time, slowest first.
+// Cache counters cover all loads that went through the shared in-memory asset cache since process start.
+struct QAssetLoadSummary
+{
+    Q_GADGET
+    Q_PROPERTY(int numPending MEMBER numPending)
+    Q_PROPERTY(int numReady MEMBER numReady)
+    Q_PROPERTY(int numFailed MEMBER numFailed)
+    Q_PROPERTY(double progress MEMBER progress)
+    Q_PROPERTY(qint64 bytesRead MEMBER bytesRead)
+    Q_PROPERTY(double decodeTime MEMBER decodeTime)
+    Q_PROPERTY(double conversionTime MEMBER conversionTime)
+    Q_PROPERTY(qint64 memoryFootprint MEMBER memoryFootprint)
+    Q_PROPERTY(int numCacheHits MEMBER numCacheHits)
+    Q_PROPERTY(int numCacheMisses MEMBER numCacheMisses)
+public:
+    int numPending = 0;
+    int numReady = 0;
+    int numFailed = 0;
+    double progress = 1.0;
+    qint64 bytesRead = 0;
+    double decodeTime = 0.0;
+    double conversionTime = 0.0;
+    qint64 memoryFootprint = 0;
+    int numCacheHits = 0;
+    int numCacheMisses = 0;
+    QVector<QAssetStatistics> assets;
+};
+
+} // Qt3DRaytrace
+
+Q_DECLARE_METATYPE(Qt3DRaytrace::QAssetStatistics)
+Q_DECLARE_METATYPE(Qt3DRaytrace::QAssetLoadSummary)
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <QtCore/qmetatype.h>
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QString>
+
+#include <functional>
+
+namespace Qt3DRaytrace {
+
+class QDataStorage;
+using QDataStoragePtr = QSharedPointer<const QDataStorage>;
+
+// Immutable, shared block of memory not limited in size by Qt containers.
+// Memory is owned by the storage object and released once the last reference is dropped.
+class QT3DRAYTRACESHARED_EXPORT QDataStorage
+{
+public:
+    virtual ~QDataStorage() = default;
+
+    virtual const uchar *data() const = 0;
+    virtual quint64 size() const = 0;
+
+    static QDataStoragePtr fromByteArray(const QByteArray &data);
+    static QDataStoragePtr fromRawData(const uchar *data, quint64 size, std::function<void()> release);
+    // Maps given range of a file into memory; size of zero maps everything past offset. Returns null on failure.
+    static QDataStoragePtr fromFile(const QString &path, quint64 offset = 0, quint64 size = 0);
+};
+
+} // Qt3DRaytrace
+
+Q_DECLARE_METATYPE(Qt3DRaytrace::QDataStoragePtr)
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <Qt3DRaytrace/qdatastorage.h>
 #include <QtCore/qmetatype.h>
 
 #include <QVector2D>
@@ -29,10 +30,37 @@ struct QTriangle
     quint32 vertices[3];
 };
 
+// Geometry is stored either in vertices & faces vectors, or in external storage objects.
+// External storage (e.g. memory mapped files) is not limited to 2^31 elements and takes precedence when set.
+// Consumers should access geometry through numVertices(), numFaces(), vertexData() and faceData().
 struct QGeometryData
 {
     QVector<QVertex> vertices;
     QVector<QTriangle> faces;
+
+    QDataStoragePtr vertexStorage;
+    QDataStoragePtr faceStorage;
+
+    quint64 numVertices() const
+    {
+        return vertexStorage ? vertexStorage->size() / sizeof(QVertex) : quint64(vertices.size());
+    }
+    quint64 numFaces() const
+    {
+        return faceStorage ? faceStorage->size() / sizeof(QTriangle) : quint64(faces.size());
+    }
+    const QVertex *vertexData() const
+    {
+        return vertexStorage ? reinterpret_cast<const QVertex*>(vertexStorage->data()) : vertices.constData();
+    }
+    const QTriangle *faceData() const
+    {
+        return faceStorage ? reinterpret_cast<const QTriangle*>(faceStorage->data()) : faces.constData();
+    }
+    bool isEmpty() const
+    {
+        return numVertices() == 0 || numFaces() == 0;
+    }
 };
 
 } // Qt3DRaytrace
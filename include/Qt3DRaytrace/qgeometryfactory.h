@@ -7,6 +7,7 @@
 #pragma once
 
 #include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <Qt3DRaytrace/qassetstatistics.h>
 
 #include <QSharedPointer>
 
@@ -19,6 +20,13 @@ class QT3DRAYTRACESHARED_EXPORT QGeometryFactory
 public:
     virtual ~QGeometryFactory() = default;
     virtual QGeometry *create() = 0;
+
+    // Factories able to measure their work should override this and fill in statistics.
+    virtual QGeometry *create(QAssetStatistics &statistics)
+    {
+        Q_UNUSED(statistics);
+        return create();
+    }
 };
 
 using QGeometryFactoryPtr = QSharedPointer<QGeometryFactory>;
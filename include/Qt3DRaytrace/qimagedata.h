@@ -7,6 +7,7 @@
 #pragma once
 
 #include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <Qt3DRaytrace/qdatastorage.h>
 #include <QtCore/qmetatype.h>
 
 #include <QByteArray>
@@ -14,7 +15,7 @@
 
 namespace Qt3DRaytrace {
 
-// TODO: Add support for layers and mipmaps.
+// TODO: Add support for layers.
 struct QImageData
 {
     enum class ValueType {
@@ -30,13 +31,108 @@ struct QImageData
         RGBA,
         BGRA,
     };
+    // Block compression formats; pixel data of compressed images holds 4x4 texel blocks.
+    // Type and number of channels then describe decoded texels.
+    enum class BlockFormat {
+        None = 0,
+        BC1,  // RGB, 8 bytes per block.
+        BC2,  // RGB with explicit 4-bit alpha, 16 bytes per block.
+        BC3,  // RGB with interpolated alpha, 16 bytes per block.
+        BC4,  // R, 8 bytes per block.
+        BC5,  // RG, 16 bytes per block.
+        BC6H, // Unsigned half float RGB, 16 bytes per block.
+        BC7,  // RGBA, 16 bytes per block.
+    };
 
     int width  = 0;
     int height = 0;
     int channels = 0;
+    // Mip levels are stored one after another in pixel data, starting with the full resolution level.
+    int mipLevels = 1;
     ValueType type = ValueType::Undefined;
     Format format = Format::Undefined;
+    BlockFormat blockFormat = BlockFormat::None;
     QByteArray data;
+
+    // Optional external pixel storage; takes precedence over data when set.
+    QDataStoragePtr storage;
+
+    const uchar *constBits() const
+    {
+        return storage ? storage->data() : reinterpret_cast<const uchar*>(data.constData());
+    }
+    quint64 sizeInBytes() const
+    {
+        return storage ? storage->size() : quint64(data.size());
+    }
+    bool isEmpty() const
+    {
+        return sizeInBytes() == 0;
+    }
+
+    int mipWidth(int level) const
+    {
+        return qMax(1, width >> level);
+    }
+    int mipHeight(int level) const
+    {
+        return qMax(1, height >> level);
+    }
+    bool isCompressed() const
+    {
+        return blockFormat != BlockFormat::None;
+    }
+    quint64 mipLevelSize(int level) const
+    {
+        if(isCompressed()) {
+            const quint64 numBlocksX = quint64(mipWidth(level) + 3) / 4;
+            const quint64 numBlocksY = quint64(mipHeight(level) + 3) / 4;
+            return numBlocksX * numBlocksY * quint64(blockSize(blockFormat));
+        }
+        return quint64(mipWidth(level)) * quint64(mipHeight(level)) * quint64(channels) * quint64(type);
+    }
+    quint64 mipLevelOffset(int level) const
+    {
+        quint64 offset = 0;
+        for(int i=0; i<level; ++i) {
+            offset += mipLevelSize(i);
+        }
+        return offset;
+    }
+    const uchar *constMipBits(int level) const
+    {
+        return constBits() + mipLevelOffset(level);
+    }
+    // Size of pixel data required to hold all mip levels.
+    quint64 expectedSizeInBytes() const
+    {
+        return mipLevelOffset(mipLevels);
+    }
+
+    static int blockSize(BlockFormat blockFormat)
+    {
+        switch(blockFormat) {
+        case BlockFormat::BC1:
+        case BlockFormat::BC4:
+            return 8;
+        case BlockFormat::BC2:
+        case BlockFormat::BC3:
+        case BlockFormat::BC5:
+        case BlockFormat::BC6H:
+        case BlockFormat::BC7:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+    static int maxMipLevels(int width, int height)
+    {
+        int levels = 1;
+        for(int size=qMax(width, height); size > 1; size >>= 1) {
+            ++levels;
+        }
+        return levels;
+    }
 };
 
 using QImageDataPtr = QSharedPointer<QImageData>;
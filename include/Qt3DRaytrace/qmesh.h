@@ -9,6 +9,8 @@
 #include <Qt3DRaytrace/qt3draytrace_global.h>
 #include <Qt3DRaytrace/qgeometryrenderer.h>
 
+#include <Qt3DRaytrace/qassetstatistics.h>
+
 #include <QUrl>
 
 namespace Qt3DRaytrace {
@@ -20,6 +22,9 @@ class QT3DRAYTRACESHARED_EXPORT QMesh : public QGeometryRenderer
     Q_OBJECT
     Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(float progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(Qt3DRaytrace::QAssetStatistics statistics READ statistics NOTIFY statisticsChanged)
+    Q_PROPERTY(bool optimize READ optimize WRITE setOptimize NOTIFY optimizeChanged)
 public:
     explicit QMesh(Qt3DCore::QNode *parent = nullptr);
 
@@ -33,16 +38,24 @@ public:
 
     QUrl source() const;
     Status status() const;
+    float progress() const;
+    QAssetStatistics statistics() const;
+    bool optimize() const;
 
 public slots:
     void setSource(const QUrl &source);
+    void setOptimize(bool optimize);
 
 signals:
     void sourceChanged(const QUrl &source);
     void statusChanged(Status status);
+    void progressChanged(float progress);
+    void statisticsChanged(const Qt3DRaytrace::QAssetStatistics &statistics);
+    void optimizeChanged(bool optimize);
 
 protected:
     explicit QMesh(QMeshPrivate &dd, Qt3DCore::QNode *parent = nullptr);
+    void sceneChangeEvent(const Qt3DCore::QSceneChangePtr &change) override;
 
 private:
     Q_DECLARE_PRIVATE(QMesh)
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <Qt3DRaytrace/qgeometrydata.h>
+
+#include <QUrl>
+
+class QIODevice;
+
+namespace Qt3DRaytrace {
+
+// Encoding and decoding of Quartz mesh pack (.qmp) files, loaded natively by QMesh.
+class QT3DRAYTRACESHARED_EXPORT QMeshPack
+{
+public:
+    // Imports mesh from any file format supported by QMesh.
+    static bool importMesh(const QUrl &source, QGeometryData &data);
+    // Imports mesh with the general purpose Assimp based importer, bypassing native OBJ and glTF importers.
+    static bool importMeshWithAssimp(const QUrl &source, QGeometryData &data);
+    // Reorders mesh for memory locality, which also makes it compress better.
+    static void optimizeMesh(QGeometryData &data);
+
+    static bool encode(const QGeometryData &data, QIODevice *device);
+    static bool decode(const uchar *packData, quint64 packSize, QGeometryData &data);
+};
+
+} // Qt3DRaytrace
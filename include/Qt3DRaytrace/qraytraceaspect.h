@@ -9,8 +9,10 @@
 #include <Qt3DRaytrace/qt3draytrace_global.h>
 #include <Qt3DRaytrace/qimagedata.h>
 #include <Qt3DRaytrace/qrenderimage.h>
+#include <Qt3DRaytrace/qassetstatistics.h>
 
 #include <Qt3DCore/qabstractaspect.h>
+#include <QtCore/qstringlist.h>
 
 class QSurface;
 
@@ -21,13 +23,21 @@ class QRaytraceAspectPrivate;
 class QT3DRAYTRACESHARED_EXPORT QRaytraceAspect : public Qt3DCore::QAbstractAspect
 {
     Q_OBJECT
+    Q_PROPERTY(QString renderer READ renderer WRITE setRenderer NOTIFY rendererChanged)
 public:
     explicit QRaytraceAspect(QObject *parent = nullptr);
 
     QSurface *surface() const;
     void setSurface(QObject *surfaceObject);
 
+    QString renderer() const;
+    void setRenderer(const QString &renderer);
+
+    static QStringList availableRenderers();
+    static QString defaultRenderer();
+
     bool queryRenderStatistics(QRenderStatistics &statistics) const;
+    Q_INVOKABLE Qt3DRaytrace::QAssetLoadSummary assetLoadSummary() const;
 
 public slots:
     void suspendJobs();
@@ -35,6 +45,7 @@ public slots:
     void requestImage(Qt3DRaytrace::QRenderImage type);
 
 signals:
+    void rendererChanged(const QString &renderer);
     void imageReady(Qt3DRaytrace::QRenderImage type, Qt3DRaytrace::QImageDataPtr image);
 
 protected:
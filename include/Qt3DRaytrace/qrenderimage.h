@@ -8,6 +8,8 @@
 
 #include <Qt3DRaytrace/qt3draytrace_global.h>
 #include <QtCore/qmetatype.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qvector.h>
 
 namespace Qt3DRaytrace {
 
@@ -17,12 +19,21 @@ enum class QRenderImage
     FinalLDR,
 };
 
+struct QRenderJobStatistics
+{
+    QString name;
+    double averageTime;
+    double lastTime;
+    unsigned int numRuns;
+};
+
 struct QRenderStatistics
 {
     double cpuFrameTime;
     double gpuFrameTime;
     double totalRenderTime;
     unsigned int numFramesRendered;
+    QVector<QRenderJobStatistics> jobStatistics;
 };
 
 } // Qt3DRaytrace
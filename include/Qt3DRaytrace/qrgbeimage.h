@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <Qt3DRaytrace/qimagedata.h>
+
+class QIODevice;
+
+namespace Qt3DRaytrace {
+
+// Encoding and decoding of Radiance RGBE (.hdr) images, loaded natively by QTexture.
+// Image rows are ordered top to bottom.
+class QT3DRAYTRACESHARED_EXPORT QRgbeImage
+{
+public:
+    // Encodes 16-bit or 32-bit floating point RGB or RGBA image; alpha is discarded.
+    static bool encode(const QImageData &image, QIODevice *device);
+    // Decodes to 16-bit or 32-bit floating point RGBA image.
+    static bool decode(const uchar *imageData, quint64 imageSize, QImageData &image, QImageData::ValueType type = QImageData::ValueType::Float32);
+};
+
+} // Qt3DRaytrace
@@ -9,6 +9,8 @@
 #include <Qt3DRaytrace/qt3draytrace_global.h>
 #include <Qt3DRaytrace/qabstracttexture.h>
 
+#include <Qt3DRaytrace/qassetstatistics.h>
+
 #include <QUrl>
 
 namespace Qt3DRaytrace {
@@ -20,6 +22,10 @@ class QT3DRAYTRACESHARED_EXPORT QTexture : public QAbstractTexture
     Q_OBJECT
     Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(float progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(Qt3DRaytrace::QAssetStatistics statistics READ statistics NOTIFY statisticsChanged)
+    Q_PROPERTY(bool generateMipmaps READ generateMipmaps WRITE setGenerateMipmaps NOTIFY generateMipmapsChanged)
+    Q_PROPERTY(Compression compression READ compression WRITE setCompression NOTIFY compressionChanged)
 public:
     explicit QTexture(Qt3DCore::QNode *parent = nullptr);
 
@@ -31,18 +37,40 @@ public:
     };
     Q_ENUM(Status)
 
+    // Block compression is chosen by texture role.
+    enum Compression {
+        NoCompression = 0,
+        BaseColorCompression,    // BC7: high quality RGBA, 1 byte per texel.
+        CompactColorCompression, // BC1: RGB, 0.5 byte per texel.
+        NormalMapCompression,    // BC5: two channel vectors, 1 byte per texel.
+        GrayscaleCompression,    // BC4: single channel (e.g. roughness or metalness), 0.5 byte per texel.
+        HdrCompression,          // BC6H: unsigned HDR RGB, 1 byte per texel.
+    };
+    Q_ENUM(Compression)
+
     QUrl source() const;
     Status status() const;
+    float progress() const;
+    QAssetStatistics statistics() const;
+    bool generateMipmaps() const;
+    Compression compression() const;
 
 public slots:
     void setSource(const QUrl &source);
+    void setGenerateMipmaps(bool generateMipmaps);
+    void setCompression(Compression compression);
 
 signals:
     void sourceChanged(const QUrl &source);
     void statusChanged(Status status);
+    void progressChanged(float progress);
+    void statisticsChanged(const Qt3DRaytrace::QAssetStatistics &statistics);
+    void generateMipmapsChanged(bool generateMipmaps);
+    void compressionChanged(Compression compression);
 
 protected:
     explicit QTexture(QTexturePrivate &dd, Qt3DCore::QNode *parent = nullptr);
+    void sceneChangeEvent(const Qt3DCore::QSceneChangePtr &change) override;
 
 private:
     Q_DECLARE_PRIVATE(QTexture)
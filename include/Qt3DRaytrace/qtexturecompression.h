@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <Qt3DRaytrace/qt3draytrace_global.h>
+#include <Qt3DRaytrace/qimagedata.h>
+
+#include <QUrl>
+
+namespace Qt3DRaytrace {
+
+// Block compression of texture images, same as done by QTexture when compression is enabled.
+class QT3DRAYTRACESHARED_EXPORT QTextureCompression
+{
+public:
+    // Imports image from any file format supported by QTexture.
+    static bool importImage(const QUrl &source, QImageData &data);
+    static bool generateMipmaps(QImageData &data);
+
+    static bool compress(QImageData &data, QImageData::BlockFormat blockFormat);
+    static bool decompress(const QImageData &data, QImageData &result);
+
+    // Peak signal to noise ratio in decibels between first mip levels of two uncompressed images of equal dimensions.
+    // Compares given number of channels, or all channels present in both images if zero. Peak value is 255 for 8-bit
+    // reference images and the largest reference value for floating point ones. Returns negative value on error.
+    static double computePSNR(const QImageData &reference, const QImageData &image, int numChannels = 0);
+};
+
+} // Qt3DRaytrace
@@ -10,6 +10,7 @@
 
 #include <Qt3DCore/QPropertyUpdatedChange>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 
 using namespace Qt3DCore;
 
@@ -27,6 +28,22 @@ void AbstractTexture::setManager(TextureManager *manager)
     m_manager = manager;
 }
 
+void AbstractTexture::setStatisticsManager(AssetStatisticsManager *statisticsManager)
+{
+    Q_ASSERT(statisticsManager);
+    m_statisticsManager = statisticsManager;
+}
+
+void AbstractTexture::markFactoryDirty()
+{
+    if(m_imageFactory && m_manager) {
+        m_manager->markComponentDirty(peerId());
+        if(m_statisticsManager) {
+            m_statisticsManager->beginLoad(peerId());
+        }
+    }
+}
+
 void AbstractTexture::sceneChangeEvent(const QSceneChangePtr &change)
 {
     if(change->type() == PropertyUpdated) {
@@ -37,9 +54,7 @@ void AbstractTexture::sceneChangeEvent(const QSceneChangePtr &change)
         }
         else if(propertyName == QByteArrayLiteral("imageFactory")) {
             m_imageFactory = propertyChange->value().value<QTextureImageFactoryPtr>();
-            if(m_imageFactory && m_manager) {
-                m_manager->markComponentDirty(peerId());
-            }
+            markFactoryDirty();
         }
     }
 
@@ -51,8 +66,22 @@ void AbstractTexture::loadImage()
 {
     Q_ASSERT(m_imageFactory);
 
-    std::unique_ptr<QTextureImage> image(m_imageFactory->create());
+    QElapsedTimer timer;
+    timer.start();
+
+    QAssetStatistics statistics;
+    std::unique_ptr<QTextureImage> image(m_imageFactory->create(statistics));
+    if(statistics.decodeTime == 0.0 && statistics.conversionTime == 0.0) {
+        statistics.decodeTime = double(timer.nsecsElapsed()) * 1e-6;
+    }
+    statistics.succeeded = bool(image);
+
     if(image) {
+        if(statistics.numPixels == 0) {
+            const QImageData &data = image->data();
+            statistics.numPixels = qint64(data.width) * qint64(data.height);
+            statistics.memoryFootprint = qint64(data.sizeInBytes());
+        }
         image->moveToThread(QCoreApplication::instance()->thread());
 
         auto change = QTextureImageChangePtr::create(peerId());
@@ -61,6 +90,16 @@ void AbstractTexture::loadImage()
         change->data = std::move(image);
         notifyObservers(change);
     }
+
+    if(m_statisticsManager) {
+        m_statisticsManager->finishLoad(peerId(), statistics);
+    }
+
+    auto statisticsChange = QPropertyUpdatedChangePtr::create(peerId());
+    statisticsChange->setDeliveryFlags(QSceneChange::Nodes);
+    statisticsChange->setPropertyName("statistics");
+    statisticsChange->setValue(QVariant::fromValue(statistics));
+    notifyObservers(statisticsChange);
 }
 
 void AbstractTexture::initializeFromPeer(const QNodeCreatedChangeBasePtr &change)
@@ -70,9 +109,7 @@ void AbstractTexture::initializeFromPeer(const QNodeCreatedChangeBasePtr &change
 
     m_imageId = data.imageId;
     m_imageFactory = data.imageFactory;
-    if(m_imageFactory && m_manager) {
-        m_manager->markComponentDirty(peerId());
-    }
+    markFactoryDirty();
 
     markDirty(AbstractRenderer::TextureDirty);
 }
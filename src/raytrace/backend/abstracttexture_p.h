@@ -8,6 +8,7 @@
 
 #include <qt3draytrace_global_p.h>
 #include <backend/backendnode_p.h>
+#include <backend/assetstatisticsmanager_p.h>
 #include <Qt3DRaytrace/qtextureimagefactory.h>
 
 namespace Qt3DRaytrace {
@@ -21,6 +22,7 @@ public:
     AbstractTexture();
 
     void setManager(TextureManager *manager);
+    void setStatisticsManager(AssetStatisticsManager *statisticsManager);
     void sceneChangeEvent(const Qt3DCore::QSceneChangePtr &change) override;
     void loadImage();
 
@@ -29,8 +31,10 @@ public:
 
 private:
     void initializeFromPeer(const Qt3DCore::QNodeCreatedChangeBasePtr &change) override;
+    void markFactoryDirty();
 
     TextureManager *m_manager;
+    AssetStatisticsManager *m_statisticsManager = nullptr;
     Qt3DCore::QNodeId m_imageId;
     QTextureImageFactoryPtr m_imageFactory;
 };
@@ -38,16 +42,27 @@ private:
 class TextureNodeMapper final : public BackendNodeMapper<AbstractTexture, TextureManager>
 {
 public:
-    TextureNodeMapper(TextureManager *manager, AbstractRenderer *renderer)
+    TextureNodeMapper(TextureManager *manager, AssetStatisticsManager *statisticsManager, AbstractRenderer *renderer)
         : BackendNodeMapper(manager, renderer)
+        , m_statisticsManager(statisticsManager)
     {}
 
     Qt3DCore::QBackendNode *create(const Qt3DCore::QNodeCreatedChangeBasePtr &change) const override
     {
         auto texture = static_cast<AbstractTexture*>(BackendNodeMapper::create(change));
         texture->setManager(m_manager);
+        texture->setStatisticsManager(m_statisticsManager);
         return texture;
     }
+
+    void destroy(Qt3DCore::QNodeId id) const override
+    {
+        m_statisticsManager->removeAsset(id);
+        BackendNodeMapper::destroy(id);
+    }
+
+private:
+    AssetStatisticsManager *m_statisticsManager;
 };
 
 } // Raytrace
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <backend/assetstatisticsmanager_p.h>
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+void AssetStatisticsManager::beginLoad(QNodeId assetId)
+{
+    QMutexLocker lock(&m_mutex);
+    m_entries[assetId].isPending = true;
+}
+
+void AssetStatisticsManager::finishLoad(QNodeId assetId, const QAssetStatistics &statistics)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_entries.find(assetId);
+    if(it != m_entries.end()) {
+        it->isPending = false;
+        it->statistics = statistics;
+    }
+}
+
+void AssetStatisticsManager::removeAsset(QNodeId assetId)
+{
+    QMutexLocker lock(&m_mutex);
+    m_entries.remove(assetId);
+}
+
+QAssetLoadSummary AssetStatisticsManager::summary() const
+{
+    QAssetLoadSummary summary;
+
+    QMutexLocker lock(&m_mutex);
+    summary.assets.reserve(m_entries.size());
+    for(const Entry &entry : m_entries) {
+        if(entry.isPending) {
+            ++summary.numPending;
+            continue;
+        }
+        const QAssetStatistics &statistics = entry.statistics;
+        if(statistics.succeeded) {
+            ++summary.numReady;
+        }
+        else {
+            ++summary.numFailed;
+        }
+        summary.bytesRead += statistics.bytesRead;
+        summary.decodeTime += statistics.decodeTime;
+        summary.conversionTime += statistics.conversionTime;
+        summary.memoryFootprint += statistics.memoryFootprint;
+        summary.assets.append(statistics);
+    }
+    lock.unlock();
+
+    const int numAssets = summary.numPending + summary.numReady + summary.numFailed;
+    if(numAssets > 0) {
+        summary.progress = double(summary.numReady + summary.numFailed) / double(numAssets);
+    }
+    std::sort(summary.assets.begin(), summary.assets.end(), [](const QAssetStatistics &a, const QAssetStatistics &b) {
+        return a.totalTime() > b.totalTime();
+    });
+    return summary;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
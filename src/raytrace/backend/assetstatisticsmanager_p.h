@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qassetstatistics.h>
+#include <Qt3DCore/QNodeId>
+
+#include <QHash>
+#include <QMutex>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Tracks load state and statistics of assets owned by geometry renderer and texture backend nodes.
+// Loads are started on the aspect thread and finished by load jobs, while summaries are queried from the frontend.
+class AssetStatisticsManager
+{
+public:
+    void beginLoad(Qt3DCore::QNodeId assetId);
+    void finishLoad(Qt3DCore::QNodeId assetId, const QAssetStatistics &statistics);
+    void removeAsset(Qt3DCore::QNodeId assetId);
+
+    QAssetLoadSummary summary() const;
+
+private:
+    struct Entry {
+        bool isPending = false;
+        QAssetStatistics statistics;
+    };
+    QHash<Qt3DCore::QNodeId, Entry> m_entries;
+    mutable QMutex m_mutex;
+};
+
+} // Raytrace
+} // Qt3DRaytrace
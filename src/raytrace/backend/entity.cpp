@@ -36,6 +36,7 @@ QBackendNode *EntityMapper::create(const Qt3DCore::QNodeCreatedChangeBasePtr &ch
     Entity *entity = entityManager.data(entityHandle);
     entity->m_nodeManagers = m_nodeManagers;
     entity->m_handle = entityHandle;
+    entity->m_componentRow = m_nodeManagers->entityComponentTable.addEntity(entityHandle);
     entity->setRenderer(m_renderer);
     return entity;
 }
@@ -49,7 +50,14 @@ QBackendNode *EntityMapper::get(Qt3DCore::QNodeId id) const
 void EntityMapper::destroy(Qt3DCore::QNodeId id) const
 {
     Q_ASSERT(m_nodeManagers);
+    if(Entity *entity = m_nodeManagers->entityManager.lookupResource(id)) {
+        // Renderer must see the removal to drop the entity from its renderable and emissive sets.
+        m_renderer->markDirty(AbstractRenderer::EntityDirty, entity);
+        m_nodeManagers->entityComponentTable.removeEntity(entity->m_componentRow);
+        entity->m_componentRow = -1;
+    }
     m_nodeManagers->entityManager.releaseResource(id);
+    m_nodeManagers->worldTransformManager.markHierarchyDirty();
 }
 
 Entity::~Entity()
@@ -164,45 +172,52 @@ void Entity::removeComponent(QNodeId nodeId)
 Transform *Entity::transformComponent() const
 {
     Q_ASSERT(m_nodeManagers);
-    return m_nodeManagers->transformManager.lookupResource(m_transformComponent);
+    return m_nodeManagers->entityComponentTable.transform(m_componentRow);
 }
 
 GeometryRenderer *Entity::geometryRendererComponent() const
 {
     Q_ASSERT(m_nodeManagers);
-    return m_nodeManagers->geometryRendererManager.lookupResource(m_geometryRendererComponent);
+    return m_nodeManagers->entityComponentTable.geometryRenderer(m_componentRow);
 }
 
 Material *Entity::materialComponent() const
 {
     Q_ASSERT(m_nodeManagers);
-    return m_nodeManagers->materialManager.lookupResource(m_materialComponent);
+    return m_nodeManagers->entityComponentTable.material(m_componentRow);
 }
 
 DistantLight *Entity::distantLightComponent() const
 {
     Q_ASSERT(m_nodeManagers);
-    return m_nodeManagers->distantLightManager.lookupResource(m_distantLightComponent);
+    return m_nodeManagers->entityComponentTable.distantLight(m_componentRow);
 }
 
 CameraLens *Entity::cameraLensComponent() const
 {
     Q_ASSERT(m_nodeManagers);
-    return m_nodeManagers->cameraManager.lookupResource(m_cameraLensComponent);
+    return m_nodeManagers->entityComponentTable.cameraLens(m_componentRow);
+}
+
+Matrix4x4 Entity::worldTransformMatrix() const
+{
+    Q_ASSERT(m_nodeManagers);
+    return m_nodeManagers->worldTransformManager.worldTransformMatrix(m_worldTransformIndex);
 }
 
 bool Entity::isRenderable() const
 {
-    if(m_geometryRendererComponent.isNull() || m_materialComponent.isNull()) {
+    const GeometryRenderer *geometryRenderer = geometryRendererComponent();
+    if(!geometryRenderer || !materialComponent()) {
         return false;
     }
-    return !geometryRendererComponent()->geometryId().isNull();
+    return !geometryRenderer->geometryId().isNull();
 }
 
 bool Entity::isEmissive() const
 {
-    if(!m_distantLightComponent.isNull()) {
-        if(!distantLightComponent()->radiance().isBlack()) {
+    if(const DistantLight *distantLight = distantLightComponent()) {
+        if(!distantLight->radiance().isBlack()) {
             return true;
         }
     }
@@ -221,16 +236,22 @@ bool Entity::isCamera() const
 
 void Entity::sceneChangeEvent(const QSceneChangePtr &changeEvent)
 {
+    WorldTransformManager &worldTransformManager = m_nodeManagers->worldTransformManager;
+
     switch(changeEvent->type()) {
     case ComponentAdded: {
         QComponentAddedChangePtr change = qSharedPointerCast<QComponentAddedChange>(changeEvent);
         addComponent(QNodeIdTypePair{change->componentId(), change->componentMetaObject()});
+        m_nodeManagers->entityComponentTable.resolveComponents(m_componentRow);
+        worldTransformManager.markHierarchyDirty();
         markDirty(AbstractRenderer::AllDirty);
         break;
     }
     case ComponentRemoved: {
         QComponentRemovedChangePtr change = qSharedPointerCast<QComponentRemovedChange>(changeEvent);
         removeComponent(change->componentId());
+        m_nodeManagers->entityComponentTable.resolveComponents(m_componentRow);
+        worldTransformManager.markHierarchyDirty();
         markDirty(AbstractRenderer::AllDirty);
         break;
     }
@@ -238,6 +259,7 @@ void Entity::sceneChangeEvent(const QSceneChangePtr &changeEvent)
         QPropertyNodeAddedChangePtr change = qSharedPointerCast<QPropertyNodeAddedChange>(changeEvent);
         if(change->metaObject()->inherits(&QEntity::staticMetaObject)) {
             appendChildHandle(m_nodeManagers->entityManager.lookupHandle(change->addedNodeId()));
+            worldTransformManager.markHierarchyDirty();
             markDirty(AbstractRenderer::AllDirty);
         }
         break;
@@ -246,6 +268,7 @@ void Entity::sceneChangeEvent(const QSceneChangePtr &changeEvent)
         QPropertyNodeRemovedChangePtr change = qSharedPointerCast<QPropertyNodeRemovedChange>(changeEvent);
         if(change->metaObject()->inherits(&QEntity::staticMetaObject)) {
             removeChildHandle(m_nodeManagers->entityManager.lookupHandle(change->removedNodeId()));
+            worldTransformManager.markHierarchyDirty();
             markDirty(AbstractRenderer::AllDirty);
         }
         break;
@@ -271,11 +294,13 @@ void Entity::initializeFromPeer(const QNodeCreatedChangeBasePtr &change)
     for(const auto &idAndType : qAsConst(data.componentIdsAndTypes)) {
         addComponent(idAndType);
     }
+    m_nodeManagers->entityComponentTable.resolveComponents(m_componentRow);
 
     if(!data.parentEntityId.isNull()) {
         setParentHandle(m_nodeManagers->entityManager.lookupHandle(data.parentEntityId));
     }
 
+    m_nodeManagers->worldTransformManager.markHierarchyDirty();
     markDirty(AbstractRenderer::AllDirty);
 }
 
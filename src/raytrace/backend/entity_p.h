@@ -33,6 +33,8 @@ class Entity : public BackendNode
 {
     friend class EntityMapper;
     friend class EntityManager;
+    friend class WorldTransformManager;
+    friend class EntityComponentTable;
 public:
     ~Entity();
 
@@ -68,8 +70,7 @@ public:
     bool isEmissive() const;
     bool isCamera() const;
 
-    // TODO: Store via manager.
-    Matrix4x4 worldTransformMatrix;
+    Matrix4x4 worldTransformMatrix() const;
 
 protected:
     void sceneChangeEvent(const Qt3DCore::QSceneChangePtr &changeEvent) override;
@@ -81,6 +82,8 @@ private:
     HEntity m_handle;
     HEntity m_parentHandle;
     QVector<HEntity> m_childrenHandles;
+    int m_worldTransformIndex = -1;
+    int m_componentRow = -1;
 
     Qt3DCore::QNodeId m_transformComponent;
     Qt3DCore::QNodeId m_geometryRendererComponent;
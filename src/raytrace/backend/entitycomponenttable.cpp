@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <backend/entitycomponenttable_p.h>
+#include <backend/managers_p.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+template<typename HandleType, typename ManagerType>
+static bool resolveComponentHandle(ManagerType &manager, QNodeId componentId, HandleType &handle)
+{
+    if(componentId.isNull()) {
+        handle = HandleType();
+        return true;
+    }
+    handle = manager.lookupHandle(componentId);
+    return !handle.isNull();
+}
+
+EntityComponentTable::EntityComponentTable(NodeManagers *managers)
+    : m_nodeManagers(managers)
+{
+    Q_ASSERT(m_nodeManagers);
+}
+
+int EntityComponentTable::addEntity(const HEntity &entityHandle)
+{
+    const int row = m_entities.size();
+    m_entities.append(entityHandle);
+    m_transforms.append(HTransform());
+    m_geometryRenderers.append(HGeometryRenderer());
+    m_materials.append(HMaterial());
+    m_distantLights.append(HDistantLight());
+    m_cameraLenses.append(HCameraLens());
+    return row;
+}
+
+void EntityComponentTable::removeEntity(int row)
+{
+    if(!isValidRow(row)) {
+        return;
+    }
+
+    const int lastRow = m_entities.size() - 1;
+    if(row != lastRow) {
+        m_entities[row] = m_entities[lastRow];
+        m_transforms[row] = m_transforms[lastRow];
+        m_geometryRenderers[row] = m_geometryRenderers[lastRow];
+        m_materials[row] = m_materials[lastRow];
+        m_distantLights[row] = m_distantLights[lastRow];
+        m_cameraLenses[row] = m_cameraLenses[lastRow];
+        if(Entity *movedEntity = m_entities[row].data()) {
+            movedEntity->m_componentRow = row;
+        }
+    }
+
+    m_entities.removeLast();
+    m_transforms.removeLast();
+    m_geometryRenderers.removeLast();
+    m_materials.removeLast();
+    m_distantLights.removeLast();
+    m_cameraLenses.removeLast();
+}
+
+void EntityComponentTable::resolveComponents(int row)
+{
+    const Entity *entity = this->entity(row);
+    if(!entity) {
+        return;
+    }
+
+    // Component backend nodes may be created after the entity referencing them.
+    // Such entities are revisited in resolvePendingComponents() once all creation changes are processed.
+    bool resolved = true;
+    resolved &= resolveComponentHandle(m_nodeManagers->transformManager, entity->transformComponentId(), m_transforms[row]);
+    resolved &= resolveComponentHandle(m_nodeManagers->geometryRendererManager, entity->geometryRendererComponentId(), m_geometryRenderers[row]);
+    resolved &= resolveComponentHandle(m_nodeManagers->materialManager, entity->materialComponentId(), m_materials[row]);
+    resolved &= resolveComponentHandle(m_nodeManagers->distantLightManager, entity->distantLightComponentId(), m_distantLights[row]);
+    resolved &= resolveComponentHandle(m_nodeManagers->cameraManager, entity->cameraLensComponentId(), m_cameraLenses[row]);
+    if(!resolved) {
+        m_pendingEntities.append(entity->handle());
+    }
+}
+
+void EntityComponentTable::resolvePendingComponents()
+{
+    if(m_pendingEntities.isEmpty()) {
+        return;
+    }
+
+    QVector<HEntity> pendingEntities;
+    pendingEntities.swap(m_pendingEntities);
+    for(const HEntity &entityHandle : pendingEntities) {
+        if(const Entity *entity = entityHandle.data()) {
+            resolveComponents(entity->m_componentRow);
+        }
+    }
+}
+
+} // Raytrace
+} // Qt3DRaytrace
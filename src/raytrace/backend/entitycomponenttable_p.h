@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+#include <backend/handles_p.h>
+#include <backend/entity_p.h>
+#include <backend/transform_p.h>
+#include <backend/geometryrenderer_p.h>
+#include <backend/material_p.h>
+#include <backend/distantlight_p.h>
+#include <backend/cameralens_p.h>
+
+#include <QVector>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+struct NodeManagers;
+
+// Packed table of component handles resolved for every entity, one row per entity.
+// Rows are kept dense by moving the last row into the slot of a removed entity,
+// so jobs can iterate all entities and their components linearly.
+class EntityComponentTable
+{
+public:
+    explicit EntityComponentTable(NodeManagers *managers);
+
+    int addEntity(const HEntity &entityHandle);
+    void removeEntity(int row);
+
+    void resolveComponents(int row);
+    void resolvePendingComponents();
+
+    int size() const { return m_entities.size(); }
+
+    const QVector<HEntity> &entities() const { return m_entities; }
+    const QVector<HTransform> &transforms() const { return m_transforms; }
+    const QVector<HGeometryRenderer> &geometryRenderers() const { return m_geometryRenderers; }
+    const QVector<HMaterial> &materials() const { return m_materials; }
+    const QVector<HDistantLight> &distantLights() const { return m_distantLights; }
+    const QVector<HCameraLens> &cameraLenses() const { return m_cameraLenses; }
+
+    Entity *entity(int row) const { return isValidRow(row) ? m_entities[row].data() : nullptr; }
+    Transform *transform(int row) const { return isValidRow(row) ? m_transforms[row].data() : nullptr; }
+    GeometryRenderer *geometryRenderer(int row) const { return isValidRow(row) ? m_geometryRenderers[row].data() : nullptr; }
+    Material *material(int row) const { return isValidRow(row) ? m_materials[row].data() : nullptr; }
+    DistantLight *distantLight(int row) const { return isValidRow(row) ? m_distantLights[row].data() : nullptr; }
+    CameraLens *cameraLens(int row) const { return isValidRow(row) ? m_cameraLenses[row].data() : nullptr; }
+
+private:
+    bool isValidRow(int row) const { return row >= 0 && row < m_entities.size(); }
+
+    NodeManagers *m_nodeManagers;
+
+    QVector<HEntity> m_entities;
+    QVector<HTransform> m_transforms;
+    QVector<HGeometryRenderer> m_geometryRenderers;
+    QVector<HMaterial> m_materials;
+    QVector<HDistantLight> m_distantLights;
+    QVector<HCameraLens> m_cameraLenses;
+
+    QVector<HEntity> m_pendingEntities;
+};
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -47,5 +47,14 @@ void Geometry::initializeFromPeer(const QNodeCreatedChangeBasePtr &change)
     markDirty(AbstractRenderer::GeometryDirty);
 }
 
+void GeometryNodeMapper::destroy(QNodeId id) const
+{
+    // Renderer must see the removal to release its device resources.
+    if(Geometry *geometry = m_manager->lookupResource(id)) {
+        m_renderer->markDirty(AbstractRenderer::GeometryDirty, geometry);
+    }
+    BackendNodeMapper::destroy(id);
+}
+
 } // Raytrace
 } // Qt3DRaytrace
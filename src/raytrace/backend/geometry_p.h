@@ -20,8 +20,10 @@ class Geometry : public BackendNode
 {
 public:
     const QGeometryData &data() const { return m_data; }
-    const QVector<QVertex> &vertices() const { return m_data.vertices; }
-    const QVector<QTriangle> &faces() const { return m_data.faces; }
+    quint64 numVertices() const { return m_data.numVertices(); }
+    quint64 numFaces() const { return m_data.numFaces(); }
+    const QVertex *vertexData() const { return m_data.vertexData(); }
+    const QTriangle *faceData() const { return m_data.faceData(); }
 
     void setManager(GeometryManager *manager);
     void sceneChangeEvent(const Qt3DCore::QSceneChangePtr &change) override;
@@ -46,6 +48,8 @@ public:
         geometry->setManager(m_manager);
         return geometry;
     }
+
+    void destroy(Qt3DCore::QNodeId id) const override;
 };
 
 } // Raytrace
@@ -10,6 +10,7 @@
 
 #include <Qt3DCore/QPropertyUpdatedChange>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 
 using namespace Qt3DCore;
 
@@ -27,6 +28,22 @@ void GeometryRenderer::setManager(GeometryRendererManager *manager)
     m_manager = manager;
 }
 
+void GeometryRenderer::setStatisticsManager(AssetStatisticsManager *statisticsManager)
+{
+    Q_ASSERT(statisticsManager);
+    m_statisticsManager = statisticsManager;
+}
+
+void GeometryRenderer::markFactoryDirty()
+{
+    if(m_geometryFactory && m_manager) {
+        m_manager->markComponentDirty(peerId());
+        if(m_statisticsManager) {
+            m_statisticsManager->beginLoad(peerId());
+        }
+    }
+}
+
 void GeometryRenderer::sceneChangeEvent(const QSceneChangePtr &change)
 {
     if(change->type() == PropertyUpdated) {
@@ -37,9 +54,7 @@ void GeometryRenderer::sceneChangeEvent(const QSceneChangePtr &change)
         }
         else if(propertyName == QByteArrayLiteral("geometryFactory")) {
             m_geometryFactory = propertyChange->value().value<QGeometryFactoryPtr>();
-            if(m_geometryFactory && m_manager) {
-                m_manager->markComponentDirty(peerId());
-            }
+            markFactoryDirty();
         }
     }
 
@@ -51,8 +66,23 @@ void GeometryRenderer::loadGeometry()
 {
     Q_ASSERT(m_geometryFactory);
 
-    std::unique_ptr<QGeometry> geometry(m_geometryFactory->create());
+    QElapsedTimer timer;
+    timer.start();
+
+    QAssetStatistics statistics;
+    std::unique_ptr<QGeometry> geometry(m_geometryFactory->create(statistics));
+    if(statistics.decodeTime == 0.0 && statistics.conversionTime == 0.0) {
+        statistics.decodeTime = double(timer.nsecsElapsed()) * 1e-6;
+    }
+    statistics.succeeded = bool(geometry);
+
     if(geometry) {
+        if(statistics.numVertices == 0 && statistics.numTriangles == 0) {
+            const QGeometryData &data = geometry->data();
+            statistics.numVertices = qint64(data.numVertices());
+            statistics.numTriangles = qint64(data.numFaces());
+            statistics.memoryFootprint = qint64(data.numVertices() * sizeof(QVertex) + data.numFaces() * sizeof(QTriangle));
+        }
         geometry->moveToThread(QCoreApplication::instance()->thread());
 
         auto change = QGeometryChangePtr::create(peerId());
@@ -61,6 +91,16 @@ void GeometryRenderer::loadGeometry()
         change->data = std::move(geometry);
         notifyObservers(change);
     }
+
+    if(m_statisticsManager) {
+        m_statisticsManager->finishLoad(peerId(), statistics);
+    }
+
+    auto statisticsChange = QPropertyUpdatedChangePtr::create(peerId());
+    statisticsChange->setDeliveryFlags(QSceneChange::Nodes);
+    statisticsChange->setPropertyName("statistics");
+    statisticsChange->setValue(QVariant::fromValue(statistics));
+    notifyObservers(statisticsChange);
 }
 
 void GeometryRenderer::initializeFromPeer(const QNodeCreatedChangeBasePtr &change)
@@ -70,9 +110,7 @@ void GeometryRenderer::initializeFromPeer(const QNodeCreatedChangeBasePtr &chang
 
     m_geometryId = data.geometryId;
     m_geometryFactory = data.geometryFactory;
-    if(m_geometryFactory && m_manager) {
-        m_manager->markComponentDirty(peerId());
-    }
+    markFactoryDirty();
 
     markDirty(AbstractRenderer::GeometryDirty);
 }
@@ -8,6 +8,7 @@
 
 #include <qt3draytrace_global_p.h>
 #include <backend/backendnode_p.h>
+#include <backend/assetstatisticsmanager_p.h>
 #include <Qt3DRaytrace/qgeometryfactory.h>
 
 namespace Qt3DRaytrace {
@@ -21,6 +22,7 @@ public:
     GeometryRenderer();
 
     void setManager(GeometryRendererManager *manager);
+    void setStatisticsManager(AssetStatisticsManager *statisticsManager);
     void sceneChangeEvent(const Qt3DCore::QSceneChangePtr &change) override;
     void loadGeometry();
 
@@ -29,8 +31,10 @@ public:
 
 private:
     void initializeFromPeer(const Qt3DCore::QNodeCreatedChangeBasePtr &change) override;
+    void markFactoryDirty();
 
     GeometryRendererManager *m_manager;
+    AssetStatisticsManager *m_statisticsManager = nullptr;
     Qt3DCore::QNodeId m_geometryId;
     QGeometryFactoryPtr m_geometryFactory;
 };
@@ -38,16 +42,27 @@ private:
 class GeometryRendererNodeMapper final : public BackendNodeMapper<GeometryRenderer, GeometryRendererManager>
 {
 public:
-    GeometryRendererNodeMapper(GeometryRendererManager *manager, AbstractRenderer *renderer)
+    GeometryRendererNodeMapper(GeometryRendererManager *manager, AssetStatisticsManager *statisticsManager, AbstractRenderer *renderer)
         : BackendNodeMapper(manager, renderer)
+        , m_statisticsManager(statisticsManager)
     {}
 
     Qt3DCore::QBackendNode *create(const Qt3DCore::QNodeCreatedChangeBasePtr &change) const override
     {
         auto geometryRenderer = static_cast<GeometryRenderer*>(BackendNodeMapper::create(change));
         geometryRenderer->setManager(m_manager);
+        geometryRenderer->setStatisticsManager(m_statisticsManager);
         return geometryRenderer;
     }
+
+    void destroy(Qt3DCore::QNodeId id) const override
+    {
+        m_statisticsManager->removeAsset(id);
+        BackendNodeMapper::destroy(id);
+    }
+
+private:
+    AssetStatisticsManager *m_statisticsManager;
 };
 
 } // Raytrace
@@ -19,6 +19,8 @@ using HGeometryRenderer = Qt3DCore::QHandle<class GeometryRenderer>;
 using HTextureImage = Qt3DCore::QHandle<class TextureImage>;
 using HAbstractTexture = Qt3DCore::QHandle<class AbstractTexture>;
 using HMaterial = Qt3DCore::QHandle<class Material>;
+using HDistantLight = Qt3DCore::QHandle<class DistantLight>;
+using HCameraLens = Qt3DCore::QHandle<class CameraLens>;
 
 } // Raytrace
 } // Qt3DRaytrace
@@ -17,6 +17,9 @@
 #include <backend/material_p.h>
 #include <backend/distantlight_p.h>
 #include <backend/cameralens_p.h>
+#include <backend/worldtransformmanager_p.h>
+#include <backend/entitycomponenttable_p.h>
+#include <backend/assetstatisticsmanager_p.h>
 
 #include <QVector>
 
@@ -60,7 +63,7 @@ private:
     QVector<Qt3DCore::QNodeId> m_dirtyComponents;
 };
 
-class TransformManager : public Qt3DCore::QResourceManager<Transform, Qt3DCore::QNodeId> {};
+class TransformManager : public ComponentManager<Transform> {};
 class GeometryManager : public ComponentManager<Geometry> {};
 class GeometryRendererManager : public ComponentManager<GeometryRenderer> {};
 class TextureManager : public ComponentManager<AbstractTexture> {};
@@ -71,6 +74,10 @@ class CameraManager : public ComponentManager<CameraLens> {};
 
 struct NodeManagers
 {
+    NodeManagers()
+        : entityComponentTable(this)
+    {}
+
     EntityManager entityManager;
     TransformManager transformManager;
     GeometryManager geometryManager;
@@ -80,6 +87,9 @@ struct NodeManagers
     MaterialManager materialManager;
     DistantLightManager distantLightManager;
     CameraManager cameraManager;
+    WorldTransformManager worldTransformManager;
+    EntityComponentTable entityComponentTable;
+    AssetStatisticsManager assetStatisticsManager;
 };
 
 } // Raytrace
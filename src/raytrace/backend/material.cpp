@@ -86,5 +86,14 @@ void Material::initializeFromPeer(const QNodeCreatedChangeBasePtr &change)
     markDirty(AbstractRenderer::MaterialDirty);
 }
 
+void MaterialNodeMapper::destroy(QNodeId id) const
+{
+    // Renderer must see the removal to release its material slot.
+    if(Material *material = m_manager->lookupResource(id)) {
+        m_renderer->markDirty(AbstractRenderer::MaterialDirty, material);
+    }
+    BackendNodeMapper::destroy(id);
+}
+
 } // Raytrace
 } // Qt3DRaytrace
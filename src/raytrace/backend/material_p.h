@@ -82,6 +82,8 @@ public:
         material->setManager(m_manager);
         return material;
     }
+
+    void destroy(Qt3DCore::QNodeId id) const override;
 };
 
 } // Raytrace
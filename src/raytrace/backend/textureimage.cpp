@@ -47,5 +47,14 @@ void TextureImage::initializeFromPeer(const QNodeCreatedChangeBasePtr &change)
     markDirty(AbstractRenderer::TextureDirty);
 }
 
+void TextureImageNodeMapper::destroy(QNodeId id) const
+{
+    // Renderer must see the removal to release its device resources.
+    if(TextureImage *textureImage = m_manager->lookupResource(id)) {
+        m_renderer->markDirty(AbstractRenderer::TextureDirty, textureImage);
+    }
+    BackendNodeMapper::destroy(id);
+}
+
 } // Raytrace
 } // Qt3DRaytrace
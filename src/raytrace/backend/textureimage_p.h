@@ -44,6 +44,8 @@ public:
         textureImage->setManager(m_manager);
         return textureImage;
     }
+
+    void destroy(Qt3DCore::QNodeId id) const override;
 };
 
 } // Raytrace
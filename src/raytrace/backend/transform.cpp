@@ -5,6 +5,8 @@
  */
 
 #include <backend/transform_p.h>
+#include <backend/managers_p.h>
+
 #include <Qt3DCore/QPropertyUpdatedChange>
 
 using namespace Qt3DCore;
@@ -17,11 +19,21 @@ Transform::Transform()
     m_transform.scale = { 1.0f, 1.0f, 1.0f };
 }
 
+void Transform::setManager(TransformManager *manager)
+{
+    Q_ASSERT(manager);
+    m_manager = manager;
+}
+
 void Transform::initializeFromPeer(const QNodeCreatedChangeBasePtr &change)
 {
     const auto typedChange = qSharedPointerCast<Qt3DCore::QNodeCreatedChange<QTransformData>>(change);
     m_transform = typedChange->data;
     updateTransformMatrix();
+
+    if(m_manager) {
+        m_manager->markComponentDirty(peerId());
+    }
 }
 
 void Transform::sceneChangeEvent(const QSceneChangePtr &change)
@@ -40,6 +52,10 @@ void Transform::sceneChangeEvent(const QSceneChangePtr &change)
             m_transform.scale = propertyChange->value().value<QVector3D>();
             updateTransformMatrix();
         }
+
+        if(m_manager) {
+            m_manager->markComponentDirty(peerId());
+        }
         markDirty(AbstractRenderer::TransformDirty);
     }
     BackendNode::sceneChangeEvent(change);
@@ -18,11 +18,15 @@
 namespace Qt3DRaytrace {
 namespace Raytrace {
 
+class TransformManager;
+
 class Transform : public BackendNode
 {
 public:
     Transform();
 
+    void setManager(TransformManager *manager);
+
     Matrix4x4 transformMatrix() const { return m_transformMatrix; }
 
 protected:
@@ -32,9 +36,26 @@ private:
     void initializeFromPeer(const Qt3DCore::QNodeCreatedChangeBasePtr &change) override;
     void updateTransformMatrix();
 
+    TransformManager *m_manager = nullptr;
+
     Qt3DCore::QTransformData m_transform;
     Matrix4x4 m_transformMatrix;
 };
 
+class TransformNodeMapper final : public BackendNodeMapper<Transform, TransformManager>
+{
+public:
+    TransformNodeMapper(TransformManager *manager, AbstractRenderer *renderer)
+        : BackendNodeMapper(manager, renderer)
+    {}
+
+    Qt3DCore::QBackendNode *create(const Qt3DCore::QNodeCreatedChangeBasePtr &change) const override
+    {
+        auto transform = static_cast<Transform*>(BackendNodeMapper::create(change));
+        transform->setManager(m_manager);
+        return transform;
+    }
+};
+
 } // Raytrace
 } // Qt3DRaytrace
@@ -0,0 +1,285 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <backend/worldtransformmanager_p.h>
+#include <backend/managers_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QAtomicInt>
+
+#include <algorithm>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+// Number of dirty subtree roots above which levels are swept in full instead of walking individual subtrees.
+static constexpr int DenseUpdateThreshold = 256;
+// Minimum number of nodes in a single hierarchy level for it to be processed in parallel.
+static constexpr int ParallelLevelThreshold = 2048;
+static constexpr int ParallelGrainSize = 512;
+
+} // Config
+
+void WorldTransformManager::markHierarchyDirty()
+{
+    m_hierarchyDirty = true;
+}
+
+void WorldTransformManager::update(NodeManagers *managers, Entity *root)
+{
+    Q_ASSERT(managers);
+
+    const HEntity rootHandle = root ? root->handle() : HEntity();
+    if(m_hierarchyDirty || rootHandle != m_rootHandle) {
+        rebuildHierarchy(managers, root);
+        updateWorldTransformsDense();
+    }
+    else {
+        updateLocalTransforms(managers);
+        if(m_dirtyRoots.size() > Config::DenseUpdateThreshold) {
+            updateWorldTransformsDense();
+        }
+        else {
+            updateWorldTransformsSparse();
+        }
+    }
+}
+
+QVector<HEntity> WorldTransformManager::transformEntities(QNodeId transformId) const
+{
+    QVector<HEntity> result;
+    const auto it = m_transformNodes.constFind(transformId);
+    if(it != m_transformNodes.constEnd()) {
+        result.reserve(it->size());
+        for(int index : *it) {
+            result.append(m_entities[index]);
+        }
+    }
+    return result;
+}
+
+void WorldTransformManager::rebuildHierarchy(NodeManagers *managers, Entity *root)
+{
+    EntityManager &entityManager = managers->entityManager;
+
+    for(const HEntity &handle : qAsConst(m_entities)) {
+        if(Entity *entity = entityManager.data(handle)) {
+            entity->m_worldTransformIndex = -1;
+        }
+    }
+
+    m_entities.resize(0);
+    m_parentIndices.resize(0);
+    m_childOffsets.resize(0);
+    m_levelOffsets.resize(0);
+    m_localMatrices.resize(0);
+    m_transformNodes.clear();
+    m_dirtyRoots.resize(0);
+
+    // Local transforms are re-read below so pending component updates are redundant.
+    managers->transformManager.clearDirtyComponents();
+
+    m_rootHandle = root ? root->handle() : HEntity();
+    m_hierarchyDirty = false;
+
+    if(root) {
+        root->m_worldTransformIndex = 0;
+        m_entities.append(m_rootHandle);
+        m_parentIndices.append(-1);
+    }
+
+    m_levelOffsets.append(0);
+    int levelBegin = 0;
+    while(levelBegin < m_entities.size()) {
+        const int levelEnd = m_entities.size();
+        for(int index=levelBegin; index < levelEnd; ++index) {
+            m_childOffsets.append(m_entities.size());
+
+            const Entity *entity = entityManager.data(m_entities[index]);
+            Q_ASSERT(entity);
+            for(const HEntity &childHandle : entity->childrenHandles()) {
+                Entity *child = entityManager.data(childHandle);
+                if(!child) {
+                    continue;
+                }
+                child->m_worldTransformIndex = m_entities.size();
+                m_entities.append(childHandle);
+                m_parentIndices.append(index);
+            }
+        }
+        m_levelOffsets.append(m_entities.size());
+        levelBegin = levelEnd;
+    }
+    m_childOffsets.append(m_entities.size());
+
+    const int numNodes = m_entities.size();
+    m_localMatrices.resize(numNodes);
+    m_worldMatrices.resize(numNodes);
+    for(int index=0; index < numNodes; ++index) {
+        const Entity *entity = entityManager.data(m_entities[index]);
+        if(const Transform *transform = entity->transformComponent()) {
+            m_localMatrices[index] = transform->transformMatrix();
+            m_transformNodes[entity->transformComponentId()].append(index);
+        }
+        else {
+            m_localMatrices[index] = Matrix4x4();
+        }
+    }
+
+    m_dirtyFlags.fill(1, numNodes);
+}
+
+void WorldTransformManager::updateLocalTransforms(NodeManagers *managers)
+{
+    TransformManager &transformManager = managers->transformManager;
+
+    const QVector<QNodeId> dirtyTransforms = transformManager.acquireDirtyComponents();
+    for(const QNodeId &transformId : dirtyTransforms) {
+        const auto it = m_transformNodes.constFind(transformId);
+        if(it == m_transformNodes.constEnd()) {
+            continue;
+        }
+        const Transform *transform = transformManager.lookupResource(transformId);
+        const Matrix4x4 transformMatrix = transform ? transform->transformMatrix() : Matrix4x4();
+        for(int index : *it) {
+            m_localMatrices[index] = transformMatrix;
+            markNodeDirty(index);
+        }
+    }
+}
+
+void WorldTransformManager::markNodeDirty(int index)
+{
+    if(!m_dirtyFlags[index]) {
+        m_dirtyFlags[index] = 1;
+        m_dirtyRoots.append(index);
+    }
+}
+
+int WorldTransformManager::nodeLevel(int index) const
+{
+    const auto it = std::upper_bound(m_levelOffsets.cbegin(), m_levelOffsets.cend(), index);
+    return int(it - m_levelOffsets.cbegin()) - 1;
+}
+
+void WorldTransformManager::updateWorldTransformsSparse()
+{
+    if(m_dirtyRoots.isEmpty()) {
+        return;
+    }
+
+    // Ancestors have lower indices than their descendants so walking roots in ascending order
+    // visits every dirty subtree exactly once: nested roots are cleared by their ancestor's walk.
+    std::sort(m_dirtyRoots.begin(), m_dirtyRoots.end());
+
+    const int *parentIndices = m_parentIndices.constData();
+    const int *childOffsets = m_childOffsets.constData();
+    const Matrix4x4 *localMatrices = m_localMatrices.constData();
+    Matrix4x4 *worldMatrices = m_worldMatrices.data();
+    uchar *dirtyFlags = m_dirtyFlags.data();
+
+    QVector<int> stack;
+    for(int rootIndex : qAsConst(m_dirtyRoots)) {
+        if(!dirtyFlags[rootIndex]) {
+            continue;
+        }
+        stack.append(rootIndex);
+        while(!stack.isEmpty()) {
+            const int index = stack.takeLast();
+            const int parentIndex = parentIndices[index];
+            worldMatrices[index] = (parentIndex >= 0) ? worldMatrices[parentIndex] * localMatrices[index] : localMatrices[index];
+            dirtyFlags[index] = 0;
+            for(int childIndex=childOffsets[index]; childIndex < childOffsets[index+1]; ++childIndex) {
+                stack.append(childIndex);
+            }
+        }
+    }
+    m_dirtyRoots.resize(0);
+}
+
+void WorldTransformManager::updateWorldTransformsDense()
+{
+    const int numLevels = this->numLevels();
+    if(numLevels == 0) {
+        m_dirtyRoots.resize(0);
+        return;
+    }
+
+    const int *parentIndices = m_parentIndices.constData();
+    const Matrix4x4 *localMatrices = m_localMatrices.constData();
+    Matrix4x4 *worldMatrices = m_worldMatrices.data();
+    uchar *dirtyFlags = m_dirtyFlags.data();
+
+    // Levels that contain no dirty node and whose parent level propagated nothing are skipped entirely.
+    QVector<uchar> levelHasDirtyRoots(numLevels, 0);
+    int firstLevel = 0;
+    if(!m_dirtyRoots.isEmpty()) {
+        firstLevel = numLevels;
+        for(int index : qAsConst(m_dirtyRoots)) {
+            const int level = nodeLevel(index);
+            levelHasDirtyRoots[level] = 1;
+            firstLevel = qMin(firstLevel, level);
+        }
+    }
+    else {
+        levelHasDirtyRoots.fill(1);
+    }
+
+    int sweepBegin = -1;
+    int sweepEnd = -1;
+    bool parentLevelDirty = false;
+    for(int level=firstLevel; level < numLevels; ++level) {
+        if(!parentLevelDirty && !levelHasDirtyRoots[level]) {
+            continue;
+        }
+
+        const int levelBegin = m_levelOffsets[level];
+        const int levelEnd = m_levelOffsets[level+1];
+
+        QAtomicInt levelDirty(0);
+        auto updateRange = [&](int begin, int end) {
+            bool rangeDirty = false;
+            for(int index=begin; index < end; ++index) {
+                const int parentIndex = parentIndices[index];
+                const bool parentDirty = (parentIndex >= 0) && dirtyFlags[parentIndex];
+                if(dirtyFlags[index] || parentDirty) {
+                    worldMatrices[index] = (parentIndex >= 0) ? worldMatrices[parentIndex] * localMatrices[index] : localMatrices[index];
+                    dirtyFlags[index] = 1;
+                    rangeDirty = true;
+                }
+            }
+            if(rangeDirty) {
+                levelDirty.store(1);
+            }
+        };
+
+        if(levelEnd - levelBegin >= Config::ParallelLevelThreshold) {
+            Utility::parallelFor(levelBegin, levelEnd, Config::ParallelGrainSize, updateRange);
+        }
+        else {
+            updateRange(levelBegin, levelEnd);
+        }
+
+        parentLevelDirty = (levelDirty.load() != 0);
+        if(sweepBegin < 0) {
+            sweepBegin = levelBegin;
+        }
+        sweepEnd = levelEnd;
+    }
+
+    if(sweepBegin >= 0) {
+        std::fill(dirtyFlags + sweepBegin, dirtyFlags + sweepEnd, uchar(0));
+    }
+    m_dirtyRoots.resize(0);
+}
+
+} // Raytrace
+} // Qt3DRaytrace
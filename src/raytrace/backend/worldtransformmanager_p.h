@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+#include <backend/handles_p.h>
+
+#include <QVector>
+#include <QHash>
+
+#include <Qt3DCore/QNodeId>
+#include <Qt3DCore/private/matrix4x4_p.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+struct NodeManagers;
+class Entity;
+
+// Flattened entity hierarchy stored as structure-of-arrays in breadth-first order.
+// Parents always precede their children, nodes of the same depth are stored contiguously,
+// and children of a single node occupy a contiguous range.
+class WorldTransformManager
+{
+public:
+    void markHierarchyDirty();
+    void update(NodeManagers *managers, Entity *root);
+
+    Matrix4x4 worldTransformMatrix(int index) const
+    {
+        if(index < 0 || index >= m_worldMatrices.size()) {
+            return Matrix4x4();
+        }
+        return m_worldMatrices[index];
+    }
+
+    int numTransforms() const { return m_entities.size(); }
+    int numLevels() const { return qMax(m_levelOffsets.size() - 1, 0); }
+
+    // Entities of the flattened hierarchy that reference the given transform component.
+    // Only meaningful while the hierarchy is up to date, see isHierarchyDirty().
+    QVector<HEntity> transformEntities(Qt3DCore::QNodeId transformId) const;
+    bool isHierarchyDirty() const { return m_hierarchyDirty; }
+
+private:
+    void rebuildHierarchy(NodeManagers *managers, Entity *root);
+    void updateLocalTransforms(NodeManagers *managers);
+    void markNodeDirty(int index);
+    int nodeLevel(int index) const;
+
+    void updateWorldTransformsSparse();
+    void updateWorldTransformsDense();
+
+    QVector<HEntity> m_entities;
+    QVector<int> m_parentIndices;
+    QVector<int> m_childOffsets;
+    QVector<int> m_levelOffsets;
+    QVector<Matrix4x4> m_localMatrices;
+    QVector<Matrix4x4> m_worldMatrices;
+    QVector<uchar> m_dirtyFlags;
+    QVector<int> m_dirtyRoots;
+
+    QHash<Qt3DCore::QNodeId, QVector<int>> m_transformNodes;
+
+    HEntity m_rootHandle;
+    bool m_hierarchyDirty = true;
+};
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -6,14 +6,37 @@
 
 #include <frontend/qmesh_p.h>
 #include <io/defaultmeshimporter_p.h>
+#include <io/objmeshimporter_p.h>
+#include <io/gltfmeshimporter_p.h>
+#include <io/meshpackimporter_p.h>
+#include <io/meshprocessing_p.h>
+#include <io/common_p.h>
+#include <io/assetcache_p.h>
+
+#include <Qt3DCore/QPropertyUpdatedChange>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
 
 using namespace Qt3DCore;
 
 namespace Qt3DRaytrace {
 
-// TODO: Implement status change.
 // TODO: Make mesh importer configurable.
 
+void QMeshPrivate::setStatus(QMesh::Status status)
+{
+    Q_Q(QMesh);
+    if(m_status != status) {
+        const float oldProgress = q->progress();
+        m_status = status;
+        emit q->statusChanged(status);
+        if(q->progress() != oldProgress) {
+            emit q->progressChanged(q->progress());
+        }
+    }
+}
+
 QMesh::QMesh(QNode *parent)
     : QGeometryRenderer(*new QMeshPrivate, parent)
 {}
@@ -34,6 +57,25 @@ QMesh::Status QMesh::status() const
     return d->m_status;
 }
 
+float QMesh::progress() const
+{
+    Q_D(const QMesh);
+    // Importers do not report partial progress, so an asset is either still loading or finished.
+    return (d->m_status == Ready || d->m_status == Error) ? 1.0f : 0.0f;
+}
+
+QAssetStatistics QMesh::statistics() const
+{
+    Q_D(const QMesh);
+    return d->m_statistics;
+}
+
+bool QMesh::optimize() const
+{
+    Q_D(const QMesh);
+    return d->m_optimize;
+}
+
 void QMesh::setSource(const QUrl &source)
 {
     Q_D(QMesh);
@@ -41,25 +83,116 @@ void QMesh::setSource(const QUrl &source)
         d->m_source = source;
         setGeometryFactory(QGeometryFactoryPtr(new MeshLoader(this)));
         emit sourceChanged(source);
+        d->setStatus(source.isEmpty() ? None : Loading);
     }
 }
 
+void QMesh::setOptimize(bool optimize)
+{
+    Q_D(QMesh);
+    if(d->m_optimize != optimize) {
+        d->m_optimize = optimize;
+        if(!d->m_source.isEmpty()) {
+            setGeometryFactory(QGeometryFactoryPtr(new MeshLoader(this)));
+            d->setStatus(Loading);
+        }
+        emit optimizeChanged(optimize);
+    }
+}
+
+void QMesh::sceneChangeEvent(const QSceneChangePtr &change)
+{
+    Q_D(QMesh);
+    if(change->type() == PropertyUpdated) {
+        auto propertyChange = qSharedPointerCast<QStaticPropertyUpdatedChangeBase>(change);
+        if(propertyChange->propertyName() == QByteArrayLiteral("statistics")) {
+            auto typedChange = qSharedPointerCast<QPropertyUpdatedChange>(change);
+            d->m_statistics = typedChange->value().value<QAssetStatistics>();
+            emit statisticsChanged(d->m_statistics);
+            d->setStatus(d->m_statistics.succeeded ? Ready : Error);
+            return;
+        }
+    }
+    QGeometryRenderer::sceneChangeEvent(change);
+}
+
+Raytrace::MeshImporter *createMeshImporter(const QUrl &source)
+{
+    if(Raytrace::MeshPackImporter::isSupported(source)) {
+        return new Raytrace::MeshPackImporter;
+    }
+    if(Raytrace::ObjMeshImporter::isSupported(source)) {
+        return new Raytrace::ObjMeshImporter;
+    }
+    if(Raytrace::GltfMeshImporter::isSupported(source)) {
+        return new Raytrace::GltfMeshImporter;
+    }
+    return new Raytrace::DefaultMeshImporter;
+}
+
 MeshLoader::MeshLoader(const QMesh *mesh)
-    : m_importer(new Raytrace::DefaultMeshImporter)
+    : m_importer(createMeshImporter(mesh->source()))
     , m_source(mesh->source())
+    , m_optimize(mesh->optimize())
 {}
 
 QGeometry *MeshLoader::create()
+{
+    QAssetStatistics statistics;
+    return create(statistics);
+}
+
+QGeometry *MeshLoader::create(QAssetStatistics &statistics)
 {
     Q_ASSERT(m_importer);
 
+    statistics.source = m_source;
     if(m_source.isEmpty()) {
         qCWarning(logImport) << "Mesh source path is empty";
         return nullptr;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
+    Raytrace::AssetCache *assetCache = Raytrace::AssetCache::instance();
+    const QString cacheKey = Raytrace::AssetCache::makeKey(m_source, m_optimize ? QStringLiteral("optimize") : QString());
+    m_cacheEntry = assetCache->acquireGeometry(cacheKey);
+
     QGeometryData geometryData;
-    if(m_importer->import(m_source, geometryData)) {
+    bool imported = false;
+    {
+        // Holding entry lock for the duration of the import makes concurrent loads of the same mesh wait for this one.
+        QMutexLocker lock(&m_cacheEntry->mutex);
+        if(m_cacheEntry->isLoaded) {
+            assetCache->recordHit();
+            statistics.cacheHit = true;
+            statistics.decodeTime = double(timer.nsecsElapsed()) * 1e-6;
+            geometryData = m_cacheEntry->data;
+            imported = true;
+        }
+        else {
+            assetCache->recordMiss();
+            statistics.bytesRead = QFileInfo(Raytrace::getAssetPathFromUrl(m_source)).size();
+            imported = m_importer->import(m_source, geometryData);
+            statistics.decodeTime = double(timer.nsecsElapsed()) * 1e-6;
+            if(imported && m_optimize) {
+                timer.restart();
+                Raytrace::optimizeMesh(geometryData);
+                statistics.conversionTime = double(timer.nsecsElapsed()) * 1e-6;
+            }
+            if(imported) {
+                m_cacheEntry->data = geometryData;
+                m_cacheEntry->isLoaded = true;
+            }
+        }
+    }
+
+    if(imported) {
+        statistics.numVertices = qint64(geometryData.numVertices());
+        statistics.numTriangles = qint64(geometryData.numFaces());
+        statistics.memoryFootprint = qint64(geometryData.numVertices() * sizeof(QVertex) + geometryData.numFaces() * sizeof(QTriangle));
+
         QGeometry *geometry = new QGeometry;
         geometry->setData(geometryData);
         return geometry;
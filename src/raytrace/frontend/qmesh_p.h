@@ -10,6 +10,7 @@
 #include <Qt3DRaytrace/qgeometryfactory.h>
 #include <frontend/qgeometryrenderer_p.h>
 #include <io/meshimporter_p.h>
+#include <io/assetcache_p.h>
 
 #include <QScopedPointer>
 
@@ -20,20 +21,30 @@ class QMeshPrivate : public QGeometryRendererPrivate
 public:
     Q_DECLARE_PUBLIC(QMesh)
 
+    void setStatus(QMesh::Status status);
+
     QUrl m_source;
     QMesh::Status m_status = QMesh::None;
+    QAssetStatistics m_statistics;
+    bool m_optimize = false;
 };
 
+// Creates importer best suited for given mesh source.
+Raytrace::MeshImporter *createMeshImporter(const QUrl &source);
+
 class MeshLoader final : public QGeometryFactory
 {
 public:
     explicit MeshLoader(const QMesh *mesh);
 
     QGeometry *create() override;
+    QGeometry *create(QAssetStatistics &statistics) override;
 
 private:
     QScopedPointer<Raytrace::MeshImporter> m_importer;
     QUrl m_source;
+    bool m_optimize;
+    Raytrace::AssetCache::GeometryEntryPtr m_cacheEntry;
 };
 
 } // Qt3DRaytrace
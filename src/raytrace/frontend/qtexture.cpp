@@ -6,14 +6,58 @@
 
 #include <frontend/qtexture_p.h>
 #include <io/defaultimageimporter_p.h>
+#include <io/ktximporter_p.h>
+#include <io/ddsimporter_p.h>
+#include <io/rgbeimporter_p.h>
+#include <io/imageprocessing_p.h>
+#include <io/blockcompression_p.h>
+#include <io/texturecache_p.h>
+#include <io/common_p.h>
+#include <io/assetcache_p.h>
+
+#include <Qt3DCore/QPropertyUpdatedChange>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStringList>
 
 using namespace Qt3DCore;
 
 namespace Qt3DRaytrace {
 
-// TODO: Implement status change.
 // TODO: Make texture image loader configurable.
 
+static QImageData::BlockFormat getBlockFormat(QTexture::Compression compression)
+{
+    switch(compression) {
+    case QTexture::BaseColorCompression:
+        return QImageData::BlockFormat::BC7;
+    case QTexture::CompactColorCompression:
+        return QImageData::BlockFormat::BC1;
+    case QTexture::NormalMapCompression:
+        return QImageData::BlockFormat::BC5;
+    case QTexture::GrayscaleCompression:
+        return QImageData::BlockFormat::BC4;
+    case QTexture::HdrCompression:
+        return QImageData::BlockFormat::BC6H;
+    default:
+        return QImageData::BlockFormat::None;
+    }
+}
+
+void QTexturePrivate::setStatus(QTexture::Status status)
+{
+    Q_Q(QTexture);
+    if(m_status != status) {
+        const float oldProgress = q->progress();
+        m_status = status;
+        emit q->statusChanged(status);
+        if(q->progress() != oldProgress) {
+            emit q->progressChanged(q->progress());
+        }
+    }
+}
+
 QTexture::QTexture(QNode *parent)
     : QAbstractTexture(*new QTexturePrivate, parent)
 {}
@@ -34,6 +78,31 @@ QTexture::Status QTexture::status() const
     return d->m_status;
 }
 
+float QTexture::progress() const
+{
+    Q_D(const QTexture);
+    // Importers do not report partial progress, so an asset is either still loading or finished.
+    return (d->m_status == Ready || d->m_status == Error) ? 1.0f : 0.0f;
+}
+
+QAssetStatistics QTexture::statistics() const
+{
+    Q_D(const QTexture);
+    return d->m_statistics;
+}
+
+bool QTexture::generateMipmaps() const
+{
+    Q_D(const QTexture);
+    return d->m_generateMipmaps;
+}
+
+QTexture::Compression QTexture::compression() const
+{
+    Q_D(const QTexture);
+    return d->m_compression;
+}
+
 void QTexture::setSource(const QUrl &source)
 {
     Q_D(QTexture);
@@ -41,25 +110,172 @@ void QTexture::setSource(const QUrl &source)
         d->m_source = source;
         setImageFactory(QTextureImageFactoryPtr(new TextureImageLoader(this)));
         emit sourceChanged(source);
+        d->setStatus(source.isEmpty() ? None : Loading);
+    }
+}
+
+void QTexture::setGenerateMipmaps(bool generateMipmaps)
+{
+    Q_D(QTexture);
+    if(d->m_generateMipmaps != generateMipmaps) {
+        d->m_generateMipmaps = generateMipmaps;
+        if(!d->m_source.isEmpty()) {
+            setImageFactory(QTextureImageFactoryPtr(new TextureImageLoader(this)));
+            d->setStatus(Loading);
+        }
+        emit generateMipmapsChanged(generateMipmaps);
+    }
+}
+
+void QTexture::setCompression(Compression compression)
+{
+    Q_D(QTexture);
+    if(d->m_compression != compression) {
+        d->m_compression = compression;
+        if(!d->m_source.isEmpty()) {
+            setImageFactory(QTextureImageFactoryPtr(new TextureImageLoader(this)));
+            d->setStatus(Loading);
+        }
+        emit compressionChanged(compression);
+    }
+}
+
+void QTexture::sceneChangeEvent(const QSceneChangePtr &change)
+{
+    Q_D(QTexture);
+    if(change->type() == PropertyUpdated) {
+        auto propertyChange = qSharedPointerCast<QStaticPropertyUpdatedChangeBase>(change);
+        if(propertyChange->propertyName() == QByteArrayLiteral("statistics")) {
+            auto typedChange = qSharedPointerCast<QPropertyUpdatedChange>(change);
+            d->m_statistics = typedChange->value().value<QAssetStatistics>();
+            emit statisticsChanged(d->m_statistics);
+            d->setStatus(d->m_statistics.succeeded ? Ready : Error);
+            return;
+        }
+    }
+    QAbstractTexture::sceneChangeEvent(change);
+}
+
+Raytrace::ImageImporter *createImageImporter(const QUrl &source)
+{
+    if(Raytrace::RgbeImageImporter::isSupported(source)) {
+        return new Raytrace::RgbeImageImporter;
+    }
+    if(Raytrace::KtxImageImporter::isSupported(source)) {
+        return new Raytrace::KtxImageImporter;
     }
+    if(Raytrace::DdsImageImporter::isSupported(source)) {
+        return new Raytrace::DdsImageImporter;
+    }
+    return new Raytrace::DefaultImageImporter;
+}
+
+// Texture container formats hold pixel data ready for upload, possibly with mip levels and block compression already applied.
+static bool isTextureContainer(const QUrl &source)
+{
+    return Raytrace::KtxImageImporter::isSupported(source) || Raytrace::DdsImageImporter::isSupported(source);
 }
 
 TextureImageLoader::TextureImageLoader(const QTexture *texture)
-    : m_importer(new Raytrace::DefaultImageImporter)
+    : m_importer(createImageImporter(texture->source()))
     , m_source(texture->source())
+    , m_generateMipmaps(texture->generateMipmaps())
+    , m_compression(texture->compression())
 {}
 
 QTextureImage *TextureImageLoader::create()
+{
+    QAssetStatistics statistics;
+    return create(statistics);
+}
+
+QTextureImage *TextureImageLoader::create(QAssetStatistics &statistics)
 {
     Q_ASSERT(m_importer);
 
+    statistics.source = m_source;
     if(m_source.isEmpty()) {
         qCWarning(logImport) << "Texture image source path is empty";
         return nullptr;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
+    const QImageData::BlockFormat blockFormat = getBlockFormat(m_compression);
+
+    QStringList cacheOptions;
+    if(m_generateMipmaps) {
+        cacheOptions.append(QStringLiteral("mipmaps"));
+    }
+    if(blockFormat != QImageData::BlockFormat::None) {
+        cacheOptions.append(QStringLiteral("compression=%1").arg(int(m_compression)));
+    }
+
+    Raytrace::AssetCache *assetCache = Raytrace::AssetCache::instance();
+    const QString cacheKey = Raytrace::AssetCache::makeKey(m_source, cacheOptions.join(QLatin1Char(',')));
+    m_cacheEntry = assetCache->acquireImage(cacheKey);
+
     QImageData imageData;
-    if(m_importer->import(m_source, imageData)) {
+    bool imported = false;
+    {
+        // Holding entry lock for the duration of the import makes concurrent loads of the same image wait for this one.
+        QMutexLocker lock(&m_cacheEntry->mutex);
+        if(m_cacheEntry->isLoaded) {
+            assetCache->recordHit();
+            statistics.cacheHit = true;
+            statistics.decodeTime = double(timer.nsecsElapsed()) * 1e-6;
+            imageData = m_cacheEntry->data;
+            imported = true;
+        }
+        else {
+            assetCache->recordMiss();
+            const QString sourcePath = Raytrace::getAssetPathFromUrl(m_source);
+            statistics.bytesRead = QFileInfo(sourcePath).size();
+
+            // Block compressed results are looked up in the on-disk texture cache by source file contents.
+            // Texture containers are not cached since they are mapped or copied as is, without decoding.
+            Raytrace::TextureCache *textureCache = Raytrace::TextureCache::instance();
+            QByteArray sourceHash;
+            if(blockFormat != QImageData::BlockFormat::None && textureCache->isEnabled() && !isTextureContainer(m_source)) {
+                sourceHash = Raytrace::TextureCache::computeSourceHash(sourcePath);
+            }
+            if(!sourceHash.isEmpty() && textureCache->load(sourceHash, m_generateMipmaps, blockFormat, imageData)) {
+                statistics.decodeTime = double(timer.nsecsElapsed()) * 1e-6;
+                imported = true;
+            }
+            else {
+                imported = m_importer->import(m_source, imageData);
+                statistics.decodeTime = double(timer.nsecsElapsed()) * 1e-6;
+                timer.restart();
+                // Mip levels and block compression already present in imported image are used as is.
+                if(imported && m_generateMipmaps && imageData.mipLevels == 1 && !imageData.isCompressed()) {
+                    imported = Raytrace::generateMipmaps(imageData);
+                }
+                if(imported && blockFormat != QImageData::BlockFormat::None && !imageData.isCompressed()) {
+                    // Images not suitable for requested compression are still usable uncompressed.
+                    if(Raytrace::compressImage(imageData, blockFormat)) {
+                        if(!sourceHash.isEmpty()) {
+                            textureCache->store(sourceHash, m_generateMipmaps, imageData);
+                        }
+                    }
+                    else {
+                        qCWarning(logImport) << "Using uncompressed texture image:" << m_source.toString();
+                    }
+                }
+                statistics.conversionTime = double(timer.nsecsElapsed()) * 1e-6;
+            }
+            if(imported) {
+                m_cacheEntry->data = imageData;
+                m_cacheEntry->isLoaded = true;
+            }
+        }
+    }
+
+    if(imported) {
+        statistics.numPixels = qint64(imageData.width) * qint64(imageData.height);
+        statistics.memoryFootprint = qint64(imageData.sizeInBytes());
+
         QTextureImage *image = new QTextureImage;
         image->setData(imageData);
         return image;
@@ -10,6 +10,7 @@
 #include <Qt3DRaytrace/qtextureimagefactory.h>
 #include <frontend/qabstracttexture_p.h>
 #include <io/imageimporter_p.h>
+#include <io/assetcache_p.h>
 
 #include <QScopedPointer>
 
@@ -20,20 +21,32 @@ class QTexturePrivate : public QAbstractTexturePrivate
 public:
     Q_DECLARE_PUBLIC(QTexture)
 
+    void setStatus(QTexture::Status status);
+
     QUrl m_source;
     QTexture::Status m_status = QTexture::None;
+    QAssetStatistics m_statistics;
+    bool m_generateMipmaps = false;
+    QTexture::Compression m_compression = QTexture::NoCompression;
 };
 
+// Creates importer best suited for given texture image source.
+Raytrace::ImageImporter *createImageImporter(const QUrl &source);
+
 class TextureImageLoader final : public QTextureImageFactory
 {
 public:
     explicit TextureImageLoader(const QTexture *texture);
 
     QTextureImage *create() override;
+    QTextureImage *create(QAssetStatistics &statistics) override;
 
 private:
     QScopedPointer<Raytrace::ImageImporter> m_importer;
     QUrl m_source;
+    bool m_generateMipmaps;
+    QTexture::Compression m_compression;
+    Raytrace::AssetCache::ImageEntryPtr m_cacheEntry;
 };
 
 } // Qt3DRaytrace
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/assetcache_p.h>
+#include <io/common_p.h>
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutexLocker>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+Q_GLOBAL_STATIC(AssetCache, assetCacheInstance)
+
+AssetCache *AssetCache::instance()
+{
+    return assetCacheInstance();
+}
+
+QString AssetCache::makeKey(const QUrl &url, const QString &options)
+{
+    const QString sourcePath = getAssetPathFromUrl(url);
+
+    // Source size and modification time make edited files miss the cache even while old entries are still in use.
+    const QFileInfo sourceInfo(sourcePath);
+    QString canonicalPath = sourceInfo.canonicalFilePath();
+    if(canonicalPath.isEmpty()) {
+        canonicalPath = sourceInfo.absoluteFilePath();
+    }
+    return QStringLiteral("%1|%2|%3|%4")
+            .arg(canonicalPath)
+            .arg(sourceInfo.size())
+            .arg(sourceInfo.lastModified().toMSecsSinceEpoch())
+            .arg(options);
+}
+
+template<typename T>
+QSharedPointer<AssetCache::Entry<T>> AssetCache::acquire(QHash<QString, QWeakPointer<Entry<T>>> &entries, const QString &key)
+{
+    QMutexLocker lock(&m_mutex);
+
+    auto it = entries.find(key);
+    if(it != entries.end()) {
+        if(QSharedPointer<Entry<T>> entry = it->toStrongRef()) {
+            return entry;
+        }
+    }
+
+    // Drop entries of assets no longer used by any loader before adding a new one.
+    for(auto expiredIt = entries.begin(); expiredIt != entries.end();) {
+        if(expiredIt->isNull()) {
+            expiredIt = entries.erase(expiredIt);
+        }
+        else {
+            ++expiredIt;
+        }
+    }
+
+    QSharedPointer<Entry<T>> entry(new Entry<T>);
+    entries.insert(key, entry);
+    return entry;
+}
+
+AssetCache::GeometryEntryPtr AssetCache::acquireGeometry(const QString &key)
+{
+    return acquire(m_geometryEntries, key);
+}
+
+AssetCache::ImageEntryPtr AssetCache::acquireImage(const QString &key)
+{
+    return acquire(m_imageEntries, key);
+}
+
+} // Raytrace
+} // Qt3DRaytrace
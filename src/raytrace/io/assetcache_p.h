@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qgeometrydata.h>
+#include <Qt3DRaytrace/qimagedata.h>
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QUrl>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// In-memory cache of imported assets shared by all mesh and texture loaders.
+// Entries are keyed by canonical source path, source size and modification time, and import options.
+// Loaders keep the entries they acquired alive, so an asset stays cached for as long as any mesh or texture uses it.
+// Loading an entry holds its mutex, which makes concurrent loads of the same asset wait for the first one to finish.
+class AssetCache
+{
+public:
+    template<typename T>
+    struct Entry
+    {
+        QMutex mutex;
+        bool isLoaded = false;
+        T data;
+    };
+    using GeometryEntryPtr = QSharedPointer<Entry<QGeometryData>>;
+    using ImageEntryPtr = QSharedPointer<Entry<QImageData>>;
+
+    static AssetCache *instance();
+
+    static QString makeKey(const QUrl &url, const QString &options = QString());
+
+    GeometryEntryPtr acquireGeometry(const QString &key);
+    ImageEntryPtr acquireImage(const QString &key);
+
+    void recordHit() { m_numHits.fetchAndAddRelaxed(1); }
+    void recordMiss() { m_numMisses.fetchAndAddRelaxed(1); }
+
+    int numHits() const { return m_numHits.loadAcquire(); }
+    int numMisses() const { return m_numMisses.loadAcquire(); }
+
+private:
+    template<typename T>
+    QSharedPointer<Entry<T>> acquire(QHash<QString, QWeakPointer<Entry<T>>> &entries, const QString &key);
+
+    QMutex m_mutex;
+    QHash<QString, QWeakPointer<Entry<QGeometryData>>> m_geometryEntries;
+    QHash<QString, QWeakPointer<Entry<QImageData>>> m_imageEntries;
+    QAtomicInt m_numHits;
+    QAtomicInt m_numMisses;
+};
+
+} // Raytrace
+} // Qt3DRaytrace
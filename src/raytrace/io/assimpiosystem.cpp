@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/assimpiosystem_p.h>
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+MappedIOStream::MappedIOStream(const QString &path)
+    : m_file(path)
+{}
+
+MappedIOStream::~MappedIOStream()
+{
+    if(m_isMapped) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+}
+
+MappedIOStream *MappedIOStream::open(const QString &path)
+{
+    std::unique_ptr<MappedIOStream> stream(new MappedIOStream(path));
+    if(!stream->m_file.open(QFile::ReadOnly)) {
+        return nullptr;
+    }
+
+    const qint64 fileSize = stream->m_file.size();
+    if(fileSize > 0) {
+        if(uchar *data = stream->m_file.map(0, fileSize)) {
+            stream->m_data = data;
+            stream->m_size = size_t(fileSize);
+            stream->m_isMapped = true;
+        }
+        else {
+            stream->m_buffer = stream->m_file.readAll();
+            stream->m_data = reinterpret_cast<const uchar*>(stream->m_buffer.constData());
+            stream->m_size = size_t(stream->m_buffer.size());
+        }
+    }
+    return stream.release();
+}
+
+size_t MappedIOStream::Read(void *buffer, size_t size, size_t count)
+{
+    if(size == 0 || count == 0) {
+        return 0;
+    }
+    const size_t numElementsAvailable = (m_size - m_position) / size;
+    const size_t numElementsToRead = std::min(count, numElementsAvailable);
+    const size_t numBytesToRead = numElementsToRead * size;
+    if(numBytesToRead > 0) {
+        std::memcpy(buffer, m_data + m_position, numBytesToRead);
+        m_position += numBytesToRead;
+    }
+    return numElementsToRead;
+}
+
+size_t MappedIOStream::Write(const void *buffer, size_t size, size_t count)
+{
+    Q_UNUSED(buffer);
+    Q_UNUSED(size);
+    Q_UNUSED(count);
+    return 0;
+}
+
+aiReturn MappedIOStream::Seek(size_t offset, aiOrigin origin)
+{
+    size_t newPosition;
+    switch(origin) {
+    case aiOrigin_SET:
+        newPosition = offset;
+        break;
+    case aiOrigin_CUR:
+        newPosition = m_position + offset;
+        break;
+    case aiOrigin_END:
+        // Assimp passes negative offsets relative to end of file as wrapped around unsigned values.
+        newPosition = m_size + offset;
+        break;
+    default:
+        return aiReturn_FAILURE;
+    }
+    if(newPosition > m_size) {
+        return aiReturn_FAILURE;
+    }
+    m_position = newPosition;
+    return aiReturn_SUCCESS;
+}
+
+size_t MappedIOStream::Tell() const
+{
+    return m_position;
+}
+
+size_t MappedIOStream::FileSize() const
+{
+    return m_size;
+}
+
+void MappedIOStream::Flush()
+{}
+
+bool AssimpIOSystem::Exists(const char *path) const
+{
+    return QFileInfo(resolvePath(path)).isFile();
+}
+
+char AssimpIOSystem::getOsSeparator() const
+{
+    // Qt file APIs accept forward slashes on every platform, including in resource paths.
+    return '/';
+}
+
+Assimp::IOStream *AssimpIOSystem::Open(const char *path, const char *mode)
+{
+    if(!mode || std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+')) {
+        return nullptr;
+    }
+    return MappedIOStream::open(resolvePath(path));
+}
+
+void AssimpIOSystem::Close(Assimp::IOStream *stream)
+{
+    delete stream;
+}
+
+QString AssimpIOSystem::resolvePath(const char *path)
+{
+    return QDir::cleanPath(QDir::fromNativeSeparators(QString::fromUtf8(path)));
+}
+
+} // Raytrace
+} // Qt3DRaytrace
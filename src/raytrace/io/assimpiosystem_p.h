@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <QFile>
+#include <QByteArray>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Read-only Assimp stream over a memory-mapped file.
+// Falls back to reading file contents into memory if the file cannot be mapped (e.g. compressed Qt resources).
+class MappedIOStream final : public Assimp::IOStream
+{
+public:
+    ~MappedIOStream() override;
+
+    static MappedIOStream *open(const QString &path);
+
+    size_t Read(void *buffer, size_t size, size_t count) override;
+    size_t Write(const void *buffer, size_t size, size_t count) override;
+    aiReturn Seek(size_t offset, aiOrigin origin) override;
+    size_t Tell() const override;
+    size_t FileSize() const override;
+    void Flush() override;
+
+private:
+    explicit MappedIOStream(const QString &path);
+
+    QFile m_file;
+    QByteArray m_buffer;
+    const uchar *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_position = 0;
+    bool m_isMapped = false;
+};
+
+// Assimp file system resolving both local files and Qt resources, so that importers
+// can read companion files (material libraries, external buffers) next to the main asset.
+class AssimpIOSystem final : public Assimp::IOSystem
+{
+public:
+    bool Exists(const char *path) const override;
+    char getOsSeparator() const override;
+    Assimp::IOStream *Open(const char *path, const char *mode) override;
+    void Close(Assimp::IOStream *stream) override;
+
+    static QString resolvePath(const char *path);
+};
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,1057 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/blockcompression_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QtCore/qfloat16.h>
+#include <QAtomicInt>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUARTZ_BLOCKCOMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr int GrainSize = 256;
+static constexpr int RefinementIterations = 2;
+static constexpr int PowerIterations = 8;
+static constexpr float MaxHalf = 65504.0f;
+
+} // Config
+
+namespace {
+
+using BlockFormat = QImageData::BlockFormat;
+
+constexpr int BlockTexels = 16;
+
+// BC6H and BC7 interpolation weights for 4-bit indices.
+constexpr int Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Texels of a single 4x4 block in row-major order, always holding 4 floats per texel.
+struct TexelBlock
+{
+    float texels[BlockTexels][4];
+};
+
+// Palette entries in structure of arrays layout; number of entries must be a multiple of 4.
+struct Palette
+{
+    alignas(16) float channels[4][16];
+    int numEntries;
+};
+
+struct SourceLevel
+{
+    const uchar *pixels;
+    int width;
+    int height;
+    int channels;
+    QImageData::ValueType type;
+    bool swapRB;
+};
+
+inline int clampInt(int value, int minValue, int maxValue)
+{
+    return std::min(std::max(value, minValue), maxValue);
+}
+
+inline int roundToInt(float value)
+{
+    return int(std::floor(value + 0.5f));
+}
+
+inline quint16 floatToHalfBits(float value)
+{
+    quint16 bits;
+    qFloatToFloat16(reinterpret_cast<qfloat16*>(&bits), &value, 1);
+    return bits;
+}
+
+inline float halfBitsToFloat(quint16 bits)
+{
+    float value;
+    qFloatFromFloat16(&value, reinterpret_cast<const qfloat16*>(&bits), 1);
+    return value;
+}
+
+class BitWriter
+{
+public:
+    void write(quint32 value, int count)
+    {
+        for(int i=0; i<count; ++i, ++m_position) {
+            if(value & (1u << i)) {
+                m_bytes[m_position >> 3] |= uchar(1u << (m_position & 7));
+            }
+        }
+    }
+    void store(uchar *output) const
+    {
+        std::memcpy(output, m_bytes, sizeof(m_bytes));
+    }
+
+private:
+    uchar m_bytes[16] = {};
+    int m_position = 0;
+};
+
+class BitReader
+{
+public:
+    explicit BitReader(const uchar *bytes)
+        : m_bytes(bytes)
+    {}
+    quint32 read(int count)
+    {
+        quint32 value = 0;
+        for(int i=0; i<count; ++i, ++m_position) {
+            if(m_bytes[m_position >> 3] & (1u << (m_position & 7))) {
+                value |= 1u << i;
+            }
+        }
+        return value;
+    }
+
+private:
+    const uchar *m_bytes;
+    int m_position = 0;
+};
+
+void fetchBlock(const SourceLevel &source, int blockX, int blockY, TexelBlock &block)
+{
+    const size_t texelSize = size_t(source.channels) * size_t(source.type);
+    const int numChannels = std::min(source.channels, 4);
+    const float defaultAlpha = (source.type == QImageData::ValueType::UInt8) ? 255.0f : 1.0f;
+
+    for(int y=0; y<4; ++y) {
+        const int sourceY = std::min(blockY * 4 + y, source.height - 1);
+        for(int x=0; x<4; ++x) {
+            const int sourceX = std::min(blockX * 4 + x, source.width - 1);
+            const uchar *texel = source.pixels + (size_t(sourceY) * size_t(source.width) + size_t(sourceX)) * texelSize;
+
+            float *value = block.texels[y * 4 + x];
+            value[0] = value[1] = value[2] = 0.0f;
+            value[3] = defaultAlpha;
+            for(int c=0; c<numChannels; ++c) {
+                switch(source.type) {
+                case QImageData::ValueType::UInt8:
+                    value[c] = float(texel[c]);
+                    break;
+                case QImageData::ValueType::Float16: {
+                    quint16 bits;
+                    std::memcpy(&bits, texel + c * sizeof(quint16), sizeof(bits));
+                    value[c] = halfBitsToFloat(bits);
+                    break;
+                }
+                case QImageData::ValueType::Float32:
+                    std::memcpy(&value[c], texel + c * sizeof(float), sizeof(float));
+                    break;
+                default:
+                    Q_UNREACHABLE();
+                }
+            }
+            if(source.swapRB) {
+                std::swap(value[0], value[2]);
+            }
+        }
+    }
+}
+
+// Assigns each texel an index of its nearest palette entry and returns total squared error.
+float selectIndices(const TexelBlock &block, const Palette &palette, uchar indices[BlockTexels])
+{
+    Q_ASSERT(palette.numEntries % 4 == 0);
+
+    float totalError = 0.0f;
+#if defined(QUARTZ_BLOCKCOMPRESSION_SSE2)
+    const __m128i indexStep = _mm_set1_epi32(4);
+    for(int i=0; i<BlockTexels; ++i) {
+        const __m128 r = _mm_set1_ps(block.texels[i][0]);
+        const __m128 g = _mm_set1_ps(block.texels[i][1]);
+        const __m128 b = _mm_set1_ps(block.texels[i][2]);
+        const __m128 a = _mm_set1_ps(block.texels[i][3]);
+
+        __m128 bestError = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+        for(int j=0; j<palette.numEntries; j+=4) {
+            const __m128 dr = _mm_sub_ps(_mm_load_ps(&palette.channels[0][j]), r);
+            const __m128 dg = _mm_sub_ps(_mm_load_ps(&palette.channels[1][j]), g);
+            const __m128 db = _mm_sub_ps(_mm_load_ps(&palette.channels[2][j]), b);
+            const __m128 da = _mm_sub_ps(_mm_load_ps(&palette.channels[3][j]), a);
+            const __m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+                                            _mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+            const __m128i isBetter = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+            bestError = _mm_min_ps(error, bestError);
+            bestIndex = _mm_or_si128(_mm_and_si128(isBetter, index), _mm_andnot_si128(isBetter, bestIndex));
+            index = _mm_add_epi32(index, indexStep);
+        }
+
+        alignas(16) float laneErrors[4];
+        alignas(16) qint32 laneIndices[4];
+        _mm_store_ps(laneErrors, bestError);
+        _mm_store_si128(reinterpret_cast<__m128i*>(laneIndices), bestIndex);
+        int bestLane = 0;
+        for(int lane=1; lane<4; ++lane) {
+            if(laneErrors[lane] < laneErrors[bestLane] ||
+              (laneErrors[lane] == laneErrors[bestLane] && laneIndices[lane] < laneIndices[bestLane])) {
+                bestLane = lane;
+            }
+        }
+        indices[i] = uchar(laneIndices[bestLane]);
+        totalError += laneErrors[bestLane];
+    }
+#else
+    for(int i=0; i<BlockTexels; ++i) {
+        float bestError = FLT_MAX;
+        int bestIndex = 0;
+        for(int j=0; j<palette.numEntries; ++j) {
+            float error = 0.0f;
+            for(int c=0; c<4; ++c) {
+                const float d = palette.channels[c][j] - block.texels[i][c];
+                error += d * d;
+            }
+            if(error < bestError) {
+                bestError = error;
+                bestIndex = j;
+            }
+        }
+        indices[i] = uchar(bestIndex);
+        totalError += bestError;
+    }
+#endif
+    return totalError;
+}
+
+// Initial endpoints spanning the extent of texels projected onto their principal axis.
+void computeEndpoints(const TexelBlock &block, int numChannels, float e0[4], float e1[4])
+{
+    float mean[4] = {};
+    for(int i=0; i<BlockTexels; ++i) {
+        for(int c=0; c<numChannels; ++c) {
+            mean[c] += block.texels[i][c];
+        }
+    }
+    for(int c=0; c<numChannels; ++c) {
+        mean[c] /= BlockTexels;
+    }
+
+    float covariance[4][4] = {};
+    for(int i=0; i<BlockTexels; ++i) {
+        float d[4];
+        for(int c=0; c<numChannels; ++c) {
+            d[c] = block.texels[i][c] - mean[c];
+        }
+        for(int c0=0; c0<numChannels; ++c0) {
+            for(int c1=0; c1<numChannels; ++c1) {
+                covariance[c0][c1] += d[c0] * d[c1];
+            }
+        }
+    }
+
+    // Start power iteration from the covariance row of the channel with the largest variance.
+    int maxVarianceChannel = 0;
+    for(int c=1; c<numChannels; ++c) {
+        if(covariance[c][c] > covariance[maxVarianceChannel][maxVarianceChannel]) {
+            maxVarianceChannel = c;
+        }
+    }
+    float axis[4] = {};
+    for(int c=0; c<numChannels; ++c) {
+        axis[c] = covariance[maxVarianceChannel][c];
+    }
+
+    float axisLength = 0.0f;
+    for(int iteration=0; iteration<Config::PowerIterations; ++iteration) {
+        float nextAxis[4] = {};
+        for(int c0=0; c0<numChannels; ++c0) {
+            for(int c1=0; c1<numChannels; ++c1) {
+                nextAxis[c0] += covariance[c0][c1] * axis[c1];
+            }
+        }
+        axisLength = 0.0f;
+        for(int c=0; c<numChannels; ++c) {
+            axisLength += nextAxis[c] * nextAxis[c];
+        }
+        axisLength = std::sqrt(axisLength);
+        if(axisLength < 1e-12f) {
+            break;
+        }
+        for(int c=0; c<numChannels; ++c) {
+            axis[c] = nextAxis[c] / axisLength;
+        }
+    }
+
+    for(int c=0; c<4; ++c) {
+        e0[c] = e1[c] = (c < numChannels) ? mean[c] : 0.0f;
+    }
+    if(axisLength < 1e-12f) {
+        return;
+    }
+
+    float minT = FLT_MAX;
+    float maxT = -FLT_MAX;
+    for(int i=0; i<BlockTexels; ++i) {
+        float t = 0.0f;
+        for(int c=0; c<numChannels; ++c) {
+            t += (block.texels[i][c] - mean[c]) * axis[c];
+        }
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    for(int c=0; c<numChannels; ++c) {
+        e0[c] = mean[c] + axis[c] * minT;
+        e1[c] = mean[c] + axis[c] * maxT;
+    }
+}
+
+// Least squares fit of endpoints to texels given their indices; indexWeights hold weights of the second endpoint.
+bool fitEndpoints(const TexelBlock &block, const uchar indices[BlockTexels], const float *indexWeights, float e0[4], float e1[4])
+{
+    float a00 = 0.0f, a01 = 0.0f, a11 = 0.0f;
+    float b0[4] = {}, b1[4] = {};
+    for(int i=0; i<BlockTexels; ++i) {
+        const float w1 = indexWeights[indices[i]];
+        const float w0 = 1.0f - w1;
+        a00 += w0 * w0;
+        a01 += w0 * w1;
+        a11 += w1 * w1;
+        for(int c=0; c<4; ++c) {
+            b0[c] += w0 * block.texels[i][c];
+            b1[c] += w1 * block.texels[i][c];
+        }
+    }
+
+    const float determinant = a00 * a11 - a01 * a01;
+    if(std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+    const float invDeterminant = 1.0f / determinant;
+    for(int c=0; c<4; ++c) {
+        e0[c] = (a11 * b0[c] - a01 * b1[c]) * invDeterminant;
+        e1[c] = (a00 * b1[c] - a01 * b0[c]) * invDeterminant;
+    }
+    return true;
+}
+
+void storeIndices(const uchar indices[BlockTexels], int bitsPerIndex, uchar *output)
+{
+    quint64 bits = 0;
+    for(int i=0; i<BlockTexels; ++i) {
+        bits |= quint64(indices[i]) << (i * bitsPerIndex);
+    }
+    const int numBytes = (BlockTexels * bitsPerIndex) / 8;
+    for(int i=0; i<numBytes; ++i) {
+        output[i] = uchar(bits >> (i * 8));
+    }
+}
+
+quint64 loadIndexBits(const uchar *input, int numBytes)
+{
+    quint64 bits = 0;
+    for(int i=0; i<numBytes; ++i) {
+        bits |= quint64(input[i]) << (i * 8);
+    }
+    return bits;
+}
+
+quint16 packColor565(const float color[4])
+{
+    const int r = clampInt(roundToInt(color[0] * (31.0f / 255.0f)), 0, 31);
+    const int g = clampInt(roundToInt(color[1] * (63.0f / 255.0f)), 0, 63);
+    const int b = clampInt(roundToInt(color[2] * (31.0f / 255.0f)), 0, 31);
+    return quint16((r << 11) | (g << 5) | b);
+}
+
+void unpackColor565(quint16 packed, int color[3])
+{
+    const int r = (packed >> 11) & 31;
+    const int g = (packed >> 5) & 63;
+    const int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void encodeBC1(const TexelBlock &source, uchar *output)
+{
+    static constexpr float IndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+    // BC1 alpha is not used (4 color mode is always selected), so exclude it from error metric.
+    TexelBlock block = source;
+    for(int i=0; i<BlockTexels; ++i) {
+        block.texels[i][3] = 0.0f;
+    }
+
+    float e0[4], e1[4];
+    computeEndpoints(block, 3, e0, e1);
+
+    quint16 bestColors[2] = {};
+    uchar bestIndices[BlockTexels] = {};
+    float bestError = FLT_MAX;
+    for(int iteration=0; iteration<=Config::RefinementIterations; ++iteration) {
+        quint16 color0 = packColor565(e0);
+        quint16 color1 = packColor565(e1);
+        // Decoders select 4 color mode only if the first color is greater.
+        if(color0 < color1) {
+            std::swap(color0, color1);
+        }
+
+        int c0[3], c1[3];
+        unpackColor565(color0, c0);
+        unpackColor565(color1, c1);
+
+        Palette palette;
+        palette.numEntries = 4;
+        for(int c=0; c<3; ++c) {
+            palette.channels[c][0] = float(c0[c]);
+            palette.channels[c][1] = float(c1[c]);
+            palette.channels[c][2] = float((2 * c0[c] + c1[c]) / 3);
+            palette.channels[c][3] = float((c0[c] + 2 * c1[c]) / 3);
+        }
+        for(int j=0; j<4; ++j) {
+            palette.channels[3][j] = 0.0f;
+        }
+
+        uchar indices[BlockTexels];
+        const float error = selectIndices(block, palette, indices);
+        if(error < bestError) {
+            bestError = error;
+            bestColors[0] = color0;
+            bestColors[1] = color1;
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+        if(bestError == 0.0f || !fitEndpoints(block, indices, IndexWeights, e0, e1)) {
+            break;
+        }
+    }
+
+    // Identical colors would select 3 color mode where index 3 decodes to black.
+    if(bestColors[0] == bestColors[1]) {
+        std::memset(bestIndices, 0, sizeof(bestIndices));
+    }
+
+    output[0] = uchar(bestColors[0]);
+    output[1] = uchar(bestColors[0] >> 8);
+    output[2] = uchar(bestColors[1]);
+    output[3] = uchar(bestColors[1] >> 8);
+    storeIndices(bestIndices, 2, output + 4);
+}
+
+void encodeBC4(const TexelBlock &block, int channel, uchar *output)
+{
+    float minValue = FLT_MAX;
+    float maxValue = -FLT_MAX;
+    for(int i=0; i<BlockTexels; ++i) {
+        minValue = std::min(minValue, block.texels[i][channel]);
+        maxValue = std::max(maxValue, block.texels[i][channel]);
+    }
+
+    const int r0 = clampInt(roundToInt(maxValue), 0, 255);
+    const int r1 = clampInt(roundToInt(minValue), 0, 255);
+    output[0] = uchar(r0);
+    output[1] = uchar(r1);
+
+    uchar indices[BlockTexels] = {};
+    if(r0 > r1) {
+        // Palette of 8 evenly spaced values: the nearest one is found by projection.
+        const float scale = 7.0f / float(r0 - r1);
+        for(int i=0; i<BlockTexels; ++i) {
+            const int step = clampInt(roundToInt((float(r0) - block.texels[i][channel]) * scale), 0, 7);
+            indices[i] = uchar((step == 0) ? 0 : ((step == 7) ? 1 : step + 1));
+        }
+    }
+    storeIndices(indices, 3, output + 2);
+}
+
+void quantizeBC7Endpoint(const float endpoint[4], int pbit, int quantized[4], float dequantized[4])
+{
+    for(int c=0; c<4; ++c) {
+        quantized[c] = clampInt(roundToInt((endpoint[c] - float(pbit)) * 0.5f), 0, 127);
+        dequantized[c] = float((quantized[c] << 1) | pbit);
+    }
+}
+
+void encodeBC7(const TexelBlock &block, uchar *output)
+{
+    static float IndexWeights[16];
+    static const bool initialized = []() {
+        for(int i=0; i<16; ++i) {
+            IndexWeights[i] = Weights4[i] / 64.0f;
+        }
+        return true;
+    }();
+    Q_UNUSED(initialized);
+
+    float e0[4], e1[4];
+    computeEndpoints(block, 4, e0, e1);
+
+    int bestEndpoints[2][4] = {};
+    int bestPBits[2] = {};
+    uchar bestIndices[BlockTexels] = {};
+    float bestError = FLT_MAX;
+    for(int iteration=0; iteration<=Config::RefinementIterations; ++iteration) {
+        for(int pbits=0; pbits<4; ++pbits) {
+            const int p0 = pbits & 1;
+            const int p1 = pbits >> 1;
+
+            int q0[4], q1[4];
+            float d0[4], d1[4];
+            quantizeBC7Endpoint(e0, p0, q0, d0);
+            quantizeBC7Endpoint(e1, p1, q1, d1);
+
+            Palette palette;
+            palette.numEntries = 16;
+            for(int j=0; j<16; ++j) {
+                const int w = Weights4[j];
+                for(int c=0; c<4; ++c) {
+                    palette.channels[c][j] = float(((64 - w) * int(d0[c]) + w * int(d1[c]) + 32) >> 6);
+                }
+            }
+
+            uchar indices[BlockTexels];
+            const float error = selectIndices(block, palette, indices);
+            if(error < bestError) {
+                bestError = error;
+                std::memcpy(bestEndpoints[0], q0, sizeof(q0));
+                std::memcpy(bestEndpoints[1], q1, sizeof(q1));
+                bestPBits[0] = p0;
+                bestPBits[1] = p1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+        }
+        if(bestError == 0.0f || !fitEndpoints(block, bestIndices, IndexWeights, e0, e1)) {
+            break;
+        }
+    }
+
+    // Most significant bit of the anchor index is implicitly zero.
+    if(bestIndices[0] >= 8) {
+        std::swap(bestEndpoints[0], bestEndpoints[1]);
+        std::swap(bestPBits[0], bestPBits[1]);
+        for(int i=0; i<BlockTexels; ++i) {
+            bestIndices[i] = uchar(15 - bestIndices[i]);
+        }
+    }
+
+    BitWriter writer;
+    writer.write(1u << 6, 7);
+    for(int c=0; c<4; ++c) {
+        writer.write(quint32(bestEndpoints[0][c]), 7);
+        writer.write(quint32(bestEndpoints[1][c]), 7);
+    }
+    writer.write(quint32(bestPBits[0]), 1);
+    writer.write(quint32(bestPBits[1]), 1);
+    for(int i=0; i<BlockTexels; ++i) {
+        writer.write(bestIndices[i], (i == 0) ? 3 : 4);
+    }
+    writer.store(output);
+}
+
+inline int unquantizeBC6H(int value)
+{
+    if(value == 0) {
+        return 0;
+    }
+    if(value == 1023) {
+        return 0xFFFF;
+    }
+    return ((value << 16) + 0x8000) >> 10;
+}
+
+inline int finishUnquantizeBC6H(int value)
+{
+    return (value * 31) >> 6;
+}
+
+int quantizeBC6H(float halfBits)
+{
+    // Find endpoint value which finishes unquantization closest to given half float bit pattern.
+    const float target = halfBits * (64.0f / 31.0f);
+    const int estimate = clampInt(roundToInt((target - 32.0f) / 64.0f), 0, 1023);
+    int bestValue = estimate;
+    float bestError = FLT_MAX;
+    for(int value=std::max(estimate - 1, 0); value<=std::min(estimate + 1, 1023); ++value) {
+        const float error = std::abs(float(unquantizeBC6H(value)) - target);
+        if(error < bestError) {
+            bestError = error;
+            bestValue = value;
+        }
+    }
+    return bestValue;
+}
+
+void encodeBC6H(const TexelBlock &source, uchar *output)
+{
+    static float IndexWeights[16];
+    static const bool initialized = []() {
+        for(int i=0; i<16; ++i) {
+            IndexWeights[i] = Weights4[i] / 64.0f;
+        }
+        return true;
+    }();
+    Q_UNUSED(initialized);
+
+    // Fit endpoints to half float bit patterns which are roughly logarithmic, same as BC6H interpolation.
+    TexelBlock block;
+    for(int i=0; i<BlockTexels; ++i) {
+        for(int c=0; c<3; ++c) {
+            const float value = source.texels[i][c];
+            const float clampedValue = (value > 0.0f) ? std::min(value, Config::MaxHalf) : 0.0f;
+            block.texels[i][c] = float(floatToHalfBits(clampedValue));
+        }
+        block.texels[i][3] = 0.0f;
+    }
+
+    float e0[4], e1[4];
+    computeEndpoints(block, 3, e0, e1);
+
+    int bestEndpoints[2][3] = {};
+    uchar bestIndices[BlockTexels] = {};
+    float bestError = FLT_MAX;
+    for(int iteration=0; iteration<=Config::RefinementIterations; ++iteration) {
+        int q0[3], q1[3];
+        for(int c=0; c<3; ++c) {
+            q0[c] = quantizeBC6H(std::max(e0[c], 0.0f));
+            q1[c] = quantizeBC6H(std::max(e1[c], 0.0f));
+        }
+
+        Palette palette;
+        palette.numEntries = 16;
+        for(int j=0; j<16; ++j) {
+            const int w = Weights4[j];
+            for(int c=0; c<3; ++c) {
+                const int value = ((64 - w) * unquantizeBC6H(q0[c]) + w * unquantizeBC6H(q1[c]) + 32) >> 6;
+                palette.channels[c][j] = float(finishUnquantizeBC6H(value));
+            }
+            palette.channels[3][j] = 0.0f;
+        }
+
+        uchar indices[BlockTexels];
+        const float error = selectIndices(block, palette, indices);
+        if(error < bestError) {
+            bestError = error;
+            std::memcpy(bestEndpoints[0], q0, sizeof(q0));
+            std::memcpy(bestEndpoints[1], q1, sizeof(q1));
+            std::memcpy(bestIndices, indices, sizeof(indices));
+        }
+        if(bestError == 0.0f || !fitEndpoints(block, indices, IndexWeights, e0, e1)) {
+            break;
+        }
+    }
+
+    // Most significant bit of the anchor index is implicitly zero.
+    if(bestIndices[0] >= 8) {
+        std::swap(bestEndpoints[0], bestEndpoints[1]);
+        for(int i=0; i<BlockTexels; ++i) {
+            bestIndices[i] = uchar(15 - bestIndices[i]);
+        }
+    }
+
+    // Mode 11: single region, 10-bit endpoints without delta encoding.
+    BitWriter writer;
+    writer.write(0x03, 5);
+    for(int e=0; e<2; ++e) {
+        for(int c=0; c<3; ++c) {
+            writer.write(quint32(bestEndpoints[e][c]), 10);
+        }
+    }
+    for(int i=0; i<BlockTexels; ++i) {
+        writer.write(bestIndices[i], (i == 0) ? 3 : 4);
+    }
+    writer.store(output);
+}
+
+// Color blocks of BC2 and BC3 are always decoded in four color mode.
+void decodeBC1(const uchar *input, uchar *texels, size_t texelPitch, bool fourColorMode=false)
+{
+    const quint16 color0 = quint16(input[0] | (input[1] << 8));
+    const quint16 color1 = quint16(input[2] | (input[3] << 8));
+    const bool hasFourColors = fourColorMode || color0 > color1;
+
+    int palette[4][4];
+    unpackColor565(color0, palette[0]);
+    unpackColor565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    for(int c=0; c<3; ++c) {
+        if(hasFourColors) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[3][3] = hasFourColors ? 255 : 0;
+
+    const quint64 indices = loadIndexBits(input + 4, 4);
+    for(int i=0; i<BlockTexels; ++i) {
+        const int *value = palette[(indices >> (2 * i)) & 3];
+        uchar *texel = texels + size_t(i) * texelPitch;
+        for(int c=0; c<4; ++c) {
+            texel[c] = uchar(value[c]);
+        }
+    }
+}
+
+void decodeBC4(const uchar *input, uchar *texels, size_t texelPitch)
+{
+    const int r0 = input[0];
+    const int r1 = input[1];
+
+    int palette[8] = { r0, r1 };
+    if(r0 > r1) {
+        for(int i=2; i<8; ++i) {
+            palette[i] = ((8 - i) * r0 + (i - 1) * r1) / 7;
+        }
+    }
+    else {
+        for(int i=2; i<6; ++i) {
+            palette[i] = ((6 - i) * r0 + (i - 1) * r1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    const quint64 indices = loadIndexBits(input + 2, 6);
+    for(int i=0; i<BlockTexels; ++i) {
+        texels[size_t(i) * texelPitch] = uchar(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+void decodeBC2Alpha(const uchar *input, uchar *texels, size_t texelPitch)
+{
+    const quint64 alpha = loadIndexBits(input, 8);
+    for(int i=0; i<BlockTexels; ++i) {
+        texels[size_t(i) * texelPitch] = uchar(((alpha >> (4 * i)) & 0xF) * 17);
+    }
+}
+
+bool decodeBC7(const uchar *input, uchar *texels, size_t texelPitch)
+{
+    if((input[0] & 0x7F) != 0x40) {
+        return false;
+    }
+
+    BitReader reader(input);
+    reader.read(7);
+    int endpoints[2][4];
+    for(int c=0; c<4; ++c) {
+        endpoints[0][c] = int(reader.read(7));
+        endpoints[1][c] = int(reader.read(7));
+    }
+    const int p0 = int(reader.read(1));
+    const int p1 = int(reader.read(1));
+    for(int c=0; c<4; ++c) {
+        endpoints[0][c] = (endpoints[0][c] << 1) | p0;
+        endpoints[1][c] = (endpoints[1][c] << 1) | p1;
+    }
+
+    for(int i=0; i<BlockTexels; ++i) {
+        const int w = Weights4[reader.read((i == 0) ? 3 : 4)];
+        uchar *texel = texels + size_t(i) * texelPitch;
+        for(int c=0; c<4; ++c) {
+            texel[c] = uchar(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6);
+        }
+    }
+    return true;
+}
+
+bool decodeBC6H(const uchar *input, uchar *texels, size_t texelPitch)
+{
+    BitReader reader(input);
+    if(reader.read(5) != 0x03) {
+        return false;
+    }
+
+    int endpoints[2][3];
+    for(int e=0; e<2; ++e) {
+        for(int c=0; c<3; ++c) {
+            endpoints[e][c] = unquantizeBC6H(int(reader.read(10)));
+        }
+    }
+
+    for(int i=0; i<BlockTexels; ++i) {
+        const int w = Weights4[reader.read((i == 0) ? 3 : 4)];
+        uchar *texel = texels + size_t(i) * texelPitch;
+        for(int c=0; c<3; ++c) {
+            const quint16 value = quint16(finishUnquantizeBC6H(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6));
+            std::memcpy(texel + c * sizeof(quint16), &value, sizeof(value));
+        }
+    }
+    return true;
+}
+
+// Decoded image layout for each block format.
+void getDecodedFormat(BlockFormat blockFormat, QImageData::ValueType &type, int &channels)
+{
+    switch(blockFormat) {
+    case BlockFormat::BC1:
+    case BlockFormat::BC2:
+    case BlockFormat::BC3:
+    case BlockFormat::BC7:
+        type = QImageData::ValueType::UInt8;
+        channels = 4;
+        break;
+    case BlockFormat::BC4:
+        type = QImageData::ValueType::UInt8;
+        channels = 1;
+        break;
+    case BlockFormat::BC5:
+        type = QImageData::ValueType::UInt8;
+        channels = 2;
+        break;
+    case BlockFormat::BC6H:
+        type = QImageData::ValueType::Float16;
+        channels = 3;
+        break;
+    default:
+        type = QImageData::ValueType::Undefined;
+        channels = 0;
+        break;
+    }
+}
+
+bool isCompatibleSource(const QImageData &image, BlockFormat blockFormat)
+{
+    switch(blockFormat) {
+    case BlockFormat::BC1:
+    case BlockFormat::BC7:
+        return image.type == QImageData::ValueType::UInt8 && image.channels >= 3;
+    case BlockFormat::BC4:
+        return image.type == QImageData::ValueType::UInt8 && image.channels >= 1;
+    case BlockFormat::BC5:
+        return image.type == QImageData::ValueType::UInt8 && image.channels >= 2;
+    case BlockFormat::BC6H:
+        return (image.type == QImageData::ValueType::Float16 || image.type == QImageData::ValueType::Float32) && image.channels >= 3;
+    default:
+        return false;
+    }
+}
+
+QDataStoragePtr allocateStorage(quint64 size, uchar *&pixels)
+{
+    pixels = new (std::nothrow) uchar[size];
+    if(!pixels) {
+        return QDataStoragePtr();
+    }
+    uchar *allocatedPixels = pixels;
+    return QDataStorage::fromRawData(pixels, size, [allocatedPixels]() {
+        delete[] allocatedPixels;
+    });
+}
+
+} // anonymous
+
+void setBlockFormat(QImageData &image, QImageData::BlockFormat blockFormat)
+{
+    image.blockFormat = blockFormat;
+    getDecodedFormat(blockFormat, image.type, image.channels);
+    if(image.channels >= 3) {
+        image.format = (image.channels == 4) ? QImageData::Format::RGBA : QImageData::Format::RGB;
+    }
+}
+
+bool compressImage(QImageData &image, QImageData::BlockFormat blockFormat)
+{
+    using Utility::parallelFor;
+
+    if(image.isCompressed()) {
+        qCWarning(logImport) << "Cannot compress image: image is already block compressed";
+        return false;
+    }
+    if(image.width <= 0 || image.height <= 0 || image.mipLevels <= 0 || blockFormat == BlockFormat::None) {
+        qCWarning(logImport) << "Cannot compress image: invalid image dimensions or block format";
+        return false;
+    }
+    if(!isCompatibleSource(image, blockFormat)) {
+        qCWarning(logImport) << "Cannot compress image: block format is incompatible with image pixel format";
+        return false;
+    }
+    if(image.sizeInBytes() < image.expectedSizeInBytes()) {
+        qCWarning(logImport) << "Cannot compress image: incomplete image data";
+        return false;
+    }
+
+    QImageData result = image;
+    setBlockFormat(result, blockFormat);
+
+    uchar *pixels = nullptr;
+    result.data.clear();
+    result.storage = allocateStorage(result.expectedSizeInBytes(), pixels);
+    if(!result.storage) {
+        qCWarning(logImport) << "Cannot compress image: failed to allocate memory for compressed image";
+        return false;
+    }
+
+    const int blockSize = QImageData::blockSize(blockFormat);
+    const bool swapRB = (image.format == QImageData::Format::BGR || image.format == QImageData::Format::BGRA);
+    for(int level=0; level<image.mipLevels; ++level) {
+        const SourceLevel source = {
+            image.constMipBits(level),
+            image.mipWidth(level),
+            image.mipHeight(level),
+            image.channels,
+            image.type,
+            swapRB && image.channels >= 3,
+        };
+        const int numBlocksX = (source.width + 3) / 4;
+        const int numBlocksY = (source.height + 3) / 4;
+        uchar *blocks = pixels + result.mipLevelOffset(level);
+
+        parallelFor(0, numBlocksX * numBlocksY, Config::GrainSize, [&](int begin, int end) {
+            TexelBlock block;
+            for(int i=begin; i<end; ++i) {
+                fetchBlock(source, i % numBlocksX, i / numBlocksX, block);
+                uchar *output = blocks + size_t(i) * size_t(blockSize);
+                switch(blockFormat) {
+                case BlockFormat::BC1:
+                    encodeBC1(block, output);
+                    break;
+                case BlockFormat::BC4:
+                    encodeBC4(block, 0, output);
+                    break;
+                case BlockFormat::BC5:
+                    encodeBC4(block, 0, output);
+                    encodeBC4(block, 1, output + 8);
+                    break;
+                case BlockFormat::BC6H:
+                    encodeBC6H(block, output);
+                    break;
+                case BlockFormat::BC7:
+                    encodeBC7(block, output);
+                    break;
+                default:
+                    Q_UNREACHABLE();
+                }
+            }
+        });
+    }
+
+    image = result;
+    return true;
+}
+
+bool decompressImage(const QImageData &image, QImageData &result)
+{
+    using Utility::parallelFor;
+
+    if(!image.isCompressed()) {
+        qCWarning(logImport) << "Cannot decompress image: image is not block compressed";
+        return false;
+    }
+    if(image.width <= 0 || image.height <= 0 || image.mipLevels <= 0 || QImageData::blockSize(image.blockFormat) == 0) {
+        qCWarning(logImport) << "Cannot decompress image: invalid image dimensions or block format";
+        return false;
+    }
+    if(image.sizeInBytes() < image.expectedSizeInBytes()) {
+        qCWarning(logImport) << "Cannot decompress image: incomplete image data";
+        return false;
+    }
+
+    QImageData output = image;
+    output.blockFormat = BlockFormat::None;
+    getDecodedFormat(image.blockFormat, output.type, output.channels);
+    if(output.channels >= 3) {
+        output.format = (output.channels == 4) ? QImageData::Format::RGBA : QImageData::Format::RGB;
+    }
+
+    uchar *pixels = nullptr;
+    output.data.clear();
+    output.storage = allocateStorage(output.expectedSizeInBytes(), pixels);
+    if(!output.storage) {
+        qCWarning(logImport) << "Cannot decompress image: failed to allocate memory for decompressed image";
+        return false;
+    }
+
+    const int blockSize = QImageData::blockSize(image.blockFormat);
+    const size_t texelSize = size_t(output.channels) * size_t(output.type);
+    QAtomicInt unsupportedBlocks(0);
+    for(int level=0; level<image.mipLevels; ++level) {
+        const int width = image.mipWidth(level);
+        const int height = image.mipHeight(level);
+        const int numBlocksX = (width + 3) / 4;
+        const int numBlocksY = (height + 3) / 4;
+        const uchar *blocks = image.constMipBits(level);
+        uchar *levelPixels = pixels + output.mipLevelOffset(level);
+
+        parallelFor(0, numBlocksX * numBlocksY, Config::GrainSize, [&](int begin, int end) {
+            uchar decodedTexels[BlockTexels * 4 * sizeof(quint16)];
+            for(int i=begin; i<end; ++i) {
+                const uchar *input = blocks + size_t(i) * size_t(blockSize);
+                bool decoded = true;
+                switch(image.blockFormat) {
+                case BlockFormat::BC1:
+                    decodeBC1(input, decodedTexels, texelSize);
+                    break;
+                case BlockFormat::BC2:
+                    decodeBC1(input + 8, decodedTexels, texelSize, true);
+                    decodeBC2Alpha(input, decodedTexels + 3, texelSize);
+                    break;
+                case BlockFormat::BC3:
+                    decodeBC1(input + 8, decodedTexels, texelSize, true);
+                    decodeBC4(input, decodedTexels + 3, texelSize);
+                    break;
+                case BlockFormat::BC4:
+                    decodeBC4(input, decodedTexels, texelSize);
+                    break;
+                case BlockFormat::BC5:
+                    decodeBC4(input, decodedTexels, texelSize);
+                    decodeBC4(input + 8, decodedTexels + 1, texelSize);
+                    break;
+                case BlockFormat::BC6H:
+                    decoded = decodeBC6H(input, decodedTexels, texelSize);
+                    break;
+                case BlockFormat::BC7:
+                    decoded = decodeBC7(input, decodedTexels, texelSize);
+                    break;
+                default:
+                    Q_UNREACHABLE();
+                }
+                if(!decoded) {
+                    unsupportedBlocks.ref();
+                    std::memset(decodedTexels, 0, sizeof(decodedTexels));
+                }
+
+                // Copy decoded texels, clipping blocks which extend past image edges.
+                const int blockX = (i % numBlocksX) * 4;
+                const int blockY = (i / numBlocksX) * 4;
+                const int blockWidth = std::min(4, width - blockX);
+                const int blockHeight = std::min(4, height - blockY);
+                for(int y=0; y<blockHeight; ++y) {
+                    uchar *row = levelPixels + (size_t(blockY + y) * size_t(width) + size_t(blockX)) * texelSize;
+                    std::memcpy(row, decodedTexels + size_t(y * 4) * texelSize, size_t(blockWidth) * texelSize);
+                }
+            }
+        });
+    }
+
+    if(unsupportedBlocks.load() > 0) {
+        qCWarning(logImport) << "Cannot decompress image:" << unsupportedBlocks.load() << "blocks use unsupported block modes";
+        return false;
+    }
+
+    result = output;
+    return true;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qimagedata.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Sets block format of an image together with type, number of channels and format describing its decoded texels.
+void setBlockFormat(QImageData &image, QImageData::BlockFormat blockFormat);
+
+// Compresses all mip levels of an image into given block format.
+// BC1 and BC7 take 8-bit RGB or RGBA images (BC1 ignores alpha), BC4 and BC5 take first one or two channels
+// of 8-bit images, and BC6H takes RGB channels of 16-bit or 32-bit floating point images.
+// Incomplete blocks at image edges are padded by repeating edge texels.
+bool compressImage(QImageData &image, QImageData::BlockFormat blockFormat);
+
+// Decompresses all mip levels of a block compressed image.
+// Results in 8-bit RGBA (BC1, BC2, BC3, BC7), R (BC4), RG (BC5) or 16-bit floating point RGB (BC6H) image.
+// BC2 and BC3 can only be decompressed. Only block modes produced by compressImage() are supported
+// for BC6H (mode 11) and BC7 (mode 6).
+bool decompressImage(const QImageData &image, QImageData &result);
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <QUrl>
+#include <QVector3D>
 
 namespace Qt3DRaytrace {
 namespace Raytrace {
@@ -24,5 +25,20 @@ static inline QString getAssetPathFromUrl(const QUrl &url)
     }
 }
 
+static inline QVector3D computeFallbackTangent(const QVector3D &normal)
+{
+    // Used when no UV coords are present so tangents cannot be derived from texture space.
+    // Lousy tangents are better than no tangents. ;-)
+    static constexpr QVector3D TangentGenUp{0.0f, 1.0f, 0.0f};
+    static constexpr QVector3D TangentGenRight{1.0f, 0.0f, 0.0f};
+    static constexpr float     TangentGenLengthThreshold = 0.001f;
+
+    QVector3D tangent = QVector3D::crossProduct(TangentGenUp, normal);
+    if(tangent.lengthSquared() < TangentGenLengthThreshold) {
+        tangent = QVector3D::crossProduct(TangentGenRight, normal);
+    }
+    return tangent.normalized();
+}
+
 } // Raytrace
 } // Qt3DRaytrace
@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/ddsimporter_p.h>
+#include <io/blockcompression_p.h>
+#include <io/imageprocessing_p.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <cstring>
+#include <new>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace {
+
+using ValueType = QImageData::ValueType;
+using Format = QImageData::Format;
+using BlockFormat = QImageData::BlockFormat;
+
+constexpr quint32 makeFourCC(char a, char b, char c, char d)
+{
+    return quint32(uchar(a)) | (quint32(uchar(b)) << 8) | (quint32(uchar(c)) << 16) | (quint32(uchar(d)) << 24);
+}
+
+constexpr quint32 Magic = makeFourCC('D', 'D', 'S', ' ');
+constexpr quint32 FourCC_DX10 = makeFourCC('D', 'X', '1', '0');
+
+constexpr int MagicSize = 4;
+constexpr int HeaderSize = 124;
+constexpr int HeaderDX10Size = 20;
+
+// Offsets of DDS_HEADER fields.
+enum HeaderField {
+    HeaderField_Size = 0,
+    HeaderField_Flags = 4,
+    HeaderField_Height = 8,
+    HeaderField_Width = 12,
+    HeaderField_Depth = 20,
+    HeaderField_MipMapCount = 24,
+    HeaderField_PixelFormat = 72,
+    HeaderField_Caps2 = 108,
+};
+
+// Offsets of DDS_PIXELFORMAT fields.
+enum PixelFormatField {
+    PixelFormatField_Flags = 4,
+    PixelFormatField_FourCC = 8,
+    PixelFormatField_RGBBitCount = 12,
+    PixelFormatField_RBitMask = 16,
+    PixelFormatField_GBitMask = 20,
+    PixelFormatField_BBitMask = 24,
+    PixelFormatField_ABitMask = 28,
+};
+
+// Offsets of DDS_HEADER_DXT10 fields.
+enum HeaderDX10Field {
+    HeaderDX10Field_DxgiFormat = 0,
+    HeaderDX10Field_ResourceDimension = 4,
+    HeaderDX10Field_MiscFlag = 8,
+    HeaderDX10Field_ArraySize = 12,
+};
+
+constexpr quint32 DDSD_MIPMAPCOUNT = 0x20000;
+constexpr quint32 DDPF_ALPHAPIXELS = 0x1;
+constexpr quint32 DDPF_FOURCC = 0x4;
+constexpr quint32 DDPF_RGB = 0x40;
+constexpr quint32 DDPF_LUMINANCE = 0x20000;
+constexpr quint32 DDSCAPS2_CUBEMAP = 0x200;
+constexpr quint32 DDSCAPS2_VOLUME = 0x200000;
+constexpr quint32 D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+constexpr quint32 D3D10_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+// Legacy D3DFORMAT codes of floating point formats stored in FourCC field.
+constexpr quint32 D3DFMT_R16F = 111;
+constexpr quint32 D3DFMT_G16R16F = 112;
+constexpr quint32 D3DFMT_A16B16G16R16F = 113;
+constexpr quint32 D3DFMT_R32F = 114;
+constexpr quint32 D3DFMT_G32R32F = 115;
+constexpr quint32 D3DFMT_A32B32G32R32F = 116;
+
+struct PixelFormat
+{
+    quint32 code;
+    ValueType type;
+    int channels;
+    Format format;
+    BlockFormat blockFormat;
+};
+
+// Both UNORM and SRGB variants of 8-bit color formats map to the same image format since renderers assume sRGB colorspace anyway.
+constexpr PixelFormat DxgiFormats[] = {
+    {  2, ValueType::Float32, 4, Format::RGBA,      BlockFormat::None }, // R32G32B32A32_FLOAT
+    {  6, ValueType::Float32, 3, Format::RGB,       BlockFormat::None }, // R32G32B32_FLOAT
+    { 10, ValueType::Float16, 4, Format::RGBA,      BlockFormat::None }, // R16G16B16A16_FLOAT
+    { 16, ValueType::Float32, 2, Format::Undefined, BlockFormat::None }, // R32G32_FLOAT
+    { 28, ValueType::UInt8,   4, Format::RGBA,      BlockFormat::None }, // R8G8B8A8_UNORM
+    { 29, ValueType::UInt8,   4, Format::RGBA,      BlockFormat::None }, // R8G8B8A8_UNORM_SRGB
+    { 34, ValueType::Float16, 2, Format::Undefined, BlockFormat::None }, // R16G16_FLOAT
+    { 41, ValueType::Float32, 1, Format::Undefined, BlockFormat::None }, // R32_FLOAT
+    { 49, ValueType::UInt8,   2, Format::Undefined, BlockFormat::None }, // R8G8_UNORM
+    { 54, ValueType::Float16, 1, Format::Undefined, BlockFormat::None }, // R16_FLOAT
+    { 61, ValueType::UInt8,   1, Format::Undefined, BlockFormat::None }, // R8_UNORM
+    { 71, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC1 }, // BC1_UNORM
+    { 72, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC1 }, // BC1_UNORM_SRGB
+    { 74, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC2 }, // BC2_UNORM
+    { 75, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC2 }, // BC2_UNORM_SRGB
+    { 77, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC3 }, // BC3_UNORM
+    { 78, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC3 }, // BC3_UNORM_SRGB
+    { 80, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC4 }, // BC4_UNORM
+    { 83, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC5 }, // BC5_UNORM
+    { 87, ValueType::UInt8,   4, Format::BGRA,      BlockFormat::None }, // B8G8R8A8_UNORM
+    { 91, ValueType::UInt8,   4, Format::BGRA,      BlockFormat::None }, // B8G8R8A8_UNORM_SRGB
+    { 95, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC6H }, // BC6H_UF16
+    { 98, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC7 }, // BC7_UNORM
+    { 99, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC7 }, // BC7_UNORM_SRGB
+};
+
+constexpr PixelFormat FourCCFormats[] = {
+    { makeFourCC('D', 'X', 'T', '1'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC1 },
+    { makeFourCC('D', 'X', 'T', '2'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC2 },
+    { makeFourCC('D', 'X', 'T', '3'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC2 },
+    { makeFourCC('D', 'X', 'T', '4'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC3 },
+    { makeFourCC('D', 'X', 'T', '5'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC3 },
+    { makeFourCC('A', 'T', 'I', '1'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC4 },
+    { makeFourCC('B', 'C', '4', 'U'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC4 },
+    { makeFourCC('A', 'T', 'I', '2'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC5 },
+    { makeFourCC('B', 'C', '5', 'U'), ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC5 },
+    { D3DFMT_R16F,          ValueType::Float16, 1, Format::Undefined, BlockFormat::None },
+    { D3DFMT_G16R16F,       ValueType::Float16, 2, Format::Undefined, BlockFormat::None },
+    { D3DFMT_A16B16G16R16F, ValueType::Float16, 4, Format::RGBA,      BlockFormat::None },
+    { D3DFMT_R32F,          ValueType::Float32, 1, Format::Undefined, BlockFormat::None },
+    { D3DFMT_G32R32F,       ValueType::Float32, 2, Format::Undefined, BlockFormat::None },
+    { D3DFMT_A32B32G32R32F, ValueType::Float32, 4, Format::RGBA,      BlockFormat::None },
+};
+
+inline quint32 readUInt32(const uchar *data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(quint32));
+    return qFromLittleEndian(value);
+}
+
+template<size_t N>
+bool findPixelFormat(const PixelFormat (&formats)[N], quint32 code, QImageData &image)
+{
+    for(const PixelFormat &pixelFormat : formats) {
+        if(pixelFormat.code == code) {
+            if(pixelFormat.blockFormat != BlockFormat::None) {
+                setBlockFormat(image, pixelFormat.blockFormat);
+            }
+            else {
+                image.type = pixelFormat.type;
+                image.channels = pixelFormat.channels;
+                image.format = pixelFormat.format;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool getLegacyPixelFormat(const uchar *pixelFormat, QImageData &image)
+{
+    const quint32 flags = readUInt32(pixelFormat + PixelFormatField_Flags);
+    if(flags & DDPF_FOURCC) {
+        return findPixelFormat(FourCCFormats, readUInt32(pixelFormat + PixelFormatField_FourCC), image);
+    }
+
+    const quint32 bitCount = readUInt32(pixelFormat + PixelFormatField_RGBBitCount);
+    const quint32 maskR = readUInt32(pixelFormat + PixelFormatField_RBitMask);
+    const quint32 maskG = readUInt32(pixelFormat + PixelFormatField_GBitMask);
+    const quint32 maskB = readUInt32(pixelFormat + PixelFormatField_BBitMask);
+    const quint32 maskA = readUInt32(pixelFormat + PixelFormatField_ABitMask);
+
+    image.type = ValueType::UInt8;
+    if((flags & DDPF_RGB) && (flags & DDPF_ALPHAPIXELS) && bitCount == 32 && maskG == 0x0000FF00 && maskA == 0xFF000000) {
+        image.channels = 4;
+        if(maskR == 0x000000FF && maskB == 0x00FF0000) {
+            image.format = Format::RGBA;
+            return true;
+        }
+        if(maskR == 0x00FF0000 && maskB == 0x000000FF) {
+            image.format = Format::BGRA;
+            return true;
+        }
+    }
+    else if((flags & DDPF_RGB) && !(flags & DDPF_ALPHAPIXELS) && bitCount == 24 && maskG == 0x00FF00) {
+        image.channels = 3;
+        if(maskR == 0x0000FF && maskB == 0xFF0000) {
+            image.format = Format::RGB;
+            return true;
+        }
+        if(maskR == 0xFF0000 && maskB == 0x0000FF) {
+            image.format = Format::BGR;
+            return true;
+        }
+    }
+    else if((flags & (DDPF_RGB | DDPF_LUMINANCE)) && !(flags & DDPF_ALPHAPIXELS) && bitCount == 8 && maskR == 0xFF) {
+        image.channels = 1;
+        return true;
+    }
+    return false;
+}
+
+bool readHeader(QFile &file, QImageData &image, quint64 &dataOffset)
+{
+    uchar header[MagicSize + HeaderSize + HeaderDX10Size];
+    const qint64 headerSize = file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if(headerSize < MagicSize + HeaderSize || readUInt32(header) != Magic || readUInt32(header + MagicSize + HeaderField_Size) != HeaderSize) {
+        qCCritical(logImport) << "Invalid DDS file header";
+        return false;
+    }
+
+    const uchar *ddsHeader = header + MagicSize;
+    const uchar *pixelFormat = ddsHeader + HeaderField_PixelFormat;
+    const quint32 flags = readUInt32(ddsHeader + HeaderField_Flags);
+    const quint32 width = readUInt32(ddsHeader + HeaderField_Width);
+    const quint32 height = readUInt32(ddsHeader + HeaderField_Height);
+    const quint32 mipMapCount = (flags & DDSD_MIPMAPCOUNT) ? readUInt32(ddsHeader + HeaderField_MipMapCount) : 1;
+    const quint32 caps2 = readUInt32(ddsHeader + HeaderField_Caps2);
+
+    if(width == 0 || width > 65536 || height == 0 || height > 65536) {
+        qCCritical(logImport) << "Invalid DDS image dimensions:" << width << "x" << height;
+        return false;
+    }
+    if((caps2 & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME)) || readUInt32(ddsHeader + HeaderField_Depth) > 1) {
+        qCCritical(logImport) << "Unsupported DDS texture type: only 2D textures are supported";
+        return false;
+    }
+
+    image.width = int(width);
+    image.height = int(height);
+    image.mipLevels = int(qMax(mipMapCount, 1u));
+    if(image.mipLevels > QImageData::maxMipLevels(image.width, image.height)) {
+        qCCritical(logImport) << "Invalid number of DDS mip levels:" << mipMapCount;
+        return false;
+    }
+
+    const bool hasDX10Header = (readUInt32(pixelFormat + PixelFormatField_Flags) & DDPF_FOURCC) && readUInt32(pixelFormat + PixelFormatField_FourCC) == FourCC_DX10;
+    if(hasDX10Header) {
+        if(headerSize < qint64(sizeof(header))) {
+            qCCritical(logImport) << "Invalid DDS file header";
+            return false;
+        }
+        const uchar *dx10Header = ddsHeader + HeaderSize;
+        if(readUInt32(dx10Header + HeaderDX10Field_ResourceDimension) != D3D10_RESOURCE_DIMENSION_TEXTURE2D ||
+           readUInt32(dx10Header + HeaderDX10Field_ArraySize) != 1 ||
+           (readUInt32(dx10Header + HeaderDX10Field_MiscFlag) & D3D10_RESOURCE_MISC_TEXTURECUBE)) {
+            qCCritical(logImport) << "Unsupported DDS texture type: only 2D textures are supported";
+            return false;
+        }
+        const quint32 dxgiFormat = readUInt32(dx10Header + HeaderDX10Field_DxgiFormat);
+        if(!findPixelFormat(DxgiFormats, dxgiFormat, image)) {
+            qCCritical(logImport) << "Unsupported DDS pixel format: DXGI format" << dxgiFormat;
+            return false;
+        }
+        dataOffset = MagicSize + HeaderSize + HeaderDX10Size;
+    }
+    else {
+        if(!getLegacyPixelFormat(pixelFormat, image)) {
+            qCCritical(logImport) << "Unsupported DDS pixel format";
+            return false;
+        }
+        dataOffset = MagicSize + HeaderSize;
+    }
+    return true;
+}
+
+} // anonymous
+
+bool DdsImageImporter::isSupported(const QUrl &url)
+{
+    return QFileInfo(url.path()).suffix().compare(QStringLiteral("dds"), Qt::CaseInsensitive) == 0;
+}
+
+bool DdsImageImporter::import(const QUrl &url, QImageData &data)
+{
+    const QString path = getAssetPathFromUrl(url);
+    QFile imageFile(path);
+    if(!imageFile.open(QFile::ReadOnly)) {
+        qCCritical(logImport) << "Cannot open image file:" << url.toString();
+        return false;
+    }
+
+    qCInfo(logImport) << "Loading texture image:" << url.toString();
+
+    QImageData image;
+    quint64 dataOffset = 0;
+    if(!readHeader(imageFile, image, dataOffset)) {
+        qCCritical(logImport) << "Failed to import DDS file:" << url.toString();
+        return false;
+    }
+
+    const quint64 dataSize = image.expectedSizeInBytes();
+    if(dataOffset + dataSize > quint64(imageFile.size())) {
+        qCCritical(logImport) << "Failed to import DDS file: file is truncated:" << url.toString();
+        return false;
+    }
+
+    // DDS images are stored with top-left origin while renderers expect bottom-left origin, same as produced by other importers.
+    // Flipping is done while copying pixel data out of mapped file; images that cannot be flipped are mapped as is instead.
+    if(!canFlipImageVertically(image)) {
+        qCWarning(logImport) << "Image in this block format cannot be flipped without decoding, texture will appear upside down:" << url.toString();
+        image.storage = QDataStorage::fromFile(path, dataOffset, dataSize);
+        if(image.storage) {
+            data = image;
+            return true;
+        }
+    }
+
+    QByteArray dataBytes;
+    uchar *mappedData = imageFile.map(qint64(dataOffset), qint64(dataSize));
+    const uchar *pixelData = mappedData;
+    if(!pixelData) {
+        imageFile.seek(qint64(dataOffset));
+        dataBytes = imageFile.read(qint64(dataSize));
+        if(quint64(dataBytes.size()) != dataSize) {
+            qCCritical(logImport) << "Failed to read DDS file:" << url.toString();
+            return false;
+        }
+        pixelData = reinterpret_cast<const uchar*>(dataBytes.constData());
+    }
+
+    if(canFlipImageVertically(image)) {
+        uchar *pixels = new (std::nothrow) uchar[dataSize];
+        if(!pixels) {
+            qCCritical(logImport) << "Failed to allocate memory for texture image:" << url.toString();
+            if(mappedData) {
+                imageFile.unmap(mappedData);
+            }
+            return false;
+        }
+        image.storage = QDataStorage::fromRawData(pixels, dataSize, [pixels]() {
+            delete[] pixels;
+        });
+        for(int level=0; level<image.mipLevels; ++level) {
+            flipMipLevelVertically(image, level, pixelData + image.mipLevelOffset(level), pixels + image.mipLevelOffset(level));
+        }
+    }
+    else {
+        image.data = QByteArray(reinterpret_cast<const char*>(pixelData), int(dataSize));
+    }
+    if(mappedData) {
+        imageFile.unmap(mappedData);
+    }
+
+    data = image;
+    return true;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -10,12 +10,20 @@
 #include <QFile>
 
 // NOTE: Qt's own QImage lacks support for HDR formats, hence usage of stb_image.
-// TODO: Implement QImageReader for Radiance RGBE format, and possibly others.
+// Radiance RGBE images are normally handled by RgbeImageImporter, stb_image remains a fallback for other HDR formats.
 #include <stb_image.h>
 
 namespace Qt3DRaytrace {
 namespace Raytrace {
 
+// Decoded pixels are handed over to image data without copying and released with the last reference.
+static QDataStoragePtr takeImage(void *image, quint64 size)
+{
+    return QDataStorage::fromRawData(reinterpret_cast<const uchar*>(image), size, [image]() {
+        stbi_image_free(image);
+    });
+}
+
 DefaultImageImporter::DefaultImageImporter()
 {
     stbi_set_flip_vertically_on_load(1);
@@ -51,11 +59,10 @@ bool DefaultImageImporter::import(const QUrl &url, QImageData &data)
     if(stbi_is_hdr_from_memory(compressedData, compressedDataSize) == 1) {
         float *image = stbi_loadf_from_memory(compressedData, compressedDataSize, &data.width, &data.height, &data.channels, 0);
         if(image) {
-            const int imageSize = data.width * data.height * data.channels * sizeof(float);
-            data.format = QImageData::Format::RGB;
-            data.type   = QImageData::ValueType::Float32;
-            data.data   = QByteArray(reinterpret_cast<const char*>(image), imageSize);
-            stbi_image_free(image);
+            const quint64 imageSize = quint64(data.width) * quint64(data.height) * quint64(data.channels) * sizeof(float);
+            data.format  = QImageData::Format::RGB;
+            data.type    = QImageData::ValueType::Float32;
+            data.storage = takeImage(image, imageSize);
             return true;
         }
     }
@@ -69,11 +76,10 @@ bool DefaultImageImporter::import(const QUrl &url, QImageData &data)
         int numActualChannels;
         stbi_uc *image = stbi_load_from_memory(compressedData, compressedDataSize, &data.width, &data.height, &numActualChannels, imageChannels);
         if(image) {
-            const int imageSize = data.width * data.height * data.channels;
-            data.format = QImageData::Format::RGBA;
-            data.type   = QImageData::ValueType::UInt8;
-            data.data   = QByteArray(reinterpret_cast<const char*>(image), imageSize);
-            stbi_image_free(image);
+            const quint64 imageSize = quint64(data.width) * quint64(data.height) * quint64(data.channels);
+            data.format  = QImageData::Format::RGBA;
+            data.type    = QImageData::ValueType::UInt8;
+            data.storage = takeImage(image, imageSize);
             return true;
         }
     }
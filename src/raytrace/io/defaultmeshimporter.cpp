@@ -6,6 +6,8 @@
 
 #include <io/common_p.h>
 #include <io/defaultmeshimporter_p.h>
+#include <io/meshcache_p.h>
+#include <io/assimpiosystem_p.h>
 
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
@@ -13,11 +15,14 @@
 #include <assimp/LogStream.hpp>
 #include <assimp/DefaultLogger.hpp>
 
-#include <QFile>
-#include <QFileInfo>
+#include <utility/parallelfor.h>
 
 #include <QMutex>
 #include <QMutexLocker>
+#include <QAtomicInt>
+
+#include <limits>
+#include <memory>
 
 namespace Qt3DRaytrace {
 namespace Raytrace {
@@ -34,9 +39,7 @@ static constexpr unsigned int ImportFlags =
         aiProcess_FindInvalidData |
         aiProcess_ValidateDataStructure;
 
-static constexpr QVector3D TangentGenUp{0.0f, 1.0f, 0.0f};
-static constexpr QVector3D TangentGenRight{1.0f, 0.0f, 0.0f};
-static constexpr float     TangentGenLengthThreshold = 0.001f;
+static constexpr int ConversionChunkSize = 64 * 1024;
 
 class LogStream final : public Assimp::LogStream
 {
@@ -61,97 +64,158 @@ private:
 
 QMutex LogStream::LoggerInitMutex;
 
-static bool importScene(const aiScene *scene, QGeometryData &data)
+namespace {
+
+struct ConversionChunk
 {
-    int totalNumVertices = 0;
-    int totalNumFaces = 0;
+    int meshIndex;
+    int firstVertex;
+    int lastVertex;
+    int firstFace;
+    int lastFace;
+};
 
-    QVector<quint32> meshBaseIndices;
-    meshBaseIndices.reserve(int(scene->mNumMeshes));
-    for(int i=0; i<int(scene->mNumMeshes); ++i) {
-        const aiMesh *mesh = scene->mMeshes[i];
-        if(mesh->HasPositions() && mesh->HasNormals() && mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) {
-            meshBaseIndices.append(quint32(totalNumVertices));
-            totalNumVertices += int(mesh->mNumVertices);
-            totalNumFaces += int(mesh->mNumFaces);
+} // anonymous
+
+static bool isMeshImportable(const aiMesh *mesh)
+{
+    return mesh->HasPositions() && mesh->HasNormals() && mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE;
+}
+
+static void convertMeshChunk(const aiMesh *mesh, const ConversionChunk &chunk, quint32 baseVertex, QVertex *vertices, QTriangle *faces)
+{
+    for(int j=chunk.firstVertex; j<chunk.lastVertex; ++j) {
+        auto &vertex = vertices[j];
+
+        vertex.position = { mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z };
+        vertex.normal = { mesh->mNormals[j].x, mesh->mNormals[j].y, mesh->mNormals[j].z };
+        vertex.normal.normalize();
+        if(mesh->HasTextureCoords(0)) {
+            vertex.texcoord = { mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y };
+        }
+        if(mesh->HasTangentsAndBitangents()) {
+            vertex.tangent = { mesh->mTangents[j].x, mesh->mTangents[j].y, mesh->mTangents[j].z };
+            vertex.tangent.normalize();
+        }
+        else {
+            // Assimp was unable to calculate tangents.
+            vertex.tangent = computeFallbackTangent(vertex.normal);
         }
     }
-    if(totalNumVertices == 0 || totalNumFaces == 0) {
-        return false;
+    for(int j=chunk.firstFace; j<chunk.lastFace; ++j) {
+        auto &triangle = faces[j];
+        triangle.vertices[0] = baseVertex + mesh->mFaces[j].mIndices[0];
+        triangle.vertices[1] = baseVertex + mesh->mFaces[j].mIndices[1];
+        triangle.vertices[2] = baseVertex + mesh->mFaces[j].mIndices[2];
     }
+}
 
-    data.vertices.resize(totalNumVertices);
-    data.faces.resize(totalNumFaces);
-
-    for(int i=0, meshIndex=0, vertexIndex=0, triangleIndex=0; i<int(scene->mNumMeshes); ++i) {
+// Converts meshes in parallel into disjoint ranges of pre-sized output.
+// Each mesh is destroyed as soon as all of its chunks are converted so that peak memory stays close to
+// the size of the scene rather than scene and output combined.
+static bool importScene(aiScene *scene, QGeometryData &data)
+{
+    qint64 totalNumVertices = 0;
+    qint64 totalNumFaces = 0;
+
+    const int numMeshes = int(scene->mNumMeshes);
+    QVector<quint32> meshBaseVertices(numMeshes);
+    QVector<quint32> meshBaseFaces(numMeshes);
+    QVector<ConversionChunk> chunks;
+    for(int i=0; i<numMeshes; ++i) {
         const aiMesh *mesh = scene->mMeshes[i];
-        if(!mesh->HasPositions() || !mesh->HasNormals()) {
+        if(!isMeshImportable(mesh)) {
             continue;
         }
-        if(mesh->mPrimitiveTypes != aiPrimitiveType_TRIANGLE) {
-            continue;
+        meshBaseVertices[i] = quint32(totalNumVertices);
+        meshBaseFaces[i] = quint32(totalNumFaces);
+        totalNumVertices += mesh->mNumVertices;
+        totalNumFaces += mesh->mNumFaces;
+
+        const int numVertices = int(mesh->mNumVertices);
+        const int numFaces = int(mesh->mNumFaces);
+        const int numChunks = qMax((qMax(numVertices, numFaces) + ConversionChunkSize - 1) / ConversionChunkSize, 1);
+        for(int j=0; j<numChunks; ++j) {
+            const int chunkBegin = j * ConversionChunkSize;
+            chunks.append({ i,
+                            qMin(chunkBegin, numVertices), qMin(chunkBegin + ConversionChunkSize, numVertices),
+                            qMin(chunkBegin, numFaces), qMin(chunkBegin + ConversionChunkSize, numFaces) });
         }
+    }
+    if(totalNumVertices == 0 || totalNumFaces == 0) {
+        return false;
+    }
+    if(totalNumVertices > std::numeric_limits<int>::max() || totalNumFaces > std::numeric_limits<int>::max()) {
+        qCCritical(logImport) << "Mesh is too large";
+        return false;
+    }
 
-        for(int j=0; j<int(mesh->mNumVertices); ++j, ++vertexIndex) {
-            auto &vertex = data.vertices[vertexIndex];
+    data.vertices.resize(int(totalNumVertices));
+    data.faces.resize(int(totalNumFaces));
+    QVertex *vertices = data.vertices.data();
+    QTriangle *faces = data.faces.data();
 
-            vertex.position = { mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z };
-            vertex.normal = { mesh->mNormals[j].x, mesh->mNormals[j].y, mesh->mNormals[j].z };
-            vertex.normal.normalize();
-            if(mesh->HasTextureCoords(0)) {
-                vertex.texcoord = { mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y };
-            }
-            if(mesh->HasTangentsAndBitangents()) {
-                vertex.tangent = { mesh->mTangents[j].x, mesh->mTangents[j].y, mesh->mTangents[j].z };
-                vertex.tangent.normalize();
-            }
-            else {
-                // Fallback when no UV coords were present so Assimp was unable to calculate tangents.
-                // Lousy tangents are better than no tangents. ;-)
-                vertex.tangent = QVector3D::crossProduct(TangentGenUp, vertex.normal);
-                if(vertex.tangent.lengthSquared() < TangentGenLengthThreshold) {
-                    vertex.tangent = QVector3D::crossProduct(TangentGenRight, vertex.normal);
-                }
-                vertex.tangent.normalize();
+    QVector<QAtomicInt> meshRemainingChunks(numMeshes);
+    for(const ConversionChunk &chunk : qAsConst(chunks)) {
+        meshRemainingChunks[chunk.meshIndex].ref();
+    }
+    QAtomicInt *remainingChunks = meshRemainingChunks.data();
+
+    const ConversionChunk *chunkData = chunks.constData();
+    const quint32 *baseVertices = meshBaseVertices.constData();
+    const quint32 *baseFaces = meshBaseFaces.constData();
+    Utility::parallelFor(0, chunks.size(), 1, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            const ConversionChunk &chunk = chunkData[i];
+            convertMeshChunk(scene->mMeshes[chunk.meshIndex], chunk, baseVertices[chunk.meshIndex],
+                             vertices + baseVertices[chunk.meshIndex], faces + baseFaces[chunk.meshIndex]);
+            if(!remainingChunks[chunk.meshIndex].deref()) {
+                delete scene->mMeshes[chunk.meshIndex];
+                scene->mMeshes[chunk.meshIndex] = nullptr;
             }
         }
-        for(int j=0; j<int(mesh->mNumFaces); ++j, ++triangleIndex) {
-            auto &triangle = data.faces[triangleIndex];
-            triangle.vertices[0] = meshBaseIndices[meshIndex] + mesh->mFaces[j].mIndices[0];
-            triangle.vertices[1] = meshBaseIndices[meshIndex] + mesh->mFaces[j].mIndices[1];
-            triangle.vertices[2] = meshBaseIndices[meshIndex] + mesh->mFaces[j].mIndices[2];
-        }
-        ++meshIndex;
-    }
-
+    });
     return true;
 }
 
 bool DefaultMeshImporter::import(const QUrl &url, QGeometryData &data)
 {
+    const QString scenePath = getAssetPathFromUrl(url);
+
+    MeshCache *meshCache = MeshCache::instance();
+    if(meshCache->load(scenePath, ImportFlags, data)) {
+        qCInfo(logImport) << "Loading mesh:" << url.toString() << "(cached)";
+        return true;
+    }
+
     LogStream::initialize();
 
-    const aiScene *scene = nullptr;
+    // Importer reads the mesh and any companion files in place through memory-mapped streams.
     Assimp::Importer importer;
-    {
-        QFile sceneFile(getAssetPathFromUrl(url));
-        if(!sceneFile.open(QFile::ReadOnly)) {
-            qCCritical(logImport) << "Cannot open mesh file:" << url.toString();
-            return false;
-        }
+    importer.SetIOHandler(new AssimpIOSystem);
 
-        qCInfo(logImport) << "Loading mesh:" << url.toString();
+    const QByteArray scenePathUtf8 = scenePath.toUtf8();
+    if(!importer.GetIOHandler()->Exists(scenePathUtf8.constData())) {
+        qCCritical(logImport) << "Cannot open mesh file:" << url.toString();
+        return false;
+    }
 
-        const QByteArray sceneData = sceneFile.readAll();
-        const QByteArray sceneHint = QFileInfo(url.path()).completeSuffix().toUtf8();
-        scene = importer.ReadFileFromMemory(sceneData.data(), size_t(sceneData.size()), ImportFlags, sceneHint.data());
+    qCInfo(logImport) << "Loading mesh:" << url.toString();
+
+    // Scene is detached from the importer so that meshes can be released as they are converted.
+    std::unique_ptr<aiScene> scene;
+    if(importer.ReadFile(scenePathUtf8.constData(), ImportFlags)) {
+        scene.reset(importer.GetOrphanedScene());
     }
 
     bool result = false;
     if(scene && scene->HasMeshes()) {
-        result = importScene(scene, data);
+        result = importScene(scene.get(), data);
+    }
+    if(result) {
+        meshCache->store(scenePath, ImportFlags, data);
     }
-    if(!result) {
+    else {
         qCCritical(logImport) << "Failed to import mesh from file:" << url.toString();
     }
     return result;
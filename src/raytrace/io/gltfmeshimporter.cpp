@@ -0,0 +1,849 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/gltfmeshimporter_p.h>
+#include <io/defaultmeshimporter_p.h>
+#include <io/meshcache_p.h>
+#include <io/meshprocessing_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QMatrix4x4>
+#include <QQuaternion>
+#include <QAtomicInt>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr quint32 GlbMagic = 0x46546C67u;
+static constexpr quint32 GlbVersion = 2;
+static constexpr quint32 GlbHeaderSize = 12;
+static constexpr quint32 GlbChunkHeaderSize = 8;
+static constexpr quint32 GlbChunkJson = 0x4E4F534Au;
+static constexpr quint32 GlbChunkBinary = 0x004E4942u;
+static constexpr int MaxNodeDepth = 256;
+
+// Distinguishes cache entries produced by this importer from those produced by DefaultMeshImporter.
+// Must be incremented whenever output of this importer changes.
+static constexpr quint32 CacheImportFlags = 0x474C5401u;
+
+} // Config
+
+namespace {
+
+enum ComponentType
+{
+    Byte = 5120,
+    UnsignedByte = 5121,
+    Short = 5122,
+    UnsignedShort = 5123,
+    UnsignedInt = 5125,
+    Float = 5126,
+};
+
+enum PrimitiveMode
+{
+    Triangles = 4,
+    TriangleStrip = 5,
+    TriangleFan = 6,
+};
+
+struct BufferData
+{
+    const uchar *data = nullptr;
+    qint64 size = 0;
+};
+
+struct Accessor
+{
+    const uchar *data = nullptr; // Elements of accessors without buffer view are all zero.
+    int count = 0;
+    int stride = 0;
+    int componentType = Float;
+    int numComponents = 0;
+    bool normalized = false;
+};
+
+struct Primitive
+{
+    Accessor positions;
+    Accessor normals;
+    Accessor tangents;
+    Accessor texcoords;
+    Accessor indices;
+    bool hasIndices = false;
+    int mode = Triangles;
+    int numTriangles = 0;
+    QMatrix4x4 transform;
+    int firstVertex = 0;
+    int numVertices = 0;
+    int firstFace = 0;
+};
+
+inline QJsonValue get(const QJsonObject &object, const char *key)
+{
+    return object.value(QLatin1String(key));
+}
+
+inline quint32 readUInt32(const uchar *data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(quint32));
+    return qFromLittleEndian(value);
+}
+
+int componentSize(int componentType)
+{
+    switch(componentType) {
+    case Byte:
+    case UnsignedByte:
+        return 1;
+    case Short:
+    case UnsignedShort:
+        return 2;
+    case UnsignedInt:
+    case Float:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// glTF only allows unsigned integer component types for vertex and sparse indices.
+bool isIndexComponentType(int componentType)
+{
+    return componentType == UnsignedByte || componentType == UnsignedShort || componentType == UnsignedInt;
+}
+
+int numComponentsOfType(const QString &type)
+{
+    if(type == QLatin1String("SCALAR")) {
+        return 1;
+    }
+    else if(type == QLatin1String("VEC2")) {
+        return 2;
+    }
+    else if(type == QLatin1String("VEC3")) {
+        return 3;
+    }
+    else if(type == QLatin1String("VEC4")) {
+        return 4;
+    }
+    return 0;
+}
+
+inline float readComponent(const uchar *data, int componentType, bool normalized)
+{
+    switch(componentType) {
+    case Byte: {
+        const float value = float(qint8(*data));
+        return normalized ? qMax(value / 127.0f, -1.0f) : value;
+    }
+    case UnsignedByte: {
+        const float value = float(*data);
+        return normalized ? (value / 255.0f) : value;
+    }
+    case Short: {
+        qint16 value;
+        std::memcpy(&value, data, sizeof(qint16));
+        return normalized ? qMax(float(value) / 32767.0f, -1.0f) : float(value);
+    }
+    case UnsignedShort: {
+        quint16 value;
+        std::memcpy(&value, data, sizeof(quint16));
+        return normalized ? (float(value) / 65535.0f) : float(value);
+    }
+    case UnsignedInt: {
+        quint32 value;
+        std::memcpy(&value, data, sizeof(quint32));
+        return normalized ? float(double(value) / 4294967295.0) : float(value);
+    }
+    case Float: {
+        float value;
+        std::memcpy(&value, data, sizeof(float));
+        return value;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+template<int N>
+inline void readElement(const Accessor &accessor, int index, float (&values)[N])
+{
+    std::fill(values, values + N, 0.0f);
+    if(!accessor.data) {
+        return;
+    }
+    const uchar *element = accessor.data + qint64(index) * accessor.stride;
+    const int numComponents = qMin(N, accessor.numComponents);
+    if(accessor.componentType == Float) {
+        std::memcpy(values, element, sizeof(float) * size_t(numComponents));
+    }
+    else {
+        const int size = componentSize(accessor.componentType);
+        for(int i=0; i<numComponents; ++i) {
+            values[i] = readComponent(element + i * size, accessor.componentType, accessor.normalized);
+        }
+    }
+}
+
+inline quint32 readIndex(const Accessor &accessor, int index)
+{
+    const uchar *element = accessor.data + qint64(index) * accessor.stride;
+    switch(accessor.componentType) {
+    case UnsignedByte:
+        return *element;
+    case UnsignedShort: {
+        quint16 value;
+        std::memcpy(&value, element, sizeof(quint16));
+        return value;
+    }
+    case UnsignedInt: {
+        quint32 value;
+        std::memcpy(&value, element, sizeof(quint32));
+        return value;
+    }
+    default:
+        Q_ASSERT_X(0, Q_FUNC_INFO, "Unsupported index component type");
+        return 0;
+    }
+}
+
+class GltfDocument
+{
+public:
+    bool open(const QString &path);
+    bool resolveAccessor(int index, Accessor &accessor);
+
+    const QJsonObject &root() const { return m_root; }
+
+private:
+    bool mapFile(const QString &path, BufferData &buffer);
+    bool loadBuffers(const QString &basePath, const BufferData &binaryChunk);
+    bool resolveBufferView(int index, BufferData &view, int &stride) const;
+    bool materializeSparse(const QJsonObject &sparse, Accessor &accessor);
+
+    QJsonObject m_root;
+    QJsonArray m_accessors;
+    QJsonArray m_bufferViews;
+    QVector<BufferData> m_buffers;
+    std::vector<std::unique_ptr<QFile>> m_mappedFiles;
+    QList<QByteArray> m_ownedData;
+};
+
+bool GltfDocument::mapFile(const QString &path, BufferData &buffer)
+{
+    std::unique_ptr<QFile> file(new QFile(path));
+    if(!file->open(QFile::ReadOnly)) {
+        return false;
+    }
+    buffer.size = file->size();
+    if(buffer.size > 0) {
+        if(const uchar *data = file->map(0, buffer.size)) {
+            buffer.data = data;
+            m_mappedFiles.push_back(std::move(file));
+        }
+        else {
+            // Compressed Qt resources cannot be mapped.
+            m_ownedData.append(file->readAll());
+            buffer.data = reinterpret_cast<const uchar*>(m_ownedData.last().constData());
+            buffer.size = m_ownedData.last().size();
+        }
+    }
+    return true;
+}
+
+bool GltfDocument::open(const QString &path)
+{
+    BufferData file;
+    if(!mapFile(path, file)) {
+        return false;
+    }
+
+    BufferData json = file;
+    BufferData binaryChunk;
+    if(file.size >= Config::GlbHeaderSize && readUInt32(file.data) == Config::GlbMagic) {
+        const quint32 version = readUInt32(file.data + 4);
+        const qint64 length = qMin(qint64(readUInt32(file.data + 8)), file.size);
+        if(version != Config::GlbVersion) {
+            qCWarning(logImport) << "Unsupported glTF binary container version:" << version;
+            return false;
+        }
+        json = BufferData();
+        for(qint64 offset = Config::GlbHeaderSize; offset + Config::GlbChunkHeaderSize <= length;) {
+            const qint64 chunkLength = readUInt32(file.data + offset);
+            const quint32 chunkType = readUInt32(file.data + offset + 4);
+            const qint64 chunkOffset = offset + Config::GlbChunkHeaderSize;
+            if(chunkOffset + chunkLength > length) {
+                break;
+            }
+            if(chunkType == Config::GlbChunkJson && !json.data) {
+                json = { file.data + chunkOffset, chunkLength };
+            }
+            else if(chunkType == Config::GlbChunkBinary && !binaryChunk.data) {
+                binaryChunk = { file.data + chunkOffset, chunkLength };
+            }
+            offset = chunkOffset + chunkLength;
+        }
+        if(!json.data) {
+            qCWarning(logImport) << "glTF binary container is missing JSON chunk";
+            return false;
+        }
+    }
+
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(QByteArray::fromRawData(reinterpret_cast<const char*>(json.data), int(json.size)), &error);
+    if(!document.isObject()) {
+        qCWarning(logImport) << "Invalid glTF document:" << error.errorString();
+        return false;
+    }
+    m_root = document.object();
+    m_accessors = get(m_root, "accessors").toArray();
+    m_bufferViews = get(m_root, "bufferViews").toArray();
+    return loadBuffers(QFileInfo(path).path(), binaryChunk);
+}
+
+bool GltfDocument::loadBuffers(const QString &basePath, const BufferData &binaryChunk)
+{
+    static const QString DataUriPrefix = QStringLiteral("data:");
+
+    const QJsonArray buffers = get(m_root, "buffers").toArray();
+    m_buffers.resize(buffers.size());
+    for(int i=0; i<buffers.size(); ++i) {
+        const QJsonObject buffer = buffers[i].toObject();
+        const QString uri = get(buffer, "uri").toString();
+        const qint64 byteLength = qint64(get(buffer, "byteLength").toDouble());
+
+        BufferData data;
+        if(uri.isEmpty()) {
+            // Only the first buffer may refer to binary chunk of GLB container.
+            if(i != 0 || !binaryChunk.data) {
+                qCWarning(logImport) << "glTF buffer" << i << "has no data";
+                return false;
+            }
+            data = binaryChunk;
+        }
+        else if(uri.startsWith(DataUriPrefix)) {
+            const int dataOffset = uri.indexOf(QLatin1Char(',')) + 1;
+            m_ownedData.append(QByteArray::fromBase64(uri.midRef(dataOffset).toLatin1()));
+            data.data = reinterpret_cast<const uchar*>(m_ownedData.last().constData());
+            data.size = m_ownedData.last().size();
+        }
+        else {
+            const QString bufferPath = basePath + QLatin1Char('/') + QUrl::fromPercentEncoding(uri.toUtf8());
+            if(!mapFile(bufferPath, data)) {
+                qCWarning(logImport) << "Cannot open glTF buffer file:" << bufferPath;
+                return false;
+            }
+        }
+        if(data.size < byteLength) {
+            qCWarning(logImport) << "glTF buffer" << i << "is smaller than declared";
+            return false;
+        }
+        data.size = byteLength;
+        m_buffers[i] = data;
+    }
+    return true;
+}
+
+bool GltfDocument::resolveBufferView(int index, BufferData &view, int &stride) const
+{
+    if(index < 0 || index >= m_bufferViews.size()) {
+        return false;
+    }
+    const QJsonObject bufferView = m_bufferViews[index].toObject();
+    const int bufferIndex = get(bufferView, "buffer").toInt(-1);
+    if(bufferIndex < 0 || bufferIndex >= m_buffers.size()) {
+        return false;
+    }
+    const qint64 byteOffset = qint64(get(bufferView, "byteOffset").toDouble());
+    const qint64 byteLength = qint64(get(bufferView, "byteLength").toDouble());
+    if(byteOffset < 0 || byteLength < 0 || byteOffset + byteLength > m_buffers[bufferIndex].size) {
+        return false;
+    }
+    view.data = m_buffers[bufferIndex].data + byteOffset;
+    view.size = byteLength;
+    stride = get(bufferView, "byteStride").toInt(0);
+    return true;
+}
+
+bool GltfDocument::resolveAccessor(int index, Accessor &accessor)
+{
+    if(index < 0 || index >= m_accessors.size()) {
+        return false;
+    }
+    const QJsonObject object = m_accessors[index].toObject();
+    accessor.count = get(object, "count").toInt(-1);
+    accessor.componentType = get(object, "componentType").toInt();
+    accessor.numComponents = numComponentsOfType(get(object, "type").toString());
+    accessor.normalized = get(object, "normalized").toBool(false);
+
+    const int elementSize = componentSize(accessor.componentType) * accessor.numComponents;
+    if(accessor.count < 0 || elementSize == 0) {
+        return false;
+    }
+
+    accessor.data = nullptr;
+    accessor.stride = elementSize;
+    if(object.contains(QLatin1String("bufferView"))) {
+        BufferData view;
+        int viewStride;
+        if(!resolveBufferView(get(object, "bufferView").toInt(-1), view, viewStride)) {
+            return false;
+        }
+        accessor.stride = (viewStride > 0) ? viewStride : elementSize;
+
+        const qint64 byteOffset = qint64(get(object, "byteOffset").toDouble());
+        const qint64 byteSize = (accessor.count > 0) ? (qint64(accessor.stride) * (accessor.count - 1) + elementSize) : 0;
+        if(byteOffset < 0 || byteOffset + byteSize > view.size) {
+            return false;
+        }
+        accessor.data = view.data + byteOffset;
+    }
+
+    const QJsonObject sparse = get(object, "sparse").toObject();
+    if(!sparse.isEmpty()) {
+        return materializeSparse(sparse, accessor);
+    }
+    return true;
+}
+
+bool GltfDocument::materializeSparse(const QJsonObject &sparse, Accessor &accessor)
+{
+    // Sparse accessors are rare enough to be expanded into tightly packed dense copies.
+    const int elementSize = componentSize(accessor.componentType) * accessor.numComponents;
+    const qint64 denseSize = qint64(accessor.count) * elementSize;
+    if(accessor.count < 0 || elementSize <= 0 || denseSize > std::numeric_limits<int>::max()) {
+        return false;
+    }
+    QByteArray denseData(int(denseSize), '\0');
+    if(denseData.size() != int(denseSize)) {
+        return false;
+    }
+    uchar *dense = reinterpret_cast<uchar*>(denseData.data());
+    if(accessor.data) {
+        for(int i=0; i<accessor.count; ++i) {
+            std::memcpy(dense + qint64(i) * elementSize, accessor.data + qint64(i) * accessor.stride, size_t(elementSize));
+        }
+    }
+
+    const int count = get(sparse, "count").toInt(-1);
+    const QJsonObject indicesObject = get(sparse, "indices").toObject();
+    const QJsonObject valuesObject = get(sparse, "values").toObject();
+
+    Accessor indices;
+    indices.count = count;
+    indices.componentType = get(indicesObject, "componentType").toInt();
+    indices.stride = componentSize(indices.componentType);
+
+    BufferData indicesView, valuesView;
+    int unusedStride;
+    if(count < 0 || !isIndexComponentType(indices.componentType) ||
+       !resolveBufferView(get(indicesObject, "bufferView").toInt(-1), indicesView, unusedStride) ||
+       !resolveBufferView(get(valuesObject, "bufferView").toInt(-1), valuesView, unusedStride)) {
+        return false;
+    }
+    const qint64 indicesOffset = qint64(get(indicesObject, "byteOffset").toDouble());
+    const qint64 valuesOffset = qint64(get(valuesObject, "byteOffset").toDouble());
+    if(indicesOffset < 0 || indicesOffset + qint64(count) * indices.stride > indicesView.size ||
+       valuesOffset < 0 || valuesOffset + qint64(count) * elementSize > valuesView.size) {
+        return false;
+    }
+    indices.data = indicesView.data + indicesOffset;
+
+    const uchar *values = valuesView.data + valuesOffset;
+    for(int i=0; i<count; ++i) {
+        const quint32 index = readIndex(indices, i);
+        if(index >= quint32(accessor.count)) {
+            return false;
+        }
+        std::memcpy(dense + qint64(index) * elementSize, values + qint64(i) * elementSize, size_t(elementSize));
+    }
+
+    m_ownedData.append(denseData);
+    accessor.data = reinterpret_cast<const uchar*>(m_ownedData.last().constData());
+    accessor.stride = elementSize;
+    return true;
+}
+
+QMatrix4x4 nodeTransform(const QJsonObject &node)
+{
+    const QJsonArray matrix = get(node, "matrix").toArray();
+    if(matrix.size() == 16) {
+        float values[16];
+        for(int i=0; i<16; ++i) {
+            values[i] = float(matrix[i].toDouble());
+        }
+        // QMatrix4x4 expects row-major values while glTF stores matrices in column-major order.
+        return QMatrix4x4(values).transposed();
+    }
+
+    QMatrix4x4 transform;
+    const QJsonArray translation = get(node, "translation").toArray();
+    if(translation.size() == 3) {
+        transform.translate(float(translation[0].toDouble()), float(translation[1].toDouble()), float(translation[2].toDouble()));
+    }
+    const QJsonArray rotation = get(node, "rotation").toArray();
+    if(rotation.size() == 4) {
+        transform.rotate(QQuaternion(float(rotation[3].toDouble()), float(rotation[0].toDouble()), float(rotation[1].toDouble()), float(rotation[2].toDouble())));
+    }
+    const QJsonArray scale = get(node, "scale").toArray();
+    if(scale.size() == 3) {
+        transform.scale(float(scale[0].toDouble()), float(scale[1].toDouble()), float(scale[2].toDouble()));
+    }
+    return transform;
+}
+
+bool isCompressed(const QJsonObject &object)
+{
+    const QJsonObject extensions = get(object, "extensions").toObject();
+    return extensions.contains(QLatin1String("KHR_draco_mesh_compression"))
+        || extensions.contains(QLatin1String("EXT_meshopt_compression"));
+}
+
+// Returns false if the document uses features this importer does not handle.
+bool collectPrimitives(GltfDocument &document, const QJsonObject &mesh, const QMatrix4x4 &transform, QVector<Primitive> &primitives)
+{
+    const QJsonArray meshPrimitives = get(mesh, "primitives").toArray();
+    for(const QJsonValue &value : meshPrimitives) {
+        const QJsonObject object = value.toObject();
+        if(isCompressed(object)) {
+            return false;
+        }
+
+        Primitive primitive;
+        primitive.mode = get(object, "mode").toInt(Triangles);
+        if(primitive.mode != Triangles && primitive.mode != TriangleStrip && primitive.mode != TriangleFan) {
+            // Points and lines are not renderable.
+            continue;
+        }
+
+        const QJsonObject attributes = get(object, "attributes").toObject();
+        if(!attributes.contains(QLatin1String("POSITION"))) {
+            continue;
+        }
+
+        auto resolveAttribute = [&document, &attributes](const char *name, Accessor &accessor) -> bool {
+            const QJsonValue value = get(attributes, name);
+            return value.isUndefined() || document.resolveAccessor(value.toInt(-1), accessor);
+        };
+        if(!resolveAttribute("POSITION", primitive.positions) ||
+           !resolveAttribute("NORMAL", primitive.normals) ||
+           !resolveAttribute("TANGENT", primitive.tangents) ||
+           !resolveAttribute("TEXCOORD_0", primitive.texcoords)) {
+            return false;
+        }
+        const int numSourceVertices = primitive.positions.count;
+        for(const Accessor *attribute : { &primitive.normals, &primitive.tangents, &primitive.texcoords }) {
+            if(attribute->numComponents > 0 && attribute->count != numSourceVertices) {
+                return false;
+            }
+        }
+
+        int numCorners = numSourceVertices;
+        const QJsonValue indices = get(object, "indices");
+        if(!indices.isUndefined()) {
+            if(!document.resolveAccessor(indices.toInt(-1), primitive.indices) || !primitive.indices.data ||
+               primitive.indices.numComponents != 1 || !isIndexComponentType(primitive.indices.componentType)) {
+                return false;
+            }
+            primitive.hasIndices = true;
+            numCorners = primitive.indices.count;
+        }
+        primitive.numTriangles = (primitive.mode == Triangles) ? (numCorners / 3) : qMax(numCorners - 2, 0);
+        if(primitive.numTriangles == 0) {
+            continue;
+        }
+
+        // Normals are needed to derive tangents; without them glTF mandates flat shading, which requires unwelded vertices.
+        if(primitive.normals.numComponents == 0) {
+            primitive.tangents = Accessor();
+            primitive.numVertices = 3 * primitive.numTriangles;
+        }
+        else {
+            primitive.numVertices = numSourceVertices;
+        }
+        primitive.transform = transform;
+        primitives.append(primitive);
+    }
+    return true;
+}
+
+bool collectScene(GltfDocument &document, QVector<Primitive> &primitives)
+{
+    const QJsonObject &root = document.root();
+    for(const QJsonValue &extension : get(root, "extensionsRequired").toArray()) {
+        const QString name = extension.toString();
+        if(name == QLatin1String("KHR_draco_mesh_compression") || name == QLatin1String("EXT_meshopt_compression")) {
+            return false;
+        }
+    }
+
+    const QJsonArray nodes = get(root, "nodes").toArray();
+    const QJsonArray meshes = get(root, "meshes").toArray();
+
+    QVector<int> rootNodes;
+    const QJsonArray scenes = get(root, "scenes").toArray();
+    if(!scenes.isEmpty()) {
+        const int sceneIndex = qBound(0, get(root, "scene").toInt(0), scenes.size() - 1);
+        for(const QJsonValue &node : get(scenes[sceneIndex].toObject(), "nodes").toArray()) {
+            rootNodes.append(node.toInt(-1));
+        }
+    }
+    else {
+        // Without scenes all nodes which are not children of other nodes are treated as roots.
+        QVector<bool> isChild(nodes.size(), false);
+        for(const QJsonValue &node : nodes) {
+            for(const QJsonValue &child : get(node.toObject(), "children").toArray()) {
+                const int childIndex = child.toInt(-1);
+                if(childIndex >= 0 && childIndex < nodes.size()) {
+                    isChild[childIndex] = true;
+                }
+            }
+        }
+        for(int i=0; i<nodes.size(); ++i) {
+            if(!isChild[i]) {
+                rootNodes.append(i);
+            }
+        }
+    }
+
+    struct NodeRef
+    {
+        int index;
+        QMatrix4x4 parentTransform;
+        int depth;
+    };
+    QVector<NodeRef> stack;
+    for(int i=rootNodes.size()-1; i>=0; --i) {
+        stack.append({ rootNodes[i], QMatrix4x4(), 0 });
+    }
+    while(!stack.isEmpty()) {
+        const NodeRef ref = stack.takeLast();
+        if(ref.index < 0 || ref.index >= nodes.size() || ref.depth > Config::MaxNodeDepth) {
+            return false;
+        }
+        const QJsonObject node = nodes[ref.index].toObject();
+        const QMatrix4x4 transform = ref.parentTransform * nodeTransform(node);
+
+        const QJsonValue mesh = get(node, "mesh");
+        if(!mesh.isUndefined()) {
+            const int meshIndex = mesh.toInt(-1);
+            if(meshIndex < 0 || meshIndex >= meshes.size()) {
+                return false;
+            }
+            if(!collectPrimitives(document, meshes[meshIndex].toObject(), transform, primitives)) {
+                return false;
+            }
+        }
+
+        const QJsonArray children = get(node, "children").toArray();
+        for(int i=children.size()-1; i>=0; --i) {
+            stack.append({ children[i].toInt(-1), transform, ref.depth + 1 });
+        }
+    }
+    return true;
+}
+
+inline int cornerSourceIndex(const Primitive &primitive, int triangle, int corner)
+{
+    int index;
+    switch(primitive.mode) {
+    case TriangleStrip:
+        // Every other triangle in a strip has reversed winding.
+        index = triangle + (((triangle & 1) && corner < 2) ? (1 - corner) : corner);
+        break;
+    case TriangleFan:
+        index = (corner == 0) ? 0 : (triangle + corner);
+        break;
+    default:
+        index = 3 * triangle + corner;
+        break;
+    }
+    return primitive.hasIndices ? int(readIndex(primitive.indices, index)) : index;
+}
+
+bool convertPrimitive(const Primitive &primitive, QGeometryData &data)
+{
+    const bool hasNormals = primitive.normals.numComponents > 0;
+    const bool hasTangents = primitive.tangents.numComponents > 0;
+    const bool isIdentity = primitive.transform.isIdentity();
+    const bool flipWinding = primitive.transform.determinant() < 0.0f;
+    const QMatrix4x4 normalTransform(primitive.transform.normalMatrix());
+
+    QVertex *vertices = data.vertices.data() + primitive.firstVertex;
+    QTriangle *faces = data.faces.data() + primitive.firstFace;
+
+    auto convertVertex = [&](int sourceIndex, QVertex &vertex) {
+        float position[3], normal[3], tangent[3], texcoord[2];
+        readElement(primitive.positions, sourceIndex, position);
+        readElement(primitive.normals, sourceIndex, normal);
+        readElement(primitive.tangents, sourceIndex, tangent);
+        readElement(primitive.texcoords, sourceIndex, texcoord);
+
+        vertex.position = { position[0], position[1], position[2] };
+        vertex.normal = { normal[0], normal[1], normal[2] };
+        vertex.tangent = { tangent[0], tangent[1], tangent[2] };
+        // Flip V to match texture coordinate convention of the Assimp import path.
+        vertex.texcoord = { texcoord[0], 1.0f - texcoord[1] };
+        if(!isIdentity) {
+            vertex.position = primitive.transform.map(vertex.position);
+            vertex.normal = normalTransform.mapVector(vertex.normal);
+            vertex.tangent = primitive.transform.mapVector(vertex.tangent);
+        }
+        vertex.normal.normalize();
+        vertex.tangent.normalize();
+    };
+
+    const int numSourceVertices = primitive.positions.count;
+    if(hasNormals) {
+        for(int i=0; i<primitive.numVertices; ++i) {
+            convertVertex(i, vertices[i]);
+        }
+        for(int i=0; i<primitive.numTriangles; ++i) {
+            for(int k=0; k<3; ++k) {
+                const int sourceIndex = cornerSourceIndex(primitive, i, k);
+                if(sourceIndex < 0 || sourceIndex >= numSourceVertices) {
+                    return false;
+                }
+                faces[i].vertices[k] = quint32(primitive.firstVertex + sourceIndex);
+            }
+        }
+    }
+    else {
+        for(int i=0; i<primitive.numTriangles; ++i) {
+            QVertex *triangleVertices = &vertices[3 * i];
+            for(int k=0; k<3; ++k) {
+                const int sourceIndex = cornerSourceIndex(primitive, i, k);
+                if(sourceIndex < 0 || sourceIndex >= numSourceVertices) {
+                    return false;
+                }
+                convertVertex(sourceIndex, triangleVertices[k]);
+                faces[i].vertices[k] = quint32(primitive.firstVertex + 3 * i + k);
+            }
+            QVector3D faceNormal = QVector3D::crossProduct(triangleVertices[1].position - triangleVertices[0].position,
+                                                           triangleVertices[2].position - triangleVertices[0].position);
+            if(flipWinding) {
+                faceNormal = -faceNormal;
+            }
+            faceNormal.normalize();
+            for(int k=0; k<3; ++k) {
+                triangleVertices[k].normal = faceNormal;
+            }
+        }
+    }
+    if(flipWinding) {
+        for(int i=0; i<primitive.numTriangles; ++i) {
+            std::swap(faces[i].vertices[1], faces[i].vertices[2]);
+        }
+    }
+    if(!hasTangents) {
+        generateTangents(data, primitive.firstVertex, primitive.numVertices, primitive.firstFace, primitive.numTriangles);
+    }
+    return true;
+}
+
+bool importDocument(GltfDocument &document, QGeometryData &data)
+{
+    QVector<Primitive> primitives;
+    if(!collectScene(document, primitives)) {
+        return false;
+    }
+
+    qint64 numVertices = 0;
+    qint64 numFaces = 0;
+    for(Primitive &primitive : primitives) {
+        primitive.firstVertex = int(numVertices);
+        primitive.firstFace = int(numFaces);
+        numVertices += primitive.numVertices;
+        numFaces += primitive.numTriangles;
+        if(numVertices > std::numeric_limits<int>::max() || numFaces > std::numeric_limits<int>::max()) {
+            return false;
+        }
+    }
+    if(numVertices == 0 || numFaces == 0) {
+        return false;
+    }
+
+    data.vertices.resize(int(numVertices));
+    data.faces.resize(int(numFaces));
+
+    QAtomicInt failed(0);
+    Utility::parallelFor(0, primitives.size(), 1, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            if(!convertPrimitive(primitives[i], data)) {
+                failed.storeRelease(1);
+            }
+        }
+    });
+    return !failed.loadAcquire();
+}
+
+} // anonymous
+
+bool GltfMeshImporter::isSupported(const QUrl &url)
+{
+    const QString suffix = QFileInfo(url.path()).suffix();
+    return suffix.compare(QStringLiteral("gltf"), Qt::CaseInsensitive) == 0
+        || suffix.compare(QStringLiteral("glb"), Qt::CaseInsensitive) == 0;
+}
+
+bool GltfMeshImporter::import(const QUrl &url, QGeometryData &data)
+{
+    const QString scenePath = getAssetPathFromUrl(url);
+
+    // Cache entries are keyed by the main file only, so only self-contained binary containers are cached.
+    const bool isCacheable = QFileInfo(scenePath).suffix().compare(QStringLiteral("glb"), Qt::CaseInsensitive) == 0;
+
+    MeshCache *meshCache = MeshCache::instance();
+    if(isCacheable && meshCache->load(scenePath, Config::CacheImportFlags, data)) {
+        qCInfo(logImport) << "Loading mesh:" << url.toString() << "(cached)";
+        return true;
+    }
+
+    bool result = false;
+    {
+        GltfDocument document;
+        if(!QFileInfo::exists(scenePath)) {
+            qCCritical(logImport) << "Cannot open mesh file:" << url.toString();
+            return false;
+        }
+
+        qCInfo(logImport) << "Loading mesh:" << url.toString();
+
+        result = document.open(scenePath) && importDocument(document, data);
+    }
+
+    if(result) {
+        if(isCacheable) {
+            meshCache->store(scenePath, Config::CacheImportFlags, data);
+        }
+        return true;
+    }
+
+    qCWarning(logImport) << "Mesh file contains unsupported glTF content, falling back to default importer:" << url.toString();
+    data = QGeometryData();
+    return DefaultMeshImporter().import(url, data);
+}
+
+} // Raytrace
+} // Qt3DRaytrace
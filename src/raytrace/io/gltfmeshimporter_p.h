@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+#include <io/meshimporter_p.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Native glTF 2.0 importer for both JSON (.gltf) and binary (.glb) containers.
+// Accessors are read directly from memory-mapped buffers, node transforms are baked into vertices
+// and all primitives of the default scene are merged into a single mesh.
+// Files using compression extensions not supported by this importer are handed over to DefaultMeshImporter.
+class GltfMeshImporter final : public MeshImporter
+{
+public:
+    bool import(const QUrl &url, QGeometryData &data) override;
+
+    static bool isSupported(const QUrl &url);
+};
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,617 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/imageprocessing_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QtCore/qfloat16.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUARTZ_IMAGEPROCESSING_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr int GrainSize = 32 * 1024;
+static constexpr float Pi = 3.14159265f;
+static constexpr float KaiserRadius = 3.0f;
+static constexpr float KaiserAlpha = 4.0f;
+static constexpr int SrgbEncodeBuckets = 4096;
+
+} // Config
+
+namespace {
+
+// Filtered rows always hold 4 floats per texel regardless of the number of image channels.
+constexpr int RowStride = 4;
+
+struct SrgbTables
+{
+    SrgbTables()
+    {
+        for(int i=0; i<256; ++i) {
+            toLinear[i] = float(decode(i / 255.0));
+            toUnorm[i] = i / 255.0f;
+        }
+        // Linear value at which rounding of encoded value switches from i-1 to i.
+        thresholds[0] = 0.0f;
+        for(int i=1; i<256; ++i) {
+            thresholds[i] = float(decode((i - 0.5) / 255.0));
+        }
+        int value = 0;
+        for(int i=0; i<=Config::SrgbEncodeBuckets; ++i) {
+            const float bucketStart = float(i) / Config::SrgbEncodeBuckets;
+            while(value < 255 && thresholds[value + 1] <= bucketStart) {
+                ++value;
+            }
+            bucketValues[i] = quint8(value);
+        }
+    }
+
+    static double decode(double c)
+    {
+        return (c <= 0.04045) ? (c / 12.92) : std::pow((c + 0.055) / 1.055, 2.4);
+    }
+
+    quint8 encode(float linear) const
+    {
+        if(!(linear > 0.0f)) {
+            return 0;
+        }
+        if(linear >= 1.0f) {
+            return 255;
+        }
+        int value = bucketValues[int(linear * Config::SrgbEncodeBuckets)];
+        while(value < 255 && thresholds[value + 1] <= linear) {
+            ++value;
+        }
+        return quint8(value);
+    }
+
+    float toLinear[256];
+    float toUnorm[256];
+    float thresholds[256];
+    quint8 bucketValues[Config::SrgbEncodeBuckets + 1];
+};
+
+const SrgbTables &srgbTables()
+{
+    static const SrgbTables tables;
+    return tables;
+}
+
+// Separable filter kernel with a fixed number of taps per destination texel.
+// Source indices are already wrapped around image edges.
+struct FilterKernel
+{
+    int numTaps = 0;
+    QVector<int> indices;
+    QVector<float> weights;
+};
+
+float besselI0(float x)
+{
+    // Power series of modified Bessel function of the first kind converges quickly for arguments used here.
+    float sum = 1.0f;
+    float term = 1.0f;
+    const float halfXSq = 0.25f * x * x;
+    for(int k=1; k<32 && term > 1e-7f * sum; ++k) {
+        term *= halfXSq / float(k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+float sinc(float x)
+{
+    if(std::abs(x) < 1e-6f) {
+        return 1.0f;
+    }
+    const float pix = Config::Pi * x;
+    return std::sin(pix) / pix;
+}
+
+float kaiserWeight(float t)
+{
+    const float u = t / Config::KaiserRadius;
+    if(std::abs(u) >= 1.0f) {
+        return 0.0f;
+    }
+    static const float invI0Alpha = 1.0f / besselI0(Config::KaiserAlpha);
+    return sinc(t) * besselI0(Config::KaiserAlpha * std::sqrt(1.0f - u * u)) * invI0Alpha;
+}
+
+FilterKernel createFilterKernel(MipmapFilter filter, int srcSize, int dstSize)
+{
+    const float scale = float(srcSize) / float(dstSize);
+    const float support = (filter == MipmapFilter::Box) ? (0.5f * scale) : (Config::KaiserRadius * scale);
+
+    // Texel i of source spans [i, i+1) in source coordinates.
+    auto firstTap = [&](int i) { return int(std::floor((i + 0.5f) * scale - support + 1e-4f)); };
+    auto lastTap  = [&](int i) { return int(std::ceil((i + 0.5f) * scale + support - 1e-4f)) - 1; };
+
+    FilterKernel kernel;
+    for(int i=0; i<dstSize; ++i) {
+        kernel.numTaps = qMax(kernel.numTaps, lastTap(i) - firstTap(i) + 1);
+    }
+    kernel.indices.resize(dstSize * kernel.numTaps);
+    kernel.weights.resize(dstSize * kernel.numTaps);
+
+    for(int i=0; i<dstSize; ++i) {
+        const float center = (i + 0.5f) * scale;
+        const int first = firstTap(i);
+        const int last = lastTap(i);
+
+        int *indices = kernel.indices.data() + i * kernel.numTaps;
+        float *weights = kernel.weights.data() + i * kernel.numTaps;
+        float weightSum = 0.0f;
+        for(int k=0; k<kernel.numTaps; ++k) {
+            const int s = first + k;
+            float weight = 0.0f;
+            if(s <= last) {
+                if(filter == MipmapFilter::Box) {
+                    weight = qMax(0.0f, qMin(float(s + 1), center + support) - qMax(float(s), center - support));
+                }
+                else {
+                    weight = kaiserWeight((s + 0.5f - center) / scale);
+                }
+            }
+            // Padding taps repeat the first source texel with zero weight.
+            const int wrapped = ((s <= last ? s : first) % srcSize + srcSize) % srcSize;
+            indices[k] = wrapped;
+            weights[k] = weight;
+            weightSum += weight;
+        }
+        if(weightSum != 0.0f) {
+            const float invWeightSum = 1.0f / weightSum;
+            for(int k=0; k<kernel.numTaps; ++k) {
+                weights[k] *= invWeightSum;
+            }
+        }
+    }
+    return kernel;
+}
+
+void decodeRow(const QImageData &image, bool sRGB, const uchar *src, int width, float *dst)
+{
+    const int channels = image.channels;
+    if(channels < RowStride) {
+        std::fill(dst, dst + width * RowStride, 0.0f);
+    }
+
+    switch(image.type) {
+    case QImageData::ValueType::UInt8: {
+        const SrgbTables &tables = srgbTables();
+        const float *lookup[RowStride];
+        for(int c=0; c<RowStride; ++c) {
+            lookup[c] = (sRGB && c < 3) ? tables.toLinear : tables.toUnorm;
+        }
+        if(channels == RowStride) {
+            for(int x=0; x<width; ++x, src += RowStride, dst += RowStride) {
+                dst[0] = lookup[0][src[0]];
+                dst[1] = lookup[1][src[1]];
+                dst[2] = lookup[2][src[2]];
+                dst[3] = lookup[3][src[3]];
+            }
+        }
+        else {
+            for(int x=0; x<width; ++x) {
+                for(int c=0; c<channels; ++c) {
+                    dst[x * RowStride + c] = lookup[c][src[x * channels + c]];
+                }
+            }
+        }
+        break;
+    }
+    case QImageData::ValueType::Float16: {
+        const qfloat16 *values = reinterpret_cast<const qfloat16*>(src);
+        if(channels == RowStride) {
+            qFloatFromFloat16(dst, values, width * RowStride);
+        }
+        else {
+            for(int x=0; x<width; ++x) {
+                for(int c=0; c<channels; ++c) {
+                    dst[x * RowStride + c] = float(values[x * channels + c]);
+                }
+            }
+        }
+        break;
+    }
+    case QImageData::ValueType::Float32: {
+        const float *values = reinterpret_cast<const float*>(src);
+        if(channels == RowStride) {
+            std::memcpy(dst, values, size_t(width) * RowStride * sizeof(float));
+        }
+        else {
+            for(int x=0; x<width; ++x) {
+                for(int c=0; c<channels; ++c) {
+                    dst[x * RowStride + c] = values[x * channels + c];
+                }
+            }
+        }
+        break;
+    }
+    default:
+        Q_ASSERT_X(0, Q_FUNC_INFO, "Unsupported image value type");
+    }
+}
+
+void encodeRow(const QImageData &image, bool sRGB, float *src, int width, uchar *dst)
+{
+    const int channels = image.channels;
+    const int numValues = width * RowStride;
+
+    // Textures never hold negative values; clamp ringing introduced by the filter.
+#if defined(QUARTZ_IMAGEPROCESSING_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    for(int i=0; i<numValues; i+=4) {
+        _mm_storeu_ps(src + i, _mm_max_ps(_mm_loadu_ps(src + i), zero));
+    }
+#else
+    for(int i=0; i<numValues; ++i) {
+        src[i] = (src[i] > 0.0f) ? src[i] : 0.0f;
+    }
+#endif
+
+    switch(image.type) {
+    case QImageData::ValueType::UInt8:
+        if(sRGB && channels == RowStride) {
+            const SrgbTables &tables = srgbTables();
+            for(int x=0; x<width; ++x, src += RowStride, dst += RowStride) {
+                dst[0] = tables.encode(src[0]);
+                dst[1] = tables.encode(src[1]);
+                dst[2] = tables.encode(src[2]);
+                dst[3] = quint8(qMin(src[3], 1.0f) * 255.0f + 0.5f);
+            }
+        }
+        else if(sRGB) {
+            const SrgbTables &tables = srgbTables();
+            for(int x=0; x<width; ++x) {
+                for(int c=0; c<channels; ++c) {
+                    const float value = src[x * RowStride + c];
+                    dst[x * channels + c] = (c < 3) ? tables.encode(value) : quint8(qMin(value, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+#if defined(QUARTZ_IMAGEPROCESSING_SSE2)
+        else if(channels == RowStride) {
+            const __m128 scale = _mm_set1_ps(255.0f);
+            const __m128 one = _mm_set1_ps(1.0f);
+            for(int x=0; x<width; ++x) {
+                const __m128 value = _mm_mul_ps(_mm_min_ps(_mm_loadu_ps(src + x * RowStride), one), scale);
+                __m128i packed = _mm_cvtps_epi32(value);
+                packed = _mm_packs_epi32(packed, packed);
+                packed = _mm_packus_epi16(packed, packed);
+                const qint32 texel = _mm_cvtsi128_si32(packed);
+                std::memcpy(dst + x * RowStride, &texel, sizeof(texel));
+            }
+        }
+#endif
+        else {
+            for(int x=0; x<width; ++x) {
+                for(int c=0; c<channels; ++c) {
+                    dst[x * channels + c] = quint8(qMin(src[x * RowStride + c], 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+        break;
+    case QImageData::ValueType::Float16: {
+        qfloat16 *values = reinterpret_cast<qfloat16*>(dst);
+        if(channels == RowStride) {
+            qFloatToFloat16(values, src, numValues);
+        }
+        else {
+            for(int x=0; x<width; ++x) {
+                for(int c=0; c<channels; ++c) {
+                    values[x * channels + c] = qfloat16(src[x * RowStride + c]);
+                }
+            }
+        }
+        break;
+    }
+    case QImageData::ValueType::Float32: {
+        float *values = reinterpret_cast<float*>(dst);
+        if(channels == RowStride) {
+            std::memcpy(values, src, size_t(numValues) * sizeof(float));
+        }
+        else {
+            for(int x=0; x<width; ++x) {
+                for(int c=0; c<channels; ++c) {
+                    values[x * channels + c] = src[x * RowStride + c];
+                }
+            }
+        }
+        break;
+    }
+    default:
+        Q_ASSERT_X(0, Q_FUNC_INFO, "Unsupported image value type");
+    }
+}
+
+void filterRowHorizontal(const float *src, const FilterKernel &kernel, int dstWidth, float *dst)
+{
+    const int numTaps = kernel.numTaps;
+    const int *indices = kernel.indices.constData();
+    const float *weights = kernel.weights.constData();
+
+    for(int x=0; x<dstWidth; ++x, indices += numTaps, weights += numTaps) {
+#if defined(QUARTZ_IMAGEPROCESSING_SSE2)
+        __m128 sum = _mm_setzero_ps();
+        for(int k=0; k<numTaps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + indices[k] * RowStride), _mm_set1_ps(weights[k])));
+        }
+        _mm_storeu_ps(dst + x * RowStride, sum);
+#else
+        float sum[RowStride] = {};
+        for(int k=0; k<numTaps; ++k) {
+            const float *texel = src + indices[k] * RowStride;
+            for(int c=0; c<RowStride; ++c) {
+                sum[c] += texel[c] * weights[k];
+            }
+        }
+        std::memcpy(dst + x * RowStride, sum, sizeof(sum));
+#endif
+    }
+}
+
+void filterRowsVertical(const float *const *rows, const float *weights, int numTaps, int numValues, float *dst)
+{
+#if defined(QUARTZ_IMAGEPROCESSING_SSE2)
+    for(int i=0; i<numValues; i+=4) {
+        __m128 sum = _mm_setzero_ps();
+        for(int k=0; k<numTaps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(weights[k])));
+        }
+        _mm_storeu_ps(dst + i, sum);
+    }
+#else
+    std::fill(dst, dst + numValues, 0.0f);
+    for(int k=0; k<numTaps; ++k) {
+        const float *row = rows[k];
+        const float weight = weights[k];
+        for(int i=0; i<numValues; ++i) {
+            dst[i] += row[i] * weight;
+        }
+    }
+#endif
+}
+
+void downsampleLevel(const QImageData &image, int level, MipmapFilter filter, bool sRGB, const uchar *srcPixels, uchar *dstPixels)
+{
+    using Utility::parallelFor;
+
+    const int srcWidth = image.mipWidth(level - 1);
+    const int srcHeight = image.mipHeight(level - 1);
+    const int dstWidth = image.mipWidth(level);
+    const int dstHeight = image.mipHeight(level);
+
+    const size_t texelSize = size_t(image.channels) * size_t(image.type);
+    const size_t srcRowPitch = size_t(srcWidth) * texelSize;
+    const size_t dstRowPitch = size_t(dstWidth) * texelSize;
+
+    const FilterKernel kernelX = createFilterKernel(filter, srcWidth, dstWidth);
+    const FilterKernel kernelY = createFilterKernel(filter, srcHeight, dstHeight);
+    const int numTapsY = kernelY.numTaps;
+
+    const int rowsPerChunk = qMax(1, Config::GrainSize / dstWidth);
+    parallelFor(0, dstHeight, rowsPerChunk, [&](int begin, int end) {
+        // Horizontally filter every source row referenced by this chunk once.
+        QVector<int> rowSlots(srcHeight, -1);
+        int numSlots = 0;
+        for(int i=begin * numTapsY; i<end * numTapsY; ++i) {
+            int &slot = rowSlots[kernelY.indices[i]];
+            if(slot < 0) {
+                slot = numSlots++;
+            }
+        }
+
+        QVector<float> decodedRow(srcWidth * RowStride);
+        QVector<float> filteredRows(numSlots * dstWidth * RowStride);
+        for(int sy=0; sy<srcHeight; ++sy) {
+            if(rowSlots[sy] >= 0) {
+                decodeRow(image, sRGB, srcPixels + size_t(sy) * srcRowPitch, srcWidth, decodedRow.data());
+                filterRowHorizontal(decodedRow.constData(), kernelX, dstWidth, filteredRows.data() + rowSlots[sy] * dstWidth * RowStride);
+            }
+        }
+
+        QVector<const float*> rows(numTapsY);
+        QVector<float> outputRow(dstWidth * RowStride);
+        for(int y=begin; y<end; ++y) {
+            for(int k=0; k<numTapsY; ++k) {
+                rows[k] = filteredRows.constData() + rowSlots[kernelY.indices[y * numTapsY + k]] * dstWidth * RowStride;
+            }
+            filterRowsVertical(rows.constData(), kernelY.weights.constData() + y * numTapsY, numTapsY, dstWidth * RowStride, outputRow.data());
+            encodeRow(image, sRGB, outputRow.data(), dstWidth, dstPixels + size_t(y) * dstRowPitch);
+        }
+    });
+}
+
+// Reverses order of first numRows rows of texels within a block, given bits per row of texel data.
+void flipBlockRows(uchar *rows, int rowBits, int numRows)
+{
+    const int rowBytes = (4 * rowBits) / 8;
+    const quint64 rowMask = (quint64(1) << rowBits) - 1;
+
+    quint64 bits = 0;
+    for(int i=0; i<rowBytes; ++i) {
+        bits |= quint64(rows[i]) << (8 * i);
+    }
+    const int flippedBitCount = numRows * rowBits;
+    quint64 flippedBits = (flippedBitCount < 64) ? (bits & ~((quint64(1) << flippedBitCount) - 1)) : 0;
+    for(int y=0; y<numRows; ++y) {
+        flippedBits |= ((bits >> (y * rowBits)) & rowMask) << ((numRows - 1 - y) * rowBits);
+    }
+    for(int i=0; i<rowBytes; ++i) {
+        rows[i] = uchar(flippedBits >> (8 * i));
+    }
+}
+
+void flipBlock(QImageData::BlockFormat blockFormat, uchar *block, int numRows)
+{
+    switch(blockFormat) {
+    case QImageData::BlockFormat::BC1:
+        flipBlockRows(block + 4, 8, numRows);
+        break;
+    case QImageData::BlockFormat::BC2:
+        flipBlockRows(block, 16, numRows);
+        flipBlockRows(block + 12, 8, numRows);
+        break;
+    case QImageData::BlockFormat::BC3:
+        flipBlockRows(block + 2, 12, numRows);
+        flipBlockRows(block + 12, 8, numRows);
+        break;
+    case QImageData::BlockFormat::BC4:
+        flipBlockRows(block + 2, 12, numRows);
+        break;
+    case QImageData::BlockFormat::BC5:
+        flipBlockRows(block + 2, 12, numRows);
+        flipBlockRows(block + 10, 12, numRows);
+        break;
+    default:
+        Q_UNREACHABLE();
+    }
+}
+
+} // anonymous
+
+bool canFlipImageVertically(const QImageData &image)
+{
+    switch(image.blockFormat) {
+    case QImageData::BlockFormat::None:
+        return true;
+    case QImageData::BlockFormat::BC1:
+    case QImageData::BlockFormat::BC2:
+    case QImageData::BlockFormat::BC3:
+    case QImageData::BlockFormat::BC4:
+    case QImageData::BlockFormat::BC5:
+        break;
+    default:
+        return false;
+    }
+
+    // Blocks of levels with partial bottom row of blocks would straddle block boundaries once flipped.
+    for(int level=0; level<image.mipLevels; ++level) {
+        const int height = image.mipHeight(level);
+        if(height > 4 && height % 4 != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void flipMipLevelVertically(const QImageData &image, int level, const uchar *src, uchar *dst)
+{
+    Q_ASSERT(canFlipImageVertically(image));
+
+    const int width = image.mipWidth(level);
+    const int height = image.mipHeight(level);
+    if(!image.isCompressed()) {
+        const size_t rowSize = size_t(width) * size_t(image.channels) * size_t(image.type);
+        for(int y=0; y<height; ++y) {
+            std::memcpy(dst + size_t(height - 1 - y) * rowSize, src + size_t(y) * rowSize, rowSize);
+        }
+        return;
+    }
+
+    const int blockSize = QImageData::blockSize(image.blockFormat);
+    const int numBlocksX = (width + 3) / 4;
+    const int numBlocksY = (height + 3) / 4;
+    const int numRowsInBlock = std::min(4, height);
+    const size_t blockRowSize = size_t(numBlocksX) * size_t(blockSize);
+    for(int y=0; y<numBlocksY; ++y) {
+        uchar *dstRow = dst + size_t(numBlocksY - 1 - y) * blockRowSize;
+        std::memcpy(dstRow, src + size_t(y) * blockRowSize, blockRowSize);
+        for(int x=0; x<numBlocksX; ++x) {
+            flipBlock(image.blockFormat, dstRow + size_t(x) * size_t(blockSize), numRowsInBlock);
+        }
+    }
+}
+
+bool flipImageVertically(QImageData &image)
+{
+    if(!canFlipImageVertically(image)) {
+        qCWarning(logImport) << "Cannot flip image: block format does not allow flipping image without decoding it";
+        return false;
+    }
+    if(image.sizeInBytes() < image.expectedSizeInBytes()) {
+        qCWarning(logImport) << "Cannot flip image: incomplete image data";
+        return false;
+    }
+
+    QImageData result = image;
+    const quint64 resultSize = result.expectedSizeInBytes();
+    uchar *pixels = new (std::nothrow) uchar[resultSize];
+    if(!pixels) {
+        qCWarning(logImport) << "Cannot flip image: failed to allocate memory for flipped image";
+        return false;
+    }
+    result.data.clear();
+    result.storage = QDataStorage::fromRawData(pixels, resultSize, [pixels]() {
+        delete[] pixels;
+    });
+
+    for(int level=0; level<image.mipLevels; ++level) {
+        flipMipLevelVertically(image, level, image.constMipBits(level), pixels + image.mipLevelOffset(level));
+    }
+
+    image = result;
+    return true;
+}
+
+bool generateMipmaps(QImageData &image, MipmapFilter filter)
+{
+    if(image.isCompressed()) {
+        qCWarning(logImport) << "Cannot generate mipmaps: image is block compressed";
+        return false;
+    }
+    if(image.width <= 0 || image.height <= 0 || image.channels <= 0 || image.channels > 4) {
+        qCWarning(logImport) << "Cannot generate mipmaps: invalid image dimensions or number of channels";
+        return false;
+    }
+    if(image.type == QImageData::ValueType::Undefined || image.sizeInBytes() < image.mipLevelSize(0)) {
+        qCWarning(logImport) << "Cannot generate mipmaps: unsupported or incomplete image data";
+        return false;
+    }
+
+    QImageData result = image;
+    result.mipLevels = QImageData::maxMipLevels(image.width, image.height);
+
+    const quint64 resultSize = result.expectedSizeInBytes();
+    uchar *pixels = new (std::nothrow) uchar[resultSize];
+    if(!pixels) {
+        qCWarning(logImport) << "Cannot generate mipmaps: failed to allocate memory for mip chain";
+        return false;
+    }
+    result.data.clear();
+    result.storage = QDataStorage::fromRawData(pixels, resultSize, [pixels]() {
+        delete[] pixels;
+    });
+
+    // Assume sRGB colorspace for RGB & RGBA LDR formats, same as renderers do.
+    const bool sRGB = (image.type == QImageData::ValueType::UInt8 && image.channels >= 3);
+
+    std::memcpy(pixels, image.constBits(), image.mipLevelSize(0));
+    for(int level=1; level<result.mipLevels; ++level) {
+        downsampleLevel(result, level, filter, sRGB, pixels + result.mipLevelOffset(level - 1), pixels + result.mipLevelOffset(level));
+    }
+
+    image = result;
+    return true;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qimagedata.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+enum class MipmapFilter {
+    Box,
+    Kaiser,
+};
+
+// Replaces mip levels of an image with a full mip chain downsampled from its first level.
+// Filtering is done in linear space: color channels of 8-bit RGB & RGBA images are assumed to be sRGB encoded.
+// Image edges wrap around, same as texture addressing mode used by renderers.
+bool generateMipmaps(QImageData &image, MipmapFilter filter = MipmapFilter::Kaiser);
+
+// Returns true if all mip levels of an image can be flipped vertically without decoding texels.
+// Block compressed images are flipped by reordering rows of blocks and rows of texels within each block,
+// which is possible for BC1-BC5 formats only and as long as every mip level is made of whole blocks vertically.
+bool canFlipImageVertically(const QImageData &image);
+
+// Copies pixel data of a mip level from src to dst flipping it vertically.
+void flipMipLevelVertically(const QImageData &image, int level, const uchar *src, uchar *dst);
+
+// Flips all mip levels of an image vertically, as needed for images stored with top-left origin.
+bool flipImageVertically(QImageData &image);
+
+} // Raytrace
+} // Qt3DRaytrace
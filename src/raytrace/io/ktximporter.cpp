@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/ktximporter_p.h>
+#include <io/blockcompression_p.h>
+#include <io/imageprocessing_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+#include <new>
+#include <vector>
+
+#ifdef QUARTZ_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace {
+
+using ValueType = QImageData::ValueType;
+using Format = QImageData::Format;
+using BlockFormat = QImageData::BlockFormat;
+
+constexpr uchar Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+constexpr quint64 HeaderSize = 80;
+constexpr quint64 LevelIndexEntrySize = 24;
+
+// Offsets of header and index fields.
+enum HeaderField {
+    HeaderField_VkFormat = 12,
+    HeaderField_PixelWidth = 20,
+    HeaderField_PixelHeight = 24,
+    HeaderField_PixelDepth = 28,
+    HeaderField_LayerCount = 32,
+    HeaderField_FaceCount = 36,
+    HeaderField_LevelCount = 40,
+    HeaderField_SupercompressionScheme = 44,
+    HeaderField_KvdByteOffset = 56,
+    HeaderField_KvdByteLength = 60,
+};
+
+enum SupercompressionScheme : quint32 {
+    SupercompressionNone = 0,
+    SupercompressionBasisLZ = 1,
+    SupercompressionZstandard = 2,
+    SupercompressionZLIB = 3,
+};
+
+struct PixelFormat
+{
+    quint32 vkFormat;
+    ValueType type;
+    int channels;
+    Format format;
+    BlockFormat blockFormat;
+};
+
+// Both UNORM and SRGB variants of 8-bit color formats map to the same image format since renderers assume sRGB colorspace anyway.
+constexpr PixelFormat VkFormats[] = {
+    {   9, ValueType::UInt8,   1, Format::Undefined, BlockFormat::None }, // R8_UNORM
+    {  16, ValueType::UInt8,   2, Format::Undefined, BlockFormat::None }, // R8G8_UNORM
+    {  23, ValueType::UInt8,   3, Format::RGB,       BlockFormat::None }, // R8G8B8_UNORM
+    {  29, ValueType::UInt8,   3, Format::RGB,       BlockFormat::None }, // R8G8B8_SRGB
+    {  30, ValueType::UInt8,   3, Format::BGR,       BlockFormat::None }, // B8G8R8_UNORM
+    {  36, ValueType::UInt8,   3, Format::BGR,       BlockFormat::None }, // B8G8R8_SRGB
+    {  37, ValueType::UInt8,   4, Format::RGBA,      BlockFormat::None }, // R8G8B8A8_UNORM
+    {  43, ValueType::UInt8,   4, Format::RGBA,      BlockFormat::None }, // R8G8B8A8_SRGB
+    {  44, ValueType::UInt8,   4, Format::BGRA,      BlockFormat::None }, // B8G8R8A8_UNORM
+    {  50, ValueType::UInt8,   4, Format::BGRA,      BlockFormat::None }, // B8G8R8A8_SRGB
+    {  76, ValueType::Float16, 1, Format::Undefined, BlockFormat::None }, // R16_SFLOAT
+    {  83, ValueType::Float16, 2, Format::Undefined, BlockFormat::None }, // R16G16_SFLOAT
+    {  90, ValueType::Float16, 3, Format::RGB,       BlockFormat::None }, // R16G16B16_SFLOAT
+    {  97, ValueType::Float16, 4, Format::RGBA,      BlockFormat::None }, // R16G16B16A16_SFLOAT
+    { 100, ValueType::Float32, 1, Format::Undefined, BlockFormat::None }, // R32_SFLOAT
+    { 103, ValueType::Float32, 2, Format::Undefined, BlockFormat::None }, // R32G32_SFLOAT
+    { 106, ValueType::Float32, 3, Format::RGB,       BlockFormat::None }, // R32G32B32_SFLOAT
+    { 109, ValueType::Float32, 4, Format::RGBA,      BlockFormat::None }, // R32G32B32A32_SFLOAT
+    { 131, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC1 }, // BC1_RGB_UNORM_BLOCK
+    { 132, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC1 }, // BC1_RGB_SRGB_BLOCK
+    { 133, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC1 }, // BC1_RGBA_UNORM_BLOCK
+    { 134, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC1 }, // BC1_RGBA_SRGB_BLOCK
+    { 135, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC2 }, // BC2_UNORM_BLOCK
+    { 136, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC2 }, // BC2_SRGB_BLOCK
+    { 137, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC3 }, // BC3_UNORM_BLOCK
+    { 138, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC3 }, // BC3_SRGB_BLOCK
+    { 139, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC4 }, // BC4_UNORM_BLOCK
+    { 141, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC5 }, // BC5_UNORM_BLOCK
+    { 143, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC6H }, // BC6H_UFLOAT_BLOCK
+    { 145, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC7 }, // BC7_UNORM_BLOCK
+    { 146, ValueType::Undefined, 0, Format::Undefined, BlockFormat::BC7 }, // BC7_SRGB_BLOCK
+};
+
+struct Level
+{
+    quint64 byteOffset;
+    quint64 byteLength;
+    quint64 uncompressedByteLength;
+};
+
+struct TextureInfo
+{
+    QImageData image;
+    quint32 supercompressionScheme = SupercompressionNone;
+    bool isBottomUp = false;
+    QVector<Level> levels;
+};
+
+inline quint32 readUInt32(const uchar *data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(quint32));
+    return qFromLittleEndian(value);
+}
+
+inline quint64 readUInt64(const uchar *data)
+{
+    quint64 value;
+    std::memcpy(&value, data, sizeof(quint64));
+    return qFromLittleEndian(value);
+}
+
+bool getPixelFormat(quint32 vkFormat, QImageData &image)
+{
+    for(const PixelFormat &pixelFormat : VkFormats) {
+        if(pixelFormat.vkFormat == vkFormat) {
+            if(pixelFormat.blockFormat != BlockFormat::None) {
+                setBlockFormat(image, pixelFormat.blockFormat);
+            }
+            else {
+                image.type = pixelFormat.type;
+                image.channels = pixelFormat.channels;
+                image.format = pixelFormat.format;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Images are stored with top-left origin unless KTXorientation metadata specifies rows going up.
+bool isStoredBottomUp(const uchar *keyValueData, quint64 keyValueDataLength)
+{
+    static const QByteArray OrientationKey = QByteArrayLiteral("KTXorientation");
+
+    quint64 offset = 0;
+    while(offset + sizeof(quint32) <= keyValueDataLength) {
+        const quint32 length = readUInt32(keyValueData + offset);
+        offset += sizeof(quint32);
+        if(length > keyValueDataLength - offset) {
+            break;
+        }
+        const char *keyAndValue = reinterpret_cast<const char*>(keyValueData + offset);
+        const uint keyLength = qstrnlen(keyAndValue, length);
+        if(OrientationKey == QByteArray::fromRawData(keyAndValue, int(keyLength)) && keyLength + 2 < length) {
+            return keyAndValue[keyLength + 2] == 'u';
+        }
+        offset += (quint64(length) + 3) & ~quint64(3);
+    }
+    return false;
+}
+
+bool readHeader(const uchar *fileData, quint64 fileSize, TextureInfo &info)
+{
+    if(fileSize < HeaderSize || std::memcmp(fileData, Identifier, sizeof(Identifier)) != 0) {
+        qCCritical(logImport) << "Invalid KTX2 file header";
+        return false;
+    }
+
+    const quint32 vkFormat = readUInt32(fileData + HeaderField_VkFormat);
+    const quint32 width = readUInt32(fileData + HeaderField_PixelWidth);
+    const quint32 height = readUInt32(fileData + HeaderField_PixelHeight);
+    const quint32 levelCount = readUInt32(fileData + HeaderField_LevelCount);
+    info.supercompressionScheme = readUInt32(fileData + HeaderField_SupercompressionScheme);
+
+    if(width == 0 || width > 65536 || height == 0 || height > 65536) {
+        qCCritical(logImport) << "Invalid or unsupported KTX2 image dimensions:" << width << "x" << height;
+        return false;
+    }
+    if(readUInt32(fileData + HeaderField_PixelDepth) > 0 || readUInt32(fileData + HeaderField_LayerCount) > 1 || readUInt32(fileData + HeaderField_FaceCount) != 1) {
+        qCCritical(logImport) << "Unsupported KTX2 texture type: only 2D textures are supported";
+        return false;
+    }
+
+    switch(info.supercompressionScheme) {
+    case SupercompressionNone:
+    case SupercompressionZLIB:
+        break;
+#ifdef QUARTZ_HAVE_ZSTD
+    case SupercompressionZstandard:
+        break;
+#endif
+    default:
+        qCCritical(logImport) << "Unsupported KTX2 supercompression scheme:" << info.supercompressionScheme;
+        return false;
+    }
+
+    QImageData &image = info.image;
+    if(!getPixelFormat(vkFormat, image)) {
+        qCCritical(logImport) << "Unsupported KTX2 pixel format: Vulkan format" << vkFormat;
+        return false;
+    }
+    image.width = int(width);
+    image.height = int(height);
+    // Level count of zero requests mip chain to be generated at load time.
+    image.mipLevels = int(qMax(levelCount, 1u));
+    if(image.mipLevels > QImageData::maxMipLevels(image.width, image.height)) {
+        qCCritical(logImport) << "Invalid number of KTX2 mip levels:" << levelCount;
+        return false;
+    }
+
+    if(HeaderSize + quint64(image.mipLevels) * LevelIndexEntrySize > fileSize) {
+        qCCritical(logImport) << "Invalid KTX2 level index";
+        return false;
+    }
+    info.levels.resize(image.mipLevels);
+    for(int level=0; level<image.mipLevels; ++level) {
+        const uchar *entry = fileData + HeaderSize + quint64(level) * LevelIndexEntrySize;
+        Level &levelInfo = info.levels[level];
+        levelInfo.byteOffset = readUInt64(entry);
+        levelInfo.byteLength = readUInt64(entry + 8);
+        levelInfo.uncompressedByteLength = readUInt64(entry + 16);
+
+        const quint64 levelSize = image.mipLevelSize(level);
+        const bool isValidLevel =
+                levelInfo.byteOffset <= fileSize && levelInfo.byteLength <= fileSize - levelInfo.byteOffset &&
+                levelInfo.uncompressedByteLength == levelSize &&
+                (info.supercompressionScheme != SupercompressionNone || levelInfo.byteLength == levelSize);
+        if(!isValidLevel) {
+            qCCritical(logImport) << "Invalid KTX2 level index entry for mip level" << level;
+            return false;
+        }
+    }
+
+    const quint32 keyValueDataOffset = readUInt32(fileData + HeaderField_KvdByteOffset);
+    const quint32 keyValueDataLength = readUInt32(fileData + HeaderField_KvdByteLength);
+    if(keyValueDataLength > 0 && quint64(keyValueDataOffset) + keyValueDataLength <= fileSize) {
+        info.isBottomUp = isStoredBottomUp(fileData + keyValueDataOffset, keyValueDataLength);
+    }
+    return true;
+}
+
+bool inflateLevel(quint32 supercompressionScheme, const uchar *input, quint64 inputSize, uchar *output, quint64 outputSize)
+{
+    switch(supercompressionScheme) {
+#ifdef QUARTZ_HAVE_ZSTD
+    case SupercompressionZstandard: {
+        const size_t result = ZSTD_decompress(output, size_t(outputSize), input, size_t(inputSize));
+        return !ZSTD_isError(result) && result == outputSize;
+    }
+#endif
+    case SupercompressionZLIB: {
+        // qUncompress() expects zlib stream to be prefixed with big endian uncompressed size.
+        const quint64 maxSize = quint64(std::numeric_limits<int>::max()) - sizeof(quint32);
+        if(inputSize > maxSize || outputSize > maxSize) {
+            return false;
+        }
+        QByteArray compressedBytes(int(inputSize + sizeof(quint32)), Qt::Uninitialized);
+        qToBigEndian(quint32(outputSize), compressedBytes.data());
+        std::memcpy(compressedBytes.data() + sizeof(quint32), input, size_t(inputSize));
+
+        const QByteArray uncompressedBytes = qUncompress(compressedBytes);
+        if(quint64(uncompressedBytes.size()) != outputSize) {
+            return false;
+        }
+        std::memcpy(output, uncompressedBytes.constData(), size_t(outputSize));
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool copyLevels(const TextureInfo &info, const uchar *fileData, QImageData &image, bool flip)
+{
+    using Utility::parallelFor;
+
+    const quint64 imageSize = image.expectedSizeInBytes();
+    uchar *pixels = new (std::nothrow) uchar[imageSize];
+    if(!pixels) {
+        qCCritical(logImport) << "Failed to allocate memory for texture image";
+        return false;
+    }
+    image.data.clear();
+    image.storage = QDataStorage::fromRawData(pixels, imageSize, [pixels]() {
+        delete[] pixels;
+    });
+
+    // Levels are stored smallest first in KTX2 files, hence each one is copied to its place in the mip chain.
+    QAtomicInt failedLevels(0);
+    parallelFor(0, image.mipLevels, 1, [&](int begin, int end) {
+        std::vector<uchar> inflatedLevel;
+        for(int level=begin; level<end; ++level) {
+            const Level &levelInfo = info.levels[level];
+            const quint64 levelSize = image.mipLevelSize(level);
+            const uchar *levelData = fileData + levelInfo.byteOffset;
+            uchar *output = pixels + image.mipLevelOffset(level);
+
+            if(info.supercompressionScheme != SupercompressionNone) {
+                uchar *inflatedOutput = output;
+                if(flip) {
+                    inflatedLevel.resize(size_t(levelSize));
+                    inflatedOutput = inflatedLevel.data();
+                }
+                if(!inflateLevel(info.supercompressionScheme, levelData, levelInfo.byteLength, inflatedOutput, levelSize)) {
+                    failedLevels.ref();
+                    continue;
+                }
+                levelData = inflatedOutput;
+            }
+
+            if(flip) {
+                flipMipLevelVertically(image, level, levelData, output);
+            }
+            else if(levelData != output) {
+                std::memcpy(output, levelData, size_t(levelSize));
+            }
+        }
+    });
+
+    if(failedLevels.load() > 0) {
+        qCCritical(logImport) << "Failed to inflate supercompressed KTX2 mip levels";
+        return false;
+    }
+    return true;
+}
+
+} // anonymous
+
+bool KtxImageImporter::isSupported(const QUrl &url)
+{
+    return QFileInfo(url.path()).suffix().compare(QStringLiteral("ktx2"), Qt::CaseInsensitive) == 0;
+}
+
+bool KtxImageImporter::import(const QUrl &url, QImageData &data)
+{
+    const QString path = getAssetPathFromUrl(url);
+    QFile imageFile(path);
+    if(!imageFile.open(QFile::ReadOnly)) {
+        qCCritical(logImport) << "Cannot open image file:" << url.toString();
+        return false;
+    }
+
+    qCInfo(logImport) << "Loading texture image:" << url.toString();
+
+    QByteArray fileBytes;
+    quint64 fileSize = quint64(imageFile.size());
+    uchar *mappedData = (fileSize > 0) ? imageFile.map(0, qint64(fileSize)) : nullptr;
+    const uchar *fileData = mappedData;
+    if(!fileData) {
+        fileBytes = imageFile.readAll();
+        fileData = reinterpret_cast<const uchar*>(fileBytes.constData());
+        fileSize = quint64(fileBytes.size());
+    }
+
+    TextureInfo info;
+    bool result = readHeader(fileData, fileSize, info);
+    if(result) {
+        QImageData &image = info.image;
+
+        // Renderers expect images with bottom-left origin, same as produced by other importers.
+        const bool flip = !info.isBottomUp && canFlipImageVertically(image);
+        if(!info.isBottomUp && !flip) {
+            qCWarning(logImport) << "Image in this block format cannot be flipped without decoding, texture will appear upside down:" << url.toString();
+        }
+
+        const bool canMapLevel = !flip && image.mipLevels == 1 && info.supercompressionScheme == SupercompressionNone;
+        if(canMapLevel) {
+            image.storage = QDataStorage::fromFile(path, info.levels[0].byteOffset, info.levels[0].byteLength);
+        }
+        if(!image.storage) {
+            result = copyLevels(info, fileData, image, flip);
+        }
+    }
+    if(mappedData) {
+        imageFile.unmap(mappedData);
+    }
+
+    if(!result) {
+        qCCritical(logImport) << "Failed to import KTX2 file:" << url.toString();
+        return false;
+    }
+    data = info.image;
+    return true;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
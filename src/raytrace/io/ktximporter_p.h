@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+#include <io/imageimporter_p.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Importer of KTX 2.0 (.ktx2) texture files.
+// Supports 2D textures with mip levels in uncompressed 8-bit, 16-bit and 32-bit floating point formats and in BC1-BC7
+// block compressed formats. Mip levels may be supercompressed with zlib or Zstandard (if built with zstd library);
+// supercompressed levels are inflated in parallel. Single level textures without supercompression are memory mapped.
+class KtxImageImporter final : public ImageImporter
+{
+public:
+    bool import(const QUrl &url, QImageData &data) override;
+
+    static bool isSupported(const QUrl &url);
+};
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,359 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/meshcache_p.h>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QMutexLocker>
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+// Must be incremented whenever entry layout or mesh import post-processing changes.
+static constexpr quint32 FormatVersion = 1;
+static constexpr qint64 DefaultMaximumSizeMB = 2048;
+static constexpr qint64 PageSize = 4096;
+
+static const char *EnableEnvironmentVariable = "QUARTZ_MESH_CACHE";
+static const char *DirectoryEnvironmentVariable = "QUARTZ_MESH_CACHE_DIR";
+static const char *SizeEnvironmentVariable = "QUARTZ_MESH_CACHE_SIZE";
+
+} // Config
+
+namespace {
+
+constexpr char EntryMagic[8] = { 'Q', 'Z', 'M', 'E', 'S', 'H', '\r', '\n' };
+constexpr quint32 ByteOrderMark = 0x01020304u;
+
+struct EntryHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrderMark;
+    quint32 vertexSize;
+    quint32 triangleSize;
+    quint32 importFlags;
+    quint32 reserved;
+    quint64 sourcePathHash;
+    quint64 sourceSize;
+    qint64 sourceModifiedTime;
+    quint64 numVertices;
+    quint64 numFaces;
+    quint64 verticesOffset;
+    quint64 facesOffset;
+    quint64 fileSize;
+    quint64 verticesChecksum;
+    quint64 facesChecksum;
+    quint64 headerChecksum;
+};
+
+static_assert(std::is_trivially_copyable<QVertex>::value, "QVertex must be trivially copyable");
+static_assert(std::is_trivially_copyable<QTriangle>::value, "QTriangle must be trivially copyable");
+static_assert(sizeof(EntryHeader) <= Config::PageSize, "Mesh cache entry header must fit in a single page");
+
+inline quint64 alignToPage(quint64 offset)
+{
+    return (offset + Config::PageSize - 1) & ~quint64(Config::PageSize - 1);
+}
+
+inline quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 headerChecksum(const EntryHeader &header)
+{
+    return MeshCache::computeChecksum(&header, qint64(offsetof(EntryHeader, headerChecksum)));
+}
+
+} // anonymous
+
+Q_GLOBAL_STATIC(MeshCache, meshCacheInstance)
+
+MeshCache::MeshCache()
+    : m_maximumSize(Config::DefaultMaximumSizeMB * 1024 * 1024)
+{
+    if(qEnvironmentVariableIsSet(Config::EnableEnvironmentVariable) && qEnvironmentVariableIntValue(Config::EnableEnvironmentVariable) == 0) {
+        return;
+    }
+
+    bool sizeIsValid = false;
+    const int maximumSizeMB = qEnvironmentVariableIntValue(Config::SizeEnvironmentVariable, &sizeIsValid);
+    if(sizeIsValid && maximumSizeMB > 0) {
+        m_maximumSize = qint64(maximumSizeMB) * 1024 * 1024;
+    }
+
+    QString cacheDirectory = QString::fromLocal8Bit(qgetenv(Config::DirectoryEnvironmentVariable));
+    if(cacheDirectory.isEmpty()) {
+        const QString genericCacheLocation = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+        if(genericCacheLocation.isEmpty()) {
+            return;
+        }
+        cacheDirectory = genericCacheLocation + QStringLiteral("/quartz/meshes");
+    }
+    if(!QDir().mkpath(cacheDirectory)) {
+        qCWarning(logImport) << "Cannot create mesh cache directory:" << cacheDirectory;
+        return;
+    }
+    m_cacheDirectory = QDir(cacheDirectory).absolutePath();
+}
+
+MeshCache *MeshCache::instance()
+{
+    return meshCacheInstance();
+}
+
+bool MeshCache::makeKey(const QString &sourcePath, quint32 importFlags, Key &key) const
+{
+    // Embedded resources are already in memory and are not worth caching.
+    if(sourcePath.startsWith(QLatin1Char(':'))) {
+        return false;
+    }
+
+    const QFileInfo sourceInfo(sourcePath);
+    if(!sourceInfo.isFile()) {
+        return false;
+    }
+
+    const QByteArray absoluteSourcePath = sourceInfo.absoluteFilePath().toUtf8();
+    key.sourcePathHash = computeChecksum(absoluteSourcePath.constData(), absoluteSourcePath.size());
+    key.sourceSize = quint64(sourceInfo.size());
+    key.sourceModifiedTime = sourceInfo.lastModified().toMSecsSinceEpoch();
+    key.importFlags = importFlags;
+
+    const quint64 keyFields[] = { key.sourcePathHash, key.sourceSize, quint64(key.sourceModifiedTime), key.importFlags, Config::FormatVersion };
+    const quint64 keyHash = computeChecksum(keyFields, qint64(sizeof(keyFields)));
+    key.entryPath = QStringLiteral("%1/%2.qmc").arg(m_cacheDirectory).arg(keyHash, 16, 16, QLatin1Char('0'));
+    return true;
+}
+
+bool MeshCache::load(const QString &sourcePath, quint32 importFlags, QGeometryData &data)
+{
+    Key key;
+    if(!isEnabled() || !makeKey(sourcePath, importFlags, key)) {
+        return false;
+    }
+
+    QFile entryFile(key.entryPath);
+    if(!entryFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 entrySize = entryFile.size();
+    if(entrySize < qint64(sizeof(EntryHeader))) {
+        qCWarning(logImport) << "Removing truncated mesh cache entry:" << key.entryPath;
+        entryFile.remove();
+        return false;
+    }
+
+    const uchar *entryData = entryFile.map(0, entrySize);
+    if(!entryData) {
+        return false;
+    }
+
+    EntryHeader header;
+    std::memcpy(&header, entryData, sizeof(EntryHeader));
+
+    const bool isCompatible =
+            std::memcmp(header.magic, EntryMagic, sizeof(EntryMagic)) == 0 &&
+            header.version == Config::FormatVersion &&
+            header.byteOrderMark == ByteOrderMark &&
+            header.vertexSize == sizeof(QVertex) &&
+            header.triangleSize == sizeof(QTriangle) &&
+            header.headerChecksum == headerChecksum(header);
+
+    const bool isMatchingSource =
+            header.importFlags == key.importFlags &&
+            header.sourcePathHash == key.sourcePathHash &&
+            header.sourceSize == key.sourceSize &&
+            header.sourceModifiedTime == key.sourceModifiedTime;
+
+    const quint64 verticesSize = header.numVertices * sizeof(QVertex);
+    const quint64 facesSize = header.numFaces * sizeof(QTriangle);
+    const bool isWellFormed =
+            header.fileSize == quint64(entrySize) &&
+            header.numVertices <= quint64(entrySize) / sizeof(QVertex) &&
+            header.numFaces <= quint64(entrySize) / sizeof(QTriangle) &&
+            header.verticesOffset >= sizeof(EntryHeader) &&
+            header.verticesOffset + verticesSize <= header.facesOffset &&
+            header.facesOffset + facesSize <= header.fileSize;
+
+    bool isValid = isCompatible && isMatchingSource && isWellFormed;
+    if(isValid) {
+        isValid = computeChecksum(entryData + header.verticesOffset, qint64(verticesSize)) == header.verticesChecksum &&
+                  computeChecksum(entryData + header.facesOffset, qint64(facesSize)) == header.facesChecksum;
+    }
+
+    entryFile.unmap(const_cast<uchar*>(entryData));
+    entryFile.close();
+
+    if(isValid) {
+        // Vertex and face arrays are mapped directly from the entry file instead of being copied.
+        // Mappings stay valid if the entry is later evicted or replaced since entries are never modified in place.
+        data = QGeometryData();
+        if(verticesSize > 0) {
+            data.vertexStorage = QDataStorage::fromFile(key.entryPath, header.verticesOffset, verticesSize);
+        }
+        if(facesSize > 0) {
+            data.faceStorage = QDataStorage::fromFile(key.entryPath, header.facesOffset, facesSize);
+        }
+        isValid = (verticesSize == 0 || data.vertexStorage) && (facesSize == 0 || data.faceStorage);
+        if(!isValid) {
+            data = QGeometryData();
+            return false;
+        }
+    }
+
+    if(!isValid) {
+        if(isCompatible && isMatchingSource) {
+            qCWarning(logImport) << "Removing corrupted mesh cache entry:" << key.entryPath;
+        }
+        QFile::remove(key.entryPath);
+        return false;
+    }
+
+    // Modification time of cache entries tracks their last use for LRU eviction.
+    QFile touchFile(key.entryPath);
+    if(touchFile.open(QFile::Append)) {
+        touchFile.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    }
+    return true;
+}
+
+bool MeshCache::store(const QString &sourcePath, quint32 importFlags, const QGeometryData &data)
+{
+    Key key;
+    if(!isEnabled() || !makeKey(sourcePath, importFlags, key)) {
+        return false;
+    }
+
+    const quint64 verticesSize = data.numVertices() * sizeof(QVertex);
+    const quint64 facesSize = data.numFaces() * sizeof(QTriangle);
+
+    EntryHeader header = {};
+    std::memcpy(header.magic, EntryMagic, sizeof(EntryMagic));
+    header.version = Config::FormatVersion;
+    header.byteOrderMark = ByteOrderMark;
+    header.vertexSize = sizeof(QVertex);
+    header.triangleSize = sizeof(QTriangle);
+    header.importFlags = key.importFlags;
+    header.sourcePathHash = key.sourcePathHash;
+    header.sourceSize = key.sourceSize;
+    header.sourceModifiedTime = key.sourceModifiedTime;
+    header.numVertices = data.numVertices();
+    header.numFaces = data.numFaces();
+    header.verticesOffset = alignToPage(sizeof(EntryHeader));
+    header.facesOffset = alignToPage(header.verticesOffset + verticesSize);
+    header.fileSize = header.facesOffset + facesSize;
+    header.verticesChecksum = computeChecksum(data.vertexData(), qint64(verticesSize));
+    header.facesChecksum = computeChecksum(data.faceData(), qint64(facesSize));
+    header.headerChecksum = headerChecksum(header);
+
+    if(qint64(header.fileSize) > m_maximumSize) {
+        return false;
+    }
+    evictEntries(qint64(header.fileSize));
+
+    // Entries are written to a temporary file and atomically renamed so that readers never observe partial writes.
+    QSaveFile entryFile(key.entryPath);
+    if(!entryFile.open(QFile::WriteOnly)) {
+        qCWarning(logImport) << "Cannot create mesh cache entry:" << key.entryPath;
+        return false;
+    }
+
+    QByteArray headerPage(int(header.verticesOffset), '\0');
+    std::memcpy(headerPage.data(), &header, sizeof(EntryHeader));
+    entryFile.write(headerPage);
+    entryFile.write(reinterpret_cast<const char*>(data.vertexData()), qint64(verticesSize));
+    entryFile.write(QByteArray(int(header.facesOffset - header.verticesOffset - verticesSize), '\0'));
+    entryFile.write(reinterpret_cast<const char*>(data.faceData()), qint64(facesSize));
+
+    if(!entryFile.commit()) {
+        qCWarning(logImport) << "Cannot write mesh cache entry:" << key.entryPath << entryFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+void MeshCache::evictEntries(qint64 reservedSize)
+{
+    QMutexLocker lock(&m_evictionMutex);
+
+    const QDir cacheDirectory(m_cacheDirectory);
+    const QFileInfoList entries = cacheDirectory.entryInfoList({ QStringLiteral("*.qmc") }, QDir::Files, QDir::Time | QDir::Reversed);
+
+    qint64 totalSize = reservedSize;
+    for(const QFileInfo &entry : entries) {
+        totalSize += entry.size();
+    }
+    for(const QFileInfo &entry : entries) {
+        if(totalSize <= m_maximumSize) {
+            break;
+        }
+        if(QFile::remove(entry.absoluteFilePath())) {
+            totalSize -= entry.size();
+        }
+    }
+}
+
+quint64 MeshCache::computeChecksum(const void *data, qint64 size)
+{
+    // Non-cryptographic 64-bit hash over four independent lanes; only used to detect corrupted entries.
+    constexpr quint64 Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr quint64 Prime2 = 0xC2B2AE3D27D4EB4Full;
+    auto mix = [](quint64 hash, quint64 value) -> quint64 {
+        hash ^= value * Prime2;
+        return rotateLeft(hash, 31) * Prime1;
+    };
+
+    const uchar *bytes = static_cast<const uchar*>(data);
+    quint64 lanes[4] = { Prime1, Prime2, ~Prime1, ~Prime2 };
+
+    qint64 offset = 0;
+    for(; offset + 32 <= size; offset += 32) {
+        quint64 words[4];
+        std::memcpy(words, bytes + offset, sizeof(words));
+        lanes[0] = mix(lanes[0], words[0]);
+        lanes[1] = mix(lanes[1], words[1]);
+        lanes[2] = mix(lanes[2], words[2]);
+        lanes[3] = mix(lanes[3], words[3]);
+    }
+
+    quint64 hash = quint64(size) * Prime1;
+    for(quint64 lane : lanes) {
+        hash = mix(hash, lane);
+    }
+    for(; offset + 8 <= size; offset += 8) {
+        quint64 word;
+        std::memcpy(&word, bytes + offset, sizeof(word));
+        hash = mix(hash, word);
+    }
+    for(; offset < size; ++offset) {
+        hash = mix(hash, bytes[offset]);
+    }
+
+    hash ^= hash >> 33;
+    hash *= Prime2;
+    hash ^= hash >> 29;
+    hash *= Prime1;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qgeometrydata.h>
+
+#include <QString>
+#include <QMutex>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// On-disk cache of imported meshes.
+// Entries are keyed by source file path, size, modification time and importer flags, and store final
+// vertex and triangle arrays in a page-aligned binary layout that is memory mapped and used directly as geometry storage on load.
+// Least recently used entries are evicted once total cache size exceeds the configured limit.
+//
+// Cache is configured through environment variables:
+//   QUARTZ_MESH_CACHE       Set to 0 to disable the cache.
+//   QUARTZ_MESH_CACHE_DIR   Cache directory (defaults to "quartz/meshes" in generic cache location).
+//   QUARTZ_MESH_CACHE_SIZE  Maximum cache size in megabytes.
+class MeshCache
+{
+public:
+    MeshCache();
+
+    static MeshCache *instance();
+
+    bool isEnabled() const { return !m_cacheDirectory.isEmpty(); }
+
+    bool load(const QString &sourcePath, quint32 importFlags, QGeometryData &data);
+    bool store(const QString &sourcePath, quint32 importFlags, const QGeometryData &data);
+
+    static quint64 computeChecksum(const void *data, qint64 size);
+
+private:
+    struct Key {
+        QString entryPath;
+        quint64 sourcePathHash;
+        quint64 sourceSize;
+        qint64 sourceModifiedTime;
+        quint32 importFlags;
+    };
+    bool makeKey(const QString &sourcePath, quint32 importFlags, Key &key) const;
+    void evictEntries(qint64 reservedSize);
+
+    QString m_cacheDirectory;
+    qint64 m_maximumSize;
+    QMutex m_evictionMutex;
+};
+
+} // Raytrace
+} // Qt3DRaytrace
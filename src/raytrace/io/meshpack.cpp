@@ -0,0 +1,456 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/meshpack_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QAtomicInt>
+#include <QIODevice>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr quint32 FormatVersion = 1;
+static constexpr quint32 VerticesPerChunk = 64 * 1024;
+static constexpr quint32 FacesPerChunk = 64 * 1024;
+static constexpr quint32 MaxElementsPerChunk = 1024 * 1024;
+static constexpr int CompressionLevel = 9;
+// Upper bound of zlib compression ratio, used to reject chunks claiming implausible uncompressed sizes.
+static constexpr quint64 MaxCompressionRatio = 1032;
+
+} // Config
+
+namespace {
+
+static constexpr char FileMagic[8] = { 'Q', 'Z', 'M', 'P', 'A', 'C', 'K', '\x1a' };
+static constexpr quint32 ByteOrderMark = 0x01020304u;
+
+// Position XYZ, normal UV, tangent UV, texcoord UV.
+static constexpr int NumVertexStreams = 9;
+static constexpr int VertexStreamSize = NumVertexStreams * sizeof(quint16);
+
+struct FileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrderMark;
+    quint64 numVertices;
+    quint64 numFaces;
+    quint32 verticesPerChunk;
+    quint32 facesPerChunk;
+    float positionOrigin[3];
+    float positionScale[3];
+    float texcoordOrigin[2];
+    float texcoordScale[2];
+};
+
+// Chunk table immediately follows file header: vertex chunks first, then face chunks.
+struct ChunkEntry
+{
+    quint64 offset;
+    quint32 compressedSize;
+    quint32 uncompressedSize;
+};
+
+static_assert(std::is_trivially_copyable<FileHeader>::value, "FileHeader must be trivially copyable");
+static_assert(std::is_trivially_copyable<ChunkEntry>::value, "ChunkEntry must be trivially copyable");
+static_assert(sizeof(QTriangle) == 3 * sizeof(quint32), "QTriangle must be tightly packed");
+
+struct ChunkLayout
+{
+    quint64 numVertexChunks;
+    quint64 numFaceChunks;
+};
+
+} // anonymous
+
+static ChunkLayout getChunkLayout(const FileHeader &header)
+{
+    return {
+        (header.numVertices + header.verticesPerChunk - 1) / header.verticesPerChunk,
+        (header.numFaces + header.facesPerChunk - 1) / header.facesPerChunk,
+    };
+}
+
+static inline quint16 quantizeUnorm(float value, float origin, float inverseScale)
+{
+    return quint16(qBound(0.0f, (value - origin) * inverseScale + 0.5f, 65535.0f));
+}
+
+static inline float dequantizeUnorm(quint16 value, float origin, float scale)
+{
+    return origin + float(value) * scale;
+}
+
+static inline quint16 quantizeSnorm(float value)
+{
+    return quint16(qint16(std::floor(qBound(-1.0f, value, 1.0f) * 32767.0f + 0.5f)));
+}
+
+static void encodeOctahedral(const QVector3D &v, quint16 &u, quint16 &w)
+{
+    const float sum = std::abs(v.x()) + std::abs(v.y()) + std::abs(v.z());
+    float x = 0.0f;
+    float y = 0.0f;
+    if(sum > 0.0f) {
+        x = v.x() / sum;
+        y = v.y() / sum;
+        if(v.z() < 0.0f) {
+            const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+    }
+    u = quantizeSnorm(x);
+    w = quantizeSnorm(y);
+}
+
+static inline QVector3D decodeOctahedral(quint16 u, quint16 w)
+{
+    float x = float(qint16(u)) * (1.0f / 32767.0f);
+    float y = float(qint16(w)) * (1.0f / 32767.0f);
+    const float z = 1.0f - std::abs(x) - std::abs(y);
+    const float t = qMax(-z, 0.0f);
+    x += (x >= 0.0f) ? -t : t;
+    y += (y >= 0.0f) ? -t : t;
+    const float inverseLength = 1.0f / std::sqrt(x*x + y*y + z*z);
+    return QVector3D(x * inverseLength, y * inverseLength, z * inverseLength);
+}
+
+static QByteArray encodeVertexChunk(const QVertex *vertices, int count, const FileHeader &header, quint32 &uncompressedSize)
+{
+    float positionInverseScale[3];
+    for(int i=0; i<3; ++i) {
+        positionInverseScale[i] = header.positionScale[i] > 0.0f ? 1.0f / header.positionScale[i] : 0.0f;
+    }
+    float texcoordInverseScale[2];
+    for(int i=0; i<2; ++i) {
+        texcoordInverseScale[i] = header.texcoordScale[i] > 0.0f ? 1.0f / header.texcoordScale[i] : 0.0f;
+    }
+
+    QVector<quint16> streams(count * NumVertexStreams);
+    quint16 *stream[NumVertexStreams];
+    for(int i=0; i<NumVertexStreams; ++i) {
+        stream[i] = streams.data() + i * count;
+    }
+    for(int i=0; i<count; ++i) {
+        const QVertex &vertex = vertices[i];
+        for(int j=0; j<3; ++j) {
+            stream[j][i] = quantizeUnorm(vertex.position[j], header.positionOrigin[j], positionInverseScale[j]);
+        }
+        encodeOctahedral(vertex.normal, stream[3][i], stream[4][i]);
+        encodeOctahedral(vertex.tangent, stream[5][i], stream[6][i]);
+        for(int j=0; j<2; ++j) {
+            stream[7+j][i] = quantizeUnorm(vertex.texcoord[j], header.texcoordOrigin[j], texcoordInverseScale[j]);
+        }
+    }
+
+    // Consecutive vertices tend to be spatially close so deltas are small and mostly leave high byte planes zero.
+    QByteArray payload(count * VertexStreamSize, Qt::Uninitialized);
+    uchar *planes = reinterpret_cast<uchar*>(payload.data());
+    for(int i=0; i<NumVertexStreams; ++i) {
+        uchar *lowPlane = planes + (2*i + 0) * count;
+        uchar *highPlane = planes + (2*i + 1) * count;
+        quint16 previous = 0;
+        for(int j=0; j<count; ++j) {
+            const quint16 delta = quint16(stream[i][j] - previous);
+            previous = stream[i][j];
+            lowPlane[j] = uchar(delta & 0xFF);
+            highPlane[j] = uchar(delta >> 8);
+        }
+    }
+    uncompressedSize = quint32(payload.size());
+    return qCompress(payload, Config::CompressionLevel);
+}
+
+static bool decodeVertexChunk(const QByteArray &payload, int count, const FileHeader &header, QVertex *vertices)
+{
+    if(payload.size() != count * VertexStreamSize) {
+        return false;
+    }
+
+    QVector<quint16> streams(count * NumVertexStreams);
+    const uchar *planes = reinterpret_cast<const uchar*>(payload.constData());
+    const quint16 *stream[NumVertexStreams];
+    for(int i=0; i<NumVertexStreams; ++i) {
+        const uchar *lowPlane = planes + (2*i + 0) * count;
+        const uchar *highPlane = planes + (2*i + 1) * count;
+        quint16 *values = streams.data() + i * count;
+        quint16 previous = 0;
+        for(int j=0; j<count; ++j) {
+            previous = quint16(previous + (quint16(lowPlane[j]) | quint16(highPlane[j] << 8)));
+            values[j] = previous;
+        }
+        stream[i] = values;
+    }
+
+    for(int i=0; i<count; ++i) {
+        QVertex &vertex = vertices[i];
+        vertex.position = QVector3D(
+            dequantizeUnorm(stream[0][i], header.positionOrigin[0], header.positionScale[0]),
+            dequantizeUnorm(stream[1][i], header.positionOrigin[1], header.positionScale[1]),
+            dequantizeUnorm(stream[2][i], header.positionOrigin[2], header.positionScale[2]));
+        vertex.normal = decodeOctahedral(stream[3][i], stream[4][i]);
+        vertex.tangent = decodeOctahedral(stream[5][i], stream[6][i]);
+        vertex.texcoord = QVector2D(
+            dequantizeUnorm(stream[7][i], header.texcoordOrigin[0], header.texcoordScale[0]),
+            dequantizeUnorm(stream[8][i], header.texcoordOrigin[1], header.texcoordScale[1]));
+    }
+    return true;
+}
+
+static QByteArray encodeFaceChunk(const QTriangle *faces, int count, quint32 &uncompressedSize)
+{
+    // Indices are delta coded against the previous index as zigzag LEB128 varints, up to 5 bytes each.
+    QByteArray payload(count * 3 * 5, Qt::Uninitialized);
+    uchar *output = reinterpret_cast<uchar*>(payload.data());
+    qint64 previous = 0;
+    for(int i=0; i<count; ++i) {
+        for(int j=0; j<3; ++j) {
+            const qint64 index = qint64(faces[i].vertices[j]);
+            const qint64 delta = index - previous;
+            previous = index;
+            quint64 value = (delta >= 0) ? (quint64(delta) << 1) : ((quint64(-delta) << 1) - 1);
+            while(value >= 0x80) {
+                *output++ = uchar(value | 0x80);
+                value >>= 7;
+            }
+            *output++ = uchar(value);
+        }
+    }
+    payload.resize(int(output - reinterpret_cast<uchar*>(payload.data())));
+    uncompressedSize = quint32(payload.size());
+    return qCompress(payload, Config::CompressionLevel);
+}
+
+static bool decodeFaceChunk(const QByteArray &payload, int count, quint64 numVertices, QTriangle *faces)
+{
+    const uchar *input = reinterpret_cast<const uchar*>(payload.constData());
+    const uchar *inputEnd = input + payload.size();
+    quint32 *indices = reinterpret_cast<quint32*>(faces);
+
+    qint64 previous = 0;
+    for(int i=0; i<count*3; ++i) {
+        quint64 value = 0;
+        for(int shift=0;; shift += 7) {
+            if(input == inputEnd || shift > 35) {
+                return false;
+            }
+            const uchar byte = *input++;
+            value |= quint64(byte & 0x7F) << shift;
+            if(!(byte & 0x80)) {
+                break;
+            }
+        }
+        const qint64 delta = (value & 1) ? -qint64(value >> 1) - 1 : qint64(value >> 1);
+        const qint64 index = previous + delta;
+        if(index < 0 || quint64(index) >= numVertices) {
+            return false;
+        }
+        indices[i] = quint32(index);
+        previous = index;
+    }
+    return input == inputEnd;
+}
+
+template<typename T>
+static T *allocateElements(QVector<T> &vector, QDataStoragePtr &storage, quint64 count)
+{
+    if(count <= quint64(std::numeric_limits<int>::max())) {
+        vector.resize(int(count));
+        return vector.data();
+    }
+    T *elements = new (std::nothrow) T[count];
+    if(elements) {
+        storage = QDataStorage::fromRawData(reinterpret_cast<const uchar*>(elements), count * sizeof(T), [elements]() {
+            delete[] elements;
+        });
+    }
+    return elements;
+}
+
+bool isMeshPack(const uchar *data, quint64 size)
+{
+    return size >= sizeof(FileHeader) && std::memcmp(data, FileMagic, sizeof(FileMagic)) == 0;
+}
+
+bool encodeMeshPack(const QGeometryData &data, QIODevice *device)
+{
+    Q_ASSERT(device);
+
+    const quint64 numVertices = data.numVertices();
+    const quint64 numFaces = data.numFaces();
+    const QVertex *vertices = data.vertexData();
+    const QTriangle *faces = data.faceData();
+
+    FileHeader header = {};
+    std::memcpy(header.magic, FileMagic, sizeof(FileMagic));
+    header.version = Config::FormatVersion;
+    header.byteOrderMark = ByteOrderMark;
+    header.numVertices = numVertices;
+    header.numFaces = numFaces;
+    header.verticesPerChunk = Config::VerticesPerChunk;
+    header.facesPerChunk = Config::FacesPerChunk;
+
+    if(numVertices > 0) {
+        QVector3D positionMin = vertices[0].position;
+        QVector3D positionMax = vertices[0].position;
+        QVector2D texcoordMin = vertices[0].texcoord;
+        QVector2D texcoordMax = vertices[0].texcoord;
+        for(quint64 i=1; i<numVertices; ++i) {
+            const QVertex &vertex = vertices[i];
+            for(int j=0; j<3; ++j) {
+                positionMin[j] = qMin(positionMin[j], vertex.position[j]);
+                positionMax[j] = qMax(positionMax[j], vertex.position[j]);
+            }
+            for(int j=0; j<2; ++j) {
+                texcoordMin[j] = qMin(texcoordMin[j], vertex.texcoord[j]);
+                texcoordMax[j] = qMax(texcoordMax[j], vertex.texcoord[j]);
+            }
+        }
+        for(int j=0; j<3; ++j) {
+            header.positionOrigin[j] = positionMin[j];
+            header.positionScale[j] = (positionMax[j] - positionMin[j]) / 65535.0f;
+        }
+        for(int j=0; j<2; ++j) {
+            header.texcoordOrigin[j] = texcoordMin[j];
+            header.texcoordScale[j] = (texcoordMax[j] - texcoordMin[j]) / 65535.0f;
+        }
+    }
+
+    const ChunkLayout layout = getChunkLayout(header);
+    const quint64 numChunks = layout.numVertexChunks + layout.numFaceChunks;
+    if(numChunks > quint64(std::numeric_limits<int>::max())) {
+        qCWarning(logImport) << "Mesh is too large to be stored in a mesh pack";
+        return false;
+    }
+
+    QVector<QByteArray> chunks(static_cast<int>(numChunks));
+    QVector<ChunkEntry> chunkTable(static_cast<int>(numChunks));
+    Utility::parallelFor(0, int(numChunks), 1, [&](int begin, int end) {
+        for(int chunkIndex=begin; chunkIndex<end; ++chunkIndex) {
+            if(quint64(chunkIndex) < layout.numVertexChunks) {
+                const quint64 first = quint64(chunkIndex) * header.verticesPerChunk;
+                const int count = int(qMin(quint64(header.verticesPerChunk), numVertices - first));
+                chunks[chunkIndex] = encodeVertexChunk(vertices + first, count, header, chunkTable[chunkIndex].uncompressedSize);
+            }
+            else {
+                const quint64 first = (quint64(chunkIndex) - layout.numVertexChunks) * header.facesPerChunk;
+                const int count = int(qMin(quint64(header.facesPerChunk), numFaces - first));
+                chunks[chunkIndex] = encodeFaceChunk(faces + first, count, chunkTable[chunkIndex].uncompressedSize);
+            }
+        }
+    });
+
+    quint64 offset = sizeof(FileHeader) + numChunks * sizeof(ChunkEntry);
+    for(int i=0; i<chunks.size(); ++i) {
+        if(chunks[i].isEmpty()) {
+            qCWarning(logImport) << "Failed to compress mesh pack chunk";
+            return false;
+        }
+        chunkTable[i].offset = offset;
+        chunkTable[i].compressedSize = quint32(chunks[i].size());
+        offset += quint64(chunks[i].size());
+    }
+
+    bool result = device->write(reinterpret_cast<const char*>(&header), sizeof(FileHeader)) == qint64(sizeof(FileHeader));
+    result = result && device->write(reinterpret_cast<const char*>(chunkTable.constData()), qint64(chunkTable.size()) * qint64(sizeof(ChunkEntry))) == qint64(chunkTable.size()) * qint64(sizeof(ChunkEntry));
+    for(int i=0; result && i<chunks.size(); ++i) {
+        result = device->write(chunks[i]) == chunks[i].size();
+    }
+    return result;
+}
+
+bool decodeMeshPack(const uchar *data, quint64 size, QGeometryData &result)
+{
+    if(!isMeshPack(data, size)) {
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data, sizeof(FileHeader));
+    if(header.version != Config::FormatVersion || header.byteOrderMark != ByteOrderMark) {
+        qCWarning(logImport) << "Unsupported mesh pack version or byte order";
+        return false;
+    }
+    if(header.verticesPerChunk == 0 || header.verticesPerChunk > Config::MaxElementsPerChunk ||
+       header.facesPerChunk == 0 || header.facesPerChunk > Config::MaxElementsPerChunk) {
+        return false;
+    }
+
+    const ChunkLayout layout = getChunkLayout(header);
+    const quint64 numChunks = layout.numVertexChunks + layout.numFaceChunks;
+    const quint64 maxNumChunks = (size - sizeof(FileHeader)) / sizeof(ChunkEntry);
+    if(numChunks > maxNumChunks || numChunks > quint64(std::numeric_limits<int>::max())) {
+        return false;
+    }
+
+    QVector<ChunkEntry> chunkTable(static_cast<int>(numChunks));
+    if(numChunks > 0) {
+        std::memcpy(chunkTable.data(), data + sizeof(FileHeader), size_t(numChunks) * sizeof(ChunkEntry));
+    }
+    for(const ChunkEntry &entry : chunkTable) {
+        if(entry.offset > size || entry.compressedSize > size - entry.offset ||
+           quint64(entry.uncompressedSize) > quint64(entry.compressedSize) * Config::MaxCompressionRatio) {
+            return false;
+        }
+    }
+
+    QGeometryData geometry;
+    QVertex *vertices = allocateElements(geometry.vertices, geometry.vertexStorage, header.numVertices);
+    QTriangle *faces = allocateElements(geometry.faces, geometry.faceStorage, header.numFaces);
+    if((header.numVertices > 0 && !vertices) || (header.numFaces > 0 && !faces)) {
+        qCWarning(logImport) << "Failed to allocate memory for mesh pack geometry";
+        return false;
+    }
+
+    QAtomicInt failed(0);
+    Utility::parallelFor(0, int(numChunks), 1, [&](int begin, int end) {
+        for(int chunkIndex=begin; chunkIndex<end && !failed.loadAcquire(); ++chunkIndex) {
+            const ChunkEntry &entry = chunkTable[chunkIndex];
+            const QByteArray payload = qUncompress(data + entry.offset, int(entry.compressedSize));
+            if(payload.size() != int(entry.uncompressedSize)) {
+                failed.storeRelease(1);
+                break;
+            }
+            bool chunkDecoded;
+            if(quint64(chunkIndex) < layout.numVertexChunks) {
+                const quint64 first = quint64(chunkIndex) * header.verticesPerChunk;
+                const int count = int(qMin(quint64(header.verticesPerChunk), header.numVertices - first));
+                chunkDecoded = decodeVertexChunk(payload, count, header, vertices + first);
+            }
+            else {
+                const quint64 first = (quint64(chunkIndex) - layout.numVertexChunks) * header.facesPerChunk;
+                const int count = int(qMin(quint64(header.facesPerChunk), header.numFaces - first));
+                chunkDecoded = decodeFaceChunk(payload, count, header.numVertices, faces + first);
+            }
+            if(!chunkDecoded) {
+                failed.storeRelease(1);
+            }
+        }
+    });
+    if(failed.loadAcquire()) {
+        qCWarning(logImport) << "Mesh pack contains corrupted chunks";
+        return false;
+    }
+
+    result = geometry;
+    return true;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
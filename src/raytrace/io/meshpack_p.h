@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qgeometrydata.h>
+
+class QIODevice;
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Quartz mesh pack (.qmp) is a compact mesh format designed for fast, parallel loading.
+//
+// Vertex positions and texture coordinates are quantized to 16 bits over their bounding boxes, normals and tangents
+// are octahedron encoded to two 16-bit components. Attributes are stored as delta coded planar streams split into
+// byte planes. Indices are delta coded as zigzag varints. Both are zlib compressed in chunks of a fixed number of
+// vertices or faces. Every chunk is decoded independently straight into its slice of the resulting geometry.
+bool encodeMeshPack(const QGeometryData &data, QIODevice *device);
+bool decodeMeshPack(const uchar *data, quint64 size, QGeometryData &result);
+
+bool isMeshPack(const uchar *data, quint64 size);
+
+} // Raytrace
+} // Qt3DRaytrace
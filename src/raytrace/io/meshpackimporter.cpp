@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/meshpackimporter_p.h>
+#include <io/meshpack_p.h>
+
+#include <QFile>
+#include <QFileInfo>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+bool MeshPackImporter::isSupported(const QUrl &url)
+{
+    return QFileInfo(url.path()).suffix().compare(QStringLiteral("qmp"), Qt::CaseInsensitive) == 0;
+}
+
+bool MeshPackImporter::import(const QUrl &url, QGeometryData &data)
+{
+    QFile packFile(getAssetPathFromUrl(url));
+    if(!packFile.open(QFile::ReadOnly)) {
+        qCCritical(logImport) << "Cannot open mesh file:" << url.toString();
+        return false;
+    }
+
+    qCInfo(logImport) << "Loading mesh:" << url.toString();
+
+    bool result = false;
+    const qint64 packSize = packFile.size();
+    if(packSize > 0) {
+        if(uchar *packData = packFile.map(0, packSize)) {
+            result = decodeMeshPack(packData, quint64(packSize), data);
+            packFile.unmap(packData);
+        }
+        else {
+            const QByteArray packData = packFile.readAll();
+            result = decodeMeshPack(reinterpret_cast<const uchar*>(packData.constData()), quint64(packData.size()), data);
+        }
+    }
+
+    if(!result) {
+        qCCritical(logImport) << "Failed to import mesh pack file:" << url.toString();
+    }
+    return result;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+#include <io/meshimporter_p.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Importer of Quartz mesh pack (.qmp) files produced by the meshpack tool.
+// Chunks of a memory-mapped file are decoded in parallel directly into the resulting geometry.
+class MeshPackImporter final : public MeshImporter
+{
+public:
+    bool import(const QUrl &url, QGeometryData &data) override;
+
+    static bool isSupported(const QUrl &url);
+};
+
+} // Raytrace
+} // Qt3DRaytrace
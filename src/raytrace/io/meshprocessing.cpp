@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/meshprocessing_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr int GrainSize = 64 * 1024;
+static constexpr float TangentLengthThreshold = 1e-12f;
+static constexpr int MortonBitsPerAxis = 10;
+
+} // Config
+
+static QVector3D computeFaceTangent(const QVertex &v0, const QVertex &v1, const QVertex &v2)
+{
+    const QVector3D e1 = v1.position - v0.position;
+    const QVector3D e2 = v2.position - v0.position;
+    const QVector2D d1 = v1.texcoord - v0.texcoord;
+    const QVector2D d2 = v2.texcoord - v0.texcoord;
+    const float det = d1.x() * d2.y() - d2.x() * d1.y();
+    if(det == 0.0f) {
+        return QVector3D();
+    }
+    return (e1 * d2.y() - e2 * d1.y()) * (1.0f / det);
+}
+
+void generateTangents(QGeometryData &data, int firstVertex, int numVertices, int firstFace, int numFaces)
+{
+    using Utility::parallelFor;
+
+    Q_ASSERT(!data.vertexStorage && !data.faceStorage);
+    Q_ASSERT(firstVertex >= 0 && firstVertex + numVertices <= data.vertices.size());
+    Q_ASSERT(firstFace >= 0 && firstFace + numFaces <= data.faces.size());
+
+    QVertex *vertices = data.vertices.data();
+    const QTriangle *faces = data.faces.constData() + firstFace;
+
+    QVector<QVector3D> faceTangentsArray(numFaces);
+    QVector3D *faceTangents = faceTangentsArray.data();
+    parallelFor(0, numFaces, Config::GrainSize, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            const QTriangle &face = faces[i];
+            faceTangents[i] = computeFaceTangent(vertices[face.vertices[0]], vertices[face.vertices[1]], vertices[face.vertices[2]]);
+        }
+    });
+
+    for(int i=firstVertex; i<firstVertex+numVertices; ++i) {
+        vertices[i].tangent = QVector3D();
+    }
+    // Faces sharing vertices cannot be accumulated concurrently; this pass is cheap compared to the above.
+    for(int i=0; i<numFaces; ++i) {
+        for(int k=0; k<3; ++k) {
+            vertices[faces[i].vertices[k]].tangent += faceTangents[i];
+        }
+    }
+
+    parallelFor(firstVertex, firstVertex + numVertices, Config::GrainSize, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            QVertex &vertex = vertices[i];
+            vertex.tangent -= vertex.normal * QVector3D::dotProduct(vertex.normal, vertex.tangent);
+            if(vertex.tangent.lengthSquared() > Config::TangentLengthThreshold) {
+                vertex.tangent.normalize();
+            }
+            else {
+                vertex.tangent = computeFallbackTangent(vertex.normal);
+            }
+        }
+    });
+}
+
+static quint32 expandMortonBits(quint32 value)
+{
+    value = (value | (value << 16)) & 0x030000FFu;
+    value = (value | (value <<  8)) & 0x0300F00Fu;
+    value = (value | (value <<  4)) & 0x030C30C3u;
+    value = (value | (value <<  2)) & 0x09249249u;
+    return value;
+}
+
+static bool isDegenerate(const QVertex *vertices, const QTriangle &face)
+{
+    if(face.vertices[0] == face.vertices[1] || face.vertices[1] == face.vertices[2] || face.vertices[0] == face.vertices[2]) {
+        return true;
+    }
+    const QVector3D &p0 = vertices[face.vertices[0]].position;
+    const QVector3D &p1 = vertices[face.vertices[1]].position;
+    const QVector3D &p2 = vertices[face.vertices[2]].position;
+    return QVector3D::crossProduct(p1 - p0, p2 - p0).lengthSquared() == 0.0f;
+}
+
+// Triangle vertices rotated so that the lowest index comes first; equal for triangles differing only by rotation.
+static std::array<quint32, 3> canonicalTriangle(const QTriangle &face)
+{
+    const quint32 *v = face.vertices;
+    if(v[0] < v[1] && v[0] < v[2]) {
+        return {{ v[0], v[1], v[2] }};
+    }
+    else if(v[1] < v[2]) {
+        return {{ v[1], v[2], v[0] }};
+    }
+    else {
+        return {{ v[2], v[0], v[1] }};
+    }
+}
+
+// Stable LSD radix sort of entries by their upper 32 bits.
+static void radixSortByKey(QVector<quint64> &entries)
+{
+    QVector<quint64> buffer(entries.size());
+    quint64 *source = entries.data();
+    quint64 *dest = buffer.data();
+    for(int shift=32; shift<64; shift+=8) {
+        int offsets[257] = {};
+        for(int i=0; i<entries.size(); ++i) {
+            ++offsets[((source[i] >> shift) & 0xFF) + 1];
+        }
+        for(int i=1; i<257; ++i) {
+            offsets[i] += offsets[i-1];
+        }
+        for(int i=0; i<entries.size(); ++i) {
+            dest[offsets[(source[i] >> shift) & 0xFF]++] = source[i];
+        }
+        std::swap(source, dest);
+    }
+    // Even number of passes leaves sorted data in the original array.
+    Q_ASSERT(source == entries.data());
+}
+
+void optimizeMesh(QGeometryData &data)
+{
+    using Utility::parallelFor;
+
+    // Optimized mesh is written back into vectors which limits the number of elements.
+    if(data.isEmpty() || data.numVertices() > quint64(std::numeric_limits<int>::max()) || data.numFaces() > quint64(std::numeric_limits<int>::max())) {
+        return;
+    }
+    const int numVertices = int(data.numVertices());
+    const int numFaces = int(data.numFaces());
+
+    const QVertex *vertices = data.vertexData();
+    const QTriangle *faces = data.faceData();
+
+    QVector3D boundsMin(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+    QVector3D boundsMax(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+    for(int i=0; i<numVertices; ++i) {
+        const QVector3D &position = vertices[i].position;
+        boundsMin = QVector3D(qMin(boundsMin.x(), position.x()), qMin(boundsMin.y(), position.y()), qMin(boundsMin.z(), position.z()));
+        boundsMax = QVector3D(qMax(boundsMax.x(), position.x()), qMax(boundsMax.y(), position.y()), qMax(boundsMax.z(), position.z()));
+    }
+    const QVector3D extent = boundsMax - boundsMin;
+    const float maxGridCoord = float((1 << Config::MortonBitsPerAxis) - 1);
+    const QVector3D gridScale(
+        extent.x() > 0.0f ? maxGridCoord / extent.x() : 0.0f,
+        extent.y() > 0.0f ? maxGridCoord / extent.y() : 0.0f,
+        extent.z() > 0.0f ? maxGridCoord / extent.z() : 0.0f);
+
+    // Entries hold Morton code of triangle centroid in the upper and triangle index in the lower 32 bits.
+    // Degenerate triangles are marked with an all-ones entry and dropped after sorting.
+    static constexpr quint64 DegenerateEntry = ~quint64(0);
+    QVector<quint64> entries(numFaces);
+    quint64 *entryData = entries.data();
+    parallelFor(0, numFaces, Config::GrainSize, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            const QTriangle &face = faces[i];
+            if(isDegenerate(vertices, face)) {
+                entryData[i] = DegenerateEntry;
+                continue;
+            }
+            const QVector3D centroid = (vertices[face.vertices[0]].position + vertices[face.vertices[1]].position + vertices[face.vertices[2]].position) / 3.0f;
+            const QVector3D gridCoord = (centroid - boundsMin) * gridScale;
+            const quint32 mortonCode =
+                    (expandMortonBits(quint32(qBound(0.0f, gridCoord.x(), maxGridCoord))) << 2) |
+                    (expandMortonBits(quint32(qBound(0.0f, gridCoord.y(), maxGridCoord))) << 1) |
+                    (expandMortonBits(quint32(qBound(0.0f, gridCoord.z(), maxGridCoord))));
+            entryData[i] = (quint64(mortonCode) << 32) | quint64(i);
+        }
+    });
+    radixSortByKey(entries);
+
+    // Duplicates share centroid and thus Morton code so only runs of equal codes need to be compared.
+    QVector<QTriangle> sortedFaces;
+    sortedFaces.reserve(numFaces);
+    QVector<std::pair<std::array<quint32, 3>, int>> run;
+    for(int runBegin=0; runBegin<numFaces && entries[runBegin] != DegenerateEntry;) {
+        const quint32 mortonCode = quint32(entries[runBegin] >> 32);
+        int runEnd = runBegin + 1;
+        while(runEnd < numFaces && entries[runEnd] != DegenerateEntry && quint32(entries[runEnd] >> 32) == mortonCode) {
+            ++runEnd;
+        }
+        if(runEnd - runBegin == 1) {
+            sortedFaces.append(faces[quint32(entries[runBegin])]);
+        }
+        else {
+            run.clear();
+            for(int i=runBegin; i<runEnd; ++i) {
+                run.append(std::make_pair(canonicalTriangle(faces[quint32(entries[i])]), i));
+            }
+            std::sort(run.begin(), run.end());
+            QVector<bool> isDuplicate(runEnd - runBegin, false);
+            for(int i=1; i<run.size(); ++i) {
+                if(run[i].first == run[i-1].first) {
+                    isDuplicate[run[i].second - runBegin] = true;
+                }
+            }
+            for(int i=runBegin; i<runEnd; ++i) {
+                if(!isDuplicate[i - runBegin]) {
+                    sortedFaces.append(faces[quint32(entries[i])]);
+                }
+            }
+        }
+        runBegin = runEnd;
+    }
+    entries.clear();
+
+    QVector<int> vertexRemap(numVertices, -1);
+    int numUsedVertices = 0;
+    for(QTriangle &face : sortedFaces) {
+        for(quint32 &index : face.vertices) {
+            int &remappedIndex = vertexRemap[int(index)];
+            if(remappedIndex < 0) {
+                remappedIndex = numUsedVertices++;
+            }
+            index = quint32(remappedIndex);
+        }
+    }
+
+    QVector<QVertex> sortedVertices(numUsedVertices);
+    QVertex *sortedVertexData = sortedVertices.data();
+    const int *vertexRemapData = vertexRemap.constData();
+    parallelFor(0, numVertices, Config::GrainSize, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            if(vertexRemapData[i] >= 0) {
+                sortedVertexData[vertexRemapData[i]] = vertices[i];
+            }
+        }
+    });
+
+    data.vertices = sortedVertices;
+    data.faces = sortedFaces;
+    data.vertexStorage.reset();
+    data.faceStorage.reset();
+}
+
+} // Raytrace
+} // Qt3DRaytrace
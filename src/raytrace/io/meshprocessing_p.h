@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qgeometrydata.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Generates tangents of vertices in [firstVertex, firstVertex + numVertices) from texture coordinates of faces
+// in [firstFace, firstFace + numFaces), which must only reference vertices within that range.
+// Vertices without usable texture space get arbitrary tangents perpendicular to their normals.
+// Geometry must be stored in vectors, not in external storage.
+void generateTangents(QGeometryData &data, int firstVertex, int numVertices, int firstFace, int numFaces);
+
+// Reorders mesh data for memory locality.
+// Degenerate and duplicate triangles are removed, remaining triangles are sorted along a Morton curve
+// through their centroids, and vertices are renumbered in order of first use with unreferenced vertices dropped.
+void optimizeMesh(QGeometryData &data);
+
+} // Raytrace
+} // Qt3DRaytrace
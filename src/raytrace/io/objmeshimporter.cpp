@@ -0,0 +1,667 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/objmeshimporter_p.h>
+#include <io/defaultmeshimporter_p.h>
+#include <io/meshcache_p.h>
+#include <io/meshprocessing_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QVarLengthArray>
+#include <QAtomicInt>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr qint64 ChunkSize = 4 * 1024 * 1024;
+static constexpr int GrainSize = 64 * 1024;
+static constexpr qint64 MaxCorners = (1 << 29);
+
+// Distinguishes cache entries produced by this importer from those produced by DefaultMeshImporter.
+// Must be incremented whenever output of this importer changes.
+static constexpr quint32 CacheImportFlags = 0x4F424A01u;
+
+} // Config
+
+namespace {
+
+enum class LineType
+{
+    Other,
+    Position,
+    Texcoord,
+    Normal,
+    Face,
+};
+
+struct Corner
+{
+    qint32 position;
+    qint32 texcoord;
+    qint32 normal;
+
+    bool operator==(const Corner &other) const
+    {
+        return position == other.position && texcoord == other.texcoord && normal == other.normal;
+    }
+};
+
+struct Chunk
+{
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    int numPositions = 0;
+    int numTexcoords = 0;
+    int numNormals = 0;
+    int numTriangles = 0;
+    int basePosition = 0;
+    int baseTexcoord = 0;
+    int baseNormal = 0;
+    int baseTriangle = 0;
+};
+
+struct ObjData
+{
+    QVector<QVector3D> positions;
+    QVector<QVector2D> texcoords;
+    QVector<QVector3D> normals;
+    QVector<Corner> corners;
+};
+
+inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline void skipSpaces(const char *&p, const char *end)
+{
+    while(p < end && isSpace(*p)) {
+        ++p;
+    }
+}
+
+// Calls func(lineBegin, lineEnd) for every line with comments stripped; stops early if func returns false.
+template<typename Func>
+bool forEachLine(const char *begin, const char *end, Func &&func)
+{
+    const char *p = begin;
+    while(p < end) {
+        const char *lineEnd = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        const char *nextLine = lineEnd ? (lineEnd + 1) : end;
+        if(!lineEnd) {
+            lineEnd = end;
+        }
+        if(const char *comment = static_cast<const char*>(std::memchr(p, '#', size_t(lineEnd - p)))) {
+            lineEnd = comment;
+        }
+        if(!func(p, lineEnd)) {
+            return false;
+        }
+        p = nextLine;
+    }
+    return true;
+}
+
+LineType parseLineType(const char *&p, const char *end)
+{
+    skipSpaces(p, end);
+    if(end - p >= 2 && p[0] == 'v' && isSpace(p[1])) {
+        p += 1;
+        return LineType::Position;
+    }
+    if(end - p >= 3 && p[0] == 'v' && p[1] == 't' && isSpace(p[2])) {
+        p += 2;
+        return LineType::Texcoord;
+    }
+    if(end - p >= 3 && p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+        p += 2;
+        return LineType::Normal;
+    }
+    if(end - p >= 2 && p[0] == 'f' && isSpace(p[1])) {
+        p += 1;
+        return LineType::Face;
+    }
+    return LineType::Other;
+}
+
+int countTokens(const char *p, const char *end)
+{
+    int numTokens = 0;
+    while(true) {
+        skipSpaces(p, end);
+        if(p == end) {
+            break;
+        }
+        ++numTokens;
+        while(p < end && !isSpace(*p)) {
+            ++p;
+        }
+    }
+    return numTokens;
+}
+
+// Parses decimal floating point number in place.
+// Up to 19 significant digits are accumulated into an integer mantissa which, for the common case of short
+// mantissas and small exponents, is scaled by an exactly representable power of ten yielding correctly rounded result.
+bool parseFloat(const char *&p, const char *end, float &value)
+{
+    static constexpr double ExactPowersOf10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    static constexpr int MaxExactPowerOf10 = 22;
+    static constexpr quint64 MaxExactMantissa = quint64(1) << 53;
+    static constexpr int MaxMantissaDigits = 19;
+
+    skipSpaces(p, end);
+
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    quint64 mantissa = 0;
+    int exponent = 0;
+    int numMantissaDigits = 0;
+    bool hasDigits = false;
+    for(; p < end && isDigit(*p); ++p) {
+        if(numMantissaDigits < MaxMantissaDigits) {
+            mantissa = mantissa * 10 + quint64(*p - '0');
+            numMantissaDigits += (mantissa != 0) ? 1 : 0;
+        }
+        else {
+            ++exponent;
+        }
+        hasDigits = true;
+    }
+    if(p < end && *p == '.') {
+        for(++p; p < end && isDigit(*p); ++p) {
+            if(numMantissaDigits < MaxMantissaDigits) {
+                mantissa = mantissa * 10 + quint64(*p - '0');
+                numMantissaDigits += (mantissa != 0) ? 1 : 0;
+                --exponent;
+            }
+            hasDigits = true;
+        }
+    }
+    if(!hasDigits) {
+        return false;
+    }
+    if(p < end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool negativeExponent = false;
+        if(q < end && (*q == '-' || *q == '+')) {
+            negativeExponent = (*q == '-');
+            ++q;
+        }
+        if(q < end && isDigit(*q)) {
+            int explicitExponent = 0;
+            for(; q < end && isDigit(*q); ++q) {
+                explicitExponent = qMin(explicitExponent * 10 + (*q - '0'), 10000);
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            p = q;
+        }
+    }
+    if(p < end && !isSpace(*p)) {
+        return false;
+    }
+
+    double result = double(mantissa);
+    if(mantissa != 0) {
+        if(mantissa <= MaxExactMantissa && exponent >= -MaxExactPowerOf10 && exponent <= MaxExactPowerOf10) {
+            result = (exponent < 0) ? (result / ExactPowersOf10[-exponent]) : (result * ExactPowersOf10[exponent]);
+        }
+        else {
+            result *= std::pow(10.0, double(exponent));
+        }
+    }
+    value = float(negative ? -result : result);
+    return true;
+}
+
+bool parseIndex(const char *&p, const char *end, int &value)
+{
+    bool negative = false;
+    if(p < end && *p == '-') {
+        negative = true;
+        ++p;
+    }
+    if(p == end || !isDigit(*p)) {
+        return false;
+    }
+    qint64 result = 0;
+    for(; p < end && isDigit(*p); ++p) {
+        result = result * 10 + (*p - '0');
+        if(result > std::numeric_limits<int>::max()) {
+            return false;
+        }
+    }
+    value = int(negative ? -result : result);
+    return true;
+}
+
+// Resolves one-based or negative (relative to the number of elements defined so far) index into zero-based index.
+// Upper bound is validated later against total number of elements in the file.
+bool resolveIndex(int index, int numDefined, qint32 &result)
+{
+    if(index > 0) {
+        result = index - 1;
+        return true;
+    }
+    if(index < 0 && numDefined + index >= 0) {
+        result = numDefined + index;
+        return true;
+    }
+    return false;
+}
+
+bool parseCorner(const char *&p, const char *end, const Chunk &counters, Corner &corner)
+{
+    int index;
+    if(!parseIndex(p, end, index) || !resolveIndex(index, counters.numPositions, corner.position)) {
+        return false;
+    }
+    corner.texcoord = -1;
+    corner.normal = -1;
+    if(p < end && *p == '/') {
+        ++p;
+        if(p < end && *p != '/') {
+            if(!parseIndex(p, end, index) || !resolveIndex(index, counters.numTexcoords, corner.texcoord)) {
+                return false;
+            }
+        }
+        if(p < end && *p == '/') {
+            ++p;
+            if(!parseIndex(p, end, index) || !resolveIndex(index, counters.numNormals, corner.normal)) {
+                return false;
+            }
+        }
+    }
+    return p == end || isSpace(*p);
+}
+
+void countChunk(Chunk &chunk)
+{
+    forEachLine(chunk.begin, chunk.end, [&chunk](const char *p, const char *lineEnd) {
+        switch(parseLineType(p, lineEnd)) {
+        case LineType::Position:
+            ++chunk.numPositions;
+            break;
+        case LineType::Texcoord:
+            ++chunk.numTexcoords;
+            break;
+        case LineType::Normal:
+            ++chunk.numNormals;
+            break;
+        case LineType::Face:
+            chunk.numTriangles += qMax(countTokens(p, lineEnd) - 2, 0);
+            break;
+        default:
+            break;
+        }
+        return true;
+    });
+}
+
+bool parseChunk(const Chunk &chunk, ObjData &obj)
+{
+    // Counters track global number of elements defined so far to resolve relative indices.
+    Chunk counters;
+    counters.numPositions = chunk.basePosition;
+    counters.numTexcoords = chunk.baseTexcoord;
+    counters.numNormals = chunk.baseNormal;
+    int triangleIndex = chunk.baseTriangle;
+
+    QVector3D *positions = obj.positions.data();
+    QVector2D *texcoords = obj.texcoords.data();
+    QVector3D *normals = obj.normals.data();
+    Corner *corners = obj.corners.data();
+
+    QVarLengthArray<Corner, 16> polygon;
+    const bool result = forEachLine(chunk.begin, chunk.end, [&](const char *p, const char *lineEnd) {
+        float x, y, z;
+        switch(parseLineType(p, lineEnd)) {
+        case LineType::Position:
+            if(!parseFloat(p, lineEnd, x) || !parseFloat(p, lineEnd, y) || !parseFloat(p, lineEnd, z)) {
+                return false;
+            }
+            positions[counters.numPositions++] = { x, y, z };
+            break;
+        case LineType::Texcoord:
+            y = 0.0f;
+            if(!parseFloat(p, lineEnd, x)) {
+                return false;
+            }
+            skipSpaces(p, lineEnd);
+            if(p < lineEnd && !parseFloat(p, lineEnd, y)) {
+                return false;
+            }
+            texcoords[counters.numTexcoords++] = { x, y };
+            break;
+        case LineType::Normal:
+            if(!parseFloat(p, lineEnd, x) || !parseFloat(p, lineEnd, y) || !parseFloat(p, lineEnd, z)) {
+                return false;
+            }
+            normals[counters.numNormals++] = { x, y, z };
+            break;
+        case LineType::Face:
+            polygon.clear();
+            for(skipSpaces(p, lineEnd); p < lineEnd; skipSpaces(p, lineEnd)) {
+                Corner corner;
+                if(!parseCorner(p, lineEnd, counters, corner)) {
+                    return false;
+                }
+                polygon.append(corner);
+            }
+            // Polygons are fan triangulated which is exact for planar convex polygons.
+            for(int i=1; i<polygon.size()-1; ++i, ++triangleIndex) {
+                Corner *triangleCorners = &corners[3 * triangleIndex];
+                triangleCorners[0] = polygon[0];
+                triangleCorners[1] = polygon[i];
+                triangleCorners[2] = polygon[i+1];
+                for(int k=0; k<3; ++k) {
+                    if(triangleCorners[k].normal < 0) {
+                        // Corners without normals get flat normals and are never shared with other triangles.
+                        triangleCorners[k].normal = -2 - triangleIndex;
+                    }
+                }
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    });
+
+    Q_ASSERT(!result || triangleIndex == chunk.baseTriangle + chunk.numTriangles);
+    return result;
+}
+
+inline quint32 hashCorner(const Corner &corner)
+{
+    quint64 hash = quint64(quint32(corner.position)) * 0x9E3779B97F4A7C15ull;
+    hash ^= quint64(quint32(corner.texcoord)) * 0xC2B2AE3D27D4EB4Full;
+    hash ^= quint64(quint32(corner.normal)) * 0x165667B19E3779F9ull;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 32;
+    return quint32(hash);
+}
+
+// Lock-free open addressing table mapping distinct corners to their representative corner index.
+// Slots store representative index + 1 (zero marks an empty slot). Representative of each distinct corner
+// is the one with the lowest index, which makes vertex order independent of thread scheduling.
+class CornerTable
+{
+public:
+    explicit CornerTable(const Corner *corners, int numCorners)
+        : m_corners(corners)
+    {
+        quint32 size = 1;
+        while(size < quint32(numCorners) + quint32(numCorners) / 2 + 1) {
+            size <<= 1;
+        }
+        m_slots.resize(int(size));
+        m_mask = size - 1;
+    }
+
+    void insert(int cornerIndex)
+    {
+        QAtomicInt *slots = m_slots.data();
+        const Corner &corner = m_corners[cornerIndex];
+        const int value = cornerIndex + 1;
+        for(quint32 slot = hashCorner(corner) & m_mask;; slot = (slot + 1) & m_mask) {
+            int current = slots[slot].loadAcquire();
+            if(current == 0) {
+                if(slots[slot].testAndSetOrdered(0, value, current)) {
+                    return;
+                }
+            }
+            if(m_corners[current - 1] == corner) {
+                while(value < current && !slots[slot].testAndSetOrdered(current, value, current)) {}
+                return;
+            }
+        }
+    }
+
+    int find(int cornerIndex) const
+    {
+        const QAtomicInt *slots = m_slots.constData();
+        const Corner &corner = m_corners[cornerIndex];
+        for(quint32 slot = hashCorner(corner) & m_mask;; slot = (slot + 1) & m_mask) {
+            const int current = slots[slot].loadAcquire();
+            Q_ASSERT(current != 0);
+            if(m_corners[current - 1] == corner) {
+                return current - 1;
+            }
+        }
+    }
+
+private:
+    const Corner *m_corners;
+    QVector<QAtomicInt> m_slots;
+    quint32 m_mask;
+};
+
+QVector3D computeFaceNormal(const ObjData &obj, int triangleIndex)
+{
+    const Corner *corners = &obj.corners[3 * triangleIndex];
+    const QVector3D &p0 = obj.positions[corners[0].position];
+    const QVector3D &p1 = obj.positions[corners[1].position];
+    const QVector3D &p2 = obj.positions[corners[2].position];
+    return QVector3D::crossProduct(p1 - p0, p2 - p0).normalized();
+}
+
+bool parseObj(const char *data, qint64 size, QGeometryData &result)
+{
+    using Utility::parallelFor;
+
+    QVector<Chunk> chunks;
+    for(const char *p = data, *end = data + size; p < end;) {
+        Chunk chunk;
+        chunk.begin = p;
+        chunk.end = (end - p > Config::ChunkSize) ? (p + Config::ChunkSize) : end;
+        if(chunk.end < end) {
+            const char *lineEnd = static_cast<const char*>(std::memchr(chunk.end, '\n', size_t(end - chunk.end)));
+            chunk.end = lineEnd ? (lineEnd + 1) : end;
+        }
+        chunks.append(chunk);
+        p = chunk.end;
+    }
+
+    parallelFor(0, chunks.size(), 1, [&chunks](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            countChunk(chunks[i]);
+        }
+    });
+
+    qint64 numPositions = 0;
+    qint64 numTexcoords = 0;
+    qint64 numNormals = 0;
+    qint64 numTriangles = 0;
+    for(Chunk &chunk : chunks) {
+        chunk.basePosition = int(numPositions);
+        chunk.baseTexcoord = int(numTexcoords);
+        chunk.baseNormal = int(numNormals);
+        chunk.baseTriangle = int(numTriangles);
+        numPositions += chunk.numPositions;
+        numTexcoords += chunk.numTexcoords;
+        numNormals += chunk.numNormals;
+        numTriangles += chunk.numTriangles;
+        if(numPositions > Config::MaxCorners || numTexcoords > Config::MaxCorners || numNormals > Config::MaxCorners || 3 * numTriangles > Config::MaxCorners) {
+            return false;
+        }
+    }
+    if(numPositions == 0 || numTriangles == 0) {
+        return false;
+    }
+
+    ObjData obj;
+    obj.positions.resize(int(numPositions));
+    obj.texcoords.resize(int(numTexcoords));
+    obj.normals.resize(int(numNormals));
+    obj.corners.resize(3 * int(numTriangles));
+
+    QAtomicInt failed(0);
+    parallelFor(0, chunks.size(), 1, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            if(!parseChunk(chunks[i], obj)) {
+                failed.storeRelease(1);
+            }
+        }
+    });
+    if(failed.loadAcquire()) {
+        return false;
+    }
+
+    const int numFaces = int(numTriangles);
+    const int numCorners = obj.corners.size();
+    const Corner *corners = obj.corners.constData();
+
+    CornerTable cornerTable(corners, numCorners);
+    parallelFor(0, numCorners, Config::GrainSize, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            const Corner &corner = corners[i];
+            if(corner.position >= numPositions || corner.texcoord >= numTexcoords || corner.normal >= numNormals) {
+                failed.storeRelease(1);
+                return;
+            }
+            cornerTable.insert(i);
+        }
+    });
+    if(failed.loadAcquire()) {
+        return false;
+    }
+
+    // Vertices are numbered in order of first occurrence of each distinct corner.
+    const int numBlocks = (numCorners + Config::GrainSize - 1) / Config::GrainSize;
+    QVector<int> cornerRepresentativesArray(numCorners);
+    QVector<int> blockBaseVerticesArray(numBlocks);
+    int *cornerRepresentatives = cornerRepresentativesArray.data();
+    int *blockBaseVertices = blockBaseVerticesArray.data();
+    parallelFor(0, numBlocks, 1, [&](int begin, int end) {
+        for(int block=begin; block<end; ++block) {
+            int numBlockVertices = 0;
+            for(int i=block * Config::GrainSize, blockEnd=qMin(i + Config::GrainSize, numCorners); i<blockEnd; ++i) {
+                const int representative = cornerTable.find(i);
+                cornerRepresentatives[i] = representative;
+                numBlockVertices += (representative == i) ? 1 : 0;
+            }
+            blockBaseVertices[block] = numBlockVertices;
+        }
+    });
+
+    int numVertices = 0;
+    for(int &blockBaseVertex : blockBaseVerticesArray) {
+        const int numBlockVertices = blockBaseVertex;
+        blockBaseVertex = numVertices;
+        numVertices += numBlockVertices;
+    }
+
+    result.vertices.resize(numVertices);
+    result.faces.resize(numFaces);
+    QVertex *vertices = result.vertices.data();
+    QTriangle *faces = result.faces.data();
+
+    QVector<int> cornerVerticesArray(numCorners);
+    int *cornerVertices = cornerVerticesArray.data();
+    const ObjData &constObj = obj;
+    parallelFor(0, numBlocks, 1, [&](int begin, int end) {
+        for(int block=begin; block<end; ++block) {
+            int vertexIndex = blockBaseVertices[block];
+            for(int i=block * Config::GrainSize, blockEnd=qMin(i + Config::GrainSize, numCorners); i<blockEnd; ++i) {
+                if(cornerRepresentatives[i] != i) {
+                    continue;
+                }
+                const Corner &corner = corners[i];
+                QVertex &vertex = vertices[vertexIndex];
+                vertex.position = constObj.positions[corner.position];
+                vertex.normal = (corner.normal >= 0) ? constObj.normals[corner.normal].normalized() : computeFaceNormal(constObj, i / 3);
+                vertex.texcoord = (corner.texcoord >= 0) ? constObj.texcoords[corner.texcoord] : QVector2D();
+                cornerVertices[i] = vertexIndex++;
+            }
+        }
+    });
+    parallelFor(0, numFaces, Config::GrainSize, [&](int begin, int end) {
+        for(int i=begin; i<end; ++i) {
+            for(int k=0; k<3; ++k) {
+                faces[i].vertices[k] = quint32(cornerVertices[cornerRepresentatives[3 * i + k]]);
+            }
+        }
+    });
+
+    generateTangents(result, 0, numVertices, 0, numFaces);
+    return true;
+}
+
+} // anonymous
+
+bool ObjMeshImporter::isSupported(const QUrl &url)
+{
+    return QFileInfo(url.path()).suffix().compare(QStringLiteral("obj"), Qt::CaseInsensitive) == 0;
+}
+
+bool ObjMeshImporter::import(const QUrl &url, QGeometryData &data)
+{
+    const QString scenePath = getAssetPathFromUrl(url);
+
+    MeshCache *meshCache = MeshCache::instance();
+    if(meshCache->load(scenePath, Config::CacheImportFlags, data)) {
+        qCInfo(logImport) << "Loading mesh:" << url.toString() << "(cached)";
+        return true;
+    }
+
+    QFile sceneFile(scenePath);
+    if(!sceneFile.open(QFile::ReadOnly)) {
+        qCCritical(logImport) << "Cannot open mesh file:" << url.toString();
+        return false;
+    }
+
+    qCInfo(logImport) << "Loading mesh:" << url.toString();
+
+    bool result = false;
+    const qint64 sceneSize = sceneFile.size();
+    if(sceneSize > 0) {
+        if(uchar *sceneData = sceneFile.map(0, sceneSize)) {
+            result = parseObj(reinterpret_cast<const char*>(sceneData), sceneSize, data);
+            sceneFile.unmap(sceneData);
+        }
+        else {
+            const QByteArray sceneData = sceneFile.readAll();
+            result = parseObj(sceneData.constData(), sceneData.size(), data);
+        }
+    }
+    sceneFile.close();
+
+    if(result) {
+        meshCache->store(scenePath, Config::CacheImportFlags, data);
+        return true;
+    }
+
+    qCWarning(logImport) << "Mesh file contains unsupported OBJ content, falling back to default importer:" << url.toString();
+    data = QGeometryData();
+    return DefaultMeshImporter().import(url, data);
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+#include <io/meshimporter_p.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Native Wavefront OBJ importer.
+// Parses line-aligned chunks of a memory-mapped file in parallel and deduplicates vertex tuples
+// through a lock-free hash table. Only geometry is imported; materials and groups are ignored.
+// Files using OBJ features not supported by this importer are handed over to DefaultMeshImporter.
+class ObjMeshImporter final : public MeshImporter
+{
+public:
+    bool import(const QUrl &url, QGeometryData &data) override;
+
+    static bool isSupported(const QUrl &url);
+};
+
+} // Raytrace
+} // Qt3DRaytrace
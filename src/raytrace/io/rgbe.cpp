@@ -0,0 +1,679 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/rgbe_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <QIODevice>
+#include <QList>
+#include <QVector>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qfloat16.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUARTZ_RGBE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr int DecodeGrainSize = 16;
+static constexpr int EncodeBandHeight = 64;
+static constexpr quint64 MaxHeaderSize = 64 * 1024;
+static constexpr int MaxImageSize = 65536;
+
+} // Config
+
+namespace {
+
+constexpr char Magic[2] = { '#', '?' };
+
+// Scanlines narrower or wider than that are never run-length encoded.
+constexpr int MinEncodedWidth = 8;
+constexpr int MaxEncodedWidth = 0x7FFF;
+constexpr int MaxRunLength = 127;
+constexpr int MaxLiteralLength = 128;
+
+constexpr float MaxHalf = 65504.0f;
+constexpr float MinNormalHalf = 6.103515625e-05f;
+constexpr float HalfSubnormalScale = 16777216.0f;
+constexpr quint16 MaxHalfBits = 0x7BFF;
+constexpr quint16 OneHalfBits = 0x3C00;
+
+// Values outside of this range are stored as zero or clamped since they cannot be represented with 8-bit shared exponent.
+constexpr float MinEncodedValue = 1.0e-32f;
+constexpr float MaxEncodedValue = 1.0e38f;
+
+struct Header
+{
+    int width = 0;
+    int height = 0;
+    bool isTopDown = true;
+    quint64 dataOffset = 0;
+};
+
+bool readLine(const uchar *data, quint64 size, quint64 &offset, QByteArray &line)
+{
+    const uchar *lineBegin = data + offset;
+    const uchar *lineEnd = static_cast<const uchar*>(std::memchr(lineBegin, '\n', size_t(size - offset)));
+    if(!lineEnd) {
+        return false;
+    }
+    offset = quint64(lineEnd - data) + 1;
+    if(lineEnd > lineBegin && lineEnd[-1] == '\r') {
+        --lineEnd;
+    }
+    line = QByteArray(reinterpret_cast<const char*>(lineBegin), int(lineEnd - lineBegin));
+    return true;
+}
+
+bool readHeader(const uchar *data, quint64 size, Header &header)
+{
+    const quint64 headerSize = qMin(size, Config::MaxHeaderSize);
+
+    quint64 offset = 0;
+    QByteArray line;
+    if(!isRgbeImage(data, size) || !readLine(data, headerSize, offset, line)) {
+        qCWarning(logImport) << "Invalid Radiance HDR image header";
+        return false;
+    }
+
+    // Header variables are terminated by an empty line; pixel format defaults to RGBE if not specified.
+    bool isRgbeFormat = true;
+    do {
+        if(!readLine(data, headerSize, offset, line)) {
+            qCWarning(logImport) << "Invalid Radiance HDR image header";
+            return false;
+        }
+        if(line.startsWith("FORMAT=")) {
+            isRgbeFormat = (line.mid(7).trimmed() == "32-bit_rle_rgbe");
+        }
+    } while(!line.isEmpty());
+
+    if(!isRgbeFormat) {
+        qCWarning(logImport) << "Unsupported Radiance HDR pixel format: only RGBE images are supported";
+        return false;
+    }
+
+    if(!readLine(data, headerSize, offset, line)) {
+        qCWarning(logImport) << "Invalid Radiance HDR image resolution";
+        return false;
+    }
+    const QList<QByteArray> fields = line.simplified().split(' ');
+    if(fields.size() != 4 || (fields[0] != "-Y" && fields[0] != "+Y") || fields[2] != "+X") {
+        qCWarning(logImport) << "Unsupported Radiance HDR image orientation:" << line;
+        return false;
+    }
+
+    bool isHeightValid = false;
+    bool isWidthValid = false;
+    header.height = fields[1].toInt(&isHeightValid);
+    header.width = fields[3].toInt(&isWidthValid);
+    if(!isWidthValid || !isHeightValid || header.width <= 0 || header.width > Config::MaxImageSize || header.height <= 0 || header.height > Config::MaxImageSize) {
+        qCWarning(logImport) << "Invalid Radiance HDR image resolution:" << line;
+        return false;
+    }
+    header.isTopDown = (fields[0] == "-Y");
+    header.dataOffset = offset;
+    return true;
+}
+
+inline bool isEncodedScanline(const uchar *data, quint64 size, int width)
+{
+    return width >= MinEncodedWidth && width <= MaxEncodedWidth && size >= 4 &&
+           data[0] == 2 && data[1] == 2 && ((int(data[2]) << 8) | int(data[3])) == width;
+}
+
+// Old-style run-length encoding marks runs with pixels (1, 1, 1, n), which repeat the previous pixel n times.
+// Consecutive run pixels supply successively higher order bytes of the repeat count.
+inline bool isRunPixel(const uchar *pixel)
+{
+    return pixel[0] == 1 && pixel[1] == 1 && pixel[2] == 1;
+}
+
+// Returns offset of the next scanline or zero if scanline data is malformed or truncated.
+quint64 skipScanline(const uchar *data, quint64 size, quint64 offset, int width)
+{
+    if(!isEncodedScanline(data + offset, size - offset, width)) {
+        // Runs may not continue from the previous scanline so that bands of scanlines can be decoded independently.
+        int shift = 0;
+        for(int x=0; x<width;) {
+            if(size - offset < 4) {
+                return 0;
+            }
+            const uchar *pixel = data + offset;
+            offset += 4;
+            if(isRunPixel(pixel)) {
+                if(x == 0 || shift > 16) {
+                    return 0;
+                }
+                const int count = int(pixel[3]) << shift;
+                if(count > width - x) {
+                    return 0;
+                }
+                x += count;
+                shift += 8;
+            }
+            else {
+                ++x;
+                shift = 0;
+            }
+        }
+        return offset;
+    }
+
+    offset += 4;
+    for(int c=0; c<4; ++c) {
+        for(int x=0; x<width;) {
+            if(offset >= size) {
+                return 0;
+            }
+            int count = data[offset++];
+            if(count > 128) {
+                count -= 128;
+                offset += 1;
+            }
+            else if(count > 0) {
+                offset += quint64(count);
+            }
+            else {
+                return 0;
+            }
+            x += count;
+            if(x > width) {
+                return 0;
+            }
+        }
+    }
+    return (offset <= size) ? offset : 0;
+}
+
+// Decodes scanline into separate planes of red, green, blue and exponent bytes.
+// Scanline data must have been validated by skipScanline() beforehand.
+void decodeScanline(const uchar *data, int width, uchar *planes)
+{
+    if(!isEncodedScanline(data, 4, width)) {
+        int shift = 0;
+        for(int x=0; x<width; data += 4) {
+            if(isRunPixel(data)) {
+                const int count = int(data[3]) << shift;
+                for(int c=0; c<4; ++c) {
+                    uchar *plane = planes + size_t(c) * size_t(width);
+                    std::memset(plane + x, plane[x - 1], size_t(count));
+                }
+                x += count;
+                shift += 8;
+            }
+            else {
+                for(int c=0; c<4; ++c) {
+                    planes[size_t(c) * size_t(width) + size_t(x)] = data[c];
+                }
+                ++x;
+                shift = 0;
+            }
+        }
+        return;
+    }
+
+    data += 4;
+    for(int c=0; c<4; ++c) {
+        uchar *plane = planes + size_t(c) * size_t(width);
+        for(int x=0; x<width;) {
+            int count = *data++;
+            if(count > 128) {
+                count -= 128;
+                std::memset(plane + x, *data++, size_t(count));
+            }
+            else {
+                std::memcpy(plane + x, data, size_t(count));
+                data += count;
+            }
+            x += count;
+        }
+    }
+}
+
+// Scale of a shared exponent; tiny exponents which would result in subnormal floats are flushed to zero.
+inline float exponentScale(int exponent)
+{
+    const quint32 bits = quint32(std::max(exponent - 9, 0)) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(float));
+    return scale;
+}
+
+// Converts non-negative float holding at most 8 significant bits (as decoded from RGBE) to half float bits.
+inline quint16 toHalfBits(float value)
+{
+    if(value > MaxHalf) {
+        return MaxHalfBits;
+    }
+    if(value < MinNormalHalf) {
+        return quint16(std::lrint(value * HalfSubnormalScale));
+    }
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    return quint16((bits >> 13) - ((127 - 15) << 10));
+}
+
+#if defined(QUARTZ_RGBE_SSE2)
+// Zero-extends 16 bytes into four vectors of 32-bit integers.
+inline void expandBytes(__m128i bytes, __m128i values[4])
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    values[0] = _mm_unpacklo_epi16(low, zero);
+    values[1] = _mm_unpackhi_epi16(low, zero);
+    values[2] = _mm_unpacklo_epi16(high, zero);
+    values[3] = _mm_unpackhi_epi16(high, zero);
+}
+
+inline __m128 exponentScale(__m128i exponents)
+{
+    const __m128i bias = _mm_set1_epi32(9);
+    const __m128i isNormal = _mm_cmpgt_epi32(exponents, bias);
+    return _mm_castsi128_ps(_mm_and_si128(_mm_slli_epi32(_mm_sub_epi32(exponents, bias), 23), isNormal));
+}
+
+inline __m128i toHalfBits(__m128 values)
+{
+    const __m128i normal = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(values), 13), _mm_set1_epi32((127 - 15) << 10));
+    const __m128i subnormal = _mm_cvtps_epi32(_mm_mul_ps(values, _mm_set1_ps(HalfSubnormalScale)));
+    const __m128i isSubnormal = _mm_castps_si128(_mm_cmplt_ps(values, _mm_set1_ps(MinNormalHalf)));
+    const __m128i isOverflow = _mm_castps_si128(_mm_cmpgt_ps(values, _mm_set1_ps(MaxHalf)));
+    __m128i bits = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    bits = _mm_or_si128(_mm_and_si128(isOverflow, _mm_set1_epi32(MaxHalfBits)), _mm_andnot_si128(isOverflow, bits));
+    return bits;
+}
+#endif
+
+template<QImageData::ValueType Type>
+void expandTexels(const uchar *planes, int width, uchar *output)
+{
+    const uchar *planeR = planes;
+    const uchar *planeG = planes + size_t(width);
+    const uchar *planeB = planes + size_t(width) * 2;
+    const uchar *planeE = planes + size_t(width) * 3;
+
+    int x = 0;
+#if defined(QUARTZ_RGBE_SSE2)
+    for(; x + 16 <= width; x += 16) {
+        __m128i r[4], g[4], b[4], e[4];
+        expandBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(planeR + x)), r);
+        expandBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(planeG + x)), g);
+        expandBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(planeB + x)), b);
+        expandBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(planeE + x)), e);
+
+        for(int i=0; i<4; ++i) {
+            const __m128 scale = exponentScale(e[i]);
+            __m128 red = _mm_mul_ps(_mm_cvtepi32_ps(r[i]), scale);
+            __m128 green = _mm_mul_ps(_mm_cvtepi32_ps(g[i]), scale);
+            __m128 blue = _mm_mul_ps(_mm_cvtepi32_ps(b[i]), scale);
+            if(Type == QImageData::ValueType::Float32) {
+                __m128 alpha = _mm_set1_ps(1.0f);
+                _MM_TRANSPOSE4_PS(red, green, blue, alpha);
+                float *texels = reinterpret_cast<float*>(output) + size_t(x + 4 * i) * 4;
+                _mm_storeu_ps(texels + 0, red);
+                _mm_storeu_ps(texels + 4, green);
+                _mm_storeu_ps(texels + 8, blue);
+                _mm_storeu_ps(texels + 12, alpha);
+            }
+            else {
+                const __m128i redGreen = _mm_packs_epi32(toHalfBits(red), toHalfBits(green));
+                const __m128i blueAlpha = _mm_packs_epi32(toHalfBits(blue), _mm_set1_epi32(OneHalfBits));
+                const __m128i redBlue = _mm_unpacklo_epi16(redGreen, blueAlpha);
+                const __m128i greenAlpha = _mm_unpackhi_epi16(redGreen, blueAlpha);
+                quint16 *texels = reinterpret_cast<quint16*>(output) + size_t(x + 4 * i) * 4;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + 0), _mm_unpacklo_epi16(redBlue, greenAlpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + 8), _mm_unpackhi_epi16(redBlue, greenAlpha));
+            }
+        }
+    }
+#endif
+    for(; x < width; ++x) {
+        const float scale = exponentScale(planeE[x]);
+        const float rgb[3] = { planeR[x] * scale, planeG[x] * scale, planeB[x] * scale };
+        if(Type == QImageData::ValueType::Float32) {
+            float *texel = reinterpret_cast<float*>(output) + size_t(x) * 4;
+            texel[0] = rgb[0];
+            texel[1] = rgb[1];
+            texel[2] = rgb[2];
+            texel[3] = 1.0f;
+        }
+        else {
+            quint16 *texel = reinterpret_cast<quint16*>(output) + size_t(x) * 4;
+            texel[0] = toHalfBits(rgb[0]);
+            texel[1] = toHalfBits(rgb[1]);
+            texel[2] = toHalfBits(rgb[2]);
+            texel[3] = OneHalfBits;
+        }
+    }
+}
+
+// Converts floating point RGBA texels to separate planes of red, green, blue and exponent bytes.
+void packTexels(const float *texels, int width, uchar *planes)
+{
+    uchar *planeR = planes;
+    uchar *planeG = planes + size_t(width);
+    uchar *planeB = planes + size_t(width) * 2;
+    uchar *planeE = planes + size_t(width) * 3;
+
+    int x = 0;
+#if defined(QUARTZ_RGBE_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 maxValue = _mm_set1_ps(MaxEncodedValue);
+    for(; x + 4 <= width; x += 4) {
+        __m128 red = _mm_loadu_ps(texels + size_t(x) * 4 + 0);
+        __m128 green = _mm_loadu_ps(texels + size_t(x) * 4 + 4);
+        __m128 blue = _mm_loadu_ps(texels + size_t(x) * 4 + 8);
+        __m128 alpha = _mm_loadu_ps(texels + size_t(x) * 4 + 12);
+        _MM_TRANSPOSE4_PS(red, green, blue, alpha);
+
+        // Maximum with zero as second operand also replaces NaNs with zeros.
+        red = _mm_min_ps(_mm_max_ps(red, zero), maxValue);
+        green = _mm_min_ps(_mm_max_ps(green, zero), maxValue);
+        blue = _mm_min_ps(_mm_max_ps(blue, zero), maxValue);
+
+        // Same as frexp(): maxComponent = m * 2^e with m in [0.5, 1), biased exponent is e + 126.
+        const __m128 maxComponent = _mm_max_ps(red, _mm_max_ps(green, blue));
+        const __m128i biasedExponent = _mm_srli_epi32(_mm_castps_si128(maxComponent), 23);
+        const __m128 normalize = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(_mm_set1_epi32(261), biasedExponent), 23));
+        const __m128i isNonZero = _mm_castps_si128(_mm_cmpge_ps(maxComponent, _mm_set1_ps(MinEncodedValue)));
+
+        const __m128i r = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(red, normalize)), isNonZero);
+        const __m128i g = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(green, normalize)), isNonZero);
+        const __m128i b = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(blue, normalize)), isNonZero);
+        const __m128i e = _mm_and_si128(_mm_add_epi32(biasedExponent, _mm_set1_epi32(2)), isNonZero);
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(r, g), _mm_packs_epi32(b, e));
+
+        const int packed[4] = {
+            _mm_cvtsi128_si32(bytes),
+            _mm_cvtsi128_si32(_mm_srli_si128(bytes, 4)),
+            _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)),
+            _mm_cvtsi128_si32(_mm_srli_si128(bytes, 12)),
+        };
+        std::memcpy(planeR + x, &packed[0], 4);
+        std::memcpy(planeG + x, &packed[1], 4);
+        std::memcpy(planeB + x, &packed[2], 4);
+        std::memcpy(planeE + x, &packed[3], 4);
+    }
+#endif
+    for(; x < width; ++x) {
+        const float *texel = texels + size_t(x) * 4;
+        float rgb[3];
+        for(int c=0; c<3; ++c) {
+            rgb[c] = (texel[c] > 0.0f) ? std::min(texel[c], MaxEncodedValue) : 0.0f;
+        }
+        const float maxComponent = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+        if(maxComponent < MinEncodedValue) {
+            planeR[x] = planeG[x] = planeB[x] = planeE[x] = 0;
+            continue;
+        }
+        int exponent;
+        std::frexp(maxComponent, &exponent);
+        const float normalize = std::ldexp(1.0f, 8 - exponent);
+        planeR[x] = uchar(rgb[0] * normalize);
+        planeG[x] = uchar(rgb[1] * normalize);
+        planeB[x] = uchar(rgb[2] * normalize);
+        planeE[x] = uchar(exponent + 128);
+    }
+}
+
+// Returns position of the first run of at least three equal bytes, starting at or after x, or width if there are none.
+int findRun(const uchar *plane, int x, int width)
+{
+#if defined(QUARTZ_RGBE_SSE2)
+    for(; x + 18 <= width; x += 16) {
+        const __m128i bytes0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + x));
+        const __m128i bytes1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + x + 1));
+        const __m128i bytes2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + x + 2));
+        const int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bytes0, bytes1), _mm_cmpeq_epi8(bytes0, bytes2)));
+        if(mask != 0) {
+            return x + int(qCountTrailingZeroBits(quint32(mask)));
+        }
+    }
+#endif
+    for(; x + 2 < width; ++x) {
+        if(plane[x] == plane[x + 1] && plane[x] == plane[x + 2]) {
+            return x;
+        }
+    }
+    return width;
+}
+
+// Returns position of the first byte after a run starting at x.
+int findRunEnd(const uchar *plane, int x, int width)
+{
+    const uchar value = plane[x];
+#if defined(QUARTZ_RGBE_SSE2)
+    const __m128i values = _mm_set1_epi8(char(value));
+    for(; x + 16 <= width; x += 16) {
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(plane + x)), values));
+        if(mask != 0xFFFF) {
+            return x + int(qCountTrailingZeroBits(quint32(~mask)));
+        }
+    }
+#endif
+    while(x < width && plane[x] == value) {
+        ++x;
+    }
+    return x;
+}
+
+uchar *encodePlane(const uchar *plane, int width, uchar *output)
+{
+    for(int x=0; x<width;) {
+        const int runStart = findRun(plane, x, width);
+        while(x < runStart) {
+            const int literalLength = std::min(MaxLiteralLength, runStart - x);
+            *output++ = uchar(literalLength);
+            std::memcpy(output, plane + x, size_t(literalLength));
+            output += literalLength;
+            x += literalLength;
+        }
+        if(runStart < width) {
+            const int runEnd = findRunEnd(plane, runStart, width);
+            while(x < runEnd) {
+                const int runLength = std::min(MaxRunLength, runEnd - x);
+                *output++ = uchar(128 + runLength);
+                *output++ = plane[x];
+                x += runLength;
+            }
+        }
+    }
+    return output;
+}
+
+uchar *encodeScanline(const uchar *planes, int width, uchar *output)
+{
+    if(width < MinEncodedWidth || width > MaxEncodedWidth) {
+        for(int x=0; x<width; ++x) {
+            for(int c=0; c<4; ++c) {
+                *output++ = planes[size_t(c) * size_t(width) + size_t(x)];
+            }
+        }
+        return output;
+    }
+
+    *output++ = 2;
+    *output++ = 2;
+    *output++ = uchar(width >> 8);
+    *output++ = uchar(width & 0xFF);
+    for(int c=0; c<4; ++c) {
+        output = encodePlane(planes + size_t(c) * size_t(width), width, output);
+    }
+    return output;
+}
+
+size_t maxEncodedScanlineSize(int width)
+{
+    // Literals cost one additional byte per up to 128 bytes, while runs never take more space than the bytes they encode.
+    return 4 + 4 * (size_t(width) + size_t(width) / MaxLiteralLength + 2);
+}
+
+// Loads texels of an image row as floating point RGBA.
+void loadTexels(const QImageData &image, int y, float *texels)
+{
+    const bool swapRB = (image.format == QImageData::Format::BGR || image.format == QImageData::Format::BGRA);
+    const size_t numValues = size_t(image.width) * size_t(image.channels);
+    const uchar *row = image.constBits() + size_t(y) * numValues * size_t(image.type);
+
+    for(int x=0; x<image.width; ++x) {
+        float *texel = texels + size_t(x) * 4;
+        const size_t offset = size_t(x) * size_t(image.channels);
+        if(image.type == QImageData::ValueType::Float32) {
+            std::memcpy(texel, row + offset * sizeof(float), 3 * sizeof(float));
+        }
+        else {
+            qFloatFromFloat16(texel, reinterpret_cast<const qfloat16*>(row) + offset, 3);
+        }
+        if(swapRB) {
+            std::swap(texel[0], texel[2]);
+        }
+        texel[3] = 1.0f;
+    }
+}
+
+} // anonymous
+
+bool isRgbeImage(const uchar *data, quint64 size)
+{
+    return size >= sizeof(Magic) && std::memcmp(data, Magic, sizeof(Magic)) == 0;
+}
+
+bool decodeRgbeImage(const uchar *data, quint64 size, QImageData::ValueType type, bool bottomUp, QImageData &image)
+{
+    using Utility::parallelFor;
+
+    if(type != QImageData::ValueType::Float16 && type != QImageData::ValueType::Float32) {
+        qCWarning(logImport) << "Cannot decode Radiance HDR image: output must be 16-bit or 32-bit floating point";
+        return false;
+    }
+
+    Header header;
+    if(!readHeader(data, size, header)) {
+        return false;
+    }
+
+    // Run-length encoded scanlines vary in size, so all of them are located up front to allow decoding in parallel.
+    std::vector<quint64> scanlineOffsets(size_t(header.height));
+    quint64 offset = header.dataOffset;
+    for(int y=0; y<header.height; ++y) {
+        scanlineOffsets[size_t(y)] = offset;
+        offset = skipScanline(data, size, offset, header.width);
+        if(offset == 0) {
+            qCWarning(logImport) << "Cannot decode Radiance HDR image: invalid or truncated scanline" << y;
+            return false;
+        }
+    }
+
+    QImageData result;
+    result.width = header.width;
+    result.height = header.height;
+    result.channels = 4;
+    result.type = type;
+    result.format = QImageData::Format::RGBA;
+
+    const quint64 resultSize = result.expectedSizeInBytes();
+    uchar *pixels = new (std::nothrow) uchar[resultSize];
+    if(!pixels) {
+        qCWarning(logImport) << "Cannot decode Radiance HDR image: failed to allocate memory for image";
+        return false;
+    }
+    result.storage = QDataStorage::fromRawData(pixels, resultSize, [pixels]() {
+        delete[] pixels;
+    });
+
+    const size_t rowSize = size_t(result.width) * 4 * size_t(type);
+    const bool flip = (bottomUp == header.isTopDown);
+    parallelFor(0, header.height, Config::DecodeGrainSize, [&](int begin, int end) {
+        std::vector<uchar> planes(size_t(header.width) * 4);
+        for(int y=begin; y<end; ++y) {
+            decodeScanline(data + scanlineOffsets[size_t(y)], header.width, planes.data());
+            uchar *row = pixels + size_t(flip ? header.height - 1 - y : y) * rowSize;
+            if(type == QImageData::ValueType::Float32) {
+                expandTexels<QImageData::ValueType::Float32>(planes.data(), header.width, row);
+            }
+            else {
+                expandTexels<QImageData::ValueType::Float16>(planes.data(), header.width, row);
+            }
+        }
+    });
+
+    image = result;
+    return true;
+}
+
+bool encodeRgbeImage(const QImageData &image, QIODevice *device)
+{
+    using Utility::parallelFor;
+
+    Q_ASSERT(device);
+
+    if(image.isCompressed() || image.channels < 3 ||
+       (image.type != QImageData::ValueType::Float16 && image.type != QImageData::ValueType::Float32)) {
+        qCWarning(logImport) << "Cannot encode Radiance HDR image: image must be 16-bit or 32-bit floating point RGB or RGBA";
+        return false;
+    }
+    if(image.width <= 0 || image.height <= 0 || image.sizeInBytes() < image.mipLevelSize(0)) {
+        qCWarning(logImport) << "Cannot encode Radiance HDR image: invalid image dimensions or incomplete image data";
+        return false;
+    }
+
+    // Rows of 32-bit floating point RGBA images are encoded in place, others are converted first.
+    const bool isNativeLayout = image.type == QImageData::ValueType::Float32 && image.channels == 4 && image.format == QImageData::Format::RGBA;
+    const size_t maxScanlineSize = maxEncodedScanlineSize(image.width);
+    const int numBands = (image.height + Config::EncodeBandHeight - 1) / Config::EncodeBandHeight;
+
+    QVector<QByteArray> bands(numBands);
+    parallelFor(0, numBands, 1, [&](int begin, int end) {
+        std::vector<float> texels(isNativeLayout ? 0 : size_t(image.width) * 4);
+        std::vector<uchar> planes(size_t(image.width) * 4);
+        for(int band=begin; band<end; ++band) {
+            const int firstRow = band * Config::EncodeBandHeight;
+            const int lastRow = std::min(firstRow + Config::EncodeBandHeight, image.height);
+
+            QByteArray &bandData = bands[band];
+            bandData.resize(int(maxScanlineSize * size_t(lastRow - firstRow)));
+            uchar *output = reinterpret_cast<uchar*>(bandData.data());
+            for(int y=firstRow; y<lastRow; ++y) {
+                const float *rowTexels;
+                if(isNativeLayout) {
+                    rowTexels = reinterpret_cast<const float*>(image.constBits()) + size_t(y) * size_t(image.width) * 4;
+                }
+                else {
+                    loadTexels(image, y, texels.data());
+                    rowTexels = texels.data();
+                }
+                packTexels(rowTexels, image.width, planes.data());
+                output = encodeScanline(planes.data(), image.width, output);
+            }
+            bandData.resize(int(output - reinterpret_cast<uchar*>(bandData.data())));
+        }
+    });
+
+    const QByteArray header = QStringLiteral("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %1 +X %2\n").arg(image.height).arg(image.width).toLatin1();
+    bool result = device->write(header) == header.size();
+    for(int i=0; result && i<bands.size(); ++i) {
+        result = device->write(bands[i]) == bands[i].size();
+    }
+    return result;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qimagedata.h>
+
+class QIODevice;
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Radiance RGBE (.hdr) image codec.
+//
+// Decoding first locates all scanlines in a single sequential pass over run-length encoded data, then decodes bands
+// of scanlines in parallel, expanding shared exponent texels with SIMD straight into 16-bit or 32-bit floating point
+// RGBA output. Values exceeding 16-bit floating point range are clamped to the largest finite half float.
+// Output rows are ordered bottom to top if bottomUp is set (as expected of texture images), top to bottom otherwise.
+bool decodeRgbeImage(const uchar *data, quint64 size, QImageData::ValueType type, bool bottomUp, QImageData &image);
+
+// Encodes first mip level of a 16-bit or 32-bit floating point RGB(A) image, with rows ordered top to bottom.
+// Scanlines are run-length encoded in parallel bands; alpha is discarded.
+bool encodeRgbeImage(const QImageData &image, QIODevice *device);
+
+bool isRgbeImage(const uchar *data, quint64 size);
+
+} // Raytrace
+} // Qt3DRaytrace
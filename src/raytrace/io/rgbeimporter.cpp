@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/common_p.h>
+#include <io/rgbeimporter_p.h>
+#include <io/rgbe_p.h>
+
+#include <QFile>
+#include <QFileInfo>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+bool RgbeImageImporter::import(const QUrl &url, QImageData &data)
+{
+    QFile imageFile(getAssetPathFromUrl(url));
+    if(!imageFile.open(QFile::ReadOnly)) {
+        qCCritical(logImport) << "Cannot open image file:" << url.toString();
+        return false;
+    }
+
+    qCInfo(logImport) << "Loading texture image:" << url.toString();
+
+    QByteArray fileBytes;
+    const quint64 fileSize = quint64(imageFile.size());
+    uchar *mappedData = imageFile.map(0, qint64(fileSize));
+    const uchar *fileData = mappedData;
+    if(!fileData) {
+        fileBytes = imageFile.readAll();
+        fileData = reinterpret_cast<const uchar*>(fileBytes.constData());
+    }
+
+    const quint64 dataSize = mappedData ? fileSize : quint64(fileBytes.size());
+    const bool result = decodeRgbeImage(fileData, dataSize, QImageData::ValueType::Float16, true, data);
+    if(mappedData) {
+        imageFile.unmap(mappedData);
+    }
+    if(!result) {
+        qCCritical(logImport) << "Failed to import Radiance HDR image:" << url.toString();
+    }
+    return result;
+}
+
+bool RgbeImageImporter::isSupported(const QUrl &url)
+{
+    return QFileInfo(url.path()).suffix().compare(QStringLiteral("hdr"), Qt::CaseInsensitive) == 0;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+#include <io/imageimporter_p.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Importer of Radiance RGBE (.hdr) images, decoded to 16-bit floating point RGBA.
+class RgbeImageImporter final : public ImageImporter
+{
+public:
+    bool import(const QUrl &url, QImageData &data) override;
+
+    static bool isSupported(const QUrl &url);
+};
+
+} // Raytrace
+} // Qt3DRaytrace
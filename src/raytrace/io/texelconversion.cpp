@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/texelconversion_p.h>
+
+#include <utility/parallelfor.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QUARTZ_TEXELCONVERSION_AVX2
+#define QUARTZ_TEXELCONVERSION_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define QUARTZ_TEXELCONVERSION_AVX2
+#define QUARTZ_TEXELCONVERSION_TARGET_AVX2
+#endif
+
+#if defined(QUARTZ_TEXELCONVERSION_AVX2)
+#include <QtCore/private/qsimd_p.h>
+#include <immintrin.h>
+#endif
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static constexpr int ConversionGrainSize = 64 * 1024;
+
+} // Config
+
+namespace {
+
+using ValueType = QImageData::ValueType;
+using Format = QImageData::Format;
+
+constexpr float MaxHalf = 65504.0f;
+constexpr quint8 OneUInt8 = 0xFF;
+constexpr quint16 OneHalfBits = 0x3C00;
+
+// Round to nearest even conversion of finite floats, bit exact with F16C.
+inline quint16 floatToHalf(float value)
+{
+    value = (value == value) ? std::min(std::max(value, -MaxHalf), MaxHalf) : 0.0f;
+
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(float));
+    const quint32 sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    quint32 halfBits;
+    if(bits < (113u << 23)) {
+        // Values below smallest normal half float are aligned and rounded by floating point addition.
+        constexpr quint32 SubnormalMagicBits = 126u << 23;
+        float subnormalMagic, absValue;
+        std::memcpy(&subnormalMagic, &SubnormalMagicBits, sizeof(float));
+        std::memcpy(&absValue, &bits, sizeof(float));
+        absValue += subnormalMagic;
+        std::memcpy(&halfBits, &absValue, sizeof(float));
+        halfBits -= SubnormalMagicBits;
+    }
+    else {
+        const quint32 mantissaOdd = (bits >> 13) & 1u;
+        halfBits = (bits - (112u << 23) + 0xFFFu + mantissaOdd) >> 13;
+    }
+    return quint16(halfBits | (sign >> 16));
+}
+
+template<typename T>
+void expandRGB(const T *src, T *dst, int numTexels, T alpha, bool swapRB)
+{
+    const int r = swapRB ? 2 : 0;
+    const int b = swapRB ? 0 : 2;
+    for(int i=0; i<numTexels; ++i, src += 3, dst += 4) {
+        dst[0] = src[r];
+        dst[1] = src[1];
+        dst[2] = src[b];
+        dst[3] = alpha;
+    }
+}
+
+template<typename T>
+void swapRGBA(const T *src, T *dst, int numTexels)
+{
+    for(int i=0; i<numTexels; ++i, src += 4, dst += 4) {
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = src[0];
+        dst[3] = src[3];
+    }
+}
+
+void convertFloat(const float *src, quint16 *dst, int numTexels, int channels, bool swapRB)
+{
+    for(int i=0; i<numTexels; ++i, src += channels, dst += channels) {
+        for(int c=0; c<channels; ++c) {
+            dst[c] = floatToHalf(src[c]);
+        }
+        if(swapRB) {
+            std::swap(dst[0], dst[2]);
+        }
+    }
+}
+
+void expandFloatRGB(const float *src, quint16 *dst, int numTexels, bool swapRB)
+{
+    const int r = swapRB ? 2 : 0;
+    const int b = swapRB ? 0 : 2;
+    for(int i=0; i<numTexels; ++i, src += 3, dst += 4) {
+        dst[0] = floatToHalf(src[r]);
+        dst[1] = floatToHalf(src[1]);
+        dst[2] = floatToHalf(src[b]);
+        dst[3] = OneHalfBits;
+    }
+}
+
+#if defined(QUARTZ_TEXELCONVERSION_AVX2)
+QUARTZ_TEXELCONVERSION_TARGET_AVX2
+inline __m128i floatToHalfAvx2(__m256 values)
+{
+    values = _mm256_and_ps(values, _mm256_cmp_ps(values, values, _CMP_ORD_Q));
+    values = _mm256_min_ps(_mm256_max_ps(values, _mm256_set1_ps(-MaxHalf)), _mm256_set1_ps(MaxHalf));
+    return _mm256_cvtps_ph(values, _MM_FROUND_TO_NEAREST_INT);
+}
+
+bool hasAvx2()
+{
+    static const bool result = qCpuHasFeature(AVX2) && qCpuHasFeature(F16C);
+    return result;
+}
+
+QUARTZ_TEXELCONVERSION_TARGET_AVX2
+void convertFloatAvx2(const float *src, quint16 *dst, int numTexels, int channels, bool swapRB)
+{
+    // Vectors of 8 values always hold whole texels since there are one, two or four channels.
+    const int numValues = numTexels * channels;
+    int i = 0;
+    for(; i + 8 <= numValues; i += 8) {
+        __m256 values = _mm256_loadu_ps(src + i);
+        if(swapRB) {
+            values = _mm256_permute_ps(values, _MM_SHUFFLE(3, 0, 1, 2));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), floatToHalfAvx2(values));
+    }
+    convertFloat(src + i, dst + i, (numValues - i) / channels, channels, swapRB);
+}
+
+QUARTZ_TEXELCONVERSION_TARGET_AVX2
+void expandFloatRGBAvx2(const float *src, quint16 *dst, int numTexels, bool swapRB)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    int i = 0;
+    // Each texel is loaded along with first value of the next one, which is then replaced with alpha.
+    for(; i + 5 <= numTexels; i += 4) {
+        const __m128 texel0 = _mm_blend_ps(_mm_loadu_ps(src + 3 * i + 0), one, 0x8);
+        const __m128 texel1 = _mm_blend_ps(_mm_loadu_ps(src + 3 * i + 3), one, 0x8);
+        const __m128 texel2 = _mm_blend_ps(_mm_loadu_ps(src + 3 * i + 6), one, 0x8);
+        const __m128 texel3 = _mm_blend_ps(_mm_loadu_ps(src + 3 * i + 9), one, 0x8);
+        __m256 texels01 = _mm256_insertf128_ps(_mm256_castps128_ps256(texel0), texel1, 1);
+        __m256 texels23 = _mm256_insertf128_ps(_mm256_castps128_ps256(texel2), texel3, 1);
+        if(swapRB) {
+            texels01 = _mm256_permute_ps(texels01, _MM_SHUFFLE(3, 0, 1, 2));
+            texels23 = _mm256_permute_ps(texels23, _MM_SHUFFLE(3, 0, 1, 2));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i + 0), floatToHalfAvx2(texels01));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i + 8), floatToHalfAvx2(texels23));
+    }
+    expandFloatRGB(src + 3 * i, dst + 4 * i, numTexels - i, swapRB);
+}
+
+QUARTZ_TEXELCONVERSION_TARGET_AVX2
+void expandUInt8RGBAvx2(const quint8 *src, quint8 *dst, int numTexels, bool swapRB)
+{
+    const __m256i shuffle = swapRB
+        ? _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                           2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+        : _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                           0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32(int(0xFF000000u));
+    int i = 0;
+    // Each lane takes 4 texels out of 16 loaded bytes.
+    for(; 3 * i + 28 <= 3 * numTexels; i += 8) {
+        const __m128i texels0123 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i + 0));
+        const __m128i texels4567 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i + 12));
+        const __m256i texels = _mm256_inserti128_si256(_mm256_castsi128_si256(texels0123), texels4567, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * i), _mm256_or_si256(_mm256_shuffle_epi8(texels, shuffle), alpha));
+    }
+    expandRGB<quint8>(src + 3 * i, dst + 4 * i, numTexels - i, OneUInt8, swapRB);
+}
+
+QUARTZ_TEXELCONVERSION_TARGET_AVX2
+void swapUInt8RGBAAvx2(const quint8 *src, quint8 *dst, int numTexels)
+{
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    int i = 0;
+    for(; i + 8 <= numTexels; i += 8) {
+        const __m256i texels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * i), _mm256_shuffle_epi8(texels, shuffle));
+    }
+    swapRGBA<quint8>(src + 4 * i, dst + 4 * i, numTexels - i);
+}
+#endif
+
+// Converts a contiguous range of texels; rows of both source and converted images are tightly packed.
+void convertTexelRange(const QImageData &image, const uchar *src, uchar *dst, int numTexels)
+{
+    const bool swapRB = (image.format == Format::BGR || image.format == Format::BGRA);
+#if defined(QUARTZ_TEXELCONVERSION_AVX2)
+    const bool useAvx2 = hasAvx2();
+#endif
+
+    switch(image.type) {
+    case ValueType::UInt8:
+        if(image.channels == 3) {
+#if defined(QUARTZ_TEXELCONVERSION_AVX2)
+            if(useAvx2) {
+                expandUInt8RGBAvx2(src, dst, numTexels, swapRB);
+                break;
+            }
+#endif
+            expandRGB<quint8>(src, dst, numTexels, OneUInt8, swapRB);
+        }
+        else {
+            Q_ASSERT(image.channels == 4 && swapRB);
+#if defined(QUARTZ_TEXELCONVERSION_AVX2)
+            if(useAvx2) {
+                swapUInt8RGBAAvx2(src, dst, numTexels);
+                break;
+            }
+#endif
+            swapRGBA<quint8>(src, dst, numTexels);
+        }
+        break;
+    case ValueType::Float16:
+        if(image.channels == 3) {
+            expandRGB<quint16>(reinterpret_cast<const quint16*>(src), reinterpret_cast<quint16*>(dst), numTexels, OneHalfBits, swapRB);
+        }
+        else {
+            Q_ASSERT(image.channels == 4 && swapRB);
+            swapRGBA<quint16>(reinterpret_cast<const quint16*>(src), reinterpret_cast<quint16*>(dst), numTexels);
+        }
+        break;
+    case ValueType::Float32:
+        if(image.channels == 3) {
+#if defined(QUARTZ_TEXELCONVERSION_AVX2)
+            if(useAvx2) {
+                expandFloatRGBAvx2(reinterpret_cast<const float*>(src), reinterpret_cast<quint16*>(dst), numTexels, swapRB);
+                break;
+            }
+#endif
+            expandFloatRGB(reinterpret_cast<const float*>(src), reinterpret_cast<quint16*>(dst), numTexels, swapRB);
+        }
+        else {
+            const bool swapChannels = swapRB && image.channels == 4;
+#if defined(QUARTZ_TEXELCONVERSION_AVX2)
+            if(useAvx2) {
+                convertFloatAvx2(reinterpret_cast<const float*>(src), reinterpret_cast<quint16*>(dst), numTexels, image.channels, swapChannels);
+                break;
+            }
+#endif
+            convertFloat(reinterpret_cast<const float*>(src), reinterpret_cast<quint16*>(dst), numTexels, image.channels, swapChannels);
+        }
+        break;
+    default:
+        Q_ASSERT_X(0, Q_FUNC_INFO, "Unsupported image value type");
+        break;
+    }
+}
+
+} // anonymous
+
+QImageData getConvertedTexelLayout(const QImageData &image)
+{
+    Q_ASSERT(!image.isCompressed());
+
+    QImageData layout;
+    layout.width = image.width;
+    layout.height = image.height;
+    layout.mipLevels = image.mipLevels;
+    layout.type = (image.type == ValueType::UInt8) ? ValueType::UInt8 : ValueType::Float16;
+    layout.channels = (image.channels == 3) ? 4 : image.channels;
+    if(layout.channels == 4) {
+        layout.format = Format::RGBA;
+    }
+    else {
+        layout.format = image.format;
+    }
+    return layout;
+}
+
+void convertTexels(const QImageData &image, int level, uchar *dst)
+{
+    using Utility::parallelFor;
+
+    Q_ASSERT(!image.isCompressed());
+    Q_ASSERT(level >= 0 && level < image.mipLevels);
+    Q_ASSERT(dst);
+
+    const QImageData layout = getConvertedTexelLayout(image);
+    const uchar *src = image.constMipBits(level);
+
+    const bool isSwapRequired = (image.format == Format::BGR || image.format == Format::BGRA) && image.channels >= 3;
+    if(layout.type == image.type && layout.channels == image.channels && !isSwapRequired) {
+        std::memcpy(dst, src, size_t(image.mipLevelSize(level)));
+        return;
+    }
+
+    const int width = image.mipWidth(level);
+    const int height = image.mipHeight(level);
+    const size_t srcRowSize = size_t(width) * size_t(image.channels) * size_t(image.type);
+    const size_t dstRowSize = size_t(width) * size_t(layout.channels) * size_t(layout.type);
+    const int grainSize = std::max(1, Config::ConversionGrainSize / width);
+    parallelFor(0, height, grainSize, [&](int begin, int end) {
+        convertTexelRange(image, src + size_t(begin) * srcRowSize, dst + size_t(begin) * dstRowSize, (end - begin) * width);
+    });
+}
+
+} // Raytrace
+} // Qt3DRaytrace
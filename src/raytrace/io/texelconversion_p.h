@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qimagedata.h>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// Conversion of uncompressed images to texel layouts stored by GPU textures as is: 8-bit unsigned or 16-bit floating
+// point values with one, two or four channels in RGB(A) order. Three channel images are expanded with opaque alpha.
+// 32-bit floating point values are rounded to nearest half float; NaNs become zero and values out of half float range
+// are clamped to the largest finite half float of the same sign.
+// Kernels use AVX2 & F16C if supported by the CPU at runtime, with scalar fallback producing identical results.
+
+// Returns description (without pixel data) of an image converted by convertTexels().
+QImageData getConvertedTexelLayout(const QImageData &image);
+
+// Converts a mip level of an uncompressed image, writing tightly packed texels to dst. Rows are converted in parallel.
+void convertTexels(const QImageData &image, int level, uchar *dst);
+
+} // Raytrace
+} // Qt3DRaytrace
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/texturecache_p.h>
+#include <io/meshcache_p.h>
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+#include <cstddef>
+#include <cstring>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+// Must be incremented whenever entry layout, mipmap generation or block compression encoders change.
+static constexpr quint32 FormatVersion = 2;
+static constexpr qint64 DefaultMaximumSizeMB = 4096;
+static constexpr qint64 PageSize = 4096;
+
+static const char *EnableEnvironmentVariable = "QUARTZ_TEXTURE_CACHE";
+static const char *DirectoryEnvironmentVariable = "QUARTZ_TEXTURE_CACHE_DIR";
+static const char *SizeEnvironmentVariable = "QUARTZ_TEXTURE_CACHE_SIZE";
+
+} // Config
+
+namespace {
+
+constexpr char EntryMagic[8] = { 'Q', 'Z', 'T', 'E', 'X', 'T', '\r', '\n' };
+constexpr quint32 ByteOrderMark = 0x01020304u;
+constexpr int SourceHashSize = 20;
+
+struct EntryHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrderMark;
+    uchar sourceHash[SourceHashSize];
+    quint32 generateMipmaps;
+    quint32 width;
+    quint32 height;
+    quint32 channels;
+    quint32 mipLevels;
+    quint32 type;
+    quint32 format;
+    quint32 blockFormat;
+    quint32 reserved;
+    quint64 dataOffset;
+    quint64 dataSize;
+    quint64 fileSize;
+    quint64 dataChecksum;
+    quint64 headerChecksum;
+};
+
+static_assert(sizeof(EntryHeader) <= Config::PageSize, "Texture cache entry header must fit in a single page");
+static_assert(offsetof(EntryHeader, dataOffset) == 72, "Texture cache entry header must not contain padding");
+
+inline quint64 alignToPage(quint64 offset)
+{
+    return (offset + Config::PageSize - 1) & ~quint64(Config::PageSize - 1);
+}
+
+inline quint64 headerChecksum(const EntryHeader &header)
+{
+    return MeshCache::computeChecksum(&header, qint64(offsetof(EntryHeader, headerChecksum)));
+}
+
+} // anonymous
+
+Q_GLOBAL_STATIC(TextureCache, textureCacheInstance)
+
+TextureCache::TextureCache()
+    : m_maximumSize(Config::DefaultMaximumSizeMB * 1024 * 1024)
+{
+    if(qEnvironmentVariableIsSet(Config::EnableEnvironmentVariable) && qEnvironmentVariableIntValue(Config::EnableEnvironmentVariable) == 0) {
+        return;
+    }
+
+    bool sizeIsValid = false;
+    const int maximumSizeMB = qEnvironmentVariableIntValue(Config::SizeEnvironmentVariable, &sizeIsValid);
+    if(sizeIsValid && maximumSizeMB > 0) {
+        m_maximumSize = qint64(maximumSizeMB) * 1024 * 1024;
+    }
+
+    QString cacheDirectory = QString::fromLocal8Bit(qgetenv(Config::DirectoryEnvironmentVariable));
+    if(cacheDirectory.isEmpty()) {
+        const QString genericCacheLocation = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+        if(genericCacheLocation.isEmpty()) {
+            return;
+        }
+        cacheDirectory = genericCacheLocation + QStringLiteral("/quartz/textures");
+    }
+    if(!QDir().mkpath(cacheDirectory)) {
+        qCWarning(logImport) << "Cannot create texture cache directory:" << cacheDirectory;
+        return;
+    }
+    m_cacheDirectory = QDir(cacheDirectory).absolutePath();
+}
+
+TextureCache *TextureCache::instance()
+{
+    return textureCacheInstance();
+}
+
+QByteArray TextureCache::computeSourceHash(const QString &sourcePath)
+{
+    QFile sourceFile(sourcePath);
+    if(!sourceFile.open(QFile::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if(!hash.addData(&sourceFile)) {
+        return QByteArray();
+    }
+    return hash.result();
+}
+
+QString TextureCache::entryPath(const QByteArray &sourceHash, bool generateMipmaps, QImageData::BlockFormat blockFormat) const
+{
+    return QStringLiteral("%1/%2-%3%4.qtc")
+            .arg(m_cacheDirectory)
+            .arg(QString::fromLatin1(sourceHash.toHex()))
+            .arg(int(blockFormat))
+            .arg(generateMipmaps ? QStringLiteral("m") : QString());
+}
+
+bool TextureCache::load(const QByteArray &sourceHash, bool generateMipmaps, QImageData::BlockFormat blockFormat, QImageData &data)
+{
+    if(!isEnabled() || sourceHash.size() != SourceHashSize) {
+        return false;
+    }
+
+    const QString path = entryPath(sourceHash, generateMipmaps, blockFormat);
+    QFile entryFile(path);
+    if(!entryFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    const qint64 entrySize = entryFile.size();
+    EntryHeader header;
+    if(entrySize < qint64(sizeof(EntryHeader)) || entryFile.read(reinterpret_cast<char*>(&header), sizeof(EntryHeader)) != qint64(sizeof(EntryHeader))) {
+        qCWarning(logImport) << "Removing truncated texture cache entry:" << path;
+        entryFile.remove();
+        return false;
+    }
+
+    const bool isCompatible =
+            std::memcmp(header.magic, EntryMagic, sizeof(EntryMagic)) == 0 &&
+            header.version == Config::FormatVersion &&
+            header.byteOrderMark == ByteOrderMark &&
+            header.headerChecksum == headerChecksum(header);
+
+    const bool isMatchingSource =
+            std::memcmp(header.sourceHash, sourceHash.constData(), SourceHashSize) == 0 &&
+            header.generateMipmaps == quint32(generateMipmaps) &&
+            header.blockFormat == quint32(blockFormat);
+
+    QImageData image;
+    image.width = int(header.width);
+    image.height = int(header.height);
+    image.channels = int(header.channels);
+    image.mipLevels = int(header.mipLevels);
+    image.type = QImageData::ValueType(header.type);
+    image.format = QImageData::Format(header.format);
+    image.blockFormat = QImageData::BlockFormat(header.blockFormat);
+
+    const bool isWellFormed =
+            header.width > 0 && header.width <= 65536 &&
+            header.height > 0 && header.height <= 65536 &&
+            header.mipLevels > 0 && int(header.mipLevels) <= QImageData::maxMipLevels(image.width, image.height) &&
+            image.isCompressed() &&
+            header.dataSize == image.expectedSizeInBytes() &&
+            header.fileSize == quint64(entrySize) &&
+            header.dataOffset >= sizeof(EntryHeader) &&
+            header.dataOffset + header.dataSize <= header.fileSize;
+
+    bool isValid = isCompatible && isMatchingSource && isWellFormed;
+    if(isValid) {
+        // Pixel data is mapped directly from the entry file instead of being copied.
+        // Mappings stay valid if the entry is later evicted or replaced since entries are never modified in place.
+        image.storage = QDataStorage::fromFile(path, header.dataOffset, header.dataSize);
+        isValid = image.storage && MeshCache::computeChecksum(image.storage->data(), qint64(header.dataSize)) == header.dataChecksum;
+    }
+    entryFile.close();
+
+    if(!isValid) {
+        if(isCompatible && isMatchingSource) {
+            qCWarning(logImport) << "Removing corrupted texture cache entry:" << path;
+        }
+        QFile::remove(path);
+        return false;
+    }
+    data = image;
+
+    // Modification time of cache entries tracks their last use for LRU eviction.
+    QFile touchFile(path);
+    if(touchFile.open(QFile::Append)) {
+        touchFile.setFileTime(QDateTime::currentDateTimeUtc(), QFileDevice::FileModificationTime);
+    }
+    return true;
+}
+
+bool TextureCache::store(const QByteArray &sourceHash, bool generateMipmaps, const QImageData &data)
+{
+    if(!isEnabled() || sourceHash.size() != SourceHashSize || !data.isCompressed()) {
+        return false;
+    }
+
+    const quint64 dataSize = data.expectedSizeInBytes();
+    if(data.sizeInBytes() < dataSize) {
+        return false;
+    }
+
+    EntryHeader header = {};
+    std::memcpy(header.magic, EntryMagic, sizeof(EntryMagic));
+    header.version = Config::FormatVersion;
+    header.byteOrderMark = ByteOrderMark;
+    std::memcpy(header.sourceHash, sourceHash.constData(), SourceHashSize);
+    header.generateMipmaps = quint32(generateMipmaps);
+    header.width = quint32(data.width);
+    header.height = quint32(data.height);
+    header.channels = quint32(data.channels);
+    header.mipLevels = quint32(data.mipLevels);
+    header.type = quint32(data.type);
+    header.format = quint32(data.format);
+    header.blockFormat = quint32(data.blockFormat);
+    header.dataOffset = alignToPage(sizeof(EntryHeader));
+    header.dataSize = dataSize;
+    header.fileSize = header.dataOffset + dataSize;
+    header.dataChecksum = MeshCache::computeChecksum(data.constBits(), qint64(dataSize));
+    header.headerChecksum = headerChecksum(header);
+
+    if(qint64(header.fileSize) > m_maximumSize) {
+        return false;
+    }
+    evictEntries(qint64(header.fileSize));
+
+    // Entries are written to a temporary file and atomically renamed so that readers never observe partial writes.
+    const QString path = entryPath(sourceHash, generateMipmaps, data.blockFormat);
+    QSaveFile entryFile(path);
+    if(!entryFile.open(QFile::WriteOnly)) {
+        qCWarning(logImport) << "Cannot create texture cache entry:" << path;
+        return false;
+    }
+
+    QByteArray headerPage(int(header.dataOffset), '\0');
+    std::memcpy(headerPage.data(), &header, sizeof(EntryHeader));
+    entryFile.write(headerPage);
+    entryFile.write(reinterpret_cast<const char*>(data.constBits()), qint64(dataSize));
+
+    if(!entryFile.commit()) {
+        qCWarning(logImport) << "Cannot write texture cache entry:" << path << entryFile.errorString();
+        return false;
+    }
+    return true;
+}
+
+void TextureCache::evictEntries(qint64 reservedSize)
+{
+    QMutexLocker lock(&m_evictionMutex);
+
+    const QDir cacheDirectory(m_cacheDirectory);
+    const QFileInfoList entries = cacheDirectory.entryInfoList({ QStringLiteral("*.qtc") }, QDir::Files, QDir::Time | QDir::Reversed);
+
+    qint64 totalSize = reservedSize;
+    for(const QFileInfo &entry : entries) {
+        totalSize += entry.size();
+    }
+    for(const QFileInfo &entry : entries) {
+        if(totalSize <= m_maximumSize) {
+            break;
+        }
+        if(QFile::remove(entry.absoluteFilePath())) {
+            totalSize -= entry.size();
+        }
+    }
+}
+
+} // Raytrace
+} // Qt3DRaytrace
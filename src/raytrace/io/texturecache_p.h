@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <qt3draytrace_global_p.h>
+
+#include <Qt3DRaytrace/qimagedata.h>
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+// On-disk cache of block compressed textures.
+// Entries are content-addressed: keyed by a hash of source image file contents together with post-processing options,
+// so that renamed or copied images still hit the cache while edited ones miss it. Pixel data of all mip levels is stored
+// in a page-aligned binary layout that is memory mapped and used directly as image storage on load.
+// Least recently used entries are evicted once total cache size exceeds the configured limit.
+//
+// Cache is configured through environment variables:
+//   QUARTZ_TEXTURE_CACHE       Set to 0 to disable the cache.
+//   QUARTZ_TEXTURE_CACHE_DIR   Cache directory (defaults to "quartz/textures" in generic cache location).
+//   QUARTZ_TEXTURE_CACHE_SIZE  Maximum cache size in megabytes.
+class TextureCache
+{
+public:
+    TextureCache();
+
+    static TextureCache *instance();
+
+    bool isEnabled() const { return !m_cacheDirectory.isEmpty(); }
+
+    bool load(const QByteArray &sourceHash, bool generateMipmaps, QImageData::BlockFormat blockFormat, QImageData &data);
+    bool store(const QByteArray &sourceHash, bool generateMipmaps, const QImageData &data);
+
+    // Returns hash of source file contents or empty byte array if the file cannot be read.
+    static QByteArray computeSourceHash(const QString &sourcePath);
+
+private:
+    QString entryPath(const QByteArray &sourceHash, bool generateMipmaps, QImageData::BlockFormat blockFormat) const;
+    void evictEntries(qint64 reservedSize);
+
+    QString m_cacheDirectory;
+    qint64 m_maximumSize;
+    QMutex m_evictionMutex;
+};
+
+} // Raytrace
+} // Qt3DRaytrace
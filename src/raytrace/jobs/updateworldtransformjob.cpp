@@ -5,36 +5,17 @@
  */
 
 #include <jobs/updateworldtransformjob_p.h>
-#include <backend/entity_p.h>
-#include <backend/transform_p.h>
+#include <backend/managers_p.h>
 
 namespace Qt3DRaytrace {
 namespace Raytrace {
 
-static void updateWorldTransform(Entity *entity, const Matrix4x4 &parentTransformMatrix)
-{
-    Matrix4x4 worldTransformMatrix = parentTransformMatrix;
-    const Transform *transform = entity->transformComponent();
-    if(transform) {
-        worldTransformMatrix *= transform->transformMatrix();
-    }
-    entity->worldTransformMatrix = worldTransformMatrix;
-
-    for(Entity *childEntity : entity->children()) {
-        updateWorldTransform(childEntity, worldTransformMatrix);
-    }
-}
-
 void UpdateWorldTransformJob::run()
 {
     Q_ASSERT(m_rootEntity);
+    Q_ASSERT(m_nodeManagers);
 
-    Matrix4x4 parentTransformMatrix;
-    Entity *parent = m_rootEntity->parent();
-    if(parent) {
-        parentTransformMatrix = parent->worldTransformMatrix;
-    }
-    updateWorldTransform(m_rootEntity, parentTransformMatrix);
+    m_nodeManagers->worldTransformManager.update(m_nodeManagers, m_rootEntity);
 }
 
 } // Raytrace
@@ -11,6 +11,7 @@
 namespace Qt3DRaytrace {
 namespace Raytrace {
 
+struct NodeManagers;
 class Entity;
 
 class UpdateWorldTransformJob final : public Qt3DCore::QAspectJob
@@ -20,10 +21,15 @@ public:
     {
         m_rootEntity = root;
     }
+    void setManagers(NodeManagers *managers)
+    {
+        m_nodeManagers = managers;
+    }
     void run() override;
 
 private:
     Entity *m_rootEntity = nullptr;
+    NodeManagers *m_nodeManagers = nullptr;
 };
 
 using UpdateWorldTransformJobPtr = QSharedPointer<UpdateWorldTransformJob>;
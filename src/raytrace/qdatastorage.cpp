@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <Qt3DRaytrace/qdatastorage.h>
+
+#include <QFile>
+
+namespace Qt3DRaytrace {
+
+namespace {
+
+class ByteArrayStorage final : public QDataStorage
+{
+public:
+    explicit ByteArrayStorage(const QByteArray &data)
+        : m_data(data)
+    {}
+
+    const uchar *data() const override { return reinterpret_cast<const uchar*>(m_data.constData()); }
+    quint64 size() const override { return quint64(m_data.size()); }
+
+private:
+    QByteArray m_data;
+};
+
+class RawDataStorage final : public QDataStorage
+{
+public:
+    RawDataStorage(const uchar *data, quint64 size, std::function<void()> release)
+        : m_data(data)
+        , m_size(size)
+        , m_release(std::move(release))
+    {}
+    ~RawDataStorage() override
+    {
+        if(m_release) {
+            m_release();
+        }
+    }
+
+    const uchar *data() const override { return m_data; }
+    quint64 size() const override { return m_size; }
+
+private:
+    const uchar *m_data;
+    quint64 m_size;
+    std::function<void()> m_release;
+};
+
+class MappedFileStorage final : public QDataStorage
+{
+public:
+    explicit MappedFileStorage(const QString &path)
+        : m_file(path)
+    {}
+    ~MappedFileStorage() override
+    {
+        if(m_data) {
+            m_file.unmap(m_data);
+        }
+    }
+
+    bool map(quint64 offset, quint64 size)
+    {
+        if(!m_file.open(QFile::ReadOnly)) {
+            return false;
+        }
+        const quint64 fileSize = quint64(m_file.size());
+        if(offset > fileSize) {
+            return false;
+        }
+        if(size == 0) {
+            size = fileSize - offset;
+        }
+        if(size == 0 || size > fileSize - offset) {
+            return false;
+        }
+        m_data = m_file.map(qint64(offset), qint64(size));
+        m_size = size;
+        // Mapping stays valid after the file is closed.
+        m_file.close();
+        return m_data != nullptr;
+    }
+
+    const uchar *data() const override { return m_data; }
+    quint64 size() const override { return m_size; }
+
+private:
+    QFile m_file;
+    uchar *m_data = nullptr;
+    quint64 m_size = 0;
+};
+
+} // anonymous
+
+QDataStoragePtr QDataStorage::fromByteArray(const QByteArray &data)
+{
+    return QDataStoragePtr(new ByteArrayStorage(data));
+}
+
+QDataStoragePtr QDataStorage::fromRawData(const uchar *data, quint64 size, std::function<void()> release)
+{
+    return QDataStoragePtr(new RawDataStorage(data, size, std::move(release)));
+}
+
+QDataStoragePtr QDataStorage::fromFile(const QString &path, quint64 offset, quint64 size)
+{
+    QSharedPointer<MappedFileStorage> storage(new MappedFileStorage(path));
+    if(!storage->map(offset, size)) {
+        return QDataStoragePtr();
+    }
+    return storage;
+}
+
+} // Qt3DRaytrace
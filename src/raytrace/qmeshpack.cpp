@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <Qt3DRaytrace/qmeshpack.h>
+
+#include <frontend/qmesh_p.h>
+#include <io/defaultmeshimporter_p.h>
+#include <io/meshpack_p.h>
+#include <io/meshprocessing_p.h>
+
+#include <QScopedPointer>
+
+namespace Qt3DRaytrace {
+
+bool QMeshPack::importMesh(const QUrl &source, QGeometryData &data)
+{
+    QScopedPointer<Raytrace::MeshImporter> importer(createMeshImporter(source));
+    return importer->import(source, data);
+}
+
+bool QMeshPack::importMeshWithAssimp(const QUrl &source, QGeometryData &data)
+{
+    return Raytrace::DefaultMeshImporter().import(source, data);
+}
+
+void QMeshPack::optimizeMesh(QGeometryData &data)
+{
+    Raytrace::optimizeMesh(data);
+}
+
+bool QMeshPack::encode(const QGeometryData &data, QIODevice *device)
+{
+    return Raytrace::encodeMeshPack(data, device);
+}
+
+bool QMeshPack::decode(const uchar *packData, quint64 packSize, QGeometryData &data)
+{
+    return Raytrace::decodeMeshPack(packData, packSize, data);
+}
+
+} // Qt3DRaytrace
@@ -22,11 +22,13 @@
 #include <Qt3DRaytrace/qcameralens.h>
 #include <Qt3DRaytrace/qrendersettings.h>
 
-#include <renderers/vulkan/renderer.h>
+#include <renderers/rendererfactory.h>
 
 #include <jobs/loadgeometryjob_p.h>
 #include <jobs/loadtexturejob_p.h>
 
+#include <io/assetcache_p.h>
+
 using namespace Qt3DCore;
 
 namespace Qt3DRaytrace {
@@ -44,6 +46,8 @@ void QRaytraceAspectPrivate::registerBackendTypes()
     qRegisterMetaType<Qt3DRaytrace::QImageData>();
     qRegisterMetaType<Qt3DRaytrace::QImageDataPtr>();
     qRegisterMetaType<Qt3DRaytrace::QRenderImage>();
+    qRegisterMetaType<Qt3DRaytrace::QAssetStatistics>();
+    qRegisterMetaType<Qt3DRaytrace::QAssetLoadSummary>();
 
     qRegisterMetaType<Qt3DRaytrace::QCamera*>();
     qRegisterMetaType<Qt3DRaytrace::QGeometry*>();
@@ -52,8 +56,7 @@ void QRaytraceAspectPrivate::registerBackendTypes()
 
     q->registerBackendType<Qt3DCore::QEntity>(QSharedPointer<Raytrace::EntityMapper>::create(m_nodeManagers.get(), m_renderer.get()));
 
-    using TransformNodeMapper = Raytrace::BackendNodeMapper<Raytrace::Transform, Raytrace::TransformManager>;
-    q->registerBackendType<Qt3DCore::QTransform>(QSharedPointer<TransformNodeMapper>::create(&m_nodeManagers->transformManager, m_renderer.get()));
+    q->registerBackendType<Qt3DCore::QTransform>(QSharedPointer<Raytrace::TransformNodeMapper>::create(&m_nodeManagers->transformManager, m_renderer.get()));
 
     using CameraLensNodeMapper = Raytrace::BackendNodeMapper<Raytrace::CameraLens, Raytrace::CameraManager>;
     q->registerBackendType<QCameraLens>(QSharedPointer<CameraLensNodeMapper>::create(&m_nodeManagers->cameraManager, m_renderer.get()));
@@ -62,8 +65,8 @@ void QRaytraceAspectPrivate::registerBackendTypes()
     q->registerBackendType<QDistantLight>(QSharedPointer<DistantLightNodeMapper>::create(&m_nodeManagers->distantLightManager, m_renderer.get()));
 
     q->registerBackendType<QGeometry>(QSharedPointer<Raytrace::GeometryNodeMapper>::create(&m_nodeManagers->geometryManager, m_renderer.get()));
-    q->registerBackendType<QGeometryRenderer>(QSharedPointer<Raytrace::GeometryRendererNodeMapper>::create(&m_nodeManagers->geometryRendererManager, m_renderer.get()));
-    q->registerBackendType<QAbstractTexture>(QSharedPointer<Raytrace::TextureNodeMapper>::create(&m_nodeManagers->textureManager, m_renderer.get()));
+    q->registerBackendType<QGeometryRenderer>(QSharedPointer<Raytrace::GeometryRendererNodeMapper>::create(&m_nodeManagers->geometryRendererManager, &m_nodeManagers->assetStatisticsManager, m_renderer.get()));
+    q->registerBackendType<QAbstractTexture>(QSharedPointer<Raytrace::TextureNodeMapper>::create(&m_nodeManagers->textureManager, &m_nodeManagers->assetStatisticsManager, m_renderer.get()));
     q->registerBackendType<QTextureImage>(QSharedPointer<Raytrace::TextureImageNodeMapper>::create(&m_nodeManagers->textureImageManager, m_renderer.get()));
     q->registerBackendType<QMaterial>(QSharedPointer<Raytrace::MaterialNodeMapper>::create(&m_nodeManagers->materialManager, m_renderer.get()));
 
@@ -135,6 +138,36 @@ void QRaytraceAspect::setSurface(QObject *surfaceObject)
     }
 }
 
+QString QRaytraceAspect::renderer() const
+{
+    Q_D(const QRaytraceAspect);
+    return d->m_rendererName.isEmpty() ? defaultRenderer() : d->m_rendererName;
+}
+
+void QRaytraceAspect::setRenderer(const QString &renderer)
+{
+    Q_D(QRaytraceAspect);
+    if(d->m_renderer) {
+        qCWarning(logAspect) << "Renderer must be set before the aspect is registered with an aspect engine";
+        return;
+    }
+    const QString rendererName = renderer.trimmed().toLower();
+    if(d->m_rendererName != rendererName) {
+        d->m_rendererName = rendererName;
+        emit rendererChanged(this->renderer());
+    }
+}
+
+QStringList QRaytraceAspect::availableRenderers()
+{
+    return Raytrace::RendererFactory::availableRenderers();
+}
+
+QString QRaytraceAspect::defaultRenderer()
+{
+    return Raytrace::RendererFactory::defaultRenderer();
+}
+
 bool QRaytraceAspect::queryRenderStatistics(QRenderStatistics &statistics) const
 {
     Q_D(const QRaytraceAspect);
@@ -146,6 +179,19 @@ bool QRaytraceAspect::queryRenderStatistics(QRenderStatistics &statistics) const
     return false;
 }
 
+QAssetLoadSummary QRaytraceAspect::assetLoadSummary() const
+{
+    Q_D(const QRaytraceAspect);
+
+    QAssetLoadSummary summary;
+    if(d->m_nodeManagers) {
+        summary = d->m_nodeManagers->assetStatisticsManager.summary();
+    }
+    summary.numCacheHits = Raytrace::AssetCache::instance()->numHits();
+    summary.numCacheMisses = Raytrace::AssetCache::instance()->numMisses();
+    return summary;
+}
+
 void QRaytraceAspect::suspendJobs()
 {
     Q_D(QRaytraceAspect);
@@ -170,7 +216,7 @@ void QRaytraceAspect::grabImage(QRenderImage type)
     if(d->m_renderer) {
         QImageDataPtr image(new QImageData);
         *image = d->m_renderer->grabImage(type);
-        if(!image->data.isEmpty()) {
+        if(!image->isEmpty()) {
             emit imageReady(type, image);
         }
     }
@@ -192,6 +238,9 @@ QVector<QAspectJobPtr> QRaytraceAspect::jobsToExecute(qint64 time)
         return jobs;
     }
 
+    // Resolve component handles of entities whose components were created after the entity itself.
+    d->m_nodeManagers->entityComponentTable.resolvePendingComponents();
+
     jobs.append(d->createGeometryRendererJobs());
     jobs.append(d->createTextureJobs());
     if(d->m_renderer) {
@@ -207,8 +256,17 @@ void QRaytraceAspect::onRegistered()
 
     d->m_nodeManagers.reset(new Raytrace::NodeManagers);
 
-    // TODO: Make renderer configurable.
-    d->m_renderer.reset(new Vulkan::Renderer);
+    if(d->m_rendererName.isEmpty()) {
+        d->m_rendererName = Raytrace::RendererFactory::defaultRenderer();
+    }
+    d->m_renderer.reset(Raytrace::RendererFactory::createRenderer(d->m_rendererName));
+    if(!d->m_renderer) {
+        const QString fallbackRendererName = QStringLiteral("vulkan");
+        qCWarning(logAspect) << "Unknown renderer:" << d->m_rendererName << "- falling back to" << fallbackRendererName;
+        d->m_rendererName = fallbackRendererName;
+        d->m_renderer.reset(Raytrace::RendererFactory::createRenderer(d->m_rendererName));
+    }
+    qCInfo(logAspect) << "Using renderer:" << d->m_rendererName;
     d->m_renderer->setNodeManagers(d->m_nodeManagers.get());
 
     d->updateServiceProviders();
@@ -26,6 +26,7 @@ public:
     QVector<Qt3DCore::QAspectJobPtr> createGeometryRendererJobs() const;
     QVector<Qt3DCore::QAspectJobPtr> createTextureJobs() const;
 
+    QString m_rendererName;
     QScopedPointer<Raytrace::AbstractRenderer> m_renderer;
     QScopedPointer<Raytrace::NodeManagers> m_nodeManagers;
     bool m_jobsSuspended = false;
@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <Qt3DRaytrace/qrgbeimage.h>
+
+#include <io/rgbe_p.h>
+
+namespace Qt3DRaytrace {
+
+bool QRgbeImage::encode(const QImageData &image, QIODevice *device)
+{
+    return Raytrace::encodeRgbeImage(image, device);
+}
+
+bool QRgbeImage::decode(const uchar *imageData, quint64 imageSize, QImageData &image, QImageData::ValueType type)
+{
+    return Raytrace::decodeRgbeImage(imageData, imageSize, type, false, image);
+}
+
+} // Qt3DRaytrace
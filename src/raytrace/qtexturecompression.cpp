@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <Qt3DRaytrace/qtexturecompression.h>
+
+#include <frontend/qtexture_p.h>
+#include <io/imageprocessing_p.h>
+#include <io/blockcompression_p.h>
+
+#include <QtCore/qfloat16.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Qt3DRaytrace {
+
+static double readValue(const QImageData &image, quint64 index)
+{
+    const uchar *value = image.constBits() + index * quint64(image.type);
+    switch(image.type) {
+    case QImageData::ValueType::UInt8:
+        return double(*value);
+    case QImageData::ValueType::Float16: {
+        qfloat16 halfValue;
+        std::memcpy(&halfValue, value, sizeof(halfValue));
+        return double(float(halfValue));
+    }
+    case QImageData::ValueType::Float32: {
+        float floatValue;
+        std::memcpy(&floatValue, value, sizeof(floatValue));
+        return double(floatValue);
+    }
+    default:
+        return 0.0;
+    }
+}
+
+bool QTextureCompression::importImage(const QUrl &source, QImageData &data)
+{
+    QScopedPointer<Raytrace::ImageImporter> importer(createImageImporter(source));
+    return importer->import(source, data);
+}
+
+bool QTextureCompression::generateMipmaps(QImageData &data)
+{
+    return Raytrace::generateMipmaps(data);
+}
+
+bool QTextureCompression::compress(QImageData &data, QImageData::BlockFormat blockFormat)
+{
+    return Raytrace::compressImage(data, blockFormat);
+}
+
+bool QTextureCompression::decompress(const QImageData &data, QImageData &result)
+{
+    return Raytrace::decompressImage(data, result);
+}
+
+double QTextureCompression::computePSNR(const QImageData &reference, const QImageData &image, int numChannels)
+{
+    if(reference.isCompressed() || image.isCompressed() || reference.width != image.width || reference.height != image.height) {
+        return -1.0;
+    }
+    if(reference.type == QImageData::ValueType::Undefined || image.type == QImageData::ValueType::Undefined) {
+        return -1.0;
+    }
+    if(numChannels <= 0) {
+        numChannels = qMin(reference.channels, image.channels);
+    }
+    if(numChannels <= 0 || numChannels > reference.channels || numChannels > image.channels) {
+        return -1.0;
+    }
+    if(reference.sizeInBytes() < reference.mipLevelSize(0) || image.sizeInBytes() < image.mipLevelSize(0)) {
+        return -1.0;
+    }
+
+    const quint64 numTexels = quint64(reference.width) * quint64(reference.height);
+    double peakValue = (reference.type == QImageData::ValueType::UInt8) ? 255.0 : 0.0;
+    double squaredError = 0.0;
+    for(quint64 i=0; i<numTexels; ++i) {
+        for(int c=0; c<numChannels; ++c) {
+            const double referenceValue = readValue(reference, i * quint64(reference.channels) + quint64(c));
+            const double error = referenceValue - readValue(image, i * quint64(image.channels) + quint64(c));
+            squaredError += error * error;
+            if(reference.type != QImageData::ValueType::UInt8) {
+                peakValue = qMax(peakValue, referenceValue);
+            }
+        }
+    }
+
+    const double meanSquaredError = squaredError / double(numTexels * quint64(numChannels));
+    if(meanSquaredError == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(peakValue * peakValue / meanSquaredError);
+}
+
+} // Qt3DRaytrace
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/bvh.h>
+
+#include <QVarLengthArray>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+namespace Config {
+
+constexpr int NumBins = 16;
+constexpr int MaxSAHDepth = 64;
+
+} // Config
+
+namespace {
+
+struct BuildTask
+{
+    uint32_t parentIndex;
+    uint32_t begin;
+    uint32_t end;
+    int depth;
+    bool isRightChild;
+};
+
+struct Bin
+{
+    Aabb bounds = Aabb::empty();
+    uint32_t count = 0;
+};
+
+} // anonymous
+
+void Bvh::build(const QVector<Aabb> &primitiveBounds, uint32_t maxLeafSize)
+{
+    Q_ASSERT(maxLeafSize > 0);
+
+    clear();
+
+    const uint32_t numPrimitives = uint32_t(primitiveBounds.size());
+    if(numPrimitives == 0) {
+        return;
+    }
+
+    QVector<vec3> centroids(static_cast<int>(numPrimitives));
+    m_primitiveIndices.resize(int(numPrimitives));
+    for(uint32_t i=0; i < numPrimitives; ++i) {
+        centroids[int(i)] = primitiveBounds[int(i)].centroid();
+        m_primitiveIndices[int(i)] = i;
+    }
+    m_nodes.reserve(int(2 * numPrimitives / maxLeafSize + 1));
+
+    uint32_t *indices = m_primitiveIndices.data();
+
+    QVarLengthArray<BuildTask, 128> tasks;
+    tasks.append({ ~0u, 0, numPrimitives, 0, false });
+    while(!tasks.isEmpty()) {
+        const BuildTask task = tasks.last();
+        tasks.removeLast();
+
+        const uint32_t nodeIndex = uint32_t(m_nodes.size());
+        if(task.isRightChild) {
+            m_nodes[int(task.parentIndex)].offset = nodeIndex;
+        }
+        m_nodes.append(BvhNode{});
+
+        Aabb bounds = Aabb::empty();
+        Aabb centroidBounds = Aabb::empty();
+        for(uint32_t i=task.begin; i < task.end; ++i) {
+            bounds.grow(primitiveBounds[int(indices[i])]);
+            centroidBounds.grow(centroids[int(indices[i])]);
+        }
+
+        BvhNode &node = m_nodes[int(nodeIndex)];
+        node.bmin = bounds.bmin;
+        node.bmax = bounds.bmax;
+
+        const uint32_t count = task.end - task.begin;
+        if(count <= maxLeafSize) {
+            node.offset = task.begin;
+            node.count = count;
+            continue;
+        }
+
+        uint32_t mid = task.begin;
+        const vec3 centroidExtent = centroidBounds.extent();
+        if(task.depth < Config::MaxSAHDepth && maxcomp(centroidExtent) > 0.0f) {
+            int bestAxis = -1;
+            int bestSplit = 0;
+            float bestCost = std::numeric_limits<float>::max();
+
+            for(int axis=0; axis < 3; ++axis) {
+                if(centroidExtent[axis] <= 0.0f) {
+                    continue;
+                }
+                const float binScale = Config::NumBins / centroidExtent[axis];
+                Bin bins[Config::NumBins];
+                for(uint32_t i=task.begin; i < task.end; ++i) {
+                    const uint32_t primitive = indices[i];
+                    const int binIndex = std::min(Config::NumBins - 1, int((centroids[int(primitive)][axis] - centroidBounds.bmin[axis]) * binScale));
+                    bins[binIndex].bounds.grow(primitiveBounds[int(primitive)]);
+                    bins[binIndex].count++;
+                }
+
+                // Sweep from the right to accumulate right hand side areas, then from the left to evaluate split costs.
+                float rightArea[Config::NumBins];
+                uint32_t rightCount[Config::NumBins];
+                Aabb accumBounds = Aabb::empty();
+                uint32_t accumCount = 0;
+                for(int i=Config::NumBins-1; i > 0; --i) {
+                    accumBounds.grow(bins[i].bounds);
+                    accumCount += bins[i].count;
+                    rightArea[i] = accumBounds.surfaceArea();
+                    rightCount[i] = accumCount;
+                }
+                accumBounds = Aabb::empty();
+                accumCount = 0;
+                for(int i=1; i < Config::NumBins; ++i) {
+                    accumBounds.grow(bins[i-1].bounds);
+                    accumCount += bins[i-1].count;
+                    if(accumCount == 0 || rightCount[i] == 0) {
+                        continue;
+                    }
+                    const float cost = accumBounds.surfaceArea() * accumCount + rightArea[i] * rightCount[i];
+                    if(cost < bestCost) {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = i;
+                    }
+                }
+            }
+
+            if(bestAxis >= 0) {
+                const float binScale = Config::NumBins / centroidExtent[bestAxis];
+                const float binOrigin = centroidBounds.bmin[bestAxis];
+                uint32_t *split = std::partition(indices + task.begin, indices + task.end, [&](uint32_t primitive) {
+                    const int binIndex = std::min(Config::NumBins - 1, int((centroids[int(primitive)][bestAxis] - binOrigin) * binScale));
+                    return binIndex < bestSplit;
+                });
+                mid = uint32_t(split - indices);
+            }
+        }
+
+        if(mid <= task.begin || mid >= task.end) {
+            // Fall back to object median split along the longest axis.
+            const int axis = (centroidExtent.x >= centroidExtent.y && centroidExtent.x >= centroidExtent.z) ? 0 : (centroidExtent.y >= centroidExtent.z ? 1 : 2);
+            mid = task.begin + count / 2;
+            std::nth_element(indices + task.begin, indices + mid, indices + task.end, [&](uint32_t a, uint32_t b) {
+                return centroids[int(a)][axis] < centroids[int(b)][axis];
+            });
+        }
+
+        node.count = 0;
+        // Right child is processed after the whole left subtree has been emitted.
+        tasks.append({ nodeIndex, mid, task.end, task.depth + 1, true });
+        tasks.append({ nodeIndex, task.begin, mid, task.depth + 1, false });
+    }
+
+    m_nodes.squeeze();
+}
+
+void Bvh::clear()
+{
+    m_nodes.clear();
+    m_primitiveIndices.clear();
+}
+
+Aabb Bvh::bounds() const
+{
+    if(m_nodes.isEmpty()) {
+        return Aabb::empty();
+    }
+    return { m_nodes[0].bmin, m_nodes[0].bmax };
+}
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/cpu/cpucommon.h>
+#include <renderers/cpu/vecmath.h>
+
+#include <QVector>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+struct BvhNode
+{
+    vec3 bmin;
+    uint32_t offset; // Interior: index of right child (left child immediately follows its parent). Leaf: first primitive.
+    vec3 bmax;
+    uint32_t count;  // Number of primitives in a leaf, zero for interior nodes.
+
+    bool isLeaf() const { return count > 0; }
+};
+
+// Bounding volume hierarchy built with binned surface area heuristic.
+// Nodes are stored in depth-first order.
+class Bvh
+{
+public:
+    void build(const QVector<Aabb> &primitiveBounds, uint32_t maxLeafSize);
+    void clear();
+
+    bool isEmpty() const { return m_nodes.isEmpty(); }
+    Aabb bounds() const;
+
+    const QVector<BvhNode> &nodes() const { return m_nodes; }
+    QVector<BvhNode> &nodes() { return m_nodes; }
+    const QVector<uint32_t> &primitiveIndices() const { return m_primitiveIndices; }
+
+    // Traverses nodes intersected by the ray in front-to-back order.
+    // LeafFunc is invoked as bool(const BvhNode &leaf, float &tmax), it should return true and shorten tmax on hit.
+    template<bool AnyHit, typename LeafFunc>
+    bool traverse(const Ray &ray, LeafFunc &&leafFunc) const;
+
+private:
+    QVector<BvhNode> m_nodes;
+    QVector<uint32_t> m_primitiveIndices;
+};
+
+namespace BvhDetail {
+
+inline bool intersectNode(const BvhNode &node, const vec3 &origin, const vec3 &invDirection, float tmin, float tmax, float &tnear)
+{
+    const vec3 t0 = (node.bmin - origin) * invDirection;
+    const vec3 t1 = (node.bmax - origin) * invDirection;
+    tnear = std::max(maxcomp(min(t0, t1)), tmin);
+    const float tfar = std::min(mincomp(max(t0, t1)), tmax);
+    return tnear <= tfar;
+}
+
+} // BvhDetail
+
+template<bool AnyHit, typename LeafFunc>
+bool Bvh::traverse(const Ray &ray, LeafFunc &&leafFunc) const
+{
+    constexpr int MaxStackSize = 128;
+
+    if(m_nodes.isEmpty()) {
+        return false;
+    }
+
+    const vec3 invDirection = { 1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z };
+    const BvhNode *nodes = m_nodes.constData();
+
+    float tmax = ray.tmax;
+    float tnear;
+    if(!BvhDetail::intersectNode(nodes[0], ray.origin, invDirection, ray.tmin, tmax, tnear)) {
+        return false;
+    }
+
+    struct StackEntry {
+        uint32_t index;
+        float tnear;
+    } stack[MaxStackSize];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, tnear };
+
+    bool hit = false;
+    while(stackSize > 0) {
+        const StackEntry entry = stack[--stackSize];
+        if(entry.tnear > tmax) {
+            continue;
+        }
+
+        const BvhNode &node = nodes[entry.index];
+        if(node.isLeaf()) {
+            if(leafFunc(node, tmax)) {
+                hit = true;
+                if(AnyHit) {
+                    break;
+                }
+            }
+            continue;
+        }
+
+        const uint32_t leftIndex = entry.index + 1;
+        const uint32_t rightIndex = node.offset;
+
+        float tnearLeft, tnearRight;
+        const bool hitLeft = BvhDetail::intersectNode(nodes[leftIndex], ray.origin, invDirection, ray.tmin, tmax, tnearLeft);
+        const bool hitRight = BvhDetail::intersectNode(nodes[rightIndex], ray.origin, invDirection, ray.tmin, tmax, tnearRight);
+
+        Q_ASSERT(stackSize + 2 <= MaxStackSize);
+        if(hitLeft && hitRight) {
+            // Push the farther child first so that the nearer one gets visited next.
+            if(tnearLeft <= tnearRight) {
+                stack[stackSize++] = { rightIndex, tnearRight };
+                stack[stackSize++] = { leftIndex, tnearLeft };
+            }
+            else {
+                stack[stackSize++] = { leftIndex, tnearLeft };
+                stack[stackSize++] = { rightIndex, tnearRight };
+            }
+        }
+        else if(hitLeft) {
+            stack[stackSize++] = { leftIndex, tnearLeft };
+        }
+        else if(hitRight) {
+            stack[stackSize++] = { rightIndex, tnearRight };
+        }
+    }
+    return hit;
+}
+
+} // Cpu
+} // Qt3DRaytrace
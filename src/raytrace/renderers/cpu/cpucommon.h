@@ -0,0 +1,23 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <QLoggingCategory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUARTZ_CPU_SSE 1
+#endif
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+Q_DECLARE_LOGGING_CATEGORY(logCpu)
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/geometry.h>
+
+#include <cstring>
+
+#if QUARTZ_CPU_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+TriangleMesh::TriangleMesh(const QGeometryData &data)
+{
+    const int dataNumVertices = int(data.numVertices());
+    const int dataNumFaces = int(data.numFaces());
+    const QVertex *dataVertices = data.vertexData();
+
+    m_vertices.resize(dataNumVertices);
+    for(int i=0; i < dataNumVertices; ++i) {
+        const QVertex &vertex = dataVertices[i];
+        m_vertices[i] = { vertex.position, vertex.normal, vertex.tangent, vertex.texcoord };
+    }
+    if(data.faceStorage) {
+        m_faces.resize(dataNumFaces);
+        std::memcpy(m_faces.data(), data.faceData(), sizeof(QTriangle) * size_t(dataNumFaces));
+    }
+    else {
+        m_faces = data.faces;
+    }
+
+    const uint32_t numVertices = uint32_t(m_vertices.size());
+    QVector<Aabb> faceBounds(m_faces.size());
+    for(int i=0; i < m_faces.size(); ++i) {
+        QTriangle &face = m_faces[i];
+        if(face.vertices[0] >= numVertices || face.vertices[1] >= numVertices || face.vertices[2] >= numVertices) {
+            qCWarning(logCpu) << "Geometry face" << i << "references out of range vertex index";
+            face.vertices[0] = face.vertices[1] = face.vertices[2] = 0;
+        }
+        Aabb bounds = Aabb::empty();
+        if(numVertices > 0) {
+            bounds.grow(m_vertices[int(face.vertices[0])].position);
+            bounds.grow(m_vertices[int(face.vertices[1])].position);
+            bounds.grow(m_vertices[int(face.vertices[2])].position);
+        }
+        faceBounds[i] = bounds;
+    }
+    if(numVertices == 0) {
+        return;
+    }
+
+    m_bvh.build(faceBounds, PackSize);
+
+    // Replace leaf primitive ranges with indices of SIMD triangle packs.
+    const QVector<uint32_t> &primitiveIndices = m_bvh.primitiveIndices();
+    for(BvhNode &node : m_bvh.nodes()) {
+        if(!node.isLeaf()) {
+            continue;
+        }
+        Q_ASSERT(node.count <= PackSize);
+
+        TrianglePack pack;
+        std::memset(&pack, 0, sizeof(TrianglePack));
+        for(uint32_t lane=0; lane < PackSize; ++lane) {
+            if(lane >= node.count) {
+                // Degenerate triangle never passes the determinant test.
+                pack.primitives[lane] = ~0u;
+                continue;
+            }
+            const uint32_t primitive = primitiveIndices[int(node.offset + lane)];
+            const QTriangle &face = m_faces[int(primitive)];
+            const vec3 &p1 = m_vertices[int(face.vertices[0])].position;
+            const vec3 &p2 = m_vertices[int(face.vertices[1])].position;
+            const vec3 &p3 = m_vertices[int(face.vertices[2])].position;
+            const vec3 e1 = p2 - p1;
+            const vec3 e2 = p3 - p1;
+            for(int axis=0; axis < 3; ++axis) {
+                pack.v0[axis][lane] = p1[axis];
+                pack.e1[axis][lane] = e1[axis];
+                pack.e2[axis][lane] = e2[axis];
+            }
+            pack.primitives[lane] = primitive;
+        }
+        node.offset = uint32_t(m_packs.size());
+        m_packs.append(pack);
+    }
+}
+
+template<bool AnyHit>
+bool TriangleMesh::intersectPack(const TrianglePack &pack, const Ray &ray, float &tmax, Hit &hit) const
+{
+    alignas(16) float t[PackSize];
+    alignas(16) float u[PackSize];
+    alignas(16) float v[PackSize];
+    int mask = 0;
+
+#if QUARTZ_CPU_SSE
+    const __m128 dx = _mm_set1_ps(ray.direction.x);
+    const __m128 dy = _mm_set1_ps(ray.direction.y);
+    const __m128 dz = _mm_set1_ps(ray.direction.z);
+
+    const __m128 e1x = _mm_load_ps(pack.e1[0]);
+    const __m128 e1y = _mm_load_ps(pack.e1[1]);
+    const __m128 e1z = _mm_load_ps(pack.e1[2]);
+    const __m128 e2x = _mm_load_ps(pack.e2[0]);
+    const __m128 e2y = _mm_load_ps(pack.e2[1]);
+    const __m128 e2z = _mm_load_ps(pack.e2[2]);
+
+    // P = D x E2
+    const __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    const __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    const __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+
+    const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    const __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+    // T = O - V0
+    const __m128 tx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_load_ps(pack.v0[0]));
+    const __m128 ty = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_load_ps(pack.v0[1]));
+    const __m128 tz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_load_ps(pack.v0[2]));
+
+    const __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, px), _mm_mul_ps(ty, py)), _mm_mul_ps(tz, pz)), invDet);
+
+    // Q = T x E1
+    const __m128 qx = _mm_sub_ps(_mm_mul_ps(ty, e1z), _mm_mul_ps(tz, e1y));
+    const __m128 qy = _mm_sub_ps(_mm_mul_ps(tz, e1x), _mm_mul_ps(tx, e1z));
+    const __m128 qz = _mm_sub_ps(_mm_mul_ps(tx, e1y), _mm_mul_ps(ty, e1x));
+
+    const __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), invDet);
+    const __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), invDet);
+
+    const __m128 zero = _mm_setzero_ps();
+    __m128 valid = _mm_cmpneq_ps(det, zero);
+    valid = _mm_and_ps(valid, _mm_cmpge_ps(uu, zero));
+    valid = _mm_and_ps(valid, _mm_cmpge_ps(vv, zero));
+    valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(uu, vv), _mm_set1_ps(1.0f)));
+    valid = _mm_and_ps(valid, _mm_cmpgt_ps(tt, _mm_set1_ps(ray.tmin)));
+    valid = _mm_and_ps(valid, _mm_cmplt_ps(tt, _mm_set1_ps(tmax)));
+
+    mask = _mm_movemask_ps(valid);
+    if(mask == 0) {
+        return false;
+    }
+    _mm_store_ps(t, tt);
+    _mm_store_ps(u, uu);
+    _mm_store_ps(v, vv);
+#else
+    for(uint32_t lane=0; lane < PackSize; ++lane) {
+        const vec3 e1 = { pack.e1[0][lane], pack.e1[1][lane], pack.e1[2][lane] };
+        const vec3 e2 = { pack.e2[0][lane], pack.e2[1][lane], pack.e2[2][lane] };
+        const vec3 p  = cross(ray.direction, e2);
+        const float det = dot(e1, p);
+        if(det == 0.0f) {
+            continue;
+        }
+        const float invDet = 1.0f / det;
+        const vec3 tv = ray.origin - vec3(pack.v0[0][lane], pack.v0[1][lane], pack.v0[2][lane]);
+        const vec3 q  = cross(tv, e1);
+        u[lane] = dot(tv, p) * invDet;
+        v[lane] = dot(ray.direction, q) * invDet;
+        t[lane] = dot(e2, q) * invDet;
+        if(u[lane] >= 0.0f && v[lane] >= 0.0f && u[lane] + v[lane] <= 1.0f && t[lane] > ray.tmin && t[lane] < tmax) {
+            mask |= 1 << lane;
+        }
+    }
+    if(mask == 0) {
+        return false;
+    }
+#endif
+
+    int closestLane = -1;
+    for(uint32_t lane=0; lane < PackSize; ++lane) {
+        if((mask & (1 << lane)) && (closestLane < 0 || t[lane] < t[closestLane])) {
+            closestLane = int(lane);
+            if(AnyHit) {
+                break;
+            }
+        }
+    }
+    Q_ASSERT(closestLane >= 0);
+
+    tmax = t[closestLane];
+    hit.t = t[closestLane];
+    hit.u = u[closestLane];
+    hit.v = v[closestLane];
+    hit.primitive = pack.primitives[closestLane];
+    return true;
+}
+
+bool TriangleMesh::intersect(const Ray &ray, Hit &hit) const
+{
+    return m_bvh.traverse<false>(ray, [this, &ray, &hit](const BvhNode &leaf, float &tmax) {
+        return intersectPack<false>(m_packs[int(leaf.offset)], ray, tmax, hit);
+    });
+}
+
+bool TriangleMesh::occluded(const Ray &ray) const
+{
+    Hit hit;
+    return m_bvh.traverse<true>(ray, [this, &ray, &hit](const BvhNode &leaf, float &tmax) {
+        return intersectPack<true>(m_packs[int(leaf.offset)], ray, tmax, hit);
+    });
+}
+
+Triangle TriangleMesh::triangle(uint32_t primitive) const
+{
+    Q_ASSERT(primitive < numFaces());
+    const QTriangle &face = m_faces[int(primitive)];
+    return {
+        m_vertices[int(face.vertices[0])],
+        m_vertices[int(face.vertices[1])],
+        m_vertices[int(face.vertices[2])],
+    };
+}
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/cpu/cpucommon.h>
+#include <renderers/cpu/vecmath.h>
+#include <renderers/cpu/bvh.h>
+
+#include <Qt3DRaytrace/qgeometrydata.h>
+
+#include <QSharedPointer>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+struct Hit
+{
+    float t;
+    float u, v; // Barycentrics of the second & third triangle vertex.
+    uint32_t primitive;
+    uint32_t instance;
+};
+
+// Up to four triangles laid out for SIMD Möller-Trumbore intersection.
+struct alignas(16) TrianglePack
+{
+    float v0[3][4];
+    float e1[3][4];
+    float e2[3][4];
+    uint32_t primitives[4];
+};
+
+struct Vertex
+{
+    vec3 position;
+    vec3 normal;
+    vec3 tangent;
+    vec2 texcoord;
+};
+
+struct Triangle
+{
+    Vertex v1, v2, v3;
+};
+
+class TriangleMesh
+{
+public:
+    static constexpr uint32_t PackSize = 4;
+
+    explicit TriangleMesh(const QGeometryData &data);
+
+    bool intersect(const Ray &ray, Hit &hit) const;
+    bool occluded(const Ray &ray) const;
+
+    Triangle triangle(uint32_t primitive) const;
+
+    Aabb bounds() const { return m_bvh.bounds(); }
+    uint32_t numFaces() const { return uint32_t(m_faces.size()); }
+    uint32_t numVertices() const { return uint32_t(m_vertices.size()); }
+
+private:
+    template<bool AnyHit>
+    bool intersectPack(const TrianglePack &pack, const Ray &ray, float &tmax, Hit &hit) const;
+
+    QVector<Vertex> m_vertices;
+    QVector<QTriangle> m_faces;
+    QVector<TrianglePack> m_packs;
+    Bvh m_bvh;
+};
+
+using TriangleMeshPtr = QSharedPointer<const TriangleMesh>;
+
+} // Cpu
+} // Qt3DRaytrace
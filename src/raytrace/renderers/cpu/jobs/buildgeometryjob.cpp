@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/jobs/buildgeometryjob.h>
+#include <renderers/cpu/renderer.h>
+#include <renderers/cpu/geometry.h>
+
+#include <backend/managers_p.h>
+#include <backend/geometry_p.h>
+
+#include <limits>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+BuildGeometryJob::BuildGeometryJob(Renderer *renderer, const Raytrace::HGeometry &handle)
+    : m_renderer(renderer)
+    , m_handle(handle)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void BuildGeometryJob::run()
+{
+    Raytrace::Geometry *geometryNode = m_handle.data();
+    if(!geometryNode) {
+        return;
+    }
+
+    auto *sceneManager = m_renderer->sceneManager();
+    if(geometryNode->numFaces() == 0) {
+        sceneManager->addOrUpdateGeometry(geometryNode->peerId(), TriangleMeshPtr());
+        return;
+    }
+    if(geometryNode->numVertices() > quint64(std::numeric_limits<int>::max()) || geometryNode->numFaces() > quint64(std::numeric_limits<int>::max())) {
+        qCWarning(logCpu) << "Geometry exceeds maximum number of vertices or faces supported by CPU renderer";
+        sceneManager->addOrUpdateGeometry(geometryNode->peerId(), TriangleMeshPtr());
+        return;
+    }
+
+    TriangleMeshPtr geometry(new TriangleMesh(geometryNode->data()));
+    sceneManager->addOrUpdateGeometry(geometryNode->peerId(), geometry);
+}
+
+} // Cpu
+} // Qt3DRaytrace
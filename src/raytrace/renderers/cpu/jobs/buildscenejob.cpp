@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/jobs/buildscenejob.h>
+#include <renderers/cpu/renderer.h>
+#include <renderers/cpu/scene.h>
+
+#include <backend/managers_p.h>
+#include <backend/rendersettings_p.h>
+
+#include <QHash>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+BuildSceneJob::BuildSceneJob(Renderer *renderer)
+    : m_renderer(renderer)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void BuildSceneJob::run()
+{
+    auto *nodeManagers = m_renderer->nodeManagers();
+    auto *sceneManager = m_renderer->sceneManager();
+    Q_ASSERT(nodeManagers);
+
+    QSharedPointer<Scene> scene(new Scene);
+
+    QHash<QNodeId, uint32_t> geometryIndices;
+    QHash<QNodeId, uint32_t> textureIndices;
+    QHash<QNodeId, uint32_t> materialIndices;
+
+    auto lookupTextureImageIndex = [&](QNodeId textureId) -> uint32_t {
+        const Raytrace::AbstractTexture *texture = nodeManagers->textureManager.lookupResource(textureId);
+        if(!texture) {
+            return ~0u;
+        }
+        auto it = textureIndices.find(texture->imageId());
+        if(it != textureIndices.end()) {
+            return *it;
+        }
+        TexturePtr textureImage = sceneManager->lookupTexture(texture->imageId());
+        if(!textureImage) {
+            return ~0u;
+        }
+        const uint32_t index = uint32_t(scene->textures.size());
+        scene->textures.append(textureImage);
+        textureIndices.insert(texture->imageId(), index);
+        return index;
+    };
+
+    auto lookupGeometryIndex = [&](QNodeId geometryId) -> uint32_t {
+        auto it = geometryIndices.find(geometryId);
+        if(it != geometryIndices.end()) {
+            return *it;
+        }
+        TriangleMeshPtr geometry = sceneManager->lookupGeometry(geometryId);
+        if(!geometry || geometry->numFaces() == 0) {
+            return ~0u;
+        }
+        const uint32_t index = uint32_t(scene->geometry.size());
+        scene->geometry.append(geometry);
+        geometryIndices.insert(geometryId, index);
+        return index;
+    };
+
+    auto lookupMaterialIndex = [&](const Raytrace::Material *material) -> uint32_t {
+        auto it = materialIndices.find(material->peerId());
+        if(it != materialIndices.end()) {
+            return *it;
+        }
+        Material materialData;
+        material->albedo().writeToBuffer(&materialData.albedo.x);
+        material->emission().writeToBuffer(&materialData.emission.x);
+        materialData.roughness = material->roughness();
+        materialData.metalness = material->metalness();
+        materialData.albedoTexture = lookupTextureImageIndex(material->albedoTextureId());
+        materialData.roughnessTexture = lookupTextureImageIndex(material->roughnessTextureId());
+        materialData.metalnessTexture = lookupTextureImageIndex(material->metalnessTextureId());
+
+        const uint32_t index = uint32_t(scene->materials.size());
+        scene->materials.append(materialData);
+        materialIndices.insert(material->peerId(), index);
+        return index;
+    };
+
+    const Raytrace::EntityComponentTable &componentTable = nodeManagers->entityComponentTable;
+    QVector<uint32_t> instanceIndices(componentTable.size(), ~0u);
+    for(int row=0; row < componentTable.size(); ++row) {
+        const Raytrace::Entity *entity = componentTable.entity(row);
+        const Raytrace::GeometryRenderer *geometryRenderer = componentTable.geometryRenderer(row);
+        const Raytrace::Material *material = componentTable.material(row);
+        if(!entity || !geometryRenderer || !material || geometryRenderer->geometryId().isNull()) {
+            continue;
+        }
+
+        const uint32_t geometryIndex = lookupGeometryIndex(geometryRenderer->geometryId());
+        if(geometryIndex == ~0u) {
+            // Geometry not loaded yet.
+            continue;
+        }
+
+        const QMatrix4x4 transform = entity->worldTransformMatrix().toQMatrix4x4();
+
+        EntityInstance instance;
+        instance.geometryIndex = geometryIndex;
+        instance.materialIndex = lookupMaterialIndex(material);
+        instance.transform = Affine3(transform);
+        instance.inverseTransform = Affine3(transform.inverted());
+        instance.basisTransform = Basis3(transform.normalMatrix());
+
+        instanceIndices[row] = uint32_t(scene->instances.size());
+        scene->instances.append(instance);
+    }
+
+    {
+        Emitter skyEmitter = {};
+        skyEmitter.instanceIndex = ~0u;
+        skyEmitter.textureIndex = ~0u;
+        if(const Raytrace::RenderSettings *settings = m_renderer->settings()) {
+            settings->skyRadiance().writeToBuffer(&skyEmitter.radiance.x);
+            skyEmitter.intensity = settings->skyIntensity();
+            skyEmitter.textureIndex = lookupTextureImageIndex(settings->skyTextureId());
+            skyEmitter.direction = QVector3D(settings->skyTextureOffset(), 0.0f);
+        }
+        scene->emitters.append(skyEmitter);
+    }
+
+    for(int row=0; row < componentTable.size(); ++row) {
+        const Raytrace::Entity *entity = componentTable.entity(row);
+        if(!entity) {
+            continue;
+        }
+        const Raytrace::DistantLight *light = componentTable.distantLight(row);
+        if(light && !light->radiance().isBlack()) {
+            const QMatrix4x4 entityTransform = entity->worldTransformMatrix().toQMatrix4x4();
+            const QVector3D worldDirection = entityTransform.mapVector(light->direction()).normalized();
+
+            Emitter emitter = {};
+            emitter.instanceIndex = ~0u;
+            emitter.direction = worldDirection;
+            light->radiance().writeToBuffer(&emitter.radiance.x);
+            scene->emitters.append(emitter);
+        }
+        const Raytrace::Material *material = componentTable.material(row);
+        if(material && !material->emission().isBlack()) {
+            const uint32_t instanceIndex = instanceIndices[row];
+            if(instanceIndex == ~0u) {
+                continue;
+            }
+
+            Emitter emitter = {};
+            emitter.instanceIndex = instanceIndex;
+            emitter.geometryIndex = scene->instances[int(instanceIndex)].geometryIndex;
+            material->emission().writeToBuffer(&emitter.radiance.x);
+            scene->emitters.append(emitter);
+        }
+    }
+
+    scene->buildInstanceBvh();
+    sceneManager->updateScene(scene);
+}
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/jobs/uploadtexturejob.h>
+#include <renderers/cpu/renderer.h>
+#include <renderers/cpu/texture.h>
+
+#include <backend/managers_p.h>
+#include <backend/textureimage_p.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+UploadTextureJob::UploadTextureJob(Renderer *renderer, const Raytrace::HTextureImage &handle)
+    : m_renderer(renderer)
+    , m_handle(handle)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void UploadTextureJob::run()
+{
+    Raytrace::TextureImage *textureImageNode = m_handle.data();
+    if(!textureImageNode) {
+        return;
+    }
+
+    const QImageData &imageData = textureImageNode->data();
+    if(imageData.width <= 0 || imageData.height <= 0 || imageData.isEmpty()) {
+        return;
+    }
+
+    TexturePtr texture(new Texture(imageData));
+    if(!texture->isValid()) {
+        qCCritical(logCpu) << "UploadTextureJob: unsupported texture image data format";
+        return;
+    }
+    m_renderer->sceneManager()->addOrUpdateTexture(textureImageNode->peerId(), texture);
+}
+
+} // Cpu
+} // Qt3DRaytrace
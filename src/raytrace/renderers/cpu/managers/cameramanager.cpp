@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/managers/cameramanager.h>
+#include <renderers/cpu/pathtracer.h>
+
+#include <backend/entity_p.h>
+#include <backend/transform_p.h>
+#include <backend/cameralens_p.h>
+
+#include <QtMath>
+#include <QMatrix4x4>
+
+#include <tuple>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+// Use right-handed coordinate system.
+// Up vector is flipped since screen coordinates increase from top to bottom.
+static constexpr QVector3D IdentityUpVector(0.0f, -1.0f, 0.0f);
+static constexpr QVector3D IdentityRightVector(1.0f, 0.0f, 0.0f);
+static constexpr QVector3D IdentityForwardVector(0.0f, 0.0f, -1.0f);
+
+static constexpr float DefaultFOV = 90.0f;
+
+CameraManager::CameraManager()
+    : m_activeCamera(nullptr)
+{
+    setDefaultParameters();
+}
+
+Raytrace::Entity *CameraManager::activeCamera() const
+{
+    QReadLocker lock(&m_rwlock);
+    return m_activeCamera;
+}
+
+void CameraManager::setActiveCamera(Raytrace::Entity *activeCamera)
+{
+    QWriteLocker lock(&m_rwlock);
+    m_activeCamera = activeCamera;
+}
+
+void CameraManager::setDefaultParameters()
+{
+    m_position = QVector3D(0.0f, 0.0f, 0.0f);
+    m_upVector = IdentityUpVector;
+    m_rightVector = IdentityRightVector;
+    m_forwardVector = IdentityForwardVector;
+    m_aspectRatio = 1.0f;
+    m_tanHalfFOV = std::tan(0.5f * qDegreesToRadians(DefaultFOV));
+    m_lensRadius = 0.0f;
+    m_lensFocalDistance = 1.0f;
+    m_invGamma = 1.0f / 2.2f;
+    m_exposure = 1.0f;
+    m_tonemapFactor = 1.0f;
+}
+
+void CameraManager::updateParameters()
+{
+    QWriteLocker lock(&m_rwlock);
+
+    const auto renderParameters = [this]() {
+        return std::make_tuple(m_position, m_upVector, m_rightVector, m_forwardVector, m_aspectRatio, m_tanHalfFOV, m_lensRadius, m_lensFocalDistance);
+    };
+    const auto previousRenderParameters = renderParameters();
+    updateParametersFromActiveCamera();
+    if(renderParameters() != previousRenderParameters) {
+        ++m_renderParametersVersion;
+    }
+}
+
+quint64 CameraManager::renderParametersVersion() const
+{
+    QReadLocker lock(&m_rwlock);
+    return m_renderParametersVersion;
+}
+
+void CameraManager::updateParametersFromActiveCamera()
+{
+    if(!m_activeCamera || !m_activeCamera->isCamera()) {
+        setDefaultParameters();
+        return;
+    }
+
+    const QMatrix4x4 worldTransformMatrix = m_activeCamera->worldTransformMatrix().toQMatrix4x4();
+
+    m_position = QVector3D(worldTransformMatrix.column(3));
+    m_upVector = worldTransformMatrix.mapVector(IdentityUpVector);
+    m_rightVector = worldTransformMatrix.mapVector(IdentityRightVector);
+    m_forwardVector = worldTransformMatrix.mapVector(IdentityForwardVector);
+
+    const Raytrace::CameraLens *lens = m_activeCamera->cameraLensComponent();
+    if(lens) {
+        m_aspectRatio = lens->aspectRatio();
+        m_tanHalfFOV = std::tan(0.5f * qDegreesToRadians(lens->fieldOfView()));
+        m_lensRadius = 0.5f * lens->diameter();
+        m_lensFocalDistance = lens->focalDistance();
+        m_invGamma = 1.0f / lens->gamma();
+        m_exposure = lens->exposure();
+        m_tonemapFactor = lens->tonemapFactor();
+    }
+}
+
+void CameraManager::applyRenderParameters(RenderParameters &params) const
+{
+    QReadLocker lock(&m_rwlock);
+
+    params.cameraPosition = m_position;
+    params.cameraUpVector = m_upVector;
+    params.cameraRightVector = m_rightVector;
+    params.cameraForwardVector = m_forwardVector;
+    params.aspectRatio = m_aspectRatio;
+    params.tanHalfFOV = m_tanHalfFOV;
+    params.lensRadius = m_lensRadius;
+    params.lensFocalDistance = m_lensFocalDistance;
+}
+
+void CameraManager::applyDisplayParameters(DisplayParameters &params) const
+{
+    QReadLocker lock(&m_rwlock);
+
+    params.invGamma = m_invGamma;
+    params.exposure = m_exposure;
+    params.tonemapFactorSq = m_tonemapFactor * m_tonemapFactor;
+}
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/cpu/cpucommon.h>
+#include <QVector3D>
+#include <QReadWriteLock>
+
+namespace Qt3DRaytrace {
+
+namespace Raytrace {
+class Entity;
+} // Raytrace
+
+namespace Cpu {
+
+struct RenderParameters;
+struct DisplayParameters;
+
+class CameraManager
+{
+public:
+    CameraManager();
+
+    Raytrace::Entity *activeCamera() const;
+    void setActiveCamera(Raytrace::Entity *activeCamera);
+
+    void updateParameters();
+    // Incremented whenever parameters affecting rendered image (as opposed to display only) change.
+    quint64 renderParametersVersion() const;
+    void applyRenderParameters(RenderParameters &params) const;
+    void applyDisplayParameters(DisplayParameters &params) const;
+
+private:
+    void setDefaultParameters();
+    void updateParametersFromActiveCamera();
+
+    Raytrace::Entity *m_activeCamera;
+
+    QVector3D m_position;
+    QVector3D m_upVector;
+    QVector3D m_rightVector;
+    QVector3D m_forwardVector;
+    float m_aspectRatio;
+    float m_tanHalfFOV;
+    float m_lensRadius;
+    float m_lensFocalDistance;
+    float m_invGamma;
+    float m_exposure;
+    float m_tonemapFactor;
+    quint64 m_renderParametersVersion = 0;
+
+    mutable QReadWriteLock m_rwlock;
+};
+
+} // Cpu
+} // Qt3DRaytrace
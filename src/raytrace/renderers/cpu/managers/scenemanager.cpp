@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/managers/scenemanager.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+void SceneManager::addOrUpdateGeometry(QNodeId geometryNodeId, const TriangleMeshPtr &geometry)
+{
+    QWriteLocker lock(&m_rwlock);
+    m_geometry.insert(geometryNodeId, geometry);
+}
+
+void SceneManager::addOrUpdateTexture(QNodeId textureImageNodeId, const TexturePtr &textureImage)
+{
+    QWriteLocker lock(&m_rwlock);
+    m_textures.insert(textureImageNodeId, textureImage);
+}
+
+TriangleMeshPtr SceneManager::lookupGeometry(QNodeId geometryNodeId) const
+{
+    QReadLocker lock(&m_rwlock);
+    return m_geometry.value(geometryNodeId);
+}
+
+TexturePtr SceneManager::lookupTexture(QNodeId textureImageNodeId) const
+{
+    QReadLocker lock(&m_rwlock);
+    return m_textures.value(textureImageNodeId);
+}
+
+void SceneManager::updateScene(const ScenePtr &scene)
+{
+    QWriteLocker lock(&m_rwlock);
+    m_scene = scene;
+    ++m_sceneVersion;
+}
+
+ScenePtr SceneManager::scene(quint64 *version) const
+{
+    QReadLocker lock(&m_rwlock);
+    if(version) {
+        *version = m_sceneVersion;
+    }
+    return m_scene;
+}
+
+void SceneManager::clear()
+{
+    QWriteLocker lock(&m_rwlock);
+    m_geometry.clear();
+    m_textures.clear();
+    m_scene.reset();
+}
+
+uint32_t SceneManager::numGeometry() const
+{
+    QReadLocker lock(&m_rwlock);
+    return uint32_t(m_geometry.size());
+}
+
+uint32_t SceneManager::numTextures() const
+{
+    QReadLocker lock(&m_rwlock);
+    return uint32_t(m_textures.size());
+}
+
+} // Cpu
+} // Qt3DRaytrace
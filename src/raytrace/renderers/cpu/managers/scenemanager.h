@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/cpu/cpucommon.h>
+#include <renderers/cpu/geometry.h>
+#include <renderers/cpu/texture.h>
+#include <renderers/cpu/scene.h>
+
+#include <Qt3DCore/QNodeId>
+
+#include <QHash>
+#include <QReadWriteLock>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+class SceneManager
+{
+public:
+    void addOrUpdateGeometry(Qt3DCore::QNodeId geometryNodeId, const TriangleMeshPtr &geometry);
+    void addOrUpdateTexture(Qt3DCore::QNodeId textureImageNodeId, const TexturePtr &textureImage);
+
+    TriangleMeshPtr lookupGeometry(Qt3DCore::QNodeId geometryNodeId) const;
+    TexturePtr lookupTexture(Qt3DCore::QNodeId textureImageNodeId) const;
+
+    void updateScene(const ScenePtr &scene);
+    // Version is incremented with every scene update.
+    ScenePtr scene(quint64 *version = nullptr) const;
+
+    void clear();
+
+    uint32_t numGeometry() const;
+    uint32_t numTextures() const;
+
+private:
+    QHash<Qt3DCore::QNodeId, TriangleMeshPtr> m_geometry;
+    QHash<Qt3DCore::QNodeId, TexturePtr> m_textures;
+    ScenePtr m_scene;
+    quint64 m_sceneVersion = 0;
+
+    mutable QReadWriteLock m_rwlock;
+};
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,561 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/pathtracer.h>
+
+#include <cstring>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+namespace {
+
+constexpr float MinRoughness = 0.02f;
+constexpr float MinTerminationThreshold = 0.05f;
+
+// Average fresnel factor at angle of incidence for dielectrics.
+constexpr vec3 kF0_dielectric = vec3(0.04f);
+
+inline uint32_t rotl(uint32_t x, uint32_t k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+// Thomas Wang 32-bit hash.
+inline uint32_t rngHash(uint32_t seed)
+{
+    seed = (seed ^ 61) ^ (seed >> 16);
+    seed *= 9;
+    seed = seed ^ (seed >> 4);
+    seed *= 0x27d4eb2d;
+    seed = seed ^ (seed >> 15);
+    return seed;
+}
+
+inline vec2 blerp(const vec2 &b, const vec2 &p1, const vec2 &p2, const vec2 &p3)
+{
+    return (1.0f - b.x - b.y) * p1 + b.x * p2 + b.y * p3;
+}
+
+inline vec3 blerp(const vec2 &b, const vec3 &p1, const vec3 &p2, const vec3 &p3)
+{
+    return (1.0f - b.x - b.y) * p1 + b.x * p2 + b.y * p3;
+}
+
+inline float cosThetaWorld(const vec3 &v, const vec3 &N)
+{
+    return std::max(dot(v, N), 0.0f);
+}
+
+inline float cosThetaTangent(const vec3 &v)
+{
+    return std::max(v.z, 0.0f);
+}
+
+inline vec2 skyuv(const vec3 &w)
+{
+    const float s = std::atan2(w.z, w.x) * InvTwoPI;
+    const float t = std::acos(qBound(-1.0f, w.y, 1.0f)) * InvPI;
+    return { s, 1.0f - t };
+}
+
+inline vec2 sampleDisk(const vec2 &u)
+{
+    const float r = std::sqrt(u.x);
+    const float theta = TwoPI * u.y;
+    return { r * std::cos(theta), r * std::sin(theta) };
+}
+
+inline vec2 sampleDiskConcentric(const vec2 &u)
+{
+    const vec2 up = { 2.0f * u.x - 1.0f, 2.0f * u.y - 1.0f };
+    if(up.x == 0.0f && up.y == 0.0f) {
+        return { 0.0f, 0.0f };
+    }
+
+    float r, theta;
+    if(std::abs(up.x) > std::abs(up.y)) {
+        r = up.x;
+        theta = 0.25f * PI * (up.y / up.x);
+    }
+    else {
+        r = up.y;
+        theta = 0.5f * PI - 0.25f * PI * (up.x / up.y);
+    }
+    return { r * std::cos(theta), r * std::sin(theta) };
+}
+
+inline vec3 sampleHemisphereCosine(const vec2 &u)
+{
+    const vec2 d = sampleDisk(u);
+    return { d.x, d.y, std::sqrt(std::max(0.0f, 1.0f - d.x*d.x - d.y*d.y)) };
+}
+
+inline float pdfHemisphereCosine(float cosTheta)
+{
+    return cosTheta * InvPI;
+}
+
+inline vec2 sampleTriangle(const vec2 &u)
+{
+    const float uxsqrt = std::sqrt(u.x);
+    return { 1.0f - uxsqrt, u.y * uxsqrt };
+}
+
+// MIS power heuristic for two samples taken from two different distributions
+// pdfA and pdfB. The Beta parameter is assumed to be 2.
+inline float powerHeuristic(float pdfA, float pdfB)
+{
+    const float f = pdfA * pdfA;
+    const float g = pdfB * pdfB;
+    return f / (f + g);
+}
+
+// Schlick's approximation of the Fresnel function.
+inline vec3 F_schlick(const vec3 &F0, const vec3 &wo, const vec3 &wh)
+{
+    return F0 + (vec3(1.0f) - F0) * pow5(1.0f - std::max(0.0f, dot(wo, wh)));
+}
+
+// Trowbridge-Reitz (GGX) normal distribution function.
+inline float D_ggx(float alpha2, float cos_wh)
+{
+    return alpha2 / (PI * pow2(pow2(cos_wh) * (alpha2 - 1.0f) + 1.0f));
+}
+
+// Single term for separable Schlick-GGX below.
+inline float G1_schlick_ggx(float k, float cosTheta)
+{
+    return cosTheta * (1.0f - k) + k;
+}
+
+// Schlick's approximation for Beckmann geometric shadowing function using Smith's method.
+// Uses Brian Karis' remapping of k=alpha/2 to better match Smith's model for GGX.
+inline float G_schlick_ggx(float alpha, float cos_wo, float cos_wi)
+{
+    const float k = 0.5f * alpha;
+    // Numerator cancels out with cos_wi & cos_wo in specular BRDF normalization factor.
+    return 1.0f /* cos_wi * cos_wo */ / (G1_schlick_ggx(k, cos_wi) * G1_schlick_ggx(k, cos_wo));
+}
+
+// Sample half-angle directions from GGX normal distribution function.
+inline vec3 sampleD_ggx(const vec2 &u, float alpha2)
+{
+    const float phi    = TwoPI * u.x;
+    const float cos_wh = std::sqrt((1.0f - u.y) / (1.0f + (alpha2 - 1.0f) * u.y));
+    const float sin_wh = std::sqrt(std::max(0.0f, 1.0f - pow2(cos_wh)));
+    return { sin_wh * std::cos(phi), sin_wh * std::sin(phi), cos_wh };
+}
+
+// GGX NDF sample pdf (with respect to solid angle).
+inline float pdfD_ggx(float alpha2, float cos_wh)
+{
+    return D_ggx(alpha2, cos_wh) * cos_wh;
+}
+
+} // anonymous
+
+RNG::RNG(uint32_t x, uint32_t y, uint32_t frameNumber)
+{
+    s[0] = rngHash((x << 16) | y);
+    s[1] = rngHash(frameNumber);
+    next();
+}
+
+uint32_t RNG::next()
+{
+    const uint32_t result = s[0] * 0x9e3779bb;
+
+    s[1] ^= s[0];
+    s[0] = rotl(s[0], 26) ^ s[1] ^ (s[1] << 9);
+    s[1] = rotl(s[1], 13);
+
+    return result;
+}
+
+float RNG::nextFloat()
+{
+    const uint32_t u = 0x3f800000 | (next() >> 9);
+    float f;
+    std::memcpy(&f, &u, sizeof(float));
+    return f - 1.0f;
+}
+
+uint32_t RNG::nextUInt(uint32_t nmax)
+{
+    return uint32_t(std::floor(nextFloat() * nmax));
+}
+
+vec2 RNG::nextVec2()
+{
+    const float x = nextFloat();
+    const float y = nextFloat();
+    return { x, y };
+}
+
+vec3 RNG::nextVec3()
+{
+    const float x = nextFloat();
+    const float y = nextFloat();
+    const float z = nextFloat();
+    return { x, y, z };
+}
+
+PathTracer::PathTracer(const Scene &scene, const RenderParameters &params)
+    : m_scene(scene)
+    , m_params(params)
+    , m_numEmitters(uint32_t(scene.emitters.size()))
+{
+    Q_ASSERT(m_numEmitters >= 1);
+}
+
+vec3 PathTracer::renderPixel(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const
+{
+    const vec2 pixelSize = { 1.0f / width, 1.0f / height };
+    const vec2 pixelLocation = { x * pixelSize.x, y * pixelSize.y };
+
+    RNG rng(x, y, m_params.frameNumber);
+
+    const vec2 jitter = rng.nextVec2() - vec2(0.5f, 0.5f);
+    const vec2 lensUV = rng.nextVec2();
+    const vec2 pixelUV = { pixelLocation.x + pixelSize.x * jitter.x, pixelLocation.y + pixelSize.y * jitter.y };
+
+    const float tx = (2.0f * pixelUV.x - 1.0f) * m_params.tanHalfFOV * m_params.aspectRatio;
+    const float ty = (2.0f * pixelUV.y - 1.0f) * m_params.tanHalfFOV;
+
+    vec3 pCamera(0.0f);
+    vec3 woCamera = normalize(vec3(tx, ty, 1.0f));
+    if(m_params.lensRadius > 0.0f) {
+        const float tFocus = m_params.lensFocalDistance / woCamera.z;
+        const vec3  pFocus = tFocus * woCamera;
+        const vec2  pLens  = m_params.lensRadius * sampleDiskConcentric(lensUV);
+        pCamera = vec3(pLens.x, pLens.y, 0.0f);
+        woCamera = normalize(pFocus - pCamera);
+    }
+
+    auto cameraToWorld = [this](const vec3 &v) -> vec3 {
+        return m_params.cameraRightVector * v.x + m_params.cameraUpVector * v.y + m_params.cameraForwardVector * v.z;
+    };
+
+    const vec3 p  = cameraToWorld(pCamera) + m_params.cameraPosition;
+    const vec3 wo = cameraToWorld(woCamera);
+    return traceRadiance(p, wo, 0.0f, vec3(1.0f), 0, rng);
+}
+
+vec3 PathTracer::tonemap(const vec3 &color, const DisplayParameters &params)
+{
+    const vec3 linearColor = color * params.exposure;
+
+    // Reinhard tonemapping operator.
+    // see: "Photographic Tone Reproduction for Digital Images", eq. 4
+    const float lum = luminance(linearColor);
+    if(!(lum > 0.0f)) {
+        return vec3(0.0f);
+    }
+    const float mappedLuminance = (lum * (1.0f + lum / params.tonemapFactorSq)) / (1.0f + lum);
+
+    // Scale color by ratio of average luminances.
+    const vec3 mappedColor = (mappedLuminance / lum) * linearColor;
+
+    // Gamma correction.
+    return {
+        std::pow(std::max(0.0f, mappedColor.x), params.invGamma),
+        std::pow(std::max(0.0f, mappedColor.y), params.invGamma),
+        std::pow(std::max(0.0f, mappedColor.z), params.invGamma),
+    };
+}
+
+vec3 PathTracer::traceRadiance(const vec3 &p, const vec3 &w, float tmin, const vec3 &T, uint32_t depth, RNG &rng) const
+{
+    Hit hit;
+    if(!m_scene.intersect({p, w, tmin, Infinity}, hit)) {
+        return (depth == 0) ? fetchSkyRadiance(w) : vec3(0.0f);
+    }
+
+    const EntityInstance &instance = m_scene.instances[int(hit.instance)];
+    const Material &material = m_scene.materials[int(instance.materialIndex)];
+    const Triangle triangle = m_scene.geometry[int(instance.geometryIndex)]->triangle(hit.primitive);
+
+    const vec2 b  = { hit.u, hit.v };
+    const vec2 uv = blerp(b, triangle.v1.texcoord, triangle.v2.texcoord, triangle.v3.texcoord);
+
+    DifferentialSurface surface;
+    surface.basis.N = normalize(instance.basisTransform.map(blerp(b, triangle.v1.normal, triangle.v2.normal, triangle.v3.normal)));
+    surface.basis.T = normalize(instance.basisTransform.map(blerp(b, triangle.v1.tangent, triangle.v2.tangent, triangle.v3.tangent)));
+    surface.basis.B = cross(surface.basis.N, surface.basis.T);
+
+    surface.albedo = material.albedo;
+    if(material.albedoTexture != ~0u) {
+        surface.albedo = fetchTexture(material.albedoTexture, uv);
+    }
+    surface.roughness = material.roughness;
+    if(material.roughnessTexture != ~0u) {
+        surface.roughness = 1.0f - std::min(1.0f, fetchTexture(material.roughnessTexture, uv).x);
+    }
+    surface.roughness = std::max(MinRoughness, surface.roughness);
+    surface.metalness = material.metalness;
+    if(material.metalnessTexture != ~0u) {
+        surface.metalness = 1.0f - std::min(1.0f, fetchTexture(material.metalnessTexture, uv).x);
+    }
+    initializeSurfaceBSDF(surface);
+
+    const vec3 hitP = p + hit.t * w;
+    const vec3 wo = worldToTangent(surface.basis, -w);
+
+    vec3 L = (depth == 0) ? material.emission : vec3(0.0f);
+    L += directLighting(hitP, wo, surface, T, rng);
+    if(depth + 1 <= m_params.maxDepth) {
+        L += indirectLighting(hitP, wo, surface, T, depth, rng);
+    }
+    return L;
+}
+
+vec3 PathTracer::traceEmission(const vec3 &p, const vec3 &w) const
+{
+    Hit hit;
+    if(m_scene.intersect({p, w, Epsilon, Infinity}, hit)) {
+        const EntityInstance &instance = m_scene.instances[int(hit.instance)];
+        return m_scene.materials[int(instance.materialIndex)].emission;
+    }
+    // Emitter #0 is always sky.
+    return fetchSkyRadiance(w);
+}
+
+vec3 PathTracer::sampleEmitterLi(const vec3 &p, const DifferentialSurface &surface, vec3 &wiWorld, vec3 &wiTangent, float &pdf, RNG &rng) const
+{
+    const uint32_t emitterIndex = rng.nextUInt(m_numEmitters);
+    const Emitter &emitter = m_scene.emitters[int(emitterIndex)];
+
+    vec3 emitterL = emitter.radiance;
+    float emitterDistance = Infinity;
+
+    if(emitterIndex == 0) {
+        // Sky emitter.
+        wiTangent = sampleHemisphereCosine(rng.nextVec2());
+        wiWorld   = tangentToWorld(surface.basis, wiTangent);
+        pdf       = pdfHemisphereCosine(cosThetaTangent(wiTangent));
+        emitterL  = fetchSkyRadiance(wiWorld);
+    }
+    else if(emitter.instanceIndex == ~0u) {
+        // Distant light emitter.
+        wiWorld   = -emitter.direction;
+        wiTangent = worldToTangent(surface.basis, wiWorld);
+        pdf       = 0.0f;
+    }
+    else {
+        // Area emitter.
+        const EntityInstance &emitterInstance = m_scene.instances[int(emitter.instanceIndex)];
+        const TriangleMesh *emitterGeometry = m_scene.geometry[int(emitter.geometryIndex)].data();
+        const uint32_t faceIndex = rng.nextUInt(emitterGeometry->numFaces());
+        const vec2 faceBarycentrics = sampleTriangle(rng.nextVec2());
+
+        const Triangle triangle = emitterGeometry->triangle(faceIndex);
+        const vec3 p1 = emitterInstance.transform.mapPoint(triangle.v1.position);
+        const vec3 p2 = emitterInstance.transform.mapPoint(triangle.v2.position);
+        const vec3 p3 = emitterInstance.transform.mapPoint(triangle.v3.position);
+
+        const vec3 emitterP = blerp(faceBarycentrics, p1, p2, p3);
+        const vec3 emitterN = normalize(emitterInstance.basisTransform.map(blerp(faceBarycentrics, triangle.v1.normal, triangle.v2.normal, triangle.v3.normal)));
+        vec3 emitterWo = p - emitterP;
+
+        const float triangleArea = 0.5f * length(cross(p2 - p1, p3 - p1));
+        const float distanceSqr = dot(emitterWo, emitterWo);
+        if(triangleArea == 0.0f || distanceSqr == 0.0f) {
+            pdf = 0.0f;
+            return vec3(0.0f);
+        }
+
+        emitterDistance = std::sqrt(distanceSqr);
+        emitterWo /= emitterDistance;
+        emitterDistance = std::max(0.0f, emitterDistance - Epsilon);
+
+        const float cosTheta = cosThetaWorld(emitterN, emitterWo);
+        if(cosTheta == 0.0f) {
+            pdf = 0.0f;
+            return vec3(0.0f);
+        }
+
+        wiWorld   = -emitterWo;
+        wiTangent = worldToTangent(surface.basis, wiWorld);
+        pdf       = distanceSqr / (cosTheta * triangleArea);
+    }
+
+    if(m_scene.occluded({p, wiWorld, Epsilon, emitterDistance})) {
+        return vec3(0.0f);
+    }
+    return emitterL;
+}
+
+vec3 PathTracer::sampleScatteringLi(const vec3 &p, const DifferentialSurface &surface, const vec3 &wo, vec3 &wi, float &pdf, RNG &rng) const
+{
+    const vec3 brdf = sampleBSDF(surface, wo, wi, pdf, rng);
+    if(isblack(brdf) || pdf < Epsilon) {
+        return vec3(0.0f);
+    }
+
+    const vec3 wiWorld = tangentToWorld(surface.basis, wi);
+    return traceEmission(p, wiWorld) * brdf;
+}
+
+vec3 PathTracer::directLighting(const vec3 &p, const vec3 &wo, const DifferentialSurface &surface, const vec3 &T, RNG &rng) const
+{
+    vec3 L(0.0f);
+
+    vec3  emitterWiWorld, emitterWi;
+    float emitterPdf;
+    const vec3 emitterLi = sampleEmitterLi(p, surface, emitterWiWorld, emitterWi, emitterPdf, rng);
+    if(!isblack(emitterLi)) {
+        const vec3 wi = emitterWi;
+        const vec3 wh = normalize(wi + wo);
+        const float cosTheta = cosThetaTangent(wi);
+        const vec3 bsdf = evaluateBSDF(surface, wo, wi, wh);
+        if(emitterPdf != 0.0f) {
+            // Area emitter: Add contribution with MIS heuristic.
+            const float scatteringPdf = pdfBSDF(surface, wo, wi, wh);
+            const float weight = powerHeuristic(emitterPdf, scatteringPdf);
+            L += (emitterLi * bsdf * cosTheta * weight) / emitterPdf;
+        }
+        else {
+            // Delta-distribution emitter: add contribution directly.
+            L += emitterLi * bsdf * cosTheta;
+        }
+    }
+    if(emitterPdf != 0.0f) {
+        vec3  scatteringWi;
+        float scatteringPdf;
+        const vec3 scatteringLi = sampleScatteringLi(p, surface, wo, scatteringWi, scatteringPdf, rng);
+        if(!isblack(scatteringLi)) {
+            const vec3 wi = scatteringWi;
+            const float cosTheta = cosThetaTangent(wi);
+            const float weight = powerHeuristic(scatteringPdf, emitterPdf);
+            L += (scatteringLi * cosTheta * weight) / scatteringPdf;
+        }
+    }
+    return min(T * float(m_numEmitters) * L, vec3(m_params.directRadianceClamp));
+}
+
+vec3 PathTracer::indirectLighting(const vec3 &p, const vec3 &wo, const DifferentialSurface &surface, const vec3 &T, uint32_t depth, RNG &rng) const
+{
+    vec3 wi;
+    float pdf;
+    const vec3 brdf = sampleBSDF(surface, wo, wi, pdf, rng);
+    if(isblack(brdf) || pdf < Epsilon) {
+        return vec3(0.0f);
+    }
+
+    const float cosTheta = cosThetaTangent(wi);
+    vec3 pathThroughput = T * (brdf * cosTheta) / pdf;
+
+    if(depth > m_params.minDepth) {
+        const float terminationThreshold = std::max(MinTerminationThreshold, 1.0f - maxcomp(pathThroughput));
+        if(rng.nextFloat() < terminationThreshold) {
+            return vec3(0.0f);
+        }
+        pathThroughput /= 1.0f - terminationThreshold;
+    }
+
+    const vec3 wiWorld = tangentToWorld(surface.basis, wi);
+    const vec3 Li = traceRadiance(p, wiWorld, Epsilon, pathThroughput, depth + 1, rng);
+    return min(Li, vec3(m_params.indirectRadianceClamp));
+}
+
+vec3 PathTracer::fetchSkyRadiance(const vec3 &w) const
+{
+    const Emitter &skyEmitter = m_scene.emitters[0];
+    vec3 radiance = skyEmitter.radiance;
+    if(skyEmitter.textureIndex != ~0u) {
+        vec2 uv = skyuv(w);
+        // Apply uv offset.
+        uv.x += skyEmitter.direction.x;
+        uv.y += skyEmitter.direction.y;
+        radiance = skyEmitter.intensity * fetchTexture(skyEmitter.textureIndex, uv);
+    }
+    return radiance;
+}
+
+vec3 PathTracer::fetchTexture(uint32_t textureIndex, const vec2 &uv) const
+{
+    const Texture *texture = m_scene.textures[int(textureIndex)].data();
+    return texture->isValid() ? texture->sample(uv) : vec3(0.0f);
+}
+
+void PathTracer::initializeSurfaceBSDF(DifferentialSurface &surface)
+{
+    // Fresnel reflectance at normal incidence (for metals use albedo color).
+    surface.reflectance = mix(kF0_dielectric, surface.albedo, surface.metalness);
+
+    // Specular BRDF coefficients.
+    surface.alpha  = pow2(surface.roughness);
+    surface.alpha2 = pow2(surface.alpha);
+
+    // Sampling weights.
+    const float weightDiffuse  = mix(luminance(surface.albedo), 0.0f, surface.metalness);
+    const float weightSpecular = luminance(surface.reflectance);
+    surface.swSpecular = std::min(1.0f, weightSpecular / (weightDiffuse + weightSpecular));
+}
+
+vec3 PathTracer::evaluateBSDF(const DifferentialSurface &surface, const vec3 &wo, const vec3 &wi, const vec3 &wh)
+{
+    const float cos_wo = cosThetaTangent(wo);
+    const float cos_wi = cosThetaTangent(wi);
+    const float cos_wh = cosThetaTangent(wh);
+
+    const float D = D_ggx(surface.alpha2, cos_wh);
+    const float G = G_schlick_ggx(surface.alpha, cos_wo, cos_wi);
+    const vec3  F = F_schlick(surface.reflectance, wo, wh);
+
+    // Energy conserving diffuse term, metals have no diffuse contribution (see bsdf.glsl).
+    const vec3 kd = mix(vec3(1.0f) - F, vec3(0.0f), surface.metalness);
+    const vec3 diffuse = kd * surface.albedo * InvPI;
+
+    // Cook-Torrance specular microfacet BRDF.
+    const vec3 specular = F * (D * G * 0.25f);
+
+    return diffuse + specular;
+}
+
+float PathTracer::pdfBSDF(const DifferentialSurface &surface, const vec3 &wo, const vec3 &wi, const vec3 &wh)
+{
+    Q_UNUSED(wo);
+
+    // Specular pdf normalization term is due to change of variables.
+    const float pdfDiffuse  = pdfHemisphereCosine(cosThetaTangent(wi));
+    const float pdfSpecular = pdfD_ggx(surface.alpha2, cosThetaTangent(wh)) / std::max(Epsilon, 4.0f * dot(wi, wh));
+    return mix(pdfDiffuse, pdfSpecular, surface.swSpecular);
+}
+
+vec3 PathTracer::sampleBSDF(const DifferentialSurface &surface, const vec3 &wo, vec3 &wi, float &pdf, RNG &rng)
+{
+    vec3 wh;
+
+    const vec3 u = rng.nextVec3();
+
+    // Sample either specular or diffuse BRDF based on sampling weights.
+    if(u.z < surface.swSpecular) {
+        wh = sampleD_ggx({u.x, u.y}, surface.alpha2);
+        wi = -reflect(wo, wh);
+    }
+    else {
+        wi = sampleHemisphereCosine({u.x, u.y});
+        wh = normalize(wi + wo);
+    }
+
+    pdf = pdfBSDF(surface, wo, wi, wh);
+    return evaluateBSDF(surface, wo, wi, wh);
+}
+
+vec3 PathTracer::tangentToWorld(const TangentBasis &basis, const vec3 &v)
+{
+    return basis.T * v.x + basis.B * v.y + basis.N * v.z;
+}
+
+vec3 PathTracer::worldToTangent(const TangentBasis &basis, const vec3 &v)
+{
+    return { dot(basis.T, v), dot(basis.B, v), dot(basis.N, v) };
+}
+
+} // Cpu
+} // Qt3DRaytrace
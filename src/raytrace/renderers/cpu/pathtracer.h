@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/cpu/cpucommon.h>
+#include <renderers/cpu/vecmath.h>
+#include <renderers/cpu/scene.h>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+struct RenderParameters
+{
+    uint32_t minDepth;
+    uint32_t maxDepth;
+    uint32_t frameNumber;
+    float directRadianceClamp;
+    float indirectRadianceClamp;
+    vec3 cameraPosition;
+    vec3 cameraUpVector;
+    vec3 cameraRightVector;
+    vec3 cameraForwardVector;
+    float aspectRatio;
+    float tanHalfFOV;
+    float lensRadius;
+    float lensFocalDistance;
+};
+
+struct DisplayParameters
+{
+    float invGamma;
+    float exposure;
+    float tonemapFactorSq;
+};
+
+// Xoroshiro64* RNG
+struct RNG
+{
+    RNG(uint32_t x, uint32_t y, uint32_t frameNumber);
+
+    uint32_t next();
+    float nextFloat();
+    uint32_t nextUInt(uint32_t nmax);
+    vec2 nextVec2();
+    vec3 nextVec3();
+
+    uint32_t s[2];
+};
+
+// Host port of the Vulkan path tracing shaders (pathtrace.rgen, pathtrace.rchit and friends).
+class PathTracer
+{
+public:
+    PathTracer(const Scene &scene, const RenderParameters &params);
+
+    vec3 renderPixel(uint32_t x, uint32_t y, uint32_t width, uint32_t height) const;
+
+    static vec3 tonemap(const vec3 &color, const DisplayParameters &params);
+
+private:
+    struct TangentBasis {
+        vec3 T, N, B;
+    };
+
+    struct DifferentialSurface {
+        TangentBasis basis;
+        vec3 albedo;
+        vec3 reflectance;
+        float roughness;
+        float metalness;
+        float alpha, alpha2;
+        float swSpecular;
+    };
+
+    vec3 traceRadiance(const vec3 &p, const vec3 &w, float tmin, const vec3 &T, uint32_t depth, RNG &rng) const;
+    vec3 traceEmission(const vec3 &p, const vec3 &w) const;
+
+    vec3 sampleEmitterLi(const vec3 &p, const DifferentialSurface &surface, vec3 &wiWorld, vec3 &wiTangent, float &pdf, RNG &rng) const;
+    vec3 sampleScatteringLi(const vec3 &p, const DifferentialSurface &surface, const vec3 &wo, vec3 &wi, float &pdf, RNG &rng) const;
+    vec3 directLighting(const vec3 &p, const vec3 &wo, const DifferentialSurface &surface, const vec3 &T, RNG &rng) const;
+    vec3 indirectLighting(const vec3 &p, const vec3 &wo, const DifferentialSurface &surface, const vec3 &T, uint32_t depth, RNG &rng) const;
+
+    vec3 fetchSkyRadiance(const vec3 &w) const;
+    vec3 fetchTexture(uint32_t textureIndex, const vec2 &uv) const;
+
+    static void initializeSurfaceBSDF(DifferentialSurface &surface);
+    static vec3 evaluateBSDF(const DifferentialSurface &surface, const vec3 &wo, const vec3 &wi, const vec3 &wh);
+    static float pdfBSDF(const DifferentialSurface &surface, const vec3 &wo, const vec3 &wi, const vec3 &wh);
+    static vec3 sampleBSDF(const DifferentialSurface &surface, const vec3 &wo, vec3 &wi, float &pdf, RNG &rng);
+
+    static vec3 tangentToWorld(const TangentBasis &basis, const vec3 &v);
+    static vec3 worldToTangent(const TangentBasis &basis, const vec3 &v);
+
+    const Scene &m_scene;
+    const RenderParameters &m_params;
+    const uint32_t m_numEmitters;
+};
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,579 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/renderer.h>
+
+#include <renderers/cpu/jobs/buildgeometryjob.h>
+#include <renderers/cpu/jobs/buildscenejob.h>
+#include <renderers/cpu/jobs/uploadtexturejob.h>
+
+#include <backend/managers_p.h>
+#include <backend/rendersettings_p.h>
+
+#include <QWindow>
+#include <QBackingStore>
+#include <QPainter>
+#include <QThread>
+#include <QTimer>
+#include <QRunnable>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+namespace Config {
+
+constexpr uint32_t TileSize = 32;
+constexpr int      IdleFrameInterval = 10;
+constexpr int      DefaultRenderWidth = 1280;
+constexpr int      DefaultRenderHeight = 720;
+
+} // Config
+
+Q_LOGGING_CATEGORY(logCpu, "raytrace.cpu")
+
+class Renderer::TileWorker final : public QRunnable
+{
+public:
+    explicit TileWorker(Renderer *renderer)
+        : m_renderer(renderer)
+    {}
+
+    void run() override
+    {
+        FrameContext &frame = m_renderer->m_frame;
+        const int numTiles = int(frame.numTilesX * frame.numTilesY);
+        while(!frame.cancelled.loadAcquire()) {
+            const int tileIndex = frame.nextTile.fetchAndAddRelaxed(1);
+            if(tileIndex >= numTiles) {
+                break;
+            }
+            m_renderer->renderTile(uint32_t(tileIndex));
+        }
+        if(frame.activeWorkers.fetchAndSubOrdered(1) == 1) {
+            QMetaObject::invokeMethod(m_renderer, "finishFrame", Qt::QueuedConnection);
+        }
+    }
+
+private:
+    Renderer *m_renderer;
+};
+
+static inline uchar toUNorm8(float value)
+{
+    return uchar(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+Renderer::Renderer(QObject *parent)
+    : QObject(parent)
+    , m_renderFrameTimer(new QTimer(this))
+    , m_frameAdvanceService(new FrameAdvanceService)
+    , m_cameraManager(new CameraManager)
+    , m_updateWorldTransformJob(new Raytrace::UpdateWorldTransformJob)
+    , m_updateRenderParametersJob(new UpdateRenderParametersJob(this))
+{
+    m_renderFrameTimer->setSingleShot(true);
+    QObject::connect(m_renderFrameTimer, &QTimer::timeout, this, &Renderer::renderFrame);
+}
+
+Renderer::~Renderer()
+{
+    cancelFrame();
+    delete m_backingStore;
+}
+
+bool Renderer::initialize()
+{
+    m_sceneManager.reset(new SceneManager);
+    m_threadPool.setMaxThreadCount(QThread::idealThreadCount());
+    qCInfo(logCpu) << "Using" << m_threadPool.maxThreadCount() << "render threads";
+
+    m_renderFrameTimer->start(0);
+    m_frameAdvanceService->proceedToNextFrame();
+    return true;
+}
+
+void Renderer::shutdown()
+{
+    m_renderFrameTimer->stop();
+    cancelFrame();
+    releaseRenderBuffers();
+
+    if(m_sceneManager) {
+        m_sceneManager->clear();
+    }
+}
+
+QVector<Qt3DCore::QAspectJobPtr> Renderer::createGeometryJobs()
+{
+    auto *geometryManager = &m_nodeManagers->geometryManager;
+    auto dirtyGeometry = geometryManager->acquireDirtyComponents();
+
+    QVector<Qt3DCore::QAspectJobPtr> buildGeometryJobs;
+    buildGeometryJobs.reserve(dirtyGeometry.size());
+    for(const Qt3DCore::QNodeId &geometryId : dirtyGeometry) {
+        Raytrace::HGeometry handle = geometryManager->lookupHandle(geometryId);
+        if(!handle.isNull()) {
+            auto job = BuildGeometryJobPtr::create(this, handle);
+            buildGeometryJobs.append(job);
+        }
+    }
+    return buildGeometryJobs;
+}
+
+QVector<Qt3DCore::QAspectJobPtr> Renderer::createTextureJobs()
+{
+    auto *textureImageManager = &m_nodeManagers->textureImageManager;
+    auto dirtyTextureImages = textureImageManager->acquireDirtyComponents();
+
+    QVector<Qt3DCore::QAspectJobPtr> uploadTextureJobs;
+    uploadTextureJobs.reserve(dirtyTextureImages.size());
+    for(const Qt3DCore::QNodeId &textureImageId : dirtyTextureImages) {
+        Raytrace::HTextureImage handle = textureImageManager->lookupHandle(textureImageId);
+        if(!handle.isNull()) {
+            auto job = UploadTextureJobPtr::create(this, handle);
+            uploadTextureJobs.append(job);
+        }
+    }
+    return uploadTextureJobs;
+}
+
+QSize Renderer::queryRenderSize() const
+{
+    QReadLocker lock(&m_windowSurfaceLock);
+    if(m_window) {
+        return m_window->size() * m_window->devicePixelRatio();
+    }
+    return QSize(Config::DefaultRenderWidth, Config::DefaultRenderHeight);
+}
+
+void Renderer::resizeRenderBuffers(const QSize &size)
+{
+    QWriteLocker lock(&m_imageLock);
+
+    const int numPixels = size.width() * size.height();
+    for(int index=0; index < 2; ++index) {
+        m_renderBuffers[index].fill(0.0f, numPixels * 4);
+        m_displayImages[index] = QImage(size, QImage::Format_RGBA8888);
+        m_displayImages[index].fill(Qt::black);
+    }
+    m_renderBufferSize = size;
+    m_renderBuffersReady = false;
+    resetRenderProgress();
+}
+
+void Renderer::releaseRenderBuffers()
+{
+    QWriteLocker lock(&m_imageLock);
+
+    for(int index=0; index < 2; ++index) {
+        m_renderBuffers[index].clear();
+        m_displayImages[index] = QImage();
+    }
+    m_renderBufferSize = QSize();
+    m_renderBuffersReady = false;
+}
+
+void Renderer::beginRenderIteration()
+{
+    RenderParameters &renderParams = m_frame.renderParams;
+    if(m_settings) {
+        renderParams.minDepth = m_settings->minDepth();
+        renderParams.maxDepth = m_settings->maxDepth();
+        renderParams.directRadianceClamp = m_settings->directRadianceClamp();
+        renderParams.indirectRadianceClamp = m_settings->indirectRadianceClamp();
+    }
+    renderParams.frameNumber = ++m_frameNumber;
+
+    m_cameraManager->applyRenderParameters(renderParams);
+    m_cameraManager->applyDisplayParameters(m_frame.displayParams);
+}
+
+void Renderer::renderTile(uint32_t tileIndex) const
+{
+    const FrameContext &frame = m_frame;
+    const PathTracer pathTracer(*frame.scene, frame.renderParams);
+
+    const uint32_t x0 = (tileIndex % frame.numTilesX) * Config::TileSize;
+    const uint32_t y0 = (tileIndex / frame.numTilesX) * Config::TileSize;
+    const uint32_t x1 = std::min(x0 + Config::TileSize, frame.width);
+    const uint32_t y1 = std::min(y0 + Config::TileSize, frame.height);
+
+    const float invFrameNumber = 1.0f / float(frame.renderParams.frameNumber);
+    for(uint32_t y=y0; y < y1; ++y) {
+        uchar *displayScanline = frame.displayImage + y * uint32_t(frame.displayImageStride);
+        for(uint32_t x=x0; x < x1; ++x) {
+            vec3 L = pathTracer.renderPixel(x, y, frame.width, frame.height);
+            if(!isfinite(L)) {
+                L = vec3(0.0f);
+            }
+
+            const uint32_t offset = 4 * (y * frame.width + x);
+            const float *prevPixel = &frame.prevRenderBuffer[offset];
+            float *pixel = &frame.renderBuffer[offset];
+
+            const vec3 prevColor = { prevPixel[0], prevPixel[1], prevPixel[2] };
+            const vec3 color = prevColor + (L - prevColor) * invFrameNumber;
+            pixel[0] = color.x;
+            pixel[1] = color.y;
+            pixel[2] = color.z;
+            pixel[3] = 1.0f;
+
+            const vec3 displayColor = PathTracer::tonemap(color, frame.displayParams);
+            uchar *displayPixel = &displayScanline[4 * x];
+            displayPixel[0] = toUNorm8(displayColor.x);
+            displayPixel[1] = toUNorm8(displayColor.y);
+            displayPixel[2] = toUNorm8(displayColor.z);
+            displayPixel[3] = 255;
+        }
+    }
+}
+
+void Renderer::cancelFrame()
+{
+    if(m_frameInFlight) {
+        m_frame.cancelled.storeRelease(1);
+        m_threadPool.waitForDone();
+        m_frame.scene.reset();
+        m_frameInFlight = false;
+    }
+}
+
+void Renderer::presentFrame()
+{
+    QWriteLocker lock(&m_windowSurfaceLock);
+    if(!m_window || !m_window->isExposed()) {
+        return;
+    }
+
+    // Surface type can still change after the window has been handed to the renderer
+    // so the backing store is created lazily, on the GUI thread.
+    if(!m_backingStore) {
+        if(m_window->surfaceType() != QSurface::RasterSurface) {
+            if(!m_warnedOffscreen) {
+                qCInfo(logCpu) << "Surface is not a raster surface: rendering offscreen";
+                m_warnedOffscreen = true;
+            }
+            return;
+        }
+        m_backingStore = new QBackingStore(m_window);
+    }
+
+    const QRect targetRect = { {0, 0}, m_window->size() };
+    if(m_backingStore->size() != targetRect.size()) {
+        m_backingStore->resize(targetRect.size());
+    }
+
+    m_backingStore->beginPaint(targetRect);
+    {
+        QPainter painter(m_backingStore->paintDevice());
+        painter.drawImage(targetRect, m_displayImages[m_displayIndex]);
+    }
+    m_backingStore->endPaint();
+    m_backingStore->flush(targetRect);
+}
+
+void Renderer::renderFrame()
+{
+    Q_ASSERT(m_sceneManager);
+    if(m_frameInFlight) {
+        return;
+    }
+
+    const QSize renderSize = queryRenderSize();
+    quint64 sceneVersion;
+    const ScenePtr scene = m_sceneManager->scene(&sceneVersion);
+    if(renderSize.isEmpty() || !scene) {
+        // Nothing to render yet; keep the aspect jobs flowing.
+        m_frameAdvanceService->proceedToNextFrame();
+        m_renderFrameTimer->start(Config::IdleFrameInterval);
+        return;
+    }
+
+    if(renderSize != m_renderBufferSize) {
+        resizeRenderBuffers(renderSize);
+    }
+
+    // Accumulation restarts once a new scene or camera is picked up for rendering rather than when changes are
+    // signalled, since the scene is rebuilt asynchronously and samples of the outdated one would be kept otherwise.
+    const quint64 cameraVersion = m_cameraManager->renderParametersVersion();
+    if(sceneVersion != m_renderedSceneVersion || cameraVersion != m_renderedCameraVersion) {
+        m_renderedSceneVersion = sceneVersion;
+        m_renderedCameraVersion = cameraVersion;
+        resetRenderProgress();
+    }
+
+    const int currentIndex = m_displayIndex ^ 1;
+
+    m_frame.scene = scene;
+    m_frame.width = uint32_t(renderSize.width());
+    m_frame.height = uint32_t(renderSize.height());
+    m_frame.numTilesX = (m_frame.width + Config::TileSize - 1) / Config::TileSize;
+    m_frame.numTilesY = (m_frame.height + Config::TileSize - 1) / Config::TileSize;
+    m_frame.prevRenderBuffer = m_renderBuffers[m_displayIndex].constData();
+    m_frame.renderBuffer = m_renderBuffers[currentIndex].data();
+    m_frame.displayImage = m_displayImages[currentIndex].bits();
+    m_frame.displayImageStride = m_displayImages[currentIndex].bytesPerLine();
+    beginRenderIteration();
+
+    const int numTiles = int(m_frame.numTilesX * m_frame.numTilesY);
+    const int numWorkers = std::min(m_threadPool.maxThreadCount(), numTiles);
+    m_frame.nextTile.store(0);
+    m_frame.cancelled.store(0);
+    m_frame.activeWorkers.storeRelease(numWorkers);
+
+    m_frameInFlight = true;
+    m_frameTimer.start();
+    for(int i=0; i < numWorkers; ++i) {
+        m_threadPool.start(new TileWorker(this));
+    }
+}
+
+void Renderer::finishFrame()
+{
+    if(!m_frameInFlight) {
+        return;
+    }
+    m_frameInFlight = false;
+    m_frame.scene.reset();
+
+    {
+        QWriteLocker lock(&m_imageLock);
+        m_displayIndex ^= 1;
+        m_renderBuffersReady = true;
+    }
+
+    updateFrameTimings(m_frameTimer.nsecsElapsed() * 1e-6);
+    presentFrame();
+
+    m_frameAdvanceService->proceedToNextFrame();
+    m_renderFrameTimer->start(0);
+}
+
+void Renderer::resetRenderProgress()
+{
+    m_frameNumber = 0;
+
+    if(m_frameElapsedTimer.isValid()) {
+        m_frameElapsedTimer.restart();
+    }
+    else {
+        m_frameElapsedTimer.start();
+    }
+}
+
+void Renderer::updateActiveCamera()
+{
+    Q_ASSERT(m_cameraManager);
+    if(m_settings) {
+        Raytrace::Entity *cameraEntity = m_nodeManagers->entityManager.lookupResource(m_settings->cameraId());
+        if(cameraEntity && cameraEntity->isCamera()) {
+            m_cameraManager->setActiveCamera(cameraEntity);
+        }
+    }
+}
+
+void Renderer::updateFrameTimings(double hostFrameTime)
+{
+    QWriteLocker lock(&m_frameTimingsLock);
+    m_hostTimeAverage.add(hostFrameTime);
+}
+
+QSurface *Renderer::surface() const
+{
+    QReadLocker lock(&m_windowSurfaceLock);
+    return m_window;
+}
+
+void Renderer::setSurface(QObject *surfaceObject)
+{
+    QWriteLocker lock(&m_windowSurfaceLock);
+
+    delete m_backingStore;
+    m_backingStore = nullptr;
+    m_window = nullptr;
+
+    if(surfaceObject) {
+        if(QWindow *window = qobject_cast<QWindow*>(surfaceObject)) {
+            m_window = window;
+            m_warnedOffscreen = false;
+        }
+        else {
+            qCWarning(logCpu) << "Incompatible surface object: expected QWindow instance";
+        }
+    }
+}
+
+void Renderer::markDirty(DirtySet changes, Raytrace::BackendNode *node)
+{
+    Q_UNUSED(node);
+    m_dirtySet |= changes;
+}
+
+Raytrace::Entity *Renderer::sceneRoot() const
+{
+    return m_sceneRoot;
+}
+
+void Renderer::setSceneRoot(Raytrace::Entity *rootEntity)
+{
+    m_sceneRoot = rootEntity;
+    m_updateWorldTransformJob->setRoot(m_sceneRoot);
+}
+
+Raytrace::RenderSettings *Renderer::settings() const
+{
+    return m_settings;
+}
+
+QRenderStatistics Renderer::statistics() const
+{
+    QReadLocker lock(&m_frameTimingsLock);
+
+    QRenderStatistics stats;
+    stats.cpuFrameTime = m_hostTimeAverage.average();
+    stats.gpuFrameTime = 0.0;
+    stats.totalRenderTime = m_frameElapsedTimer.elapsed() * 1e-3;
+    stats.numFramesRendered = m_frameNumber;
+    return stats;
+}
+
+void Renderer::setSettings(Raytrace::RenderSettings *settings)
+{
+    m_settings = settings;
+    updateActiveCamera();
+}
+
+void Renderer::setNodeManagers(Raytrace::NodeManagers *nodeManagers)
+{
+    Q_ASSERT(nodeManagers);
+    m_nodeManagers = nodeManagers;
+    m_updateWorldTransformJob->setManagers(m_nodeManagers);
+}
+
+Qt3DCore::QAbstractFrameAdvanceService *Renderer::frameAdvanceService() const
+{
+    return m_frameAdvanceService.get();
+}
+
+Raytrace::NodeManagers *Renderer::nodeManagers() const
+{
+    return m_nodeManagers;
+}
+
+SceneManager *Renderer::sceneManager() const
+{
+    return m_sceneManager.get();
+}
+
+CameraManager *Renderer::cameraManager() const
+{
+    return m_cameraManager.get();
+}
+
+QVector<Qt3DCore::QAspectJobPtr> Renderer::jobsToExecute(qint64 time)
+{
+    Q_UNUSED(time);
+
+    QVector<Qt3DCore::QAspectJobPtr> jobs;
+
+    bool shouldUpdateRenderParameters = false;
+    bool shouldBuildScene = false;
+
+    m_updateRenderParametersJob->removeDependency(m_updateWorldTransformJob);
+
+    if(m_dirtySet & (DirtyFlag::EntityDirty | DirtyFlag::LightDirty | DirtyFlag::MaterialDirty)) {
+        m_nodeManagers->materialManager.clearDirtyComponents();
+        shouldBuildScene = true;
+    }
+
+    if(m_dirtySet & DirtyFlag::TransformDirty) {
+        jobs.append(m_updateWorldTransformJob);
+        m_updateRenderParametersJob->addDependency(m_updateWorldTransformJob);
+        shouldUpdateRenderParameters = true;
+        shouldBuildScene = true;
+    }
+
+    QVector<Qt3DCore::QAspectJobPtr> geometryJobs;
+    if(m_dirtySet & DirtyFlag::GeometryDirty) {
+        geometryJobs = createGeometryJobs();
+        jobs.append(geometryJobs);
+        shouldBuildScene = true;
+    }
+
+    QVector<Qt3DCore::QAspectJobPtr> textureJobs;
+    if(m_dirtySet & DirtyFlag::TextureDirty) {
+        textureJobs = createTextureJobs();
+        jobs.append(textureJobs);
+        shouldBuildScene = true;
+    }
+
+    if(m_dirtySet & DirtyFlag::CameraDirty) {
+        updateActiveCamera();
+        shouldUpdateRenderParameters = true;
+    }
+
+    m_dirtySet = DirtyFlag::NoneDirty;
+
+    if(shouldUpdateRenderParameters) {
+        jobs.append(m_updateRenderParametersJob);
+    }
+
+    if(shouldBuildScene) {
+        Qt3DCore::QAspectJobPtr buildSceneJob = BuildSceneJobPtr::create(this);
+        buildSceneJob->addDependency(m_updateWorldTransformJob);
+        for(const auto &job : geometryJobs) {
+            buildSceneJob->addDependency(job);
+        }
+        for(const auto &job : textureJobs) {
+            buildSceneJob->addDependency(job);
+        }
+        jobs.append(buildSceneJob);
+    }
+
+    return jobs;
+}
+
+QImageData Renderer::grabImage(QRenderImage type)
+{
+    QReadLocker lock(&m_imageLock);
+
+    if(!m_renderBuffersReady) {
+        qCWarning(logCpu) << "Cannot grab render buffer: image not ready";
+        return QImageData{};
+    }
+
+    QImageData output = {};
+    output.width    = m_renderBufferSize.width();
+    output.height   = m_renderBufferSize.height();
+    output.channels = 4;
+    output.format   = QImageData::Format::RGBA;
+
+    switch(type) {
+    case QRenderImage::HDR: {
+        const QVector<float> &renderBuffer = m_renderBuffers[m_displayIndex];
+        output.type = QImageData::ValueType::Float32;
+        output.data = QByteArray(reinterpret_cast<const char*>(renderBuffer.constData()), renderBuffer.size() * int(sizeof(float)));
+        break;
+    }
+    case QRenderImage::FinalLDR: {
+        const QImage &displayImage = m_displayImages[m_displayIndex];
+        const int rowSize = output.width * output.channels;
+        output.type = QImageData::ValueType::UInt8;
+        output.data.resize(rowSize * output.height);
+        for(int y=0; y < output.height; ++y) {
+            std::memcpy(output.data.data() + y * rowSize, displayImage.constScanLine(y), size_t(rowSize));
+        }
+        break;
+    }
+    }
+    return output;
+}
+
+} // Cpu
+} // Qt3DRaytrace
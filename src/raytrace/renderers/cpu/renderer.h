@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <backend/abstractrenderer_p.h>
+
+#include <renderers/cpu/cpucommon.h>
+#include <renderers/cpu/pathtracer.h>
+#include <renderers/cpu/services/frameadvanceservice.h>
+#include <renderers/cpu/managers/scenemanager.h>
+#include <renderers/cpu/managers/cameramanager.h>
+
+#include <jobs/updateworldtransformjob_p.h>
+#include <renderers/cpu/jobs/updaterenderparametersjob.h>
+
+#include <utility/movingaverage.h>
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QReadWriteLock>
+#include <QThreadPool>
+#include <QVector>
+#include <QImage>
+#include <QSize>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+class QWindow;
+class QTimer;
+class QBackingStore;
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+class Renderer final : public QObject
+                     , public Raytrace::AbstractRenderer
+{
+    Q_OBJECT
+public:
+    explicit Renderer(QObject *parent = nullptr);
+    ~Renderer() override;
+
+    QSurface *surface() const override;
+
+    bool initialize() override;
+    void shutdown() override;
+
+    void markDirty(DirtySet changes, Raytrace::BackendNode *node) override;
+
+    Raytrace::Entity *sceneRoot() const override;
+    Raytrace::RenderSettings *settings() const override;
+    QRenderStatistics statistics() const override;
+
+    void setSurface(QObject *surfaceObject) override;
+    void setSceneRoot(Raytrace::Entity *rootEntity) override;
+    void setSettings(Raytrace::RenderSettings *settings) override;
+    void setNodeManagers(Raytrace::NodeManagers *nodeManagers) override;
+
+    Qt3DCore::QAbstractFrameAdvanceService *frameAdvanceService() const override;
+    Raytrace::NodeManagers *nodeManagers() const;
+    SceneManager *sceneManager() const;
+    CameraManager *cameraManager() const;
+
+    QVector<Qt3DCore::QAspectJobPtr> jobsToExecute(qint64 time) override;
+
+    QImageData grabImage(QRenderImage type) override;
+
+private slots:
+    void renderFrame();
+    void finishFrame();
+
+private:
+    class TileWorker;
+
+    struct FrameContext {
+        ScenePtr scene;
+        RenderParameters renderParams;
+        DisplayParameters displayParams;
+        uint32_t width;
+        uint32_t height;
+        uint32_t numTilesX;
+        uint32_t numTilesY;
+        const float *prevRenderBuffer;
+        float *renderBuffer;
+        uchar *displayImage;
+        int displayImageStride;
+        QAtomicInt nextTile;
+        QAtomicInt activeWorkers;
+        QAtomicInt cancelled;
+    };
+
+    QVector<Qt3DCore::QAspectJobPtr> createGeometryJobs();
+    QVector<Qt3DCore::QAspectJobPtr> createTextureJobs();
+
+    QSize queryRenderSize() const;
+    void resizeRenderBuffers(const QSize &size);
+    void releaseRenderBuffers();
+
+    void beginRenderIteration();
+    void renderTile(uint32_t tileIndex) const;
+    void cancelFrame();
+    void presentFrame();
+
+    void resetRenderProgress();
+    void updateActiveCamera();
+    void updateFrameTimings(double hostFrameTime);
+
+    QWindow *m_window = nullptr;
+    QBackingStore *m_backingStore = nullptr;
+    bool m_warnedOffscreen = false;
+    mutable QReadWriteLock m_windowSurfaceLock;
+    mutable QReadWriteLock m_frameTimingsLock;
+    mutable QReadWriteLock m_imageLock;
+
+    QTimer *m_renderFrameTimer = nullptr;
+    QThreadPool m_threadPool;
+
+    Raytrace::NodeManagers *m_nodeManagers = nullptr;
+    Raytrace::RenderSettings *m_settings = nullptr;
+
+    QSharedPointer<FrameAdvanceService> m_frameAdvanceService;
+    QSharedPointer<SceneManager> m_sceneManager;
+    QSharedPointer<CameraManager> m_cameraManager;
+
+    QSize m_renderBufferSize;
+    QVector<float> m_renderBuffers[2];
+    QImage m_displayImages[2];
+    int m_displayIndex = 0;
+    bool m_renderBuffersReady = false;
+
+    FrameContext m_frame;
+    bool m_frameInFlight = false;
+    QElapsedTimer m_frameTimer;
+
+    uint32_t m_frameNumber = 0;
+    QElapsedTimer m_frameElapsedTimer;
+    quint64 m_renderedSceneVersion = 0;
+    quint64 m_renderedCameraVersion = 0;
+
+    Raytrace::UpdateWorldTransformJobPtr m_updateWorldTransformJob;
+    UpdateRenderParametersJobPtr m_updateRenderParametersJob;
+
+    Raytrace::Entity *m_sceneRoot = nullptr;
+    DirtySet m_dirtySet = DirtyFlag::AllDirty;
+
+    Utility::MovingAverage<double> m_hostTimeAverage;
+};
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/scene.h>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+namespace Config {
+
+constexpr uint32_t MaxInstancesPerLeaf = 2;
+
+} // Config
+
+void Scene::buildInstanceBvh()
+{
+    QVector<Aabb> instanceBounds(instances.size());
+    for(int i=0; i < instances.size(); ++i) {
+        const EntityInstance &instance = instances[i];
+        const TriangleMesh *mesh = geometry[int(instance.geometryIndex)].data();
+        instanceBounds[i] = mesh->bounds().transformed(instance.transform);
+    }
+    m_instanceBvh.build(instanceBounds, Config::MaxInstancesPerLeaf);
+}
+
+template<bool AnyHit>
+bool Scene::traverse(const Ray &ray, Hit &hit) const
+{
+    const uint32_t *instanceIndices = m_instanceBvh.primitiveIndices().constData();
+
+    return m_instanceBvh.traverse<AnyHit>(ray, [this, &ray, &hit, instanceIndices](const BvhNode &leaf, float &tmax) {
+        bool leafHit = false;
+        for(uint32_t i=0; i < leaf.count; ++i) {
+            const uint32_t instanceIndex = instanceIndices[leaf.offset + i];
+            const EntityInstance &instance = instances[int(instanceIndex)];
+            const TriangleMesh *mesh = geometry[int(instance.geometryIndex)].data();
+
+            // Direction is not normalized so that ray parameter t remains valid in world space.
+            Ray objectRay;
+            objectRay.origin = instance.inverseTransform.mapPoint(ray.origin);
+            objectRay.direction = instance.inverseTransform.mapVector(ray.direction);
+            objectRay.tmin = ray.tmin;
+            objectRay.tmax = tmax;
+
+            if(AnyHit) {
+                if(mesh->occluded(objectRay)) {
+                    return true;
+                }
+            }
+            else if(mesh->intersect(objectRay, hit)) {
+                hit.instance = instanceIndex;
+                tmax = hit.t;
+                leafHit = true;
+            }
+        }
+        return leafHit;
+    });
+}
+
+bool Scene::intersect(const Ray &ray, Hit &hit) const
+{
+    return traverse<false>(ray, hit);
+}
+
+bool Scene::occluded(const Ray &ray) const
+{
+    Hit hit;
+    return traverse<true>(ray, hit);
+}
+
+} // Cpu
+} // Qt3DRaytrace
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/cpu/cpucommon.h>
+#include <renderers/cpu/vecmath.h>
+#include <renderers/cpu/bvh.h>
+#include <renderers/cpu/geometry.h>
+#include <renderers/cpu/texture.h>
+
+#include <QVector>
+#include <QSharedPointer>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+// Host-side counterparts of structures declared in shaders/lib/shared.glsl.
+
+struct Material
+{
+    vec3 albedo;
+    float roughness;
+    vec3 emission;
+    float metalness;
+    uint32_t albedoTexture;
+    uint32_t roughnessTexture;
+    uint32_t metalnessTexture;
+};
+
+struct Emitter
+{
+    uint32_t instanceIndex;
+    uint32_t geometryIndex;
+    uint32_t textureIndex;
+    float intensity;
+    vec3 radiance;
+    vec3 direction;
+};
+
+struct EntityInstance
+{
+    uint32_t materialIndex;
+    uint32_t geometryIndex;
+    Affine3 transform;
+    Affine3 inverseTransform;
+    Basis3 basisTransform;
+};
+
+// Immutable snapshot of the scene consumed by render threads.
+class Scene
+{
+public:
+    bool intersect(const Ray &ray, Hit &hit) const;
+    bool occluded(const Ray &ray) const;
+
+    void buildInstanceBvh();
+
+    QVector<TriangleMeshPtr> geometry;
+    QVector<TexturePtr> textures;
+    QVector<Material> materials;
+    QVector<EntityInstance> instances;
+    QVector<Emitter> emitters;
+
+private:
+    template<bool AnyHit>
+    bool traverse(const Ray &ray, Hit &hit) const;
+
+    Bvh m_instanceBvh;
+};
+
+using ScenePtr = QSharedPointer<const Scene>;
+
+} // Cpu
+} // Qt3DRaytrace
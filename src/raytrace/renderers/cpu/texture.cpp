@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/cpu/texture.h>
+#include <io/blockcompression_p.h>
+
+#include <QtCore/qfloat16.h>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+namespace {
+
+struct SrgbLookupTable
+{
+    SrgbLookupTable()
+    {
+        for(int i=0; i < 256; ++i) {
+            const float c = i / 255.0f;
+            values[i] = (c <= 0.04045f) ? (c / 12.92f) : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+    float values[256];
+};
+
+template<typename T>
+float readValue(const T *data);
+
+template<>
+float readValue<quint8>(const quint8 *data)
+{
+    return *data / 255.0f;
+}
+
+template<>
+float readValue<qfloat16>(const qfloat16 *data)
+{
+    return float(*data);
+}
+
+template<>
+float readValue<float>(const float *data)
+{
+    return *data;
+}
+
+template<typename T>
+void convertTexels(const QImageData &image, bool sRGB, QVector<vec3> &texels)
+{
+    static const SrgbLookupTable srgbTable;
+
+    const T *data = reinterpret_cast<const T*>(image.constBits());
+    const bool swapRB = (image.format == QImageData::Format::BGR || image.format == QImageData::Format::BGRA);
+    const int numTexels = image.width * image.height;
+
+    // Missing channels are read as zero, same as when sampling on the GPU.
+    for(int i=0; i < numTexels; ++i) {
+        const T *texel = data + i * image.channels;
+        vec3 value(0.0f);
+        for(int c=0; c < std::min(3, image.channels); ++c) {
+            if(sRGB) {
+                value[c] = srgbTable.values[*reinterpret_cast<const quint8*>(texel + c)];
+            }
+            else {
+                value[c] = readValue<T>(texel + c);
+            }
+        }
+        if(swapRB) {
+            std::swap(value.x, value.z);
+        }
+        texels[i] = value;
+    }
+}
+
+} // anonymous
+
+Texture::Texture(const QImageData &sourceImage)
+{
+    // Only the first mip level is sampled, so block compressed images need just that level decompressed.
+    QImageData image = sourceImage;
+    if(sourceImage.isCompressed()) {
+        QImageData baseLevel = sourceImage;
+        baseLevel.mipLevels = 1;
+        if(!Raytrace::decompressImage(baseLevel, image)) {
+            qCWarning(logCpu) << "Texture: failed to decompress block compressed texture image";
+            return;
+        }
+    }
+
+    if(image.width <= 0 || image.height <= 0 || image.channels <= 0 || image.channels > 4) {
+        qCWarning(logCpu) << "Texture: invalid image dimensions or number of channels";
+        return;
+    }
+
+    const quint64 expectedSize = quint64(image.width) * quint64(image.height) * quint64(image.channels) * quint64(image.type);
+    if(image.type == QImageData::ValueType::Undefined || image.sizeInBytes() < expectedSize) {
+        qCWarning(logCpu) << "Texture: unsupported or incomplete texture image data";
+        return;
+    }
+
+    m_width = image.width;
+    m_height = image.height;
+    m_texels.resize(m_width * m_height);
+
+    switch(image.type) {
+    case QImageData::ValueType::UInt8:
+        // Assume sRGB colorspace for RGB & RGBA LDR formats.
+        convertTexels<quint8>(image, image.channels >= 3, m_texels);
+        break;
+    case QImageData::ValueType::Float16:
+        convertTexels<qfloat16>(image, false, m_texels);
+        break;
+    case QImageData::ValueType::Float32:
+        convertTexels<float>(image, false, m_texels);
+        break;
+    default:
+        Q_ASSERT_X(0, Q_FUNC_INFO, "Unsupported image value type");
+    }
+}
+
+vec3 Texture::sample(const vec2 &uv) const
+{
+    Q_ASSERT(isValid());
+
+    auto wrap = [](int value, int size) -> int {
+        const int result = value % size;
+        return (result < 0) ? (result + size) : result;
+    };
+
+    const float x = uv.x * m_width - 0.5f;
+    const float y = uv.y * m_height - 0.5f;
+    if(!std::isfinite(x) || !std::isfinite(y)) {
+        return vec3(0.0f);
+    }
+
+    const float fx0 = std::floor(x);
+    const float fy0 = std::floor(y);
+    const float fx = x - fx0;
+    const float fy = y - fy0;
+
+    const int x0 = wrap(int(std::fmod(fx0, float(m_width))), m_width);
+    const int y0 = wrap(int(std::fmod(fy0, float(m_height))), m_height);
+    const int x1 = (x0 + 1 == m_width) ? 0 : x0 + 1;
+    const int y1 = (y0 + 1 == m_height) ? 0 : y0 + 1;
+
+    const vec3 top = mix(texel(x0, y0), texel(x1, y0), fx);
+    const vec3 bottom = mix(texel(x0, y1), texel(x1, y1), fx);
+    return mix(top, bottom, fy);
+}
+
+} // Cpu
+} // Qt3DRaytrace
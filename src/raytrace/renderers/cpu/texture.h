@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/cpu/cpucommon.h>
+#include <renderers/cpu/vecmath.h>
+
+#include <Qt3DRaytrace/qimagedata.h>
+
+#include <QVector>
+#include <QSharedPointer>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+// Linear RGB texture sampled with bilinear filtering and repeat addressing mode.
+class Texture
+{
+public:
+    explicit Texture(const QImageData &image);
+
+    bool isValid() const { return !m_texels.isEmpty(); }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    vec3 sample(const vec2 &uv) const;
+
+private:
+    const vec3 &texel(int x, int y) const
+    {
+        return m_texels[y * m_width + x];
+    }
+
+    int m_width = 0;
+    int m_height = 0;
+    QVector<vec3> m_texels;
+};
+
+using TexturePtr = QSharedPointer<const Texture>;
+
+} // Cpu
+} // Qt3DRaytrace
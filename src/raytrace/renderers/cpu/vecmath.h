@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+
+#include <QtGlobal>
+#include <QVector2D>
+#include <QVector3D>
+#include <QMatrix3x3>
+#include <QMatrix4x4>
+
+namespace Qt3DRaytrace {
+namespace Cpu {
+
+// Constants mirror those used by the Vulkan path tracing shaders (see shaders/lib/common.glsl).
+constexpr float PI       = 3.141592f;
+constexpr float HalfPI   = 0.5f * PI;
+constexpr float TwoPI    = 2.0f * PI;
+constexpr float InvPI    = 1.0f / PI;
+constexpr float InvTwoPI = 1.0f / TwoPI;
+
+constexpr float Epsilon  = 0.0001f;
+constexpr float Infinity = 1000000.0f;
+
+struct vec2
+{
+    vec2() = default;
+    constexpr vec2(float x, float y)
+        : x(x), y(y)
+    {}
+    vec2(const QVector2D &v)
+        : x(v.x()), y(v.y())
+    {}
+
+    float x, y;
+};
+
+inline vec2 operator+(const vec2 &a, const vec2 &b) { return { a.x + b.x, a.y + b.y }; }
+inline vec2 operator-(const vec2 &a, const vec2 &b) { return { a.x - b.x, a.y - b.y }; }
+inline vec2 operator*(const vec2 &a, float s) { return { a.x * s, a.y * s }; }
+inline vec2 operator*(float s, const vec2 &a) { return { a.x * s, a.y * s }; }
+
+struct vec3
+{
+    vec3() = default;
+    constexpr vec3(float x, float y, float z)
+        : x(x), y(y), z(z)
+    {}
+    constexpr explicit vec3(float s)
+        : x(s), y(s), z(s)
+    {}
+    vec3(const QVector3D &v)
+        : x(v.x()), y(v.y()), z(v.z())
+    {}
+
+    float operator[](int index) const
+    {
+        Q_ASSERT(index >= 0 && index < 3);
+        return (&x)[index];
+    }
+    float &operator[](int index)
+    {
+        Q_ASSERT(index >= 0 && index < 3);
+        return (&x)[index];
+    }
+
+    vec3 &operator+=(const vec3 &v) { x += v.x; y += v.y; z += v.z; return *this; }
+    vec3 &operator-=(const vec3 &v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+    vec3 &operator*=(const vec3 &v) { x *= v.x; y *= v.y; z *= v.z; return *this; }
+    vec3 &operator*=(float s) { x *= s; y *= s; z *= s; return *this; }
+    vec3 &operator/=(float s) { return *this *= (1.0f / s); }
+
+    float x, y, z;
+};
+
+inline vec3 operator-(const vec3 &a) { return { -a.x, -a.y, -a.z }; }
+inline vec3 operator+(const vec3 &a, const vec3 &b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+inline vec3 operator-(const vec3 &a, const vec3 &b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline vec3 operator*(const vec3 &a, const vec3 &b) { return { a.x * b.x, a.y * b.y, a.z * b.z }; }
+inline vec3 operator/(const vec3 &a, const vec3 &b) { return { a.x / b.x, a.y / b.y, a.z / b.z }; }
+inline vec3 operator*(const vec3 &a, float s) { return { a.x * s, a.y * s, a.z * s }; }
+inline vec3 operator*(float s, const vec3 &a) { return { a.x * s, a.y * s, a.z * s }; }
+inline vec3 operator/(const vec3 &a, float s) { return a * (1.0f / s); }
+
+inline float dot(const vec3 &a, const vec3 &b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline vec3 cross(const vec3 &a, const vec3 &b)
+{
+    return {
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x
+    };
+}
+
+inline float length(const vec3 &v)
+{
+    return std::sqrt(dot(v, v));
+}
+
+inline vec3 normalize(const vec3 &v)
+{
+    const float len = length(v);
+    return (len > 0.0f) ? v / len : v;
+}
+
+inline vec3 min(const vec3 &a, const vec3 &b)
+{
+    return { std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z) };
+}
+
+inline vec3 max(const vec3 &a, const vec3 &b)
+{
+    return { std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z) };
+}
+
+inline float mincomp(const vec3 &v)
+{
+    return std::min(std::min(v.x, v.y), v.z);
+}
+
+inline float maxcomp(const vec3 &v)
+{
+    return std::max(std::max(v.x, v.y), v.z);
+}
+
+inline float mix(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
+inline vec3 mix(const vec3 &a, const vec3 &b, float t)
+{
+    return a + (b - a) * t;
+}
+
+inline vec3 reflect(const vec3 &i, const vec3 &n)
+{
+    return i - 2.0f * dot(n, i) * n;
+}
+
+inline bool isblack(const vec3 &v)
+{
+    return dot(v, v) < Epsilon;
+}
+
+inline bool isfinite(const vec3 &v)
+{
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+inline float luminance(const vec3 &color)
+{
+    return dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+inline float pow2(float x)
+{
+    return x * x;
+}
+
+inline float pow5(float x)
+{
+    return (x * x) * (x * x) * x;
+}
+
+// Row-major 3x4 affine transform.
+struct Affine3
+{
+    Affine3()
+        : Affine3(QMatrix4x4())
+    {}
+    explicit Affine3(const QMatrix4x4 &m)
+    {
+        for(int row=0; row < 3; ++row) {
+            for(int col=0; col < 4; ++col) {
+                data[row][col] = m(row, col);
+            }
+        }
+    }
+
+    vec3 mapPoint(const vec3 &p) const
+    {
+        return {
+            data[0][0] * p.x + data[0][1] * p.y + data[0][2] * p.z + data[0][3],
+            data[1][0] * p.x + data[1][1] * p.y + data[1][2] * p.z + data[1][3],
+            data[2][0] * p.x + data[2][1] * p.y + data[2][2] * p.z + data[2][3],
+        };
+    }
+    vec3 mapVector(const vec3 &v) const
+    {
+        return {
+            data[0][0] * v.x + data[0][1] * v.y + data[0][2] * v.z,
+            data[1][0] * v.x + data[1][1] * v.y + data[1][2] * v.z,
+            data[2][0] * v.x + data[2][1] * v.y + data[2][2] * v.z,
+        };
+    }
+
+    float data[3][4];
+};
+
+// Row-major 3x3 linear transform.
+struct Basis3
+{
+    Basis3()
+        : Basis3(QMatrix3x3())
+    {}
+    explicit Basis3(const QMatrix3x3 &m)
+    {
+        for(int row=0; row < 3; ++row) {
+            for(int col=0; col < 3; ++col) {
+                data[row][col] = m(row, col);
+            }
+        }
+    }
+
+    vec3 map(const vec3 &v) const
+    {
+        return {
+            data[0][0] * v.x + data[0][1] * v.y + data[0][2] * v.z,
+            data[1][0] * v.x + data[1][1] * v.y + data[1][2] * v.z,
+            data[2][0] * v.x + data[2][1] * v.y + data[2][2] * v.z,
+        };
+    }
+
+    float data[3][3];
+};
+
+struct Ray
+{
+    vec3 origin;
+    vec3 direction;
+    float tmin;
+    float tmax;
+};
+
+struct Aabb
+{
+    static Aabb empty()
+    {
+        constexpr float inf = std::numeric_limits<float>::infinity();
+        return { vec3(inf), vec3(-inf) };
+    }
+
+    void grow(const vec3 &p)
+    {
+        bmin = min(bmin, p);
+        bmax = max(bmax, p);
+    }
+    void grow(const Aabb &other)
+    {
+        bmin = min(bmin, other.bmin);
+        bmax = max(bmax, other.bmax);
+    }
+
+    bool isEmpty() const
+    {
+        return bmin.x > bmax.x || bmin.y > bmax.y || bmin.z > bmax.z;
+    }
+    vec3 extent() const
+    {
+        return bmax - bmin;
+    }
+    vec3 centroid() const
+    {
+        return 0.5f * (bmin + bmax);
+    }
+    float surfaceArea() const
+    {
+        if(isEmpty()) {
+            return 0.0f;
+        }
+        const vec3 e = extent();
+        return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    }
+
+    Aabb transformed(const Affine3 &transform) const
+    {
+        Aabb result = empty();
+        for(int corner=0; corner < 8; ++corner) {
+            const vec3 p = {
+                (corner & 1) ? bmax.x : bmin.x,
+                (corner & 2) ? bmax.y : bmin.y,
+                (corner & 4) ? bmax.z : bmin.z,
+            };
+            result.grow(transform.mapPoint(p));
+        }
+        return result;
+    }
+
+    vec3 bmin;
+    vec3 bmax;
+};
+
+} // Cpu
+} // Qt3DRaytrace
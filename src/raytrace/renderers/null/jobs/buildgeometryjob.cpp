@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/buildgeometryjob.h>
+#include <renderers/null/renderer.h>
+
+#include <backend/managers_p.h>
+#include <backend/geometry_p.h>
+
+#include <cstring>
+#include <limits>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+BuildGeometryJob::BuildGeometryJob(Renderer *renderer, const Raytrace::HGeometry &handle)
+    : m_renderer(renderer)
+    , m_handle(handle)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void BuildGeometryJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("BuildGeometry"));
+
+    Raytrace::Geometry *geometryNode = m_handle.data();
+    if(!geometryNode) {
+        return;
+    }
+
+    const quint64 numVertices = geometryNode->numVertices();
+    const quint64 numFaces = geometryNode->numFaces();
+    if(numVertices == 0 || numFaces == 0) {
+        return;
+    }
+    if(numVertices > quint64(std::numeric_limits<int>::max()) || numFaces > quint64(std::numeric_limits<int>::max() / 3)) {
+        return;
+    }
+
+    const QVertex *vertices = geometryNode->vertexData();
+    const QTriangle *faces = geometryNode->faceData();
+
+    // Pack vertex attributes and indices the same way the Vulkan renderer fills its staging buffers.
+    Geometry geometry;
+    geometry.attributes.resize(int(numVertices));
+    for(int i=0; i < int(numVertices); ++i) {
+        const QVertex &vertex = vertices[i];
+        Attributes &attributes = geometry.attributes[i];
+        for(int j=0; j<3; ++j) {
+            attributes.position[j] = vertex.position[j];
+            attributes.normal[j]   = vertex.normal[j];
+            attributes.tangent[j]  = vertex.tangent[j];
+        }
+        for(int j=0; j<2; ++j) {
+            attributes.texcoord[j] = vertex.texcoord[j];
+        }
+    }
+    geometry.indices.resize(int(numFaces) * 3);
+    std::memcpy(geometry.indices.data(), faces, sizeof(uint32_t) * size_t(geometry.indices.size()));
+
+    m_renderer->sceneManager()->addOrUpdateGeometry(geometryNode->peerId(), geometry);
+}
+
+} // Null
+} // Qt3DRaytrace
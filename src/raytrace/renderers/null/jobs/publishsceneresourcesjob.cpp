@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/publishsceneresourcesjob.h>
+#include <renderers/null/renderer.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+PublishSceneResourcesJob::PublishSceneResourcesJob(Renderer *renderer, ResourceType resourceType)
+    : m_renderer(renderer)
+    , m_resourceType(resourceType)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void PublishSceneResourcesJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("PublishSceneResources"));
+
+    switch(m_resourceType) {
+    case ResourceType::Geometry:
+        m_renderer->sceneManager()->publishGeometry();
+        break;
+    case ResourceType::Textures:
+        m_renderer->sceneManager()->publishTextures();
+        break;
+    }
+}
+
+} // Null
+} // Qt3DRaytrace
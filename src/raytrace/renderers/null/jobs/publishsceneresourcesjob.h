@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/null/nullcommon.h>
+#include <Qt3DCore/QAspectJob>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+class Renderer;
+
+// Publishes scene resources added by all upload jobs of a frame as a single snapshot.
+class PublishSceneResourcesJob final : public Qt3DCore::QAspectJob
+{
+public:
+    enum class ResourceType {
+        Geometry,
+        Textures,
+    };
+
+    PublishSceneResourcesJob(Renderer *renderer, ResourceType resourceType);
+
+    void run() override;
+
+private:
+    Renderer *m_renderer;
+    ResourceType m_resourceType;
+};
+
+using PublishSceneResourcesJobPtr = QSharedPointer<PublishSceneResourcesJob>;
+
+} // Null
+} // Qt3DRaytrace
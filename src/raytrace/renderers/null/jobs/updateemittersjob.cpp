@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/updateemittersjob.h>
+#include <renderers/null/renderer.h>
+
+#include <backend/managers_p.h>
+#include <backend/rendersettings_p.h>
+
+#include <QVector>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+UpdateEmittersJob::UpdateEmittersJob(Renderer *renderer)
+    : m_renderer(renderer)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void UpdateEmittersJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("UpdateEmitters"));
+
+    auto *textureManager = &m_renderer->nodeManagers()->textureManager;
+    auto *sceneManager = m_renderer->sceneManager();
+
+    auto lookupTextureImageIndex = [textureManager, sceneManager](QNodeId textureId) -> uint32_t {
+        if(const auto *texture = textureManager->lookupResource(textureId)) {
+            return sceneManager->lookupTextureIndex(texture->imageId());
+        }
+        return ~0u;
+    };
+
+    QVector<Emitter> emitters;
+    {
+        Emitter skyEmitter = {};
+        skyEmitter.instanceIndex = ~0u;
+        if(const Raytrace::RenderSettings *settings = m_renderer->settings()) {
+            settings->skyRadiance().writeToBuffer(skyEmitter.radiance.data);
+            skyEmitter.intensity = settings->skyIntensity();
+            skyEmitter.textureIndex = lookupTextureImageIndex(settings->skyTextureId());
+            skyEmitter.direction = QVector3D(settings->skyTextureOffset(), 0.0f);
+        }
+        emitters.append(skyEmitter);
+    }
+
+    for(const auto &emissive : sceneManager->emissives()) {
+        const Raytrace::Entity *entity = emissive.data();
+        if(!entity) {
+            continue;
+        }
+        const QMatrix4x4 entityTransform = entity->worldTransformMatrix().toQMatrix4x4();
+        if(!entity->distantLightComponentId().isNull()) {
+            const Raytrace::DistantLight *light = entity->distantLightComponent();
+            Q_ASSERT(light);
+
+            const QVector3D worldDirection = entityTransform.mapVector(light->direction()).normalized();
+
+            Emitter emitter = {};
+            emitter.instanceIndex = ~0u;
+            emitter.direction = worldDirection;
+            light->radiance().writeToBuffer(emitter.radiance.data);
+            emitters.append(emitter);
+        }
+        if(entity->isRenderable()) {
+            const Raytrace::Material *material = entity->materialComponent();
+            const Raytrace::GeometryRenderer *geometryRenderer = entity->geometryRendererComponent();
+            Q_ASSERT(material && geometryRenderer);
+
+            Emitter emitter = {};
+            emitter.instanceIndex = sceneManager->lookupRenderableIndex(entity->peerId());
+            emitter.geometryIndex = sceneManager->lookupGeometryIndex(geometryRenderer->geometryId());
+            material->emission().writeToBuffer(emitter.radiance.data);
+            emitters.append(emitter);
+        }
+    }
+
+    sceneManager->updateEmitters(emitters);
+}
+
+} // Null
+} // Qt3DRaytrace
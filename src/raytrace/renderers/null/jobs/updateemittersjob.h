@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/null/nullcommon.h>
+#include <Qt3DCore/QAspectJob>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+class Renderer;
+
+class UpdateEmittersJob final : public Qt3DCore::QAspectJob
+{
+public:
+    explicit UpdateEmittersJob(Renderer *renderer);
+
+    void run() override;
+
+private:
+    Renderer *m_renderer;
+};
+
+using UpdateEmittersJobPtr = QSharedPointer<UpdateEmittersJob>;
+
+} // Null
+} // Qt3DRaytrace
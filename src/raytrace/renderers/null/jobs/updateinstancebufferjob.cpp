@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/updateinstancebufferjob.h>
+#include <renderers/null/renderer.h>
+
+#include <backend/managers_p.h>
+#include <utility/parallelfor.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+namespace Config {
+
+constexpr int GatherGrainSize = 1024;
+
+} // Config
+
+UpdateInstanceBufferJob::UpdateInstanceBufferJob(Renderer *renderer)
+    : m_renderer(renderer)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void UpdateInstanceBufferJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("UpdateInstanceBuffer"));
+
+    auto *sceneManager = m_renderer->sceneManager();
+
+    const auto &renderables = sceneManager->renderables();
+    const uint32_t instanceCount = uint32_t(renderables.size());
+
+    Vulkan::InstancePacker &instancePacker = sceneManager->instancePacker();
+    instancePacker.resize(instanceCount);
+    Utility::parallelFor(0, int(instanceCount), Config::GatherGrainSize, [&](int begin, int end) {
+        for(int instanceIndex=begin; instanceIndex < end; ++instanceIndex) {
+            const Raytrace::Entity *renderable = renderables[instanceIndex].data();
+            if(!renderable) {
+                instancePacker.clearInstance(uint32_t(instanceIndex));
+                continue;
+            }
+            const Raytrace::GeometryRenderer *geometryRenderer = renderable->geometryRendererComponent();
+            Q_ASSERT(geometryRenderer);
+
+            const uint32_t materialIndex = sceneManager->lookupMaterialIndex(renderable->materialComponentId());
+
+            Geometry renderableGeometry;
+            const uint32_t geometryIndex = sceneManager->lookupGeometry(geometryRenderer->geometryId(), renderableGeometry);
+
+            const QMatrix4x4 entityTransform = renderable->worldTransformMatrix().toQMatrix4x4();
+            instancePacker.setInstance(uint32_t(instanceIndex), materialIndex, geometryIndex, uint32_t(renderableGeometry.indices.size() / 3), entityTransform.constData());
+        }
+    });
+
+    const QVector<Vulkan::InstancePacker::Range> dirtyRanges = instancePacker.pack();
+    sceneManager->updateInstances(instancePacker, dirtyRanges);
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/updatematerialsjob.h>
+#include <renderers/null/renderer.h>
+
+#include <backend/managers_p.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+UpdateMaterialsJob::UpdateMaterialsJob(Renderer *renderer)
+    : m_renderer(renderer)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void UpdateMaterialsJob::setDirtyMaterialHandles(QVector<Raytrace::HMaterial> &materialHandles)
+{
+    m_dirtyMaterialHandles = std::move(materialHandles);
+}
+
+void UpdateMaterialsJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("UpdateMaterials"));
+
+    auto *textureManager = &m_renderer->nodeManagers()->textureManager;
+    auto *sceneManager = m_renderer->sceneManager();
+
+    auto lookupTextureImageIndex = [textureManager, sceneManager](QNodeId textureId) -> uint32_t {
+        if(const auto *texture = textureManager->lookupResource(textureId)) {
+            return sceneManager->lookupTextureIndex(texture->imageId());
+        }
+        return ~0u;
+    };
+
+    QVector<QNodeId> materialNodeIds;
+    QVector<Material> materialUpdates;
+    materialNodeIds.reserve(m_dirtyMaterialHandles.size());
+    materialUpdates.reserve(m_dirtyMaterialHandles.size());
+
+    for(const auto &handle : m_dirtyMaterialHandles) {
+        Raytrace::Material *material = handle.data();
+
+        Material materialData;
+        material->albedo().writeToBuffer(materialData.albedo.data);
+        material->emission().writeToBuffer(materialData.emission.data);
+        // Pack roughness in albedo.a
+        materialData.albedo.data[3] = material->roughness();
+        // Pack metalness in emission.a
+        materialData.emission.data[3] = material->metalness();
+
+        materialData.albedoTexture = lookupTextureImageIndex(material->albedoTextureId());
+        materialData.roughnessTexture = lookupTextureImageIndex(material->roughnessTextureId());
+        materialData.metalnessTexture = lookupTextureImageIndex(material->metalnessTextureId());
+
+        materialNodeIds.append(material->peerId());
+        materialUpdates.append(materialData);
+    }
+    m_dirtyMaterialHandles.clear();
+
+    sceneManager->addOrUpdateMaterials(materialNodeIds, materialUpdates);
+}
+
+} // Null
+} // Qt3DRaytrace
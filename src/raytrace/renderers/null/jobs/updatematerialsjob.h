@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/null/nullcommon.h>
+#include <backend/handles_p.h>
+#include <Qt3DCore/QAspectJob>
+
+#include <QVector>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+class Renderer;
+
+class UpdateMaterialsJob final : public Qt3DCore::QAspectJob
+{
+public:
+    explicit UpdateMaterialsJob(Renderer *renderer);
+
+    void setDirtyMaterialHandles(QVector<Raytrace::HMaterial> &materialHandles);
+
+    void run() override;
+
+private:
+    Renderer *m_renderer;
+    QVector<Raytrace::HMaterial> m_dirtyMaterialHandles;
+};
+
+using UpdateMaterialsJobPtr = QSharedPointer<UpdateMaterialsJob>;
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/updaterenderparametersjob.h>
+#include <renderers/null/renderer.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+UpdateRenderParametersJob::UpdateRenderParametersJob(Renderer *renderer)
+    : m_renderer(renderer)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void UpdateRenderParametersJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("UpdateRenderParameters"));
+
+    auto *cameraManager = m_renderer->cameraManager();
+    if(cameraManager) {
+        cameraManager->updateParameters();
+    }
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/updateworldtransformjob.h>
+#include <renderers/null/renderer.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+UpdateWorldTransformJob::UpdateWorldTransformJob(Renderer *renderer)
+    : m_renderer(renderer)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void UpdateWorldTransformJob::setRoot(Raytrace::Entity *root)
+{
+    m_job.setRoot(root);
+}
+
+void UpdateWorldTransformJob::setManagers(Raytrace::NodeManagers *managers)
+{
+    m_job.setManagers(managers);
+}
+
+void UpdateWorldTransformJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("UpdateWorldTransform"));
+    m_job.run();
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/null/nullcommon.h>
+#include <jobs/updateworldtransformjob_p.h>
+#include <Qt3DCore/QAspectJob>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+class Renderer;
+
+class UpdateWorldTransformJob final : public Qt3DCore::QAspectJob
+{
+public:
+    explicit UpdateWorldTransformJob(Renderer *renderer);
+
+    void setRoot(Raytrace::Entity *root);
+    void setManagers(Raytrace::NodeManagers *managers);
+
+    void run() override;
+
+private:
+    Renderer *m_renderer;
+    Raytrace::UpdateWorldTransformJob m_job;
+};
+
+using UpdateWorldTransformJobPtr = QSharedPointer<UpdateWorldTransformJob>;
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/jobs/uploadtexturejob.h>
+#include <renderers/null/renderer.h>
+
+#include <backend/managers_p.h>
+#include <backend/textureimage_p.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+UploadTextureJob::UploadTextureJob(Renderer *renderer, const Raytrace::HTextureImage &handle)
+    : m_renderer(renderer)
+    , m_handle(handle)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void UploadTextureJob::run()
+{
+    ScopedJobTimer timer(m_renderer->jobStatisticsManager(), QStringLiteral("UploadTexture"));
+
+    Raytrace::TextureImage *textureImageNode = m_handle.data();
+    if(!textureImageNode) {
+        return;
+    }
+
+    const QImageData &imageData = textureImageNode->data();
+    if(imageData.width <= 0 || imageData.height <= 0 || imageData.isEmpty()) {
+        return;
+    }
+
+    // No device to upload to: only register the texture so that materials can resolve its index.
+    m_renderer->sceneManager()->addOrUpdateTexture(textureImageNode->peerId(), { imageData.width, imageData.height });
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/managers/jobstatisticsmanager.h>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+void JobStatisticsManager::addSample(const QString &jobName, double time)
+{
+    QMutexLocker lock(&m_mutex);
+
+    JobRecord &record = m_records[jobName];
+    record.averageTime.add(time);
+    record.lastTime = time;
+    ++record.numRuns;
+}
+
+QVector<QRenderJobStatistics> JobStatisticsManager::statistics() const
+{
+    QMutexLocker lock(&m_mutex);
+
+    QVector<QRenderJobStatistics> result;
+    result.reserve(m_records.size());
+    for(auto it = m_records.begin(); it != m_records.end(); ++it) {
+        const JobRecord &record = it.value();
+        result.append({ it.key(), record.averageTime.average(), record.lastTime, record.numRuns });
+    }
+    return result;
+}
+
+void JobStatisticsManager::reset()
+{
+    QMutexLocker lock(&m_mutex);
+    m_records.clear();
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/null/nullcommon.h>
+#include <utility/movingaverage.h>
+
+#include <Qt3DRaytrace/qrenderimage.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMap>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+class JobStatisticsManager
+{
+public:
+    void addSample(const QString &jobName, double time);
+    QVector<QRenderJobStatistics> statistics() const;
+    void reset();
+
+private:
+    struct JobRecord {
+        Utility::MovingAverage<double> averageTime;
+        double lastTime = 0.0;
+        unsigned int numRuns = 0;
+    };
+    QMap<QString, JobRecord> m_records;
+    mutable QMutex m_mutex;
+};
+
+// Measures the lifetime of the enclosing scope and reports it as a job sample (in milliseconds).
+class ScopedJobTimer
+{
+public:
+    ScopedJobTimer(JobStatisticsManager *manager, const QString &jobName)
+        : m_manager(manager)
+        , m_jobName(jobName)
+    {
+        Q_ASSERT(m_manager);
+        m_timer.start();
+    }
+    ~ScopedJobTimer()
+    {
+        m_manager->addSample(m_jobName, m_timer.nsecsElapsed() * 1e-6);
+    }
+
+private:
+    JobStatisticsManager *m_manager;
+    QString m_jobName;
+    QElapsedTimer m_timer;
+};
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/managers/scenemanager.h>
+
+#include <backend/managers_p.h>
+
+#include <algorithm>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+void SceneManager::addOrUpdateGeometry(Qt3DCore::QNodeId geometryNodeId, const Geometry &geometry)
+{
+    Vulkan::SceneSnapshotTable<Geometry>::Writer writer(m_geometry, Vulkan::SceneSnapshotTable<Geometry>::Writer::PublishDeferred);
+    writer.addOrUpdateResource(geometryNodeId, geometry);
+}
+
+void SceneManager::addOrUpdateMaterial(Qt3DCore::QNodeId materialNodeId, const Material &material)
+{
+    Vulkan::SceneSnapshotTable<Material>::Writer writer(m_materials);
+    writer.addOrUpdateResource(materialNodeId, material);
+}
+
+void SceneManager::addOrUpdateMaterials(const QVector<Qt3DCore::QNodeId> &materialNodeIds, const QVector<Material> &materials)
+{
+    Q_ASSERT(materialNodeIds.size() == materials.size());
+
+    Vulkan::SceneSnapshotTable<Material>::Writer writer(m_materials);
+    for(int i=0; i < materialNodeIds.size(); ++i) {
+        writer.addOrUpdateResource(materialNodeIds[i], materials[i]);
+    }
+}
+
+void SceneManager::addOrUpdateTexture(Qt3DCore::QNodeId textureImageNodeId, const TextureImage &textureImage)
+{
+    Vulkan::SceneSnapshotTable<TextureImage>::Writer writer(m_textures, Vulkan::SceneSnapshotTable<TextureImage>::Writer::PublishDeferred);
+    writer.addOrUpdateResource(textureImageNodeId, textureImage);
+}
+
+void SceneManager::removeGeometry(Qt3DCore::QNodeId geometryNodeId)
+{
+    // Host-side resources are never referenced by frames in flight so slots are released immediately.
+    Vulkan::SceneSnapshotTable<Geometry>::Writer writer(m_geometry);
+    writer.removeResource(geometryNodeId);
+}
+
+void SceneManager::removeMaterial(Qt3DCore::QNodeId materialNodeId)
+{
+    Vulkan::SceneSnapshotTable<Material>::Writer writer(m_materials);
+    writer.removeResource(materialNodeId);
+}
+
+void SceneManager::removeTexture(Qt3DCore::QNodeId textureImageNodeId)
+{
+    Vulkan::SceneSnapshotTable<TextureImage>::Writer writer(m_textures);
+    writer.removeResource(textureImageNodeId);
+}
+
+void SceneManager::publishGeometry()
+{
+    m_geometry.publishPending();
+}
+
+void SceneManager::publishTextures()
+{
+    m_textures.publishPending();
+}
+
+void SceneManager::updateEmitters(QVector<Emitter> &emitters)
+{
+    QWriteLocker lock(&m_rwlock);
+    m_emitters = std::move(emitters);
+}
+
+void SceneManager::updateInstances(const Vulkan::InstancePacker &instancePacker, const QVector<Vulkan::InstancePacker::Range> &dirtyRanges)
+{
+    // Mirrors partial instance buffer uploads performed by the Vulkan renderer.
+    QWriteLocker lock(&m_rwlock);
+    m_instances.resize(int(instancePacker.instanceCount()));
+    for(const Vulkan::InstancePacker::Range &range : dirtyRanges) {
+        std::copy_n(instancePacker.instances() + range.first, range.count, m_instances.begin() + int(range.first));
+    }
+}
+
+uint32_t SceneManager::lookupGeometry(Qt3DCore::QNodeId geometryNodeId, Geometry &geometry) const
+{
+    // NO LOCK: Wait-free snapshot read.
+    return m_geometry.lookupResource(geometryNodeId, geometry);
+}
+
+uint32_t SceneManager::lookupGeometryIndex(Qt3DCore::QNodeId geometryNodeId) const
+{
+    // NO LOCK: Wait-free snapshot read.
+    return m_geometry.lookupIndex(geometryNodeId);
+}
+
+uint32_t SceneManager::lookupMaterialIndex(Qt3DCore::QNodeId materialNodeId) const
+{
+    // NO LOCK: Wait-free snapshot read.
+    return m_materials.lookupIndex(materialNodeId);
+}
+
+uint32_t SceneManager::lookupTextureIndex(Qt3DCore::QNodeId textureImageNodeId) const
+{
+    // NO LOCK: Wait-free snapshot read.
+    return m_textures.lookupIndex(textureImageNodeId);
+}
+
+Vulkan::SceneEntitySet::Changes SceneManager::updateEntities(Raytrace::EntityManager *entityManager, const QVector<Qt3DCore::QNodeId> &dirtyNodeIds)
+{
+    // NO LOCK: Access from aspect thread only, while no jobs are running.
+    return m_entities.update(entityManager, dirtyNodeIds);
+}
+
+const Vulkan::SceneEntitySet &SceneManager::entities() const
+{
+    // NO LOCK: Access from aspect thread only.
+    return m_entities;
+}
+
+uint32_t SceneManager::lookupRenderableIndex(Qt3DCore::QNodeId entityNodeId) const
+{
+    // NO LOCK: Entity sets are only modified by the aspect thread while no jobs are running.
+    return m_entities.lookupRenderableIndex(entityNodeId);
+}
+
+const QVector<Raytrace::HEntity> &SceneManager::renderables() const
+{
+    // NO LOCK: Access from render/aspect thread only.
+    return m_entities.renderables();
+}
+
+const QVector<Raytrace::HEntity> &SceneManager::emissives() const
+{
+    // NO LOCK: Access from render/aspect thread only.
+    return m_entities.emissives();
+}
+
+uint32_t SceneManager::numRenderables() const
+{
+    // NO LOCK: Access from render/aspect thread only.
+    return m_entities.numRenderables();
+}
+
+QVector<Material> SceneManager::materials() const
+{
+    // NO LOCK: Snapshot contents are immutable.
+    return m_materials.resources();
+}
+
+QVector<Emitter> SceneManager::emitters() const
+{
+    QReadLocker lock(&m_rwlock);
+    return m_emitters;
+}
+
+QVector<EntityInstance> SceneManager::instances() const
+{
+    QReadLocker lock(&m_rwlock);
+    return m_instances;
+}
+
+void SceneManager::reclaimRetiredSnapshots()
+{
+    // Must only be called between aspect frames when no job can hold a reference to a retired snapshot.
+    m_geometry.reclaimRetiredSnapshots();
+    m_materials.reclaimRetiredSnapshots();
+    m_textures.reclaimRetiredSnapshots();
+}
+
+Vulkan::InstancePacker &SceneManager::instancePacker()
+{
+    // NO LOCK: Access from UpdateInstanceBufferJob only.
+    return m_instancePacker;
+}
+
+void SceneManager::clear()
+{
+    QWriteLocker lock(&m_rwlock);
+    m_entities.clear();
+    m_geometry.clear();
+    m_materials.clear();
+    m_textures.clear();
+    m_emitters.clear();
+    m_instances.clear();
+    m_instancePacker.clear();
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/null/nullcommon.h>
+#include <renderers/vulkan/glsl.h>
+#include <renderers/vulkan/instancepacker.h>
+#include <renderers/vulkan/managers/scenesnapshottable.h>
+#include <renderers/vulkan/managers/sceneentityset.h>
+
+#include <backend/handles_p.h>
+
+#include <QReadWriteLock>
+
+namespace Qt3DRaytrace {
+
+namespace Raytrace {
+class EntityManager;
+} // Raytrace
+
+namespace Null {
+
+using Vulkan::Attributes;
+using Vulkan::Material;
+using Vulkan::Emitter;
+using Vulkan::EntityInstance;
+
+// Host-side equivalent of the Vulkan renderer's geometry buffers.
+struct Geometry
+{
+    QVector<Attributes> attributes;
+    QVector<uint32_t> indices;
+};
+
+struct TextureImage
+{
+    int width;
+    int height;
+};
+
+class SceneManager
+{
+public:
+    void addOrUpdateGeometry(Qt3DCore::QNodeId geometryNodeId, const Geometry &geometry);
+    void addOrUpdateMaterial(Qt3DCore::QNodeId materialNodeId, const Material &material);
+    void addOrUpdateMaterials(const QVector<Qt3DCore::QNodeId> &materialNodeIds, const QVector<Material> &materials);
+    void addOrUpdateTexture(Qt3DCore::QNodeId textureImageNodeId, const TextureImage &textureImage);
+    void removeGeometry(Qt3DCore::QNodeId geometryNodeId);
+    void removeMaterial(Qt3DCore::QNodeId materialNodeId);
+    void removeTexture(Qt3DCore::QNodeId textureImageNodeId);
+
+    // Geometry and textures are added by concurrent upload jobs and become visible to readers only once published.
+    void publishGeometry();
+    void publishTextures();
+
+    void updateEmitters(QVector<Emitter> &emitters);
+    void updateInstances(const Vulkan::InstancePacker &instancePacker, const QVector<Vulkan::InstancePacker::Range> &dirtyRanges);
+
+    uint32_t lookupGeometry(Qt3DCore::QNodeId geometryNodeId, Geometry &geometry) const;
+    uint32_t lookupGeometryIndex(Qt3DCore::QNodeId geometryNodeId) const;
+    uint32_t lookupMaterialIndex(Qt3DCore::QNodeId materialNodeId) const;
+    uint32_t lookupTextureIndex(Qt3DCore::QNodeId textureImageNodeId) const;
+
+    Vulkan::SceneEntitySet::Changes updateEntities(Raytrace::EntityManager *entityManager, const QVector<Qt3DCore::QNodeId> &dirtyNodeIds);
+    const Vulkan::SceneEntitySet &entities() const;
+
+    uint32_t lookupRenderableIndex(Qt3DCore::QNodeId entityNodeId) const;
+
+    const QVector<Raytrace::HEntity> &renderables() const;
+    const QVector<Raytrace::HEntity> &emissives() const;
+    uint32_t numRenderables() const;
+
+    QVector<Material> materials() const;
+    QVector<Emitter> emitters() const;
+    QVector<EntityInstance> instances() const;
+
+    Vulkan::InstancePacker &instancePacker();
+
+    void reclaimRetiredSnapshots();
+    void clear();
+
+private:
+    Vulkan::SceneEntitySet m_entities;
+
+    Vulkan::SceneSnapshotTable<Geometry> m_geometry;
+    Vulkan::SceneSnapshotTable<Material> m_materials;
+    Vulkan::SceneSnapshotTable<TextureImage> m_textures;
+    QVector<Emitter> m_emitters;
+    QVector<EntityInstance> m_instances;
+    Vulkan::InstancePacker m_instancePacker;
+
+    mutable QReadWriteLock m_rwlock;
+};
+
+} // Null
+} // Qt3DRaytrace
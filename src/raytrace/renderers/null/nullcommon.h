@@ -0,0 +1,19 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include <QLoggingCategory>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+Q_DECLARE_LOGGING_CATEGORY(logNull)
+
+} // Null
+} // Qt3DRaytrace
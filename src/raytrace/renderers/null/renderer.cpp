@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/renderer.h>
+
+#include <renderers/null/jobs/buildgeometryjob.h>
+#include <renderers/null/jobs/updatematerialsjob.h>
+#include <renderers/null/jobs/uploadtexturejob.h>
+#include <renderers/null/jobs/publishsceneresourcesjob.h>
+
+#include <backend/managers_p.h>
+#include <backend/rendersettings_p.h>
+
+#include <QWindow>
+#include <QTimer>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+Q_LOGGING_CATEGORY(logNull, "raytrace.null")
+
+Renderer::Renderer(QObject *parent)
+    : QObject(parent)
+    , m_renderFrameTimer(new QTimer(this))
+    , m_frameAdvanceService(new FrameAdvanceService)
+    , m_cameraManager(new CameraManager)
+    , m_jobStatisticsManager(new JobStatisticsManager)
+    , m_updateWorldTransformJob(new UpdateWorldTransformJob(this))
+    , m_updateRenderParametersJob(new UpdateRenderParametersJob(this))
+    , m_updateInstanceBufferJob(new UpdateInstanceBufferJob(this))
+    , m_updateEmittersJob(new UpdateEmittersJob(this))
+{
+    QObject::connect(m_renderFrameTimer, &QTimer::timeout, this, &Renderer::renderFrame);
+}
+
+bool Renderer::initialize()
+{
+    m_sceneManager.reset(new SceneManager);
+    m_jobStatisticsManager->reset();
+
+    m_renderFrameTimer->start();
+    m_frameRequested.store(1);
+    m_frameAdvanceService->proceedToNextFrame();
+    return true;
+}
+
+void Renderer::shutdown()
+{
+    m_renderFrameTimer->stop();
+    if(m_sceneManager) {
+        m_sceneManager->clear();
+    }
+    m_materialTextures.clear();
+}
+
+QVector<Qt3DCore::QAspectJobPtr> Renderer::createGeometryJobs()
+{
+    auto *geometryManager = &m_nodeManagers->geometryManager;
+    auto dirtyGeometry = geometryManager->acquireDirtyComponents();
+
+    QVector<Qt3DCore::QAspectJobPtr> buildGeometryJobs;
+    buildGeometryJobs.reserve(dirtyGeometry.size());
+    for(const Qt3DCore::QNodeId &geometryId : dirtyGeometry) {
+        Raytrace::HGeometry handle = geometryManager->lookupHandle(geometryId);
+        if(!handle.isNull()) {
+            auto job = BuildGeometryJobPtr::create(this, handle);
+            buildGeometryJobs.append(job);
+        }
+    }
+    if(!buildGeometryJobs.isEmpty()) {
+        // Dependents of geometry jobs also depend on this job and so observe all built geometry at once.
+        auto publishJob = PublishSceneResourcesJobPtr::create(this, PublishSceneResourcesJob::ResourceType::Geometry);
+        for(const auto &job : qAsConst(buildGeometryJobs)) {
+            publishJob->addDependency(job);
+        }
+        buildGeometryJobs.append(publishJob);
+    }
+    return buildGeometryJobs;
+}
+
+QVector<Qt3DCore::QAspectJobPtr> Renderer::createTextureJobs()
+{
+    auto *textureImageManager = &m_nodeManagers->textureImageManager;
+    auto dirtyTextureImages = textureImageManager->acquireDirtyComponents();
+
+    QVector<Qt3DCore::QAspectJobPtr> uploadTextureJobs;
+    uploadTextureJobs.reserve(dirtyTextureImages.size());
+    for(const Qt3DCore::QNodeId &textureImageId : dirtyTextureImages) {
+        Raytrace::HTextureImage handle = textureImageManager->lookupHandle(textureImageId);
+        if(!handle.isNull()) {
+            auto job = UploadTextureJobPtr::create(this, handle);
+            uploadTextureJobs.append(job);
+        }
+    }
+    if(!uploadTextureJobs.isEmpty()) {
+        auto publishJob = PublishSceneResourcesJobPtr::create(this, PublishSceneResourcesJob::ResourceType::Textures);
+        for(const auto &job : qAsConst(uploadTextureJobs)) {
+            publishJob->addDependency(job);
+        }
+        uploadTextureJobs.append(publishJob);
+    }
+    return uploadTextureJobs;
+}
+
+QVector<Qt3DCore::QAspectJobPtr> Renderer::createMaterialJobs(bool forceAllDirty)
+{
+    auto *materialManager = &m_nodeManagers->materialManager;
+
+    QVector<Raytrace::HMaterial> dirtyMaterialHandles;
+    if(forceAllDirty) {
+        dirtyMaterialHandles = materialManager->activeHandles();
+        materialManager->clearDirtyComponents();
+    }
+    else {
+        auto dirtyMaterials = materialManager->acquireDirtyComponents();
+        dirtyMaterialHandles.reserve(dirtyMaterials.size());
+        for(const Qt3DCore::QNodeId &materialId : dirtyMaterials) {
+            Raytrace::HMaterial handle = materialManager->lookupHandle(materialId);
+            if(!handle.isNull()) {
+                dirtyMaterialHandles.append(handle);
+            }
+        }
+    }
+
+    for(const Raytrace::HMaterial &handle : qAsConst(dirtyMaterialHandles)) {
+        m_materialTextures.updateMaterial(handle.data());
+    }
+
+    QVector<Qt3DCore::QAspectJobPtr> materialJobs;
+    if(dirtyMaterialHandles.size() > 0) {
+        auto job = UpdateMaterialsJobPtr::create(this);
+        job->setDirtyMaterialHandles(dirtyMaterialHandles);
+        materialJobs.append(job);
+    }
+    return materialJobs;
+}
+
+void Renderer::renderFrame()
+{
+    // Only advance once the aspect thread picked up the previous frame, so that the frame time
+    // reported in statistics reflects the cost of the job graph rather than the timer frequency.
+    if(m_frameRequested.testAndSetOrdered(0, 1)) {
+        m_frameAdvanceService->proceedToNextFrame();
+    }
+}
+
+void Renderer::resetRenderProgress()
+{
+    m_frameNumber = 0;
+
+    if(m_frameElapsedTimer.isValid()) {
+        m_frameElapsedTimer.restart();
+    }
+    else {
+        m_frameElapsedTimer.start();
+    }
+}
+
+void Renderer::updateActiveCamera()
+{
+    Q_ASSERT(m_cameraManager);
+    if(m_settings) {
+        Raytrace::Entity *cameraEntity = m_nodeManagers->entityManager.lookupResource(m_settings->cameraId());
+        if(cameraEntity && cameraEntity->isCamera()) {
+            m_cameraManager->setActiveCamera(cameraEntity);
+        }
+    }
+}
+
+QSurface *Renderer::surface() const
+{
+    QReadLocker lock(&m_windowSurfaceLock);
+    return m_window;
+}
+
+void Renderer::setSurface(QObject *surfaceObject)
+{
+    QWriteLocker lock(&m_windowSurfaceLock);
+    m_window = qobject_cast<QWindow*>(surfaceObject);
+}
+
+void Renderer::markDirty(DirtySet changes, Raytrace::BackendNode *node)
+{
+    m_sceneChanges.markDirty(changes, node);
+}
+
+Raytrace::Entity *Renderer::sceneRoot() const
+{
+    return m_sceneRoot;
+}
+
+void Renderer::setSceneRoot(Raytrace::Entity *rootEntity)
+{
+    m_sceneRoot = rootEntity;
+    m_updateWorldTransformJob->setRoot(m_sceneRoot);
+}
+
+Raytrace::RenderSettings *Renderer::settings() const
+{
+    return m_settings;
+}
+
+QRenderStatistics Renderer::statistics() const
+{
+    QReadLocker lock(&m_frameTimingsLock);
+
+    QRenderStatistics stats;
+    stats.cpuFrameTime = m_hostTimeAverage.average();
+    stats.gpuFrameTime = 0.0;
+    stats.totalRenderTime = m_frameElapsedTimer.elapsed() * 1e-3;
+    stats.numFramesRendered = m_frameNumber;
+    stats.jobStatistics = m_jobStatisticsManager->statistics();
+    return stats;
+}
+
+void Renderer::setSettings(Raytrace::RenderSettings *settings)
+{
+    m_settings = settings;
+    updateActiveCamera();
+}
+
+void Renderer::setNodeManagers(Raytrace::NodeManagers *nodeManagers)
+{
+    Q_ASSERT(nodeManagers);
+    m_nodeManagers = nodeManagers;
+    m_updateWorldTransformJob->setManagers(m_nodeManagers);
+}
+
+Qt3DCore::QAbstractFrameAdvanceService *Renderer::frameAdvanceService() const
+{
+    return m_frameAdvanceService.get();
+}
+
+Raytrace::NodeManagers *Renderer::nodeManagers() const
+{
+    return m_nodeManagers;
+}
+
+SceneManager *Renderer::sceneManager() const
+{
+    return m_sceneManager.get();
+}
+
+CameraManager *Renderer::cameraManager() const
+{
+    return m_cameraManager.get();
+}
+
+JobStatisticsManager *Renderer::jobStatisticsManager() const
+{
+    return m_jobStatisticsManager.get();
+}
+
+QVector<Qt3DCore::QAspectJobPtr> Renderer::jobsToExecute(qint64 time)
+{
+    Q_UNUSED(time);
+
+    QVector<Qt3DCore::QAspectJobPtr> jobs;
+
+    {
+        QWriteLocker lock(&m_frameTimingsLock);
+        if(m_frameTimer.isValid()) {
+            m_hostTimeAverage.add(m_frameTimer.nsecsElapsed() * 1e-6);
+        }
+        m_frameTimer.start();
+        ++m_frameNumber;
+    }
+    m_frameRequested.store(0);
+
+    // No jobs from the previous frame are running at this point.
+    m_sceneManager->reclaimRetiredSnapshots();
+
+    m_updateRenderParametersJob->removeDependency(m_updateWorldTransformJob);
+
+    m_updateInstanceBufferJob->removeDependency(m_updateWorldTransformJob);
+    m_updateInstanceBufferJob->removeDependency(Qt3DCore::QAspectJobPtr());
+
+    m_updateEmittersJob->removeDependency(m_updateWorldTransformJob);
+    m_updateEmittersJob->removeDependency(Qt3DCore::QAspectJobPtr());
+
+    if(m_sceneChanges.isEmpty()) {
+        return jobs;
+    }
+
+    Vulkan::SceneEntitySet::Changes entityChanges;
+    Vulkan::SceneUpdate update;
+    {
+        ScopedJobTimer timer(m_jobStatisticsManager.get(), QStringLiteral("UpdateEntities"));
+        const QVector<Qt3DCore::QNodeId> dirtyEntityNodes = m_sceneChanges.entityNodeIds();
+        if(!dirtyEntityNodes.isEmpty()) {
+            entityChanges = m_sceneManager->updateEntities(&m_nodeManagers->entityManager, dirtyEntityNodes);
+        }
+        const Qt3DCore::QNodeId activeCameraId = m_settings ? m_settings->cameraId() : Qt3DCore::QNodeId();
+        const Qt3DCore::QNodeId skyTextureId = m_settings ? m_settings->skyTextureId() : Qt3DCore::QNodeId();
+        update = m_sceneChanges.classify(m_nodeManagers, m_sceneManager->entities(), entityChanges, activeCameraId, skyTextureId);
+        m_sceneChanges.clear();
+
+        for(const Qt3DCore::QNodeId &geometryId : qAsConst(update.removedGeometry)) {
+            m_sceneManager->removeGeometry(geometryId);
+        }
+        for(const Qt3DCore::QNodeId &textureImageId : qAsConst(update.removedTextures)) {
+            m_sceneManager->removeTexture(textureImageId);
+        }
+        for(const Qt3DCore::QNodeId &materialId : qAsConst(update.removedMaterials)) {
+            m_sceneManager->removeMaterial(materialId);
+            m_materialTextures.removeMaterial(materialId);
+        }
+
+        if(!update.dirtyTextures.isEmpty()) {
+            const QVector<Qt3DCore::QNodeId> dependentMaterials = m_materialTextures.updateTextures(m_nodeManagers, update.dirtyTextures);
+            for(const Qt3DCore::QNodeId &materialId : dependentMaterials) {
+                m_nodeManagers->materialManager.markComponentDirty(materialId);
+                update.resetRenderProgress |= m_sceneManager->entities().isComponentReferencedByRenderable(materialId);
+            }
+            update.updateMaterials |= !dependentMaterials.isEmpty();
+        }
+    }
+
+    if(update.resetRenderProgress) {
+        resetRenderProgress();
+    }
+    if(update.updateActiveCamera) {
+        updateActiveCamera();
+    }
+
+    if(update.updateWorldTransforms) {
+        jobs.append(m_updateWorldTransformJob);
+        m_updateRenderParametersJob->addDependency(m_updateWorldTransformJob);
+        m_updateInstanceBufferJob->addDependency(m_updateWorldTransformJob);
+        m_updateEmittersJob->addDependency(m_updateWorldTransformJob);
+    }
+
+    QVector<Qt3DCore::QAspectJobPtr> geometryJobs;
+    if(update.updateGeometry) {
+        geometryJobs = createGeometryJobs();
+        jobs.append(geometryJobs);
+    }
+
+    QVector<Qt3DCore::QAspectJobPtr> textureJobs;
+    if(update.updateTextures) {
+        textureJobs = createTextureJobs();
+        jobs.append(textureJobs);
+    }
+
+    QVector<Qt3DCore::QAspectJobPtr> materialJobs;
+    if(update.updateMaterials) {
+        materialJobs = createMaterialJobs(update.updateAllMaterials);
+        jobs.append(materialJobs);
+        for(const auto &materialJob : materialJobs) {
+            for(const auto &textureJob : textureJobs) {
+                materialJob->addDependency(textureJob);
+            }
+        }
+    }
+
+    if(update.updateRenderParameters) {
+        jobs.append(m_updateRenderParametersJob);
+    }
+
+    if(m_sceneManager->numRenderables() == 0) {
+        return jobs;
+    }
+
+    if(update.updateInstanceBuffer) {
+        for(const auto &job : geometryJobs) {
+            m_updateInstanceBufferJob->addDependency(job);
+        }
+        for(const auto &job : materialJobs) {
+            m_updateInstanceBufferJob->addDependency(job);
+        }
+        jobs.append(m_updateInstanceBufferJob);
+    }
+    if(update.updateEmitters) {
+        for(const auto &job : geometryJobs) {
+            m_updateEmittersJob->addDependency(job);
+        }
+        for(const auto &job : materialJobs) {
+            m_updateEmittersJob->addDependency(job);
+        }
+        for(const auto &job : textureJobs) {
+            m_updateEmittersJob->addDependency(job);
+        }
+        jobs.append(m_updateEmittersJob);
+    }
+
+    return jobs;
+}
+
+QImageData Renderer::grabImage(QRenderImage type)
+{
+    Q_UNUSED(type);
+    qCWarning(logNull) << "Cannot grab image: null renderer does not produce images";
+    return QImageData{};
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <backend/abstractrenderer_p.h>
+
+#include <renderers/null/nullcommon.h>
+#include <renderers/null/services/frameadvanceservice.h>
+#include <renderers/null/managers/scenemanager.h>
+#include <renderers/null/managers/jobstatisticsmanager.h>
+#include <renderers/vulkan/managers/cameramanager.h>
+#include <renderers/vulkan/managers/scenechangetracker.h>
+#include <renderers/vulkan/managers/materialtextureindex.h>
+
+#include <renderers/null/jobs/updateworldtransformjob.h>
+#include <renderers/null/jobs/updaterenderparametersjob.h>
+#include <renderers/null/jobs/updateinstancebufferjob.h>
+#include <renderers/null/jobs/updateemittersjob.h>
+
+#include <utility/movingaverage.h>
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QReadWriteLock>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+
+class QWindow;
+class QTimer;
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+using Vulkan::CameraManager;
+
+// Headless renderer which runs the complete scene update job graph of the Vulkan renderer,
+// packing all GPU-bound data into host memory, without requiring a device or a surface.
+class Renderer final : public QObject
+                     , public Raytrace::AbstractRenderer
+{
+    Q_OBJECT
+public:
+    explicit Renderer(QObject *parent = nullptr);
+
+    QSurface *surface() const override;
+
+    bool initialize() override;
+    void shutdown() override;
+
+    void markDirty(DirtySet changes, Raytrace::BackendNode *node) override;
+
+    Raytrace::Entity *sceneRoot() const override;
+    Raytrace::RenderSettings *settings() const override;
+    QRenderStatistics statistics() const override;
+
+    void setSurface(QObject *surfaceObject) override;
+    void setSceneRoot(Raytrace::Entity *rootEntity) override;
+    void setSettings(Raytrace::RenderSettings *settings) override;
+    void setNodeManagers(Raytrace::NodeManagers *nodeManagers) override;
+
+    Qt3DCore::QAbstractFrameAdvanceService *frameAdvanceService() const override;
+    Raytrace::NodeManagers *nodeManagers() const;
+    SceneManager *sceneManager() const;
+    CameraManager *cameraManager() const;
+    JobStatisticsManager *jobStatisticsManager() const;
+
+    QVector<Qt3DCore::QAspectJobPtr> jobsToExecute(qint64 time) override;
+
+    QImageData grabImage(QRenderImage type) override;
+
+private slots:
+    void renderFrame();
+
+private:
+    QVector<Qt3DCore::QAspectJobPtr> createGeometryJobs();
+    QVector<Qt3DCore::QAspectJobPtr> createTextureJobs();
+    QVector<Qt3DCore::QAspectJobPtr> createMaterialJobs(bool forceAllDirty);
+
+    void resetRenderProgress();
+    void updateActiveCamera();
+
+    QWindow *m_window = nullptr;
+    mutable QReadWriteLock m_windowSurfaceLock;
+    mutable QReadWriteLock m_frameTimingsLock;
+
+    QTimer *m_renderFrameTimer = nullptr;
+
+    Raytrace::NodeManagers *m_nodeManagers = nullptr;
+    Raytrace::RenderSettings *m_settings = nullptr;
+
+    QSharedPointer<FrameAdvanceService> m_frameAdvanceService;
+    QSharedPointer<SceneManager> m_sceneManager;
+    QSharedPointer<CameraManager> m_cameraManager;
+    QSharedPointer<JobStatisticsManager> m_jobStatisticsManager;
+
+    uint32_t m_frameNumber = 0;
+    QAtomicInt m_frameRequested;
+    QElapsedTimer m_frameTimer;
+    QElapsedTimer m_frameElapsedTimer;
+
+    UpdateWorldTransformJobPtr m_updateWorldTransformJob;
+    UpdateRenderParametersJobPtr m_updateRenderParametersJob;
+    UpdateInstanceBufferJobPtr m_updateInstanceBufferJob;
+    UpdateEmittersJobPtr m_updateEmittersJob;
+
+    Raytrace::Entity *m_sceneRoot = nullptr;
+    Vulkan::SceneChangeTracker m_sceneChanges;
+    Vulkan::MaterialTextureIndex m_materialTextures;
+
+    Utility::MovingAverage<double> m_hostTimeAverage;
+};
+
+} // Null
+} // Qt3DRaytrace
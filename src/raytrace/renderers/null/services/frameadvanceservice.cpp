@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/null/services/frameadvanceservice.h>
+
+namespace Qt3DRaytrace {
+namespace Null {
+
+FrameAdvanceService::FrameAdvanceService()
+    : Qt3DCore::QAbstractFrameAdvanceService(QStringLiteral("Null Frame Advance Service"))
+{}
+
+qint64 FrameAdvanceService::waitForNextFrame()
+{
+    m_semaphore.acquire();
+    return m_elapsedTimer.nsecsElapsed();
+}
+
+void FrameAdvanceService::start()
+{
+    m_elapsedTimer.start();
+}
+
+void FrameAdvanceService::stop()
+{
+    proceedToNextFrame();
+}
+
+void FrameAdvanceService::proceedToNextFrame()
+{
+    m_semaphore.release();
+}
+
+} // Null
+} // Qt3DRaytrace
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/rendererfactory.h>
+
+#include <renderers/vulkan/renderer.h>
+#include <renderers/cpu/renderer.h>
+#include <renderers/null/renderer.h>
+
+#include <QMutex>
+#include <QMap>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+namespace Config {
+
+static const char *DefaultRendererName = "vulkan";
+static const char *RendererEnvironmentVariable = "QUARTZ_RENDERER";
+
+} // Config
+
+template<typename RendererType>
+static AbstractRenderer *createRendererInstance()
+{
+    return new RendererType;
+}
+
+struct RendererRegistry
+{
+    RendererRegistry()
+    {
+        renderers.insert(QStringLiteral("vulkan"), &createRendererInstance<Vulkan::Renderer>);
+        renderers.insert(QStringLiteral("cpu"), &createRendererInstance<Cpu::Renderer>);
+        renderers.insert(QStringLiteral("null"), &createRendererInstance<Null::Renderer>);
+    }
+
+    QMutex mutex;
+    QMap<QString, RendererFactory::CreateFunction> renderers;
+};
+
+Q_GLOBAL_STATIC(RendererRegistry, rendererRegistry)
+
+void RendererFactory::registerRenderer(const QString &name, CreateFunction createFunction)
+{
+    Q_ASSERT(createFunction);
+
+    RendererRegistry *registry = rendererRegistry();
+    QMutexLocker lock(&registry->mutex);
+    registry->renderers.insert(name.toLower(), createFunction);
+}
+
+QStringList RendererFactory::availableRenderers()
+{
+    RendererRegistry *registry = rendererRegistry();
+    QMutexLocker lock(&registry->mutex);
+    return registry->renderers.keys();
+}
+
+QString RendererFactory::defaultRenderer()
+{
+    const QString name = QString::fromLocal8Bit(qgetenv(Config::RendererEnvironmentVariable)).trimmed().toLower();
+    if(!name.isEmpty()) {
+        return name;
+    }
+    return QString::fromLatin1(Config::DefaultRendererName);
+}
+
+AbstractRenderer *RendererFactory::createRenderer(const QString &name)
+{
+    CreateFunction createFunction = nullptr;
+    {
+        RendererRegistry *registry = rendererRegistry();
+        QMutexLocker lock(&registry->mutex);
+        createFunction = registry->renderers.value(name.toLower(), nullptr);
+    }
+    return createFunction ? createFunction() : nullptr;
+}
+
+} // Raytrace
+} // Qt3DRaytrace
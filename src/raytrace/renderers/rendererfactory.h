@@ -0,0 +1,31 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+namespace Qt3DRaytrace {
+namespace Raytrace {
+
+class AbstractRenderer;
+
+class RendererFactory
+{
+public:
+    using CreateFunction = AbstractRenderer *(*)();
+
+    static void registerRenderer(const QString &name, CreateFunction createFunction);
+    static QStringList availableRenderers();
+
+    // Name set by QUARTZ_RENDERER environment variable, or the built-in default.
+    static QString defaultRenderer();
+    static AbstractRenderer *createRenderer(const QString &name);
+};
+
+} // Raytrace
+} // Qt3DRaytrace
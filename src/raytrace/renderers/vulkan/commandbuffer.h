@@ -93,6 +93,14 @@ public:
         bufferCopy.size = size;
         vkCmdCopyBuffer(handle, src, dest, 1, &bufferCopy);
     }
+    void copyBuffer(VkBuffer src, VkBuffer dest, const QVector<VkBufferCopy> &regions) const
+    {
+        vkCmdCopyBuffer(handle, src, dest, uint32_t(regions.size()), regions.data());
+    }
+    void copyBufferToImage(VkBuffer srcBuffer, VkImage dstImage, ImageState dstState, const QVector<VkBufferImageCopy> &regions) const
+    {
+        vkCmdCopyBufferToImage(handle, srcBuffer, dstImage, ResourceBarrier::getImageLayoutFromState(dstState), uint32_t(regions.size()), regions.data());
+    }
     void copyImageToBuffer(VkImage srcImage, ImageState srcState, VkBuffer dstBuffer, const VkBufferImageCopy &region) const
     {
         vkCmdCopyImageToBuffer(handle, srcImage, ResourceBarrier::getImageLayoutFromState(srcState), dstBuffer, 1, &region);
@@ -43,6 +43,7 @@ Device *Device::create(VkPhysicalDevice physicalDevice, uint32_t queueFamilyInde
         features.pNext = &descriptorIndexingFeatures;
     }
     vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    device->m_physicalDeviceFeatures = features.features;
 
     const float queuePriority = 1.0f;
     VkDeviceQueueCreateInfo queueCreateInfo = { VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
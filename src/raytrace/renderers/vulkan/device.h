@@ -114,6 +114,8 @@ public:
     uint32_t queueFamilyIndex() const { return m_queueFamilyIndex; }
 
     const VkPhysicalDeviceProperties &physicalDeviceProperties() const { return m_physicalDeviceProperties; }
+    // All features supported by the physical device are enabled on device creation.
+    const VkPhysicalDeviceFeatures &physicalDeviceFeatures() const { return m_physicalDeviceFeatures; }
     const VkPhysicalDeviceRayTracingPropertiesNV &rayTracingProperties() const { return m_rayTracingProperties; }
 
     bool isValid() const;
@@ -132,6 +134,7 @@ private:
     QMutex m_accelerationStructuresPoolMutex;
 
     VkPhysicalDeviceProperties m_physicalDeviceProperties;
+    VkPhysicalDeviceFeatures m_physicalDeviceFeatures;
     VkPhysicalDeviceRayTracingPropertiesNV m_rayTracingProperties;
 };
 
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/instancepacker.h>
+
+#include <utility/parallelfor.h>
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUARTZ_INSTANCEPACKER_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+namespace Config {
+
+// Number of matrices gathered into a single structure-of-arrays batch.
+constexpr int NormalMatrixBatchSize = 256;
+// Minimum number of modified instances for normal matrices to be computed in parallel.
+constexpr int NormalMatrixGrainSize = 4096;
+// Determinant magnitude below which a matrix is considered singular (matches qFuzzyIsNull(double)).
+constexpr float SingularDeterminant = 1e-12f;
+
+} // Config
+
+namespace {
+
+void computeNormalMatrix(const float m[9], float out[9])
+{
+    const float c0 = m[4] * m[8] - m[7] * m[5];
+    const float c1 = m[5] * m[6] - m[3] * m[8];
+    const float c2 = m[3] * m[7] - m[4] * m[6];
+    const float c3 = m[7] * m[2] - m[1] * m[8];
+    const float c4 = m[0] * m[8] - m[2] * m[6];
+    const float c5 = m[1] * m[6] - m[0] * m[7];
+    const float c6 = m[1] * m[5] - m[2] * m[4];
+    const float c7 = m[2] * m[3] - m[0] * m[5];
+    const float c8 = m[0] * m[4] - m[3] * m[1];
+
+    const float det = m[0] * c0 + m[3] * c3 + m[6] * c6;
+    if(std::fabs(det) <= Config::SingularDeterminant) {
+        out[0] = 1.0f; out[1] = 0.0f; out[2] = 0.0f;
+        out[3] = 0.0f; out[4] = 1.0f; out[5] = 0.0f;
+        out[6] = 0.0f; out[7] = 0.0f; out[8] = 1.0f;
+        return;
+    }
+
+    const float invDet = 1.0f / det;
+    out[0] = c0 * invDet; out[1] = c1 * invDet; out[2] = c2 * invDet;
+    out[3] = c3 * invDet; out[4] = c4 * invDet; out[5] = c5 * invDet;
+    out[6] = c6 * invDet; out[7] = c7 * invDet; out[8] = c8 * invDet;
+}
+
+} // anonymous
+
+void InstancePacker::resize(uint32_t instanceCount)
+{
+    const int oldCount = m_instances.size();
+    const int newCount = int(instanceCount);
+
+    m_instances.resize(newCount);
+    m_dirtyFlags.resize(newCount);
+    for(int index=oldCount; index < newCount; ++index) {
+        m_instances[index] = {};
+        m_dirtyFlags[index] = UploadDirty | TransformDirty;
+    }
+}
+
+void InstancePacker::invalidate()
+{
+    m_uploadAll = true;
+}
+
+void InstancePacker::clear()
+{
+    m_instances.clear();
+    m_dirtyFlags.clear();
+    m_uploadAll = false;
+}
+
+void InstancePacker::setInstance(uint32_t index, uint32_t materialIndex, uint32_t geometryIndex, uint32_t geometryNumFaces, const float *transform)
+{
+    Q_ASSERT(index < instanceCount());
+    Q_ASSERT(transform);
+
+    // Raw data pointers avoid QVector detach checks; both vectors are never shared.
+    EntityInstance &instance = m_instances.data()[index];
+    uchar &dirtyFlags = m_dirtyFlags.data()[index];
+
+    if(dirtyFlags & Cleared) {
+        dirtyFlags = (dirtyFlags & ~Cleared) | TransformDirty;
+    }
+
+    if(instance.materialIndex != materialIndex || instance.geometryIndex != geometryIndex || instance.geometryNumFaces != geometryNumFaces) {
+        instance.materialIndex = materialIndex;
+        instance.geometryIndex = geometryIndex;
+        instance.geometryNumFaces = geometryNumFaces;
+        dirtyFlags |= UploadDirty;
+    }
+    if(std::memcmp(instance.transform.data, transform, sizeof(instance.transform.data)) != 0) {
+        std::memcpy(instance.transform.data, transform, sizeof(instance.transform.data));
+        dirtyFlags |= TransformDirty;
+    }
+    if(dirtyFlags & TransformDirty) {
+        dirtyFlags |= UploadDirty;
+    }
+}
+
+void InstancePacker::clearInstance(uint32_t index)
+{
+    Q_ASSERT(index < instanceCount());
+
+    uchar &dirtyFlags = m_dirtyFlags.data()[index];
+    if(dirtyFlags & Cleared) {
+        return;
+    }
+    m_instances.data()[index] = {};
+    dirtyFlags = Cleared | UploadDirty;
+}
+
+QVector<InstancePacker::Range> InstancePacker::pack(uint32_t maxRangeGap)
+{
+    QVector<Range> ranges;
+    QVector<uint32_t> transformDirtyInstances;
+
+    const uint32_t count = instanceCount();
+    uchar *dirtyFlags = m_dirtyFlags.data();
+    for(uint32_t index=0; index < count; ++index) {
+        const uchar flags = dirtyFlags[index];
+        if(flags & TransformDirty) {
+            transformDirtyInstances.append(index);
+        }
+        if((flags & UploadDirty) && !m_uploadAll) {
+            if(!ranges.isEmpty() && index - (ranges.last().first + ranges.last().count) <= maxRangeGap) {
+                ranges.last().count = index - ranges.last().first + 1;
+            }
+            else {
+                ranges.append({index, 1});
+            }
+        }
+        dirtyFlags[index] = flags & Cleared;
+    }
+    if(m_uploadAll && count > 0) {
+        ranges.append({0, count});
+    }
+    m_uploadAll = false;
+
+    computeNormalMatrices(transformDirtyInstances);
+    return ranges;
+}
+
+void InstancePacker::computeNormalMatrices(const QVector<uint32_t> &instanceIndices)
+{
+    EntityInstance *instances = m_instances.data();
+    const uint32_t *indices = instanceIndices.constData();
+
+    auto computeRange = [instances, indices](int begin, int end) {
+        alignas(16) float inputs[9][Config::NormalMatrixBatchSize];
+        alignas(16) float outputs[9][Config::NormalMatrixBatchSize];
+        const float *const in[9] = { inputs[0], inputs[1], inputs[2], inputs[3], inputs[4], inputs[5], inputs[6], inputs[7], inputs[8] };
+        float *const out[9] = { outputs[0], outputs[1], outputs[2], outputs[3], outputs[4], outputs[5], outputs[6], outputs[7], outputs[8] };
+
+        for(int batchBegin=begin; batchBegin < end; batchBegin += Config::NormalMatrixBatchSize) {
+            const int batchSize = qMin(end - batchBegin, Config::NormalMatrixBatchSize);
+            for(int i=0; i < batchSize; ++i) {
+                const float *m = instances[indices[batchBegin + i]].transform.data;
+                inputs[0][i] = m[0]; inputs[1][i] = m[1]; inputs[2][i] = m[2];
+                inputs[3][i] = m[4]; inputs[4][i] = m[5]; inputs[5][i] = m[6];
+                inputs[6][i] = m[8]; inputs[7][i] = m[9]; inputs[8][i] = m[10];
+            }
+            InstancePacker::computeNormalMatrices(in, out, batchSize);
+            for(int i=0; i < batchSize; ++i) {
+                float *b = instances[indices[batchBegin + i]].basisTransform.data;
+                b[0] = outputs[0][i]; b[1] = outputs[1][i]; b[2]  = outputs[2][i];
+                b[4] = outputs[3][i]; b[5] = outputs[4][i]; b[6]  = outputs[5][i];
+                b[8] = outputs[6][i]; b[9] = outputs[7][i]; b[10] = outputs[8][i];
+            }
+        }
+    };
+    Utility::parallelFor(0, instanceIndices.size(), Config::NormalMatrixGrainSize, computeRange);
+}
+
+void InstancePacker::computeNormalMatrices(const float *const in[9], float *const out[9], int count)
+{
+    int i = 0;
+
+#if QUARTZ_INSTANCEPACKER_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 singularDeterminant = _mm_set1_ps(Config::SingularDeterminant);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for(; i + 4 <= count; i += 4) {
+        const __m128 m0 = _mm_loadu_ps(in[0] + i);
+        const __m128 m1 = _mm_loadu_ps(in[1] + i);
+        const __m128 m2 = _mm_loadu_ps(in[2] + i);
+        const __m128 m3 = _mm_loadu_ps(in[3] + i);
+        const __m128 m4 = _mm_loadu_ps(in[4] + i);
+        const __m128 m5 = _mm_loadu_ps(in[5] + i);
+        const __m128 m6 = _mm_loadu_ps(in[6] + i);
+        const __m128 m7 = _mm_loadu_ps(in[7] + i);
+        const __m128 m8 = _mm_loadu_ps(in[8] + i);
+
+        __m128 c[9];
+        c[0] = _mm_sub_ps(_mm_mul_ps(m4, m8), _mm_mul_ps(m7, m5));
+        c[1] = _mm_sub_ps(_mm_mul_ps(m5, m6), _mm_mul_ps(m3, m8));
+        c[2] = _mm_sub_ps(_mm_mul_ps(m3, m7), _mm_mul_ps(m4, m6));
+        c[3] = _mm_sub_ps(_mm_mul_ps(m7, m2), _mm_mul_ps(m1, m8));
+        c[4] = _mm_sub_ps(_mm_mul_ps(m0, m8), _mm_mul_ps(m2, m6));
+        c[5] = _mm_sub_ps(_mm_mul_ps(m1, m6), _mm_mul_ps(m0, m7));
+        c[6] = _mm_sub_ps(_mm_mul_ps(m1, m5), _mm_mul_ps(m2, m4));
+        c[7] = _mm_sub_ps(_mm_mul_ps(m2, m3), _mm_mul_ps(m0, m5));
+        c[8] = _mm_sub_ps(_mm_mul_ps(m0, m4), _mm_mul_ps(m3, m1));
+
+        const __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, c[0]), _mm_mul_ps(m3, c[3])), _mm_mul_ps(m6, c[6]));
+        const __m128 singular = _mm_cmple_ps(_mm_andnot_ps(signMask, det), singularDeterminant);
+        const __m128 invDet = _mm_div_ps(one, det);
+
+        for(int k=0; k < 9; ++k) {
+            const __m128 identity = (k == 0 || k == 4 || k == 8) ? one : _mm_setzero_ps();
+            const __m128 value = _mm_mul_ps(c[k], invDet);
+            _mm_storeu_ps(out[k] + i, _mm_or_ps(_mm_and_ps(singular, identity), _mm_andnot_ps(singular, value)));
+        }
+    }
+#endif
+
+    for(; i < count; ++i) {
+        const float m[9] = { in[0][i], in[1][i], in[2][i], in[3][i], in[4][i], in[5][i], in[6][i], in[7][i], in[8][i] };
+        float n[9];
+        computeNormalMatrix(m, n);
+        for(int k=0; k < 9; ++k) {
+            out[k][i] = n[k];
+        }
+    }
+}
+
+} // Vulkan
+} // Qt3DRaytrace
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/vulkan/glsl.h>
+
+#include <QVector>
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+// Persistent host-side copy of the entity instance buffer.
+// Inputs are compared against the previously packed instances so that only modified instances are
+// repacked. Normal matrices of modified instances are computed in SIMD batches and modified instances
+// are reported as coalesced index ranges suitable for partial buffer uploads.
+class InstancePacker
+{
+public:
+    struct Range {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    void resize(uint32_t instanceCount);
+    void invalidate();
+    void clear();
+
+    // Safe to call concurrently for distinct instance indices.
+    void setInstance(uint32_t index, uint32_t materialIndex, uint32_t geometryIndex, uint32_t geometryNumFaces, const float *transform);
+    void clearInstance(uint32_t index);
+
+    QVector<Range> pack(uint32_t maxRangeGap=16);
+
+    const EntityInstance *instances() const { return m_instances.constData(); }
+    uint32_t instanceCount() const { return uint32_t(m_instances.size()); }
+
+    // Computes inverse-transpose of the upper 3x3 part of count matrices stored as structure-of-arrays.
+    // Element (column c, row r) of matrix i is read from in[c*3+r][i] and written to out[c*3+r][i].
+    // Singular matrices produce identity, same as QMatrix4x4::normalMatrix().
+    static void computeNormalMatrices(const float *const in[9], float *const out[9], int count);
+
+private:
+    void computeNormalMatrices(const QVector<uint32_t> &instanceIndices);
+
+    enum DirtyFlags : uchar {
+        UploadDirty = 1 << 0,
+        TransformDirty = 1 << 1,
+        // Released instance holding no valid data; persists across pack() calls.
+        Cleared = 1 << 2,
+    };
+
+    QVector<EntityInstance> m_instances;
+    QVector<uchar> m_dirtyFlags;
+    bool m_uploadAll = false;
+};
+
+} // Vulkan
+} // Qt3DRaytrace
@@ -13,6 +13,7 @@
 #include <backend/geometry_p.h>
 
 #include <cstring>
+#include <limits>
 #include <QMutex>
 
 using namespace Qt3DCore;
@@ -59,9 +60,23 @@ void BuildGeometryJob::run()
     auto *commandBufferManager = m_renderer->commandBufferManager();
     auto *sceneManager = m_renderer->sceneManager();
 
+    if(geometryNode->numVertices() > std::numeric_limits<uint32_t>::max() || geometryNode->numFaces() > std::numeric_limits<uint32_t>::max() / 3) {
+        qCCritical(logVulkan) << "Geometry exceeds maximum number of vertices or indices supported by BLAS";
+        return;
+    }
+
+    // Geometry nodes sharing the same data, e.g. meshes loaded from the same asset, share device resources.
+    // Holding the lock makes concurrent jobs for the same data wait for this one and then reuse its result.
+    SceneManager::SharedGeometryPtr sharedGeometry = sceneManager->acquireSharedGeometry(geometryNode->data());
+    QMutexLocker sharedGeometryLock(&sharedGeometry->mutex);
+    if(sharedGeometry->resource.blas) {
+        sceneManager->addOrUpdateGeometry(geometryNode->peerId(), sharedGeometry);
+        return;
+    }
+
     Geometry geometry;
-    geometry.numVertices = uint32_t(geometryNode->vertices().size());
-    geometry.numIndices = uint32_t(geometryNode->faces().size()) * 3;
+    geometry.numVertices = uint32_t(geometryNode->numVertices());
+    geometry.numIndices = uint32_t(geometryNode->numFaces()) * 3;
 
     const VkDeviceSize attributeBufferSize = sizeof(Attributes) * geometry.numVertices;
     const VkDeviceSize indexBufferSize = sizeof(uint32_t) * geometry.numIndices;
@@ -138,8 +153,8 @@ void BuildGeometryJob::run()
         return;
     }
 
-    copyAttributes(stagingAttributes.memory<Attributes>(), geometryNode->vertices().data(), geometry.numVertices);
-    copyIndices(stagingIndices.memory<uint32_t>(), geometryNode->faces().data(), geometry.numIndices);
+    copyAttributes(stagingAttributes.memory<Attributes>(), geometryNode->vertexData(), geometry.numVertices);
+    copyIndices(stagingIndices.memory<uint32_t>(), geometryNode->faceData(), geometry.numIndices);
 
     TransientCommandBuffer commandBuffer = commandBufferManager->acquireCommandBuffer();
     {
@@ -157,7 +172,8 @@ void BuildGeometryJob::run()
     }
     commandBufferManager->releaseCommandBuffer(commandBuffer, {stagingAttributes, stagingIndices, scratchBuffer});
 
-    sceneManager->addOrUpdateGeometry(geometryNode->peerId(), geometry);
+    sharedGeometry->resource = geometry;
+    sceneManager->addOrUpdateGeometry(geometryNode->peerId(), sharedGeometry);
 }
 
 } // Vulkan
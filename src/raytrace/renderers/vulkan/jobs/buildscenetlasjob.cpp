@@ -101,21 +101,27 @@ QVector<GeometryInstance> BuildSceneTopLevelAccelerationStructureJob::gatherGeom
     auto *sceneManager = m_renderer->sceneManager();
     Q_ASSERT(sceneManager);
 
+    // Renderable slots are stable and may contain holes so instances are packed densely
+    // and refer back to their slot in the instance buffer via custom index.
     const auto &renderables = sceneManager->renderables();
+    instances.reserve(int(sceneManager->numRenderables()));
     for(int instanceIndex = 0; instanceIndex < renderables.size(); ++instanceIndex) {
-        const auto &renderable = renderables[instanceIndex];
+        const Raytrace::Entity *renderable = renderables[instanceIndex].data();
+        if(!renderable) {
+            continue;
+        }
         const Raytrace::GeometryRenderer *geometryRenderer = renderable->geometryRendererComponent();
         Q_ASSERT(geometryRenderer);
 
         Geometry geometry;
         uint32_t geometryIndex = sceneManager->lookupGeometry(geometryRenderer->geometryId(), geometry);
         if(geometryIndex != ~0u) {
-            const QMatrix4x4 worldTransformRowMajor = renderable->worldTransformMatrix.transposed().toQMatrix4x4();
+            const QMatrix4x4 worldTransformRowMajor = renderable->worldTransformMatrix().transposed().toQMatrix4x4();
             GeometryInstance geometryInstance = {};
             std::memcpy(geometryInstance.transform, worldTransformRowMajor.constData(), sizeof(geometryInstance.transform));
             geometryInstance.mask = 0xFF;
             geometryInstance.blasHandle = geometry.blasHandle;
-            geometryInstance.instanceCustomIndex = geometryIndex;
+            geometryInstance.instanceCustomIndex = uint32_t(instanceIndex);
             instances.append(geometryInstance);
         }
     }
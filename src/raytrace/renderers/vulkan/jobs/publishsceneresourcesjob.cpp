@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/jobs/publishsceneresourcesjob.h>
+#include <renderers/vulkan/renderer.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+PublishSceneResourcesJob::PublishSceneResourcesJob(Renderer *renderer, ResourceType resourceType)
+    : m_renderer(renderer)
+    , m_resourceType(resourceType)
+{
+    Q_ASSERT(m_renderer);
+}
+
+void PublishSceneResourcesJob::run()
+{
+    auto *sceneManager = m_renderer->sceneManager();
+    Q_ASSERT(sceneManager);
+
+    switch(m_resourceType) {
+    case ResourceType::Geometry:
+        sceneManager->publishGeometry();
+        break;
+    case ResourceType::Textures:
+        sceneManager->publishTextures();
+        break;
+    }
+}
+
+} // Vulkan
+} // Qt3DRaytrace
@@ -61,8 +61,12 @@ void UpdateEmittersJob::run()
         emitters.append(skyEmitter);
     }
 
-    for(const auto &entity : sceneManager->emissives()) {
-        const QMatrix4x4 entityTransform = entity->worldTransformMatrix.toQMatrix4x4();
+    for(const auto &emissive : sceneManager->emissives()) {
+        const Raytrace::Entity *entity = emissive.data();
+        if(!entity) {
+            continue;
+        }
+        const QMatrix4x4 entityTransform = entity->worldTransformMatrix().toQMatrix4x4();
         if(!entity->distantLightComponentId().isNull()) {
             const Raytrace::DistantLight *light = entity->distantLightComponent();
             Q_ASSERT(light);
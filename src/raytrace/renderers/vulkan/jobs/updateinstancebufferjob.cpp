@@ -8,12 +8,22 @@
 #include <renderers/vulkan/renderer.h>
 
 #include <backend/managers_p.h>
+#include <utility/parallelfor.h>
+
+#include <cstring>
 
 using namespace Qt3DCore;
 
 namespace Qt3DRaytrace {
 namespace Vulkan {
 
+namespace Config {
+
+constexpr uint32_t MinInstanceBufferCapacity = 256;
+constexpr int GatherGrainSize = 1024;
+
+} // Config
+
 UpdateInstanceBufferJob::UpdateInstanceBufferJob(Renderer *renderer)
     : m_renderer(renderer)
 {
@@ -30,50 +40,104 @@ void UpdateInstanceBufferJob::run()
     Q_ASSERT(renderables.size() > 0);
 
     const uint32_t instanceCount = uint32_t(renderables.size());
-    const VkDeviceSize instanceBufferSize = sizeof(EntityInstance) * instanceCount;
-
-    BufferCreateInfo instanceBufferCreateInfo;
-    instanceBufferCreateInfo.size = instanceBufferSize;
-    instanceBufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    Buffer instanceBuffer = device->createBuffer(instanceBufferCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY);
-    if(!instanceBuffer) {
-        qCCritical(logVulkan) << "Failed to create instance buffer";
+
+    InstancePacker &instancePacker = sceneManager->instancePacker();
+    instancePacker.resize(instanceCount);
+    Utility::parallelFor(0, int(instanceCount), Config::GatherGrainSize, [&](int begin, int end) {
+        for(int instanceIndex=begin; instanceIndex < end; ++instanceIndex) {
+            const Raytrace::Entity *renderable = renderables[instanceIndex].data();
+            if(!renderable) {
+                // Released slot: never referenced by TLAS instances or emitters.
+                instancePacker.clearInstance(uint32_t(instanceIndex));
+                continue;
+            }
+            const Raytrace::GeometryRenderer *geometryRenderer = renderable->geometryRendererComponent();
+            Q_ASSERT(geometryRenderer);
+
+            const uint32_t materialIndex = sceneManager->lookupMaterialIndex(renderable->materialComponentId());
+
+            Geometry renderableGeometry;
+            const uint32_t geometryIndex = sceneManager->lookupGeometry(geometryRenderer->geometryId(), renderableGeometry);
+
+            const QMatrix4x4 entityTransform = renderable->worldTransformMatrix().toQMatrix4x4();
+            instancePacker.setInstance(uint32_t(instanceIndex), materialIndex, geometryIndex, renderableGeometry.numIndices / 3, entityTransform.constData());
+        }
+    });
+
+    // Instance buffer persists across updates and is only reallocated when it needs to grow.
+    uint32_t instanceBufferCapacity = 0;
+    Buffer instanceBuffer = sceneManager->instanceBuffer(&instanceBufferCapacity);
+    const bool reallocateInstanceBuffer = !instanceBuffer || instanceBufferCapacity < instanceCount;
+    if(reallocateInstanceBuffer) {
+        instanceBufferCapacity = qMax(Config::MinInstanceBufferCapacity, instanceBufferCapacity);
+        while(instanceBufferCapacity < instanceCount) {
+            instanceBufferCapacity *= 2;
+        }
+
+        BufferCreateInfo instanceBufferCreateInfo;
+        instanceBufferCreateInfo.size = sizeof(EntityInstance) * instanceBufferCapacity;
+        instanceBufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        instanceBuffer = device->createBuffer(instanceBufferCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY);
+        if(!instanceBuffer) {
+            qCCritical(logVulkan) << "Failed to create instance buffer";
+            return;
+        }
+        instancePacker.invalidate();
+    }
+
+    const QVector<InstancePacker::Range> dirtyRanges = instancePacker.pack();
+    if(dirtyRanges.isEmpty()) {
         return;
     }
 
-    Buffer stagingBuffer = device->createStagingBuffer(instanceBufferSize);
+    VkDeviceSize stagingBufferSize = 0;
+    for(const InstancePacker::Range &range : dirtyRanges) {
+        stagingBufferSize += sizeof(EntityInstance) * range.count;
+    }
+
+    Buffer stagingBuffer = device->createStagingBuffer(stagingBufferSize);
     if(!stagingBuffer || !stagingBuffer.isHostAccessible()) {
         qCCritical(logVulkan) << "Failed to create staging buffer for instance data";
-        device->destroyBuffer(instanceBuffer);
+        if(reallocateInstanceBuffer) {
+            device->destroyBuffer(instanceBuffer);
+        }
+        // Packed instances are up to date but were never uploaded.
+        instancePacker.invalidate();
         return;
     }
 
-    EntityInstance *instanceData = stagingBuffer.memory<EntityInstance>();
-    for(uint32_t instanceIndex=0; instanceIndex < instanceCount; ++instanceIndex) {
-        const Raytrace::Entity *renderable = renderables[int(instanceIndex)].data();
-        const Raytrace::GeometryRenderer *geometryRenderer = renderable->geometryRendererComponent();
-        Q_ASSERT(geometryRenderer);
+    QVector<VkBufferCopy> copyRegions;
+    copyRegions.reserve(dirtyRanges.size());
 
-        EntityInstance &instance = instanceData[instanceIndex];
-        instance.materialIndex = sceneManager->lookupMaterialIndex(renderable->materialComponentId());
+    uint8_t *stagingData = stagingBuffer.memory<uint8_t>();
+    VkDeviceSize stagingOffset = 0;
+    for(const InstancePacker::Range &range : dirtyRanges) {
+        const VkDeviceSize rangeSize = sizeof(EntityInstance) * range.count;
+        std::memcpy(stagingData + stagingOffset, instancePacker.instances() + range.first, size_t(rangeSize));
 
-        Geometry renderableGeometry;
-        instance.geometryIndex = sceneManager->lookupGeometry(geometryRenderer->geometryId(), renderableGeometry);
-        instance.geometryNumFaces = renderableGeometry.numIndices / 3;
+        VkBufferCopy copyRegion;
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.dstOffset = sizeof(EntityInstance) * range.first;
+        copyRegion.size = rangeSize;
+        copyRegions.append(copyRegion);
 
-        const QMatrix4x4 entityTransform = renderable->worldTransformMatrix.toQMatrix4x4();
-        instance.transform = entityTransform;
-        instance.basisTransform = entityTransform.normalMatrix();
+        stagingOffset += rangeSize;
     }
 
     TransientCommandBuffer commandBuffer = commandBufferManager->acquireCommandBuffer();
     {
-        commandBuffer->copyBuffer(stagingBuffer, 0, instanceBuffer, 0, instanceBufferSize);
+        if(!reallocateInstanceBuffer) {
+            // Wait for frames submitted earlier to finish reading the instance buffer.
+            commandBuffer->resourceBarrier({instanceBuffer, BufferState::ShaderRead, BufferState::CopyDest});
+        }
+        commandBuffer->copyBuffer(stagingBuffer, instanceBuffer, copyRegions);
         commandBuffer->resourceBarrier({instanceBuffer, BufferState::CopyDest, BufferState::ShaderRead});
     }
     commandBufferManager->releaseCommandBuffer(commandBuffer, QVector<Buffer>{stagingBuffer});
 
-    sceneManager->updateInstanceBuffer(instanceBuffer);
+    if(reallocateInstanceBuffer) {
+        sceneManager->updateInstanceBuffer(instanceBuffer, instanceBufferCapacity);
+    }
 }
 
 } // Vulkan
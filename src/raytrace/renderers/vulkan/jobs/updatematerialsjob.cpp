@@ -9,6 +9,7 @@
 
 #include <backend/managers_p.h>
 
+#include <algorithm>
 #include <cstring>
 
 using namespace Qt3DCore;
@@ -16,6 +17,23 @@ using namespace Qt3DCore;
 namespace Qt3DRaytrace {
 namespace Vulkan {
 
+namespace Config {
+
+constexpr uint32_t MinMaterialBufferCapacity = 64;
+// Maximum number of unmodified materials uploaded to merge two neighbouring copy ranges.
+constexpr uint32_t MaxCopyRangeGap = 16;
+
+} // Config
+
+namespace {
+
+struct CopyRange {
+    uint32_t first;
+    uint32_t count;
+};
+
+} // anonymous
+
 UpdateMaterialsJob::UpdateMaterialsJob(Renderer *renderer, Raytrace::TextureManager *textureManager)
     : m_renderer(renderer)
     , m_textureManager(textureManager)
@@ -42,6 +60,11 @@ void UpdateMaterialsJob::run()
         return ~0u;
     };
 
+    QVector<QNodeId> materialNodeIds;
+    QVector<Material> materialUpdates;
+    materialNodeIds.reserve(m_dirtyMaterialHandles.size());
+    materialUpdates.reserve(m_dirtyMaterialHandles.size());
+
     for(const auto &handle : m_dirtyMaterialHandles) {
         Raytrace::Material *material = handle.data();
 
@@ -57,43 +80,106 @@ void UpdateMaterialsJob::run()
         materialData.roughnessTexture = lookupTextureImageIndex(material->roughnessTextureId());
         materialData.metalnessTexture = lookupTextureImageIndex(material->metalnessTextureId());
 
-        // TODO: Reduce lock contention on rwlock.
-        sceneManager->addOrUpdateMaterial(material->peerId(), materialData);
+        materialNodeIds.append(material->peerId());
+        materialUpdates.append(materialData);
     }
     m_dirtyMaterialHandles.clear();
 
-    QVector<Material> materials = sceneManager->materials();
-    const VkDeviceSize materialBufferSize = sizeof(Material) * uint32_t(materials.size());
-    if(materials.size() == 0) {
+    // All updated materials are published to readers as a single new snapshot.
+    QVector<uint32_t> updatedIndices = sceneManager->addOrUpdateMaterials(materialNodeIds, materialUpdates);
+
+    const QVector<Material> materials = sceneManager->materials();
+    const uint32_t materialCount = uint32_t(materials.size());
+    if(materialCount == 0) {
         return;
     }
 
-    BufferCreateInfo materialBufferCreateInfo;
-    materialBufferCreateInfo.size = materialBufferSize;
-    materialBufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    Buffer materialBuffer = device->createBuffer(materialBufferCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY);
-    if(!materialBuffer) {
-        qCCritical(logVulkan) << "Failed to create material data buffer";
+    // Material buffer persists across updates and is only reallocated when it needs to grow.
+    uint32_t materialBufferCapacity = 0;
+    Buffer materialBuffer = sceneManager->materialBuffer(&materialBufferCapacity);
+    const bool reallocateMaterialBuffer = !materialBuffer || materialBufferCapacity < materialCount;
+
+    QVector<CopyRange> copyRanges;
+    if(reallocateMaterialBuffer) {
+        copyRanges.append({0, materialCount});
+    }
+    else {
+        std::sort(updatedIndices.begin(), updatedIndices.end());
+        for(uint32_t index : qAsConst(updatedIndices)) {
+            if(!copyRanges.isEmpty() && index < copyRanges.last().first + copyRanges.last().count + Config::MaxCopyRangeGap) {
+                copyRanges.last().count = qMax(copyRanges.last().count, index - copyRanges.last().first + 1);
+            }
+            else {
+                copyRanges.append({index, 1});
+            }
+        }
+    }
+    if(copyRanges.isEmpty()) {
         return;
     }
 
-    Buffer stagingBuffer = device->createStagingBuffer(materialBufferSize);
+    if(reallocateMaterialBuffer) {
+        materialBufferCapacity = qMax(Config::MinMaterialBufferCapacity, materialBufferCapacity);
+        while(materialBufferCapacity < materialCount) {
+            materialBufferCapacity *= 2;
+        }
+
+        BufferCreateInfo materialBufferCreateInfo;
+        materialBufferCreateInfo.size = sizeof(Material) * materialBufferCapacity;
+        materialBufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+        materialBuffer = device->createBuffer(materialBufferCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY);
+        if(!materialBuffer) {
+            qCCritical(logVulkan) << "Failed to create material data buffer";
+            return;
+        }
+    }
+
+    VkDeviceSize stagingBufferSize = 0;
+    for(const CopyRange &range : copyRanges) {
+        stagingBufferSize += sizeof(Material) * range.count;
+    }
+
+    Buffer stagingBuffer = device->createStagingBuffer(stagingBufferSize);
     if(!stagingBuffer || !stagingBuffer.isHostAccessible()) {
         qCCritical(logVulkan) << "Failed to create staging buffer for material data upload";
-        device->destroyBuffer(materialBuffer);
+        if(reallocateMaterialBuffer) {
+            device->destroyBuffer(materialBuffer);
+        }
         return;
     }
 
-    std::memcpy(stagingBuffer.memory(), materials.data(), materialBufferSize);
+    QVector<VkBufferCopy> copyRegions;
+    copyRegions.reserve(copyRanges.size());
+
+    uint8_t *stagingData = stagingBuffer.memory<uint8_t>();
+    VkDeviceSize stagingOffset = 0;
+    for(const CopyRange &range : copyRanges) {
+        const VkDeviceSize rangeSize = sizeof(Material) * range.count;
+        std::memcpy(stagingData + stagingOffset, materials.constData() + range.first, size_t(rangeSize));
+
+        VkBufferCopy copyRegion;
+        copyRegion.srcOffset = stagingOffset;
+        copyRegion.dstOffset = sizeof(Material) * range.first;
+        copyRegion.size = rangeSize;
+        copyRegions.append(copyRegion);
+
+        stagingOffset += rangeSize;
+    }
 
     TransientCommandBuffer commandBuffer = commandBufferManager->acquireCommandBuffer();
     {
-        commandBuffer->copyBuffer(stagingBuffer, 0, materialBuffer, 0, materialBufferSize);
+        if(!reallocateMaterialBuffer) {
+            // Wait for frames submitted earlier to finish reading the material buffer.
+            commandBuffer->resourceBarrier({materialBuffer, BufferState::ShaderRead, BufferState::CopyDest});
+        }
+        commandBuffer->copyBuffer(stagingBuffer, materialBuffer, copyRegions);
         commandBuffer->resourceBarrier({materialBuffer, BufferState::CopyDest, BufferState::ShaderRead});
     }
     commandBufferManager->releaseCommandBuffer(commandBuffer, QVector<Buffer>{stagingBuffer});
 
-    sceneManager->updateMaterialBuffer(materialBuffer);
+    if(reallocateMaterialBuffer) {
+        sceneManager->updateMaterialBuffer(materialBuffer, materialBufferCapacity);
+    }
 }
 
 } // Vulkan
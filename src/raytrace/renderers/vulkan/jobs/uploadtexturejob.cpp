@@ -9,12 +9,22 @@
 
 #include <backend/managers_p.h>
 #include <backend/textureimage_p.h>
+#include <io/blockcompression_p.h>
+#include <io/texelconversion_p.h>
 
 #include <cstring>
+#include <QMutexLocker>
 
 namespace Qt3DRaytrace {
 namespace Vulkan {
 
+namespace Config {
+
+// Alignment of mip levels in staging buffer, satisfying buffer offset requirements of all texture formats.
+constexpr VkDeviceSize StagingLevelAlignment = 16;
+
+} // Config
+
 static VkFormat getOptimalTextureFormat(const QImageData &data)
 {
     switch(data.type) {
@@ -22,7 +32,7 @@ static VkFormat getOptimalTextureFormat(const QImageData &data)
         switch(data.channels) {
         case 1: return VK_FORMAT_R8_UNORM;
         case 2: return VK_FORMAT_R8G8_UNORM;
-        // Assume sRGB colorspace for RGBA LDR format.
+        // Assume sRGB colorspace for RGBA LDR format; RGB texels are expanded to RGBA when converted for upload.
         case 3:
         case 4: return VK_FORMAT_R8G8B8A8_SRGB;
         }
@@ -42,59 +52,30 @@ static VkFormat getOptimalTextureFormat(const QImageData &data)
     return VK_FORMAT_UNDEFINED;
 }
 
-static VkFormat getLinearTextureFormat(const QImageData &data)
+static VkFormat getCompressedTextureFormat(const QImageData &data)
 {
-    // TODO: Support BGR & BGRA formats.
-    switch(data.type) {
-    case QImageData::ValueType::UInt8:
-        switch(data.channels) {
-        case 1: return VK_FORMAT_R8_UNORM;
-        case 2: return VK_FORMAT_R8G8_UNORM;
-        // Assume sRGB colorspace for RGB & RGBA LDR formats.
-        case 3: return VK_FORMAT_R8G8B8_SRGB;
-        case 4: return VK_FORMAT_R8G8B8A8_SRGB;
-        }
-        break;
-    case QImageData::ValueType::Float16:
-        switch(data.channels) {
-        case 1: return VK_FORMAT_R16_SFLOAT;
-        case 2: return VK_FORMAT_R16G16_SFLOAT;
-        case 3: return VK_FORMAT_R16G16B16_SFLOAT;
-        case 4: return VK_FORMAT_R16G16B16A16_SFLOAT;
-        }
-        break;
-    case QImageData::ValueType::Float32:
-        switch(data.channels) {
-        case 1: return VK_FORMAT_R32_SFLOAT;
-        case 2: return VK_FORMAT_R32G32_SFLOAT;
-        case 3: return VK_FORMAT_R32G32B32_SFLOAT;
-        case 4: return VK_FORMAT_R32G32B32A32_SFLOAT;
-        }
-        break;
+    switch(data.blockFormat) {
+    // Assume sRGB colorspace for color formats, same as for uncompressed LDR textures.
+    case QImageData::BlockFormat::BC1:
+        return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+    case QImageData::BlockFormat::BC2:
+        return VK_FORMAT_BC2_SRGB_BLOCK;
+    case QImageData::BlockFormat::BC3:
+        return VK_FORMAT_BC3_SRGB_BLOCK;
+    case QImageData::BlockFormat::BC7:
+        return VK_FORMAT_BC7_SRGB_BLOCK;
+    case QImageData::BlockFormat::BC4:
+        return VK_FORMAT_BC4_UNORM_BLOCK;
+    case QImageData::BlockFormat::BC5:
+        return VK_FORMAT_BC5_UNORM_BLOCK;
+    case QImageData::BlockFormat::BC6H:
+        return VK_FORMAT_BC6H_UFLOAT_BLOCK;
     default:
         break;
     }
     return VK_FORMAT_UNDEFINED;
 }
 
-static void copyImageData(void *dest, const QImageData &src, const VkSubresourceLayout &layout)
-{
-    uint8_t *destPixels  = reinterpret_cast<uint8_t*>(dest) + layout.offset;
-    uint32_t srcRowPitch = uint32_t(src.width * src.channels * static_cast<int>(src.type));
-
-    if(layout.rowPitch == srcRowPitch) {
-        std::memcpy(destPixels, src.data.constData(), layout.size);
-    }
-    else {
-        const uint8_t *srcPixels = reinterpret_cast<const uint8_t*>(src.data.constData());
-        for(int row=0; row < src.height; ++row) {
-            std::memcpy(destPixels, srcPixels, srcRowPitch);
-            srcPixels  += srcRowPitch;
-            destPixels += layout.rowPitch;
-        }
-    }
-}
-
 UploadTextureJob::UploadTextureJob(Renderer *renderer, const Raytrace::HTextureImage &handle)
     : m_renderer(renderer)
     , m_handle(handle)
@@ -109,26 +90,76 @@ void UploadTextureJob::run()
         return;
     }
 
-    const auto &imageData = textureImageNode->data();
-    const uint32_t imageWidth = uint32_t(imageData.width);
-    const uint32_t imageHeight = uint32_t(imageData.height);
-
     auto *device = m_renderer->device();
     auto *commandBufferManager = m_renderer->commandBufferManager();
     auto *sceneManager = m_renderer->sceneManager();
 
-    VkFormat stagingFormat = getLinearTextureFormat(imageData);
-    VkFormat optimalFormat = getOptimalTextureFormat(imageData);
-    if(stagingFormat == VK_FORMAT_UNDEFINED || optimalFormat == VK_FORMAT_UNDEFINED) {
+    // Texture images sharing the same data, e.g. textures loaded from the same asset, share device resources.
+    SceneManager::SharedImagePtr sharedTextureImage = sceneManager->acquireSharedTexture(textureImageNode->data());
+    QMutexLocker sharedTextureImageLock(&sharedTextureImage->mutex);
+    if(sharedTextureImage->resource) {
+        sceneManager->addOrUpdateTexture(textureImageNode->peerId(), sharedTextureImage);
+        return;
+    }
+
+    QImageData imageData = textureImageNode->data();
+    if(imageData.isCompressed() && !device->physicalDeviceFeatures().textureCompressionBC) {
+        QImageData decompressedImageData;
+        if(!Raytrace::decompressImage(imageData, decompressedImageData)) {
+            qCCritical(logVulkan) << "UploadTextureJob: failed to decompress texture image unsupported by the device";
+            return;
+        }
+        imageData = decompressedImageData;
+    }
+
+    const uint32_t imageWidth = uint32_t(imageData.width);
+    const uint32_t imageHeight = uint32_t(imageData.height);
+
+    const bool isCompressed = imageData.isCompressed();
+    const VkFormat textureFormat = isCompressed ? getCompressedTextureFormat(imageData) : getOptimalTextureFormat(imageData);
+    if(textureFormat == VK_FORMAT_UNDEFINED) {
         qCCritical(logVulkan) << "UploadTextureJob: unsupported texture image data format";
         return;
     }
 
+    if(imageData.mipLevels < 1 || imageData.mipLevels > QImageData::maxMipLevels(imageData.width, imageData.height)) {
+        qCCritical(logVulkan) << "UploadTextureJob: invalid number of texture image mip levels";
+        return;
+    }
+    const uint32_t mipLevels = uint32_t(imageData.mipLevels);
+
+    const quint64 expectedSize = imageData.expectedSizeInBytes();
+    if(expectedSize == 0 || imageData.sizeInBytes() < expectedSize) {
+        qCCritical(logVulkan) << "UploadTextureJob: incomplete texture image data";
+        return;
+    }
+
+    // Uncompressed texels are converted on the CPU to the layout of texture format, while block compressed mip levels
+    // are already in it. Either way mip levels are then copied from a staging buffer as is.
+    const QImageData texelLayout = isCompressed ? imageData : Raytrace::getConvertedTexelLayout(imageData);
+
+    QVector<VkBufferImageCopy> regions;
+    regions.reserve(int(mipLevels));
+    VkDeviceSize stagingBufferSize = 0;
+    for(uint32_t level=0; level < mipLevels; ++level) {
+        VkBufferImageCopy region = {};
+        region.bufferOffset = stagingBufferSize;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { uint32_t(imageData.mipWidth(int(level))), uint32_t(imageData.mipHeight(int(level))), 1 };
+        regions.append(region);
+
+        const VkDeviceSize levelSize = VkDeviceSize(texelLayout.mipLevelSize(int(level)));
+        stagingBufferSize += (levelSize + Config::StagingLevelAlignment - 1) & ~(Config::StagingLevelAlignment - 1);
+    }
+
     ImageCreateInfo imageCreateInfo;
     imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageCreateInfo.format = optimalFormat;
+    imageCreateInfo.format = textureFormat;
     imageCreateInfo.extent.width = imageWidth;
     imageCreateInfo.extent.height = imageHeight;
+    imageCreateInfo.mipLevels = mipLevels;
     imageCreateInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 
     Image textureImage = device->createImage(imageCreateInfo, VMA_MEMORY_USAGE_GPU_ONLY);
@@ -137,38 +168,37 @@ void UploadTextureJob::run()
         return;
     }
 
-    Image stagingImage = device->createStagingImage(imageWidth, imageHeight, stagingFormat, ImageState::Staging);
-    if(!stagingImage || !stagingImage.isHostAccessible()) {
-        qCCritical(logVulkan) << "Failed to create staging image for GPU texture upload";
+    Buffer stagingBuffer = device->createStagingBuffer(stagingBufferSize);
+    if(!stagingBuffer || !stagingBuffer.isHostAccessible()) {
+        qCCritical(logVulkan) << "Failed to create staging buffer for GPU texture upload";
+        if(stagingBuffer) {
+            device->destroyBuffer(stagingBuffer);
+        }
         device->destroyImage(textureImage);
         return;
     }
 
-    VkSubresourceLayout stagingImageLayout = device->getImageSubresourceLayout(stagingImage, VK_IMAGE_ASPECT_COLOR_BIT, 0, 0);
-    copyImageData(stagingImage.hostAddress, imageData, stagingImageLayout);
+    uint8_t *stagingData = stagingBuffer.memory<uint8_t>();
+    for(uint32_t level=0; level < mipLevels; ++level) {
+        uint8_t *levelData = stagingData + regions[int(level)].bufferOffset;
+        if(isCompressed) {
+            std::memcpy(levelData, imageData.constMipBits(int(level)), size_t(imageData.mipLevelSize(int(level))));
+        }
+        else {
+            Raytrace::convertTexels(imageData, int(level), levelData);
+        }
+    }
 
     TransientCommandBuffer commandBuffer = commandBufferManager->acquireCommandBuffer();
     {
-        // TODO: Use plain copy via a staging buffer if format conversion is not necessary.
-
-        VkImageBlit region = {};
-        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.srcSubresource.layerCount = 1;
-        region.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.dstSubresource.layerCount = 1;
-        region.srcOffsets[1] = { int32_t(imageWidth), int32_t(imageHeight), 1 };
-        region.dstOffsets[1] = { int32_t(imageWidth), int32_t(imageHeight), 1 };
-
-        commandBuffer->resourceBarrier({
-            ImageTransition{stagingImage, ImageState::Staging,   ImageState::CopySource},
-            ImageTransition{textureImage, ImageState::Undefined, ImageState::CopyDest}
-        });
-        commandBuffer->blitImage(stagingImage, ImageState::CopySource, textureImage, ImageState::CopyDest, region, VK_FILTER_NEAREST);
+        commandBuffer->resourceBarrier(ImageTransition{textureImage, ImageState::Undefined, ImageState::CopyDest});
+        commandBuffer->copyBufferToImage(stagingBuffer, textureImage, ImageState::CopyDest, regions);
         commandBuffer->resourceBarrier(ImageTransition{textureImage, ImageState::CopyDest, ImageState::ShaderRead});
     }
-    commandBufferManager->releaseCommandBuffer(commandBuffer, QVector<Image>{stagingImage});
+    commandBufferManager->releaseCommandBuffer(commandBuffer, QVector<Buffer>{stagingBuffer});
 
-    sceneManager->addOrUpdateTexture(textureImageNode->peerId(), textureImage);
+    sharedTextureImage->resource = textureImage;
+    sceneManager->addOrUpdateTexture(textureImageNode->peerId(), sharedTextureImage);
 }
 
 } // Vulkan
@@ -63,7 +63,7 @@ void CameraManager::updateParameters()
         return;
     }
 
-    const QMatrix4x4 worldTransformMatrix = m_activeCamera->worldTransformMatrix.toQMatrix4x4();
+    const QMatrix4x4 worldTransformMatrix = m_activeCamera->worldTransformMatrix().toQMatrix4x4();
 
     m_position = QVector3D(worldTransformMatrix.column(3));
     m_upVector = worldTransformMatrix.mapVector(IdentityUpVector);
@@ -44,7 +44,8 @@ bool DescriptorManager::createDescriptorPool(ResourceClass rclass, uint32_t capa
     Q_ASSERT(!m_pools.contains(rclass));
 
     DescriptorPoolInfo poolInfo;
-    poolInfo.allocated = 0;
+    poolInfo.allocated = QVector<bool>(int(capacity), false);
+    poolInfo.numAllocated = 0;
     poolInfo.capacity = capacity;
 
     Result result;
@@ -138,19 +139,44 @@ void DescriptorManager::destroyAllDescriptorPools()
     m_pools.clear();
 }
 
-DescriptorHandle DescriptorManager::allocateDescriptor(ResourceClass rclass)
+DescriptorHandle DescriptorManager::acquireDescriptor(ResourceClass rclass, uint32_t descriptorIndex)
 {
     Q_ASSERT(m_pools.contains(rclass));
 
+    QMutexLocker lock(&m_allocationMutex);
     auto &pool = m_pools[rclass];
-    uint32_t descriptorIndex = pool.allocated.fetchAndAddAcquire(1);
     if(descriptorIndex >= pool.capacity) {
         // TODO: Implement exponential pool grow via re-allocation.
-        Q_ASSERT_X(false, Q_FUNC_INFO, "Descriptor pool must not be full");
+        qCCritical(logVulkan) << "DescriptorManager: Descriptor pool capacity exceeded:" << descriptorIndex << ">=" << pool.capacity;
+        return DescriptorHandle{ 0, rclass };
+    }
+    if(!pool.allocated[int(descriptorIndex)]) {
+        pool.allocated[int(descriptorIndex)] = true;
+        ++pool.numAllocated;
     }
     return DescriptorHandle{ descriptorIndex + 1, rclass };
 }
 
+void DescriptorManager::releaseDescriptor(DescriptorHandle handle)
+{
+    if(!handle) {
+        return;
+    }
+    Q_ASSERT(m_pools.contains(handle.rclass));
+
+    QMutexLocker lock(&m_allocationMutex);
+    auto &pool = m_pools[handle.rclass];
+    const uint32_t descriptorIndex = handle.index - 1;
+    if(descriptorIndex >= pool.capacity) {
+        // Never acquired: resources rejected by acquireDescriptor() are released like any other.
+        return;
+    }
+    if(pool.allocated[int(descriptorIndex)]) {
+        pool.allocated[int(descriptorIndex)] = false;
+        --pool.numAllocated;
+    }
+}
+
 void DescriptorManager::updateBufferDescriptor(DescriptorHandle handle, const DescriptorBufferInfo &bufferInfo) const
 {
     Q_ASSERT(handle);
@@ -185,6 +211,13 @@ uint32_t DescriptorManager::descriptorPoolCapacity(ResourceClass rclass) const
     return (it != m_pools.end()) ? it->capacity : 0;
 }
 
+uint32_t DescriptorManager::numAllocatedDescriptors(ResourceClass rclass) const
+{
+    QMutexLocker lock(&m_allocationMutex);
+    auto it = m_pools.find(rclass);
+    return (it != m_pools.end()) ? it->numAllocated : 0;
+}
+
 VkDescriptorBindingFlagsEXT DescriptorManager::descriptorBindingFlags(ResourceClass rclass) const
 {
     Q_UNUSED(rclass);
@@ -11,7 +11,8 @@
 #include <renderers/vulkan/descriptors.h>
 
 #include <QMap>
-#include <QAtomicInteger>
+#include <QVector>
+#include <QMutex>
 
 namespace Qt3DRaytrace {
 namespace Vulkan {
@@ -29,12 +30,15 @@ public:
     void destroyDescriptorPool(ResourceClass rclass);
     void destroyAllDescriptorPools();
 
-    DescriptorHandle allocateDescriptor(ResourceClass rclass);
+    // Returns a null handle if descriptorIndex exceeds pool capacity; the resource must then not be exposed to shaders.
+    Q_REQUIRED_RESULT DescriptorHandle acquireDescriptor(ResourceClass rclass, uint32_t descriptorIndex);
+    void releaseDescriptor(DescriptorHandle handle);
     void updateBufferDescriptor(DescriptorHandle handle, const DescriptorBufferInfo &bufferInfo) const;
     void updateImageDescriptor(DescriptorHandle handle, const DescriptorImageInfo &imageInfo) const;
 
     VkDescriptorSet descriptorSet(ResourceClass rclass) const;
     uint32_t descriptorPoolCapacity(ResourceClass rclass) const;
+    uint32_t numAllocatedDescriptors(ResourceClass rclass) const;
     VkDescriptorBindingFlagsEXT descriptorBindingFlags(ResourceClass rclass) const;
 
     Q_DISABLE_COPY(DescriptorManager)
@@ -46,10 +50,12 @@ private:
         VkDescriptorPool pool;
         VkDescriptorSet set;
         VkDescriptorSetLayout layout;
-        QAtomicInteger<uint32_t> allocated;
+        QVector<bool> allocated;
+        uint32_t numAllocated;
         uint32_t capacity;
     };
     QMap<ResourceClass, DescriptorPoolInfo> m_pools;
+    mutable QMutex m_allocationMutex;
 };
 
 } // Vulkan
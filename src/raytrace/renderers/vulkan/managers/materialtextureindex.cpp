@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/managers/materialtextureindex.h>
+
+#include <backend/managers_p.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+void MaterialTextureIndex::updateMaterial(const Raytrace::Material *material)
+{
+    Q_ASSERT(material);
+
+    const QNodeId materialNodeId = material->peerId();
+    removeMaterial(materialNodeId);
+
+    QVector<QNodeId> textureNodeIds;
+    for(const QNodeId &textureNodeId : { material->albedoTextureId(), material->roughnessTextureId(), material->metalnessTextureId() }) {
+        if(!textureNodeId.isNull() && !textureNodeIds.contains(textureNodeId)) {
+            textureNodeIds.append(textureNodeId);
+            m_textureMaterials[textureNodeId].insert(materialNodeId);
+        }
+    }
+    if(!textureNodeIds.isEmpty()) {
+        m_materialTextures.insert(materialNodeId, textureNodeIds);
+    }
+}
+
+void MaterialTextureIndex::removeMaterial(QNodeId materialNodeId)
+{
+    auto it = m_materialTextures.find(materialNodeId);
+    if(it == m_materialTextures.end()) {
+        return;
+    }
+    for(const QNodeId &textureNodeId : qAsConst(*it)) {
+        auto textureIt = m_textureMaterials.find(textureNodeId);
+        if(textureIt != m_textureMaterials.end()) {
+            textureIt->remove(materialNodeId);
+            if(textureIt->isEmpty()) {
+                m_textureMaterials.erase(textureIt);
+            }
+        }
+    }
+    m_materialTextures.erase(it);
+}
+
+QVector<QNodeId> MaterialTextureIndex::updateTextures(Raytrace::NodeManagers *nodeManagers, const QVector<QNodeId> &dirtyNodeIds)
+{
+    Q_ASSERT(nodeManagers);
+
+    QSet<QNodeId> textureNodeIds;
+    for(const QNodeId &nodeId : dirtyNodeIds) {
+        // Dirty node is either a texture node referenced directly by materials or a texture image referenced through texture nodes.
+        if(const Raytrace::AbstractTexture *texture = nodeManagers->textureManager.lookupResource(nodeId)) {
+            trackTextureImage(nodeId, texture->imageId());
+            textureNodeIds.insert(nodeId);
+        }
+        else {
+            if(m_textureImages.contains(nodeId) || m_textureMaterials.contains(nodeId)) {
+                // Destroyed texture node.
+                untrackTextureImage(nodeId);
+                textureNodeIds.insert(nodeId);
+            }
+            auto it = m_imageTextures.constFind(nodeId);
+            if(it != m_imageTextures.constEnd()) {
+                textureNodeIds.unite(*it);
+            }
+        }
+    }
+
+    QSet<QNodeId> materialNodeIds;
+    for(const QNodeId &textureNodeId : qAsConst(textureNodeIds)) {
+        auto it = m_textureMaterials.constFind(textureNodeId);
+        if(it != m_textureMaterials.constEnd()) {
+            materialNodeIds.unite(*it);
+        }
+    }
+
+    QVector<QNodeId> result;
+    result.reserve(materialNodeIds.size());
+    for(const QNodeId &materialNodeId : qAsConst(materialNodeIds)) {
+        if(nodeManagers->materialManager.lookupResource(materialNodeId)) {
+            result.append(materialNodeId);
+        }
+    }
+    return result;
+}
+
+void MaterialTextureIndex::trackTextureImage(QNodeId textureNodeId, QNodeId textureImageNodeId)
+{
+    untrackTextureImage(textureNodeId);
+    if(!textureImageNodeId.isNull()) {
+        m_textureImages.insert(textureNodeId, textureImageNodeId);
+        m_imageTextures[textureImageNodeId].insert(textureNodeId);
+    }
+}
+
+void MaterialTextureIndex::untrackTextureImage(QNodeId textureNodeId)
+{
+    auto it = m_textureImages.find(textureNodeId);
+    if(it == m_textureImages.end()) {
+        return;
+    }
+    auto imageIt = m_imageTextures.find(*it);
+    if(imageIt != m_imageTextures.end()) {
+        imageIt->remove(textureNodeId);
+        if(imageIt->isEmpty()) {
+            m_imageTextures.erase(imageIt);
+        }
+    }
+    m_textureImages.erase(it);
+}
+
+void MaterialTextureIndex::clear()
+{
+    m_materialTextures.clear();
+    m_textureMaterials.clear();
+    m_textureImages.clear();
+    m_imageTextures.clear();
+}
+
+} // Vulkan
+} // Qt3DRaytrace
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <Qt3DCore/QNodeId>
+
+namespace Qt3DRaytrace {
+
+namespace Raytrace {
+struct NodeManagers;
+class Material;
+} // Raytrace
+
+namespace Vulkan {
+
+// Reverse index from textures to materials that reference them.
+// Materials reference texture nodes which in turn reference texture images; packed materials store
+// texture image indices so they need updating whenever either of these changes.
+class MaterialTextureIndex
+{
+public:
+    void updateMaterial(const Raytrace::Material *material);
+    void removeMaterial(Qt3DCore::QNodeId materialNodeId);
+
+    // Updates texture to image mapping for texture nodes among dirtyNodeIds and returns
+    // IDs of existing materials that depend on any of the dirty texture or texture image nodes.
+    QVector<Qt3DCore::QNodeId> updateTextures(Raytrace::NodeManagers *nodeManagers, const QVector<Qt3DCore::QNodeId> &dirtyNodeIds);
+
+    void clear();
+
+private:
+    void trackTextureImage(Qt3DCore::QNodeId textureNodeId, Qt3DCore::QNodeId textureImageNodeId);
+    void untrackTextureImage(Qt3DCore::QNodeId textureNodeId);
+
+    QHash<Qt3DCore::QNodeId, QVector<Qt3DCore::QNodeId>> m_materialTextures;
+    QHash<Qt3DCore::QNodeId, QSet<Qt3DCore::QNodeId>> m_textureMaterials;
+    QHash<Qt3DCore::QNodeId, Qt3DCore::QNodeId> m_textureImages;
+    QHash<Qt3DCore::QNodeId, QSet<Qt3DCore::QNodeId>> m_imageTextures;
+};
+
+} // Vulkan
+} // Qt3DRaytrace
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <QVector>
+#include <Qt3DCore/QNodeId>
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+// Flat open-addressing map from node IDs to resource indices using linear probing.
+// Lookups touch a single contiguous array and never allocate, which makes a const instance
+// safe to query from any number of threads without synchronization.
+class NodeIdIndexMap
+{
+public:
+    static constexpr uint32_t InvalidIndex = ~0u;
+
+    uint32_t value(Qt3DCore::QNodeId nodeId) const
+    {
+        const quint64 key = nodeId.id();
+        if(m_slots.isEmpty() || key == EmptyKey || key == DeletedKey) {
+            return InvalidIndex;
+        }
+        const uint32_t mask = uint32_t(m_slots.size() - 1);
+        const Slot *slots = m_slots.constData();
+        for(uint32_t slotIndex = hash(key) & mask;; slotIndex = (slotIndex + 1) & mask) {
+            const Slot &slot = slots[slotIndex];
+            if(slot.key == key) {
+                return slot.value;
+            }
+            if(slot.key == EmptyKey) {
+                return InvalidIndex;
+            }
+        }
+    }
+
+    bool contains(Qt3DCore::QNodeId nodeId) const
+    {
+        return value(nodeId) != InvalidIndex;
+    }
+
+    void insert(Qt3DCore::QNodeId nodeId, uint32_t index)
+    {
+        const quint64 key = nodeId.id();
+        Q_ASSERT(key != EmptyKey && key != DeletedKey);
+
+        if(2 * (m_numUsedSlots + 1) > m_slots.size()) {
+            rehash(qMax(int(MinCapacity), 4 * (m_numEntries + 1)));
+        }
+
+        const uint32_t mask = uint32_t(m_slots.size() - 1);
+        Slot *slots = m_slots.data();
+        Slot *insertSlot = nullptr;
+        for(uint32_t slotIndex = hash(key) & mask;; slotIndex = (slotIndex + 1) & mask) {
+            Slot &slot = slots[slotIndex];
+            if(slot.key == key) {
+                slot.value = index;
+                return;
+            }
+            if(slot.key == DeletedKey && !insertSlot) {
+                insertSlot = &slot;
+            }
+            else if(slot.key == EmptyKey) {
+                if(!insertSlot) {
+                    insertSlot = &slot;
+                    ++m_numUsedSlots;
+                }
+                break;
+            }
+        }
+        insertSlot->key = key;
+        insertSlot->value = index;
+        ++m_numEntries;
+    }
+
+    bool remove(Qt3DCore::QNodeId nodeId)
+    {
+        const quint64 key = nodeId.id();
+        if(m_slots.isEmpty() || key == EmptyKey || key == DeletedKey) {
+            return false;
+        }
+        const uint32_t mask = uint32_t(m_slots.size() - 1);
+        Slot *slots = m_slots.data();
+        for(uint32_t slotIndex = hash(key) & mask;; slotIndex = (slotIndex + 1) & mask) {
+            Slot &slot = slots[slotIndex];
+            if(slot.key == key) {
+                slot.key = DeletedKey;
+                slot.value = InvalidIndex;
+                --m_numEntries;
+                return true;
+            }
+            if(slot.key == EmptyKey) {
+                return false;
+            }
+        }
+    }
+
+    int size() const { return m_numEntries; }
+    bool isEmpty() const { return m_numEntries == 0; }
+
+    void clear()
+    {
+        m_slots.clear();
+        m_numEntries = 0;
+        m_numUsedSlots = 0;
+    }
+
+private:
+    struct Slot {
+        quint64 key;
+        uint32_t value;
+    };
+
+    static constexpr quint64 EmptyKey = 0;
+    static constexpr quint64 DeletedKey = ~quint64(0);
+    static constexpr int MinCapacity = 16;
+
+    static uint32_t hash(quint64 key)
+    {
+        // 64-bit finalizer from MurmurHash3; node IDs are sequential so low bits alone cluster badly.
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return uint32_t(key);
+    }
+
+    void rehash(int minCapacity)
+    {
+        int capacity = MinCapacity;
+        while(capacity < minCapacity) {
+            capacity *= 2;
+        }
+
+        const QVector<Slot> oldSlots = std::move(m_slots);
+        m_slots = QVector<Slot>(capacity, Slot{EmptyKey, InvalidIndex});
+        m_numUsedSlots = m_numEntries;
+
+        const uint32_t mask = uint32_t(capacity - 1);
+        Slot *slots = m_slots.data();
+        for(const Slot &oldSlot : oldSlots) {
+            if(oldSlot.key == EmptyKey || oldSlot.key == DeletedKey) {
+                continue;
+            }
+            uint32_t slotIndex = hash(oldSlot.key) & mask;
+            while(slots[slotIndex].key != EmptyKey) {
+                slotIndex = (slotIndex + 1) & mask;
+            }
+            slots[slotIndex] = oldSlot;
+        }
+    }
+
+    QVector<Slot> m_slots;
+    int m_numEntries = 0;
+    int m_numUsedSlots = 0;
+};
+
+} // Vulkan
+} // Qt3DRaytrace
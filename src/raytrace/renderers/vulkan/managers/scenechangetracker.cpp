@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/managers/scenechangetracker.h>
+
+#include <backend/managers_p.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+static void markEverythingDirty(SceneUpdate &update)
+{
+    update.resetRenderProgress = true;
+    update.updateWorldTransforms = true;
+    update.updateGeometry = true;
+    update.updateTextures = true;
+    update.updateMaterials = true;
+    update.updateAllMaterials = true;
+    update.updateInstanceBuffer = true;
+    update.updateEmitters = true;
+    update.updateTLAS = true;
+    update.updateActiveCamera = true;
+    update.updateRenderParameters = true;
+}
+
+void SceneChangeTracker::markDirty(DirtySet changes, Raytrace::BackendNode *node)
+{
+    if(!node) {
+        m_allDirty = true;
+        return;
+    }
+    const bool isEntity = (dynamic_cast<Raytrace::Entity*>(node) != nullptr);
+    m_records.append(DirtyRecord{ node->peerId(), changes, isEntity });
+}
+
+void SceneChangeTracker::markAllDirty()
+{
+    m_allDirty = true;
+}
+
+QVector<QNodeId> SceneChangeTracker::entityNodeIds() const
+{
+    const DirtySet entityChanges = DirtyFlag::EntityDirty | DirtyFlag::GeometryDirty | DirtyFlag::MaterialDirty | DirtyFlag::LightDirty;
+
+    QVector<QNodeId> result;
+    result.reserve(m_records.size());
+    for(const DirtyRecord &record : m_records) {
+        if(record.isEntity || (record.changes & entityChanges)) {
+            result.append(record.nodeId);
+        }
+    }
+    return result;
+}
+
+SceneUpdate SceneChangeTracker::classify(Raytrace::NodeManagers *nodeManagers, const SceneEntitySet &entities,
+                                         const SceneEntitySet::Changes &entityChanges, QNodeId activeCameraId,
+                                         QNodeId skyTextureId) const
+{
+    Q_ASSERT(nodeManagers);
+
+    SceneUpdate update;
+    if(m_allDirty) {
+        // Records are still visited below to collect removed nodes.
+        markEverythingDirty(update);
+    }
+
+    const bool hasEmissives = entities.numEmissives() > 0;
+
+    if(entityChanges.renderablesChanged) {
+        update.resetRenderProgress = true;
+        update.updateInstanceBuffer = true;
+        update.updateTLAS = true;
+    }
+    if(entityChanges.emissivesChanged) {
+        update.resetRenderProgress = true;
+        update.updateEmitters = true;
+    }
+
+    for(const DirtyRecord &record : m_records) {
+        if(record.isEntity) {
+            // Structural changes to entities outside of the renderable, emissive or camera hierarchy are invisible.
+            if(isEntityRelevant(nodeManagers, entities, record.nodeId, activeCameraId)) {
+                update.resetRenderProgress = true;
+                update.updateWorldTransforms = true;
+                update.updateInstanceBuffer = true;
+                update.updateTLAS = true;
+                update.updateEmitters |= hasEmissives;
+                update.updateActiveCamera = true;
+                update.updateRenderParameters = true;
+            }
+            continue;
+        }
+
+        if(record.changes == DirtyFlag::AllDirty) {
+            // Render settings: sky, active camera and everything derived from them.
+            markEverythingDirty(update);
+            continue;
+        }
+
+        if(record.changes & DirtyFlag::TransformDirty) {
+            // World transforms are still kept current so that entities becoming relevant later start from valid matrices.
+            update.updateWorldTransforms = true;
+            if(isTransformRelevant(nodeManagers, entities, record.nodeId, activeCameraId)) {
+                update.resetRenderProgress = true;
+                update.updateInstanceBuffer = true;
+                update.updateTLAS = true;
+                update.updateEmitters |= hasEmissives;
+                update.updateRenderParameters = true;
+            }
+        }
+        if(record.changes & DirtyFlag::GeometryDirty) {
+            // Geometry is always loaded, but only geometry renderers referenced by renderables affect the image.
+            // Geometry data nodes are not indexed per entity and are conservatively treated as visible.
+            update.updateGeometry = true;
+            if(!nodeManagers->geometryManager.lookupResource(record.nodeId) && !nodeManagers->geometryRendererManager.lookupResource(record.nodeId)) {
+                update.removedGeometry.append(record.nodeId);
+            }
+            const bool isUnreferencedGeometryRenderer = !entities.isComponentReferenced(record.nodeId)
+                    && nodeManagers->geometryRendererManager.lookupResource(record.nodeId);
+            if(!isUnreferencedGeometryRenderer) {
+                update.resetRenderProgress = true;
+                update.updateInstanceBuffer = true;
+                update.updateTLAS = true;
+                update.updateEmitters |= hasEmissives;
+            }
+        }
+        if(record.changes & DirtyFlag::TextureDirty) {
+            update.updateTextures = true;
+            if(!nodeManagers->textureImageManager.lookupResource(record.nodeId) && !nodeManagers->textureManager.lookupResource(record.nodeId)) {
+                update.removedTextures.append(record.nodeId);
+            }
+            // Only materials referencing this texture are updated, see MaterialTextureIndex.
+            update.dirtyTextures.append(record.nodeId);
+            // Emitters reference only the sky texture directly.
+            if(isSkyTexture(nodeManagers, record.nodeId, skyTextureId)) {
+                update.resetRenderProgress = true;
+                update.updateEmitters = true;
+            }
+        }
+        if(record.changes & DirtyFlag::MaterialDirty) {
+            update.updateMaterials = true;
+            if(!nodeManagers->materialManager.lookupResource(record.nodeId)) {
+                update.removedMaterials.append(record.nodeId);
+            }
+            if(entities.isComponentReferencedByRenderable(record.nodeId)) {
+                // Newly created materials are assigned their index only once uploaded.
+                update.resetRenderProgress = true;
+                update.updateInstanceBuffer = true;
+            }
+            if(entities.isComponentReferencedByEmissive(record.nodeId)) {
+                update.updateEmitters = true;
+            }
+        }
+        if(record.changes & DirtyFlag::LightDirty) {
+            if(entities.isComponentReferenced(record.nodeId)) {
+                update.resetRenderProgress = true;
+                update.updateEmitters = true;
+            }
+        }
+        if(record.changes & DirtyFlag::CameraDirty) {
+            update.updateActiveCamera = true;
+            update.updateRenderParameters = true;
+            const Raytrace::Entity *activeCamera = nodeManagers->entityManager.lookupResource(activeCameraId);
+            if(!activeCamera || activeCamera->cameraLensComponentId() == record.nodeId) {
+                update.resetRenderProgress = true;
+            }
+        }
+    }
+    return update;
+}
+
+void SceneChangeTracker::clear()
+{
+    m_records.clear();
+    m_allDirty = false;
+}
+
+bool SceneChangeTracker::isEntityRelevant(Raytrace::NodeManagers *nodeManagers, const SceneEntitySet &entities,
+                                          QNodeId entityNodeId, QNodeId activeCameraId) const
+{
+    const Raytrace::Entity *entity = nodeManagers->entityManager.lookupResource(entityNodeId);
+    if(!entity) {
+        // Removal of renderable or emissive entities is reported through membership changes.
+        return false;
+    }
+
+    QVector<const Raytrace::Entity*> stack;
+    stack.append(entity);
+    while(!stack.isEmpty()) {
+        const Raytrace::Entity *node = stack.takeLast();
+        const QNodeId nodeId = node->peerId();
+        if(nodeId == activeCameraId || entities.isRenderable(nodeId) || entities.isEmissive(nodeId)) {
+            return true;
+        }
+        for(const Raytrace::HEntity &childHandle : node->childrenHandles()) {
+            if(const Raytrace::Entity *child = childHandle.data()) {
+                stack.append(child);
+            }
+        }
+    }
+    return false;
+}
+
+bool SceneChangeTracker::isTransformRelevant(Raytrace::NodeManagers *nodeManagers, const SceneEntitySet &entities,
+                                             QNodeId transformNodeId, QNodeId activeCameraId) const
+{
+    const Raytrace::WorldTransformManager &worldTransformManager = nodeManagers->worldTransformManager;
+    if(worldTransformManager.isHierarchyDirty()) {
+        // Transform to entity mapping is rebuilt on the next world transform update.
+        return true;
+    }
+    for(const Raytrace::HEntity &entityHandle : worldTransformManager.transformEntities(transformNodeId)) {
+        const Raytrace::Entity *entity = entityHandle.data();
+        if(entity && isEntityRelevant(nodeManagers, entities, entity->peerId(), activeCameraId)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SceneChangeTracker::isSkyTexture(Raytrace::NodeManagers *nodeManagers, QNodeId textureNodeId, QNodeId skyTextureId) const
+{
+    if(skyTextureId.isNull()) {
+        return false;
+    }
+    if(textureNodeId == skyTextureId) {
+        return true;
+    }
+    // Dirty node might also be the texture image referenced by the sky texture.
+    const Raytrace::AbstractTexture *skyTexture = nodeManagers->textureManager.lookupResource(skyTextureId);
+    return skyTexture && skyTexture->imageId() == textureNodeId;
+}
+
+} // Vulkan
+} // Qt3DRaytrace
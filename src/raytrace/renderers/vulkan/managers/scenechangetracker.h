@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/vulkan/managers/sceneentityset.h>
+
+#include <backend/abstractrenderer_p.h>
+
+#include <QVector>
+#include <Qt3DCore/QNodeId>
+
+namespace Qt3DRaytrace {
+
+namespace Raytrace {
+struct NodeManagers;
+} // Raytrace
+
+namespace Vulkan {
+
+// Minimal set of work derived from the dirty records accumulated since the previous frame.
+struct SceneUpdate
+{
+    bool resetRenderProgress = false;
+    bool updateWorldTransforms = false;
+    bool updateGeometry = false;
+    bool updateTextures = false;
+    bool updateMaterials = false;
+    bool updateAllMaterials = false;
+    bool updateInstanceBuffer = false;
+    bool updateEmitters = false;
+    bool updateTLAS = false;
+    bool updateActiveCamera = false;
+    bool updateRenderParameters = false;
+
+    // Texture and texture image nodes whose dependent materials need to be repacked.
+    // Accumulation is reset only once these are resolved to materials referenced by renderables.
+    QVector<Qt3DCore::QNodeId> dirtyTextures;
+
+    // Backend nodes destroyed since the previous frame whose scene resources must be released.
+    QVector<Qt3DCore::QNodeId> removedGeometry;
+    QVector<Qt3DCore::QNodeId> removedTextures;
+    QVector<Qt3DCore::QNodeId> removedMaterials;
+};
+
+// Records which backend nodes changed and classifies each change as either affecting
+// the rendered image (requiring accumulation to restart) or being invisible to the renderer.
+class SceneChangeTracker
+{
+public:
+    using DirtySet = Raytrace::AbstractRenderer::DirtySet;
+    using DirtyFlag = Raytrace::AbstractRenderer::DirtyFlag;
+
+    void markDirty(DirtySet changes, Raytrace::BackendNode *node);
+    void markAllDirty();
+
+    bool isEmpty() const { return m_records.isEmpty() && !m_allDirty; }
+
+    // Nodes whose changes may alter renderable or emissive membership of entities.
+    QVector<Qt3DCore::QNodeId> entityNodeIds() const;
+
+    SceneUpdate classify(Raytrace::NodeManagers *nodeManagers, const SceneEntitySet &entities,
+                         const SceneEntitySet::Changes &entityChanges, Qt3DCore::QNodeId activeCameraId,
+                         Qt3DCore::QNodeId skyTextureId) const;
+
+    void clear();
+
+private:
+    struct DirtyRecord {
+        Qt3DCore::QNodeId nodeId;
+        DirtySet changes;
+        bool isEntity;
+    };
+
+    bool isEntityRelevant(Raytrace::NodeManagers *nodeManagers, const SceneEntitySet &entities,
+                          Qt3DCore::QNodeId entityNodeId, Qt3DCore::QNodeId activeCameraId) const;
+    bool isTransformRelevant(Raytrace::NodeManagers *nodeManagers, const SceneEntitySet &entities,
+                             Qt3DCore::QNodeId transformNodeId, Qt3DCore::QNodeId activeCameraId) const;
+    bool isSkyTexture(Raytrace::NodeManagers *nodeManagers, Qt3DCore::QNodeId textureNodeId, Qt3DCore::QNodeId skyTextureId) const;
+
+    QVector<DirtyRecord> m_records;
+    bool m_allDirty = true;
+};
+
+} // Vulkan
+} // Qt3DRaytrace
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/managers/sceneentityset.h>
+
+#include <backend/managers_p.h>
+
+using namespace Qt3DCore;
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+SceneEntitySet::Changes SceneEntitySet::update(Raytrace::EntityManager *entityManager, const QVector<QNodeId> &dirtyNodeIds)
+{
+    Q_ASSERT(entityManager);
+
+    // Dirty nodes are either entities themselves or components whose changes may affect
+    // renderable or emissive status of every entity referencing them.
+    QSet<QNodeId> dirtyEntityIds;
+    for(const QNodeId &nodeId : dirtyNodeIds) {
+        if(entityManager->lookupResource(nodeId) || m_entityComponents.contains(nodeId)) {
+            dirtyEntityIds.insert(nodeId);
+        }
+        else {
+            auto it = m_componentEntities.constFind(nodeId);
+            if(it != m_componentEntities.constEnd()) {
+                dirtyEntityIds.unite(*it);
+            }
+        }
+    }
+
+    Changes changes;
+    for(const QNodeId &entityId : qAsConst(dirtyEntityIds)) {
+        updateEntity(entityManager, entityId, changes);
+    }
+    return changes;
+}
+
+void SceneEntitySet::updateEntity(Raytrace::EntityManager *entityManager, QNodeId entityNodeId, Changes &changes)
+{
+    untrackEntityComponents(entityNodeId);
+
+    const Raytrace::Entity *entity = entityManager->lookupResource(entityNodeId);
+    if(!entity) {
+        changes.renderablesChanged |= (m_renderables.removeResource(entityNodeId) != ~0u);
+        changes.emissivesChanged |= (m_emissives.removeResource(entityNodeId) != ~0u);
+        return;
+    }
+
+    const EntityComponents components = {
+        entity->geometryRendererComponentId(),
+        entity->materialComponentId(),
+        entity->distantLightComponentId(),
+    };
+    trackEntityComponents(entityNodeId, components);
+
+    const bool isRenderable = entity->isRenderable();
+    if(isRenderable && !m_renderables.contains(entityNodeId)) {
+        m_renderables.addResource(entityNodeId, entity->handle());
+        changes.renderablesChanged = true;
+    }
+    else if(!isRenderable) {
+        changes.renderablesChanged |= (m_renderables.removeResource(entityNodeId) != ~0u);
+    }
+
+    const bool isEmissive = entity->isEmissive();
+    if(isEmissive && !m_emissives.contains(entityNodeId)) {
+        m_emissives.addResource(entityNodeId, entity->handle());
+        changes.emissivesChanged = true;
+    }
+    else if(!isEmissive) {
+        changes.emissivesChanged |= (m_emissives.removeResource(entityNodeId) != ~0u);
+    }
+}
+
+bool SceneEntitySet::isComponentReferencedByRenderable(QNodeId componentId) const
+{
+    const auto it = m_componentEntities.constFind(componentId);
+    if(it != m_componentEntities.constEnd()) {
+        for(const QNodeId &entityId : *it) {
+            if(m_renderables.contains(entityId)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SceneEntitySet::isComponentReferencedByEmissive(QNodeId componentId) const
+{
+    const auto it = m_componentEntities.constFind(componentId);
+    if(it != m_componentEntities.constEnd()) {
+        for(const QNodeId &entityId : *it) {
+            if(m_emissives.contains(entityId)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SceneEntitySet::isComponentReferenced(QNodeId componentId) const
+{
+    return m_componentEntities.contains(componentId);
+}
+
+void SceneEntitySet::trackEntityComponents(QNodeId entityNodeId, const EntityComponents &components)
+{
+    if(components.geometryRendererId.isNull() && components.materialId.isNull() && components.distantLightId.isNull()) {
+        return;
+    }
+    m_entityComponents.insert(entityNodeId, components);
+    for(const QNodeId &componentId : { components.geometryRendererId, components.materialId, components.distantLightId }) {
+        if(!componentId.isNull()) {
+            m_componentEntities[componentId].insert(entityNodeId);
+        }
+    }
+}
+
+void SceneEntitySet::untrackEntityComponents(QNodeId entityNodeId)
+{
+    auto it = m_entityComponents.find(entityNodeId);
+    if(it == m_entityComponents.end()) {
+        return;
+    }
+    for(const QNodeId &componentId : { it->geometryRendererId, it->materialId, it->distantLightId }) {
+        auto componentIt = m_componentEntities.find(componentId);
+        if(componentIt != m_componentEntities.end()) {
+            componentIt->remove(entityNodeId);
+            if(componentIt->isEmpty()) {
+                m_componentEntities.erase(componentIt);
+            }
+        }
+    }
+    m_entityComponents.erase(it);
+}
+
+void SceneEntitySet::clear()
+{
+    m_renderables.clear();
+    m_emissives.clear();
+    m_entityComponents.clear();
+    m_componentEntities.clear();
+}
+
+} // Vulkan
+} // Qt3DRaytrace
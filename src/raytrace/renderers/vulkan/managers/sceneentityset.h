@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/vulkan/managers/sceneresourceset.h>
+
+#include <backend/handles_p.h>
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <Qt3DCore/QNodeId>
+
+namespace Qt3DRaytrace {
+
+namespace Raytrace {
+class EntityManager;
+} // Raytrace
+
+namespace Vulkan {
+
+// Incrementally maintained sets of renderable and emissive entities.
+// Entities keep their slot for as long as they remain members; released slots hold null handles
+// and are reused by subsequently added entities.
+class SceneEntitySet
+{
+public:
+    struct Changes {
+        bool renderablesChanged = false;
+        bool emissivesChanged = false;
+    };
+
+    Changes update(Raytrace::EntityManager *entityManager, const QVector<Qt3DCore::QNodeId> &dirtyNodeIds);
+    void clear();
+
+    bool isRenderable(Qt3DCore::QNodeId entityNodeId) const { return m_renderables.contains(entityNodeId); }
+    bool isEmissive(Qt3DCore::QNodeId entityNodeId) const { return m_emissives.contains(entityNodeId); }
+
+    bool isComponentReferencedByRenderable(Qt3DCore::QNodeId componentId) const;
+    bool isComponentReferencedByEmissive(Qt3DCore::QNodeId componentId) const;
+    bool isComponentReferenced(Qt3DCore::QNodeId componentId) const;
+
+    const QVector<Raytrace::HEntity> &renderables() const { return m_renderables.resources(); }
+    const QVector<Raytrace::HEntity> &emissives() const { return m_emissives.resources(); }
+
+    uint32_t lookupRenderableIndex(Qt3DCore::QNodeId entityNodeId) const { return m_renderables.lookupIndex(entityNodeId); }
+    uint32_t lookupEmissiveIndex(Qt3DCore::QNodeId entityNodeId) const { return m_emissives.lookupIndex(entityNodeId); }
+
+    uint32_t numRenderables() const { return uint32_t(m_renderables.count()); }
+    uint32_t numEmissives() const { return uint32_t(m_emissives.count()); }
+
+private:
+    struct EntityComponents {
+        Qt3DCore::QNodeId geometryRendererId;
+        Qt3DCore::QNodeId materialId;
+        Qt3DCore::QNodeId distantLightId;
+    };
+
+    void updateEntity(Raytrace::EntityManager *entityManager, Qt3DCore::QNodeId entityNodeId, Changes &changes);
+    void trackEntityComponents(Qt3DCore::QNodeId entityNodeId, const EntityComponents &components);
+    void untrackEntityComponents(Qt3DCore::QNodeId entityNodeId);
+
+    SceneResourceSet<Raytrace::HEntity> m_renderables;
+    SceneResourceSet<Raytrace::HEntity> m_emissives;
+
+    QHash<Qt3DCore::QNodeId, EntityComponents> m_entityComponents;
+    QHash<Qt3DCore::QNodeId, QSet<Qt3DCore::QNodeId>> m_componentEntities;
+};
+
+} // Vulkan
+} // Qt3DRaytrace
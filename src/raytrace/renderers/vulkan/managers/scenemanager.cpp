@@ -13,9 +13,18 @@
 namespace Qt3DRaytrace {
 namespace Vulkan {
 
+namespace Config {
+
+// Minimum number of unused slots in a scene resource table before it is considered for compaction.
+constexpr int CompactionMinFreeSlots = 64;
+
+} // Config
+
 SceneManager::SceneManager(Renderer *renderer)
     : m_renderer(renderer)
     , m_tlasInstanceCount(0)
+    , m_instanceBufferCapacity(0)
+    , m_materialBufferCapacity(0)
 {
     Q_ASSERT(m_renderer);
 }
@@ -25,38 +34,173 @@ SceneManager::~SceneManager()
     destroyResources();
 }
 
-void SceneManager::addOrUpdateGeometry(Qt3DCore::QNodeId geometryNodeId, const Geometry &geometry)
+template<typename T, typename DataT>
+QSharedPointer<SceneManager::SharedResource<T, DataT>> SceneManager::acquireSharedResource(QHash<SharedResourceKey, QWeakPointer<SharedResource<T, DataT>>> &entries,
+                                                                                           const SharedResourceKey &key, const DataT &data, void (Device::*destroy)(T&))
+{
+    QMutexLocker lock(&m_sharedResourcesMutex);
+
+    auto it = entries.find(key);
+    if(it != entries.end()) {
+        if(QSharedPointer<SharedResource<T, DataT>> entry = it->toStrongRef()) {
+            return entry;
+        }
+    }
+
+    // Drop entries of resources no longer referenced by any slot before adding a new one.
+    for(auto expiredIt = entries.begin(); expiredIt != entries.end();) {
+        if(expiredIt->isNull()) {
+            expiredIt = entries.erase(expiredIt);
+        }
+        else {
+            ++expiredIt;
+        }
+    }
+
+    Device *device = m_renderer->device();
+    Q_ASSERT(device);
+
+    QSharedPointer<SharedResource<T, DataT>> entry(new SharedResource<T, DataT>, [device, destroy](SharedResource<T, DataT> *entry) {
+        (device->*destroy)(entry->resource);
+        delete entry;
+    });
+    entry->data = data;
+    entries.insert(key, entry);
+    return entry;
+}
+
+SceneManager::SharedGeometryPtr SceneManager::acquireSharedGeometry(const QGeometryData &data)
+{
+    const SharedResourceKey key(quintptr(data.vertexData()), quintptr(data.faceData()));
+    return acquireSharedResource(m_sharedGeometry, key, data, &Device::destroyGeometry);
+}
+
+SceneManager::SharedImagePtr SceneManager::acquireSharedTexture(const QImageData &data)
+{
+    const SharedResourceKey key(quintptr(data.constBits()), data.sizeInBytes());
+    return acquireSharedResource(m_sharedTextures, key, data, &Device::destroyImage);
+}
+
+void SceneManager::addOrUpdateGeometry(Qt3DCore::QNodeId geometryNodeId, const SharedGeometryPtr &geometry)
 {
     DescriptorManager *descriptorManager = m_renderer->descriptorManager();
     Q_ASSERT(descriptorManager);
 
-    QWriteLocker lock(&m_rwlock);
+    SceneSnapshotTable<Geometry>::Writer writer(m_geometry, SceneSnapshotTable<Geometry>::Writer::PublishDeferred);
 
-    DescriptorHandle geometryAttributesDescriptor = descriptorManager->allocateDescriptor(ResourceClass::AttributeBuffer);
-    DescriptorHandle geometryIndicesDescriptor = descriptorManager->allocateDescriptor(ResourceClass::IndexBuffer);
-    descriptorManager->updateBufferDescriptor(geometryAttributesDescriptor, DescriptorBufferInfo(geometry.attributes));
-    descriptorManager->updateBufferDescriptor(geometryIndicesDescriptor, DescriptorBufferInfo(geometry.indices));
+    // Previous geometry may still be in use by frames in flight, so updated geometry is assigned a new slot.
+    retireGeometry(writer, geometryNodeId);
+    const uint32_t geometryIndex = writer.addResource(geometryNodeId, geometry->resource);
+    {
+        QWriteLocker lock(&m_rwlock);
+        m_nodeGeometry.insert(geometryNodeId, geometry);
+    }
 
-    m_geometry.addOrUpdateResource(geometryNodeId, geometry);
+    // Descriptor indices always match geometry indices.
+    DescriptorHandle geometryAttributesDescriptor = descriptorManager->acquireDescriptor(ResourceClass::AttributeBuffer, geometryIndex);
+    DescriptorHandle geometryIndicesDescriptor = descriptorManager->acquireDescriptor(ResourceClass::IndexBuffer, geometryIndex);
+    if(!geometryAttributesDescriptor || !geometryIndicesDescriptor) {
+        // Commands referencing rejected geometry may already be submitted, so it is destroyed like removed geometry.
+        qCWarning(logVulkan) << "Geometry" << geometryNodeId << "rejected: out of geometry descriptors";
+        retireGeometry(writer, geometryNodeId);
+        return;
+    }
+    descriptorManager->updateBufferDescriptor(geometryAttributesDescriptor, DescriptorBufferInfo(geometry->resource.attributes));
+    descriptorManager->updateBufferDescriptor(geometryIndicesDescriptor, DescriptorBufferInfo(geometry->resource.indices));
 }
 
 void SceneManager::addOrUpdateMaterial(Qt3DCore::QNodeId materialNodeId, const Material &material)
 {
-    QWriteLocker lock(&m_rwlock);
-    m_materials.addOrUpdateResource(materialNodeId, material);
+    SceneSnapshotTable<Material>::Writer writer(m_materials);
+    writer.addOrUpdateResource(materialNodeId, material);
+}
+
+QVector<uint32_t> SceneManager::addOrUpdateMaterials(const QVector<Qt3DCore::QNodeId> &materialNodeIds, const QVector<Material> &materials)
+{
+    Q_ASSERT(materialNodeIds.size() == materials.size());
+
+    QVector<uint32_t> materialIndices;
+    materialIndices.reserve(materialNodeIds.size());
+
+    SceneSnapshotTable<Material>::Writer writer(m_materials);
+    for(int i=0; i < materialNodeIds.size(); ++i) {
+        materialIndices.append(writer.addOrUpdateResource(materialNodeIds[i], materials[i]));
+    }
+    return materialIndices;
 }
 
-void SceneManager::addOrUpdateTexture(Qt3DCore::QNodeId textureImageNodeId, const Image &textureImage)
+void SceneManager::addOrUpdateTexture(Qt3DCore::QNodeId textureImageNodeId, const SharedImagePtr &textureImage)
 {
     DescriptorManager *descriptorManager = m_renderer->descriptorManager();
     Q_ASSERT(descriptorManager);
 
-    QWriteLocker lock(&m_rwlock);
+    SceneSnapshotTable<Image>::Writer writer(m_textures, SceneSnapshotTable<Image>::Writer::PublishDeferred);
+
+    retireTexture(writer, textureImageNodeId);
+    const uint32_t textureIndex = writer.addResource(textureImageNodeId, textureImage->resource);
+    {
+        QWriteLocker lock(&m_rwlock);
+        m_nodeTextures.insert(textureImageNodeId, textureImage);
+    }
 
-    DescriptorHandle textureImageDescriptor = descriptorManager->allocateDescriptor(ResourceClass::TextureImage);
-    descriptorManager->updateImageDescriptor(textureImageDescriptor, DescriptorImageInfo(textureImage.view, ImageState::ShaderRead));
+    DescriptorHandle textureImageDescriptor = descriptorManager->acquireDescriptor(ResourceClass::TextureImage, textureIndex);
+    if(!textureImageDescriptor) {
+        qCWarning(logVulkan) << "Texture image" << textureImageNodeId << "rejected: out of texture descriptors";
+        retireTexture(writer, textureImageNodeId);
+        return;
+    }
+    descriptorManager->updateImageDescriptor(textureImageDescriptor, DescriptorImageInfo(textureImage->resource.view, ImageState::ShaderRead));
+}
 
-    m_textures.addOrUpdateResource(textureImageNodeId, textureImage);
+void SceneManager::removeGeometry(Qt3DCore::QNodeId geometryNodeId)
+{
+    SceneSnapshotTable<Geometry>::Writer writer(m_geometry);
+    retireGeometry(writer, geometryNodeId);
+}
+
+void SceneManager::removeMaterial(Qt3DCore::QNodeId materialNodeId)
+{
+    // Material buffer is updated in place by copies ordered after reads of frames submitted earlier, so the slot can be reused immediately.
+    SceneSnapshotTable<Material>::Writer writer(m_materials);
+    writer.removeResource(materialNodeId);
+}
+
+void SceneManager::removeTexture(Qt3DCore::QNodeId textureImageNodeId)
+{
+    SceneSnapshotTable<Image>::Writer writer(m_textures);
+    retireTexture(writer, textureImageNodeId);
+}
+
+void SceneManager::publishGeometry()
+{
+    m_geometry.publishPending();
+}
+
+void SceneManager::publishTextures()
+{
+    m_textures.publishPending();
+}
+
+void SceneManager::retireGeometry(SceneSnapshotTable<Geometry>::Writer &writer, Qt3DCore::QNodeId geometryNodeId)
+{
+    RetiredSlot<SharedGeometryPtr> slot;
+    slot.index = writer.removeResource(geometryNodeId, nullptr, false);
+    if(slot.index != ~0u) {
+        QWriteLocker lock(&m_rwlock);
+        slot.shared = m_nodeGeometry.take(geometryNodeId);
+        m_retiredGeometry.retire(slot, m_renderer->numConcurrentFrames());
+    }
+}
+
+void SceneManager::retireTexture(SceneSnapshotTable<Image>::Writer &writer, Qt3DCore::QNodeId textureImageNodeId)
+{
+    RetiredSlot<SharedImagePtr> slot;
+    slot.index = writer.removeResource(textureImageNodeId, nullptr, false);
+    if(slot.index != ~0u) {
+        QWriteLocker lock(&m_rwlock);
+        slot.shared = m_nodeTextures.take(textureImageNodeId);
+        m_retiredTextures.retire(slot, m_renderer->numConcurrentFrames());
+    }
 }
 
 void SceneManager::updateEmitters(QVector<Emitter> &emitters)
@@ -72,10 +216,11 @@ void SceneManager::updateSceneTLAS(const AccelerationStructure &tlas, uint32_t i
     m_tlasInstanceCount = instanceCount;
 }
 
-void SceneManager::updateMaterialBuffer(const Buffer &buffer)
+void SceneManager::updateMaterialBuffer(const Buffer &buffer, uint32_t capacity)
 {
     QWriteLocker lock(&m_rwlock);
     m_materialBuffer.update(buffer, m_renderer->numConcurrentFrames());
+    m_materialBufferCapacity = capacity;
 }
 
 void SceneManager::updateEmitterBuffer(const Buffer &buffer)
@@ -84,57 +229,65 @@ void SceneManager::updateEmitterBuffer(const Buffer &buffer)
     m_emitterBuffer.update(buffer, m_renderer->numConcurrentFrames());
 }
 
-void SceneManager::updateInstanceBuffer(const Buffer &buffer)
+void SceneManager::updateInstanceBuffer(const Buffer &buffer, uint32_t capacity)
 {
     QWriteLocker lock(&m_rwlock);
     m_instanceBuffer.update(buffer, m_renderer->numConcurrentFrames());
+    m_instanceBufferCapacity = capacity;
 }
 
 uint32_t SceneManager::lookupGeometry(Qt3DCore::QNodeId geometryNodeId, Geometry &geometry) const
 {
-    QReadLocker lock(&m_rwlock);
+    // NO LOCK: Wait-free snapshot read.
     return m_geometry.lookupResource(geometryNodeId, geometry);
 }
 
 uint32_t SceneManager::lookupGeometryIndex(Qt3DCore::QNodeId geometryNodeId) const
 {
-    QReadLocker lock(&m_rwlock);
+    // NO LOCK: Wait-free snapshot read.
     return m_geometry.lookupIndex(geometryNodeId);
 }
 
 uint32_t SceneManager::lookupMaterial(Qt3DCore::QNodeId materialNodeId, Material &material) const
 {
-    QReadLocker lock(&m_rwlock);
+    // NO LOCK: Wait-free snapshot read.
     return m_materials.lookupResource(materialNodeId, material);
 }
 
 uint32_t SceneManager::lookupMaterialIndex(Qt3DCore::QNodeId materialNodeId) const
 {
-    QReadLocker lock(&m_rwlock);
+    // NO LOCK: Wait-free snapshot read.
     return m_materials.lookupIndex(materialNodeId);
 }
 
 uint32_t SceneManager::lookupTextureIndex(Qt3DCore::QNodeId textureImageNodeId) const
 {
-    QReadLocker lock(&m_rwlock);
+    // NO LOCK: Wait-free snapshot read.
     return m_textures.lookupIndex(textureImageNodeId);
 }
 
-void SceneManager::gatherEntities(Raytrace::EntityManager *entityManager)
+SceneResourceHandle SceneManager::lookupGeometryHandle(Qt3DCore::QNodeId geometryNodeId) const
 {
-    Q_ASSERT(entityManager);
+    // NO LOCK: Wait-free snapshot read.
+    return m_geometry.lookupHandle(geometryNodeId);
+}
 
-    // NO LOCK: Access from render/aspect thread only.
-    m_renderables.clear();
-    m_emissives.clear();
-    for(const auto &entity : entityManager->activeHandles()) {
-        if(entity->isRenderable()) {
-            m_renderables.addResource(entity->peerId(), entity->handle());
-        }
-        if(entity->isEmissive()) {
-            m_emissives.addResource(entity->peerId(), entity->handle());
-        }
-    }
+bool SceneManager::resolveGeometryHandle(const SceneResourceHandle &handle, Geometry &geometry) const
+{
+    // NO LOCK: Wait-free snapshot read.
+    return m_geometry.resolveHandle(handle, geometry);
+}
+
+SceneEntitySet::Changes SceneManager::updateEntities(Raytrace::EntityManager *entityManager, const QVector<Qt3DCore::QNodeId> &dirtyNodeIds)
+{
+    // NO LOCK: Access from aspect thread only, while no jobs are running.
+    return m_entities.update(entityManager, dirtyNodeIds);
+}
+
+const SceneEntitySet &SceneManager::entities() const
+{
+    // NO LOCK: Access from aspect thread only.
+    return m_entities;
 }
 
 void SceneManager::updateRetiredResources()
@@ -144,6 +297,19 @@ void SceneManager::updateRetiredResources()
     m_instanceBuffer.updateRetiredTTL();
     m_materialBuffer.updateRetiredTTL();
     m_emitterBuffer.updateRetiredTTL();
+
+    // Retired slots are also appended to by jobs.
+    QWriteLocker lock(&m_rwlock);
+    m_retiredGeometry.updateRetiredTTL();
+    m_retiredTextures.updateRetiredTTL();
+}
+
+void SceneManager::reclaimRetiredSnapshots()
+{
+    // Must only be called between aspect frames when no job can hold a reference to a retired snapshot.
+    m_geometry.reclaimRetiredSnapshots();
+    m_materials.reclaimRetiredSnapshots();
+    m_textures.reclaimRetiredSnapshots();
 }
 
 void SceneManager::destroyResources()
@@ -167,6 +333,8 @@ void SceneManager::destroyResources()
         }
         m_instanceBuffer.reset();
     }
+    m_instanceBufferCapacity = 0;
+    m_instancePacker.clear();
     if(m_materialBuffer.resource) {
         device->destroyBuffer(m_materialBuffer.resource);
         for(auto &retiredBuffer : m_materialBuffer.retired()) {
@@ -174,6 +342,7 @@ void SceneManager::destroyResources()
         }
         m_materialBuffer.reset();
     }
+    m_materialBufferCapacity = 0;
     if(m_emitterBuffer.resource) {
         device->destroyBuffer(m_emitterBuffer.resource);
         for(auto &retiredBuffer : m_emitterBuffer.retired()) {
@@ -182,12 +351,15 @@ void SceneManager::destroyResources()
         m_emitterBuffer.reset();
     }
 
-    for(auto &geometry : m_geometry.takeResources()) {
-        device->destroyGeometry(geometry);
-    }
-    for(auto &texture : m_textures.takeResources()) {
-        device->destroyImage(texture);
-    }
+    // Shared resources are destroyed as the last slots referencing them are released.
+    m_geometry.takeResources();
+    m_nodeGeometry.clear();
+    m_retiredGeometry.reset();
+
+    m_textures.takeResources();
+    m_nodeTextures.clear();
+    m_retiredTextures.reset();
+
     m_materials.clear();
 }
 
@@ -201,6 +373,8 @@ void SceneManager::destroyExpiredResources()
     QVarLengthArray<Buffer> expiredInstanceBuffers = m_instanceBuffer.takeExpired();
     QVarLengthArray<Buffer> expiredMaterialBuffers = m_materialBuffer.takeExpired();
     QVarLengthArray<Buffer> expiredEmitterBuffers = m_emitterBuffer.takeExpired();
+    QVarLengthArray<RetiredSlot<SharedGeometryPtr>> expiredGeometry = m_retiredGeometry.takeExpired();
+    QVarLengthArray<RetiredSlot<SharedImagePtr>> expiredTextures = m_retiredTextures.takeExpired();
     lock.unlock();
 
     for(auto &tlas : expiredTLAS) {
@@ -215,6 +389,87 @@ void SceneManager::destroyExpiredResources()
     for(auto &buffer : expiredEmitterBuffers) {
         device->destroyBuffer(buffer);
     }
+
+    if(!expiredGeometry.isEmpty()) {
+        DescriptorManager *descriptorManager = m_renderer->descriptorManager();
+        SceneSnapshotTable<Geometry>::Writer writer(m_geometry);
+        for(auto &slot : expiredGeometry) {
+            // Destroys device resources unless other slots still share them.
+            slot.shared.reset();
+            descriptorManager->releaseDescriptor(DescriptorHandle{ slot.index + 1, ResourceClass::AttributeBuffer });
+            descriptorManager->releaseDescriptor(DescriptorHandle{ slot.index + 1, ResourceClass::IndexBuffer });
+            writer.releaseIndex(slot.index);
+        }
+    }
+    if(!expiredTextures.isEmpty()) {
+        DescriptorManager *descriptorManager = m_renderer->descriptorManager();
+        SceneSnapshotTable<Image>::Writer writer(m_textures);
+        for(auto &slot : expiredTextures) {
+            slot.shared.reset();
+            descriptorManager->releaseDescriptor(DescriptorHandle{ slot.index + 1, ResourceClass::TextureImage });
+            writer.releaseIndex(slot.index);
+        }
+    }
+}
+
+SceneManager::CompactionResult SceneManager::compactResources()
+{
+    DescriptorManager *descriptorManager = m_renderer->descriptorManager();
+    Q_ASSERT(descriptorManager);
+
+    // Compaction is only worthwhile once a significant fraction of slots is unused.
+    auto shouldCompact = [](int numFreeIndices, int numResources) {
+        return numFreeIndices >= Config::CompactionMinFreeSlots && numFreeIndices * 2 >= numResources;
+    };
+
+    CompactionResult result;
+    {
+        SceneSnapshotTable<Geometry>::Writer writer(m_geometry);
+        if(shouldCompact(m_geometry.numFreeIndices(), writer.working().resources.size())) {
+            const auto moves = writer.compact(true);
+            QWriteLocker lock(&m_rwlock);
+            for(const auto &move : moves) {
+                const Geometry &geometry = writer.working().resources[int(move.to)];
+                DescriptorHandle geometryAttributesDescriptor = descriptorManager->acquireDescriptor(ResourceClass::AttributeBuffer, move.to);
+                DescriptorHandle geometryIndicesDescriptor = descriptorManager->acquireDescriptor(ResourceClass::IndexBuffer, move.to);
+                // Resources only ever move to lower slots, which are always within descriptor pool capacity.
+                Q_ASSERT(geometryAttributesDescriptor && geometryIndicesDescriptor);
+                descriptorManager->updateBufferDescriptor(geometryAttributesDescriptor, DescriptorBufferInfo(geometry.attributes));
+                descriptorManager->updateBufferDescriptor(geometryIndicesDescriptor, DescriptorBufferInfo(geometry.indices));
+
+                // Vacated slot only keeps its descriptors alive for frames in flight; resources have moved.
+                RetiredSlot<SharedGeometryPtr> slot;
+                slot.index = move.from;
+                m_retiredGeometry.retire(slot, m_renderer->numConcurrentFrames());
+            }
+            result.geometryCompacted = !moves.isEmpty();
+        }
+    }
+    {
+        SceneSnapshotTable<Image>::Writer writer(m_textures);
+        if(shouldCompact(m_textures.numFreeIndices(), writer.working().resources.size())) {
+            const auto moves = writer.compact(true);
+            QWriteLocker lock(&m_rwlock);
+            for(const auto &move : moves) {
+                const Image &textureImage = writer.working().resources[int(move.to)];
+                DescriptorHandle textureImageDescriptor = descriptorManager->acquireDescriptor(ResourceClass::TextureImage, move.to);
+                Q_ASSERT(textureImageDescriptor);
+                descriptorManager->updateImageDescriptor(textureImageDescriptor, DescriptorImageInfo(textureImage.view, ImageState::ShaderRead));
+
+                RetiredSlot<SharedImagePtr> slot;
+                slot.index = move.from;
+                m_retiredTextures.retire(slot, m_renderer->numConcurrentFrames());
+            }
+            result.texturesCompacted = !moves.isEmpty();
+        }
+    }
+    {
+        SceneSnapshotTable<Material>::Writer writer(m_materials);
+        if(shouldCompact(m_materials.numFreeIndices(), writer.working().resources.size())) {
+            result.materialsCompacted = !writer.compact(false).isEmpty();
+        }
+    }
+    return result;
 }
 
 bool SceneManager::isReadyToRender() const
@@ -226,16 +481,22 @@ bool SceneManager::isReadyToRender() const
            m_emitterBuffer.resource;
 }
 
+InstancePacker &SceneManager::instancePacker()
+{
+    // NO LOCK: Access from UpdateInstanceBufferJob only.
+    return m_instancePacker;
+}
+
 const QVector<Raytrace::HEntity> &SceneManager::renderables() const
 {
     // NO LOCK: Access from render/aspect thread only.
-    return m_renderables.resources();
+    return m_entities.renderables();
 }
 
 const QVector<Raytrace::HEntity> &SceneManager::emissives() const
 {
     // NO LOCK: Access from render/aspect thread only.
-    return m_emissives.resources();
+    return m_entities.emissives();
 }
 
 AccelerationStructure SceneManager::sceneTLAS(uint32_t *instanceCount) const
@@ -247,15 +508,21 @@ AccelerationStructure SceneManager::sceneTLAS(uint32_t *instanceCount) const
     return m_tlas.resource;
 }
 
-Buffer SceneManager::instanceBuffer() const
+Buffer SceneManager::instanceBuffer(uint32_t *capacity) const
 {
-    // NO LOCK: Access from render/aspect thread only.
+    QReadLocker lock(&m_rwlock);
+    if(capacity) {
+        *capacity = m_instanceBufferCapacity;
+    }
     return m_instanceBuffer.resource;
 }
 
-Buffer SceneManager::materialBuffer() const
+Buffer SceneManager::materialBuffer(uint32_t *capacity) const
 {
-    // NO LOCK: Access from render/aspect thread only.
+    QReadLocker lock(&m_rwlock);
+    if(capacity) {
+        *capacity = m_materialBufferCapacity;
+    }
     return m_materialBuffer.resource;
 }
 
@@ -267,30 +534,26 @@ Buffer SceneManager::emitterBuffer() const
 
 uint32_t SceneManager::lookupRenderableIndex(Qt3DCore::QNodeId entityNodeId) const
 {
-    QReadLocker lock(&m_rwlock);
-    return m_renderables.lookupIndex(entityNodeId);
+    // NO LOCK: Entity sets are only modified by the aspect thread while no jobs are running.
+    return m_entities.lookupRenderableIndex(entityNodeId);
 }
 
 uint32_t SceneManager::lookupEmissiveIndex(Qt3DCore::QNodeId entityNodeId) const
 {
-    QReadLocker lock(&m_rwlock);
-    return m_emissives.lookupIndex(entityNodeId);
+    // NO LOCK: Entity sets are only modified by the aspect thread while no jobs are running.
+    return m_entities.lookupEmissiveIndex(entityNodeId);
 }
 
 QVector<Material> SceneManager::materials() const
 {
-    QReadLocker lock(&m_rwlock);
-    auto result = m_materials.resources();
-    result.detach();
-    return result;
+    // NO LOCK: Snapshot contents are immutable.
+    return m_materials.resources();
 }
 
 QVector<Geometry> SceneManager::geometry() const
 {
-    QReadLocker lock(&m_rwlock);
-    auto result = m_geometry.resources();
-    result.detach();
-    return result;
+    // NO LOCK: Snapshot contents are immutable.
+    return m_geometry.resources();
 }
 
 QVector<Emitter> SceneManager::emitters() const
@@ -301,22 +564,34 @@ QVector<Emitter> SceneManager::emitters() const
     return result;
 }
 
+uint32_t SceneManager::numRenderables() const
+{
+    // NO LOCK: Access from render/aspect thread only.
+    return m_entities.numRenderables();
+}
+
+uint32_t SceneManager::numEmissives() const
+{
+    // NO LOCK: Access from render/aspect thread only.
+    return m_entities.numEmissives();
+}
+
 uint32_t SceneManager::numMaterials() const
 {
-    QReadLocker lock(&m_rwlock);
-    return uint32_t(m_materials.resources().size());
+    // NO LOCK: Wait-free snapshot read.
+    return uint32_t(m_materials.snapshot()->resources.size());
 }
 
 uint32_t SceneManager::numGeometry() const
 {
-    QReadLocker lock(&m_rwlock);
-    return uint32_t(m_geometry.resources().size());
+    // NO LOCK: Wait-free snapshot read.
+    return uint32_t(m_geometry.snapshot()->resources.size());
 }
 
 uint32_t SceneManager::numTextures() const
 {
-    QReadLocker lock(&m_rwlock);
-    return uint32_t(m_textures.resources().size());
+    // NO LOCK: Wait-free snapshot read.
+    return uint32_t(m_textures.snapshot()->resources.size());
 }
 
 uint32_t SceneManager::numEmitters() const
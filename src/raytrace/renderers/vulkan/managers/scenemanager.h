@@ -10,11 +10,21 @@
 #include <renderers/vulkan/vkresources.h>
 #include <renderers/vulkan/geometry.h>
 #include <renderers/vulkan/glsl.h>
+#include <renderers/vulkan/instancepacker.h>
 #include <renderers/vulkan/managers/sceneresourceset.h>
+#include <renderers/vulkan/managers/scenesnapshottable.h>
+#include <renderers/vulkan/managers/sceneentityset.h>
 
 #include <backend/handles_p.h>
 
+#include <Qt3DRaytrace/qgeometrydata.h>
+#include <Qt3DRaytrace/qimagedata.h>
+
+#include <QHash>
+#include <QMutex>
+#include <QPair>
 #include <QReadWriteLock>
+#include <QSharedPointer>
 
 namespace Qt3DRaytrace {
 
@@ -32,33 +42,71 @@ public:
     explicit SceneManager(Renderer *renderer);
     ~SceneManager();
 
-    void addOrUpdateGeometry(Qt3DCore::QNodeId geometryNodeId, const Geometry &geometry);
+    // Device resource created once for geometry or image data shared by several nodes, e.g. an asset used by multiple meshes.
+    // Upload jobs hold the mutex while creating the resource, so concurrent jobs for the same data wait and then reuse it.
+    // Entries are keyed by address of the data, which they keep alive so that the address cannot be reused by other data.
+    // Resource is destroyed once the last node slot referencing it, including retired slots, is released.
+    template<typename T, typename DataT>
+    struct SharedResource
+    {
+        QMutex mutex;
+        T resource;
+        DataT data;
+    };
+    using SharedGeometryPtr = QSharedPointer<SharedResource<Geometry, QGeometryData>>;
+    using SharedImagePtr = QSharedPointer<SharedResource<Image, QImageData>>;
+
+    SharedGeometryPtr acquireSharedGeometry(const QGeometryData &data);
+    SharedImagePtr acquireSharedTexture(const QImageData &data);
+
+    void addOrUpdateGeometry(Qt3DCore::QNodeId geometryNodeId, const SharedGeometryPtr &geometry);
     void addOrUpdateMaterial(Qt3DCore::QNodeId materialNodeId, const Material &material);
-    void addOrUpdateTexture(Qt3DCore::QNodeId textureImageNodeId, const Image &textureImage);
+    QVector<uint32_t> addOrUpdateMaterials(const QVector<Qt3DCore::QNodeId> &materialNodeIds, const QVector<Material> &materials);
+    void addOrUpdateTexture(Qt3DCore::QNodeId textureImageNodeId, const SharedImagePtr &textureImage);
+    void removeGeometry(Qt3DCore::QNodeId geometryNodeId);
+    void removeMaterial(Qt3DCore::QNodeId materialNodeId);
+    void removeTexture(Qt3DCore::QNodeId textureImageNodeId);
+
+    // Geometry and textures are added by concurrent upload jobs and become visible to readers only once published.
+    void publishGeometry();
+    void publishTextures();
     void updateEmitters(QVector<Emitter> &emitters);
 
     void updateSceneTLAS(const AccelerationStructure &tlas, uint32_t instanceCount);
-    void updateMaterialBuffer(const Buffer &buffer);
+    void updateMaterialBuffer(const Buffer &buffer, uint32_t capacity);
     void updateEmitterBuffer(const Buffer &buffer);
-    void updateInstanceBuffer(const Buffer &buffer);
+    void updateInstanceBuffer(const Buffer &buffer, uint32_t capacity);
 
     uint32_t lookupGeometry(Qt3DCore::QNodeId geometryNodeId, Geometry &geometry) const;
     uint32_t lookupGeometryIndex(Qt3DCore::QNodeId geometryNodeId) const;
     uint32_t lookupMaterial(Qt3DCore::QNodeId materialNodeId, Material &material) const;
     uint32_t lookupMaterialIndex(Qt3DCore::QNodeId materialNodeId) const;
     uint32_t lookupTextureIndex(Qt3DCore::QNodeId textureImageNodeId) const;
+    SceneResourceHandle lookupGeometryHandle(Qt3DCore::QNodeId geometryNodeId) const;
+    bool resolveGeometryHandle(const SceneResourceHandle &handle, Geometry &geometry) const;
 
-    void gatherEntities(Raytrace::EntityManager *entityManager);
+    SceneEntitySet::Changes updateEntities(Raytrace::EntityManager *entityManager, const QVector<Qt3DCore::QNodeId> &dirtyNodeIds);
+    const SceneEntitySet &entities() const;
     void updateRetiredResources();
+    void reclaimRetiredSnapshots();
 
     void destroyResources();
     void destroyExpiredResources();
 
+    struct CompactionResult {
+        bool geometryCompacted = false;
+        bool materialsCompacted = false;
+        bool texturesCompacted = false;
+    };
+    CompactionResult compactResources();
+
     bool isReadyToRender() const;
 
+    InstancePacker &instancePacker();
+
     AccelerationStructure sceneTLAS(uint32_t *instanceCount=nullptr) const;
-    Buffer instanceBuffer() const;
-    Buffer materialBuffer() const;
+    Buffer instanceBuffer(uint32_t *capacity=nullptr) const;
+    Buffer materialBuffer(uint32_t *capacity=nullptr) const;
     Buffer emitterBuffer() const;
 
     uint32_t lookupRenderableIndex(Qt3DCore::QNodeId entityNodeId) const;
@@ -71,27 +119,61 @@ public:
     QVector<Geometry> geometry() const;
     QVector<Emitter> emitters() const;
 
+    uint32_t numRenderables() const;
+    uint32_t numEmissives() const;
     uint32_t numMaterials() const;
     uint32_t numGeometry() const;
     uint32_t numTextures() const;
     uint32_t numEmitters() const;
 
 private:
-    SceneResourceSet<Raytrace::HEntity> m_renderables;
-    SceneResourceSet<Raytrace::HEntity> m_emissives;
+    // Address of vertex data and face data, or address and size of image data.
+    using SharedResourceKey = QPair<quintptr, quint64>;
+
+    // Shared resource of a vacated slot is null when the slot was relocated by compaction.
+    template<typename SharedPtrT>
+    struct RetiredSlot {
+        SharedPtrT shared;
+        uint32_t index = ~0u;
+    };
+
+    template<typename T, typename DataT>
+    QSharedPointer<SharedResource<T, DataT>> acquireSharedResource(QHash<SharedResourceKey, QWeakPointer<SharedResource<T, DataT>>> &entries,
+                                                                   const SharedResourceKey &key, const DataT &data, void (Device::*destroy)(T&));
+
+    void retireGeometry(SceneSnapshotTable<Geometry>::Writer &writer, Qt3DCore::QNodeId geometryNodeId);
+    void retireTexture(SceneSnapshotTable<Image>::Writer &writer, Qt3DCore::QNodeId textureImageNodeId);
 
-    SceneResourceSet<Geometry> m_geometry;
-    SceneResourceSet<Material> m_materials;
-    SceneResourceSet<Image> m_textures;
+    SceneEntitySet m_entities;
+
+    SceneSnapshotTable<Geometry> m_geometry;
+    SceneSnapshotTable<Material> m_materials;
+    SceneSnapshotTable<Image> m_textures;
     QVector<Emitter> m_emitters;
 
+    // Shared resources referenced by live slots of each node.
+    QHash<Qt3DCore::QNodeId, SharedGeometryPtr> m_nodeGeometry;
+    QHash<Qt3DCore::QNodeId, SharedImagePtr> m_nodeTextures;
+
+    QMutex m_sharedResourcesMutex;
+    QHash<SharedResourceKey, QWeakPointer<SharedResource<Geometry, QGeometryData>>> m_sharedGeometry;
+    QHash<SharedResourceKey, QWeakPointer<SharedResource<Image, QImageData>>> m_sharedTextures;
+
     ManagedResource<AccelerationStructure> m_tlas;
     uint32_t m_tlasInstanceCount;
 
     ManagedResource<Buffer> m_instanceBuffer;
+    uint32_t m_instanceBufferCapacity;
+    InstancePacker m_instancePacker;
+
     ManagedResource<Buffer> m_materialBuffer;
+    uint32_t m_materialBufferCapacity;
     ManagedResource<Buffer> m_emitterBuffer;
 
+    // Removed, replaced or relocated slots whose resources and descriptors may still be referenced by frames in flight.
+    ManagedResource<RetiredSlot<SharedGeometryPtr>> m_retiredGeometry;
+    ManagedResource<RetiredSlot<SharedImagePtr>> m_retiredTextures;
+
     Renderer *m_renderer;
 
     mutable QReadWriteLock m_rwlock;
@@ -20,8 +20,8 @@ public:
     uint32_t addResource(Qt3DCore::QNodeId nodeId, const T &resource)
     {
         Q_ASSERT(!m_nodeToIndexMap.contains(nodeId));
-        uint32_t index = uint32_t(m_resources.size());
-        m_resources.append(resource);
+        uint32_t index = allocateIndex();
+        m_resources[int(index)] = resource;
         m_nodeToIndexMap.insert(nodeId, index);
         return index;
     }
@@ -31,17 +31,42 @@ public:
         uint32_t index;
         auto it = m_nodeToIndexMap.find(nodeId);
         if(it == m_nodeToIndexMap.end()) {
-            index = uint32_t(m_resources.size());
-            m_resources.append(resource);
+            index = allocateIndex();
             m_nodeToIndexMap.insert(nodeId, index);
         }
         else {
             index = *it;
-            m_resources[int(index)] = resource;
         }
+        m_resources[int(index)] = resource;
         return index;
     }
 
+    // Released slots are reset to a default constructed value and reused by subsequent additions
+    // so that indices of remaining resources never change.
+    uint32_t removeResource(Qt3DCore::QNodeId nodeId)
+    {
+        auto it = m_nodeToIndexMap.find(nodeId);
+        if(it == m_nodeToIndexMap.end()) {
+            return ~0u;
+        }
+        const uint32_t index = *it;
+        m_nodeToIndexMap.erase(it);
+        m_resources[int(index)] = T();
+        m_freeIndices.append(index);
+        return index;
+    }
+
+    bool contains(Qt3DCore::QNodeId nodeId) const
+    {
+        return m_nodeToIndexMap.contains(nodeId);
+    }
+
+    // Number of live resources, excluding released slots.
+    int count() const
+    {
+        return m_nodeToIndexMap.size();
+    }
+
     uint32_t lookupIndex(Qt3DCore::QNodeId nodeId) const
     {
         return m_nodeToIndexMap.value(nodeId, ~0u);
@@ -65,6 +90,7 @@ public:
     {
         QVector<T> result(std::move(m_resources));
         m_nodeToIndexMap.clear();
+        m_freeIndices.clear();
         return result;
     }
 
@@ -72,10 +98,21 @@ public:
     {
         m_resources.clear();
         m_nodeToIndexMap.clear();
+        m_freeIndices.clear();
     }
 
 private:
+    uint32_t allocateIndex()
+    {
+        if(!m_freeIndices.isEmpty()) {
+            return m_freeIndices.takeLast();
+        }
+        m_resources.append(T());
+        return uint32_t(m_resources.size() - 1);
+    }
+
     QVector<T> m_resources;
+    QVector<uint32_t> m_freeIndices;
     QHash<Qt3DCore::QNodeId, uint32_t> m_nodeToIndexMap;
 };
 
@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <renderers/vulkan/managers/nodeidindexmap.h>
+
+#include <QVector>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QAtomicPointer>
+#include <Qt3DCore/QNodeId>
+
+#include <algorithm>
+
+namespace Qt3DRaytrace {
+namespace Vulkan {
+
+// Generation-checked reference to a table slot. A handle becomes stale as soon as its resource is removed,
+// even if the slot is later reused by another resource.
+struct SceneResourceHandle
+{
+    uint32_t index = NodeIdIndexMap::InvalidIndex;
+    uint32_t generation = 0;
+
+    bool isNull() const { return index == NodeIdIndexMap::InvalidIndex; }
+};
+
+// Read-copy-update table of scene resources indexed by node ID.
+// Readers load the current immutable snapshot with a single atomic acquire and never block.
+// Writers are serialized, modify a private working copy and publish it as a new snapshot version.
+// Superseded snapshots stay alive until reclaimRetiredSnapshots() is called at a point where
+// no reader can still hold them, i.e. between aspect frames when no jobs are running.
+template<typename T>
+class SceneSnapshotTable
+{
+public:
+    struct Snapshot
+    {
+        quint64 version = 0;
+        NodeIdIndexMap indices;
+        QVector<T> resources;
+        QVector<Qt3DCore::QNodeId> nodeIds;
+        QVector<uint32_t> generations;
+
+        uint32_t lookupIndex(Qt3DCore::QNodeId nodeId) const
+        {
+            return indices.value(nodeId);
+        }
+        uint32_t lookupResource(Qt3DCore::QNodeId nodeId, T &resource) const
+        {
+            const uint32_t index = indices.value(nodeId);
+            if(index != NodeIdIndexMap::InvalidIndex) {
+                resource = resources[int(index)];
+            }
+            return index;
+        }
+        SceneResourceHandle lookupHandle(Qt3DCore::QNodeId nodeId) const
+        {
+            SceneResourceHandle handle;
+            handle.index = indices.value(nodeId);
+            if(!handle.isNull()) {
+                handle.generation = generations[int(handle.index)];
+            }
+            return handle;
+        }
+        bool resolveHandle(const SceneResourceHandle &handle, T &resource) const
+        {
+            if(!isValid(handle)) {
+                return false;
+            }
+            resource = resources[int(handle.index)];
+            return true;
+        }
+        bool isValid(const SceneResourceHandle &handle) const
+        {
+            return handle.index < uint32_t(resources.size()) && generations[int(handle.index)] == handle.generation;
+        }
+        int count() const
+        {
+            return indices.size();
+        }
+    };
+
+    struct IndexMove
+    {
+        uint32_t from;
+        uint32_t to;
+    };
+
+    // Scoped write transaction; all modifications become visible to readers at once when it goes out of scope.
+    // Deferred writers instead leave their modifications pending until publishPending() is called, so that many
+    // short transactions (e.g. one per upload job) pay for a single snapshot rather than one each.
+    class Writer
+    {
+    public:
+        enum PublishMode {
+            PublishOnExit,
+            PublishDeferred,
+        };
+
+        explicit Writer(SceneSnapshotTable &table, PublishMode mode=PublishOnExit)
+            : m_table(table)
+            , m_lock(&table.m_writeMutex)
+            , m_mode(mode)
+        {}
+        ~Writer()
+        {
+            if(m_modified) {
+                if(m_mode == PublishOnExit) {
+                    m_table.publish();
+                }
+                else {
+                    m_table.m_publishPending = true;
+                }
+            }
+        }
+
+        uint32_t addResource(Qt3DCore::QNodeId nodeId, const T &resource)
+        {
+            Snapshot &working = m_table.m_working;
+            Q_ASSERT(!working.indices.contains(nodeId));
+            const uint32_t index = m_table.allocateIndex();
+            working.indices.insert(nodeId, index);
+            working.resources[int(index)] = resource;
+            working.nodeIds[int(index)] = nodeId;
+            m_modified = true;
+            return index;
+        }
+
+        uint32_t addOrUpdateResource(Qt3DCore::QNodeId nodeId, const T &resource)
+        {
+            Snapshot &working = m_table.m_working;
+            const uint32_t index = working.indices.value(nodeId);
+            if(index == NodeIdIndexMap::InvalidIndex) {
+                return addResource(nodeId, resource);
+            }
+            working.resources[int(index)] = resource;
+            m_modified = true;
+            return index;
+        }
+
+        // Removed slots are reset to a default constructed value so that indices of remaining resources never change.
+        // If releaseIndex is false the slot is kept reserved until passed to releaseIndex(), which allows deferring
+        // its reuse until the device no longer references it.
+        uint32_t removeResource(Qt3DCore::QNodeId nodeId, T *removedResource=nullptr, bool releaseIndex=true)
+        {
+            Snapshot &working = m_table.m_working;
+            const uint32_t index = working.indices.value(nodeId);
+            if(index == NodeIdIndexMap::InvalidIndex) {
+                return index;
+            }
+            if(removedResource) {
+                *removedResource = working.resources[int(index)];
+            }
+            working.indices.remove(nodeId);
+            working.resources[int(index)] = T();
+            working.nodeIds[int(index)] = Qt3DCore::QNodeId();
+            ++working.generations[int(index)];
+            if(releaseIndex) {
+                m_table.m_freeIndices.append(index);
+            }
+            m_modified = true;
+            return index;
+        }
+
+        void releaseIndex(uint32_t index)
+        {
+            Q_ASSERT(index < uint32_t(m_table.m_working.resources.size()));
+            Q_ASSERT(m_table.m_working.nodeIds[int(index)].isNull());
+            m_table.m_freeIndices.append(index);
+        }
+
+        // Moves resources from the end of the table into the lowest free slots and trims free slots off its end.
+        // With reserveMovedSlots the vacated slots stay reserved until passed to releaseIndex(), so that a subsequent
+        // compaction can trim them once the device no longer references them.
+        QVector<IndexMove> compact(bool reserveMovedSlots)
+        {
+            Snapshot &working = m_table.m_working;
+            QVector<uint32_t> &freeIndices = m_table.m_freeIndices;
+            std::sort(freeIndices.begin(), freeIndices.end());
+
+            QVector<uchar> isFreeSlot(working.resources.size(), 0);
+            for(uint32_t index : qAsConst(freeIndices)) {
+                isFreeSlot[int(index)] = 1;
+            }
+
+            QVector<IndexMove> moves;
+            int tail = working.resources.size() - 1;
+            for(uint32_t freeIndex : qAsConst(freeIndices)) {
+                while(tail > int(freeIndex) && working.nodeIds[tail].isNull()) {
+                    --tail;
+                }
+                if(tail <= int(freeIndex)) {
+                    break;
+                }
+                const Qt3DCore::QNodeId nodeId = working.nodeIds[tail];
+                working.resources[int(freeIndex)] = working.resources[tail];
+                working.nodeIds[int(freeIndex)] = nodeId;
+                working.resources[tail] = T();
+                working.nodeIds[tail] = Qt3DCore::QNodeId();
+                ++working.generations[int(freeIndex)];
+                ++working.generations[tail];
+                working.indices.insert(nodeId, freeIndex);
+                isFreeSlot[int(freeIndex)] = 0;
+                isFreeSlot[tail] = reserveMovedSlots ? 0 : 1;
+                moves.append(IndexMove{ uint32_t(tail), freeIndex });
+                --tail;
+            }
+
+            int end = working.resources.size();
+            while(end > 0 && isFreeSlot[end-1]) {
+                --end;
+            }
+
+            // Generations of trimmed slots are retained so that stale handles never validate against reused slots.
+            working.resources.resize(end);
+            working.nodeIds.resize(end);
+            freeIndices.resize(0);
+            for(int index=0; index < end; ++index) {
+                if(isFreeSlot[index]) {
+                    freeIndices.append(uint32_t(index));
+                }
+            }
+            m_modified = true;
+            return moves;
+        }
+
+        const Snapshot &working() const
+        {
+            return m_table.m_working;
+        }
+
+    private:
+        SceneSnapshotTable &m_table;
+        QMutexLocker m_lock;
+        PublishMode m_mode;
+        bool m_modified = false;
+    };
+
+    SceneSnapshotTable()
+        : m_current(new Snapshot)
+    {}
+    ~SceneSnapshotTable()
+    {
+        reclaimRetiredSnapshots();
+        delete m_current.loadAcquire();
+    }
+
+    // Returned snapshot remains valid at least until the next call to reclaimRetiredSnapshots().
+    const Snapshot *snapshot() const
+    {
+        return m_current.loadAcquire();
+    }
+
+    uint32_t lookupIndex(Qt3DCore::QNodeId nodeId) const
+    {
+        return snapshot()->lookupIndex(nodeId);
+    }
+    uint32_t lookupResource(Qt3DCore::QNodeId nodeId, T &resource) const
+    {
+        return snapshot()->lookupResource(nodeId, resource);
+    }
+    SceneResourceHandle lookupHandle(Qt3DCore::QNodeId nodeId) const
+    {
+        return snapshot()->lookupHandle(nodeId);
+    }
+    bool resolveHandle(const SceneResourceHandle &handle, T &resource) const
+    {
+        return snapshot()->resolveHandle(handle, resource);
+    }
+    QVector<T> resources() const
+    {
+        return snapshot()->resources;
+    }
+    int count() const
+    {
+        return snapshot()->count();
+    }
+    quint64 version() const
+    {
+        return snapshot()->version;
+    }
+
+    // Number of slots that are allocated but hold no resource. Writer side only.
+    int numFreeIndices() const
+    {
+        return m_freeIndices.size();
+    }
+
+    // Publishes modifications left by deferred writers, if any.
+    void publishPending()
+    {
+        QMutexLocker lock(&m_writeMutex);
+        if(m_publishPending) {
+            publish();
+        }
+    }
+
+    void reclaimRetiredSnapshots()
+    {
+        QMutexLocker lock(&m_writeMutex);
+        qDeleteAll(m_retired);
+        m_retired.clear();
+    }
+
+    QVector<T> takeResources()
+    {
+        QMutexLocker lock(&m_writeMutex);
+        QVector<T> result = std::move(m_working.resources);
+        m_working.resources.clear();
+        m_working.nodeIds.clear();
+        m_working.indices.clear();
+        for(uint32_t &generation : m_working.generations) {
+            ++generation;
+        }
+        m_freeIndices.clear();
+        publish();
+        return result;
+    }
+
+    void clear()
+    {
+        takeResources();
+    }
+
+private:
+    uint32_t allocateIndex()
+    {
+        if(!m_freeIndices.isEmpty()) {
+            return m_freeIndices.takeLast();
+        }
+        m_working.resources.append(T());
+        m_working.nodeIds.append(Qt3DCore::QNodeId());
+        if(m_working.generations.size() < m_working.resources.size()) {
+            m_working.generations.append(0);
+        }
+        return uint32_t(m_working.resources.size() - 1);
+    }
+
+    void publish()
+    {
+        // Containers are implicitly shared so the snapshot itself is cheap to create, but the working copy then
+        // has to copy all of its containers on its next write. Publishing is thus O(N) amortized over all writes
+        // until the next publish, which is why per-resource writers should use PublishDeferred.
+        Snapshot *snapshot = new Snapshot(m_working);
+        snapshot->version = ++m_working.version;
+        m_retired.append(m_current.fetchAndStoreRelease(snapshot));
+        m_publishPending = false;
+    }
+
+    QAtomicPointer<Snapshot> m_current;
+    Snapshot m_working;
+    QVector<uint32_t> m_freeIndices;
+    QVector<Snapshot*> m_retired;
+    QMutex m_writeMutex;
+    bool m_publishPending = false;
+};
+
+} // Vulkan
+} // Qt3DRaytrace
@@ -18,6 +18,7 @@
 #include <renderers/vulkan/jobs/updateinstancebufferjob.h>
 #include <renderers/vulkan/jobs/updatematerialsjob.h>
 #include <renderers/vulkan/jobs/uploadtexturejob.h>
+#include <renderers/vulkan/jobs/publishsceneresourcesjob.h>
 
 #include <renderers/vulkan/shaders/lib/bindings.glsl>
 
@@ -169,6 +170,14 @@ QVector<Qt3DCore::QAspectJobPtr> Renderer::createGeometryJobs()
     }
 
     geometryJobs.append(buildGeometryJobs);
+    if(!buildGeometryJobs.isEmpty()) {
+        // Dependents of geometry jobs also depend on this job and so observe all built geometry at once.
+        auto publishJob = PublishSceneResourcesJobPtr::create(this, PublishSceneResourcesJob::ResourceType::Geometry);
+        for(const auto &job : qAsConst(buildGeometryJobs)) {
+            publishJob->addDependency(job);
+        }
+        geometryJobs.append(publishJob);
+    }
     return geometryJobs;
 }
 
@@ -190,6 +199,13 @@ QVector<Qt3DCore::QAspectJobPtr> Renderer::createTextureJobs()
     }
 
     textureJobs.append(uploadTextureJobs);
+    if(!uploadTextureJobs.isEmpty()) {
+        auto publishJob = PublishSceneResourcesJobPtr::create(this, PublishSceneResourcesJob::ResourceType::Textures);
+        for(const auto &job : qAsConst(uploadTextureJobs)) {
+            publishJob->addDependency(job);
+        }
+        textureJobs.append(publishJob);
+    }
     return textureJobs;
 }
 
@@ -213,6 +229,10 @@ QVector<Qt3DCore::QAspectJobPtr> Renderer::createMaterialJobs(bool forceAllDirty
         }
     }
 
+    for(const Raytrace::HMaterial &handle : qAsConst(dirtyMaterialHandles)) {
+        m_materialTextures.updateMaterial(handle.data());
+    }
+
     auto updateMaterialsJob = UpdateMaterialsJobPtr::create(this, &m_nodeManagers->textureManager);
     updateMaterialsJob->setDirtyMaterialHandles(dirtyMaterialHandles);
     return { updateMaterialsJob };
@@ -262,7 +282,11 @@ bool Renderer::createResources()
     m_defaultQueryPool = m_device->createQueryPool({VK_QUERY_TYPE_TIMESTAMP, 2 * numConcurrentFrames()});
 
     m_displaySampler = m_device->createSampler({VK_FILTER_NEAREST});
-    m_textureSampler = m_device->createSampler({VK_FILTER_LINEAR});
+    {
+        SamplerCreateInfo textureSamplerCreateInfo(VK_FILTER_LINEAR, VK_SAMPLER_MIPMAP_MODE_LINEAR);
+        textureSamplerCreateInfo.maxLod = VK_LOD_CLAMP_NONE;
+        m_textureSampler = m_device->createSampler(textureSamplerCreateInfo);
+    }
 
     m_displayRenderPass = createDisplayRenderPass(m_swapchainFormat.format);
     m_displayPipeline = GraphicsPipelineBuilder(m_device.get(), m_displayRenderPass)
@@ -315,6 +339,7 @@ void Renderer::releaseResources()
     }
 
     m_sceneManager->destroyResources();
+    m_materialTextures.clear();
     m_descriptorManager->destroyAllDescriptorPools();
 }
 
@@ -979,8 +1004,7 @@ Device *Renderer::device() const
 
 void Renderer::markDirty(DirtySet changes, Raytrace::BackendNode *node)
 {
-    Q_UNUSED(node);
-    m_dirtySet |= changes;
+    m_sceneChanges.markDirty(changes, node);
 }
 
 Raytrace::Entity *Renderer::sceneRoot() const
@@ -1021,6 +1045,7 @@ void Renderer::setNodeManagers(Raytrace::NodeManagers *nodeManagers)
 {
     Q_ASSERT(nodeManagers);
     m_nodeManagers = nodeManagers;
+    m_updateWorldTransformJob->setManagers(m_nodeManagers);
     m_updateEmittersJob->setTextureManager(&m_nodeManagers->textureManager);
 }
 
@@ -1053,11 +1078,8 @@ QVector<Qt3DCore::QAspectJobPtr> Renderer::jobsToExecute(qint64 time)
 {
     QVector<Qt3DCore::QAspectJobPtr> jobs;
 
-    bool shouldUpdateRenderParameters = false;
-    bool shouldUpdateInstanceBuffer = false;
-    bool shouldUpdateEmitters = false;
-    bool shouldUpdateTLAS = false;
-    bool sceneEntitiesDirty = false;
+    // No jobs from the previous frame are running at this point.
+    m_sceneManager->reclaimRetiredSnapshots();
 
     m_updateRenderParametersJob->removeDependency(m_updateWorldTransformJob);
 
@@ -1069,89 +1091,116 @@ QVector<Qt3DCore::QAspectJobPtr> Renderer::jobsToExecute(qint64 time)
 
     jobs.append(m_destroyExpiredResourcesJob);
 
-    if(m_dirtySet != DirtyFlag::NoneDirty) {
-        resetRenderProgress();
+    SceneUpdate update;
+    if(!m_sceneChanges.isEmpty()) {
+        SceneEntitySet::Changes entityChanges;
+        const QVector<Qt3DCore::QNodeId> dirtyEntityNodes = m_sceneChanges.entityNodeIds();
+        if(!dirtyEntityNodes.isEmpty()) {
+            entityChanges = m_sceneManager->updateEntities(&m_nodeManagers->entityManager, dirtyEntityNodes);
+        }
+
+        const Qt3DCore::QNodeId activeCameraId = m_settings ? m_settings->cameraId() : Qt3DCore::QNodeId();
+        const Qt3DCore::QNodeId skyTextureId = m_settings ? m_settings->skyTextureId() : Qt3DCore::QNodeId();
+        update = m_sceneChanges.classify(m_nodeManagers, m_sceneManager->entities(), entityChanges, activeCameraId, skyTextureId);
+        m_sceneChanges.clear();
+
+        for(const Qt3DCore::QNodeId &geometryId : qAsConst(update.removedGeometry)) {
+            m_sceneManager->removeGeometry(geometryId);
+        }
+        for(const Qt3DCore::QNodeId &textureImageId : qAsConst(update.removedTextures)) {
+            m_sceneManager->removeTexture(textureImageId);
+        }
+        for(const Qt3DCore::QNodeId &materialId : qAsConst(update.removedMaterials)) {
+            m_sceneManager->removeMaterial(materialId);
+            m_materialTextures.removeMaterial(materialId);
+        }
+
+        if(!update.dirtyTextures.isEmpty()) {
+            const QVector<Qt3DCore::QNodeId> dependentMaterials = m_materialTextures.updateTextures(m_nodeManagers, update.dirtyTextures);
+            for(const Qt3DCore::QNodeId &materialId : dependentMaterials) {
+                m_nodeManagers->materialManager.markComponentDirty(materialId);
+                update.resetRenderProgress |= m_sceneManager->entities().isComponentReferencedByRenderable(materialId);
+            }
+            update.updateMaterials |= !dependentMaterials.isEmpty();
+        }
     }
 
-    if(m_dirtySet & DirtyFlag::EntityDirty || m_dirtySet & DirtyFlag::GeometryDirty) {
-        shouldUpdateInstanceBuffer = true;
-        shouldUpdateEmitters = true;
-        shouldUpdateTLAS = true;
-        sceneEntitiesDirty = true;
+    // Relocated resources keep their contents so compaction only requires rebuilding index-dependent data.
+    const SceneManager::CompactionResult compaction = m_sceneManager->compactResources();
+    if(compaction.geometryCompacted) {
+        update.updateInstanceBuffer = true;
+        update.updateEmitters = true;
+    }
+    if(compaction.texturesCompacted) {
+        update.updateMaterials = true;
+        update.updateAllMaterials = true;
+        update.updateEmitters = true;
     }
-    if(m_dirtySet & DirtyFlag::LightDirty) {
-        shouldUpdateEmitters = true;
-        sceneEntitiesDirty = true;
+    if(compaction.materialsCompacted) {
+        // Relocated materials are only uploaded to their new slots if every material is repacked.
+        update.updateMaterials = true;
+        update.updateAllMaterials = true;
+        update.updateInstanceBuffer = true;
+        update.updateEmitters = true;
     }
 
-    if(m_dirtySet & DirtyFlag::TransformDirty) {
+    // Changes that are invisible in the final image must not restart accumulation.
+    if(update.resetRenderProgress) {
+        resetRenderProgress();
+    }
+    if(update.updateActiveCamera) {
+        updateActiveCamera();
+    }
+
+    if(update.updateWorldTransforms) {
         jobs.append(m_updateWorldTransformJob);
         m_updateRenderParametersJob->addDependency(m_updateWorldTransformJob);
         m_updateInstanceBufferJob->addDependency(m_updateWorldTransformJob);
         m_updateEmittersJob->addDependency(m_updateWorldTransformJob);
-        shouldUpdateTLAS = true;
-        shouldUpdateRenderParameters = true;
-        shouldUpdateInstanceBuffer = true;
-        shouldUpdateEmitters = true;
     }
 
     QVector<Qt3DCore::QAspectJobPtr> geometryJobs;
-    if(m_dirtySet & DirtyFlag::GeometryDirty) {
+    if(update.updateGeometry) {
         geometryJobs = createGeometryJobs();
         jobs.append(geometryJobs);
-        shouldUpdateTLAS = true;
-        shouldUpdateInstanceBuffer = true;
-        shouldUpdateEmitters = true;
     }
 
     QVector<Qt3DCore::QAspectJobPtr> textureJobs;
-    if(m_dirtySet & DirtyFlag::TextureDirty) {
+    if(update.updateTextures) {
         textureJobs = createTextureJobs();
         jobs.append(textureJobs);
-        shouldUpdateEmitters = true;
     }
 
     QVector<Qt3DCore::QAspectJobPtr> materialJobs;
-    if(m_dirtySet & DirtyFlag::MaterialDirty || m_dirtySet & DirtyFlag::TextureDirty) {
-        bool forceUpdateAllMaterials = (m_dirtySet & DirtyFlag::TextureDirty);
-        materialJobs = createMaterialJobs(forceUpdateAllMaterials);
+    if(update.updateMaterials) {
+        materialJobs = createMaterialJobs(update.updateAllMaterials);
         jobs.append(materialJobs);
         for(const auto &materialJob : materialJobs) {
             for(const auto &textureJob : textureJobs) {
                 materialJob->addDependency(textureJob);
             }
         }
-        shouldUpdateInstanceBuffer = true;
-        shouldUpdateEmitters = true;
-    }
-
-    if(m_dirtySet & DirtyFlag::CameraDirty) {
-        updateActiveCamera();
-        shouldUpdateRenderParameters = true;
     }
 
-    m_dirtySet = DirtyFlag::NoneDirty;
-
-    if(shouldUpdateRenderParameters) {
+    if(update.updateRenderParameters) {
         jobs.append(m_updateRenderParametersJob);
     }
 
-    if(sceneEntitiesDirty) {
-        m_sceneManager->gatherEntities(&m_nodeManagers->entityManager);
-    }
-    if(m_sceneManager->renderables().size() == 0) {
+    if(m_sceneManager->numRenderables() == 0) {
         return jobs;
     }
 
-    if(shouldUpdateTLAS) {
+    if(update.updateTLAS) {
         Qt3DCore::QAspectJobPtr buildSceneTLASJob = BuildSceneTopLevelAccelerationStructureJobPtr::create(this);
-        buildSceneTLASJob->addDependency(m_updateWorldTransformJob);
+        if(update.updateWorldTransforms) {
+            buildSceneTLASJob->addDependency(m_updateWorldTransformJob);
+        }
         for(const auto &job : geometryJobs) {
             buildSceneTLASJob->addDependency(job);
         }
         jobs.append(buildSceneTLASJob);
     }
-    if(shouldUpdateInstanceBuffer) {
+    if(update.updateInstanceBuffer) {
         for(const auto &job : geometryJobs) {
             m_updateInstanceBufferJob->addDependency(job);
         }
@@ -1160,7 +1209,7 @@ QVector<Qt3DCore::QAspectJobPtr> Renderer::jobsToExecute(qint64 time)
         }
         jobs.append(m_updateInstanceBufferJob);
     }
-    if(shouldUpdateEmitters) {
+    if(update.updateEmitters) {
         for(const auto &job : geometryJobs) {
             m_updateEmittersJob->addDependency(job);
         }
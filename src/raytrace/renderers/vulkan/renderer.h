@@ -17,6 +17,8 @@
 #include <renderers/vulkan/managers/descriptormanager.h>
 #include <renderers/vulkan/managers/scenemanager.h>
 #include <renderers/vulkan/managers/cameramanager.h>
+#include <renderers/vulkan/managers/scenechangetracker.h>
+#include <renderers/vulkan/managers/materialtextureindex.h>
 
 #include <jobs/updateworldtransformjob_p.h>
 #include <renderers/vulkan/jobs/destroyexpiredresourcesjob.h>
@@ -187,7 +189,8 @@ private:
     UpdateEmittersJobPtr m_updateEmittersJob;
 
     Raytrace::Entity *m_sceneRoot = nullptr;
-    DirtySet m_dirtySet = DirtyFlag::AllDirty;
+    SceneChangeTracker m_sceneChanges;
+    MaterialTextureIndex m_materialTextures;
 
     Utility::MovingAverage<double> m_deviceTimeAverage;
     Utility::MovingAverage<double> m_hostTimeAverage;
@@ -29,6 +29,7 @@ struct PathTracePayload {
     vec3 T; // Path throughput
     RNG rng;
     uint depth;
+    float coneWidth; // Ray cone width at ray origin
 };
 
 struct Triangle {
@@ -54,6 +54,28 @@ vec2 getTexCoord(Triangle triangle, vec2 b)
     return blerp(b, triangle.v1.texcoord, triangle.v2.texcoord, triangle.v3.texcoord);
 }
 
+// Returns texture LOD at a ray hit for a texture of unit area, derived from the ray cone footprint on the triangle.
+// Add 0.5 * log2(width * height) to get mip level of a particular texture.
+// See: T. Akenine-Möller et al., "Texture Level of Detail Strategies for Real-Time Ray Tracing", Ray Tracing Gems, 2019.
+float getTextureLOD(Triangle triangle, mat4x4 objectToWorld, vec3 direction, float coneWidth)
+{
+    vec3 p1 = vec3(objectToWorld * vec4(triangle.v1.position, 1.0));
+    vec3 p2 = vec3(objectToWorld * vec4(triangle.v2.position, 1.0));
+    vec3 p3 = vec3(objectToWorld * vec4(triangle.v3.position, 1.0));
+    vec3 Ng = cross(p2 - p1, p3 - p1);
+
+    vec2 t1 = triangle.v2.texcoord - triangle.v1.texcoord;
+    vec2 t2 = triangle.v3.texcoord - triangle.v1.texcoord;
+
+    float positionArea = length(Ng);
+    float texcoordArea = abs(t1.x * t2.y - t2.x * t1.y);
+    float cosTheta = (positionArea > 0.0) ? abs(dot(Ng, direction)) / positionArea : 0.0;
+    if(texcoordArea == 0.0 || cosTheta == 0.0 || coneWidth == 0.0) {
+        return -Infinity;
+    }
+    return 0.5 * log2(texcoordArea / positionArea) + log2(coneWidth / cosTheta);
+}
+
 TangentBasis getTangentBasis(Triangle triangle, mat3x3 basisObjectToWorld, vec2 b)
 {
     TangentBasis basis;
@@ -59,29 +59,36 @@ Emitter fetchEmitter(uint emitterIndex)
     return emitterBuffer.emitters[emitterIndex];
 }
 
-vec3 fetchMaterialAlbedo(Material material, vec2 uv)
+vec4 sampleTexture(uint textureIndex, vec2 uv, float lod)
+{
+    ivec2 size = textureSize(sampler2D(textures[nonuniformEXT(textureIndex)], textureSampler), 0);
+    lod += 0.5 * log2(float(size.x) * float(size.y));
+    return textureLod(sampler2D(textures[nonuniformEXT(textureIndex)], textureSampler), uv, lod);
+}
+
+vec3 fetchMaterialAlbedo(Material material, vec2 uv, float lod)
 {
     vec3 albedo = material.albedo.rgb;
     if(material.albedoTexture != ~0u) {
-        albedo = texture(sampler2D(textures[nonuniformEXT(material.albedoTexture)], textureSampler), uv).rgb;
+        albedo = sampleTexture(material.albedoTexture, uv, lod).rgb;
     }
     return albedo;
 }
 
-float fetchMaterialRoughness(Material material, vec2 uv)
+float fetchMaterialRoughness(Material material, vec2 uv, float lod)
 {
     float roughness = material.albedo.a;
     if(material.roughnessTexture != ~0u) {
-        roughness = 1.0 - min(1.0, texture(sampler2D(textures[nonuniformEXT(material.roughnessTexture)], textureSampler), uv).r);
+        roughness = 1.0 - min(1.0, sampleTexture(material.roughnessTexture, uv, lod).r);
     }
     return max(MinRoughness, roughness);
 }
 
-float fetchMaterialMetalness(Material material, vec2 uv)
+float fetchMaterialMetalness(Material material, vec2 uv, float lod)
 {
     float metalness = material.emission.a;
     if(material.metalnessTexture != ~0u) {
-        metalness = 1.0 - min(1.0, texture(sampler2D(textures[nonuniformEXT(material.metalnessTexture)], textureSampler), uv).r);
+        metalness = 1.0 - min(1.0, sampleTexture(material.metalnessTexture, uv, lod).r);
     }
     return metalness;
 }
@@ -148,7 +148,7 @@ vec3 directLighting(vec3 p, vec3 wo, DifferentialSurface surface)
     return min(payload.T * params.numEmitters * L, vec3(params.directRadianceClamp));
 }
 
-vec3 indirectLighting(vec3 p, vec3 wo, DifferentialSurface surface, uint minDepth)
+vec3 indirectLighting(vec3 p, vec3 wo, DifferentialSurface surface, uint minDepth, float coneWidth)
 {
     vec3 wi;
     float pdf;
@@ -171,6 +171,7 @@ vec3 indirectLighting(vec3 p, vec3 wo, DifferentialSurface surface, uint minDept
     pIndirect.T     = pathThroughput;
     pIndirect.rng   = payload.rng;
     pIndirect.depth = payload.depth + 1;
+    pIndirect.coneWidth = coneWidth;
 
     vec3 wiWorld = tangentToWorld(surface.basis, wi);
     traceNV(scene, gl_RayFlagsNoneNV, 0xFF, Shader_PathTraceHit, 1, Shader_PathTraceMiss, p, Epsilon, wiWorld, Infinity, 3);
@@ -179,17 +180,22 @@ vec3 indirectLighting(vec3 p, vec3 wo, DifferentialSurface surface, uint minDept
 
 void main()
 {
-    EntityInstance instance = fetchInstance(gl_InstanceID);
-    Triangle triangle = fetchTriangle(gl_InstanceCustomIndexNV, gl_PrimitiveID);
-    Material material = fetchMaterial(gl_InstanceID);
+    EntityInstance instance = fetchInstance(gl_InstanceCustomIndexNV);
+    Triangle triangle = fetchTriangle(instance.geometryIndex, gl_PrimitiveID);
+    Material material = fetchMaterial(gl_InstanceCustomIndexNV);
     
     vec2 uv = getTexCoord(triangle, hitBarycentrics);
-    
+
+    // Ray cone spreads by pixel angle along the whole path, ignoring surface curvature.
+    float pixelSpreadAngle = atan(2.0 * params.cameraUpVectorTanHalfFOV.w / float(gl_LaunchSizeNV.y));
+    float coneWidth = payload.coneWidth + pixelSpreadAngle * gl_HitTNV;
+    float lod = getTextureLOD(triangle, instance.transform, gl_WorldRayDirectionNV, coneWidth);
+
     DifferentialSurface surface;
     surface.basis     = getTangentBasis(triangle, instance.basisTransform, hitBarycentrics);
-    surface.albedo    = fetchMaterialAlbedo(material, uv);
-    surface.roughness = fetchMaterialRoughness(material, uv);
-    surface.metalness = fetchMaterialMetalness(material, uv);
+    surface.albedo    = fetchMaterialAlbedo(material, uv, lod);
+    surface.roughness = fetchMaterialRoughness(material, uv, lod);
+    surface.metalness = fetchMaterialMetalness(material, uv, lod);
 	initializeSurfaceBSDF(surface);
 
     vec3 p  = gl_WorldRayOriginNV + gl_RayTmaxNV * gl_WorldRayDirectionNV;
@@ -198,6 +204,6 @@ void main()
     payload.L  = (payload.depth == 0) ? material.emission.rgb : vec3(0.0);
     payload.L += directLighting(p, wo, surface);
     if(payload.depth + 1 <= params.maxDepth) {
-        payload.L += indirectLighting(p, wo, surface, params.minDepth);
+        payload.L += indirectLighting(p, wo, surface, params.minDepth, coneWidth);
     }
 }
@@ -63,6 +63,7 @@ void main()
     pPathTrace.rng   = rngInit(gl_LaunchIDNV.xy, params.frameNumber);
     pPathTrace.depth = 0;
     pPathTrace.T     = vec3(1.0);
+    pPathTrace.coneWidth = 0.0;
 
     vec2 jitter  = pixelSize * (nextVec2(pPathTrace.rng) - 0.5);
     vec2 lensUV  = nextVec2(pPathTrace.rng);
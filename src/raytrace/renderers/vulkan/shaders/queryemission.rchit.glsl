@@ -16,6 +16,6 @@ rayPayloadInNV vec3 pEmission;
 
 void main()
 {
-    Material material = fetchMaterial(gl_InstanceID);
+    Material material = fetchMaterial(gl_InstanceCustomIndexNV);
     pEmission = material.emission.rgb;
 }
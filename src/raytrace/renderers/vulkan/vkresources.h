@@ -70,14 +70,24 @@ public:
     void update(const T &newResource, uint32_t retireTTL)
     {
         if(resource) {
-            RetiredResource retiredResouce;
-            retiredResouce.resource = resource;
-            retiredResouce.ttl = retireTTL;
-            m_retired.append(retiredResouce);
+            retire(resource, retireTTL);
         }
         resource = newResource;
     }
 
+    void retire(const T &retiredResource, uint32_t retireTTL)
+    {
+        RetiredResource retiredResouce;
+        retiredResouce.resource = retiredResource;
+        retiredResouce.ttl = int(retireTTL);
+        m_retired.append(retiredResouce);
+    }
+
+    bool hasRetired() const
+    {
+        return !m_retired.isEmpty();
+    }
+
     void updateRetiredTTL()
     {
         for(auto &retired : m_retired) {
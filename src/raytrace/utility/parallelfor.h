@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QAtomicInt>
+
+#include <functional>
+
+namespace Qt3DRaytrace {
+namespace Utility {
+
+namespace Detail {
+
+class FunctionRunnable final : public QRunnable
+{
+public:
+    explicit FunctionRunnable(std::function<void()> function)
+        : m_function(std::move(function))
+    {
+        setAutoDelete(true);
+    }
+    void run() override
+    {
+        m_function();
+    }
+
+private:
+    std::function<void()> m_function;
+};
+
+} // Detail
+
+// Calls func(chunkBegin, chunkEnd) over [begin, end) split into chunks of grainSize elements.
+// The calling thread participates in the work; helpers are only recruited from idle pool threads
+// so this is safe to call from within jobs already running on a thread pool.
+template<typename Func>
+void parallelFor(int begin, int end, int grainSize, Func &&func, QThreadPool *threadPool = QThreadPool::globalInstance())
+{
+    Q_ASSERT(grainSize > 0);
+    Q_ASSERT(threadPool);
+
+    const int numChunks = (end - begin + grainSize - 1) / grainSize;
+    if(numChunks <= 0) {
+        return;
+    }
+    if(numChunks == 1 || threadPool->maxThreadCount() <= 1) {
+        func(begin, end);
+        return;
+    }
+
+    QAtomicInt nextChunk(0);
+    auto worker = [&]() {
+        int chunk;
+        while((chunk = nextChunk.fetchAndAddOrdered(1)) < numChunks) {
+            const int chunkBegin = begin + chunk * grainSize;
+            const int chunkEnd = qMin(chunkBegin + grainSize, end);
+            func(chunkBegin, chunkEnd);
+        }
+    };
+
+    QSemaphore helpersFinished;
+    int numHelpers = 0;
+    const int maxHelpers = qMin(numChunks, threadPool->maxThreadCount()) - 1;
+    for(int i=0; i<maxHelpers; ++i) {
+        auto *helper = new Detail::FunctionRunnable([&worker, &helpersFinished]() {
+            worker();
+            helpersFinished.release();
+        });
+        if(!threadPool->tryStart(helper)) {
+            delete helper;
+            break;
+        }
+        ++numHelpers;
+    }
+
+    worker();
+    helpersFinished.acquire(numHelpers);
+}
+
+} // Utility
+} // Qt3DRaytrace
@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/gltfmeshimporter_p.h>
+
+#include <QtTest>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtEndian>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+enum ComponentType
+{
+    Byte = 5120,
+    UnsignedByte = 5121,
+    Short = 5122,
+    UnsignedShort = 5123,
+    UnsignedInt = 5125,
+    Float = 5126,
+};
+
+template<typename T>
+void appendValues(QByteArray &bytes, std::initializer_list<T> values)
+{
+    for(T value : values) {
+        const T littleEndianValue = qToLittleEndian(value);
+        bytes.append(reinterpret_cast<const char*>(&littleEndianValue), int(sizeof(T)));
+    }
+}
+
+void alignTo4(QByteArray &bytes, char padding)
+{
+    while(bytes.size() % 4 != 0) {
+        bytes.append(padding);
+    }
+}
+
+// Assembles a single buffer glTF document and writes it either as a binary container or as JSON with external buffer.
+class GltfBuilder
+{
+public:
+    int addBufferView(const QByteArray &bytes, int byteStride=0)
+    {
+        alignTo4(m_buffer, '\0');
+        QJsonObject view{ { "buffer", 0 }, { "byteOffset", m_buffer.size() }, { "byteLength", bytes.size() } };
+        if(byteStride > 0) {
+            view.insert("byteStride", byteStride);
+        }
+        m_buffer.append(bytes);
+        m_bufferViews.append(view);
+        return m_bufferViews.size() - 1;
+    }
+
+    int addAccessor(QJsonObject accessor)
+    {
+        m_accessors.append(accessor);
+        return m_accessors.size() - 1;
+    }
+
+    void setPrimitive(const QJsonObject &primitive)
+    {
+        m_primitive = primitive;
+    }
+
+    bool writeGlb(const QString &path) const
+    {
+        QByteArray json = document(QJsonValue()).toJson(QJsonDocument::Compact);
+        alignTo4(json, ' ');
+        QByteArray binary = m_buffer;
+        alignTo4(binary, '\0');
+
+        QByteArray glb;
+        appendValues<quint32>(glb, { 0x46546C67u, 2u, quint32(12 + 8 + json.size() + 8 + binary.size()) });
+        appendValues<quint32>(glb, { quint32(json.size()), 0x4E4F534Au });
+        glb.append(json);
+        appendValues<quint32>(glb, { quint32(binary.size()), 0x004E4942u });
+        glb.append(binary);
+        return writeFile(path, glb);
+    }
+
+    bool writeGltf(const QString &path, const QString &bufferFileName) const
+    {
+        const QString bufferPath = QFileInfo(path).path() + QLatin1Char('/') + bufferFileName;
+        const QString uri = QString::fromLatin1(QUrl::toPercentEncoding(bufferFileName));
+        return writeFile(bufferPath, m_buffer) && writeFile(path, document(uri).toJson());
+    }
+
+private:
+    QJsonDocument document(const QJsonValue &bufferUri) const
+    {
+        QJsonObject buffer{ { "byteLength", m_buffer.size() } };
+        if(!bufferUri.isUndefined() && !bufferUri.isNull()) {
+            buffer.insert("uri", bufferUri);
+        }
+        const QJsonObject mesh{ { "primitives", QJsonArray{ m_primitive } } };
+        const QJsonObject root{
+            { "asset", QJsonObject{ { "version", "2.0" } } },
+            { "scene", 0 },
+            { "scenes", QJsonArray{ QJsonObject{ { "nodes", QJsonArray{ 0 } } } } },
+            { "nodes", QJsonArray{ QJsonObject{ { "mesh", 0 } } } },
+            { "meshes", QJsonArray{ mesh } },
+            { "accessors", m_accessors },
+            { "bufferViews", m_bufferViews },
+            { "buffers", QJsonArray{ buffer } },
+        };
+        return QJsonDocument(root);
+    }
+
+    static bool writeFile(const QString &path, const QByteArray &contents)
+    {
+        QFile file(path);
+        return file.open(QFile::WriteOnly) && file.write(contents) == contents.size();
+    }
+
+    QByteArray m_buffer;
+    QJsonArray m_bufferViews;
+    QJsonArray m_accessors;
+    QJsonObject m_primitive;
+};
+
+// Collects warnings so that tests can tell whether the importer fell back to Assimp.
+QStringList g_warnings;
+QtMessageHandler g_previousMessageHandler = nullptr;
+
+void recordWarnings(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    if(type == QtWarningMsg || type == QtCriticalMsg) {
+        g_warnings.append(message);
+    }
+    g_previousMessageHandler(type, context, message);
+}
+
+bool importMesh(const QString &path, QGeometryData &data)
+{
+    g_warnings.clear();
+    g_previousMessageHandler = qInstallMessageHandler(recordWarnings);
+    const bool result = GltfMeshImporter().import(QUrl::fromLocalFile(path), data);
+    qInstallMessageHandler(g_previousMessageHandler);
+    return result;
+}
+
+bool fuzzyCompare(const QVector3D &a, const QVector3D &b)
+{
+    return (a - b).length() < 1e-5f;
+}
+
+} // anonymous
+
+class tst_GltfMeshImporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void importQuad_data();
+    void importQuad();
+    void sparseIndexOutOfRange();
+    void signedIndices_data();
+    void signedIndices();
+
+private:
+    QTemporaryDir m_directory;
+};
+
+void tst_GltfMeshImporter::initTestCase()
+{
+    // Imported fixtures must not be served from or stored in the user's mesh cache.
+    qputenv("QUARTZ_MESH_CACHE", "0");
+    QVERIFY(m_directory.isValid());
+}
+
+void tst_GltfMeshImporter::importQuad_data()
+{
+    QTest::addColumn<bool>("binary");
+    QTest::addColumn<int>("indexType");
+    QTest::addColumn<bool>("sparseHasBufferView");
+
+    for(bool binary : { true, false }) {
+        for(int indexType : { int(UnsignedShort), int(UnsignedInt) }) {
+            for(bool sparseHasBufferView : { true, false }) {
+                QTest::newRow(qPrintable(QString("%1, %2 indices, sparse %3")
+                                         .arg(binary ? "glb" : "gltf+bin")
+                                         .arg(indexType == UnsignedShort ? "uint16" : "uint32")
+                                         .arg(sparseHasBufferView ? "over buffer view" : "over zeros")))
+                        << binary << indexType << sparseHasBufferView;
+            }
+        }
+    }
+}
+
+void tst_GltfMeshImporter::importQuad()
+{
+    QFETCH(bool, binary);
+    QFETCH(int, indexType);
+    QFETCH(bool, sparseHasBufferView);
+
+    GltfBuilder builder;
+
+    // Positions of a unit quad. Sparse values either replace a bogus vertex of the base buffer view,
+    // or provide all non-zero vertices of an accessor without buffer view.
+    QJsonObject positions{ { "componentType", Float }, { "count", 4 }, { "type", "VEC3" } };
+    QByteArray sparseIndices, sparseValues;
+    if(sparseHasBufferView) {
+        QByteArray basePositions;
+        appendValues<float>(basePositions, { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 5.0f, 5.0f, 5.0f, 0.0f, 1.0f, 0.0f });
+        positions.insert("bufferView", builder.addBufferView(basePositions));
+        appendValues<quint8>(sparseIndices, { 2 });
+        appendValues<float>(sparseValues, { 1.0f, 1.0f, 0.0f });
+    }
+    else {
+        appendValues<quint8>(sparseIndices, { 1, 2, 3 });
+        appendValues<float>(sparseValues, { 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f });
+    }
+    const int numSparseValues = sparseIndices.size();
+    positions.insert("sparse", QJsonObject{
+        { "count", numSparseValues },
+        { "indices", QJsonObject{ { "bufferView", builder.addBufferView(sparseIndices) }, { "componentType", UnsignedByte } } },
+        { "values", QJsonObject{ { "bufferView", builder.addBufferView(sparseValues) } } },
+    });
+
+    // Normalized signed byte normals padded to 4 byte stride.
+    QByteArray normals;
+    for(int i=0; i < 4; ++i) {
+        appendValues<qint8>(normals, { 0, 0, 127, -1 });
+    }
+    const QJsonObject normalsAccessor{
+        { "bufferView", builder.addBufferView(normals, 4) },
+        { "componentType", Byte }, { "normalized", true }, { "count", 4 }, { "type", "VEC3" },
+    };
+
+    // Normalized unsigned short texture coordinates.
+    QByteArray texcoords;
+    appendValues<quint16>(texcoords, { 0, 0, 65535, 0, 65535, 65535, 0, 65535 });
+    const QJsonObject texcoordsAccessor{
+        { "bufferView", builder.addBufferView(texcoords) },
+        { "componentType", UnsignedShort }, { "normalized", true }, { "count", 4 }, { "type", "VEC2" },
+    };
+
+    QByteArray indices;
+    if(indexType == UnsignedShort) {
+        appendValues<quint16>(indices, { 0, 1, 2, 0, 2, 3 });
+    }
+    else {
+        appendValues<quint32>(indices, { 0, 1, 2, 0, 2, 3 });
+    }
+    const QJsonObject indicesAccessor{
+        { "bufferView", builder.addBufferView(indices) },
+        { "componentType", indexType }, { "count", 6 }, { "type", "SCALAR" },
+    };
+
+    builder.setPrimitive(QJsonObject{
+        { "attributes", QJsonObject{
+            { "POSITION", builder.addAccessor(positions) },
+            { "NORMAL", builder.addAccessor(normalsAccessor) },
+            { "TEXCOORD_0", builder.addAccessor(texcoordsAccessor) },
+        } },
+        { "indices", builder.addAccessor(indicesAccessor) },
+    });
+
+    const QString baseName = QString("quad-%1-%2").arg(indexType).arg(int(sparseHasBufferView));
+    QString path;
+    if(binary) {
+        path = m_directory.filePath(baseName + ".glb");
+        QVERIFY(builder.writeGlb(path));
+    }
+    else {
+        path = m_directory.filePath(baseName + ".gltf");
+        QVERIFY(builder.writeGltf(path, baseName + " buffer.bin"));
+    }
+
+    QGeometryData data;
+    QVERIFY(importMesh(path, data));
+    QVERIFY2(g_warnings.isEmpty(), qPrintable(g_warnings.join('\n')));
+
+    QCOMPARE(data.numVertices(), quint64(4));
+    QCOMPARE(data.numFaces(), quint64(2));
+
+    const QVector3D expectedPositions[] = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+    // V coordinate is flipped on import.
+    const QVector2D expectedTexcoords[] = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f } };
+    const QVertex *vertices = data.vertexData();
+    for(int i=0; i < 4; ++i) {
+        QVERIFY2(fuzzyCompare(vertices[i].position, expectedPositions[i]), qPrintable(QString("vertex %1 position").arg(i)));
+        QVERIFY2(fuzzyCompare(vertices[i].normal, QVector3D(0.0f, 0.0f, 1.0f)), qPrintable(QString("vertex %1 normal").arg(i)));
+        QVERIFY2(fuzzyCompare(vertices[i].tangent, QVector3D(1.0f, 0.0f, 0.0f)), qPrintable(QString("vertex %1 tangent").arg(i)));
+        QVERIFY2(fuzzyCompare(QVector3D(vertices[i].texcoord), QVector3D(expectedTexcoords[i])), qPrintable(QString("vertex %1 texcoord").arg(i)));
+    }
+
+    const quint32 expectedIndices[] = { 0, 1, 2, 0, 2, 3 };
+    const QTriangle *faces = data.faceData();
+    for(int i=0; i < 6; ++i) {
+        QCOMPARE(faces[i / 3].vertices[i % 3], expectedIndices[i]);
+    }
+}
+
+void tst_GltfMeshImporter::sparseIndexOutOfRange()
+{
+    GltfBuilder builder;
+
+    QByteArray positions;
+    appendValues<float>(positions, { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f });
+    QByteArray sparseIndices;
+    appendValues<quint16>(sparseIndices, { 3 });
+    QByteArray sparseValues;
+    appendValues<float>(sparseValues, { 1.0f, 1.0f, 1.0f });
+
+    const QJsonObject positionsAccessor{
+        { "bufferView", builder.addBufferView(positions) },
+        { "componentType", Float }, { "count", 3 }, { "type", "VEC3" },
+        { "sparse", QJsonObject{
+            { "count", 1 },
+            { "indices", QJsonObject{ { "bufferView", builder.addBufferView(sparseIndices) }, { "componentType", UnsignedShort } } },
+            { "values", QJsonObject{ { "bufferView", builder.addBufferView(sparseValues) } } },
+        } },
+    };
+    builder.setPrimitive(QJsonObject{ { "attributes", QJsonObject{ { "POSITION", builder.addAccessor(positionsAccessor) } } } });
+
+    const QString path = m_directory.filePath("invalid-sparse.glb");
+    QVERIFY(builder.writeGlb(path));
+
+    // Invalid documents are not imported natively; the importer hands them over to the default importer instead.
+    QGeometryData data;
+    importMesh(path, data);
+    QVERIFY(!g_warnings.isEmpty());
+    QVERIFY(g_warnings.first().contains("falling back to default importer"));
+}
+
+void tst_GltfMeshImporter::signedIndices_data()
+{
+    QTest::addColumn<int>("indexType");
+
+    QTest::newRow("BYTE") << int(Byte);
+    QTest::newRow("SHORT") << int(Short);
+}
+
+void tst_GltfMeshImporter::signedIndices()
+{
+    QFETCH(int, indexType);
+
+    GltfBuilder builder;
+
+    QByteArray positions;
+    appendValues<float>(positions, { 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f });
+    QByteArray indices;
+    if(indexType == Byte) {
+        appendValues<qint8>(indices, { 0, 1, 2 });
+    }
+    else {
+        appendValues<qint16>(indices, { 0, 1, 2 });
+    }
+
+    const QJsonObject positionsAccessor{
+        { "bufferView", builder.addBufferView(positions) },
+        { "componentType", Float }, { "count", 3 }, { "type", "VEC3" },
+    };
+    const QJsonObject indicesAccessor{
+        { "bufferView", builder.addBufferView(indices) },
+        { "componentType", indexType }, { "count", 3 }, { "type", "SCALAR" },
+    };
+    builder.setPrimitive(QJsonObject{
+        { "attributes", QJsonObject{ { "POSITION", builder.addAccessor(positionsAccessor) } } },
+        { "indices", builder.addAccessor(indicesAccessor) },
+    });
+
+    const QString path = m_directory.filePath(QString("signed-indices-%1.glb").arg(indexType));
+    QVERIFY(builder.writeGlb(path));
+
+    // Only unsigned index component types are valid glTF.
+    QGeometryData data;
+    importMesh(path, data);
+    QVERIFY(!g_warnings.isEmpty());
+    QVERIFY(g_warnings.first().contains("falling back to default importer"));
+}
+
+QTEST_APPLESS_MAIN(tst_GltfMeshImporter)
+
+#include "tst_gltfmeshimporter.moc"
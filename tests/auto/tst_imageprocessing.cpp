@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/imageprocessing_p.h>
+
+#include <QtTest>
+#include <QRandomGenerator>
+#include <QtCore/qfloat16.h>
+
+#include <cmath>
+#include <cstring>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+Q_DECLARE_METATYPE(Qt3DRaytrace::QImageData::ValueType)
+Q_DECLARE_METATYPE(Qt3DRaytrace::Raytrace::MipmapFilter)
+
+namespace {
+
+double srgbToLinear(double c)
+{
+    return (c <= 0.04045) ? (c / 12.92) : std::pow((c + 0.055) / 1.055, 2.4);
+}
+
+double linearToSrgb(double c)
+{
+    return (c <= 0.0031308) ? (c * 12.92) : (1.055 * std::pow(c, 1.0 / 2.4) - 0.055);
+}
+
+bool isSrgb(const QImageData &image, int channel)
+{
+    return image.type == QImageData::ValueType::UInt8 && image.channels >= 3 && channel < 3;
+}
+
+QImageData createImage(QImageData::ValueType type, int channels, int width, int height)
+{
+    QImageData image;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.type = type;
+    image.format = (channels == 4) ? QImageData::Format::RGBA : QImageData::Format::RGB;
+    image.data.resize(int(image.mipLevelSize(0)));
+    return image;
+}
+
+void fillRandom(QImageData &image, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    const int numValues = image.width * image.height * image.channels;
+    switch(image.type) {
+    case QImageData::ValueType::UInt8:
+        for(int i=0; i < numValues; ++i) {
+            image.data[i] = char(rng.bounded(256));
+        }
+        break;
+    case QImageData::ValueType::Float16: {
+        qfloat16 *values = reinterpret_cast<qfloat16*>(image.data.data());
+        for(int i=0; i < numValues; ++i) {
+            values[i] = qfloat16(float(rng.bounded(4.0)));
+        }
+        break;
+    }
+    case QImageData::ValueType::Float32: {
+        float *values = reinterpret_cast<float*>(image.data.data());
+        for(int i=0; i < numValues; ++i) {
+            values[i] = float(rng.bounded(4.0));
+        }
+        break;
+    }
+    default:
+        Q_UNREACHABLE();
+    }
+}
+
+// Value of a texel channel in linear space.
+double texelValue(const QImageData &image, const uchar *pixels, int width, int x, int y, int channel)
+{
+    const int index = (y * width + x) * image.channels + channel;
+    switch(image.type) {
+    case QImageData::ValueType::UInt8: {
+        const double value = pixels[index] / 255.0;
+        return isSrgb(image, channel) ? srgbToLinear(value) : value;
+    }
+    case QImageData::ValueType::Float16:
+        return double(float(reinterpret_cast<const qfloat16*>(pixels)[index]));
+    case QImageData::ValueType::Float32:
+        return double(reinterpret_cast<const float*>(pixels)[index]);
+    default:
+        Q_UNREACHABLE();
+    }
+    return 0.0;
+}
+
+// Source texels covered by destination texel of a power of two level: either two texels or one if the axis did not shrink.
+int footprint(int srcSize, int dstSize, int i, int *texels)
+{
+    if(srcSize == dstSize) {
+        texels[0] = i;
+        return 1;
+    }
+    texels[0] = 2 * i;
+    texels[1] = 2 * i + 1;
+    return 2;
+}
+
+// Compares mip level against a 2x2 box filter reference computed in double precision from the previous level.
+void verifyBoxFilteredLevel(const QImageData &image, int level)
+{
+    const int srcWidth = image.mipWidth(level - 1);
+    const int srcHeight = image.mipHeight(level - 1);
+    const int dstWidth = image.mipWidth(level);
+    const int dstHeight = image.mipHeight(level);
+    const uchar *src = image.constMipBits(level - 1);
+    const uchar *dst = image.constMipBits(level);
+
+    for(int y=0; y < dstHeight; ++y) {
+        int texelsY[2];
+        const int numTexelsY = footprint(srcHeight, dstHeight, y, texelsY);
+        for(int x=0; x < dstWidth; ++x) {
+            int texelsX[2];
+            const int numTexelsX = footprint(srcWidth, dstWidth, x, texelsX);
+            for(int c=0; c < image.channels; ++c) {
+                double sum = 0.0;
+                for(int j=0; j < numTexelsY; ++j) {
+                    for(int i=0; i < numTexelsX; ++i) {
+                        sum += texelValue(image, src, srcWidth, texelsX[i], texelsY[j], c);
+                    }
+                }
+                const double expected = sum / (numTexelsX * numTexelsY);
+                const int index = (y * dstWidth + x) * image.channels + c;
+
+                bool isEqual = false;
+                double actual = 0.0;
+                double reference = expected;
+                if(image.type == QImageData::ValueType::UInt8) {
+                    // Allow off by one for rounding of values close to quantization boundaries.
+                    reference = std::round(255.0 * (isSrgb(image, c) ? linearToSrgb(expected) : expected));
+                    actual = dst[index];
+                    isEqual = std::abs(actual - reference) <= 1.0;
+                }
+                else {
+                    actual = texelValue(image, dst, dstWidth, x, y, c);
+                    const double tolerance = (image.type == QImageData::ValueType::Float16) ? 2e-3 : 1e-5;
+                    isEqual = std::abs(actual - reference) <= tolerance * qMax(1.0, std::abs(reference));
+                }
+                QVERIFY2(isEqual, qPrintable(QString("level %1 texel (%2, %3) channel %4: %5 != %6")
+                                             .arg(level).arg(x).arg(y).arg(c).arg(actual).arg(reference)));
+            }
+        }
+    }
+}
+
+} // anonymous
+
+class tst_ImageProcessing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void boxFilterMatchesReference_data();
+    void boxFilterMatchesReference();
+    void filtersPreserveConstantImages_data();
+    void filtersPreserveConstantImages();
+    void filtersAverageInLinearSpace_data();
+    void filtersAverageInLinearSpace();
+    void rejectsCompressedImages();
+};
+
+void tst_ImageProcessing::boxFilterMatchesReference_data()
+{
+    QTest::addColumn<QImageData::ValueType>("type");
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+
+    QTest::newRow("UInt8 RGBA (sRGB)") << QImageData::ValueType::UInt8 << 4 << 32 << 32;
+    QTest::newRow("UInt8 RGB (sRGB)") << QImageData::ValueType::UInt8 << 3 << 16 << 64;
+    QTest::newRow("UInt8 RG (linear)") << QImageData::ValueType::UInt8 << 2 << 64 << 4;
+    QTest::newRow("Float16 RGBA") << QImageData::ValueType::Float16 << 4 << 32 << 16;
+    QTest::newRow("Float16 RGB") << QImageData::ValueType::Float16 << 3 << 8 << 32;
+    QTest::newRow("Float32 RGBA") << QImageData::ValueType::Float32 << 4 << 16 << 16;
+    QTest::newRow("Float32 R") << QImageData::ValueType::Float32 << 1 << 128 << 2;
+}
+
+void tst_ImageProcessing::boxFilterMatchesReference()
+{
+    QFETCH(QImageData::ValueType, type);
+    QFETCH(int, channels);
+    QFETCH(int, width);
+    QFETCH(int, height);
+
+    QImageData image = createImage(type, channels, width, height);
+    fillRandom(image, quint32(width * height * channels));
+    const QByteArray level0 = image.data;
+
+    QVERIFY(generateMipmaps(image, MipmapFilter::Box));
+    QCOMPARE(image.mipLevels, QImageData::maxMipLevels(width, height));
+    QVERIFY(image.sizeInBytes() >= image.expectedSizeInBytes());
+    QVERIFY(std::memcmp(image.constMipBits(0), level0.constData(), size_t(level0.size())) == 0);
+
+    for(int level=1; level < image.mipLevels; ++level) {
+        verifyBoxFilteredLevel(image, level);
+        if(QTest::currentTestFailed()) {
+            return;
+        }
+    }
+}
+
+void tst_ImageProcessing::filtersPreserveConstantImages_data()
+{
+    QTest::addColumn<QImageData::ValueType>("type");
+    QTest::addColumn<MipmapFilter>("filter");
+
+    QTest::newRow("UInt8, box") << QImageData::ValueType::UInt8 << MipmapFilter::Box;
+    QTest::newRow("UInt8, kaiser") << QImageData::ValueType::UInt8 << MipmapFilter::Kaiser;
+    QTest::newRow("Float16, box") << QImageData::ValueType::Float16 << MipmapFilter::Box;
+    QTest::newRow("Float16, kaiser") << QImageData::ValueType::Float16 << MipmapFilter::Kaiser;
+    QTest::newRow("Float32, box") << QImageData::ValueType::Float32 << MipmapFilter::Box;
+    QTest::newRow("Float32, kaiser") << QImageData::ValueType::Float32 << MipmapFilter::Kaiser;
+}
+
+void tst_ImageProcessing::filtersPreserveConstantImages()
+{
+    QFETCH(QImageData::ValueType, type);
+    QFETCH(MipmapFilter, filter);
+
+    // Odd, non power of two dimensions exercise fractional filter footprints; normalized weights must keep flat images flat.
+    const int width = 37;
+    const int height = 21;
+    const double values[4] = { 0.25, 0.5, 0.75, 1.0 };
+
+    QImageData image = createImage(type, 4, width, height);
+    for(int i=0; i < width * height; ++i) {
+        for(int c=0; c < 4; ++c) {
+            const int index = i * 4 + c;
+            switch(type) {
+            case QImageData::ValueType::UInt8:
+                image.data[index] = char(uchar(values[c] * 255.0 + 0.5));
+                break;
+            case QImageData::ValueType::Float16:
+                reinterpret_cast<qfloat16*>(image.data.data())[index] = qfloat16(float(values[c]));
+                break;
+            default:
+                reinterpret_cast<float*>(image.data.data())[index] = float(values[c]);
+                break;
+            }
+        }
+    }
+    const QImageData source = image;
+
+    QVERIFY(generateMipmaps(image, filter));
+    QCOMPARE(image.mipLevels, 6);
+    for(int level=1; level < image.mipLevels; ++level) {
+        const int levelWidth = image.mipWidth(level);
+        for(int y=0; y < image.mipHeight(level); ++y) {
+            for(int x=0; x < levelWidth; ++x) {
+                for(int c=0; c < 4; ++c) {
+                    const double expected = texelValue(source, source.constMipBits(0), width, 0, 0, c);
+                    const double actual = texelValue(image, image.constMipBits(level), levelWidth, x, y, c);
+                    QVERIFY2(std::abs(actual - expected) <= 1e-3 * qMax(1.0, expected),
+                             qPrintable(QString("level %1 texel (%2, %3) channel %4: %5 != %6")
+                                        .arg(level).arg(x).arg(y).arg(c).arg(actual).arg(expected)));
+                }
+            }
+        }
+    }
+}
+
+void tst_ImageProcessing::filtersAverageInLinearSpace_data()
+{
+    QTest::addColumn<MipmapFilter>("filter");
+
+    QTest::newRow("box") << MipmapFilter::Box;
+    QTest::newRow("kaiser") << MipmapFilter::Kaiser;
+}
+
+void tst_ImageProcessing::filtersAverageInLinearSpace()
+{
+    QFETCH(MipmapFilter, filter);
+
+    // Black & white checkerboard: linear average of sRGB colors is 0.5, which encodes to 188 rather than 128.
+    // Alpha is always linear and averages to 128.
+    QImageData image = createImage(QImageData::ValueType::UInt8, 4, 16, 16);
+    for(int y=0; y < image.height; ++y) {
+        for(int x=0; x < image.width; ++x) {
+            const char value = ((x + y) % 2 == 0) ? char(255) : char(0);
+            for(int c=0; c < 4; ++c) {
+                image.data[(y * image.width + x) * 4 + c] = value;
+            }
+        }
+    }
+
+    QVERIFY(generateMipmaps(image, filter));
+    for(int level=1; level < image.mipLevels; ++level) {
+        const uchar *pixels = image.constMipBits(level);
+        for(int i=0; i < image.mipWidth(level) * image.mipHeight(level); ++i) {
+            QVERIFY(qAbs(int(pixels[i * 4 + 0]) - 188) <= 1);
+            QVERIFY(qAbs(int(pixels[i * 4 + 1]) - 188) <= 1);
+            QVERIFY(qAbs(int(pixels[i * 4 + 2]) - 188) <= 1);
+            QVERIFY(qAbs(int(pixels[i * 4 + 3]) - 128) <= 1);
+        }
+    }
+}
+
+void tst_ImageProcessing::rejectsCompressedImages()
+{
+    QImageData image;
+    image.width = 16;
+    image.height = 16;
+    image.channels = 4;
+    image.type = QImageData::ValueType::UInt8;
+    image.format = QImageData::Format::RGBA;
+    image.blockFormat = QImageData::BlockFormat::BC1;
+    image.data.resize(int(image.mipLevelSize(0)));
+
+    QTest::ignoreMessage(QtWarningMsg, "Cannot generate mipmaps: image is block compressed");
+    QVERIFY(!generateMipmaps(image));
+    QCOMPARE(image.mipLevels, 1);
+}
+
+QTEST_APPLESS_MAIN(tst_ImageProcessing)
+
+#include "tst_imageprocessing.moc"
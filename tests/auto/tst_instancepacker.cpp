@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/instancepacker.h>
+
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include <cmath>
+
+using namespace Qt3DRaytrace::Vulkan;
+
+namespace {
+
+QMatrix4x4 randomTransform(QRandomGenerator &rng)
+{
+    auto uniform = [&rng](float min, float max) {
+        return min + float(rng.generateDouble()) * (max - min);
+    };
+
+    QMatrix4x4 m;
+    m.translate(uniform(-100.0f, 100.0f), uniform(-100.0f, 100.0f), uniform(-100.0f, 100.0f));
+    m.rotate(uniform(0.0f, 360.0f), uniform(-1.0f, 1.0f), uniform(-1.0f, 1.0f), uniform(0.1f, 1.0f));
+    m.scale(uniform(0.1f, 10.0f), uniform(0.1f, 10.0f), uniform(0.1f, 10.0f));
+    return m;
+}
+
+void verifyNormalMatrix(const float *actual, const QMatrix4x4 &transform, int stride=1)
+{
+    const QMatrix3x3 expected = transform.normalMatrix();
+    for(int k=0; k < 9; ++k) {
+        const float tolerance = 1e-4f * qMax(1.0f, std::abs(expected.constData()[k]));
+        QVERIFY2(std::abs(actual[k * stride] - expected.constData()[k]) <= tolerance,
+                 qPrintable(QString("element %1: %2 != %3").arg(k).arg(actual[k * stride]).arg(expected.constData()[k])));
+    }
+}
+
+void verifyBasisTransform(const EntityInstance &instance, const QMatrix4x4 &transform)
+{
+    const float *b = instance.basisTransform.data;
+    const float basis[9] = { b[0], b[1], b[2], b[4], b[5], b[6], b[8], b[9], b[10] };
+    verifyNormalMatrix(basis, transform);
+}
+
+} // anonymous
+
+class tst_InstancePacker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void normalMatrices_data();
+    void normalMatrices();
+    void singularNormalMatrices();
+    void packReportsDirtyRanges();
+    void packComputesBasisTransforms();
+    void clearedInstances();
+    void invalidateUploadsEverything();
+};
+
+void tst_InstancePacker::normalMatrices_data()
+{
+    QTest::addColumn<int>("count");
+
+    // Counts not divisible by the SIMD width exercise the scalar remainder.
+    QTest::newRow("1") << 1;
+    QTest::newRow("4") << 4;
+    QTest::newRow("7") << 7;
+    QTest::newRow("1023") << 1023;
+}
+
+void tst_InstancePacker::normalMatrices()
+{
+    QFETCH(int, count);
+
+    QRandomGenerator rng(count);
+    QVector<QMatrix4x4> transforms(count);
+    QVector<float> inputs(9 * count);
+    QVector<float> outputs(9 * count);
+    for(int i=0; i < count; ++i) {
+        transforms[i] = randomTransform(rng);
+        const float *m = transforms[i].constData();
+        for(int c=0; c < 3; ++c) {
+            for(int r=0; r < 3; ++r) {
+                inputs[(c * 3 + r) * count + i] = m[c * 4 + r];
+            }
+        }
+    }
+
+    const float *in[9];
+    float *out[9];
+    for(int k=0; k < 9; ++k) {
+        in[k] = inputs.constData() + k * count;
+        out[k] = outputs.data() + k * count;
+    }
+    InstancePacker::computeNormalMatrices(in, out, count);
+
+    for(int i=0; i < count; ++i) {
+        verifyNormalMatrix(outputs.constData() + i, transforms[i], count);
+    }
+}
+
+void tst_InstancePacker::singularNormalMatrices()
+{
+    constexpr int Count = 5;
+
+    float inputs[9][Count] = {};
+    float outputs[9][Count];
+    // First matrix is a uniform scale, remaining matrices have zero determinant.
+    inputs[0][0] = inputs[4][0] = inputs[8][0] = 2.0f;
+    inputs[0][2] = inputs[4][2] = 1.0f;
+    inputs[0][3] = inputs[3][3] = inputs[6][3] = 1.0f;
+
+    const float *in[9];
+    float *out[9];
+    for(int k=0; k < 9; ++k) {
+        in[k] = inputs[k];
+        out[k] = outputs[k];
+    }
+    InstancePacker::computeNormalMatrices(in, out, Count);
+
+    for(int i=0; i < Count; ++i) {
+        for(int k=0; k < 9; ++k) {
+            const bool isDiagonal = (k == 0 || k == 4 || k == 8);
+            const float expected = (i == 0) ? (isDiagonal ? 0.5f : 0.0f) : (isDiagonal ? 1.0f : 0.0f);
+            QCOMPARE(outputs[k][i], expected);
+        }
+    }
+}
+
+void tst_InstancePacker::packReportsDirtyRanges()
+{
+    constexpr uint32_t Count = 100;
+    constexpr uint32_t MaxRangeGap = 4;
+
+    InstancePacker packer;
+    packer.resize(Count);
+
+    QMatrix4x4 transform;
+    for(uint32_t i=0; i < Count; ++i) {
+        packer.setInstance(i, i, i, 1, transform.constData());
+    }
+    QVector<InstancePacker::Range> ranges = packer.pack(MaxRangeGap);
+    QCOMPARE(ranges.size(), 1);
+    QCOMPARE(ranges[0].first, 0u);
+    QCOMPARE(ranges[0].count, Count);
+
+    // Unchanged inputs produce no uploads.
+    for(uint32_t i=0; i < Count; ++i) {
+        packer.setInstance(i, i, i, 1, transform.constData());
+    }
+    QVERIFY(packer.pack(MaxRangeGap).isEmpty());
+
+    // Nearby modifications are coalesced, distant ones are not.
+    QMatrix4x4 moved;
+    moved.translate(1.0f, 0.0f, 0.0f);
+    packer.setInstance(10, 10, 10, 1, moved.constData());
+    packer.setInstance(13, 99, 13, 1, transform.constData());
+    packer.setInstance(50, 50, 50, 1, moved.constData());
+    ranges = packer.pack(MaxRangeGap);
+    QCOMPARE(ranges.size(), 2);
+    QCOMPARE(ranges[0].first, 10u);
+    QCOMPARE(ranges[0].count, 4u);
+    QCOMPARE(ranges[1].first, 50u);
+    QCOMPARE(ranges[1].count, 1u);
+
+    QCOMPARE(packer.instances()[13].materialIndex, 99u);
+    QCOMPARE(packer.instances()[10].transform.data[12], 1.0f);
+}
+
+void tst_InstancePacker::packComputesBasisTransforms()
+{
+    constexpr uint32_t Count = 1000;
+
+    QRandomGenerator rng(42);
+    QVector<QMatrix4x4> transforms(Count);
+
+    InstancePacker packer;
+    packer.resize(Count);
+    for(uint32_t i=0; i < Count; ++i) {
+        transforms[int(i)] = randomTransform(rng);
+        packer.setInstance(i, 0, 0, 1, transforms[int(i)].constData());
+    }
+    packer.pack();
+    for(uint32_t i=0; i < Count; ++i) {
+        verifyBasisTransform(packer.instances()[i], transforms[int(i)]);
+    }
+
+    // Only modified instances are recomputed, but all must remain correct.
+    for(uint32_t i=0; i < Count; i += 7) {
+        transforms[int(i)] = randomTransform(rng);
+        packer.setInstance(i, 0, 0, 1, transforms[int(i)].constData());
+    }
+    packer.pack();
+    for(uint32_t i=0; i < Count; ++i) {
+        verifyBasisTransform(packer.instances()[i], transforms[int(i)]);
+    }
+}
+
+void tst_InstancePacker::clearedInstances()
+{
+    InstancePacker packer;
+    packer.resize(8);
+
+    QMatrix4x4 transform;
+    transform.scale(2.0f);
+    for(uint32_t i=0; i < 8; ++i) {
+        packer.setInstance(i, 1, 1, 1, transform.constData());
+    }
+    packer.pack(0);
+
+    packer.clearInstance(3);
+    packer.clearInstance(3);
+    QVector<InstancePacker::Range> ranges = packer.pack(0);
+    QCOMPARE(ranges.size(), 1);
+    QCOMPARE(ranges[0].first, 3u);
+    QCOMPARE(ranges[0].count, 1u);
+    QCOMPARE(packer.instances()[3].materialIndex, 0u);
+    QCOMPARE(packer.instances()[3].transform.data[0], 0.0f);
+
+    // Reusing a cleared instance must upload it and compute its basis even if inputs match the cleared contents.
+    const float zero[16] = {};
+    packer.setInstance(3, 0, 0, 0, zero);
+    ranges = packer.pack(0);
+    QCOMPARE(ranges.size(), 1);
+    QCOMPARE(ranges[0].first, 3u);
+    verifyBasisTransform(packer.instances()[3], QMatrix4x4(zero));
+}
+
+void tst_InstancePacker::invalidateUploadsEverything()
+{
+    InstancePacker packer;
+    packer.resize(16);
+    for(uint32_t i=0; i < 16; ++i) {
+        packer.setInstance(i, 0, 0, 1, QMatrix4x4().constData());
+    }
+    packer.pack();
+    QVERIFY(packer.pack().isEmpty());
+
+    packer.invalidate();
+    const QVector<InstancePacker::Range> ranges = packer.pack();
+    QCOMPARE(ranges.size(), 1);
+    QCOMPARE(ranges[0].first, 0u);
+    QCOMPARE(ranges[0].count, 16u);
+}
+
+QTEST_APPLESS_MAIN(tst_InstancePacker)
+
+#include "tst_instancepacker.moc"
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/meshprocessing_p.h>
+
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <unordered_set>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+constexpr int VertexCacheSize = 16;
+
+// Flat grid of size x size quads, two triangles per quad, in scanline order.
+QGeometryData createGrid(int size)
+{
+    QGeometryData data;
+    for(int y=0; y <= size; ++y) {
+        for(int x=0; x <= size; ++x) {
+            QVertex vertex;
+            vertex.position = QVector3D(float(x), float(y), 0.0f);
+            vertex.normal = QVector3D(0.0f, 0.0f, 1.0f);
+            vertex.tangent = QVector3D(1.0f, 0.0f, 0.0f);
+            vertex.texcoord = QVector2D(float(x) / size, float(y) / size);
+            data.vertices.append(vertex);
+        }
+    }
+    for(int y=0; y < size; ++y) {
+        for(int x=0; x < size; ++x) {
+            const quint32 v00 = quint32(y * (size + 1) + x);
+            const quint32 v10 = v00 + 1;
+            const quint32 v01 = v00 + quint32(size + 1);
+            const quint32 v11 = v01 + 1;
+            data.faces.append(QTriangle{{ v00, v10, v11 }});
+            data.faces.append(QTriangle{{ v00, v11, v01 }});
+        }
+    }
+    return data;
+}
+
+void shuffleFaces(QGeometryData &data, quint32 seed)
+{
+    QRandomGenerator rng(seed);
+    for(int i=data.faces.size()-1; i > 0; --i) {
+        std::swap(data.faces[i], data.faces[int(rng.bounded(i + 1))]);
+    }
+}
+
+// Average cache miss ratio: vertex transforms per triangle with a FIFO post-transform cache.
+double computeACMR(const QGeometryData &data)
+{
+    std::deque<quint32> cache;
+    std::unordered_set<quint32> cached;
+    int numMisses = 0;
+    for(const QTriangle &face : data.faces) {
+        for(quint32 index : face.vertices) {
+            if(cached.count(index) == 0) {
+                ++numMisses;
+                cache.push_back(index);
+                cached.insert(index);
+                if(int(cache.size()) > VertexCacheSize) {
+                    cached.erase(cache.front());
+                    cache.pop_front();
+                }
+            }
+        }
+    }
+    return double(numMisses) / data.faces.size();
+}
+
+// Triangle as a rotation-invariant tuple of vertex positions, to compare meshes regardless of vertex numbering.
+using PositionTriangle = std::array<std::array<float, 3>, 3>;
+
+QVector<PositionTriangle> positionTriangles(const QGeometryData &data)
+{
+    QVector<PositionTriangle> triangles;
+    for(const QTriangle &face : data.faces) {
+        PositionTriangle triangle;
+        for(int k=0; k < 3; ++k) {
+            const QVector3D &p = data.vertices[int(face.vertices[k])].position;
+            triangle[k] = {{ p.x(), p.y(), p.z() }};
+        }
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.append(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+} // anonymous
+
+class tst_MeshProcessing : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void optimizeImprovesVertexCacheLocality();
+    void optimizePreservesTriangles();
+    void optimizeRemovesDegenerateAndDuplicateTriangles();
+    void optimizeCompactsVertices();
+};
+
+void tst_MeshProcessing::optimizeImprovesVertexCacheLocality()
+{
+    QGeometryData data = createGrid(64);
+    shuffleFaces(data, 1);
+
+    // Randomly ordered triangles miss the cache on almost every vertex.
+    const double shuffledACMR = computeACMR(data);
+    QVERIFY(shuffledACMR > 2.5);
+
+    optimizeMesh(data);
+    const double optimizedACMR = computeACMR(data);
+    QVERIFY2(optimizedACMR < 1.0, qPrintable(QString("ACMR %1 -> %2").arg(shuffledACMR).arg(optimizedACMR)));
+}
+
+void tst_MeshProcessing::optimizePreservesTriangles()
+{
+    QGeometryData data = createGrid(16);
+    shuffleFaces(data, 2);
+    const QVector<PositionTriangle> expected = positionTriangles(data);
+
+    optimizeMesh(data);
+    QCOMPARE(data.faces.size(), expected.size());
+    QVERIFY(positionTriangles(data) == expected);
+}
+
+void tst_MeshProcessing::optimizeRemovesDegenerateAndDuplicateTriangles()
+{
+    QGeometryData data = createGrid(4);
+    const int numFaces = data.faces.size();
+
+    // Repeated index, collinear vertices, exact duplicate and rotated duplicate.
+    data.faces.append(QTriangle{{ 0, 0, 1 }});
+    data.faces.append(QTriangle{{ 0, 1, 2 }});
+    const QTriangle duplicate = data.faces[3];
+    const QTriangle rotated = data.faces[5];
+    data.faces.append(duplicate);
+    data.faces.append(QTriangle{{ rotated.vertices[1], rotated.vertices[2], rotated.vertices[0] }});
+    shuffleFaces(data, 3);
+
+    optimizeMesh(data);
+    QCOMPARE(data.faces.size(), numFaces);
+    QVERIFY(positionTriangles(data) == positionTriangles(createGrid(4)));
+}
+
+void tst_MeshProcessing::optimizeCompactsVertices()
+{
+    QGeometryData data = createGrid(8);
+    const int numVertices = data.vertices.size();
+
+    // Unreferenced vertex and a vertex referenced only by a degenerate triangle.
+    QVertex unused;
+    unused.position = QVector3D(100.0f, 100.0f, 100.0f);
+    data.vertices.append(unused);
+    data.vertices.append(unused);
+    data.faces.append(QTriangle{{ 0, quint32(numVertices + 1), quint32(numVertices + 1) }});
+
+    optimizeMesh(data);
+    QCOMPARE(data.vertices.size(), numVertices);
+    QVERIFY(data.vertexStorage.isNull() && data.faceStorage.isNull());
+
+    // Vertices are numbered in order of first use.
+    quint32 nextVertex = 0;
+    for(const QTriangle &face : qAsConst(data.faces)) {
+        for(quint32 index : face.vertices) {
+            QVERIFY(index <= nextVertex);
+            if(index == nextVertex) {
+                ++nextVertex;
+            }
+        }
+    }
+    QCOMPARE(int(nextVertex), numVertices);
+}
+
+QTEST_APPLESS_MAIN(tst_MeshProcessing)
+
+#include "tst_meshprocessing.moc"
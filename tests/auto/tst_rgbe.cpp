@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/rgbe_p.h>
+
+#include <QtTest>
+#include <QBuffer>
+#include <QRegularExpression>
+#include <QtCore/qfloat16.h>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+QByteArray makeHeader(int width, int height)
+{
+    return QStringLiteral("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %1 +X %2\n").arg(height).arg(width).toLatin1();
+}
+
+void appendPixel(QByteArray &bytes, int r, int g, int b, int e)
+{
+    bytes.append(char(r));
+    bytes.append(char(g));
+    bytes.append(char(b));
+    bytes.append(char(e));
+}
+
+float rgbeToFloat(int value, int exponent)
+{
+    return exponent ? std::ldexp(float(value), exponent - (128 + 8)) : 0.0f;
+}
+
+// Floating point RGBA image; the left third of every row is constant so that encoded scanlines contain runs.
+QImageData makeImage(int width, int height)
+{
+    QImageData image;
+    image.width = width;
+    image.height = height;
+    image.channels = 4;
+    image.type = QImageData::ValueType::Float32;
+    image.format = QImageData::Format::RGBA;
+    image.data.resize(width * height * 4 * int(sizeof(float)));
+
+    std::mt19937 generator(1234);
+    std::uniform_real_distribution<float> distribution(0.01f, 1000.0f);
+    float *texels = reinterpret_cast<float*>(image.data.data());
+    for(int y=0; y < height; ++y) {
+        for(int x=0; x < width; ++x) {
+            float *texel = texels + (y * width + x) * 4;
+            for(int c=0; c < 3; ++c) {
+                texel[c] = (x < width / 3) ? float(c + 1) : distribution(generator);
+            }
+            texel[3] = 0.5f;
+        }
+    }
+    return image;
+}
+
+QByteArray encodeImage(const QImageData &image)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QBuffer::WriteOnly);
+    return encodeRgbeImage(image, &buffer) ? bytes : QByteArray();
+}
+
+bool decodeImage(const QByteArray &bytes, QImageData::ValueType type, QImageData &image)
+{
+    return decodeRgbeImage(reinterpret_cast<const uchar*>(bytes.constData()), quint64(bytes.size()), type, false, image);
+}
+
+const float *texelData(const QImageData &image)
+{
+    return reinterpret_cast<const float*>(image.constBits());
+}
+
+} // anonymous
+
+class tst_Rgbe : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void roundTrip_data();
+    void roundTrip();
+    void oldStyleRle();
+    void newStyleRle();
+    void invalidData_data();
+    void invalidData();
+};
+
+void tst_Rgbe::initTestCase()
+{
+    stbi_set_flip_vertically_on_load(0);
+}
+
+void tst_Rgbe::roundTrip_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<bool>("isRunLengthEncoded");
+
+    // Scanlines shorter than 8 or longer than 0x7fff texels are always stored flat.
+    QTest::newRow("flat, narrow") << 5 << 7 << false;
+    QTest::newRow("RLE") << 97 << 130 << true;
+    QTest::newRow("RLE, widest") << 0x7fff << 2 << true;
+    QTest::newRow("flat, wide") << 0x8000 << 2 << false;
+}
+
+void tst_Rgbe::roundTrip()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(bool, isRunLengthEncoded);
+
+    const QImageData source = makeImage(width, height);
+    const QByteArray encoded = encodeImage(source);
+    QVERIFY(!encoded.isEmpty());
+
+    const QByteArray header = makeHeader(width, height);
+    QVERIFY(encoded.startsWith(header));
+    const bool hasRleMarker = encoded.at(header.size()) == 2 && encoded.at(header.size() + 1) == 2;
+    QCOMPARE(hasRleMarker, isRunLengthEncoded);
+
+    QImageData decoded;
+    QVERIFY(decodeImage(encoded, QImageData::ValueType::Float32, decoded));
+    QCOMPARE(decoded.width, width);
+    QCOMPARE(decoded.height, height);
+    QCOMPARE(decoded.channels, 4);
+    QVERIFY(decoded.sizeInBytes() >= decoded.expectedSizeInBytes());
+
+    // Shared exponent keeps 8 significant bits of the largest component; others lose precision relative to it.
+    const float *sourceTexels = texelData(source);
+    const float *decodedTexels = texelData(decoded);
+    for(int i=0; i < width * height; ++i) {
+        const float *sourceTexel = sourceTexels + i * 4;
+        const float *decodedTexel = decodedTexels + i * 4;
+        const float maxComponent = std::max(sourceTexel[0], std::max(sourceTexel[1], sourceTexel[2]));
+        for(int c=0; c < 3; ++c) {
+            if(std::abs(decodedTexel[c] - sourceTexel[c]) > maxComponent / 128.0f) {
+                QFAIL(qPrintable(QString("Texel %1 component %2: expected %3, got %4").arg(i).arg(c).arg(sourceTexel[c]).arg(decodedTexel[c])));
+            }
+        }
+        QCOMPARE(decodedTexel[3], 1.0f);
+    }
+
+    // Half float output holds the same values, since RGBE values have no more than 8 significant bits.
+    QImageData decodedHalf;
+    QVERIFY(decodeImage(encoded, QImageData::ValueType::Float16, decodedHalf));
+    std::vector<float> halfTexels(size_t(width) * size_t(height) * 4);
+    qFloatFromFloat16(halfTexels.data(), reinterpret_cast<const qfloat16*>(decodedHalf.constBits()), qsizetype(halfTexels.size()));
+    QVERIFY(std::equal(halfTexels.begin(), halfTexels.end(), decodedTexels));
+
+    // Reference decoder must read the same file to the same values.
+    int stbWidth, stbHeight, stbChannels;
+    float *stbTexels = stbi_loadf_from_memory(reinterpret_cast<const stbi_uc*>(encoded.constData()), encoded.size(),
+                                              &stbWidth, &stbHeight, &stbChannels, 4);
+    QVERIFY(stbTexels);
+    const bool isEqualToReference = stbWidth == width && stbHeight == height &&
+                                    std::equal(stbTexels, stbTexels + size_t(width) * size_t(height) * 4, decodedTexels);
+    stbi_image_free(stbTexels);
+    QVERIFY(isEqualToReference);
+}
+
+void tst_Rgbe::oldStyleRle()
+{
+    constexpr int Width = 300;
+
+    // First pixel repeated 3 + (1 << 8) times by two consecutive run pixels, followed by literal pixels.
+    QByteArray bytes = makeHeader(Width, 2);
+    appendPixel(bytes, 200, 100, 50, 130);
+    appendPixel(bytes, 1, 1, 1, 3);
+    appendPixel(bytes, 1, 1, 1, 1);
+    for(int x=260; x < Width; ++x) {
+        appendPixel(bytes, x - 100, 10, 20, 129);
+    }
+    // Run counter restarts after a literal pixel.
+    for(int x=0; x < Width / 2; ++x) {
+        appendPixel(bytes, 150, 150, 150, 127);
+        appendPixel(bytes, 1, 1, 1, 1);
+    }
+
+    QImageData decoded;
+    QVERIFY(decodeImage(bytes, QImageData::ValueType::Float32, decoded));
+    const float *texels = texelData(decoded);
+    for(int x=0; x < Width; ++x) {
+        const float *texel = texels + x * 4;
+        if(x < 260) {
+            QCOMPARE(texel[0], rgbeToFloat(200, 130));
+            QCOMPARE(texel[1], rgbeToFloat(100, 130));
+            QCOMPARE(texel[2], rgbeToFloat(50, 130));
+        }
+        else {
+            QCOMPARE(texel[0], rgbeToFloat(x - 100, 129));
+            QCOMPARE(texel[1], rgbeToFloat(10, 129));
+            QCOMPARE(texel[2], rgbeToFloat(20, 129));
+        }
+    }
+    for(int x=0; x < Width; ++x) {
+        const float *texel = texels + (Width + x) * 4;
+        QCOMPARE(texel[0], rgbeToFloat(150, 127));
+        QCOMPARE(texel[2], rgbeToFloat(150, 127));
+    }
+}
+
+void tst_Rgbe::newStyleRle()
+{
+    // Each plane of an 8 texel scanline mixes runs and literals.
+    QByteArray bytes = makeHeader(8, 1);
+    const uchar scanline[] = {
+        2, 2, 0, 8,
+        128 + 8, 128,
+        8, 0, 10, 20, 30, 40, 50, 60, 70,
+        128 + 4, 64, 4, 1, 2, 3, 4,
+        128 + 3, 129, 128 + 5, 130,
+    };
+    bytes.append(reinterpret_cast<const char*>(scanline), int(sizeof(scanline)));
+
+    QImageData decoded;
+    QVERIFY(decodeImage(bytes, QImageData::ValueType::Float32, decoded));
+    const float *texels = texelData(decoded);
+    const int blue[] = { 64, 64, 64, 64, 1, 2, 3, 4 };
+    for(int x=0; x < 8; ++x) {
+        const int exponent = (x < 3) ? 129 : 130;
+        QCOMPARE(texels[x * 4 + 0], rgbeToFloat(128, exponent));
+        QCOMPARE(texels[x * 4 + 1], rgbeToFloat(x * 10, exponent));
+        QCOMPARE(texels[x * 4 + 2], rgbeToFloat(blue[x], exponent));
+        QCOMPARE(texels[x * 4 + 3], 1.0f);
+    }
+
+    int stbWidth, stbHeight, stbChannels;
+    float *stbTexels = stbi_loadf_from_memory(reinterpret_cast<const stbi_uc*>(bytes.constData()), bytes.size(),
+                                              &stbWidth, &stbHeight, &stbChannels, 4);
+    QVERIFY(stbTexels);
+    const bool isEqualToReference = std::equal(stbTexels, stbTexels + 8 * 4, texels);
+    stbi_image_free(stbTexels);
+    QVERIFY(isEqualToReference);
+}
+
+void tst_Rgbe::invalidData_data()
+{
+    QTest::addColumn<QByteArray>("bytes");
+    QTest::addColumn<QString>("message");
+
+    const QString invalidScanline = QStringLiteral("invalid or truncated scanline");
+
+    QByteArray truncated = encodeImage(makeImage(97, 4));
+    truncated.chop(10);
+    QTest::newRow("truncated RLE") << truncated << invalidScanline;
+
+    QByteArray truncatedFlat = encodeImage(makeImage(5, 4));
+    truncatedFlat.chop(2);
+    QTest::newRow("truncated flat") << truncatedFlat << invalidScanline;
+
+    QTest::newRow("truncated header") << QByteArray("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n") << QStringLiteral("Invalid Radiance HDR image header");
+
+    const QByteArray rleHeader = makeHeader(8, 1) + QByteArray::fromHex("02020008");
+    QTest::newRow("zero count") << rleHeader + QByteArray::fromHex("00") << invalidScanline;
+    QTest::newRow("run past width") << rleHeader + QByteArray::fromHex("8980") << invalidScanline;
+    QTest::newRow("literal past width") << rleHeader + QByteArray::fromHex("09000102030405060708") << invalidScanline;
+    QTest::newRow("truncated run") << rleHeader + QByteArray::fromHex("88") << invalidScanline;
+
+    QTest::newRow("old-style run at start") << makeHeader(4, 1) + QByteArray::fromHex("01010104") << invalidScanline;
+    QTest::newRow("old-style run past width") << makeHeader(4, 1) + QByteArray::fromHex("8080808001010104") << invalidScanline;
+}
+
+void tst_Rgbe::invalidData()
+{
+    QFETCH(QByteArray, bytes);
+    QFETCH(QString, message);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QRegularExpression::escape(message)));
+    QImageData decoded;
+    QVERIFY(!decodeImage(bytes, QImageData::ValueType::Float16, decoded));
+}
+
+QTEST_APPLESS_MAIN(tst_Rgbe)
+
+#include "tst_rgbe.moc"
@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/texelconversion_p.h>
+
+#include <QtTest>
+#include <QtCore/qfloat16.h>
+#include <QtCore/private/qsimd_p.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TST_TEXELCONVERSION_F16C
+#include <immintrin.h>
+#endif
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+Q_DECLARE_METATYPE(Qt3DRaytrace::QImageData::ValueType)
+Q_DECLARE_METATYPE(Qt3DRaytrace::QImageData::Format)
+
+namespace {
+
+constexpr int RowWidth = 1024;
+
+float floatFromBits(quint32 bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+quint16 halfBits(qfloat16 value)
+{
+    quint16 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Converts floats to half floats through a single channel Float32 image, split into rows to exercise parallel conversion.
+QVector<quint16> convertFloats(const QVector<float> &values)
+{
+    QImageData image;
+    image.width = RowWidth;
+    image.height = (values.size() + RowWidth - 1) / RowWidth;
+    image.channels = 1;
+    image.type = QImageData::ValueType::Float32;
+    image.data.fill(0, int(image.mipLevelSize(0)));
+    std::memcpy(image.data.data(), values.constData(), size_t(values.size()) * sizeof(float));
+
+    const QImageData layout = getConvertedTexelLayout(image);
+    QVector<quint16> result(int(layout.mipLevelSize(0) / sizeof(quint16)));
+    convertTexels(image, 0, reinterpret_cast<uchar*>(result.data()));
+    result.resize(values.size());
+    return result;
+}
+
+#if defined(TST_TEXELCONVERSION_F16C)
+__attribute__((target("f16c")))
+quint16 referenceFloatToHalf(float value)
+{
+    // Conversion contract on top of F16C rounding: NaNs become zero and values are clamped to the finite half range.
+    if(value != value) {
+        value = 0.0f;
+    }
+    value = qBound(-65504.0f, value, 65504.0f);
+    return quint16(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+}
+
+__attribute__((target("f16c")))
+float halfToFloat(quint16 bits)
+{
+    return _cvtsh_ss(bits);
+}
+#endif
+
+} // anonymous
+
+class tst_TexelConversion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void floatToHalfKnownValues_data();
+    void floatToHalfKnownValues();
+    void floatToHalfMatchesF16C();
+    void convertedLayout_data();
+    void convertedLayout();
+    void convertTexels_data();
+    void convertTexels();
+};
+
+void tst_TexelConversion::floatToHalfKnownValues_data()
+{
+    QTest::addColumn<float>("value");
+    QTest::addColumn<quint16>("expected");
+
+    QTest::newRow("zero") << 0.0f << quint16(0x0000);
+    QTest::newRow("negative zero") << -0.0f << quint16(0x8000);
+    QTest::newRow("one") << 1.0f << quint16(0x3C00);
+    QTest::newRow("minus two") << -2.0f << quint16(0xC000);
+    QTest::newRow("0.1") << 0.1f << quint16(0x2E66);
+    QTest::newRow("smallest normal") << floatFromBits(113u << 23) << quint16(0x0400);
+    QTest::newRow("smallest subnormal") << floatFromBits(103u << 23) << quint16(0x0001);
+    QTest::newRow("half of smallest subnormal") << floatFromBits(102u << 23) << quint16(0x0000);
+    QTest::newRow("subnormal tie to even") << floatFromBits((103u << 23) | 0x400000u) << quint16(0x0002);
+    QTest::newRow("normal tie to even (down)") << 2049.0f << quint16(0x6800);
+    QTest::newRow("normal tie to even (up)") << 2051.0f << quint16(0x6802);
+    QTest::newRow("largest half") << 65504.0f << quint16(0x7BFF);
+    QTest::newRow("rounds to infinity") << 65520.0f << quint16(0x7BFF);
+    QTest::newRow("large negative") << -1e9f << quint16(0xFBFF);
+    QTest::newRow("infinity") << std::numeric_limits<float>::infinity() << quint16(0x7BFF);
+    QTest::newRow("negative infinity") << -std::numeric_limits<float>::infinity() << quint16(0xFBFF);
+    QTest::newRow("NaN") << std::numeric_limits<float>::quiet_NaN() << quint16(0x0000);
+}
+
+void tst_TexelConversion::floatToHalfKnownValues()
+{
+    QFETCH(float, value);
+    QFETCH(quint16, expected);
+
+    // Surround the value with other texels so that both scalar remainders and SIMD batches see it.
+    QVector<float> values(RowWidth + 19, 1.0f);
+    values[0] = value;
+    values[RowWidth - 1] = value;
+    values[RowWidth + 18] = value;
+
+    const QVector<quint16> result = convertFloats(values);
+    QCOMPARE(result[0], expected);
+    QCOMPARE(result[RowWidth - 1], expected);
+    QCOMPARE(result[RowWidth + 18], expected);
+    QCOMPARE(result[1], quint16(0x3C00));
+}
+
+void tst_TexelConversion::floatToHalfMatchesF16C()
+{
+#if defined(TST_TEXELCONVERSION_F16C)
+    if(!qCpuHasFeature(F16C)) {
+        QSKIP("CPU does not support F16C");
+    }
+
+    // Every finite half float, midpoints between neighbouring half floats (rounding ties) and floats one ulp
+    // either side of them, with both signs; followed by a sparse sweep over all float bit patterns.
+    QVector<float> values;
+    for(quint32 bits=0; bits < 0x7C00u; ++bits) {
+        const float value = halfToFloat(quint16(bits));
+        const float midpoint = 0.5f * (value + halfToFloat(quint16(bits + 1)));
+        for(float v : { value, midpoint, std::nextafter(midpoint, 0.0f), std::nextafter(midpoint, 1e6f) }) {
+            values.append(v);
+            values.append(-v);
+        }
+    }
+    for(quint64 bits=0; bits <= 0xFFFFFFFFull; bits += 65537) {
+        values.append(floatFromBits(quint32(bits)));
+    }
+
+    const QVector<quint16> result = convertFloats(values);
+    for(int i=0; i < values.size(); ++i) {
+        const quint16 expected = referenceFloatToHalf(values[i]);
+        if(result[i] != expected) {
+            quint32 bits;
+            std::memcpy(&bits, &values[i], sizeof(bits));
+            QFAIL(qPrintable(QString("float 0x%1: 0x%2 != 0x%3").arg(bits, 8, 16, QChar('0'))
+                             .arg(result[i], 4, 16, QChar('0')).arg(expected, 4, 16, QChar('0'))));
+        }
+    }
+#else
+    QSKIP("F16C reference is not available on this platform");
+#endif
+}
+
+void tst_TexelConversion::convertedLayout_data()
+{
+    QTest::addColumn<QImageData::ValueType>("type");
+    QTest::addColumn<int>("channels");
+    QTest::addColumn<QImageData::Format>("format");
+    QTest::addColumn<QImageData::ValueType>("expectedType");
+    QTest::addColumn<int>("expectedChannels");
+    QTest::addColumn<QImageData::Format>("expectedFormat");
+
+    using ValueType = QImageData::ValueType;
+    using Format = QImageData::Format;
+    QTest::newRow("UInt8 R") << ValueType::UInt8 << 1 << Format::Undefined << ValueType::UInt8 << 1 << Format::Undefined;
+    QTest::newRow("UInt8 RGB") << ValueType::UInt8 << 3 << Format::RGB << ValueType::UInt8 << 4 << Format::RGBA;
+    QTest::newRow("UInt8 BGRA") << ValueType::UInt8 << 4 << Format::BGRA << ValueType::UInt8 << 4 << Format::RGBA;
+    QTest::newRow("Float16 BGR") << ValueType::Float16 << 3 << Format::BGR << ValueType::Float16 << 4 << Format::RGBA;
+    QTest::newRow("Float16 RGBA") << ValueType::Float16 << 4 << Format::RGBA << ValueType::Float16 << 4 << Format::RGBA;
+    QTest::newRow("Float32 RG") << ValueType::Float32 << 2 << Format::Undefined << ValueType::Float16 << 2 << Format::Undefined;
+    QTest::newRow("Float32 RGB") << ValueType::Float32 << 3 << Format::RGB << ValueType::Float16 << 4 << Format::RGBA;
+}
+
+void tst_TexelConversion::convertedLayout()
+{
+    QFETCH(QImageData::ValueType, type);
+    QFETCH(int, channels);
+    QFETCH(QImageData::Format, format);
+    QFETCH(QImageData::ValueType, expectedType);
+    QFETCH(int, expectedChannels);
+    QFETCH(QImageData::Format, expectedFormat);
+
+    QImageData image;
+    image.width = 40;
+    image.height = 20;
+    image.mipLevels = 3;
+    image.channels = channels;
+    image.type = type;
+    image.format = format;
+
+    const QImageData layout = getConvertedTexelLayout(image);
+    QCOMPARE(layout.width, image.width);
+    QCOMPARE(layout.height, image.height);
+    QCOMPARE(layout.mipLevels, image.mipLevels);
+    QCOMPARE(int(layout.type), int(expectedType));
+    QCOMPARE(layout.channels, expectedChannels);
+    QCOMPARE(int(layout.format), int(expectedFormat));
+    QVERIFY(layout.isEmpty());
+}
+
+void tst_TexelConversion::convertTexels_data()
+{
+    QTest::addColumn<QImageData::ValueType>("type");
+    QTest::addColumn<QImageData::Format>("format");
+
+    using ValueType = QImageData::ValueType;
+    using Format = QImageData::Format;
+    for(ValueType type : { ValueType::UInt8, ValueType::Float16, ValueType::Float32 }) {
+        const char *typeName = (type == ValueType::UInt8) ? "UInt8" : (type == ValueType::Float16 ? "Float16" : "Float32");
+        QTest::newRow(qPrintable(QString("%1 RGB").arg(typeName))) << type << Format::RGB;
+        QTest::newRow(qPrintable(QString("%1 BGR").arg(typeName))) << type << Format::BGR;
+        QTest::newRow(qPrintable(QString("%1 RGBA").arg(typeName))) << type << Format::RGBA;
+        QTest::newRow(qPrintable(QString("%1 BGRA").arg(typeName))) << type << Format::BGRA;
+    }
+}
+
+void tst_TexelConversion::convertTexels()
+{
+    QFETCH(QImageData::ValueType, type);
+    QFETCH(QImageData::Format, format);
+
+    const bool hasAlpha = (format == QImageData::Format::RGBA || format == QImageData::Format::BGRA);
+    const bool swapRB = (format == QImageData::Format::BGR || format == QImageData::Format::BGRA);
+
+    // Odd width leaves a remainder after SIMD batches; second mip level checks level offsets.
+    QImageData image;
+    image.width = 37;
+    image.height = 6;
+    image.mipLevels = 2;
+    image.channels = hasAlpha ? 4 : 3;
+    image.type = type;
+    image.format = format;
+    image.data.resize(int(image.expectedSizeInBytes()));
+
+    // Texel values are distinct per texel and channel, and exactly representable as half floats.
+    const int numValues = image.data.size() / int(type);
+    auto sourceValue = [](int index) { return float(index % 1024) * 0.25f; };
+    for(int i=0; i < numValues; ++i) {
+        switch(type) {
+        case QImageData::ValueType::UInt8:
+            image.data[i] = char(i * 7);
+            break;
+        case QImageData::ValueType::Float16:
+            reinterpret_cast<qfloat16*>(image.data.data())[i] = qfloat16(sourceValue(i));
+            break;
+        default:
+            reinterpret_cast<float*>(image.data.data())[i] = sourceValue(i);
+            break;
+        }
+    }
+
+    const QImageData layout = getConvertedTexelLayout(image);
+    for(int level=0; level < image.mipLevels; ++level) {
+        const int numTexels = image.mipWidth(level) * image.mipHeight(level);
+        const int firstValue = int(image.mipLevelOffset(level) / quint64(type));
+
+        // Guard bytes past the end catch writes outside of the converted level.
+        QByteArray converted(int(layout.mipLevelSize(level)) + 16, char(0xCD));
+        Raytrace::convertTexels(image, level, reinterpret_cast<uchar*>(converted.data()));
+        for(int i=0; i < 16; ++i) {
+            QCOMPARE(converted.at(converted.size() - 1 - i), char(0xCD));
+        }
+
+        for(int texel=0; texel < numTexels; ++texel) {
+            for(int c=0; c < 4; ++c) {
+                const int srcChannel = (swapRB && c != 1 && c != 3) ? (2 - c) : c;
+                const int srcIndex = firstValue + texel * image.channels + srcChannel;
+                const int dstIndex = texel * 4 + c;
+                const bool isOpaqueAlpha = (c == 3 && !hasAlpha);
+                if(type == QImageData::ValueType::UInt8) {
+                    const uchar expected = isOpaqueAlpha ? uchar(0xFF) : uchar(srcIndex * 7);
+                    QCOMPARE(uchar(converted.at(dstIndex)), expected);
+                }
+                else {
+                    const quint16 expected = isOpaqueAlpha ? quint16(0x3C00) : halfBits(qfloat16(sourceValue(srcIndex)));
+                    const quint16 *values = reinterpret_cast<const quint16*>(converted.constData());
+                    QCOMPARE(values[dstIndex], expected);
+                }
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_TexelConversion)
+
+#include "tst_texelconversion.moc"
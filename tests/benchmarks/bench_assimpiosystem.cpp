@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/assimpiosystem_p.h>
+#include <io/defaultmeshimporter_p.h>
+
+#include "peakmemory.h"
+#include "syntheticmesh.h"
+
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/Importer.hpp>
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+// About 1 GB of OBJ text, 10M triangles.
+constexpr int GridSize = 2237;
+
+// Same post-processing as DefaultMeshImporter.
+constexpr unsigned int ImportFlags =
+        aiProcess_GenNormals |
+        aiProcess_GenUVCoords |
+        aiProcess_TransformUVCoords |
+        aiProcess_CalcTangentSpace |
+        aiProcess_Triangulate |
+        aiProcess_SortByPType |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_PreTransformVertices |
+        aiProcess_FindInvalidData |
+        aiProcess_ValidateDataStructure;
+
+enum class ImportMethod {
+    ReadFromMemory,
+    MappedIOSystem,
+    DefaultMeshImporter,
+};
+
+} // anonymous
+
+Q_DECLARE_METATYPE(ImportMethod)
+
+class bench_AssimpIOSystem : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void peakMemory_data();
+    void peakMemory();
+
+private:
+    QTemporaryDir m_directory;
+    QString m_meshPath;
+    qint64 m_meshSize = 0;
+};
+
+void bench_AssimpIOSystem::initTestCase()
+{
+    if(!Benchmark::PeakMemorySampler::isSupported()) {
+        QSKIP("Memory usage sampling is not supported on this platform");
+    }
+    QVERIFY(m_directory.isValid());
+
+    // Cache hits would bypass Assimp entirely.
+    qputenv("QUARTZ_MESH_CACHE", "0");
+
+    m_meshPath = m_directory.filePath("grid.obj");
+    m_meshSize = Benchmark::writeGridObj(m_meshPath, GridSize);
+    QVERIFY(m_meshSize > 0);
+}
+
+void bench_AssimpIOSystem::peakMemory_data()
+{
+    QTest::addColumn<ImportMethod>("method");
+
+    // Previous import path: whole file read into a byte array and parsed from memory.
+    QTest::newRow("readAll + ReadFileFromMemory") << ImportMethod::ReadFromMemory;
+    // Current import path: file parsed in place through memory-mapped streams.
+    QTest::newRow("AssimpIOSystem") << ImportMethod::MappedIOSystem;
+    // Complete import including conversion to QGeometryData.
+    QTest::newRow("DefaultMeshImporter") << ImportMethod::DefaultMeshImporter;
+}
+
+void bench_AssimpIOSystem::peakMemory()
+{
+    QFETCH(ImportMethod, method);
+
+    const QByteArray meshPathUtf8 = m_meshPath.toUtf8();
+    const Benchmark::PeakMemorySampler::Usage baseline = Benchmark::PeakMemorySampler::readUsage();
+
+    QElapsedTimer timer;
+    Benchmark::PeakMemorySampler sampler;
+    sampler.start();
+    timer.start();
+    switch(method) {
+    case ImportMethod::ReadFromMemory: {
+        QFile file(m_meshPath);
+        QVERIFY(file.open(QFile::ReadOnly));
+        const QByteArray contents = file.readAll();
+        Assimp::Importer importer;
+        QVERIFY(importer.ReadFileFromMemory(contents.constData(), size_t(contents.size()), ImportFlags, "obj"));
+        break;
+    }
+    case ImportMethod::MappedIOSystem: {
+        Assimp::Importer importer;
+        importer.SetIOHandler(new AssimpIOSystem);
+        QVERIFY(importer.ReadFile(meshPathUtf8.constData(), ImportFlags));
+        break;
+    }
+    case ImportMethod::DefaultMeshImporter: {
+        QGeometryData data;
+        QVERIFY(DefaultMeshImporter().import(QUrl::fromLocalFile(m_meshPath), data));
+        QCOMPARE(data.numFaces(), quint64(2) * GridSize * GridSize);
+        break;
+    }
+    }
+    const qint64 elapsed = timer.elapsed();
+    const Benchmark::PeakMemorySampler::Usage peak = sampler.stop();
+
+    const qint64 peakAnonymous = peak.anonymous - baseline.anonymous;
+    const qint64 peakResident = peak.resident - baseline.resident;
+    qInfo("Source: %lld MB, peak anonymous: %lld MB, peak resident (incl. mapped file): %lld MB, time: %lld ms",
+          m_meshSize >> 20, peakAnonymous >> 20, peakResident >> 20, elapsed);
+    QTest::setBenchmarkResult(qreal(peakAnonymous), QTest::BytesAllocated);
+}
+
+QTEST_APPLESS_MAIN(bench_AssimpIOSystem)
+
+#include "bench_assimpiosystem.moc"
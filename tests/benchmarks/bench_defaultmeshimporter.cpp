@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/assimpiosystem_p.h>
+#include <io/common_p.h>
+#include <io/defaultmeshimporter_p.h>
+
+#include "peakmemory.h"
+#include "syntheticmesh.h"
+
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <assimp/Importer.hpp>
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+// 64 meshes, 5M triangles in total, about 500 MB of OBJ text.
+constexpr int NumObjects = 64;
+constexpr int GridSize = 198;
+
+// Same post-processing as DefaultMeshImporter.
+constexpr unsigned int ImportFlags =
+        aiProcess_GenNormals |
+        aiProcess_GenUVCoords |
+        aiProcess_TransformUVCoords |
+        aiProcess_CalcTangentSpace |
+        aiProcess_Triangulate |
+        aiProcess_SortByPType |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_PreTransformVertices |
+        aiProcess_FindInvalidData |
+        aiProcess_ValidateDataStructure;
+
+// Previous conversion: meshes are converted one after another while the whole scene stays alive.
+bool importSceneSerial(const aiScene *scene, QGeometryData &data)
+{
+    int totalNumVertices = 0;
+    int totalNumFaces = 0;
+    for(int i=0; i < int(scene->mNumMeshes); ++i) {
+        totalNumVertices += int(scene->mMeshes[i]->mNumVertices);
+        totalNumFaces += int(scene->mMeshes[i]->mNumFaces);
+    }
+    data.vertices.resize(totalNumVertices);
+    data.faces.resize(totalNumFaces);
+
+    for(int i=0, vertexIndex=0, triangleIndex=0; i < int(scene->mNumMeshes); ++i) {
+        const aiMesh *mesh = scene->mMeshes[i];
+        const quint32 baseVertex = quint32(vertexIndex);
+        for(int j=0; j < int(mesh->mNumVertices); ++j, ++vertexIndex) {
+            auto &vertex = data.vertices[vertexIndex];
+            vertex.position = { mesh->mVertices[j].x, mesh->mVertices[j].y, mesh->mVertices[j].z };
+            vertex.normal = { mesh->mNormals[j].x, mesh->mNormals[j].y, mesh->mNormals[j].z };
+            vertex.normal.normalize();
+            if(mesh->HasTextureCoords(0)) {
+                vertex.texcoord = { mesh->mTextureCoords[0][j].x, mesh->mTextureCoords[0][j].y };
+            }
+            if(mesh->HasTangentsAndBitangents()) {
+                vertex.tangent = { mesh->mTangents[j].x, mesh->mTangents[j].y, mesh->mTangents[j].z };
+                vertex.tangent.normalize();
+            }
+            else {
+                vertex.tangent = computeFallbackTangent(vertex.normal);
+            }
+        }
+        for(int j=0; j < int(mesh->mNumFaces); ++j, ++triangleIndex) {
+            auto &triangle = data.faces[triangleIndex];
+            triangle.vertices[0] = baseVertex + mesh->mFaces[j].mIndices[0];
+            triangle.vertices[1] = baseVertex + mesh->mFaces[j].mIndices[1];
+            triangle.vertices[2] = baseVertex + mesh->mFaces[j].mIndices[2];
+        }
+    }
+    return totalNumVertices > 0 && totalNumFaces > 0;
+}
+
+} // anonymous
+
+class bench_DefaultMeshImporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void conversion_data();
+    void conversion();
+
+private:
+    QTemporaryDir m_directory;
+    QString m_meshPath;
+};
+
+void bench_DefaultMeshImporter::initTestCase()
+{
+    if(!Benchmark::PeakMemorySampler::isSupported()) {
+        QSKIP("Memory usage sampling is not supported on this platform");
+    }
+    QVERIFY(m_directory.isValid());
+
+    // Cache hits would bypass conversion entirely.
+    qputenv("QUARTZ_MESH_CACHE", "0");
+
+    m_meshPath = m_directory.filePath("grids.obj");
+    QVERIFY(Benchmark::writeGridObj(m_meshPath, GridSize, NumObjects) > 0);
+}
+
+void bench_DefaultMeshImporter::conversion_data()
+{
+    QTest::addColumn<bool>("parallel");
+
+    QTest::newRow("Serial") << false;
+    QTest::newRow("Parallel") << true;
+}
+
+void bench_DefaultMeshImporter::conversion()
+{
+    QFETCH(bool, parallel);
+
+    const QByteArray meshPathUtf8 = m_meshPath.toUtf8();
+    const Benchmark::PeakMemorySampler::Usage baseline = Benchmark::PeakMemorySampler::readUsage();
+
+    QGeometryData data;
+    QElapsedTimer timer;
+    Benchmark::PeakMemorySampler sampler;
+    sampler.start();
+    timer.start();
+    if(parallel) {
+        QVERIFY(DefaultMeshImporter().import(QUrl::fromLocalFile(m_meshPath), data));
+    }
+    else {
+        Assimp::Importer importer;
+        importer.SetIOHandler(new AssimpIOSystem);
+        const aiScene *scene = importer.ReadFile(meshPathUtf8.constData(), ImportFlags);
+        QVERIFY(scene);
+        QVERIFY(importSceneSerial(scene, data));
+    }
+    const qint64 elapsed = timer.elapsed();
+    const Benchmark::PeakMemorySampler::Usage peak = sampler.stop();
+
+    QCOMPARE(data.numFaces(), quint64(2) * NumObjects * GridSize * GridSize);
+
+    const qint64 outputSize = qint64(data.numVertices() * sizeof(QVertex) + data.numFaces() * sizeof(QTriangle));
+    const qint64 peakAnonymous = peak.anonymous - baseline.anonymous;
+    qInfo("Output: %lld MB, peak anonymous: %lld MB (%.2fx output), time: %lld ms",
+          outputSize >> 20, peakAnonymous >> 20, double(peakAnonymous) / double(outputSize), elapsed);
+    QTest::setBenchmarkResult(qreal(peakAnonymous), QTest::BytesAllocated);
+}
+
+QTEST_APPLESS_MAIN(bench_DefaultMeshImporter)
+
+#include "bench_defaultmeshimporter.moc"
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/instancepacker.h>
+
+#include <QtTest>
+#include <QRandomGenerator>
+
+using namespace Qt3DRaytrace::Vulkan;
+
+class bench_InstancePacker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void packAll();
+    void packModified_data();
+    void packModified();
+    void normalMatrices();
+
+private:
+    void setInstances(InstancePacker &packer) const;
+
+    static constexpr uint32_t NumInstances = 1000000;
+    QVector<QMatrix4x4> m_transforms;
+};
+
+void bench_InstancePacker::initTestCase()
+{
+    QRandomGenerator rng(1);
+    m_transforms.resize(int(NumInstances));
+    for(QMatrix4x4 &transform : m_transforms) {
+        transform.setToIdentity();
+        transform.translate(float(rng.bounded(1000.0)), float(rng.bounded(1000.0)), float(rng.bounded(1000.0)));
+        transform.rotate(float(rng.bounded(360.0)), 0.0f, 1.0f, 0.0f);
+        transform.scale(float(0.5 + rng.bounded(2.0)));
+    }
+}
+
+void bench_InstancePacker::setInstances(InstancePacker &packer) const
+{
+    for(uint32_t i=0; i < NumInstances; ++i) {
+        packer.setInstance(i, i % 64, i % 1024, 128, m_transforms[int(i)].constData());
+    }
+}
+
+void bench_InstancePacker::packAll()
+{
+    // Initial upload of a scene: every instance is new.
+    QBENCHMARK {
+        InstancePacker packer;
+        packer.resize(NumInstances);
+        setInstances(packer);
+        const QVector<InstancePacker::Range> ranges = packer.pack();
+        QCOMPARE(ranges.size(), 1);
+    }
+}
+
+void bench_InstancePacker::packModified_data()
+{
+    QTest::addColumn<int>("stride");
+
+    QTest::newRow("all") << 1;
+    QTest::newRow("1%") << 100;
+    QTest::newRow("0.01%") << 10000;
+}
+
+void bench_InstancePacker::packModified()
+{
+    QFETCH(int, stride);
+
+    InstancePacker packer;
+    packer.resize(NumInstances);
+    setInstances(packer);
+    packer.pack();
+
+    // Animated scene: every frame all inputs are fed again but only every stride-th instance moves.
+    float offset = 0.0f;
+    QBENCHMARK {
+        offset += 1.0f;
+        for(uint32_t i=0; i < NumInstances; ++i) {
+            const float extra = (i % uint32_t(stride) == 0) ? offset : 0.0f;
+            QMatrix4x4 transform = m_transforms[int(i)];
+            transform(0, 3) += extra;
+            packer.setInstance(i, i % 64, i % 1024, 128, transform.constData());
+        }
+        packer.pack();
+    }
+}
+
+void bench_InstancePacker::normalMatrices()
+{
+    const int count = int(NumInstances);
+
+    QVector<float> inputs(9 * count);
+    QVector<float> outputs(9 * count);
+    for(int i=0; i < count; ++i) {
+        const float *m = m_transforms[i].constData();
+        for(int c=0; c < 3; ++c) {
+            for(int r=0; r < 3; ++r) {
+                inputs[(c * 3 + r) * count + i] = m[c * 4 + r];
+            }
+        }
+    }
+    const float *in[9];
+    float *out[9];
+    for(int k=0; k < 9; ++k) {
+        in[k] = inputs.constData() + k * count;
+        out[k] = outputs.data() + k * count;
+    }
+
+    // SIMD kernel alone, excluding gather and scatter of instance data.
+    QBENCHMARK {
+        InstancePacker::computeNormalMatrices(in, out, count);
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_InstancePacker)
+
+#include "bench_instancepacker.moc"
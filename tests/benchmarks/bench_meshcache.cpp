@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/defaultmeshimporter_p.h>
+#include <io/meshcache_p.h>
+
+#include "syntheticmesh.h"
+
+#include <QtTest>
+#include <QDir>
+#include <QTemporaryDir>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+// 2M triangles; cold imports run through the full Assimp post-processing pipeline.
+constexpr int GridSize = 1000;
+
+// Reads every vertex and face so that warm loads pay for faulting in mapped pages, as the renderer would.
+quint64 touchGeometry(const QGeometryData &data)
+{
+    quint64 checksum = 0;
+    const QVertex *vertices = data.vertexData();
+    for(quint64 i=0; i < data.numVertices(); ++i) {
+        checksum += quint64(vertices[i].position.x());
+    }
+    const QTriangle *faces = data.faceData();
+    for(quint64 i=0; i < data.numFaces(); ++i) {
+        checksum += faces[i].vertices[0];
+    }
+    return checksum;
+}
+
+} // anonymous
+
+class bench_MeshCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void coldImport();
+    void warmImport();
+
+private:
+    void clearCache() const;
+
+    QTemporaryDir m_directory;
+    QString m_cacheDirectory;
+    QString m_meshPath;
+};
+
+void bench_MeshCache::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+
+    // Cache is configured once, when first used, so this must happen before any import.
+    m_cacheDirectory = m_directory.filePath("cache");
+    qputenv("QUARTZ_MESH_CACHE", "1");
+    qputenv("QUARTZ_MESH_CACHE_DIR", QFile::encodeName(m_cacheDirectory));
+    QVERIFY(MeshCache::instance()->isEnabled());
+
+    m_meshPath = m_directory.filePath("grid.obj");
+    QVERIFY(Benchmark::writeGridObj(m_meshPath, GridSize) > 0);
+}
+
+void bench_MeshCache::clearCache() const
+{
+    const QDir cacheDirectory(m_cacheDirectory);
+    for(const QString &entry : cacheDirectory.entryList({ QStringLiteral("*.qmc") }, QDir::Files)) {
+        QVERIFY(QFile::remove(cacheDirectory.filePath(entry)));
+    }
+}
+
+void bench_MeshCache::coldImport()
+{
+    // First startup: full import, then the result is written to the cache.
+    QBENCHMARK {
+        clearCache();
+        QGeometryData data;
+        QVERIFY(DefaultMeshImporter().import(QUrl::fromLocalFile(m_meshPath), data));
+        QVERIFY(data.vertexStorage.isNull());
+        QVERIFY(touchGeometry(data) > 0);
+    }
+}
+
+void bench_MeshCache::warmImport()
+{
+    clearCache();
+    {
+        QGeometryData data;
+        QVERIFY(DefaultMeshImporter().import(QUrl::fromLocalFile(m_meshPath), data));
+    }
+
+    // Subsequent startups: geometry is mapped from the cache entry without parsing.
+    QBENCHMARK {
+        QGeometryData data;
+        QVERIFY(DefaultMeshImporter().import(QUrl::fromLocalFile(m_meshPath), data));
+        QVERIFY(!data.vertexStorage.isNull());
+        QCOMPARE(data.numFaces(), quint64(2 * GridSize * GridSize));
+        QVERIFY(touchGeometry(data) > 0);
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_MeshCache)
+
+#include "bench_meshcache.moc"
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/defaultmeshimporter_p.h>
+#include <io/objmeshimporter_p.h>
+
+#include "syntheticmesh.h"
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <memory>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+// 10M triangles, about 1 GB of OBJ text.
+constexpr int GridSize = 2237;
+constexpr double TargetSpeedup = 5.0;
+
+} // anonymous
+
+class bench_ObjMeshImporter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void import_data();
+    void import();
+    void speedup();
+
+private:
+    QTemporaryDir m_directory;
+    QString m_meshPath;
+    QHash<QString, qint64> m_importTimes;
+};
+
+void bench_ObjMeshImporter::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+
+    // Cache hits would bypass both importers.
+    qputenv("QUARTZ_MESH_CACHE", "0");
+
+    m_meshPath = m_directory.filePath("grid.obj");
+    QVERIFY(Benchmark::writeGridObj(m_meshPath, GridSize) > 0);
+}
+
+void bench_ObjMeshImporter::import_data()
+{
+    QTest::addColumn<bool>("native");
+
+    QTest::newRow("Assimp") << false;
+    QTest::newRow("ObjMeshImporter") << true;
+}
+
+void bench_ObjMeshImporter::import()
+{
+    QFETCH(bool, native);
+
+    std::unique_ptr<MeshImporter> importer;
+    if(native) {
+        importer.reset(new ObjMeshImporter);
+    }
+    else {
+        importer.reset(new DefaultMeshImporter);
+    }
+
+    QGeometryData data;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        QVERIFY(importer->import(QUrl::fromLocalFile(m_meshPath), data));
+    }
+    m_importTimes.insert(QTest::currentDataTag(), timer.elapsed());
+
+    QCOMPARE(data.numFaces(), quint64(2) * GridSize * GridSize);
+    QVERIFY(data.numVertices() >= quint64(GridSize + 1) * quint64(GridSize + 1));
+}
+
+void bench_ObjMeshImporter::speedup()
+{
+    const qint64 assimpTime = m_importTimes.value(QStringLiteral("Assimp"));
+    const qint64 nativeTime = m_importTimes.value(QStringLiteral("ObjMeshImporter"));
+    if(assimpTime <= 0 || nativeTime <= 0) {
+        QSKIP("Import benchmarks did not run");
+    }
+
+    const double speedup = double(assimpTime) / double(nativeTime);
+    qInfo("Assimp: %lld ms, ObjMeshImporter: %lld ms, speedup: %.1fx", assimpTime, nativeTime, speedup);
+    if(speedup < TargetSpeedup) {
+        qWarning("Speedup of native OBJ import is below the %.0fx target", TargetSpeedup);
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_ObjMeshImporter)
+
+#include "bench_objmeshimporter.moc"
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/rgbe_p.h>
+
+#include <QtTest>
+#include <QBuffer>
+#include <QElapsedTimer>
+
+#include <stb_image.h>
+
+#include <cmath>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+namespace {
+
+// 16k x 8k panorama, built by repeating an encoded band of rows.
+constexpr int ImageWidth = 16384;
+constexpr int ImageHeight = 8192;
+constexpr int BandHeight = 64;
+constexpr double TargetSpeedup = 4.0;
+
+enum class Decoder {
+    Stb,
+    RgbeFloat32,
+    RgbeFloat16,
+};
+
+// Smooth gradients with a bright spot and some noise, so that scanlines contain both runs and literals.
+QImageData makeBand()
+{
+    QImageData band;
+    band.width = ImageWidth;
+    band.height = BandHeight;
+    band.channels = 4;
+    band.type = QImageData::ValueType::Float32;
+    band.format = QImageData::Format::RGBA;
+    band.data.resize(ImageWidth * BandHeight * 4 * int(sizeof(float)));
+
+    float *texels = reinterpret_cast<float*>(band.data.data());
+    quint32 noise = 1;
+    for(int y=0; y < BandHeight; ++y) {
+        for(int x=0; x < ImageWidth; ++x) {
+            noise = noise * 1664525u + 1013904223u;
+            const float u = float(x) / ImageWidth;
+            const float spot = (std::abs(u - 0.5f) < 0.01f) ? 5000.0f : 0.0f;
+            const float jitter = (x % 4096 < 2048) ? float(noise >> 24) / 2560.0f : 0.0f;
+            float *texel = texels + (y * ImageWidth + x) * 4;
+            texel[0] = 0.2f + u + spot + jitter;
+            texel[1] = 0.3f + 0.5f * u + spot;
+            texel[2] = 0.8f + spot;
+            texel[3] = 1.0f;
+        }
+    }
+    return band;
+}
+
+} // anonymous
+
+Q_DECLARE_METATYPE(Decoder)
+
+class bench_Rgbe : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void decode_data();
+    void decode();
+    void speedup();
+
+private:
+    QByteArray m_imageBytes;
+    QHash<QString, qint64> m_decodeTimes;
+};
+
+void bench_Rgbe::initTestCase()
+{
+    QByteArray bandBytes;
+    {
+        QBuffer buffer(&bandBytes);
+        QVERIFY(buffer.open(QBuffer::WriteOnly));
+        QVERIFY(encodeRgbeImage(makeBand(), &buffer));
+    }
+    const QByteArray bandHeader = QStringLiteral("\n-Y %1 +X %2\n").arg(BandHeight).arg(ImageWidth).toLatin1();
+    const int bandDataOffset = bandBytes.indexOf(bandHeader);
+    QVERIFY(bandDataOffset > 0);
+    const QByteArray bandData = bandBytes.mid(bandDataOffset + bandHeader.size());
+
+    m_imageBytes = QStringLiteral("#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %1 +X %2\n").arg(ImageHeight).arg(ImageWidth).toLatin1();
+    m_imageBytes.reserve(m_imageBytes.size() + bandData.size() * (ImageHeight / BandHeight));
+    for(int i=0; i < ImageHeight / BandHeight; ++i) {
+        m_imageBytes.append(bandData);
+    }
+    qInfo("Encoded image: %d MB", m_imageBytes.size() >> 20);
+
+    stbi_set_flip_vertically_on_load(1);
+}
+
+void bench_Rgbe::decode_data()
+{
+    QTest::addColumn<Decoder>("decoder");
+
+    // Previous import path: stb_image decoding to 32-bit floating point RGB.
+    QTest::newRow("stb_image") << Decoder::Stb;
+    QTest::newRow("RGBE Float32") << Decoder::RgbeFloat32;
+    // Current import path: decoding straight to texture-ready 16-bit floating point RGBA.
+    QTest::newRow("RGBE Float16") << Decoder::RgbeFloat16;
+}
+
+void bench_Rgbe::decode()
+{
+    QFETCH(Decoder, decoder);
+
+    const uchar *data = reinterpret_cast<const uchar*>(m_imageBytes.constData());
+    const quint64 size = quint64(m_imageBytes.size());
+
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        if(decoder == Decoder::Stb) {
+            int width, height, channels;
+            float *image = stbi_loadf_from_memory(data, int(size), &width, &height, &channels, 0);
+            QVERIFY(image);
+            stbi_image_free(image);
+        }
+        else {
+            const auto type = (decoder == Decoder::RgbeFloat32) ? QImageData::ValueType::Float32 : QImageData::ValueType::Float16;
+            QImageData image;
+            QVERIFY(decodeRgbeImage(data, size, type, true, image));
+            QCOMPARE(image.width, ImageWidth);
+            QCOMPARE(image.height, ImageHeight);
+        }
+    }
+    m_decodeTimes.insert(QTest::currentDataTag(), timer.elapsed());
+}
+
+void bench_Rgbe::speedup()
+{
+    const qint64 stbTime = m_decodeTimes.value(QStringLiteral("stb_image"));
+    const qint64 rgbeTime = m_decodeTimes.value(QStringLiteral("RGBE Float16"));
+    if(stbTime <= 0 || rgbeTime <= 0) {
+        QSKIP("Decode benchmarks did not run");
+    }
+
+    const double speedup = double(stbTime) / double(rgbeTime);
+    qInfo("stb_image: %lld ms, RGBE Float16: %lld ms, speedup: %.1fx", stbTime, rgbeTime, speedup);
+    if(speedup < TargetSpeedup) {
+        qWarning("Speedup of RGBE decoding is below the %.0fx target", TargetSpeedup);
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_Rgbe)
+
+#include "bench_rgbe.moc"
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <renderers/vulkan/managers/scenesnapshottable.h>
+
+#include <QtTest>
+#include <QThread>
+#include <QHash>
+#include <QReadWriteLock>
+
+using namespace Qt3DRaytrace::Vulkan;
+using Qt3DCore::QNodeId;
+
+namespace {
+
+constexpr int NumResources = 100000;
+constexpr int NumLookupsPerReader = 2000000;
+// Inserts performed by the writer while readers are running, published in batches as upload jobs would be.
+constexpr int NumInserts = 1024;
+constexpr int InsertBatchSize = 64;
+
+struct Resource
+{
+    quint64 handle = 0;
+    uint32_t size = 0;
+};
+
+// Baseline: single hash guarded by a global read-write lock.
+class LockedTable
+{
+public:
+    void insert(QNodeId nodeId, const Resource &resource)
+    {
+        QWriteLocker lock(&m_lock);
+        m_resources.insert(nodeId, resource);
+    }
+    void remove(QNodeId nodeId)
+    {
+        QWriteLocker lock(&m_lock);
+        m_resources.remove(nodeId);
+    }
+    quint64 lookup(QNodeId nodeId) const
+    {
+        QReadLocker lock(&m_lock);
+        return m_resources.value(nodeId).handle;
+    }
+
+private:
+    QHash<QNodeId, Resource> m_resources;
+    mutable QReadWriteLock m_lock;
+};
+
+QVector<QNodeId> createNodeIds(int count)
+{
+    QVector<QNodeId> nodeIds(count);
+    for(QNodeId &nodeId : nodeIds) {
+        nodeId = QNodeId::createId();
+    }
+    return nodeIds;
+}
+
+// Runs numReaders threads doing random lookups of existing resources while writeFunc inserts concurrently.
+template<typename LookupFunc, typename WriteFunc>
+void runContended(const QVector<QNodeId> &nodeIds, int numReaders, LookupFunc lookup, WriteFunc write)
+{
+    QVector<quint64> checksums(numReaders);
+    QVector<QThread*> threads;
+    for(int reader=0; reader < numReaders; ++reader) {
+        threads.append(QThread::create([&nodeIds, &checksums, &lookup, reader]() {
+            quint32 state = quint32(reader + 1);
+            quint64 checksum = 0;
+            for(int i=0; i < NumLookupsPerReader; ++i) {
+                state = state * 1664525u + 1013904223u;
+                checksum += lookup(nodeIds[int(state % uint32_t(nodeIds.size()))]);
+            }
+            checksums[reader] = checksum;
+        }));
+    }
+    threads.append(QThread::create(write));
+
+    for(QThread *thread : qAsConst(threads)) {
+        thread->start();
+    }
+    for(QThread *thread : qAsConst(threads)) {
+        thread->wait();
+    }
+    qDeleteAll(threads);
+
+    for(quint64 checksum : qAsConst(checksums)) {
+        QVERIFY(checksum != 0);
+    }
+}
+
+} // anonymous
+
+class bench_SceneSnapshotTable : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void contendedLookups_data();
+    void contendedLookups();
+
+    void publishUploads_data();
+    void publishUploads();
+
+private:
+    QVector<QNodeId> m_nodeIds;
+    QVector<QNodeId> m_insertedNodeIds;
+};
+
+void bench_SceneSnapshotTable::initTestCase()
+{
+    m_nodeIds = createNodeIds(NumResources);
+    m_insertedNodeIds = createNodeIds(NumInserts);
+}
+
+void bench_SceneSnapshotTable::contendedLookups_data()
+{
+    QTest::addColumn<bool>("lockFree");
+    QTest::addColumn<int>("numReaders");
+
+    for(int numReaders : { 1, 2, 4, 8 }) {
+        QTest::newRow(qPrintable(QString("snapshot, %1 readers").arg(numReaders))) << true << numReaders;
+        QTest::newRow(qPrintable(QString("rwlock, %1 readers").arg(numReaders))) << false << numReaders;
+    }
+}
+
+void bench_SceneSnapshotTable::contendedLookups()
+{
+    QFETCH(bool, lockFree);
+    QFETCH(int, numReaders);
+
+    if(lockFree) {
+        SceneSnapshotTable<Resource> table;
+        {
+            SceneSnapshotTable<Resource>::Writer writer(table);
+            for(int i=0; i < NumResources; ++i) {
+                writer.addResource(m_nodeIds[i], Resource{ quint64(i + 1), 1 });
+            }
+        }
+
+        auto lookup = [&table](QNodeId nodeId) {
+            Resource resource;
+            table.lookupResource(nodeId, resource);
+            return resource.handle;
+        };
+        auto write = [this, &table]() {
+            for(int batch=0; batch < NumInserts; batch += InsertBatchSize) {
+                for(int i=batch; i < batch + InsertBatchSize; ++i) {
+                    SceneSnapshotTable<Resource>::Writer writer(table, SceneSnapshotTable<Resource>::Writer::PublishDeferred);
+                    writer.addResource(m_insertedNodeIds[i], Resource{ quint64(i + 1), 1 });
+                }
+                table.publishPending();
+            }
+        };
+
+        QBENCHMARK {
+            runContended(m_nodeIds, numReaders, lookup, write);
+
+            {
+                SceneSnapshotTable<Resource>::Writer writer(table);
+                for(const QNodeId &nodeId : qAsConst(m_insertedNodeIds)) {
+                    writer.removeResource(nodeId);
+                }
+            }
+            // No readers are running at this point so retired snapshots can be freed.
+            table.reclaimRetiredSnapshots();
+        }
+    }
+    else {
+        LockedTable table;
+        for(int i=0; i < NumResources; ++i) {
+            table.insert(m_nodeIds[i], Resource{ quint64(i + 1), 1 });
+        }
+
+        auto lookup = [&table](QNodeId nodeId) {
+            return table.lookup(nodeId);
+        };
+        auto write = [this, &table]() {
+            for(int i=0; i < NumInserts; ++i) {
+                table.insert(m_insertedNodeIds[i], Resource{ quint64(i + 1), 1 });
+            }
+        };
+
+        QBENCHMARK {
+            runContended(m_nodeIds, numReaders, lookup, write);
+            for(const QNodeId &nodeId : qAsConst(m_insertedNodeIds)) {
+                table.remove(nodeId);
+            }
+        }
+    }
+}
+
+void bench_SceneSnapshotTable::publishUploads_data()
+{
+    QTest::addColumn<bool>("deferred");
+
+    QTest::newRow("publish per upload") << false;
+    QTest::newRow("publish per frame") << true;
+}
+
+void bench_SceneSnapshotTable::publishUploads()
+{
+    QFETCH(bool, deferred);
+
+    // Smaller table than above: publishing per upload retires a full copy of the table per insert.
+    constexpr int NumExisting = 4096;
+    constexpr int NumUploads = 256;
+
+    const QVector<QNodeId> existingNodeIds = createNodeIds(NumExisting);
+    const QVector<QNodeId> uploadedNodeIds = createNodeIds(NumUploads);
+
+    SceneSnapshotTable<Resource> table;
+    {
+        SceneSnapshotTable<Resource>::Writer writer(table);
+        for(int i=0; i < NumExisting; ++i) {
+            writer.addResource(existingNodeIds[i], Resource{ quint64(i + 1), 1 });
+        }
+    }
+
+    const auto publishMode = deferred ? SceneSnapshotTable<Resource>::Writer::PublishDeferred : SceneSnapshotTable<Resource>::Writer::PublishOnExit;
+    QBENCHMARK {
+        for(int i=0; i < NumUploads; ++i) {
+            SceneSnapshotTable<Resource>::Writer writer(table, publishMode);
+            writer.addResource(uploadedNodeIds[i], Resource{ quint64(i + 1), 1 });
+        }
+        table.publishPending();
+        QCOMPARE(table.count(), NumExisting + NumUploads);
+
+        {
+            SceneSnapshotTable<Resource>::Writer writer(table);
+            for(const QNodeId &nodeId : uploadedNodeIds) {
+                writer.removeResource(nodeId);
+            }
+        }
+        table.reclaimRetiredSnapshots();
+    }
+}
+
+QTEST_APPLESS_MAIN(bench_SceneSnapshotTable)
+
+#include "bench_scenesnapshottable.moc"
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#include <io/texelconversion_p.h>
+
+#include <QtTest>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtCore/private/qsimd_p.h>
+
+#include <vector>
+
+using namespace Qt3DRaytrace;
+using namespace Qt3DRaytrace::Raytrace;
+
+Q_DECLARE_METATYPE(Qt3DRaytrace::QImageData::ValueType)
+
+namespace {
+
+constexpr int ImageWidth = 8192;
+constexpr int ImageHeight = 4096;
+constexpr int NumIterations = 5;
+
+} // anonymous
+
+// Run once as is and once with QT_NO_CPU_FEATURE=avx2 (see "run_bench_texelconversion_scalar" target) to compare kernels.
+class bench_TexelConversion : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void convert_data();
+    void convert();
+};
+
+void bench_TexelConversion::initTestCase()
+{
+    const bool hasVectorKernels = qCpuHasFeature(AVX2) && qCpuHasFeature(F16C);
+    qInfo("Conversion kernels: %s", hasVectorKernels ? "AVX2 & F16C" : "scalar");
+}
+
+void bench_TexelConversion::convert_data()
+{
+    QTest::addColumn<QImageData::ValueType>("type");
+
+    // HDR environment maps and LDR color textures, both expanded from RGB to RGBA on upload.
+    QTest::newRow("RGB32F -> RGBA16F") << QImageData::ValueType::Float32;
+    QTest::newRow("RGB8 -> RGBA8") << QImageData::ValueType::UInt8;
+}
+
+void bench_TexelConversion::convert()
+{
+    QFETCH(QImageData::ValueType, type);
+
+    QImageData image;
+    image.width = ImageWidth;
+    image.height = ImageHeight;
+    image.channels = 3;
+    image.type = type;
+    image.format = QImageData::Format::RGB;
+    image.data.resize(int(image.mipLevelSize(0)));
+
+    QRandomGenerator rng(1);
+    if(type == QImageData::ValueType::Float32) {
+        float *values = reinterpret_cast<float*>(image.data.data());
+        for(int i=0; i < ImageWidth * ImageHeight * 3; ++i) {
+            values[i] = float(rng.generateDouble() * 100.0);
+        }
+    }
+    else {
+        rng.fillRange(reinterpret_cast<quint32*>(image.data.data()), image.data.size() / int(sizeof(quint32)));
+    }
+
+    const QImageData layout = getConvertedTexelLayout(image);
+    std::vector<uchar> texels(size_t(layout.mipLevelSize(0)));
+
+    // First conversion also faults in pages of the destination, which a reused staging buffer would already have mapped.
+    convertTexels(image, 0, texels.data());
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i=0; i < NumIterations; ++i) {
+        convertTexels(image, 0, texels.data());
+    }
+    const double elapsed = double(timer.nsecsElapsed()) / NumIterations;
+
+    // Throughput counts bytes read and written, as a copy in the blit path would.
+    const double bytesPerIteration = double(image.mipLevelSize(0) + layout.mipLevelSize(0));
+    qInfo("%.2f ms per %dx%d image, %.2f GB/s, %.0f Mtexels/s", elapsed * 1e-6, ImageWidth, ImageHeight,
+          bytesPerIteration / elapsed, double(ImageWidth) * ImageHeight * 1e3 / elapsed);
+    QTest::setBenchmarkResult(elapsed * 1e-6, QTest::WalltimeMilliseconds);
+}
+
+QTEST_APPLESS_MAIN(bench_TexelConversion)
+
+#include "bench_texelconversion.moc"
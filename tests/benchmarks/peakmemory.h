@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QThread>
+
+#include <memory>
+
+namespace Benchmark {
+
+// Samples memory usage of the current process on a background thread while an operation runs.
+// Peak resident size counts pages of memory-mapped files, which are clean page cache the kernel can reclaim
+// at any time, so the peak of anonymous (heap) memory is tracked separately. Only supported on Linux.
+class PeakMemorySampler
+{
+public:
+    struct Usage
+    {
+        qint64 resident = 0;
+        qint64 anonymous = 0;
+    };
+
+    ~PeakMemorySampler()
+    {
+        if(m_thread) {
+            stop();
+        }
+    }
+
+    static bool isSupported()
+    {
+        return readUsage().resident > 0;
+    }
+
+    void start()
+    {
+        m_peak = readUsage();
+        m_stop.storeRelease(0);
+        m_thread.reset(QThread::create([this]() {
+            do {
+                const Usage usage = readUsage();
+                m_peak.resident = qMax(m_peak.resident, usage.resident);
+                m_peak.anonymous = qMax(m_peak.anonymous, usage.anonymous);
+                QThread::msleep(1);
+            } while(!m_stop.loadAcquire());
+        }));
+        m_thread->start();
+    }
+
+    Usage stop()
+    {
+        m_stop.storeRelease(1);
+        m_thread->wait();
+        m_thread.reset();
+        return m_peak;
+    }
+
+    static Usage readUsage()
+    {
+        Usage usage;
+        QFile status(QStringLiteral("/proc/self/status"));
+        if(!status.open(QFile::ReadOnly | QFile::Text)) {
+            return usage;
+        }
+        // Values are reported in kB, e.g. "VmRSS:    123456 kB".
+        auto parseValue = [](const QByteArray &line) {
+            return line.mid(line.indexOf(':') + 1).trimmed().split(' ').first().toLongLong() * 1024;
+        };
+        for(const QByteArray &line : status.readAll().split('\n')) {
+            if(line.startsWith("VmRSS:")) {
+                usage.resident = parseValue(line);
+            }
+            else if(line.startsWith("RssAnon:")) {
+                usage.anonymous = parseValue(line);
+            }
+        }
+        return usage;
+    }
+
+private:
+    std::unique_ptr<QThread> m_thread;
+    QAtomicInt m_stop;
+    Usage m_peak;
+};
+
+} // Benchmark
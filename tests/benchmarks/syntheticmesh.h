@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018-2019 Michał Siejak
+ * This file is part of Quartz - a raytracing aspect for Qt3D.
+ * See LICENSE file for licensing information.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <cstdio>
+
+namespace Benchmark {
+
+// Writes a Wavefront OBJ file made of numObjects flat grids of gridSize x gridSize quads, two triangles each.
+// Grids are stacked along Z axis and written as separate named objects, which Assimp imports as separate meshes.
+// Every vertex has its own position, texture coordinate and normal. Returns size of the file or -1 on failure.
+// Each quad takes roughly 200 bytes of text, e.g. a single grid of size 2237 has 10M triangles and about 1 GB.
+inline qint64 writeGridObj(const QString &path, int gridSize, int numObjects=1)
+{
+    constexpr int FlushSize = 4 * 1024 * 1024;
+
+    QFile file(path);
+    if(!file.open(QFile::WriteOnly)) {
+        return -1;
+    }
+
+    QByteArray buffer;
+    buffer.reserve(FlushSize + 1024);
+    char line[256];
+    auto append = [&buffer, &line](int length) {
+        buffer.append(line, length);
+    };
+    auto flush = [&file, &buffer](bool force) {
+        if(buffer.size() >= FlushSize || force) {
+            if(file.write(buffer) != buffer.size()) {
+                return false;
+            }
+            buffer.clear();
+        }
+        return true;
+    };
+
+    const int numGridVertices = (gridSize + 1) * (gridSize + 1);
+    for(int object=0; object < numObjects; ++object) {
+        append(std::snprintf(line, sizeof(line), "o grid%d\n", object));
+        for(int y=0; y <= gridSize; ++y) {
+            for(int x=0; x <= gridSize; ++x) {
+                append(std::snprintf(line, sizeof(line), "v %.4f %.4f %.4f\nvt %.5f %.5f\nvn 0 0 1\n",
+                                     double(x), double(y), double(object), double(x) / gridSize, double(y) / gridSize));
+            }
+            if(!flush(false)) {
+                return -1;
+            }
+        }
+        // OBJ indices are one-based and global to the file.
+        const qint64 baseVertex = qint64(object) * numGridVertices + 1;
+        for(int y=0; y < gridSize; ++y) {
+            for(int x=0; x < gridSize; ++x) {
+                const qint64 v00 = baseVertex + y * (gridSize + 1) + x;
+                const qint64 v10 = v00 + 1;
+                const qint64 v01 = v00 + gridSize + 1;
+                const qint64 v11 = v01 + 1;
+                append(std::snprintf(line, sizeof(line), "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n",
+                                     v00, v00, v00, v10, v10, v10, v11, v11, v11));
+                append(std::snprintf(line, sizeof(line), "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n",
+                                     v00, v00, v00, v11, v11, v11, v01, v01, v01));
+            }
+            if(!flush(false)) {
+                return -1;
+            }
+        }
+    }
+    if(!flush(true)) {
+        return -1;
+    }
+    return file.size();
+}
+
+} // Benchmark